@@ -81,7 +81,7 @@ configINCLUDE_DEMO_DEBUG_STATS setting in FreeRTOSIPConfig.h. */
 
 	#define iptraceNETWORK_EVENT_RECEIVED( eEvent )	{																				\
 														uint16_t usSpace;															\
-															usSpace = ( uint16_t ) uxQueueMessagesWaiting( xNetworkEventQueue );	\
+															usSpace = ( uint16_t ) uxQueueMessagesWaiting( pxIPStack->xNetworkEventQueue );\
 															/* Minus one as an event was removed before the space was queried. */	\
 															usSpace = ( ipconfigEVENT_QUEUE_LENGTH - usSpace ) - 1;					\
 															vExampleDebugStatUpdate( iptraceID_NETWORK_EVENT_RECEIVED, usSpace );	\
@@ -45,6 +45,7 @@
 #endif /* ipconfigUSE_LLMNR */
 #include "NetworkBufferManagement.h"
 #include "NetworkInterface.h"
+#include "FreeRTOS_IP_Stack.h"
 
 
 /* When the age of an entry in the ARP table reaches this value (it counts down
@@ -66,13 +67,6 @@ static eARPLookupResult_t prvCacheLookup( uint32_t ulAddressToLookup, MACAddress
 
 /*-----------------------------------------------------------*/
 
-/* The ARP cache. */
-static ARPCacheRow_t xARPCache[ ipconfigARP_CACHE_ENTRIES ];
-
-/* The time at which the last gratuitous ARP was sent.  Gratuitous ARPs are used
-to ensure ARP tables are up to date and to detect IP address conflicts. */
-static TickType_t xLastGratuitousARPTime = ( TickType_t ) 0;
-
 /*
  * IP-clash detection is currently only used internally. When DHCP doesn't respond, the
  * driver can try out a random LinkLayer IP address (169.254.x.x).  It will send out a
@@ -92,6 +86,8 @@ eFrameProcessingResult_t eARPProcessPacket( ARPPacket_t * const pxARPFrame )
 eFrameProcessingResult_t eReturn = eReleaseBuffer;
 ARPHeader_t *pxARPHeader;
 uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
+uint32_t ulLocalIPAddress;
+const uint8_t *pucLocalMACAddress;
 
 	pxARPHeader = &( pxARPFrame->xARPHeader );
 
@@ -102,16 +98,31 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 
 	traceARP_PACKET_RECEIVED();
 
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+	const NetworkEndPoint_t *pxEndPoint = pxRoutingFindEndPoint( ulTargetProtocolAddress );
+
+		/* The request may be for one of the added end-points. */
+		ulLocalIPAddress = ipEND_POINT_IP_ADDRESS( pxEndPoint );
+		pucLocalMACAddress = ipEND_POINT_MAC_ADDRESS( pxEndPoint );
+	}
+	#else
+	{
+		ulLocalIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+		pucLocalMACAddress = ipLOCAL_MAC_ADDRESS;
+	}
+	#endif
+
 	/* Don't do anything if the local IP address is zero because
 	that means a DHCP request has not completed. */
-	if( *ipLOCAL_IP_ADDRESS_POINTER != 0UL )
+	if( ulLocalIPAddress != 0UL )
 	{
 		switch( pxARPHeader->usOperation )
 		{
 			case ipARP_REQUEST	:
 				/* The packet contained an ARP request.  Was it for the IP
 				address of the node running this code? */
-				if( ulTargetProtocolAddress == *ipLOCAL_IP_ADDRESS_POINTER )
+				if( ulTargetProtocolAddress == ulLocalIPAddress )
 				{
 					iptraceSENDING_ARP_REPLY( ulSenderProtocolAddress );
 
@@ -135,8 +146,8 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 						( void ) memcpy( pxARPHeader->xTargetHardwareAddress.ucBytes, pxARPHeader->xSenderHardwareAddress.ucBytes, sizeof( MACAddress_t ) );
 						pxARPHeader->ulTargetProtocolAddress = ulSenderProtocolAddress;
 					}
-					( void ) memcpy( pxARPHeader->xSenderHardwareAddress.ucBytes, ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) );
-					( void ) memcpy( pxARPHeader->ucSenderProtocolAddress, ipLOCAL_IP_ADDRESS_POINTER, sizeof( pxARPHeader->ucSenderProtocolAddress ) );
+					( void ) memcpy( pxARPHeader->xSenderHardwareAddress.ucBytes, pucLocalMACAddress, sizeof( MACAddress_t ) );
+					( void ) memcpy( pxARPHeader->ucSenderProtocolAddress, &( ulLocalIPAddress ), sizeof( pxARPHeader->ucSenderProtocolAddress ) );
 
 					eReturn = eReturnEthernetFrame;
 				}
@@ -178,10 +189,10 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 		/* For each entry in the ARP cache table. */
 		for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
 		{
-			if( ( memcmp( xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
+			if( ( memcmp( pxIPStack->xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
 			{
-				lResult = xARPCache[ x ].ulIPAddress;
-				( void ) memset( &xARPCache[ x ], 0, sizeof( xARPCache[ x ] ) );
+				lResult = pxIPStack->xARPCache[ x ].ulIPAddress;
+				( void ) memset( &pxIPStack->xARPCache[ x ], 0, sizeof( pxIPStack->xARPCache[ x ] ) );
 				break;
 			}
 		}
@@ -204,7 +215,11 @@ uint8_t ucMinAgeFound = 0U;
 	/* Only process the IP address if it is on the local network.
 	Unless: when '*ipLOCAL_IP_ADDRESS_POINTER' equals zero, the IP-address
 	and netmask are still unknown. */
-	if( ( ( ulIPAddress & xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) ) ||
+	if( ( ( ulIPAddress & pxIPStack->xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & pxIPStack->xNetworkAddressing.ulNetMask ) ) ||
+	#if( ipconfigUSE_ROUTING != 0 )
+		/* Or on the subnet of an added end-point. */
+		( xRoutingIsOnLink( ulIPAddress ) != pdFALSE ) ||
+	#endif
 		( *ipLOCAL_IP_ADDRESS_POINTER == 0UL ) )
 #else
 		/* If ipconfigARP_STORES_REMOTE_ADDRESSES is non-zero, IP addresses with
@@ -227,7 +242,7 @@ uint8_t ucMinAgeFound = 0U;
 
 			if( pxMACAddress != NULL )
 			{
-				if( memcmp( xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 )
+				if( memcmp( pxIPStack->xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 )
 				{
 					xMatchingMAC = pdTRUE;
 				}
@@ -242,7 +257,7 @@ uint8_t ucMinAgeFound = 0U;
 			}
 			/* Does this line in the cache table hold an entry for the IP
 			address	being queried? */
-			if( xARPCache[ x ].ulIPAddress == ulIPAddress )
+			if( pxIPStack->xARPCache[ x ].ulIPAddress == ulIPAddress )
 			{
 				if( pxMACAddress == NULL )
 				{
@@ -260,8 +275,8 @@ uint8_t ucMinAgeFound = 0U;
 					As this is by far the most common path the coding standard
 					is relaxed in this case and a return is permitted as an
 					optimisation. */
-					xARPCache[ x ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
-					xARPCache[ x ].ucValid = ( uint8_t ) pdTRUE;
+					pxIPStack->xARPCache[ x ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
+					pxIPStack->xARPCache[ x ].ucValid = ( uint8_t ) pdTRUE;
 					return;
 				}
 
@@ -282,8 +297,8 @@ uint8_t ucMinAgeFound = 0U;
 				network, than the MAC address of the gateway should not be
 				overwritten. */
 				BaseType_t bIsLocal[ 2 ];
-				bIsLocal[ 0 ] = ( ( xARPCache[ x ].ulIPAddress & xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) );
-				bIsLocal[ 1 ] = ( ( ulIPAddress & xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) );
+				bIsLocal[ 0 ] = ( ( pxIPStack->xARPCache[ x ].ulIPAddress & pxIPStack->xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & pxIPStack->xNetworkAddressing.ulNetMask ) );
+				bIsLocal[ 1 ] = ( ( ulIPAddress & pxIPStack->xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & pxIPStack->xNetworkAddressing.ulNetMask ) );
 				if( bIsLocal[ 0 ] == bIsLocal[ 1 ] )
 				{
 					xMacEntry = x;
@@ -294,13 +309,13 @@ uint8_t ucMinAgeFound = 0U;
 			}
 			/* _HT_
 			Shouldn't we test for xARPCache[ x ].ucValid == pdFALSE here ? */
-			else if( xARPCache[ x ].ucAge < ucMinAgeFound )
+			else if( pxIPStack->xARPCache[ x ].ucAge < ucMinAgeFound )
 			{
 				/* As the table is traversed, remember the table row that
 				contains the oldest entry (the lowest age count, as ages are
 				decremented to zero) so the row can be re-used if this function
 				needs to add an entry that does not already exist. */
-				ucMinAgeFound = xARPCache[ x ].ucAge;
+				ucMinAgeFound = pxIPStack->xARPCache[ x ].ucAge;
 				xUseEntry = x;
 			}
 			else
@@ -318,7 +333,7 @@ uint8_t ucMinAgeFound = 0U;
 				/* Both the MAC address as well as the IP address were found in
 				different locations: clear the entry which matches the
 				IP-address */
-				( void ) memset( &( xARPCache[ xIpEntry ] ), 0, sizeof( ARPCacheRow_t ) );
+				( void ) memset( &( pxIPStack->xARPCache[ xIpEntry ] ), 0, sizeof( ARPCacheRow_t ) );
 			}
 		}
 		else if( xIpEntry >= 0 )
@@ -332,21 +347,21 @@ uint8_t ucMinAgeFound = 0U;
 		}
 
 		/* If the entry was not found, we use the oldest entry and set the IPaddress */
-		xARPCache[ xUseEntry ].ulIPAddress = ulIPAddress;
+		pxIPStack->xARPCache[ xUseEntry ].ulIPAddress = ulIPAddress;
 
 		if( pxMACAddress != NULL )
 		{
-			( void ) memcpy( xARPCache[ xUseEntry ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) );
+			( void ) memcpy( pxIPStack->xARPCache[ xUseEntry ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) );
 
 			iptraceARP_TABLE_ENTRY_CREATED( ulIPAddress, (*pxMACAddress) );
 			/* And this entry does not need immediate attention */
-			xARPCache[ xUseEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
-			xARPCache[ xUseEntry ].ucValid = ( uint8_t ) pdTRUE;
+			pxIPStack->xARPCache[ xUseEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
+			pxIPStack->xARPCache[ xUseEntry ].ucValid = ( uint8_t ) pdTRUE;
 		}
 		else if( xIpEntry < 0 )
 		{
-			xARPCache[ xUseEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_RETRANSMISSIONS;
-			xARPCache[ xUseEntry ].ucValid = ( uint8_t ) pdFALSE;
+			pxIPStack->xARPCache[ xUseEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_RETRANSMISSIONS;
+			pxIPStack->xARPCache[ xUseEntry ].ucValid = ( uint8_t ) pdFALSE;
 		}
 		else
 		{
@@ -367,9 +382,9 @@ uint8_t ucMinAgeFound = 0U;
 		{
 			/* Does this row in the ARP cache table hold an entry for the MAC
 			address being searched? */
-			if( memcmp( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
+			if( memcmp( pxMACAddress->ucBytes, pxIPStack->xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
 			{
-				*pulIPAddress = xARPCache[ x ].ulIPAddress;
+				*pulIPAddress = pxIPStack->xARPCache[ x ].ulIPAddress;
 				eReturn = eARPCacheHit;
 				break;
 			}
@@ -404,12 +419,24 @@ ulAddressToLookup = *pulIPAddress;
 		eReturn = eARPCacheHit;
 	}
 	else if( ( *pulIPAddress == ipBROADCAST_IP_ADDRESS ) ||	/* Is it the general broadcast address 255.255.255.255? */
-		( *pulIPAddress == xNetworkAddressing.ulBroadcastAddress ) )/* Or a local broadcast address, eg 192.168.1.255? */
+	#if( ipconfigUSE_ROUTING != 0 )
+		( xRoutingIsBroadcast( *pulIPAddress ) != pdFALSE ) ||	/* Or the broadcast address of an added end-point? */
+	#endif
+		( *pulIPAddress == pxIPStack->xNetworkAddressing.ulBroadcastAddress ) )/* Or a local broadcast address, eg 192.168.1.255? */
 	{
 		/* This is a broadcast so it uses the broadcast MAC address. */
 		( void ) memcpy( pxMACAddress->ucBytes, xBroadcastMACAddress.ucBytes, sizeof( MACAddress_t ) );
 		eReturn = eARPCacheHit;
 	}
+#if( ipconfigUSE_LOOPBACK != 0 )
+	else if( xIsLoopbackIPAddress( ulAddressToLookup ) != pdFALSE )
+	{
+		/* Local traffic never reaches the driver, use the own MAC address
+		so that the packet looks like any other received packet. */
+		( void ) memcpy( pxMACAddress->ucBytes, ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) );
+		eReturn = eARPCacheHit;
+	}
+#endif
 	else if( *ipLOCAL_IP_ADDRESS_POINTER == 0UL )
 	{
 		/* The IP address has not yet been assigned, so there is nothing that
@@ -420,7 +447,13 @@ ulAddressToLookup = *pulIPAddress;
 	{
 		eReturn = eARPCacheMiss;
 
-		if( ( *pulIPAddress & xNetworkAddressing.ulNetMask ) != ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) )
+		if( ( ( *pulIPAddress & pxIPStack->xNetworkAddressing.ulNetMask ) != ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & pxIPStack->xNetworkAddressing.ulNetMask ) )
+		#if( ipconfigUSE_ROUTING != 0 )
+			/* The next hop of a route through an added end-point is on its
+			subnet. */
+			&& ( xRoutingIsOnLink( *pulIPAddress ) == pdFALSE )
+		#endif
+			)
 		{
 			/* No matching end-point is found, look for a gateway. */
 #if( ipconfigARP_STORES_REMOTE_ADDRESSES == 1 )
@@ -437,9 +470,9 @@ ulAddressToLookup = *pulIPAddress;
 			{
 				/* The IP address is off the local network, so look up the
 				hardware address of the router, if any. */
-				if( xNetworkAddressing.ulGatewayAddress != ( uint32_t ) 0U )
+				if( pxIPStack->xNetworkAddressing.ulGatewayAddress != ( uint32_t ) 0U )
 				{
-					ulAddressToLookup = xNetworkAddressing.ulGatewayAddress;
+					ulAddressToLookup = pxIPStack->xNetworkAddressing.ulGatewayAddress;
 				}
 				else
 				{
@@ -494,10 +527,10 @@ eARPLookupResult_t eReturn = eARPCacheMiss;
 	{
 		/* Does this row in the ARP cache table hold an entry for the IP address
 		being queried? */
-		if( xARPCache[ x ].ulIPAddress == ulAddressToLookup )
+		if( pxIPStack->xARPCache[ x ].ulIPAddress == ulAddressToLookup )
 		{
 			/* A matching valid entry was found. */
-			if( xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
+			if( pxIPStack->xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
 			{
 				/* This entry is waiting an ARP reply, so is not valid. */
 				eReturn = eCantSendPacket;
@@ -505,7 +538,7 @@ eARPLookupResult_t eReturn = eARPCacheMiss;
 			else
 			{
 				/* A valid entry was found. */
-				( void ) memcpy( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) );
+				( void ) memcpy( pxMACAddress->ucBytes, pxIPStack->xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) );
 				eReturn = eARPCacheHit;
 			}
 			break;
@@ -525,45 +558,45 @@ TickType_t xTimeNow;
 	for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
 	{
 		/* If the entry is valid (its age is greater than zero). */
-		if( xARPCache[ x ].ucAge > 0U )
+		if( pxIPStack->xARPCache[ x ].ucAge > 0U )
 		{
 			/* Decrement the age value of the entry in this ARP cache table row.
 			When the age reaches zero it is no longer considered valid. */
-			( xARPCache[ x ].ucAge )--;
+			( pxIPStack->xARPCache[ x ].ucAge )--;
 
 			/* If the entry is not yet valid, then it is waiting an ARP
 			reply, and the ARP request should be retransmitted. */
-			if( xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
+			if( pxIPStack->xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
 			{
-				FreeRTOS_OutputARPRequest( xARPCache[ x ].ulIPAddress );
+				FreeRTOS_OutputARPRequest( pxIPStack->xARPCache[ x ].ulIPAddress );
 			}
-			else if( xARPCache[ x ].ucAge <= ( uint8_t ) arpMAX_ARP_AGE_BEFORE_NEW_ARP_REQUEST )
+			else if( pxIPStack->xARPCache[ x ].ucAge <= ( uint8_t ) arpMAX_ARP_AGE_BEFORE_NEW_ARP_REQUEST )
 			{
 				/* This entry will get removed soon.  See if the MAC address is
 				still valid to prevent this happening. */
-				iptraceARP_TABLE_ENTRY_WILL_EXPIRE( xARPCache[ x ].ulIPAddress );
-				FreeRTOS_OutputARPRequest( xARPCache[ x ].ulIPAddress );
+				iptraceARP_TABLE_ENTRY_WILL_EXPIRE( pxIPStack->xARPCache[ x ].ulIPAddress );
+				FreeRTOS_OutputARPRequest( pxIPStack->xARPCache[ x ].ulIPAddress );
 			}
 			else
 			{
 				/* The age has just ticked down, with nothing to do. */
 			}
 
-			if( xARPCache[ x ].ucAge == 0U )
+			if( pxIPStack->xARPCache[ x ].ucAge == 0U )
 			{
 				/* The entry is no longer valid.  Wipe it out. */
-				iptraceARP_TABLE_ENTRY_EXPIRED( xARPCache[ x ].ulIPAddress );
-				xARPCache[ x ].ulIPAddress = 0UL;
+				iptraceARP_TABLE_ENTRY_EXPIRED( pxIPStack->xARPCache[ x ].ulIPAddress );
+				pxIPStack->xARPCache[ x ].ulIPAddress = 0UL;
 			}
 		}
 	}
 
 	xTimeNow = xTaskGetTickCount ();
 
-	if( ( xLastGratuitousARPTime == ( TickType_t ) 0 ) || ( ( xTimeNow - xLastGratuitousARPTime ) > ( TickType_t ) arpGRATUITOUS_ARP_PERIOD ) )
+	if( ( pxIPStack->xLastGratuitousARPTime == ( TickType_t ) 0 ) || ( ( xTimeNow - pxIPStack->xLastGratuitousARPTime ) > ( TickType_t ) arpGRATUITOUS_ARP_PERIOD ) )
 	{
 		FreeRTOS_OutputARPRequest( *ipLOCAL_IP_ADDRESS_POINTER );
-		xLastGratuitousARPTime = xTimeNow;
+		pxIPStack->xLastGratuitousARPTime = xTimeNow;
 	}
 }
 /*-----------------------------------------------------------*/
@@ -572,7 +605,7 @@ void vARPSendGratuitous( void )
 {
 	/* Setting xLastGratuitousARPTime to 0 will force a gratuitous ARP the next
 	time vARPAgeCache() is called. */
-	xLastGratuitousARPTime = ( TickType_t ) 0;
+	pxIPStack->xLastGratuitousARPTime = ( TickType_t ) 0;
 
 	/* Let the IP-task call vARPAgeCache(). */
 	( void ) xSendEventToIPTask( eARPTimerEvent );
@@ -590,6 +623,14 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 	if( pxNetworkBuffer != NULL )
 	{
 		pxNetworkBuffer->ulIPAddress = ulIPAddress;
+
+		#if( ipconfigUSE_ROUTING != 0 )
+		{
+			/* Ask on the end-point through which the address is reached. */
+			vRouteNetworkBuffer( pxNetworkBuffer, ulIPAddress );
+		}
+		#endif
+
 		vARPGenerateRequestPacket( pxNetworkBuffer );
 
 		#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
@@ -610,7 +651,7 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 		if( xIsCallingFromIPTask() != 0 )
 		{
 			/* Only the IP-task is allowed to call this function directly. */
-			( void ) xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+			( void ) ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, pdTRUE );
 		}
 		else
 		{
@@ -649,6 +690,7 @@ static const uint8_t xDefaultPartARPPacketHeader[] =
 };
 
 ARPPacket_t *pxARPPacket;
+uint32_t ulSenderIPAddress;
 
 	/* Buffer allocation ensures that buffers always have space
 	for an ARP packet. See buffer allocation implementations 1
@@ -670,10 +712,11 @@ ARPPacket_t *pxARPPacket;
 		xARPHeader.xTargetHardwareAddress;
 	*/
 	( void ) memcpy( pxARPPacket, xDefaultPartARPPacketHeader, sizeof( xDefaultPartARPPacketHeader ) );
-	( void ) memcpy( pxARPPacket->xEthernetHeader.xSourceAddress.ucBytes , ipLOCAL_MAC_ADDRESS, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
-	( void ) memcpy( pxARPPacket->xARPHeader.xSenderHardwareAddress.ucBytes, ipLOCAL_MAC_ADDRESS, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
+	( void ) memcpy( pxARPPacket->xEthernetHeader.xSourceAddress.ucBytes , ipBUFFER_MAC_ADDRESS( pxNetworkBuffer ), ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
+	( void ) memcpy( pxARPPacket->xARPHeader.xSenderHardwareAddress.ucBytes, ipBUFFER_MAC_ADDRESS( pxNetworkBuffer ), ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
 
-	( void ) memcpy( pxARPPacket->xARPHeader.ucSenderProtocolAddress, ipLOCAL_IP_ADDRESS_POINTER, sizeof( pxARPPacket->xARPHeader.ucSenderProtocolAddress ) );
+	ulSenderIPAddress = ipBUFFER_IP_ADDRESS( pxNetworkBuffer );
+	( void ) memcpy( pxARPPacket->xARPHeader.ucSenderProtocolAddress, &( ulSenderIPAddress ), sizeof( pxARPPacket->xARPHeader.ucSenderProtocolAddress ) );
 	pxARPPacket->xARPHeader.ulTargetProtocolAddress = pxNetworkBuffer->ulIPAddress;
 
 	pxNetworkBuffer->xDataLength = sizeof( ARPPacket_t );
@@ -684,7 +727,7 @@ ARPPacket_t *pxARPPacket;
 
 void FreeRTOS_ClearARP( void )
 {
-	( void ) memset( xARPCache, 0, sizeof( xARPCache ) );
+	( void ) memset( pxIPStack->xARPCache, 0, sizeof( pxIPStack->xARPCache ) );
 }
 /*-----------------------------------------------------------*/
 
@@ -742,19 +785,19 @@ const IPPacket_t *pxIPPacket = ipPOINTER_CAST( IPPacket_t *, pxUseDescriptor->pu
 		/* Loop through each entry in the ARP cache. */
 		for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
 		{
-			if( ( xARPCache[ x ].ulIPAddress != 0UL ) && ( xARPCache[ x ].ucAge > ( uint8_t ) 0U ) )
+			if( ( pxIPStack->xARPCache[ x ].ulIPAddress != 0UL ) && ( pxIPStack->xARPCache[ x ].ucAge > ( uint8_t ) 0U ) )
 			{
 				/* See if the MAC-address also matches, and we're all happy */
 				FreeRTOS_printf( ( "Arp %2ld: %3u - %16lxip : %02x:%02x:%02x : %02x:%02x:%02x\n",
 					x,
-					xARPCache[ x ].ucAge,
-					xARPCache[ x ].ulIPAddress,
-					xARPCache[ x ].xMACAddress.ucBytes[0],
-					xARPCache[ x ].xMACAddress.ucBytes[1],
-					xARPCache[ x ].xMACAddress.ucBytes[2],
-					xARPCache[ x ].xMACAddress.ucBytes[3],
-					xARPCache[ x ].xMACAddress.ucBytes[4],
-					xARPCache[ x ].xMACAddress.ucBytes[5] ) );
+					pxIPStack->xARPCache[ x ].ucAge,
+					pxIPStack->xARPCache[ x ].ulIPAddress,
+					pxIPStack->xARPCache[ x ].xMACAddress.ucBytes[0],
+					pxIPStack->xARPCache[ x ].xMACAddress.ucBytes[1],
+					pxIPStack->xARPCache[ x ].xMACAddress.ucBytes[2],
+					pxIPStack->xARPCache[ x ].xMACAddress.ucBytes[3],
+					pxIPStack->xARPCache[ x ].xMACAddress.ucBytes[4],
+					pxIPStack->xARPCache[ x ].xMACAddress.ucBytes[5] ) );
 				xCount++;
 			}
 		}
@@ -46,6 +46,7 @@
 
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
+#include "FreeRTOS_IP_Stack.h"
 
 #if ( ipconfigUSE_DHCP != 0 ) && ( ipconfigNETWORK_MTU < 586U )
 	/* DHCP must be able to receive an options field of 312 bytes, the fixed
@@ -99,8 +100,8 @@ are located. */
 /* The following define is temporary and serves to make the /single source
 code more similar to the /multi version. */
 
-#define	EP_DHCPData			xDHCPData
-#define	EP_IPv4_SETTINGS	xNetworkAddressing
+#define	EP_DHCPData			pxIPStack->xDHCPData
+#define	EP_IPv4_SETTINGS	pxIPStack->xNetworkAddressing
 
 /* If a lease time is not received, use the default of two days. */
 /* 48 hours in ticks.  Can not use pdMS_TO_TICKS() as integer overflow can occur. */
@@ -154,9 +155,6 @@ struct xDHCPMessage_IPv4
 #include "pack_struct_end.h"
 typedef struct xDHCPMessage_IPv4 DHCPMessage_IPv4_t;
 
-/* The UDP socket used for all incoming and outgoing DHCP traffic. */
-_static Socket_t xDHCPSocket;
-
 #if( ipconfigDHCP_FALL_BACK_AUTO_IP != 0 )
 	/* Define the Link Layer IP address: 169.254.x.x */
 	#define LINK_LAYER_ADDRESS_0	169
@@ -221,16 +219,11 @@ static void prvCloseDHCPSocket( void );
 
 /*-----------------------------------------------------------*/
 
-/* Hold information in between steps in the DHCP state machine. */
-_static DHCPData_t xDHCPData;
-
-/*-----------------------------------------------------------*/
-
 BaseType_t xIsDHCPSocket( Socket_t xSocket )
 {
 BaseType_t xReturn;
 
-	if( xDHCPSocket == xSocket )
+	if( pxIPStack->xDHCPSocket == xSocket )
 	{
 		xReturn = pdTRUE;
 	}
@@ -249,6 +242,10 @@ BaseType_t xGivingUp = pdFALSE;
 #if( ipconfigUSE_DHCP_HOOK != 0 )
 	eDHCPCallbackAnswer_t eAnswer;
 #endif	/* ipconfigUSE_DHCP_HOOK */
+#if( ipconfigUSE_ROUTING != 0 )
+	const uint32_t ulOldIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+	const uint32_t ulOldNetMask = EP_IPv4_SETTINGS.ulNetMask;
+#endif	/* ipconfigUSE_ROUTING */
 
 	/* Is DHCP starting over? */
 	if( xReset != pdFALSE )
@@ -261,7 +258,7 @@ BaseType_t xGivingUp = pdFALSE;
 		case eWaitingSendFirstDiscover :
 			/* Ask the user if a DHCP discovery is required. */
 		#if( ipconfigUSE_DHCP_HOOK != 0 )
-			eAnswer = xApplicationDHCPHook( eDHCPPhasePreDiscover, xNetworkAddressing.ulDefaultIPAddress );
+			eAnswer = xApplicationDHCPHook( eDHCPPhasePreDiscover, pxIPStack->xNetworkAddressing.ulDefaultIPAddress );
 			if( eAnswer == eDHCPContinue )
 		#endif	/* ipconfigUSE_DHCP_HOOK */
 			{
@@ -270,7 +267,7 @@ BaseType_t xGivingUp = pdFALSE;
 				prvInitialiseDHCP();
 
 				/* See if prvInitialiseDHCP() has creates a socket. */
-				if( xDHCPSocket == NULL )
+				if( pxIPStack->xDHCPSocket == NULL )
 				{
 					xGivingUp = pdTRUE;
 				}
@@ -290,7 +287,7 @@ BaseType_t xGivingUp = pdFALSE;
 			{
 				if( eAnswer == eDHCPUseDefaults )
 				{
-					( void ) memcpy( &( xNetworkAddressing ), &( xDefaultAddressing ), sizeof( xNetworkAddressing ) );
+					( void ) memcpy( &( pxIPStack->xNetworkAddressing ), &( pxIPStack->xDefaultAddressing ), sizeof( pxIPStack->xNetworkAddressing ) );
 				}
 
 				/* The user indicates that the DHCP process does not continue. */
@@ -325,7 +322,7 @@ BaseType_t xGivingUp = pdFALSE;
 			#if( ipconfigUSE_DHCP_HOOK != 0 )
 				if( eAnswer == eDHCPUseDefaults )
 				{
-					( void ) memcpy( &( xNetworkAddressing ), &( xDefaultAddressing ), sizeof( xNetworkAddressing ) );
+					( void ) memcpy( &( pxIPStack->xNetworkAddressing ), &( pxIPStack->xDefaultAddressing ), sizeof( pxIPStack->xNetworkAddressing ) );
 				}
 
 				/* The user indicates that the DHCP process does not continue. */
@@ -404,7 +401,7 @@ BaseType_t xGivingUp = pdFALSE;
 
 				/* Setting the 'local' broadcast address, something like
 				'192.168.1.255'. */
-				EP_IPv4_SETTINGS.ulBroadcastAddress = ( EP_DHCPData.ulOfferedIPAddress & xNetworkAddressing.ulNetMask ) |  ~xNetworkAddressing.ulNetMask;
+				EP_IPv4_SETTINGS.ulBroadcastAddress = ( EP_DHCPData.ulOfferedIPAddress & pxIPStack->xNetworkAddressing.ulNetMask ) |  ~pxIPStack->xNetworkAddressing.ulNetMask;
 				EP_DHCPData.eDHCPState = eLeasedAddress;
 
 				iptraceDHCP_SUCCEDEED( EP_DHCPData.ulOfferedIPAddress );
@@ -492,7 +489,7 @@ BaseType_t xGivingUp = pdFALSE;
 				/* Resend the request at the appropriate time to renew the lease. */
 				prvCreateDHCPSocket();
 
-				if( xDHCPSocket != NULL )
+				if( pxIPStack->xDHCPSocket != NULL )
 				{
 					EP_DHCPData.xDHCPTxTime = xTaskGetTickCount();
 					EP_DHCPData.xDHCPTxPeriod = dhcpINITIAL_DHCP_TX_PERIOD;
@@ -530,8 +527,8 @@ BaseType_t xGivingUp = pdFALSE;
 		/* Revert to static IP address. */
 		taskENTER_CRITICAL();
 		{
-			*ipLOCAL_IP_ADDRESS_POINTER = xNetworkAddressing.ulDefaultIPAddress;
-			iptraceDHCP_REQUESTS_FAILED_USING_DEFAULT_IP_ADDRESS( xNetworkAddressing.ulDefaultIPAddress );
+			*ipLOCAL_IP_ADDRESS_POINTER = pxIPStack->xNetworkAddressing.ulDefaultIPAddress;
+			iptraceDHCP_REQUESTS_FAILED_USING_DEFAULT_IP_ADDRESS( pxIPStack->xNetworkAddressing.ulDefaultIPAddress );
 		}
 		taskEXIT_CRITICAL();
 
@@ -545,17 +542,28 @@ BaseType_t xGivingUp = pdFALSE;
 
 		prvCloseDHCPSocket();
 	}
+
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+		/* The routes of the sockets depend on the subnet of the primary
+		end-point. */
+		if( ( *ipLOCAL_IP_ADDRESS_POINTER != ulOldIPAddress ) || ( EP_IPv4_SETTINGS.ulNetMask != ulOldNetMask ) )
+		{
+			vRouteInvalidateCaches();
+		}
+	}
+	#endif	/* ipconfigUSE_ROUTING */
 }
 /*-----------------------------------------------------------*/
 
 static void prvCloseDHCPSocket( void )
 {
-	if( xDHCPSocket != NULL )
+	if( pxIPStack->xDHCPSocket != NULL )
 	{
 		/* This modules runs from the IP-task. Use the internal
 		function 'vSocketClose()` to close the socket. */
-		( void ) vSocketClose( xDHCPSocket );
-		xDHCPSocket = NULL;
+		( void ) vSocketClose( pxIPStack->xDHCPSocket );
+		pxIPStack->xDHCPSocket = NULL;
 	}
 }
 /*-----------------------------------------------------------*/
@@ -567,20 +575,20 @@ BaseType_t xReturn;
 TickType_t xTimeoutTime = ( TickType_t ) 0;
 
 	/* Create the socket, if it has not already been created. */
-	if( xDHCPSocket == NULL )
+	if( pxIPStack->xDHCPSocket == NULL )
 	{
-		xDHCPSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
-		if( xDHCPSocket != FREERTOS_INVALID_SOCKET )
+		pxIPStack->xDHCPSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+		if( pxIPStack->xDHCPSocket != FREERTOS_INVALID_SOCKET )
 		{
 
 			/* Ensure the Rx and Tx timeouts are zero as the DHCP executes in the
 			context of the IP task. */
-			( void ) FreeRTOS_setsockopt( xDHCPSocket, 0, FREERTOS_SO_RCVTIMEO, &( xTimeoutTime ), sizeof( TickType_t ) );
-			( void ) FreeRTOS_setsockopt( xDHCPSocket, 0, FREERTOS_SO_SNDTIMEO, &( xTimeoutTime ), sizeof( TickType_t ) );
+			( void ) FreeRTOS_setsockopt( pxIPStack->xDHCPSocket, 0, FREERTOS_SO_RCVTIMEO, &( xTimeoutTime ), sizeof( TickType_t ) );
+			( void ) FreeRTOS_setsockopt( pxIPStack->xDHCPSocket, 0, FREERTOS_SO_SNDTIMEO, &( xTimeoutTime ), sizeof( TickType_t ) );
 
 			/* Bind to the standard DHCP client port. */
 			xAddress.sin_port = ( uint16_t ) dhcpCLIENT_PORT_IPv4;
-			xReturn = vSocketBind( xDHCPSocket, &xAddress, sizeof( xAddress ), pdFALSE );
+			xReturn = vSocketBind( pxIPStack->xDHCPSocket, &xAddress, sizeof( xAddress ), pdFALSE );
 			if( xReturn != 0 )
 			{
 				/* Binding failed, close the socket again. */
@@ -590,7 +598,7 @@ TickType_t xTimeoutTime = ( TickType_t ) 0;
 		else
 		{
 			/* Change to NULL for easier testing. */
-			xDHCPSocket = NULL;
+			pxIPStack->xDHCPSocket = NULL;
 		}
 	}
 }
@@ -634,7 +642,7 @@ BaseType_t xReturn = pdFALSE;
 const uint32_t ulMandatoryOptions = 2UL; /* DHCP server address, and the correct DHCP message type must be present in the options. */
 
 	/* Passing the address of a pointer (pucUDPPayload) because FREERTOS_ZERO_COPY is used. */
-	lBytes = FreeRTOS_recvfrom( xDHCPSocket, &pucUDPPayload, 0UL, FREERTOS_ZERO_COPY, NULL, NULL );
+	lBytes = FreeRTOS_recvfrom( pxIPStack->xDHCPSocket, &pucUDPPayload, 0UL, FREERTOS_ZERO_COPY, NULL, NULL );
 
 	if( lBytes > 0 )
 	{
@@ -974,7 +982,7 @@ size_t uxOptionsLength = sizeof( ucDHCPRequestOptions );
 	FreeRTOS_debug_printf( ( "vDHCPProcess: reply %lxip\n", FreeRTOS_ntohl( EP_DHCPData.ulOfferedIPAddress ) ) );
 	iptraceSENDING_DHCP_REQUEST();
 
-	if( FreeRTOS_sendto( xDHCPSocket, pucUDPPayloadBuffer, sizeof( DHCPMessage_IPv4_t ) + uxOptionsLength, FREERTOS_ZERO_COPY, &xAddress, sizeof( xAddress ) ) == 0 )
+	if( FreeRTOS_sendto( pxIPStack->xDHCPSocket, pucUDPPayloadBuffer, sizeof( DHCPMessage_IPv4_t ) + uxOptionsLength, FREERTOS_ZERO_COPY, &xAddress, sizeof( xAddress ) ) == 0 )
 	{
 		/* The packet was not successfully queued for sending and must be
 		returned to the stack. */
@@ -1005,7 +1013,7 @@ size_t uxOptionsLength = sizeof( ucDHCPDiscoverOptions );
 	FreeRTOS_debug_printf( ( "vDHCPProcess: discover\n" ) );
 	iptraceSENDING_DHCP_DISCOVER();
 
-	if( FreeRTOS_sendto( xDHCPSocket,
+	if( FreeRTOS_sendto( pxIPStack->xDHCPSocket,
 						 pucUDPPayloadBuffer,
 						 sizeof( DHCPMessage_IPv4_t ) + uxOptionsLength,
 						 FREERTOS_ZERO_COPY,
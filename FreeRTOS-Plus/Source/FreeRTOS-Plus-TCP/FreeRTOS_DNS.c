@@ -41,6 +41,7 @@
 #include "FreeRTOS_DHCP.h"
 #include "NetworkBufferManagement.h"
 #include "NetworkInterface.h"
+#include "FreeRTOS_IP_Stack.h"
 
 #include "FreeRTOSIPConfigDefaults.h"
 
@@ -208,24 +209,10 @@ static uint32_t prvGetHostByName( const char *pcHostName,
 										  uint32_t ulTTL,
 										  BaseType_t xLookUp );
 
-	typedef struct xDNS_CACHE_TABLE_ROW
-	{
-		uint32_t ulIPAddresses[ ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY ]; /* The IP address(es) of an ARP cache entry. */
-		char pcName[ ipconfigDNS_CACHE_NAME_LENGTH ]; /* The name of the host */
-		uint32_t ulTTL;                               /* Time-to-Live (in seconds) from the DNS server. */
-		uint32_t ulTimeWhenAddedInSeconds;
-#if( ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY > 1 )
-		uint8_t  ucNumIPAddresses;
-		uint8_t  ucCurrentIPAddress;
-#endif
-	} DNSCacheRow_t;
-
-	static DNSCacheRow_t xDNSCache[ ipconfigDNS_CACHE_ENTRIES ];
-
 	/* Utility function: Clear DNS cache by calling this function. */
 	void FreeRTOS_dnsclear( void )
 	{
-		( void ) memset( xDNSCache, 0x0, sizeof( xDNSCache ) );
+		( void ) memset( pxIPStack->xDNSCache, 0x0, sizeof( pxIPStack->xDNSCache ) );
 	}
 #endif /* ipconfigUSE_DNS_CACHE == 1 */
 
@@ -353,8 +340,6 @@ typedef struct xDNSAnswerRecord DNSAnswerRecord_t;
 		char pcName[ 1 ];
 	} DNSCallback_t;
 
-	static List_t xCallbackList;
-
 	/* Define FreeRTOS_gethostbyname() as a normal blocking call. */
 	uint32_t FreeRTOS_gethostbyname( const char *pcHostName )
 	{
@@ -365,7 +350,7 @@ typedef struct xDNSAnswerRecord DNSAnswerRecord_t;
 	/* Initialise the list of call-back structures. */
 	void vDNSInitialise( void )
 	{
-		vListInitialise( &xCallbackList );
+		vListInitialise( &pxIPStack->xDNSCallbackList );
 	}
 	/*-----------------------------------------------------------*/
 
@@ -377,7 +362,7 @@ typedef struct xDNSAnswerRecord DNSAnswerRecord_t;
 	void vDNSCheckCallBack( void *pvSearchID )
 	{
 	const ListItem_t * pxIterator;
-	const ListItem_t * xEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xCallbackList ) );
+	const ListItem_t * xEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xDNSCallbackList ) );
 
 		vTaskSuspendAll();
 		{
@@ -407,7 +392,7 @@ typedef struct xDNSAnswerRecord DNSAnswerRecord_t;
 		}
 		( void ) xTaskResumeAll();
 
-		if( listLIST_IS_EMPTY( &xCallbackList ) != pdFALSE )
+		if( listLIST_IS_EMPTY( &pxIPStack->xDNSCallbackList ) != pdFALSE )
 		{
 			vIPSetDnsTimerEnableState( pdFALSE );
 		}
@@ -437,7 +422,7 @@ typedef struct xDNSAnswerRecord DNSAnswerRecord_t;
 
 		if( pxCallback != NULL )
 		{
-			if( listLIST_IS_EMPTY( &xCallbackList ) != pdFALSE )
+			if( listLIST_IS_EMPTY( &pxIPStack->xDNSCallbackList ) != pdFALSE )
 			{
 				/* This is the first one, start the DNS timer to check for timeouts */
 				vIPReloadDNSTimer( FreeRTOS_min_uint32( 1000U, uxTimeout ) );
@@ -452,7 +437,7 @@ typedef struct xDNSAnswerRecord DNSAnswerRecord_t;
 			listSET_LIST_ITEM_VALUE( &( pxCallback->xListItem ), uxIdentifier );
 			vTaskSuspendAll();
 			{
-				vListInsertEnd( &xCallbackList, &pxCallback->xListItem );
+				vListInsertEnd( &pxIPStack->xDNSCallbackList, &pxCallback->xListItem );
 			}
 			( void ) xTaskResumeAll();
 		}
@@ -467,7 +452,7 @@ typedef struct xDNSAnswerRecord DNSAnswerRecord_t;
 	{
 	BaseType_t xResult = pdFALSE;
 	const ListItem_t * pxIterator;
-	const ListItem_t * xEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xCallbackList ) );
+	const ListItem_t * xEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xDNSCallbackList ) );
 
 		vTaskSuspendAll();
 		{
@@ -483,7 +468,7 @@ typedef struct xDNSAnswerRecord DNSAnswerRecord_t;
 					( void ) uxListRemove( &pxCallback->xListItem );
 					vPortFree( pxCallback );
 
-					if( listLIST_IS_EMPTY( &xCallbackList ) != pdFALSE )
+					if( listLIST_IS_EMPTY( &pxIPStack->xDNSCallbackList ) != pdFALSE )
 					{
 						/* The list of outstanding requests is empty. No need for periodic polling. */
 						vIPSetDnsTimerEnableState( pdFALSE );
@@ -1410,7 +1395,7 @@ BaseType_t xReturn = pdTRUE;
 						vSetField16( pxAnswer, LLMNRAnswer_t, usClass, dnsCLASS_IN );   /* 1: Class IN */
 						vSetField32( pxAnswer, LLMNRAnswer_t, ulTTL, dnsLLMNR_TTL_VALUE );
 						vSetField16( pxAnswer, LLMNRAnswer_t, usDataLength, 4 );
-						vSetField32( pxAnswer, LLMNRAnswer_t, ulIPAddress, FreeRTOS_ntohl( *ipLOCAL_IP_ADDRESS_POINTER ) );
+						vSetField32( pxAnswer, LLMNRAnswer_t, ulIPAddress, FreeRTOS_ntohl( ipBUFFER_IP_ADDRESS( pxNetworkBuffer ) ) );
 						#endif /* lint */
 						usLength = ( int16_t ) ( sizeof( *pxAnswer ) + ( size_t ) ( pucByte - pucNewBuffer ) );
 
@@ -1590,7 +1575,7 @@ BaseType_t xReturn = pdTRUE;
 					vSetField32( pxAnswer, NBNSAnswer_t, ulTTL, dnsNBNS_TTL_VALUE );
 					vSetField16( pxAnswer, NBNSAnswer_t, usDataLength, 6 );           /* 6 bytes including the length field */
 					vSetField16( pxAnswer, NBNSAnswer_t, usNbFlags, dnsNBNS_NAME_FLAGS );
-					vSetField32( pxAnswer, NBNSAnswer_t, ulIPAddress, FreeRTOS_ntohl( *ipLOCAL_IP_ADDRESS_POINTER ) );
+					vSetField32( pxAnswer, NBNSAnswer_t, ulIPAddress, FreeRTOS_ntohl( ipBUFFER_IP_ADDRESS( pxNetworkBuffer ) ) );
 					#else
 					( void ) pxAnswer;
 					#endif
@@ -1659,10 +1644,10 @@ BaseType_t xReturn;
 			pxIPHeader->usLength				= FreeRTOS_htons( ( uint16_t ) lNetLength + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_UDP_HEADER );
 		/* HT:endian: should not be translated, copying from packet to packet */
 		pxIPHeader->ulDestinationIPAddress = pxIPHeader->ulSourceIPAddress;
-		pxIPHeader->ulSourceIPAddress	   = *ipLOCAL_IP_ADDRESS_POINTER;
+		pxIPHeader->ulSourceIPAddress	   = ipBUFFER_IP_ADDRESS( pxNetworkBuffer );
 		pxIPHeader->ucTimeToLive		   = ipconfigUDP_TIME_TO_LIVE;
-		pxIPHeader->usIdentification	   = FreeRTOS_htons( usPacketIdentifier );
-		usPacketIdentifier++;
+		pxIPHeader->usIdentification	   = FreeRTOS_htons( pxIPStack->usPacketIdentifier );
+		pxIPStack->usPacketIdentifier++;
 		pxUDPHeader->usLength			   = FreeRTOS_htons( ( uint32_t ) lNetLength + ipSIZE_OF_UDP_HEADER );
 		vFlip_16( pxUDPHeader->usSourcePort, pxUDPHeader->usDestinationPort );
 
@@ -1702,25 +1687,24 @@ BaseType_t xReturn;
 	BaseType_t xFound = pdFALSE;
 	uint32_t ulCurrentTimeSeconds = ( xTaskGetTickCount() / portTICK_PERIOD_MS ) / 1000U;
 	uint32_t ulIPAddressIndex = 0;
-	static BaseType_t xFreeEntry = 0;
 
 		configASSERT( ( pcName != NULL ) );
 
 		/* For each entry in the DNS cache table. */
 		for( x = 0; x < ipconfigDNS_CACHE_ENTRIES; x++ )
 		{
-			if( xDNSCache[ x ].pcName[ 0 ] == ( char ) 0 )
+			if( pxIPStack->xDNSCache[ x ].pcName[ 0 ] == ( char ) 0 )
 			{
 				continue;
 			}
 
-			if( strcmp( xDNSCache[ x ].pcName, pcName ) == 0 )
+			if( strcmp( pxIPStack->xDNSCache[ x ].pcName, pcName ) == 0 )
 			{
 				/* Is this function called for a lookup or to add/update an IP address? */
 				if( xLookUp != pdFALSE )
 				{
 					/* Confirm that the record is still fresh. */
-					if( ulCurrentTimeSeconds < ( xDNSCache[ x ].ulTimeWhenAddedInSeconds + FreeRTOS_ntohl( xDNSCache[ x ].ulTTL ) ) )
+					if( ulCurrentTimeSeconds < ( pxIPStack->xDNSCache[ x ].ulTimeWhenAddedInSeconds + FreeRTOS_ntohl( pxIPStack->xDNSCache[ x ].ulTTL ) ) )
 					{
 #if( ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY > 1 )
 					uint8_t ucIndex;
@@ -1729,35 +1713,35 @@ BaseType_t xReturn;
 						/*  Also perform a final modulo by the max number of IP addresses    */
 						/*  per DNS cache entry to prevent out-of-bounds access in the event */
 						/*  that ucNumIPAddresses has been corrupted.                        */
-						ucIndex = xDNSCache[ x ].ucCurrentIPAddress % xDNSCache[ x ].ucNumIPAddresses;
+						ucIndex = pxIPStack->xDNSCache[ x ].ucCurrentIPAddress % pxIPStack->xDNSCache[ x ].ucNumIPAddresses;
 						ucIndex = ucIndex % ( uint8_t ) ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY;
 						ulIPAddressIndex = ucIndex;
 
-						xDNSCache[ x ].ucCurrentIPAddress++;
+						pxIPStack->xDNSCache[ x ].ucCurrentIPAddress++;
 #endif
-						*pulIP = xDNSCache[ x ].ulIPAddresses[ ulIPAddressIndex ];
+						*pulIP = pxIPStack->xDNSCache[ x ].ulIPAddresses[ ulIPAddressIndex ];
 					}
 					else
 					{
 						/* Age out the old cached record. */
-						xDNSCache[ x ].pcName[ 0 ] = ( char ) 0;
+						pxIPStack->xDNSCache[ x ].pcName[ 0 ] = ( char ) 0;
 					}
 				}
 				else
 				{
 #if( ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY > 1 )
-					if ( xDNSCache[ x ].ucNumIPAddresses < ( uint8_t ) ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY )
+					if ( pxIPStack->xDNSCache[ x ].ucNumIPAddresses < ( uint8_t ) ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY )
 					{
 						/* If more answers exist than there are IP address storage slots */
 						/* they will overwrite entry 0 */
 
-						ulIPAddressIndex = xDNSCache[ x ].ucNumIPAddresses;
-						xDNSCache[ x ].ucNumIPAddresses++;
+						ulIPAddressIndex = pxIPStack->xDNSCache[ x ].ucNumIPAddresses;
+						pxIPStack->xDNSCache[ x ].ucNumIPAddresses++;
 					}
 #endif
-					xDNSCache[ x ].ulIPAddresses[ ulIPAddressIndex ] = *pulIP;
-					xDNSCache[ x ].ulTTL = ulTTL;
-					xDNSCache[ x ].ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
+					pxIPStack->xDNSCache[ x ].ulIPAddresses[ ulIPAddressIndex ] = *pulIP;
+					pxIPStack->xDNSCache[ x ].ulTTL = ulTTL;
+					pxIPStack->xDNSCache[ x ].ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
 				}
 
 				xFound = pdTRUE;
@@ -1776,27 +1760,27 @@ BaseType_t xReturn;
 				/* Add or update the item. */
 				if( strlen( pcName ) < ( size_t ) ipconfigDNS_CACHE_NAME_LENGTH )
 				{
-					( void ) strcpy( xDNSCache[ xFreeEntry ].pcName, pcName );
+					( void ) strcpy( pxIPStack->xDNSCache[ pxIPStack->xDNSFreeEntry ].pcName, pcName );
 
-					xDNSCache[ xFreeEntry ].ulIPAddresses[ 0 ] = *pulIP;
-					xDNSCache[ xFreeEntry ].ulTTL = ulTTL;
-					xDNSCache[ xFreeEntry ].ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
+					pxIPStack->xDNSCache[ pxIPStack->xDNSFreeEntry ].ulIPAddresses[ 0 ] = *pulIP;
+					pxIPStack->xDNSCache[ pxIPStack->xDNSFreeEntry ].ulTTL = ulTTL;
+					pxIPStack->xDNSCache[ pxIPStack->xDNSFreeEntry ].ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
 #if( ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY > 1 )
-					xDNSCache[ xFreeEntry ].ucNumIPAddresses = 1;
-					xDNSCache[ xFreeEntry ].ucCurrentIPAddress = 0;
+					pxIPStack->xDNSCache[ pxIPStack->xDNSFreeEntry ].ucNumIPAddresses = 1;
+					pxIPStack->xDNSCache[ pxIPStack->xDNSFreeEntry ].ucCurrentIPAddress = 0;
 
 					/* Initialize all remaining IP addresses in this entry to 0 */
-					( void ) memset( &xDNSCache[ xFreeEntry ].ulIPAddresses[ 1 ],
+					( void ) memset( &pxIPStack->xDNSCache[ pxIPStack->xDNSFreeEntry ].ulIPAddresses[ 1 ],
 							0,
-							sizeof( xDNSCache[ xFreeEntry ].ulIPAddresses[ 1 ] ) *
+							sizeof( pxIPStack->xDNSCache[ pxIPStack->xDNSFreeEntry ].ulIPAddresses[ 1 ] ) *
 								( ( uint32_t ) ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY - 1U ) );
 #endif
 
-					xFreeEntry++;
+					pxIPStack->xDNSFreeEntry++;
 
-					if( xFreeEntry == ipconfigDNS_CACHE_ENTRIES )
+					if( pxIPStack->xDNSFreeEntry == ipconfigDNS_CACHE_ENTRIES )
 					{
-						xFreeEntry = 0;
+						pxIPStack->xDNSFreeEntry = 0;
 					}
 				}
 			}
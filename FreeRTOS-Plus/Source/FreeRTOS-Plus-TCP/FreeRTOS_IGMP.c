@@ -0,0 +1,883 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_DNS.h"
+#include "FreeRTOS_IGMP.h"
+
+#include "FreeRTOSIPConfigDefaults.h"
+
+/* Exclude the entire file if IGMP is not enabled. */
+#if( ipconfigUSE_IGMP != 0 )
+
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+#include "FreeRTOS_IP_Stack.h"
+
+#if( ipconfigIGMP_MAX_GROUPS > 32 )
+	/* Every socket keeps a 32-bit mask of the groups that it has joined. */
+	#error ipconfigIGMP_MAX_GROUPS can not be larger than 32
+#endif
+
+#if( ipconfigIP_PASS_PACKETS_WITH_IP_OPTIONS == 0 )
+	/* Queries carry the Router Alert option. */
+	#error ipconfigIP_PASS_PACKETS_WITH_IP_OPTIONS must be 1 when IGMP is used
+#endif
+
+/* IGMP message types. */
+#define igmpTYPE_MEMBERSHIP_QUERY		( ( uint8_t ) 0x11U )
+#define igmpTYPE_V1_MEMBERSHIP_REPORT	( ( uint8_t ) 0x12U )
+#define igmpTYPE_V2_MEMBERSHIP_REPORT	( ( uint8_t ) 0x16U )
+#define igmpTYPE_V2_LEAVE_GROUP			( ( uint8_t ) 0x17U )
+#define igmpTYPE_V3_MEMBERSHIP_REPORT	( ( uint8_t ) 0x22U )
+
+/* IGMPv3 group record types, only the "any source" variants are used. */
+#define igmpRECORD_MODE_IS_EXCLUDE		( ( uint8_t ) 2U )
+#define igmpRECORD_CHANGE_TO_INCLUDE	( ( uint8_t ) 3U )
+#define igmpRECORD_CHANGE_TO_EXCLUDE	( ( uint8_t ) 4U )
+
+/* The addresses used by IGMP, in network byte order. */
+#define igmpALL_SYSTEMS_ADDRESS			FreeRTOS_htonl( 0xE0000001UL )	/* 224.0.0.1, every host is a member. */
+#define igmpALL_ROUTERS_ADDRESS			FreeRTOS_htonl( 0xE0000002UL )	/* 224.0.0.2, receives IGMPv2 leave messages. */
+#define igmpV3_REPORT_ADDRESS			FreeRTOS_htonl( 0xE0000016UL )	/* 224.0.0.22, receives IGMPv3 reports. */
+
+/* The lower 23 bits of a group address are mapped onto its MAC address. */
+#define igmpMAC_ADDRESS_MASK			( 0x007FFFFFUL )
+
+/* Sent messages carry the Router Alert option (RFC 2113), which makes the IP
+header 4 bytes longer. */
+#define igmpIP_HEADER_LENGTH			( ipSIZE_OF_IPv4_HEADER + 4U )
+#define igmpMESSAGE_OFFSET				( ipSIZE_OF_ETH_HEADER + igmpIP_HEADER_LENGTH )
+#define igmpTOS_INTERNETWORK_CONTROL	( ( uint8_t ) 0xC0U )
+
+/* A v1/v2 message is 8 bytes long, a v3 query has at least 12 bytes.  A v3
+report has an 8-byte header followed by 8 bytes for every group record. */
+#define igmpV3_QUERY_MIN_LENGTH			( 12U )
+#define igmpV3_RECORD_LENGTH			( 8U )
+#define igmpMAX_MESSAGE_LENGTH			( ipSIZE_OF_IGMP_HEADER + ( ipconfigIGMP_MAX_GROUPS * igmpV3_RECORD_LENGTH ) )
+
+/* The number of times that a change of membership is reported: the
+Robustness Variable of RFC 3376. */
+#define igmpROBUSTNESS					( ( uint8_t ) 2U )
+
+/* The repetitions of an unsolicited report are spread over this interval. */
+#define igmpUNSOLICITED_REPORT_INTERVAL_MS	( 1000U )
+
+/* The response time of a v1 query, which does not have a Max Resp Code. */
+#define igmpV1_MAX_RESPONSE_TIME_MS		( 10000U )
+
+/* After an older querier was heard, its version is used for this long: the
+Older Version Querier Present Timeout (2 * 125 + 10 seconds). */
+#define igmpOLDER_QUERIER_TIMEOUT_MS	( 260000U )
+
+/* The time to wait before trying again when no network buffer was available. */
+#define igmpRETRY_DELAY_MS				( 100U )
+
+/*
+ * Find the entry of a group, or a free entry when 'ulGroupAddress' is 0.
+ * Returns -1 when it was not found.
+ */
+static BaseType_t prvFindGroup( uint32_t ulGroupAddress );
+
+/*
+ * Let a group send 'ucCount' messages of the type 'ucRecordType', the first
+ * one after 'xDelay' clock ticks.
+ */
+static void prvScheduleReport( IGMPGroup_t *pxGroup, uint8_t ucRecordType, uint8_t ucCount, TickType_t xDelay );
+
+/*
+ * The IGMP version to use: 3, unless an older querier has been heard recently.
+ */
+static BaseType_t prvIGMPVersion( void );
+
+/*
+ * Respond to a query for 'ulGroupAddress', or for all groups when it is 0,
+ * within 'xMaxResponseTime' clock ticks.
+ */
+static void prvHandleQuery( uint32_t ulGroupAddress, TickType_t xMaxResponseTime );
+
+/*
+ * Write the next message that is due into 'pucMessage' and update the state
+ * of the groups involved.  Returns the length of the message, or 0 when no
+ * message is due.  Must be called with the scheduler suspended.
+ */
+static size_t prvBuildMessage( uint8_t *pucMessage, BaseType_t xVersion, uint32_t ulRandom, uint32_t *pulDestination );
+
+/*
+ * Add the Ethernet and IP headers to a message and send it.
+ */
+static void prvSendMessage( NetworkBufferDescriptor_t *pxNetworkBuffer, size_t uxLength, uint32_t ulDestination );
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFindGroup( uint32_t ulGroupAddress )
+{
+BaseType_t xIndex;
+BaseType_t xReturn = -1;
+
+	for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIGMP_MAX_GROUPS; xIndex++ )
+	{
+		if( pxIPStack->xIGMPGroups[ xIndex ].ulGroupAddress == ulGroupAddress )
+		{
+			xReturn = xIndex;
+			break;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvScheduleReport( IGMPGroup_t *pxGroup, uint8_t ucRecordType, uint8_t ucCount, TickType_t xDelay )
+{
+	pxGroup->ucRecordType = ucRecordType;
+	pxGroup->ucReportCount = ucCount;
+	pxGroup->xReportTime = xTaskGetTickCount();
+	pxGroup->xReportDelay = xDelay;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIGMPSocketMembership( uint32_t *pulGroupMask, uint32_t ulGroupAddress, BaseType_t xJoin )
+{
+BaseType_t xReturn = 0;
+BaseType_t xIndex;
+BaseType_t xChanged = pdFALSE;
+IGMPGroup_t *pxGroup;
+
+	if( ( xIsIPv4Multicast( ulGroupAddress ) == pdFALSE ) || ( ulGroupAddress == igmpALL_SYSTEMS_ADDRESS ) )
+	{
+		/* Only multicast addresses can be joined, and 224.0.0.1 is joined
+		already. */
+		xReturn = -pdFREERTOS_ERRNO_EINVAL;
+	}
+	else
+	{
+		/* Sockets may be used by any task, the IP-task reads and updates the
+		table too. */
+		vTaskSuspendAll();
+		{
+			xIndex = prvFindGroup( ulGroupAddress );
+
+			if( xJoin != pdFALSE )
+			{
+				if( xIndex < 0 )
+				{
+					xIndex = prvFindGroup( 0UL );
+
+					if( xIndex >= 0 )
+					{
+						( void ) memset( &( pxIPStack->xIGMPGroups[ xIndex ] ), 0, sizeof( pxIPStack->xIGMPGroups[ xIndex ] ) );
+						pxIPStack->xIGMPGroups[ xIndex ].ulGroupAddress = ulGroupAddress;
+					}
+				}
+
+				if( xIndex < 0 )
+				{
+					/* The table is full. */
+					xReturn = -pdFREERTOS_ERRNO_ENOBUFS;
+				}
+				else if( ( *pulGroupMask & ( 1UL << xIndex ) ) != 0UL )
+				{
+					/* The socket is a member already. */
+					xReturn = -pdFREERTOS_ERRNO_EADDRINUSE;
+				}
+				else
+				{
+					pxGroup = &( pxIPStack->xIGMPGroups[ xIndex ] );
+					*pulGroupMask |= ( 1UL << xIndex );
+					pxGroup->uxReferenceCount++;
+
+					if( pxGroup->uxReferenceCount == 1U )
+					{
+						/* A new group, or a group that was being left: announce
+						the membership right away. */
+						prvScheduleReport( pxGroup, igmpRECORD_CHANGE_TO_EXCLUDE, igmpROBUSTNESS, 0U );
+						pxIPStack->xIGMPFilterChanged = pdTRUE;
+						xChanged = pdTRUE;
+					}
+				}
+			}
+			else
+			{
+				if( ( xIndex < 0 ) || ( ( *pulGroupMask & ( 1UL << xIndex ) ) == 0UL ) )
+				{
+					xReturn = -pdFREERTOS_ERRNO_EADDRNOTAVAIL;
+				}
+				else
+				{
+					pxGroup = &( pxIPStack->xIGMPGroups[ xIndex ] );
+					*pulGroupMask &= ~( 1UL << xIndex );
+					pxGroup->uxReferenceCount--;
+
+					if( pxGroup->uxReferenceCount == 0U )
+					{
+						/* The last member has left, the entry will be freed
+						after the leave messages have been sent. */
+						prvScheduleReport( pxGroup, igmpRECORD_CHANGE_TO_INCLUDE, igmpROBUSTNESS, 0U );
+						pxIPStack->xIGMPFilterChanged = pdTRUE;
+						xChanged = pdTRUE;
+					}
+				}
+			}
+		}
+		( void ) xTaskResumeAll();
+	}
+
+	if( xChanged != pdFALSE )
+	{
+		if( xJoin != pdFALSE )
+		{
+			iptraceIGMP_JOIN_GROUP( ulGroupAddress );
+		}
+		else
+		{
+			iptraceIGMP_LEAVE_GROUP( ulGroupAddress );
+		}
+
+		/* Let the IP-task send the messages and update the filter. */
+		( void ) xSendEventToIPTask( eIGMPEvent );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vIGMPSocketLeaveAll( uint32_t *pulGroupMask )
+{
+BaseType_t xIndex;
+
+	for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIGMP_MAX_GROUPS; xIndex++ )
+	{
+		if( ( *pulGroupMask & ( 1UL << xIndex ) ) != 0UL )
+		{
+			( void ) xIGMPSocketMembership( pulGroupMask, pxIPStack->xIGMPGroups[ xIndex ].ulGroupAddress, pdFALSE );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vIGMPInitialise( void )
+{
+	/* Speak IGMPv3 until an older querier is heard. */
+	pxIPStack->xIGMPVersion = 3;
+
+	#if( ipconfigUSE_LLMNR == 1 )
+	{
+		/* LLMNR requests are sent to a multicast group. */
+		( void ) xIGMPSocketMembership( &pxIPStack->ulStackGroupMask, ipLLMNR_IP_ADDR, pdTRUE );
+	}
+	#endif /* ipconfigUSE_LLMNR */
+
+	/* In case no group is joined by the stack. */
+	( void ) pxIPStack->ulStackGroupMask;
+}
+/*-----------------------------------------------------------*/
+
+void vIGMPNetworkUp( void )
+{
+BaseType_t xIndex;
+IGMPGroup_t *pxGroup;
+
+	vTaskSuspendAll();
+	{
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIGMP_MAX_GROUPS; xIndex++ )
+		{
+			pxGroup = &( pxIPStack->xIGMPGroups[ xIndex ] );
+
+			if( pxGroup->ulGroupAddress == 0UL )
+			{
+				/* A free entry. */
+			}
+			else if( pxGroup->uxReferenceCount == 0U )
+			{
+				/* The group was left while the network was down, there is no
+				need to tell the new network about it. */
+				( void ) memset( pxGroup, 0, sizeof( *pxGroup ) );
+			}
+			else
+			{
+				prvScheduleReport( pxGroup, igmpRECORD_CHANGE_TO_EXCLUDE, igmpROBUSTNESS, 0U );
+			}
+		}
+
+		/* The driver has been initialised again, and so has its filter. */
+		pxIPStack->xIGMPFilterChanged = pdTRUE;
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIGMPVersion( void )
+{
+	if( pxIPStack->xIGMPVersion < 3 )
+	{
+		if( ( xTaskGetTickCount() - pxIPStack->xOlderQuerierTime ) >= pdMS_TO_TICKS( igmpOLDER_QUERIER_TIMEOUT_MS ) )
+		{
+			/* The older querier has not been heard for a while. */
+			pxIPStack->xIGMPVersion = 3;
+		}
+	}
+
+	return pxIPStack->xIGMPVersion;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHandleQuery( uint32_t ulGroupAddress, TickType_t xMaxResponseTime )
+{
+BaseType_t xIndex;
+IGMPGroup_t *pxGroup;
+TickType_t xDelay, xElapsed;
+uint32_t ulRandom;
+
+	for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIGMP_MAX_GROUPS; xIndex++ )
+	{
+		pxGroup = &( pxIPStack->xIGMPGroups[ xIndex ] );
+
+		if( ( pxGroup->uxReferenceCount == 0U ) ||
+			( ( ulGroupAddress != 0UL ) && ( ulGroupAddress != pxGroup->ulGroupAddress ) ) )
+		{
+			continue;
+		}
+
+		/* The answer is sent after a random delay, so that the members of a
+		group do not all answer at the same time. */
+		if( ( xMaxResponseTime == 0U ) || ( xApplicationGetRandomNumber( &( ulRandom ) ) == pdFALSE ) )
+		{
+			xDelay = 0U;
+		}
+		else
+		{
+			xDelay = ( TickType_t ) ( ulRandom % ( uint32_t ) xMaxResponseTime );
+		}
+
+		vTaskSuspendAll();
+		{
+			if( pxGroup->uxReferenceCount == 0U )
+			{
+				/* The group was left in the mean time. */
+			}
+			else if( pxGroup->ucReportCount == 0U )
+			{
+				prvScheduleReport( pxGroup, igmpRECORD_MODE_IS_EXCLUDE, 1U, xDelay );
+			}
+			else
+			{
+				/* A message is pending already, make sure that it will be sent
+				in time. */
+				xElapsed = xTaskGetTickCount() - pxGroup->xReportTime;
+
+				if( ( xElapsed < pxGroup->xReportDelay ) && ( ( pxGroup->xReportDelay - xElapsed ) > xDelay ) )
+				{
+					pxGroup->xReportTime += xElapsed;
+					pxGroup->xReportDelay = xDelay;
+				}
+			}
+		}
+		( void ) xTaskResumeAll();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vProcessIGMPPacket( const uint8_t *pucIGMPMessage, size_t uxLength )
+{
+uint32_t ulGroupAddress;
+uint32_t ulMaxResponse;
+uint8_t ucCode;
+BaseType_t xVersion;
+BaseType_t xIndex;
+
+	if( ( uxLength < ( size_t ) ipSIZE_OF_IGMP_HEADER ) ||
+		( usGenerateChecksum( 0U, pucIGMPMessage, uxLength ) != 0xffffU ) )
+	{
+		/* Too short, or damaged. */
+	}
+	else
+	{
+		( void ) memcpy( &( ulGroupAddress ), &( pucIGMPMessage[ 4 ] ), sizeof( ulGroupAddress ) );
+		ucCode = pucIGMPMessage[ 1 ];
+
+		if( pucIGMPMessage[ 0 ] == igmpTYPE_MEMBERSHIP_QUERY )
+		{
+			if( uxLength >= igmpV3_QUERY_MIN_LENGTH )
+			{
+				xVersion = 3;
+
+				/* Max Resp Code, in units of 0.1 seconds.  Above 127 it is a
+				floating point value. */
+				if( ucCode < 128U )
+				{
+					ulMaxResponse = ( uint32_t ) ucCode;
+				}
+				else
+				{
+					ulMaxResponse = ( ( uint32_t ) ucCode & 0x0FUL ) | 0x10UL;
+					ulMaxResponse <<= ( ( ( uint32_t ) ucCode >> 4 ) & 0x07UL ) + 3UL;
+				}
+				ulMaxResponse *= 100UL;
+			}
+			else if( ucCode == 0U )
+			{
+				xVersion = 1;
+				ulMaxResponse = igmpV1_MAX_RESPONSE_TIME_MS;
+				ulGroupAddress = 0UL;
+			}
+			else
+			{
+				xVersion = 2;
+				ulMaxResponse = ( uint32_t ) ucCode * 100UL;
+			}
+
+			iptraceIGMP_QUERY_RECEIVED( ulGroupAddress, xVersion );
+
+			if( xVersion < 3 )
+			{
+				/* An older router is present: use its version of the protocol
+				for a while. */
+				if( xVersion < prvIGMPVersion() )
+				{
+					pxIPStack->xIGMPVersion = xVersion;
+				}
+				pxIPStack->xOlderQuerierTime = xTaskGetTickCount();
+			}
+
+			if( ( ulGroupAddress == 0UL ) || ( xIsIPv4Multicast( ulGroupAddress ) != pdFALSE ) )
+			{
+				/* A general query, or a query for a single group.  Source
+				specific queries are treated as group queries, all groups are
+				joined for any source. */
+				prvHandleQuery( ulGroupAddress, pdMS_TO_TICKS( ulMaxResponse ) );
+			}
+		}
+		else if( ( ( pucIGMPMessage[ 0 ] == igmpTYPE_V1_MEMBERSHIP_REPORT ) ||
+				   ( pucIGMPMessage[ 0 ] == igmpTYPE_V2_MEMBERSHIP_REPORT ) ) &&
+				 ( prvIGMPVersion() < 3 ) )
+		{
+			/* Another member has answered a v1/v2 query, there is no need to
+			answer it as well. */
+			xIndex = prvFindGroup( ulGroupAddress );
+
+			if( xIndex >= 0 )
+			{
+				vTaskSuspendAll();
+				{
+					if( pxIPStack->xIGMPGroups[ xIndex ].ucRecordType == igmpRECORD_MODE_IS_EXCLUDE )
+					{
+						pxIPStack->xIGMPGroups[ xIndex ].ucReportCount = 0U;
+					}
+				}
+				( void ) xTaskResumeAll();
+			}
+		}
+		else
+		{
+			/* Reports of other versions, and leave messages, are meant for
+			routers. */
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvBuildMessage( uint8_t *pucMessage, BaseType_t xVersion, uint32_t ulRandom, uint32_t *pulDestination )
+{
+BaseType_t xIndex;
+IGMPGroup_t *pxGroup;
+TickType_t xNow = xTaskGetTickCount();
+size_t uxLength = 0U;
+uint16_t usRecordCount = 0U;
+uint8_t *pucRecord;
+
+	for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIGMP_MAX_GROUPS; xIndex++ )
+	{
+		pxGroup = &( pxIPStack->xIGMPGroups[ xIndex ] );
+
+		if( ( pxGroup->ucReportCount == 0U ) || ( ( xNow - pxGroup->xReportTime ) < pxGroup->xReportDelay ) )
+		{
+			/* Nothing to send for this group, or not yet. */
+			continue;
+		}
+
+		if( xVersion == 3 )
+		{
+			/* All groups that are due go into a single report, with a group
+			record for each of them. */
+			pucRecord = &( pucMessage[ ipSIZE_OF_IGMP_HEADER + ( ( size_t ) usRecordCount * igmpV3_RECORD_LENGTH ) ] );
+			pucRecord[ 0 ] = pxGroup->ucRecordType;
+			pucRecord[ 1 ] = 0U;	/* Aux Data Len. */
+			pucRecord[ 2 ] = 0U;	/* Number of Sources. */
+			pucRecord[ 3 ] = 0U;
+			( void ) memcpy( &( pucRecord[ 4 ] ), &( pxGroup->ulGroupAddress ), sizeof( pxGroup->ulGroupAddress ) );
+			usRecordCount++;
+		}
+		else if( uxLength == 0U )
+		{
+			/* A v1/v2 message is about a single group. */
+			if( pxGroup->ucRecordType != igmpRECORD_CHANGE_TO_INCLUDE )
+			{
+				pucMessage[ 0 ] = ( xVersion == 2 ) ? igmpTYPE_V2_MEMBERSHIP_REPORT : igmpTYPE_V1_MEMBERSHIP_REPORT;
+				*pulDestination = pxGroup->ulGroupAddress;
+				uxLength = ipSIZE_OF_IGMP_HEADER;
+			}
+			else if( xVersion == 2 )
+			{
+				pucMessage[ 0 ] = igmpTYPE_V2_LEAVE_GROUP;
+				*pulDestination = igmpALL_ROUTERS_ADDRESS;
+				uxLength = ipSIZE_OF_IGMP_HEADER;
+			}
+			else
+			{
+				/* IGMPv1 does not have leave messages. */
+				pxGroup->ucReportCount = 1U;
+			}
+
+			if( uxLength != 0U )
+			{
+				pucMessage[ 1 ] = 0U;	/* Max Resp Time. */
+				( void ) memcpy( &( pucMessage[ 4 ] ), &( pxGroup->ulGroupAddress ), sizeof( pxGroup->ulGroupAddress ) );
+			}
+		}
+		else
+		{
+			/* This group will get its own message. */
+			continue;
+		}
+
+		/* One more message for this group has been sent. */
+		pxGroup->ucReportCount--;
+
+		if( pxGroup->ucReportCount != 0U )
+		{
+			/* Repeat it at a random moment within the next interval. */
+			pxGroup->xReportTime = xNow;
+			pxGroup->xReportDelay = ( TickType_t ) ( ulRandom % ( uint32_t ) pdMS_TO_TICKS( igmpUNSOLICITED_REPORT_INTERVAL_MS ) ) + 1U;
+		}
+		else if( pxGroup->uxReferenceCount == 0U )
+		{
+			/* The group has been left. */
+			( void ) memset( pxGroup, 0, sizeof( *pxGroup ) );
+		}
+		else
+		{
+			/* Nothing else to send. */
+		}
+	}
+
+	if( usRecordCount != 0U )
+	{
+		pucMessage[ 0 ] = igmpTYPE_V3_MEMBERSHIP_REPORT;
+		pucMessage[ 1 ] = 0U;
+		pucMessage[ 4 ] = 0U;
+		pucMessage[ 5 ] = 0U;
+		pucMessage[ 6 ] = ( uint8_t ) ( usRecordCount >> 8 );
+		pucMessage[ 7 ] = ( uint8_t ) ( usRecordCount & 0xffU );
+		*pulDestination = igmpV3_REPORT_ADDRESS;
+		uxLength = ipSIZE_OF_IGMP_HEADER + ( ( size_t ) usRecordCount * igmpV3_RECORD_LENGTH );
+	}
+
+	if( uxLength != 0U )
+	{
+		iptraceIGMP_REPORT_SENT( xVersion, ( ( xVersion == 3 ) ? ( UBaseType_t ) usRecordCount : 1U ) );
+	}
+
+	return uxLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendMessage( NetworkBufferDescriptor_t *pxNetworkBuffer, size_t uxLength, uint32_t ulDestination )
+{
+EthernetHeader_t *pxEthernetHeader;
+IPHeader_t *pxIPHeader;
+uint8_t *pucOptions;
+uint8_t *pucMessage;
+uint16_t usChecksum;
+
+	pucMessage = &( pxNetworkBuffer->pucEthernetBuffer[ igmpMESSAGE_OFFSET ] );
+	pucMessage[ 2 ] = 0U;
+	pucMessage[ 3 ] = 0U;
+	usChecksum = ( uint16_t ) ~usGenerateChecksum( 0U, pucMessage, uxLength );
+	/* usGenerateChecksum() returns the sum in host byte order. */
+	pucMessage[ 2 ] = ( uint8_t ) ( usChecksum >> 8 );
+	pucMessage[ 3 ] = ( uint8_t ) ( usChecksum & 0xffU );
+
+	/* The Router Alert option asks routers to look at the message, even
+	though it is not addressed to them. */
+	pucOptions = &( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER ] );
+	pucOptions[ 0 ] = 0x94U;
+	pucOptions[ 1 ] = 0x04U;
+	pucOptions[ 2 ] = 0x00U;
+	pucOptions[ 3 ] = 0x00U;
+
+	pxIPHeader = ipPOINTER_CAST( IPHeader_t *, &( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER ] ) );
+	pxIPHeader->ucVersionHeaderLength = ( uint8_t ) ( 0x40U | ( igmpIP_HEADER_LENGTH >> 2 ) );
+	pxIPHeader->ucDifferentiatedServicesCode = igmpTOS_INTERNETWORK_CONTROL;
+	pxIPHeader->usLength = FreeRTOS_htons( ( uint16_t ) ( igmpIP_HEADER_LENGTH + uxLength ) );
+	pxIPHeader->usIdentification = FreeRTOS_htons( pxIPStack->usPacketIdentifier );
+	pxIPStack->usPacketIdentifier++;
+	pxIPHeader->usFragmentOffset = 0U;
+	pxIPHeader->ucTimeToLive = 1U;
+	pxIPHeader->ucProtocol = ( uint8_t ) ipPROTOCOL_IGMP;
+	pxIPHeader->ulSourceIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+	pxIPHeader->ulDestinationIPAddress = ulDestination;
+	pxIPHeader->usHeaderChecksum = 0U;
+	pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), igmpIP_HEADER_LENGTH );
+	pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+
+	pxEthernetHeader = ipPOINTER_CAST( EthernetHeader_t *, pxNetworkBuffer->pucEthernetBuffer );
+	vSetMultiCastIPv4MacAddress( ulDestination, &( pxEthernetHeader->xDestinationAddress ) );
+	( void ) memcpy( pxEthernetHeader->xSourceAddress.ucBytes, ipLOCAL_MAC_ADDRESS, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
+	pxEthernetHeader->usFrameType = ipIPv4_FRAME_TYPE;
+
+	pxNetworkBuffer->xDataLength = igmpMESSAGE_OFFSET + uxLength;
+
+	#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+	{
+		if( pxNetworkBuffer->xDataLength < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+		{
+			( void ) memset( &( pxNetworkBuffer->pucEthernetBuffer[ pxNetworkBuffer->xDataLength ] ), 0, ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES - pxNetworkBuffer->xDataLength );
+			pxNetworkBuffer->xDataLength = ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES;
+		}
+	}
+	#endif
+
+	( void ) ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xIGMPProcessTimers( void )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+TickType_t xNextTime = portMAX_DELAY;
+TickType_t xNow, xElapsed;
+BaseType_t xIndex;
+BaseType_t xVersion;
+BaseType_t xFilterChanged;
+size_t uxLength, uxRequestedSize;
+uint32_t ulRandom, ulDestination = 0UL;
+
+	vTaskSuspendAll();
+	{
+		xFilterChanged = pxIPStack->xIGMPFilterChanged;
+		pxIPStack->xIGMPFilterChanged = pdFALSE;
+	}
+	( void ) xTaskResumeAll();
+
+	#if( ipconfigIGMP_DRIVER_MULTICAST_FILTER != 0 )
+	{
+		if( xFilterChanged != pdFALSE )
+		{
+			/* Let the driver pass the frames of the groups that are joined,
+			and drop other multicast frames. */
+			vNetworkInterfaceUpdateMulticastFilter();
+		}
+	}
+	#else
+	{
+		( void ) xFilterChanged;
+	}
+	#endif /* ipconfigIGMP_DRIVER_MULTICAST_FILTER */
+
+	if( FreeRTOS_IsNetworkUp() != pdFALSE )
+	{
+		xVersion = prvIGMPVersion();
+
+		if( xApplicationGetRandomNumber( &( ulRandom ) ) == pdFALSE )
+		{
+			ulRandom = 0UL;
+		}
+
+		uxRequestedSize = igmpMESSAGE_OFFSET + igmpMAX_MESSAGE_LENGTH;
+		#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+		{
+			if( uxRequestedSize < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+			{
+				uxRequestedSize = ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES;
+			}
+		}
+		#endif
+
+		/* Send one message at a time, until nothing is due any more. */
+		for( ;; )
+		{
+			pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( uxRequestedSize, ( TickType_t ) 0U );
+
+			if( pxNetworkBuffer == NULL )
+			{
+				xNextTime = pdMS_TO_TICKS( igmpRETRY_DELAY_MS );
+				break;
+			}
+
+			vTaskSuspendAll();
+			{
+				uxLength = prvBuildMessage( &( pxNetworkBuffer->pucEthernetBuffer[ igmpMESSAGE_OFFSET ] ), xVersion, ulRandom, &( ulDestination ) );
+			}
+			( void ) xTaskResumeAll();
+
+			if( uxLength == 0U )
+			{
+				vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+				break;
+			}
+
+			prvSendMessage( pxNetworkBuffer, uxLength, ulDestination );
+		}
+
+		if( xNextTime == portMAX_DELAY )
+		{
+			/* Find the message that is due first. */
+			xNow = xTaskGetTickCount();
+
+			vTaskSuspendAll();
+			{
+				for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIGMP_MAX_GROUPS; xIndex++ )
+				{
+					if( pxIPStack->xIGMPGroups[ xIndex ].ucReportCount != 0U )
+					{
+						xElapsed = xNow - pxIPStack->xIGMPGroups[ xIndex ].xReportTime;
+
+						if( xElapsed >= pxIPStack->xIGMPGroups[ xIndex ].xReportDelay )
+						{
+							xNextTime = 0U;
+						}
+						else if( ( pxIPStack->xIGMPGroups[ xIndex ].xReportDelay - xElapsed ) < xNextTime )
+						{
+							xNextTime = pxIPStack->xIGMPGroups[ xIndex ].xReportDelay - xElapsed;
+						}
+						else
+						{
+							/* A message is due earlier. */
+						}
+					}
+				}
+			}
+			( void ) xTaskResumeAll();
+		}
+	}
+
+	return xNextTime;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIGMPIsGroupMember( uint32_t ulIPAddress )
+{
+BaseType_t xReturn = pdFALSE;
+BaseType_t xIndex;
+
+	if( ulIPAddress == igmpALL_SYSTEMS_ADDRESS )
+	{
+		xReturn = pdTRUE;
+	}
+	else
+	{
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIGMP_MAX_GROUPS; xIndex++ )
+		{
+			if( ( pxIPStack->xIGMPGroups[ xIndex ].ulGroupAddress == ulIPAddress ) && ( pxIPStack->xIGMPGroups[ xIndex ].uxReferenceCount != 0U ) )
+			{
+				xReturn = pdTRUE;
+				break;
+			}
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIGMPIsGroupMACAddress( const MACAddress_t *pxMACAddress )
+{
+BaseType_t xReturn = pdFALSE;
+BaseType_t xIndex;
+uint32_t ulLowBits;
+
+	/* Multicast MAC addresses are 01:00:5e followed by 23 bits of the group
+	address. */
+	if( ( pxMACAddress->ucBytes[ 0 ] == 0x01U ) &&
+		( pxMACAddress->ucBytes[ 1 ] == 0x00U ) &&
+		( pxMACAddress->ucBytes[ 2 ] == 0x5EU ) &&
+		( ( pxMACAddress->ucBytes[ 3 ] & 0x80U ) == 0U ) )
+	{
+		ulLowBits = ( ( ( uint32_t ) pxMACAddress->ucBytes[ 3 ] ) << 16 ) |
+					( ( ( uint32_t ) pxMACAddress->ucBytes[ 4 ] ) << 8 ) |
+					( ( uint32_t ) pxMACAddress->ucBytes[ 5 ] );
+
+		if( ulLowBits == ( FreeRTOS_ntohl( igmpALL_SYSTEMS_ADDRESS ) & igmpMAC_ADDRESS_MASK ) )
+		{
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIGMP_MAX_GROUPS; xIndex++ )
+			{
+				if( ( pxIPStack->xIGMPGroups[ xIndex ].uxReferenceCount != 0U ) &&
+					( ( FreeRTOS_ntohl( pxIPStack->xIGMPGroups[ xIndex ].ulGroupAddress ) & igmpMAC_ADDRESS_MASK ) == ulLowBits ) )
+				{
+					xReturn = pdTRUE;
+					break;
+				}
+			}
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxIGMPGetGroupMACAddresses( MACAddress_t *pxMACAddresses, UBaseType_t uxMaxCount )
+{
+UBaseType_t uxCount = 0U;
+BaseType_t xIndex;
+
+	if( uxMaxCount > 0U )
+	{
+		vSetMultiCastIPv4MacAddress( igmpALL_SYSTEMS_ADDRESS, &( pxMACAddresses[ 0 ] ) );
+		uxCount++;
+	}
+
+	for( xIndex = 0; ( xIndex < ( BaseType_t ) ipconfigIGMP_MAX_GROUPS ) && ( uxCount < uxMaxCount ); xIndex++ )
+	{
+		if( pxIPStack->xIGMPGroups[ xIndex ].uxReferenceCount != 0U )
+		{
+			vSetMultiCastIPv4MacAddress( pxIPStack->xIGMPGroups[ xIndex ].ulGroupAddress, &( pxMACAddresses[ uxCount ] ) );
+			uxCount++;
+		}
+	}
+
+	return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_IGMP != 0 */
@@ -44,6 +44,8 @@
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
 #include "FreeRTOS_DNS.h"
+#include "FreeRTOS_IGMP.h"
+#include "FreeRTOS_IP_Stack.h"
 
 
 /* Used to ensure the structure packing is having the desired effect.  The
@@ -67,6 +69,15 @@ a constant. */
 #define	ipFIRST_MULTI_CAST_IPv4		0xE0000000UL
 #define	ipLAST_MULTI_CAST_IPv4		0xF0000000UL
 
+/* The IPv4 loop-back network 127.0.0.0/8. */
+#define	ipLOOPBACK_NETWORK_IPv4		0x7F000000UL
+#define	ipLOOPBACK_NETMASK_IPv4		0xFF000000UL
+
+#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+	/* DHCP replies are sent to this UDP port, they are treated as control events. */
+	#define ipDHCP_CLIENT_PORT				( ( uint16_t ) 68U )
+#endif
+
 /* The first byte in the IPv4 header combines the IP version (4) with
 with the length of the IP header. */
 #define	ipIPV4_VERSION_HEADER_LENGTH_MIN	0x45U
@@ -120,6 +131,28 @@ needs to call eConsiderFrameForProcessing. */
 	#endif /* ipconfigBYTE_ORDER */
 #endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
 
+#if( ipconfigIP_REASSEMBLY_SLOTS > 0 )
+	#if( ipconfigIP_REASSEMBLY_MAX_SIZE > 65535U )
+		#error ipconfigIP_REASSEMBLY_MAX_SIZE can not be larger than an IP datagram.
+	#endif
+
+	/* The flag and the offset bits of the fragmentation field, in host order. */
+	#define ipFRAGMENT_FLAG_MORE_FRAGMENTS			( ( uint16_t ) 0x2000U )
+	#define ipFRAGMENT_OFFSET_UNITS					( ( uint16_t ) 0x1FFFU )
+
+	/* The timer that discards incomplete datagrams runs at a quarter of the
+	timeout. */
+	#define ipREASSEMBLY_TIMER_PERIOD_MS	( ( ipconfigIP_REASSEMBLY_TIMEOUT_MS + 3U ) / 4U )
+#endif /* ipconfigIP_REASSEMBLY_SLOTS */
+
+/* The largest IP packet that passes the length checks: a reassembled datagram
+may be longer than the MTU. */
+#if( ipconfigIP_REASSEMBLY_SLOTS > 0 ) && ( ipconfigIP_REASSEMBLY_MAX_SIZE > ipconfigNETWORK_MTU )
+	#define ipMAX_IP_PACKET_LENGTH			ipconfigIP_REASSEMBLY_MAX_SIZE
+#else
+	#define ipMAX_IP_PACKET_LENGTH			ipconfigNETWORK_MTU
+#endif
+
 /* The maximum time the IP task is allowed to remain in the Blocked state if no
 events are posted to the network event queue. */
 #ifndef	ipconfigMAX_IP_TASK_SLEEP_TIME
@@ -167,6 +200,16 @@ typedef union _xUnionPtr
  */
 static void prvIPTask( void *pvParameters );
 
+/*
+ * Create the event queues and the IP-task of a stack.
+ */
+static BaseType_t prvIPInitStack( IPStack_t *pxStack,
+								  const uint8_t ucIPAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+								  const uint8_t ucNetMask[ ipIP_ADDRESS_LENGTH_BYTES ],
+								  const uint8_t ucGatewayAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+								  const uint8_t ucDNSServerAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+								  const uint8_t ucMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ] );
+
 /*
  * Called when new data is available from the network interface.
  */
@@ -241,76 +284,79 @@ static eFrameProcessingResult_t prvAllowIPPacket( const IPPacket_t * const pxIPP
 	static BaseType_t xCheckSizeFields( const uint8_t * const pucEthernetBuffer, size_t uxBufferLength );
 #endif	/* ( ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM == 1 ) */
 
-/*-----------------------------------------------------------*/
+#if( ipconfigIP_REASSEMBLY_SLOTS > 0 )
+	/*
+	 * Returns pdTRUE if the IP packet is a fragment of a larger datagram.
+	 */
+	static BaseType_t prvIPIsFragment( const IPHeader_t * const pxIPHeader );
 
-/* The queue used to pass events into the IP-task for processing. */
-QueueHandle_t xNetworkEventQueue = NULL;
+	/*
+	 * Copies a fragment to the slot of its datagram.  When the datagram is
+	 * complete, it is passed to prvProcessEthernetPacket().
+	 */
+	static void prvIPReassemble( const NetworkBufferDescriptor_t * const pxFragment );
 
-/*_RB_ Requires comment. */
-uint16_t usPacketIdentifier = 0U;
+	/*
+	 * Releases the network buffer of a slot, after which the slot is free.
+	 */
+	static void prvIPReassemblyRelease( IPReassemblySlot_t *pxSlot );
 
-/* For convenience, a MAC address of all 0xffs is defined const for quick
-reference. */
-const MACAddress_t xBroadcastMACAddress = { { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff } };
+	/*
+	 * Called periodically to discard the datagrams that did not complete within
+	 * ipconfigIP_REASSEMBLY_TIMEOUT_MS.
+	 */
+	static void prvIPReassemblyCheckTimeouts( void );
+#endif /* ipconfigIP_REASSEMBLY_SLOTS */
 
-/* Structure that stores the netmask, gateway address and DNS server addresses. */
-NetworkAddressingParameters_t xNetworkAddressing = { 0, 0, 0, 0, 0 };
-
-/* Default values for the above struct in case DHCP
-does not lead to a confirmed request. */
-/* coverity[misra_c_2012_rule_8_9_violation] */
-/* "xDefaultAddressing" should be defined at block scope. */
-NetworkAddressingParameters_t xDefaultAddressing = { 0, 0, 0, 0, 0 };
-
-/* Used to ensure network down events cannot be missed when they cannot be
-posted to the network event queue because the network event queue is already
-full. */
-static volatile BaseType_t xNetworkDownEventPending = pdFALSE;
-
-/* Stores the handle of the task that handles the stack.  The handle is used
-(indirectly) by some utility function to determine if the utility function is
-being called by a task (in which case it is ok to block) or by the IP task
-itself (in which case it is not ok to block). */
-static TaskHandle_t xIPTaskHandle = NULL;
-
-#if( ipconfigUSE_TCP != 0 )
-	/* Set to a non-zero value if one or more TCP message have been processed
-	within the last round. */
-	static BaseType_t xProcessedTCPMessage;
-#endif
+#if( ipconfigUSE_LOOPBACK != 0 )
+	/*
+	 * Handle the packets that this host has sent to itself.
+	 */
+	static void prvProcessLoopbackPackets( void );
+#endif /* ipconfigUSE_LOOPBACK */
+
+#if( ipconfigUSE_ROUTING != 0 )
+	/*
+	 * Handle the packets that were received by the added interfaces, and pass
+	 * their queued packets to the drivers.
+	 */
+	static void prvProcessInterfacePackets( void );
+#endif /* ipconfigUSE_ROUTING */
+
+#if( ipconfigUSE_IGMP != 0 )
+	/*
+	 * Send the IGMP messages that are due, and restart the IGMP timer for the
+	 * next one.
+	 */
+	static void prvIGMPProcess( void );
+#endif /* ipconfigUSE_IGMP */
 
-/* Simple set to pdTRUE or pdFALSE depending on whether the network is up or
-down (connected, not connected) respectively. */
-static BaseType_t xNetworkUp = pdFALSE;
+#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+	/*
+	 * Returns the class of an event: eIPEventClassControl or eIPEventClassData.
+	 */
+	static eIPEventClass_t prvGetEventClass( const IPStackEvent_t *pxEvent );
+
+	/*
+	 * Record the number of events waiting in a queue, after an event was added.
+	 */
+	static void prvUpdateQueueHighWater( eIPEventClass_t eClass );
+#endif
 
 /*
-A timer for each of the following processes, all of which need attention on a
-regular basis:
-	1. ARP, to check its table entries
-	2. DPHC, to send requests and to renew a reservation
-	3. TCP, to check for timeouts, resends
-	4. DNS, to check for timeouts when looking-up a domain.
+ * Wait for the next event to handle.  With ipconfigUSE_PRIORITY_EVENT_QUEUES,
+ * events from the control queue are taken first.
  */
-static IPTimer_t xARPTimer;
-#if( ipconfigUSE_DHCP != 0 )
-	static IPTimer_t xDHCPTimer;
-#endif
-#if( ipconfigUSE_TCP != 0 )
-	static IPTimer_t xTCPTimer;
-#endif
-#if( ipconfigDNS_USE_CALLBACKS != 0 )
-	static IPTimer_t xDNSTimer;
-#endif
+static BaseType_t prvReceiveEvent( IPStackEvent_t *pxEvent, TickType_t xTicksToWait );
+
+/*-----------------------------------------------------------*/
 
-/* Set to pdTRUE when the IP task is ready to start processing packets. */
-/* coverity[misra_c_2012_rule_8_9_violation] */
-/* "xIPTaskInitialised" should be defined at block scope. */
-static BaseType_t xIPTaskInitialised = pdFALSE;
+/* The state of each instance of the IP-stack. */
+IPStack_t xIPStacks[ ipconfigIP_STACK_COUNT ];
 
-#if( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
-	/* Keep track of the lowest amount of space in 'xNetworkEventQueue'. */
-	static UBaseType_t uxQueueMinimumSpace = ipconfigEVENT_QUEUE_LENGTH;
-#endif
+/* For convenience, a MAC address of all 0xffs is defined const for quick
+reference. */
+const MACAddress_t xBroadcastMACAddress = { { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff } };
 
 /*-----------------------------------------------------------*/
 
@@ -323,8 +369,18 @@ TickType_t xNextIPSleep;
 FreeRTOS_Socket_t *pxSocket;
 struct freertos_sockaddr xAddress;
 
-	/* Just to prevent compiler warnings about unused parameters. */
-	( void ) pvParameters;
+	#if( ipconfigIP_STACK_COUNT > 1 )
+	{
+		/* pvParameters points to the stack of this task.  Store it before
+		anything else is done, all functions find it through 'pxIPStack'. */
+		vTaskSetThreadLocalStoragePointer( NULL, ipconfigIP_STACK_TLS_INDEX, pvParameters );
+	}
+	#else
+	{
+		/* Just to prevent compiler warnings about unused parameters. */
+		( void ) pvParameters;
+	}
+	#endif
 
 	/* A possibility to set some additional task properties. */
 	iptraceIP_TASK_STARTING();
@@ -338,12 +394,39 @@ struct freertos_sockaddr xAddress;
 	#if( ipconfigUSE_TCP == 1 )
 	{
 		/* Initialise the TCP timer. */
-		prvIPTimerReload( &xTCPTimer, pdMS_TO_TICKS( ipTCP_TIMER_PERIOD_MS ) );
+		prvIPTimerReload( &pxIPStack->xTCPTimer, pdMS_TO_TICKS( ipTCP_TIMER_PERIOD_MS ) );
+	}
+	#endif
+
+	#if( ipconfigUSE_LOOPBACK != 0 )
+	{
+		vListInitialise( &pxIPStack->xLoopbackList );
+	}
+	#endif
+
+	#if( ipconfigUSE_TX_SCHEDULER != 0 )
+	{
+		vTxSchedulerInit();
+	}
+	#endif
+
+	#if( ipconfigUSE_IGMP != 0 )
+	{
+		/* Join the multicast groups that the stack uses itself. */
+		vIGMPInitialise();
+	}
+	#endif
+
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+		/* Bring up the interfaces that were added before the IP-task
+		started. */
+		vRoutingInitialiseInterfaces();
 	}
 	#endif
 
 	/* Initialisation is complete and events can now be processed. */
-	xIPTaskInitialised = pdTRUE;
+	pxIPStack->xIPTaskInitialised = pdTRUE;
 
 	FreeRTOS_debug_printf( ( "prvIPTask started\n" ) );
 
@@ -352,6 +435,30 @@ struct freertos_sockaddr xAddress;
 	{
 		ipconfigWATCHDOG_TIMER();
 
+		#if( ipconfigUSE_LOOPBACK != 0 )
+		{
+			/* Handle the packets that were sent to this host while handling
+			the previous event. */
+			prvProcessLoopbackPackets();
+		}
+		#endif
+
+		#if( ipconfigUSE_ROUTING != 0 )
+		{
+			/* Handle the packets of the added interfaces, at most a burst of
+			each queue. */
+			prvProcessInterfacePackets();
+		}
+		#endif
+
+		#if( ipconfigUSE_TX_SCHEDULER != 0 )
+		{
+			/* Pass the packets that were queued while handling the previous
+			events to the driver, in the order chosen by the scheduler. */
+			vTxSchedulerProcess();
+		}
+		#endif
+
 		/* Check the ARP, DHCP and TCP timers to see if there is any periodic
 		or timeout processing to perform. */
 		prvCheckNetworkTimers();
@@ -362,7 +469,7 @@ struct freertos_sockaddr xAddress;
 		/* Wait until there is something to do. If the following call exits
 		 * due to a time out rather than a message being received, set a
 		 * 'NoEvent' value. */
-		if ( xQueueReceive( xNetworkEventQueue, ipPOINTER_CAST( void *, &xReceivedEvent ), xNextIPSleep ) == pdFALSE ) 
+		if( prvReceiveEvent( &xReceivedEvent, xNextIPSleep ) == pdFALSE )
 		{
 			xReceivedEvent.eEventType = eNoEvent;
 		}
@@ -373,10 +480,10 @@ struct freertos_sockaddr xAddress;
 			{
 			UBaseType_t uxCount;
 
-				uxCount = uxQueueSpacesAvailable( xNetworkEventQueue );
-				if( uxQueueMinimumSpace > uxCount )
+				uxCount = uxQueueSpacesAvailable( pxIPStack->xNetworkEventQueue );
+				if( pxIPStack->uxQueueMinimumSpace > uxCount )
 				{
-					uxQueueMinimumSpace = uxCount;
+					pxIPStack->uxQueueMinimumSpace = uxCount;
 				}
 			}
 		}
@@ -388,7 +495,7 @@ struct freertos_sockaddr xAddress;
 		{
 			case eNetworkDownEvent :
 				/* Attempt to establish a connection. */
-				xNetworkUp = pdFALSE;
+				pxIPStack->xNetworkUp = pdFALSE;
 				prvProcessNetworkDownEvent();
 				break;
 
@@ -402,12 +509,19 @@ struct freertos_sockaddr xAddress;
 			case eNetworkTxEvent:
 				/* Send a network packet. The ownership will  be transferred to
 				the driver, which will release it after delivery. */
-				( void ) xNetworkInterfaceOutput( ipPOINTER_CAST( NetworkBufferDescriptor_t *, xReceivedEvent.pvData ), pdTRUE );
+				( void ) ipNETWORK_INTERFACE_OUTPUT( ipPOINTER_CAST( NetworkBufferDescriptor_t *, xReceivedEvent.pvData ), pdTRUE );
 				break;
 
 			case eARPTimerEvent :
 				/* The ARP timer has expired, process the ARP cache. */
 				vARPAgeCache();
+
+				#if( ipconfigUSE_ROUTING != 0 )
+				{
+					/* Retry the interfaces that could not be initialised. */
+					vRoutingInitialiseInterfaces();
+				}
+				#endif /* ipconfigUSE_ROUTING */
 				break;
 
 			case eSocketBindEvent:
@@ -490,7 +604,7 @@ struct freertos_sockaddr xAddress;
 				{
 					/* Simply mark the TCP timer as expired so it gets processed
 					the next time prvCheckNetworkTimers() is called. */
-					xTCPTimer.bExpired = pdTRUE_UNSIGNED;
+					pxIPStack->xTCPTimer.bExpired = pdTRUE_UNSIGNED;
 				}
 				#endif /* ipconfigUSE_TCP */
 				break;
@@ -522,6 +636,27 @@ struct freertos_sockaddr xAddress;
 				#endif /* ipconfigUSE_TCP */
 				break;
 
+			case eIGMPEvent:
+				/* A multicast group was joined or left, send the reports and
+				update the driver's filter. */
+				#if( ipconfigUSE_IGMP != 0 )
+				{
+					prvIGMPProcess();
+				}
+				#endif /* ipconfigUSE_IGMP */
+				break;
+
+			case eInterfaceEvent:
+				/* An interface was added, or an added interface has queued
+				packets.  The packets are handled by prvProcessInterfacePackets()
+				at the top of this loop. */
+				#if( ipconfigUSE_ROUTING != 0 )
+				{
+					vRoutingInitialiseInterfaces();
+				}
+				#endif /* ipconfigUSE_ROUTING */
+				break;
+
 			case eNoEvent:
 				/* xQueueReceive() returned because of a normal time-out. */
 				break;
@@ -531,7 +666,7 @@ struct freertos_sockaddr xAddress;
 				break;
 		}
 
-		if( xNetworkDownEventPending != pdFALSE )
+		if( pxIPStack->xNetworkDownEventPending != pdFALSE )
 		{
 			/* A network down event could not be posted to the network event
 			queue because the queue was full.
@@ -547,7 +682,7 @@ BaseType_t xIsCallingFromIPTask( void )
 {
 BaseType_t xReturn;
 
-	if( xTaskGetCurrentTaskHandle() == xIPTaskHandle )
+	if( xTaskGetCurrentTaskHandle() == pxIPStack->xIPTaskHandle )
 	{
 		xReturn = pdTRUE;
 	}
@@ -605,21 +740,21 @@ TickType_t xMaximumSleepTime;
 	time in any other timers that are active. */
 	xMaximumSleepTime = ipconfigMAX_IP_TASK_SLEEP_TIME;
 
-	if( xARPTimer.bActive != pdFALSE_UNSIGNED )
+	if( pxIPStack->xARPTimer.bActive != pdFALSE_UNSIGNED )
 	{
-		if( xARPTimer.ulRemainingTime < xMaximumSleepTime )
+		if( pxIPStack->xARPTimer.ulRemainingTime < xMaximumSleepTime )
 		{
-			xMaximumSleepTime = xARPTimer.ulReloadTime;
+			xMaximumSleepTime = pxIPStack->xARPTimer.ulReloadTime;
 		}
 	}
 
 	#if( ipconfigUSE_DHCP == 1 )
 	{
-		if( xDHCPTimer.bActive != pdFALSE_UNSIGNED )
+		if( pxIPStack->xDHCPTimer.bActive != pdFALSE_UNSIGNED )
 		{
-			if( xDHCPTimer.ulRemainingTime < xMaximumSleepTime )
+			if( pxIPStack->xDHCPTimer.ulRemainingTime < xMaximumSleepTime )
 			{
-				xMaximumSleepTime = xDHCPTimer.ulRemainingTime;
+				xMaximumSleepTime = pxIPStack->xDHCPTimer.ulRemainingTime;
 			}
 		}
 	}
@@ -627,25 +762,79 @@ TickType_t xMaximumSleepTime;
 
 	#if( ipconfigUSE_TCP == 1 )
 	{
-		if( xTCPTimer.ulRemainingTime < xMaximumSleepTime )
+		if( pxIPStack->xTCPTimer.ulRemainingTime < xMaximumSleepTime )
 		{
-			xMaximumSleepTime = xTCPTimer.ulRemainingTime;
+			xMaximumSleepTime = pxIPStack->xTCPTimer.ulRemainingTime;
 		}
 	}
 	#endif
 
 	#if( ipconfigDNS_USE_CALLBACKS != 0 )
 	{
-		if( xDNSTimer.bActive != pdFALSE_UNSIGNED )
+		if( pxIPStack->xDNSTimer.bActive != pdFALSE_UNSIGNED )
 		{
-			if( xDNSTimer.ulRemainingTime < xMaximumSleepTime )
+			if( pxIPStack->xDNSTimer.ulRemainingTime < xMaximumSleepTime )
 			{
-				xMaximumSleepTime = xDNSTimer.ulRemainingTime;
+				xMaximumSleepTime = pxIPStack->xDNSTimer.ulRemainingTime;
 			}
 		}
 	}
 	#endif
 
+	#if( ipconfigIP_REASSEMBLY_SLOTS > 0 )
+	{
+		if( pxIPStack->xReassemblyTimer.bActive != pdFALSE_UNSIGNED )
+		{
+			if( pxIPStack->xReassemblyTimer.ulRemainingTime < xMaximumSleepTime )
+			{
+				xMaximumSleepTime = pxIPStack->xReassemblyTimer.ulRemainingTime;
+			}
+		}
+	}
+	#endif
+
+	#if( ipconfigUSE_IGMP != 0 )
+	{
+		if( pxIPStack->xIGMPTimer.bActive != pdFALSE_UNSIGNED )
+		{
+			if( pxIPStack->xIGMPTimer.ulRemainingTime < xMaximumSleepTime )
+			{
+				xMaximumSleepTime = pxIPStack->xIGMPTimer.ulRemainingTime;
+			}
+		}
+	}
+	#endif
+
+	#if( ipconfigUSE_LOOPBACK != 0 )
+	{
+		/* Packets that were looped back must be handled without delay. */
+		if( listCURRENT_LIST_LENGTH( &pxIPStack->xLoopbackList ) != 0U )
+		{
+			xMaximumSleepTime = 0U;
+		}
+	}
+	#endif
+
+	#if( ipconfigUSE_TX_SCHEDULER != 0 )
+	{
+		/* Do not sleep while packets are waiting to be sent. */
+		if( xTxSchedulerPending() != pdFALSE )
+		{
+			xMaximumSleepTime = 0U;
+		}
+	}
+	#endif
+
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+		/* Nor while the queues of an interface hold packets. */
+		if( xRoutingPending() != pdFALSE )
+		{
+			xMaximumSleepTime = 0U;
+		}
+	}
+	#endif
+
 	return xMaximumSleepTime;
 }
 /*-----------------------------------------------------------*/
@@ -653,7 +842,7 @@ TickType_t xMaximumSleepTime;
 static void prvCheckNetworkTimers( void )
 {
 	/* Is it time for ARP processing? */
-	if( prvIPTimerCheck( &xARPTimer ) != pdFALSE )
+	if( prvIPTimerCheck( &pxIPStack->xARPTimer ) != pdFALSE )
 	{
 		( void ) xSendEventToIPTask( eARPTimerEvent );
 	}
@@ -661,7 +850,7 @@ static void prvCheckNetworkTimers( void )
 	#if( ipconfigUSE_DHCP == 1 )
 	{
 		/* Is it time for DHCP processing? */
-		if( prvIPTimerCheck( &xDHCPTimer ) != pdFALSE )
+		if( prvIPTimerCheck( &pxIPStack->xDHCPTimer ) != pdFALSE )
 		{
 			( void ) xSendEventToIPTask( eDHCPEvent );
 		}
@@ -671,13 +860,33 @@ static void prvCheckNetworkTimers( void )
 	#if( ipconfigDNS_USE_CALLBACKS != 0 )
 	{
 		/* Is it time for DNS processing? */
-		if( prvIPTimerCheck( &xDNSTimer ) != pdFALSE )
+		if( prvIPTimerCheck( &pxIPStack->xDNSTimer ) != pdFALSE )
 		{
 			vDNSCheckCallBack( NULL );
 		}
 	}
 	#endif /* ipconfigDNS_USE_CALLBACKS */
 
+	#if( ipconfigIP_REASSEMBLY_SLOTS > 0 )
+	{
+		/* Is it time to discard incomplete datagrams? */
+		if( prvIPTimerCheck( &pxIPStack->xReassemblyTimer ) != pdFALSE )
+		{
+			prvIPReassemblyCheckTimeouts();
+		}
+	}
+	#endif /* ipconfigIP_REASSEMBLY_SLOTS */
+
+	#if( ipconfigUSE_IGMP != 0 )
+	{
+		/* Is it time to send IGMP reports? */
+		if( prvIPTimerCheck( &pxIPStack->xIGMPTimer ) != pdFALSE )
+		{
+			prvIGMPProcess();
+		}
+	}
+	#endif /* ipconfigUSE_IGMP */
+
 	#if( ipconfigUSE_TCP == 1 )
 	{
 	BaseType_t xWillSleep;
@@ -686,7 +895,11 @@ static void prvCheckNetworkTimers( void )
 
 		/* If the IP task has messages waiting to be processed then
 		it will not sleep in any case. */
-		if( uxQueueMessagesWaiting( xNetworkEventQueue ) == 0U )
+		if( ( uxQueueMessagesWaiting( pxIPStack->xNetworkEventQueue ) == 0U )
+		#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+			&& ( uxQueueMessagesWaiting( pxIPStack->xNetworkControlQueue ) == 0U )
+		#endif
+		  )
 		{
 			xWillSleep = pdTRUE;
 		}
@@ -696,11 +909,11 @@ static void prvCheckNetworkTimers( void )
 		}
 
 		/* Sockets need to be checked if the TCP timer has expired. */
-		xCheckTCPSockets = prvIPTimerCheck( &xTCPTimer );
+		xCheckTCPSockets = prvIPTimerCheck( &pxIPStack->xTCPTimer );
 
 		/* Sockets will also be checked if there are TCP messages but the
 		message queue is empty (indicated by xWillSleep being true). */
-		if( ( xProcessedTCPMessage != pdFALSE ) && ( xWillSleep != pdFALSE ) )
+		if( ( pxIPStack->xProcessedTCPMessage != pdFALSE ) && ( xWillSleep != pdFALSE ) )
 		{
 			xCheckTCPSockets = pdTRUE;
 		}
@@ -710,14 +923,36 @@ static void prvCheckNetworkTimers( void )
 			/* Attend to the sockets, returning the period after which the
 			check must be repeated. */
 			xNextTime = xTCPTimerCheck( xWillSleep );
-			prvIPTimerStart( &xTCPTimer, xNextTime );
-			xProcessedTCPMessage = 0;
+			prvIPTimerStart( &pxIPStack->xTCPTimer, xNextTime );
+			pxIPStack->xProcessedTCPMessage = 0;
 		}
 	}
 	#endif /* ipconfigUSE_TCP == 1 */
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_IGMP != 0 )
+
+	static void prvIGMPProcess( void )
+	{
+	TickType_t xNextTime;
+
+		xNextTime = xIGMPProcessTimers();
+
+		if( xNextTime == portMAX_DELAY )
+		{
+			/* Nothing is pending. */
+			pxIPStack->xIGMPTimer.bActive = pdFALSE_UNSIGNED;
+		}
+		else
+		{
+			prvIPTimerReload( &pxIPStack->xIGMPTimer, xNextTime );
+		}
+	}
+
+#endif /* ipconfigUSE_IGMP */
+/*-----------------------------------------------------------*/
+
 static void prvIPTimerStart( IPTimer_t *pxTimer, TickType_t xTime )
 {
 	vTaskSetTimeOutState( &pxTimer->xTimeOut );
@@ -787,31 +1022,39 @@ const TickType_t xDontBlock = ( TickType_t ) 0;
 	if( xSendEventStructToIPTask( &xNetworkDownEvent, xDontBlock ) != pdPASS )
 	{
 		/* Could not send the message, so it is still pending. */
-		xNetworkDownEventPending = pdTRUE;
+		pxIPStack->xNetworkDownEventPending = pdTRUE;
 	}
 	else
 	{
 		/* Message was sent so it is not pending. */
-		xNetworkDownEventPending = pdFALSE;
+		pxIPStack->xNetworkDownEventPending = pdFALSE;
 	}
 
 	iptraceNETWORK_DOWN();
 }
 /*-----------------------------------------------------------*/
-/* Utility function. Process Network Down event from ISR. */
-BaseType_t FreeRTOS_NetworkDownFromISR( void )
+#if( ipconfigIP_STACK_COUNT == 1 )
+	/* Utility function. Process Network Down event from ISR. */
+	BaseType_t FreeRTOS_NetworkDownFromISR( void )
+	{
+		return FreeRTOS_NetworkDownStackFromISR( &( xIPStacks[ 0 ] ) );
+	}
+#endif /* ipconfigIP_STACK_COUNT == 1 */
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_NetworkDownStackFromISR( IPStack_t *pxStack )
 {
 static const IPStackEvent_t xNetworkDownEvent = { eNetworkDownEvent, NULL };
 BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
 	/* Simply send the network task the appropriate event. */
-	if( xQueueSendToBackFromISR( xNetworkEventQueue, &xNetworkDownEvent, &xHigherPriorityTaskWoken ) != pdPASS )
+	if( xSendEventStructToIPStackFromISR( pxStack, &xNetworkDownEvent, &xHigherPriorityTaskWoken ) != pdPASS )
 	{
-		xNetworkDownEventPending = pdTRUE;
+		pxStack->xNetworkDownEventPending = pdTRUE;
 	}
 	else
 	{
-		xNetworkDownEventPending = pdFALSE;
+		pxStack->xNetworkDownEventPending = pdFALSE;
 	}
 
 	iptraceNETWORK_DOWN();
@@ -873,6 +1116,13 @@ NetworkBufferDescriptor_t * pxNewBuffer;
 		pxNewBuffer->ulIPAddress = pxNetworkBuffer->ulIPAddress;
 		pxNewBuffer->usPort = pxNetworkBuffer->usPort;
 		pxNewBuffer->usBoundPort = pxNetworkBuffer->usBoundPort;
+		#if( ipconfigUSE_ROUTING != 0 )
+		{
+			pxNewBuffer->pxInterface = pxNetworkBuffer->pxInterface;
+			pxNewBuffer->pxEndPoint = pxNetworkBuffer->pxEndPoint;
+			pxNewBuffer->ulNextHop = pxNetworkBuffer->ulNextHop;
+		}
+		#endif /* ipconfigUSE_ROUTING */
 		( void ) memcpy( pxNewBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
 	}
 
@@ -967,13 +1217,118 @@ void FreeRTOS_ReleaseUDPPayloadBuffer( void const * pvBuffer )
  As that bug has been repaired, there is not an urgent reason to warn.
  It is better though to use the advised priority scheme. */
 BaseType_t FreeRTOS_IPInit( const uint8_t ucIPAddress[ ipIP_ADDRESS_LENGTH_BYTES ], const uint8_t ucNetMask[ ipIP_ADDRESS_LENGTH_BYTES ], const uint8_t ucGatewayAddress[ ipIP_ADDRESS_LENGTH_BYTES ], const uint8_t ucDNSServerAddress[ ipIP_ADDRESS_LENGTH_BYTES ], const uint8_t ucMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ] )
+{
+	#if( ipconfigIP_STACK_COUNT > 1 )
+	{
+		xIPStacks[ 0 ].pxInterfaceInitialise = xNetworkInterfaceInitialise;
+		xIPStacks[ 0 ].pxInterfaceOutput = xNetworkInterfaceOutput;
+	}
+	#endif
+
+	return prvIPInitStack( &( xIPStacks[ 0 ] ), ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigIP_STACK_COUNT > 1 )
+
+	BaseType_t FreeRTOS_IPInitStack( UBaseType_t uxStack,
+		const uint8_t ucIPAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+		const uint8_t ucNetMask[ ipIP_ADDRESS_LENGTH_BYTES ],
+		const uint8_t ucGatewayAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+		const uint8_t ucDNSServerAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+		const uint8_t ucMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ],
+		NetworkInterfaceInitialiseFunction_t pxInterfaceInitialise,
+		NetworkInterfaceOutputFunction_t pxInterfaceOutput )
+	{
+	BaseType_t xReturn = pdFALSE;
+
+		configASSERT( uxStack < ( UBaseType_t ) ipconfigIP_STACK_COUNT );
+		configASSERT( ( pxInterfaceInitialise != NULL ) && ( pxInterfaceOutput != NULL ) );
+
+		if( uxStack < ( UBaseType_t ) ipconfigIP_STACK_COUNT )
+		{
+			xIPStacks[ uxStack ].pxInterfaceInitialise = pxInterfaceInitialise;
+			xIPStacks[ uxStack ].pxInterfaceOutput = pxInterfaceOutput;
+			xReturn = prvIPInitStack( &( xIPStacks[ uxStack ] ), ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	IPStack_t *pxIPStackGetCurrent( void )
+	{
+	IPStack_t *pxReturn;
+
+		if( xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED )
+		{
+			/* Called from main(), which prepares the stacks.  The IP-tasks may
+			have been created already, so the current task says nothing. */
+			pxReturn = &( xIPStacks[ 0 ] );
+		}
+		else
+		{
+			pxReturn = ( IPStack_t * ) pvTaskGetThreadLocalStoragePointer( NULL, ipconfigIP_STACK_TLS_INDEX );
+
+			/* The calling task has not called FreeRTOS_SetIPStack().  Using
+			stack 0 would silently mix the traffic of the stacks. */
+			configASSERT( pxReturn != NULL );
+
+			if( pxReturn == NULL )
+			{
+				pxReturn = &( xIPStacks[ 0 ] );
+			}
+		}
+
+		return pxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t FreeRTOS_SetIPStack( UBaseType_t uxStack )
+	{
+	BaseType_t xReturn = pdFAIL;
+
+		if( uxStack < ( UBaseType_t ) ipconfigIP_STACK_COUNT )
+		{
+			vTaskSetThreadLocalStoragePointer( NULL, ipconfigIP_STACK_TLS_INDEX, &( xIPStacks[ uxStack ] ) );
+			xReturn = pdPASS;
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+#else /* ipconfigIP_STACK_COUNT */
+
+	BaseType_t FreeRTOS_SetIPStack( UBaseType_t uxStack )
+	{
+		/* There is only one stack, nothing to remember. */
+		return ( uxStack == 0U ) ? pdPASS : pdFAIL;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigIP_STACK_COUNT */
+
+UBaseType_t FreeRTOS_GetIPStack( void )
+{
+	return pxIPStack->uxIndex;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIPInitStack( IPStack_t *pxStack,
+								  const uint8_t ucIPAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+								  const uint8_t ucNetMask[ ipIP_ADDRESS_LENGTH_BYTES ],
+								  const uint8_t ucGatewayAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+								  const uint8_t ucDNSServerAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+								  const uint8_t ucMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ] )
 {
 BaseType_t xReturn = pdFALSE;
+uint32_t *pulLocalIPAddress = ( uint32_t * ) &( pxStack->xDefaultPartUDPPacketHeader.ulWords[ 20U / sizeof( uint32_t ) ] );
 
-	/* This function should only be called once. */
-	configASSERT( xIPIsNetworkTaskReady() == pdFALSE );
-	configASSERT( xNetworkEventQueue == NULL );
-	configASSERT( xIPTaskHandle == NULL );
+	/* This function should only be called once for each stack. */
+	configASSERT( pxStack->xIPTaskInitialised == pdFALSE );
+	configASSERT( pxStack->xNetworkEventQueue == NULL );
+	configASSERT( pxStack->xIPTaskHandle == NULL );
 
 	#ifndef _lint
 	{
@@ -987,78 +1342,114 @@ BaseType_t xReturn = pdFALSE;
 		configASSERT( sizeof( UDPHeader_t ) == ipEXPECTED_UDPHeader_t_SIZE );
 	}
 	#endif
+	pxStack->uxIndex = ( UBaseType_t ) ( pxStack - xIPStacks );
+	pxStack->usPacketIdentifier = 0U;
+	( void ) memcpy( &( pxStack->xDefaultPartUDPPacketHeader ), &( xDefaultPartUDPPacketHeaderTemplate ), sizeof( pxStack->xDefaultPartUDPPacketHeader ) );
+	#if( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
+	{
+		pxStack->uxQueueMinimumSpace = ipconfigEVENT_QUEUE_LENGTH;
+	}
+	#endif
+
 	/* Attempt to create the queue used to communicate with the IP task. */
-	xNetworkEventQueue = xQueueCreate( ( UBaseType_t ) ipconfigEVENT_QUEUE_LENGTH, ( UBaseType_t ) sizeof( IPStackEvent_t ) );
-	configASSERT( xNetworkEventQueue != NULL );
+	pxStack->xNetworkEventQueue = xQueueCreate( ( UBaseType_t ) ipconfigEVENT_QUEUE_LENGTH, ( UBaseType_t ) sizeof( IPStackEvent_t ) );
+	configASSERT( pxStack->xNetworkEventQueue != NULL );
+
+	#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+	{
+		if( pxStack->xNetworkEventQueue != NULL )
+		{
+			pxStack->xNetworkControlQueue = xQueueCreate( ( UBaseType_t ) ipconfigCONTROL_EVENT_QUEUE_LENGTH, ( UBaseType_t ) sizeof( IPStackEvent_t ) );
+			configASSERT( pxStack->xNetworkControlQueue != NULL );
+
+			if( pxStack->xNetworkControlQueue == NULL )
+			{
+				vQueueDelete( pxStack->xNetworkEventQueue );
+				pxStack->xNetworkEventQueue = NULL;
+			}
+		}
+	}
+	#endif /* ipconfigUSE_PRIORITY_EVENT_QUEUES */
 
-	if( xNetworkEventQueue != NULL )
+	if( pxStack->xNetworkEventQueue != NULL )
 	{
 		#if ( configQUEUE_REGISTRY_SIZE > 0 )
 		{
 			/* A queue registry is normally used to assist a kernel aware
 			debugger.  If one is in use then it will be helpful for the debugger
 			to show information about the network event queue. */
-			vQueueAddToRegistry( xNetworkEventQueue, "NetEvnt" );
+			vQueueAddToRegistry( pxStack->xNetworkEventQueue, "NetEvnt" );
+			#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+			{
+				vQueueAddToRegistry( pxStack->xNetworkControlQueue, "NetCtrl" );
+			}
+			#endif
 		}
 		#endif /* configQUEUE_REGISTRY_SIZE */
 
 		if( xNetworkBuffersInitialise() == pdPASS )
 		{
 			/* Store the local IP and MAC address. */
-			xNetworkAddressing.ulDefaultIPAddress = FreeRTOS_inet_addr_quick( ucIPAddress[ 0 ], ucIPAddress[ 1 ], ucIPAddress[ 2 ], ucIPAddress[ 3 ] );
-			xNetworkAddressing.ulNetMask = FreeRTOS_inet_addr_quick( ucNetMask[ 0 ], ucNetMask[ 1 ], ucNetMask[ 2 ], ucNetMask[ 3 ] );
-			xNetworkAddressing.ulGatewayAddress = FreeRTOS_inet_addr_quick( ucGatewayAddress[ 0 ], ucGatewayAddress[ 1 ], ucGatewayAddress[ 2 ], ucGatewayAddress[ 3 ] );
-			xNetworkAddressing.ulDNSServerAddress = FreeRTOS_inet_addr_quick( ucDNSServerAddress[ 0 ], ucDNSServerAddress[ 1 ], ucDNSServerAddress[ 2 ], ucDNSServerAddress[ 3 ] );
-			xNetworkAddressing.ulBroadcastAddress = ( xNetworkAddressing.ulDefaultIPAddress & xNetworkAddressing.ulNetMask ) |  ~xNetworkAddressing.ulNetMask;
+			pxStack->xNetworkAddressing.ulDefaultIPAddress = FreeRTOS_inet_addr_quick( ucIPAddress[ 0 ], ucIPAddress[ 1 ], ucIPAddress[ 2 ], ucIPAddress[ 3 ] );
+			pxStack->xNetworkAddressing.ulNetMask = FreeRTOS_inet_addr_quick( ucNetMask[ 0 ], ucNetMask[ 1 ], ucNetMask[ 2 ], ucNetMask[ 3 ] );
+			pxStack->xNetworkAddressing.ulGatewayAddress = FreeRTOS_inet_addr_quick( ucGatewayAddress[ 0 ], ucGatewayAddress[ 1 ], ucGatewayAddress[ 2 ], ucGatewayAddress[ 3 ] );
+			pxStack->xNetworkAddressing.ulDNSServerAddress = FreeRTOS_inet_addr_quick( ucDNSServerAddress[ 0 ], ucDNSServerAddress[ 1 ], ucDNSServerAddress[ 2 ], ucDNSServerAddress[ 3 ] );
+			pxStack->xNetworkAddressing.ulBroadcastAddress = ( pxStack->xNetworkAddressing.ulDefaultIPAddress & pxStack->xNetworkAddressing.ulNetMask ) |  ~pxStack->xNetworkAddressing.ulNetMask;
 
-			( void ) memcpy( &xDefaultAddressing, &xNetworkAddressing, sizeof( xDefaultAddressing ) );
+			( void ) memcpy( &pxStack->xDefaultAddressing, &pxStack->xNetworkAddressing, sizeof( pxStack->xDefaultAddressing ) );
 
 			#if ipconfigUSE_DHCP == 1
 			{
 				/* The IP address is not set until DHCP completes. */
-				*ipLOCAL_IP_ADDRESS_POINTER = 0x00UL;
+				*pulLocalIPAddress = 0x00UL;
 			}
 			#else
 			{
 				/* The IP address is set from the value passed in. */
-				*ipLOCAL_IP_ADDRESS_POINTER = xNetworkAddressing.ulDefaultIPAddress;
+				*pulLocalIPAddress = pxStack->xNetworkAddressing.ulDefaultIPAddress;
 
 				/* Added to prevent ARP flood to gateway.  Ensure the
 				gateway is on the same subnet as the IP	address. */
-				if( xNetworkAddressing.ulGatewayAddress != 0UL )
+				if( pxStack->xNetworkAddressing.ulGatewayAddress != 0UL )
 				{
-					configASSERT( ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) == ( xNetworkAddressing.ulGatewayAddress & xNetworkAddressing.ulNetMask ) );
+					configASSERT( ( ( *pulLocalIPAddress ) & pxStack->xNetworkAddressing.ulNetMask ) == ( pxStack->xNetworkAddressing.ulGatewayAddress & pxStack->xNetworkAddressing.ulNetMask ) );
 				}
 			}
 			#endif /* ipconfigUSE_DHCP == 1 */
 
 			/* The MAC address is stored in the start of the default packet
 			header fragment, which is used when sending UDP packets. */
-			( void ) memcpy( ipLOCAL_MAC_ADDRESS, ucMACAddress, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
+			( void ) memcpy( pxStack->xDefaultPartUDPPacketHeader.ucBytes, ucMACAddress, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
 
 			/* Prepare the sockets interface. */
-			vNetworkSocketsInit();
+			vNetworkSocketsInit( pxStack );
 
 			/* Create the task that processes Ethernet and stack events. */
 			xReturn = xTaskCreate( prvIPTask,
 								   "IP-task",
 								   ( uint16_t )ipconfigIP_TASK_STACK_SIZE_WORDS,
-								   NULL,
+								   ( void * ) pxStack,
 								   ( UBaseType_t )ipconfigIP_TASK_PRIORITY,
-								   &( xIPTaskHandle ) );
+								   &( pxStack->xIPTaskHandle ) );
 		}
 		else
 		{
-			FreeRTOS_debug_printf( ( "FreeRTOS_IPInit: xNetworkBuffersInitialise() failed\n") );
+			FreeRTOS_debug_printf( ( "prvIPInitStack: xNetworkBuffersInitialise() failed\n") );
 
 			/* Clean up. */
-			vQueueDelete( xNetworkEventQueue );
-			xNetworkEventQueue = NULL;
+			vQueueDelete( pxStack->xNetworkEventQueue );
+			pxStack->xNetworkEventQueue = NULL;
+			#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+			{
+				vQueueDelete( pxStack->xNetworkControlQueue );
+				pxStack->xNetworkControlQueue = NULL;
+			}
+			#endif
 		}
 	}
 	else
 	{
-		FreeRTOS_debug_printf( ( "FreeRTOS_IPInit: Network event queue could not be created\n") );
+		FreeRTOS_debug_printf( ( "prvIPInitStack: Network event queue could not be created\n") );
 	}
 
 	return xReturn;
@@ -1079,17 +1470,17 @@ void FreeRTOS_GetAddressConfiguration( uint32_t *pulIPAddress,
 
 	if( pulNetMask != NULL )
 	{
-		*pulNetMask = xNetworkAddressing.ulNetMask;
+		*pulNetMask = pxIPStack->xNetworkAddressing.ulNetMask;
 	}
 
 	if( pulGatewayAddress != NULL )
 	{
-		*pulGatewayAddress = xNetworkAddressing.ulGatewayAddress;
+		*pulGatewayAddress = pxIPStack->xNetworkAddressing.ulGatewayAddress;
 	}
 
 	if( pulDNSServerAddress != NULL )
 	{
-		*pulDNSServerAddress = xNetworkAddressing.ulDNSServerAddress;
+		*pulDNSServerAddress = pxIPStack->xNetworkAddressing.ulDNSServerAddress;
 	}
 }
 /*-----------------------------------------------------------*/
@@ -1108,18 +1499,27 @@ void FreeRTOS_SetAddressConfiguration( const uint32_t *pulIPAddress,
 
 	if( pulNetMask != NULL )
 	{
-		xNetworkAddressing.ulNetMask = *pulNetMask;
+		pxIPStack->xNetworkAddressing.ulNetMask = *pulNetMask;
 	}
 
 	if( pulGatewayAddress != NULL )
 	{
-		xNetworkAddressing.ulGatewayAddress = *pulGatewayAddress;
+		pxIPStack->xNetworkAddressing.ulGatewayAddress = *pulGatewayAddress;
 	}
 
 	if( pulDNSServerAddress != NULL )
 	{
-		xNetworkAddressing.ulDNSServerAddress = *pulDNSServerAddress;
+		pxIPStack->xNetworkAddressing.ulDNSServerAddress = *pulDNSServerAddress;
+	}
+
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+		if( ( pulIPAddress != NULL ) || ( pulNetMask != NULL ) )
+		{
+			vRouteInvalidateCaches();
+		}
 	}
+	#endif /* ipconfigUSE_ROUTING */
 }
 /*-----------------------------------------------------------*/
 
@@ -1176,6 +1576,7 @@ void FreeRTOS_SetAddressConfiguration( const uint32_t *pulIPAddress,
 				/* The message is complete, IP and checksum's are handled by
 				vProcessGeneratedUDPPacket */
 				pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] = FREERTOS_SO_UDPCKSUM_OUT;
+				pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_TOS_OFFSET ] = 0U;
 				pxNetworkBuffer->ulIPAddress = ulIPAddress;
 				pxNetworkBuffer->usPort = ipPACKET_CONTAINS_ICMP_DATA;
 				/* xDataLength is the size of the total packet, including the Ethernet header. */
@@ -1241,9 +1642,13 @@ TickType_t uxUseTimeout = uxTimeout;
 				/* TCP timer events are sent to wake the timer task when
 				xTCPTimer has expired, but there is no point sending them if the
 				IP task is already awake processing other message. */
-				xTCPTimer.bExpired = pdTRUE_UNSIGNED;
+				pxIPStack->xTCPTimer.bExpired = pdTRUE_UNSIGNED;
 
-				if( uxQueueMessagesWaiting( xNetworkEventQueue ) != 0U )
+				if( ( uxQueueMessagesWaiting( pxIPStack->xNetworkEventQueue ) != 0U )
+				#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+					|| ( uxQueueMessagesWaiting( pxIPStack->xNetworkControlQueue ) != 0U )
+				#endif
+				  )
 				{
 					/* Not actually going to send the message but this is not a
 					failure as the message didn't need to be sent. */
@@ -1262,13 +1667,56 @@ TickType_t uxUseTimeout = uxTimeout;
 				uxUseTimeout = ( TickType_t ) 0;
 			}
 
-			xReturn = xQueueSendToBack( xNetworkEventQueue, pxEvent, uxUseTimeout );
+			#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+			{
+				if( prvGetEventClass( pxEvent ) == eIPEventClassControl )
+				{
+					/* Do not block on the control queue: when it is full, the
+					event goes to the normal queue. */
+					xReturn = xQueueSendToBack( pxIPStack->xNetworkControlQueue, pxEvent, 0U );
+
+					if( xReturn != pdFAIL )
+					{
+						prvUpdateQueueHighWater( eIPEventClassControl );
+
+						/* The IP-task blocks on xNetworkEventQueue only.  Wake
+						it up with an empty event, unless it has work already.
+						It checks the control queue before it blocks, so an
+						event can not be missed when this send fails. */
+						if( uxQueueMessagesWaiting( pxIPStack->xNetworkEventQueue ) == 0U )
+						{
+						IPStackEvent_t xWakeEvent = { eNoEvent, NULL };
+
+							( void ) xQueueSendToBack( pxIPStack->xNetworkEventQueue, &xWakeEvent, 0U );
+						}
+					}
+					else
+					{
+						xReturn = xQueueSendToBack( pxIPStack->xNetworkEventQueue, pxEvent, uxUseTimeout );
+					}
+				}
+				else
+				{
+					xReturn = xQueueSendToBack( pxIPStack->xNetworkEventQueue, pxEvent, uxUseTimeout );
+
+					if( xReturn != pdFAIL )
+					{
+						prvUpdateQueueHighWater( eIPEventClassData );
+					}
+				}
+			}
+			#else
+			{
+				xReturn = xQueueSendToBack( pxIPStack->xNetworkEventQueue, pxEvent, uxUseTimeout );
+			}
+			#endif /* ipconfigUSE_PRIORITY_EVENT_QUEUES */
 
 			if( xReturn == pdFAIL )
 			{
 				/* A message should have been sent to the IP task, but wasn't. */
 				FreeRTOS_debug_printf( ( "xSendEventStructToIPTask: CAN NOT ADD %d\n", pxEvent->eEventType ) );
 				iptraceSTACK_TX_EVENT_LOST( pxEvent->eEventType );
+				ipSTATS_COUNT_DROP( eIPDropEventQueueFull );
 			}
 		}
 		else
@@ -1283,6 +1731,161 @@ TickType_t uxUseTimeout = uxTimeout;
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t xSendEventStructToIPStackFromISR( IPStack_t *pxStack, const IPStackEvent_t *pxEvent, BaseType_t *pxHigherPriorityTaskWoken )
+{
+BaseType_t xReturn;
+
+	configASSERT( pxStack != NULL );
+
+	if( ( pxStack->xIPTaskInitialised == pdFALSE ) && ( pxEvent->eEventType != eNetworkDownEvent ) )
+	{
+		/* As in xSendEventStructToIPTask(). */
+		xReturn = pdFAIL;
+	}
+	else
+	{
+		#if( ipconfigUSE_TCP == 1 )
+		{
+			if( pxEvent->eEventType == eTCPTimerEvent )
+			{
+				pxStack->xTCPTimer.bExpired = pdTRUE_UNSIGNED;
+			}
+		}
+		#endif /* ipconfigUSE_TCP */
+
+		/* The IP-task blocks on xNetworkEventQueue, so control events are
+		sent to it as well. */
+		xReturn = xQueueSendToBackFromISR( pxStack->xNetworkEventQueue, pxEvent, pxHigherPriorityTaskWoken );
+
+		if( xReturn == pdFAIL )
+		{
+			iptraceSTACK_TX_EVENT_LOST( pxEvent->eEventType );
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+	static eIPEventClass_t prvGetEventClass( const IPStackEvent_t *pxEvent )
+	{
+	eIPEventClass_t eClass;
+
+		switch( pxEvent->eEventType )
+		{
+			case eNetworkRxEvent:
+				eClass = eIPEventClassData;
+
+				#if( ipconfigUSE_LINKED_RX_MESSAGES == 0 )
+				{
+				const NetworkBufferDescriptor_t *pxNetworkBuffer = ipPOINTER_CAST( const NetworkBufferDescriptor_t *, pxEvent->pvData );
+				const UDPPacket_t *pxUDPPacket;
+
+					/* ARP packets and DHCP replies are needed to keep the
+					network going, they should not wait behind other traffic. */
+					if( ( pxNetworkBuffer != NULL ) && ( pxNetworkBuffer->xDataLength >= sizeof( EthernetHeader_t ) ) )
+					{
+						pxUDPPacket = ipPOINTER_CAST( const UDPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+
+						if( pxUDPPacket->xEthernetHeader.usFrameType == ipARP_FRAME_TYPE )
+						{
+							eClass = eIPEventClassControl;
+						}
+						else if( ( pxUDPPacket->xEthernetHeader.usFrameType == ipIPv4_FRAME_TYPE ) &&
+								 ( pxNetworkBuffer->xDataLength >= sizeof( UDPPacket_t ) ) &&
+								 ( pxUDPPacket->xIPHeader.ucProtocol == ( uint8_t ) ipPROTOCOL_UDP ) &&
+								 ( pxUDPPacket->xUDPHeader.usDestinationPort == FreeRTOS_htons( ipDHCP_CLIENT_PORT ) ) )
+						{
+							eClass = eIPEventClassControl;
+						}
+						else
+						{
+							/* Some other packet. */
+						}
+					}
+				}
+				#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+				break;
+
+			case eNetworkTxEvent:
+			case eStackTxEvent:
+			case eInterfaceEvent:
+				eClass = eIPEventClassData;
+				break;
+
+			default:
+				/* Timers, socket API requests, network up/down. */
+				eClass = eIPEventClassControl;
+				break;
+		}
+
+		return eClass;
+	}
+#endif /* ipconfigUSE_PRIORITY_EVENT_QUEUES */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+	static void prvUpdateQueueHighWater( eIPEventClass_t eClass )
+	{
+	QueueHandle_t xQueue;
+	UBaseType_t uxCount;
+
+		if( eClass == eIPEventClassControl )
+		{
+			xQueue = pxIPStack->xNetworkControlQueue;
+		}
+		else
+		{
+			xQueue = pxIPStack->xNetworkEventQueue;
+		}
+
+		uxCount = uxQueueMessagesWaiting( xQueue );
+
+		/* The counter is only used for statistics, a lost update from a
+		concurrent sender is not a problem. */
+		if( pxIPStack->uxEventQueueHighWater[ eClass ] < uxCount )
+		{
+			pxIPStack->uxEventQueueHighWater[ eClass ] = uxCount;
+		}
+	}
+#endif /* ipconfigUSE_PRIORITY_EVENT_QUEUES */
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReceiveEvent( IPStackEvent_t *pxEvent, TickType_t xTicksToWait )
+{
+BaseType_t xReturn = pdFALSE;
+
+	#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+	{
+		/* Take a control event first, unless too many were handled in a row
+		while packets are waiting. */
+		if( ( pxIPStack->uxControlBurst < ( UBaseType_t ) ipconfigIP_TASK_CONTROL_BURST ) ||
+			( uxQueueMessagesWaiting( pxIPStack->xNetworkEventQueue ) == 0U ) )
+		{
+			xReturn = xQueueReceive( pxIPStack->xNetworkControlQueue, ipPOINTER_CAST( void *, pxEvent ), 0U );
+		}
+
+		if( xReturn != pdFALSE )
+		{
+			pxIPStack->uxControlBurst++;
+		}
+		else
+		{
+			pxIPStack->uxControlBurst = 0U;
+		}
+	}
+	#endif /* ipconfigUSE_PRIORITY_EVENT_QUEUES */
+
+	if( xReturn == pdFALSE )
+	{
+		xReturn = xQueueReceive( pxIPStack->xNetworkEventQueue, ipPOINTER_CAST( void *, pxEvent ), xTicksToWait );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
 eFrameProcessingResult_t eConsiderFrameForProcessing( const uint8_t * const pucEthernetBuffer )
 {
 eFrameProcessingResult_t eReturn;
@@ -1302,6 +1905,14 @@ const EthernetHeader_t *pxEthernetHeader;
 		eReturn = eProcessBuffer;
 	}
 	else
+#if( ipconfigUSE_ROUTING != 0 )
+	if( xRoutingIsEndPointMAC( &( pxEthernetHeader->xDestinationAddress ) ) != pdFALSE )
+	{
+		/* The packet was directed to an added end-point - process it. */
+		eReturn = eProcessBuffer;
+	}
+	else
+#endif /* ipconfigUSE_ROUTING */
 #if( ipconfigUSE_LLMNR == 1 )
 	if( memcmp( xLLMNR_MacAdress.ucBytes, pxEthernetHeader->xDestinationAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
 	{
@@ -1310,6 +1921,15 @@ const EthernetHeader_t *pxEthernetHeader;
 	}
 	else
 #endif /* ipconfigUSE_LLMNR */
+#if( ipconfigUSE_IGMP != 0 )
+	if( xIGMPIsGroupMACAddress( &( pxEthernetHeader->xDestinationAddress ) ) != pdFALSE )
+	{
+		/* The packet was sent to a multicast group that has been joined -
+		process it. */
+		eReturn = eProcessBuffer;
+	}
+	else
+#endif /* ipconfigUSE_IGMP */
 	{
 		/* The packet was not a broadcast, or for this node, just release
 		the buffer without taking any other action. */
@@ -1341,20 +1961,18 @@ const EthernetHeader_t *pxEthernetHeader;
 static void prvProcessNetworkDownEvent( void )
 {
 	/* Stop the ARP timer while there is no network. */
-	xARPTimer.bActive = pdFALSE_UNSIGNED;
+	pxIPStack->xARPTimer.bActive = pdFALSE_UNSIGNED;
 
 	#if ipconfigUSE_NETWORK_EVENT_HOOK == 1
 	{
-		static BaseType_t xCallEventHook = pdFALSE;
-
 		/* The first network down event is generated by the IP stack itself to
 		initialise the network hardware, so do not call the network down event
 		the first time through. */
-		if( xCallEventHook == pdTRUE )
+		if( pxIPStack->xCallEventHook == pdTRUE )
 		{
 			vApplicationIPNetworkEventHook( eNetworkDown );
 		}
-		xCallEventHook = pdTRUE;
+		pxIPStack->xCallEventHook = pdTRUE;
 	}
 	#endif
 
@@ -1366,7 +1984,7 @@ static void prvProcessNetworkDownEvent( void )
 	/* The network has been disconnected (or is being initialised for the first
 	time).  Perform whatever hardware processing is necessary to bring it up
 	again, or wait for it to be available again.  This is hardware dependent. */
-	if( xNetworkInterfaceInitialise() != pdPASS )
+	if( ipNETWORK_DRIVER_INITIALISE() != pdPASS )
 	{
 		/* Ideally the network interface initialisation function will only
 		return when the network is available.  In case this is not the case,
@@ -1395,7 +2013,7 @@ static void prvProcessNetworkDownEvent( void )
 
 void vIPNetworkUpCalls( void )
 {
-	xNetworkUp = pdTRUE;
+	pxIPStack->xNetworkUp = pdTRUE;
 
 	#if( ipconfigUSE_NETWORK_EVENT_HOOK == 1 )
 	{
@@ -1412,8 +2030,16 @@ void vIPNetworkUpCalls( void )
 	}
 	#endif /* ipconfigDNS_USE_CALLBACKS != 0 */
 
+	#if( ipconfigUSE_IGMP != 0 )
+	{
+		/* Announce the memberships on the new network. */
+		vIGMPNetworkUp();
+		prvIGMPProcess();
+	}
+	#endif /* ipconfigUSE_IGMP */
+
 	/* Set remaining time to 0 so it will become active immediately. */
-	prvIPTimerReload( &xARPTimer, pdMS_TO_TICKS( ipARP_TIMER_PERIOD_MS ) );
+	prvIPTimerReload( &pxIPStack->xARPTimer, pdMS_TO_TICKS( ipARP_TIMER_PERIOD_MS ) );
 }
 /*-----------------------------------------------------------*/
 
@@ -1424,6 +2050,13 @@ eFrameProcessingResult_t eReturned = eReleaseBuffer;
 
 	configASSERT( pxNetworkBuffer != NULL );
 
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+		/* Find the end-point that will answer the packet. */
+		vRoutingReceive( pxNetworkBuffer );
+	}
+	#endif
+
 	/* Interpret the Ethernet frame. */
 	if( pxNetworkBuffer->xDataLength >= sizeof( EthernetHeader_t ) )
 	{
@@ -1448,6 +2081,7 @@ eFrameProcessingResult_t eReturned = eReleaseBuffer;
 				}
 				else
 				{
+					ipSTATS_COUNT_DROP( eIPDropMalformed );
 					eReturned = eReleaseBuffer;
 				}
 				break;
@@ -1460,82 +2094,240 @@ eFrameProcessingResult_t eReturned = eReleaseBuffer;
 				}
 				else
 				{
+					ipSTATS_COUNT_DROP( eIPDropMalformed );
 					eReturned = eReleaseBuffer;
 				}
 				break;
 
 			default:
 				/* No other packet types are handled.  Nothing to do. */
+				ipSTATS_COUNT_DROP( eIPDropFiltered );
 				eReturned = eReleaseBuffer;
 				break;
 			}
 		}
 	}
 
-	/* Perform any actions that resulted from processing the Ethernet frame. */
-	switch( eReturned )
+	/* Perform any actions that resulted from processing the Ethernet frame. */
+	switch( eReturned )
+	{
+		case eReturnEthernetFrame :
+			/* The Ethernet frame will have been updated (maybe it was
+			an ARP request or a PING request?) and should be sent back to
+			its source. */
+			vReturnEthernetFrame( pxNetworkBuffer, pdTRUE );
+			/* parameter pdTRUE: the buffer must be released once
+			the frame has been transmitted */
+			break;
+
+		case eFrameConsumed :
+			/* The frame is in use somewhere, don't release the buffer
+			yet. */
+			break;
+
+		case eReleaseBuffer :
+		case eProcessBuffer :
+		default :
+			/* The frame is not being used anywhere, and the
+			NetworkBufferDescriptor_t structure containing the frame should
+			just be	released back to the list of free buffers. */
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+			break;
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIsIPv4Multicast( uint32_t ulIPAddress )
+{
+BaseType_t xReturn;
+uint32_t ulIP = FreeRTOS_ntohl( ulIPAddress );
+
+	if( ( ulIP >= ipFIRST_MULTI_CAST_IPv4 ) && ( ulIP < ipLAST_MULTI_CAST_IPv4 ) )
+	{
+		xReturn = pdTRUE;
+	}
+	else
+	{
+		xReturn = pdFALSE;
+	}
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vSetMultiCastIPv4MacAddress( uint32_t ulIPAddress, MACAddress_t *pxMACAddress )
+{
+uint32_t ulIP = FreeRTOS_ntohl( ulIPAddress );
+
+	pxMACAddress->ucBytes[ 0 ] = ( uint8_t ) 0x01U;
+	pxMACAddress->ucBytes[ 1 ] = ( uint8_t ) 0x00U;
+	pxMACAddress->ucBytes[ 2 ] = ( uint8_t ) 0x5EU;
+	pxMACAddress->ucBytes[ 3 ] = ( uint8_t ) ( ( ulIP >> 16 ) & 0x7fU );	/* Use 7 bits. */
+	pxMACAddress->ucBytes[ 4 ] = ( uint8_t ) ( ( ulIP >>  8 ) & 0xffU );	/* Use 8 bits. */
+	pxMACAddress->ucBytes[ 5 ] = ( uint8_t ) ( ( ulIP       ) & 0xffU );	/* Use 8 bits. */
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_LOOPBACK != 0 )
+
+	BaseType_t xIsLoopbackIPAddress( uint32_t ulIPAddress )
+	{
+	BaseType_t xReturn;
+
+		if( ( FreeRTOS_ntohl( ulIPAddress ) & ipLOOPBACK_NETMASK_IPv4 ) == ipLOOPBACK_NETWORK_IPv4 )
+		{
+			xReturn = pdTRUE;
+		}
+		else if( ( ulIPAddress == *ipLOCAL_IP_ADDRESS_POINTER ) && ( ulIPAddress != 0UL ) )
+		{
+			xReturn = pdTRUE;
+		}
+	#if( ipconfigUSE_ROUTING != 0 )
+		else if( pxRoutingFindEndPoint( ulIPAddress ) != NULL )
+		{
+			/* The address of an added end-point. */
+			xReturn = pdTRUE;
+		}
+	#endif
+		else
+		{
+			xReturn = pdFALSE;
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xLoopbackOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+	{
+	BaseType_t xReturn = pdFALSE;
+	NetworkBufferDescriptor_t *pxUseBuffer = pxNetworkBuffer;
+	const IPPacket_t *pxIPPacket = ipPOINTER_CAST( const IPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+	IPHeader_t *pxIPHeader;
+
+		if( ( pxNetworkBuffer->xDataLength >= sizeof( IPPacket_t ) ) &&
+			( pxIPPacket->xEthernetHeader.usFrameType == ipIPv4_FRAME_TYPE ) &&
+			( xIsLoopbackIPAddress( pxIPPacket->xIPHeader.ulDestinationIPAddress ) != pdFALSE ) )
+		{
+			xReturn = pdTRUE;
+
+			if( xReleaseAfterSend == pdFALSE )
+			{
+				/* The caller keeps the buffer, the IP-task needs a copy. */
+				pxUseBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+			}
+
+			if( pxUseBuffer != NULL )
+			{
+				pxIPHeader = &( ipPOINTER_CAST( IPPacket_t *, pxUseBuffer->pucEthernetBuffer )->xIPHeader );
+
+				/* A packet sent to 127.x.x.x seems to come from that same
+				address, so that the reply will be looped back as well, and
+				the peer recognises it. */
+				if( ( ( FreeRTOS_ntohl( pxIPHeader->ulDestinationIPAddress ) & ipLOOPBACK_NETMASK_IPv4 ) == ipLOOPBACK_NETWORK_IPv4 ) &&
+					( pxIPHeader->ulSourceIPAddress != pxIPHeader->ulDestinationIPAddress ) )
+				{
+					pxIPHeader->ulSourceIPAddress = pxIPHeader->ulDestinationIPAddress;
+
+					#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) && ( ipconfigLOOPBACK_SKIP_CHECKSUMS == 0 )
+					{
+						/* The source address is part of both checksums. */
+						pxIPHeader->usHeaderChecksum = 0U;
+						pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+						pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+						( void ) usGenerateProtocolChecksum( pxUseBuffer->pucEthernetBuffer, pxUseBuffer->xDataLength, pdTRUE );
+					}
+					#endif
+				}
+
+				iptraceLOOPBACK_PACKET( pxUseBuffer );
+
+				/* Handled by prvProcessLoopbackPackets() as soon as the
+				IP-task has finished the current event. */
+				vListInsertEnd( &pxIPStack->xLoopbackList, &( pxUseBuffer->xBufferListItem ) );
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvProcessLoopbackPackets( void )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	UBaseType_t uxCount;
+
+		/* Only handle the packets that are waiting now.  Any answers will be
+		handled in the next round, after the event queue has been checked. */
+		uxCount = listCURRENT_LIST_LENGTH( &pxIPStack->xLoopbackList );
+
+		while( uxCount > 0U )
+		{
+			pxNetworkBuffer = ipPOINTER_CAST( NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( &pxIPStack->xLoopbackList ) );
+			( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+
+			pxIPStack->xLoopbackReceiving = pdTRUE;
+			prvProcessEthernetPacket( pxNetworkBuffer );
+			pxIPStack->xLoopbackReceiving = pdFALSE;
+
+			uxCount--;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_LOOPBACK */
+
+#if( ipconfigUSE_ROUTING != 0 )
+
+	static void prvProcessInterfacePackets( void )
 	{
-		case eReturnEthernetFrame :
-			/* The Ethernet frame will have been updated (maybe it was
-			an ARP request or a PING request?) and should be sent back to
-			its source. */
-			vReturnEthernetFrame( pxNetworkBuffer, pdTRUE );
-			/* parameter pdTRUE: the buffer must be released once
-			the frame has been transmitted */
-			break;
+	NetworkInterface_t *pxInterface;
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	UBaseType_t uxCount;
 
-		case eFrameConsumed :
-			/* The frame is in use somewhere, don't release the buffer
-			yet. */
-			break;
+		for( pxInterface = pxIPStack->pxInterfaces; pxInterface != NULL; pxInterface = pxInterface->pxNext )
+		{
+			/* A busy interface can not starve the others. */
+			for( uxCount = 0U; uxCount < ( UBaseType_t ) ipconfigINTERFACE_BURST; uxCount++ )
+			{
+				pxNetworkBuffer = pxRoutingGetReceived( pxInterface );
 
-		case eReleaseBuffer :
-		case eProcessBuffer :
-		default :
-			/* The frame is not being used anywhere, and the
-			NetworkBufferDescriptor_t structure containing the frame should
-			just be	released back to the list of free buffers. */
-			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
-			break;
-	}
-}
-/*-----------------------------------------------------------*/
+				if( pxNetworkBuffer == NULL )
+				{
+					break;
+				}
 
-BaseType_t xIsIPv4Multicast( uint32_t ulIPAddress )
-{
-BaseType_t xReturn;
-uint32_t ulIP = FreeRTOS_ntohl( ulIPAddress );
+				iptraceNETWORK_INTERFACE_RECEIVE();
+				prvProcessEthernetPacket( pxNetworkBuffer );
+			}
+		}
 
-	if( ( ulIP >= ipFIRST_MULTI_CAST_IPv4 ) && ( ulIP < ipLAST_MULTI_CAST_IPv4 ) )
-	{
-		xReturn = pdTRUE;
-	}
-	else
-	{
-		xReturn = pdFALSE;
+		vRoutingSendQueued();
 	}
-	return xReturn;
-}
-/*-----------------------------------------------------------*/
-
-void vSetMultiCastIPv4MacAddress( uint32_t ulIPAddress, MACAddress_t *pxMACAddress )
-{
-uint32_t ulIP = FreeRTOS_ntohl( ulIPAddress );
+	/*-----------------------------------------------------------*/
 
-	pxMACAddress->ucBytes[ 0 ] = ( uint8_t ) 0x01U;
-	pxMACAddress->ucBytes[ 1 ] = ( uint8_t ) 0x00U;
-	pxMACAddress->ucBytes[ 2 ] = ( uint8_t ) 0x5EU;
-	pxMACAddress->ucBytes[ 3 ] = ( uint8_t ) ( ( ulIP >> 16 ) & 0x7fU );	/* Use 7 bits. */
-	pxMACAddress->ucBytes[ 4 ] = ( uint8_t ) ( ( ulIP >>  8 ) & 0xffU );	/* Use 8 bits. */
-	pxMACAddress->ucBytes[ 5 ] = ( uint8_t ) ( ( ulIP       ) & 0xffU );	/* Use 8 bits. */
-}
-/*-----------------------------------------------------------*/
+#endif /* ipconfigUSE_ROUTING */
 
 static eFrameProcessingResult_t prvAllowIPPacket( const IPPacket_t * const pxIPPacket,
 	const NetworkBufferDescriptor_t * const pxNetworkBuffer, UBaseType_t uxHeaderLength )
 {
 eFrameProcessingResult_t eReturn = eProcessBuffer;
 
+#if( ipconfigIP_REASSEMBLY_SLOTS > 0 )
+	/* The length fields and the protocol checksum of a fragment can only be
+	checked after reassembly. */
+	const BaseType_t xIsFragment = prvIPIsFragment( &( pxIPPacket->xIPHeader ) );
+#else
+	const BaseType_t xIsFragment = pdFALSE;
+#endif
+
+#if( ipconfigUSE_LOOPBACK != 0 )
+	/* A looped-back packet was never on the wire, its checksums need no
+	checking. */
+	const BaseType_t xIsLoopback = pxIPStack->xLoopbackReceiving;
+#else
+	const BaseType_t xIsLoopback = pdFALSE;
+#endif
+
 #if( ( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 0 ) || ( ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM == 0 ) )
 	const IPHeader_t * pxIPHeader = &( pxIPPacket->xIPHeader );
 #else
@@ -1551,12 +2343,19 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 		This method may decrease the usage of sparse network buffers. */
 		uint32_t ulDestinationIPAddress = pxIPHeader->ulDestinationIPAddress;
 
+		#if( ipconfigIP_REASSEMBLY_SLOTS > 0 )
+			/* Fragments of UDP datagrams will be reassembled, other fragments
+			are not handled. */
+			if( ( xIsFragment != pdFALSE ) && ( pxIPHeader->ucProtocol != ( uint8_t ) ipPROTOCOL_UDP ) )
+		#else
 			/* Ensure that the incoming packet is not fragmented (only outgoing
 			packets can be fragmented) as these are the only handled IP frames
 			currently. */
 			if( ( pxIPHeader->usFragmentOffset & ipFRAGMENT_OFFSET_BIT_MASK ) != 0U )
+		#endif
 			{
 				/* Can not handle, fragmented packet. */
+				ipSTATS_COUNT_DROP( eIPDropFiltered );
 				eReturn = eReleaseBuffer;
 			}
 			/* Test if the length of the IP-header is between 20 and 60 bytes,
@@ -1565,6 +2364,7 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 					 ( pxIPHeader->ucVersionHeaderLength > ipIPV4_VERSION_HEADER_LENGTH_MAX ) )
 			{
 				/* Can not handle, unknown or invalid header version. */
+				ipSTATS_COUNT_DROP( eIPDropMalformed );
 				eReturn = eReleaseBuffer;
 			}
 				/* Is the packet for this IP address? */
@@ -1572,15 +2372,30 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 				/* Is it the global broadcast address 255.255.255.255 ? */
 				( ulDestinationIPAddress != ipBROADCAST_IP_ADDRESS ) &&
 				/* Is it a specific broadcast address 192.168.1.255 ? */
-				( ulDestinationIPAddress != xNetworkAddressing.ulBroadcastAddress ) &&
+				( ulDestinationIPAddress != pxIPStack->xNetworkAddressing.ulBroadcastAddress ) &&
+			#if( ipconfigUSE_ROUTING != 0 )
+				/* Is it the address or the broadcast address of an added
+				end-point? */
+				( pxRoutingFindEndPoint( ulDestinationIPAddress ) == NULL ) &&
+				( xRoutingIsBroadcast( ulDestinationIPAddress ) == pdFALSE ) &&
+			#endif
 			#if( ipconfigUSE_LLMNR == 1 )
 				/* Is it the LLMNR multicast address? */
 				( ulDestinationIPAddress != ipLLMNR_IP_ADDR ) &&
+			#endif
+			#if( ipconfigUSE_IGMP != 0 )
+				/* Is it a multicast group that has been joined? */
+				( xIGMPIsGroupMember( ulDestinationIPAddress ) == pdFALSE ) &&
+			#endif
+			#if( ipconfigUSE_LOOPBACK != 0 )
+				/* Is it a loop-back address 127.x.x.x ? */
+				( xIsLoopbackIPAddress( ulDestinationIPAddress ) == pdFALSE ) &&
 			#endif
 				/* Or (during DHCP negotiation) we have no IP-address yet? */
 				( *ipLOCAL_IP_ADDRESS_POINTER != 0UL ) )
 			{
 				/* Packet is not for this node, release it */
+				ipSTATS_COUNT_DROP( eIPDropFiltered );
 				eReturn = eReleaseBuffer;
 			}
 			else
@@ -1594,19 +2409,25 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 	{
 		/* Some drivers of NIC's with checksum-offloading will enable the above
 		define, so that the checksum won't be checked again here */
-		if (eReturn == eProcessBuffer )
+		if( ( eReturn == eProcessBuffer ) && ( xIsLoopback == pdFALSE ) )
 		{
 			/* Is the IP header checksum correct? */
 			if( ( pxIPHeader->ucProtocol != ( uint8_t ) ipPROTOCOL_ICMP ) &&
 				( usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ( size_t ) uxHeaderLength ) != ipCORRECT_CRC ) )
 			{
 				/* Check sum in IP-header not correct. */
+				ipSTATS_COUNT_DROP( eIPDropChecksum );
 				eReturn = eReleaseBuffer;
 			}
+			else if( xIsFragment != pdFALSE )
+			{
+				/* The protocol checksum will be checked after reassembly. */
+			}
 			/* Is the upper-layer checksum (TCP/UDP/ICMP) correct? */
 			else if( usGenerateProtocolChecksum( ( uint8_t * )( pxNetworkBuffer->pucEthernetBuffer ), pxNetworkBuffer->xDataLength, pdFALSE ) != ipCORRECT_CRC )
 			{
 				/* Protocol checksum not accepted. */
+				ipSTATS_COUNT_DROP( eIPDropChecksum );
 				eReturn = eReleaseBuffer;
 			}
 			else
@@ -1618,11 +2439,12 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 	#else
 	{
 
-		if (eReturn == eProcessBuffer )
+		if( ( eReturn == eProcessBuffer ) && ( xIsFragment == pdFALSE ) )
 		{
 			if( xCheckSizeFields( ( uint8_t * )( pxNetworkBuffer->pucEthernetBuffer ), pxNetworkBuffer->xDataLength ) != pdPASS )
 			{
 				/* Some of the length checks were not successful. */
+				ipSTATS_COUNT_DROP( eIPDropMalformed );
 				eReturn = eReleaseBuffer;
 			}
 		}
@@ -1630,7 +2452,7 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 		#if( ipconfigUDP_PASS_ZERO_CHECKSUM_PACKETS == 0 )
 		{
 			/* Check if this is a UDP packet without a checksum. */
-			if (eReturn == eProcessBuffer )
+			if( ( eReturn == eProcessBuffer ) && ( xIsFragment == pdFALSE ) && ( xIsLoopback == pdFALSE ) )
 			{
 				/* ipconfigUDP_PASS_ZERO_CHECKSUM_PACKETS is defined as 0,
 				and so UDP packets carrying a protocol checksum of 0, will
@@ -1661,6 +2483,7 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 						#endif	/* ( ipconfigHAS_PRINTF != 0 ) */
 
 						/* Protocol checksum not accepted. */
+						ipSTATS_COUNT_DROP( eIPDropChecksum );
 						eReturn = eReleaseBuffer;
 					}
 				}
@@ -1691,6 +2514,7 @@ uint8_t ucProtocol;
 	if( ( uxHeaderLength > ( pxNetworkBuffer->xDataLength - ipSIZE_OF_ETH_HEADER ) ) ||
 		( uxHeaderLength < ipSIZE_OF_IPv4_HEADER ) )
 	{
+		ipSTATS_COUNT_DROP( eIPDropMalformed );
 		eReturn = eReleaseBuffer;
 	}
 	else
@@ -1724,16 +2548,36 @@ uint8_t ucProtocol;
 					/* Rewrite the Version/IHL byte to indicate that this packet has no IP options. */
 					pxIPHeader->ucVersionHeaderLength = ( pxIPHeader->ucVersionHeaderLength & 0xF0U ) | /* High nibble is the version. */
 														( ( ipSIZE_OF_IPv4_HEADER >> 2 ) & 0x0FU );
+
+					/* The total length no longer counts the options either.  A
+					valid header is at least as long as its options. */
+					if( FreeRTOS_ntohs( pxIPHeader->usLength ) >= uxHeaderLength )
+					{
+						pxIPHeader->usLength = FreeRTOS_htons( ( uint16_t ) ( FreeRTOS_ntohs( pxIPHeader->usLength ) - optlen ) );
+					}
 				}
 				#else
 				{
 					/* 'ipconfigIP_PASS_PACKETS_WITH_IP_OPTIONS' is not set, so packets carrying
 					IP-options will be dropped. */
+					ipSTATS_COUNT_DROP( eIPDropFiltered );
 					eReturn = eReleaseBuffer;
 				}
 				#endif
 			}
 
+			#if( ipconfigIP_REASSEMBLY_SLOTS > 0 )
+			{
+				if( ( eReturn != eReleaseBuffer ) && ( prvIPIsFragment( pxIPHeader ) != pdFALSE ) )
+				{
+					/* The fragment is copied to the slot of its datagram, after
+					which its network buffer can be released. */
+					prvIPReassemble( pxNetworkBuffer );
+					eReturn = eReleaseBuffer;
+				}
+			}
+			#endif /* ipconfigIP_REASSEMBLY_SLOTS */
+
 			if( eReturn != eReleaseBuffer )
 			{
 				/* Add the IP and MAC addresses to the ARP table if they are not
@@ -1763,7 +2607,7 @@ uint8_t ucProtocol;
 								/* Map the buffer onto a ICMP-Packet struct to easily access the
 								 * fields of ICMP packet. */
 								ICMPPacket_t *pxICMPPacket = ipPOINTER_CAST( ICMPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
-								if( pxIPHeader->ulDestinationIPAddress == *ipLOCAL_IP_ADDRESS_POINTER )
+								if( pxIPHeader->ulDestinationIPAddress == ipBUFFER_IP_ADDRESS( pxNetworkBuffer ) )
 								{
 									eReturn = prvProcessICMPPacket( pxICMPPacket );
 								}
@@ -1826,6 +2670,7 @@ uint8_t ucProtocol;
 							}
 							else
 							{
+								ipSTATS_COUNT_DROP( eIPDropMalformed );
 								eReturn = eReleaseBuffer;
 							}
 						}
@@ -1842,7 +2687,22 @@ uint8_t ucProtocol;
 
 							/* Setting this variable will cause xTCPTimerCheck()
 							to be called just before the IP-task blocks. */
-							xProcessedTCPMessage++;
+							pxIPStack->xProcessedTCPMessage++;
+						}
+						break;
+#endif
+#if( ipconfigUSE_IGMP != 0 )
+					case ipPROTOCOL_IGMP :
+						{
+						/* The IP-options have been removed, also from the length
+						field of the IP-header. */
+						size_t uxIGMPLength = ( size_t ) FreeRTOS_ntohs( pxIPHeader->usLength );
+
+							if( ( uxIGMPLength > ipSIZE_OF_IPv4_HEADER ) &&
+								( ( uxIGMPLength - ipSIZE_OF_IPv4_HEADER ) <= ( pxNetworkBuffer->xDataLength - sizeof( IPPacket_t ) ) ) )
+							{
+								vProcessIGMPPacket( &( pxNetworkBuffer->pucEthernetBuffer[ sizeof( IPPacket_t ) ] ), uxIGMPLength - ipSIZE_OF_IPv4_HEADER );
+							}
 						}
 						break;
 #endif
@@ -1858,6 +2718,295 @@ uint8_t ucProtocol;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigIP_REASSEMBLY_SLOTS > 0 )
+
+	static BaseType_t prvIPIsFragment( const IPHeader_t * const pxIPHeader )
+	{
+	BaseType_t xReturn;
+	uint16_t usFragmentField = FreeRTOS_ntohs( pxIPHeader->usFragmentOffset );
+
+		/* A fragment has either the "more fragments" flag set, or a non-zero
+		offset, or both. */
+		if( ( usFragmentField & ( uint16_t ) ( ipFRAGMENT_FLAG_MORE_FRAGMENTS | ipFRAGMENT_OFFSET_UNITS ) ) != 0U )
+		{
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			xReturn = pdFALSE;
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvIPReassemblyRelease( IPReassemblySlot_t *pxSlot )
+	{
+		if( pxSlot->pxBuffer != NULL )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxSlot->pxBuffer );
+			pxSlot->pxBuffer = NULL;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvIPReassemblyCheckTimeouts( void )
+	{
+	TickType_t xNow = xTaskGetTickCount();
+	BaseType_t xIndex;
+	BaseType_t xBusy = pdFALSE;
+	IPReassemblySlot_t *pxSlot;
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIP_REASSEMBLY_SLOTS; xIndex++ )
+		{
+			pxSlot = &( pxIPStack->xReassemblySlots[ xIndex ] );
+
+			if( pxSlot->pxBuffer != NULL )
+			{
+				if( ( xNow - pxSlot->xStartTime ) >= pdMS_TO_TICKS( ipconfigIP_REASSEMBLY_TIMEOUT_MS ) )
+				{
+					/* Some fragments got lost, the datagram will never be
+					complete. */
+					iptraceIP_REASSEMBLY_TIMEOUT( pxSlot->ulSourceIPAddress, pxSlot->usIdentification );
+					ipSTATS_COUNT_DROP( eIPDropReassembly );
+					prvIPReassemblyRelease( pxSlot );
+				}
+				else
+				{
+					xBusy = pdTRUE;
+				}
+			}
+		}
+
+		if( xBusy == pdFALSE )
+		{
+			/* No more datagrams under reassembly, the timer will be started
+			again by the next fragment. */
+			pxIPStack->xReassemblyTimer.bActive = pdFALSE_UNSIGNED;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvIPReassemble( const NetworkBufferDescriptor_t * const pxFragment )
+	{
+	const IPPacket_t *pxIPPacket = ipPOINTER_CAST( const IPPacket_t *, pxFragment->pucEthernetBuffer );
+	const IPHeader_t *pxIPHeader = &( pxIPPacket->xIPHeader );
+	uint16_t usFragmentField = FreeRTOS_ntohs( pxIPHeader->usFragmentOffset );
+	size_t uxOffset = ( ( size_t ) ( usFragmentField & ipFRAGMENT_OFFSET_UNITS ) ) * 8U;
+	size_t uxIPLength = ( size_t ) FreeRTOS_ntohs( pxIPHeader->usLength );
+	BaseType_t xIsLast = ( ( usFragmentField & ipFRAGMENT_FLAG_MORE_FRAGMENTS ) == 0U ) ? pdTRUE : pdFALSE;
+	const uint8_t *pucSource = &( pxFragment->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER ] );
+	uint8_t *pucTarget;
+	IPReassemblySlot_t *pxSlot = NULL;
+	IPReassemblySlot_t *pxFree = NULL;
+	NetworkBufferDescriptor_t *pxDatagram;
+	IPHeader_t *pxDatagramHeader;
+	BaseType_t xIndex;
+	BaseType_t xValid = pdTRUE;
+	BaseType_t xAnySet = pdFALSE;
+	BaseType_t xAllSet = pdTRUE;
+	size_t uxLength = 0U;
+	size_t uxEnd = 0U;
+	size_t uxBlock, uxFirstBlock, uxLastBlock;
+	uint32_t ulMask;
+
+		/* prvProcessIPPacket() has removed the IP-options, and subtracted their
+		length from usLength. */
+		if( ( uxIPLength <= ipSIZE_OF_IPv4_HEADER ) ||
+			( uxIPLength > ( pxFragment->xDataLength - ipSIZE_OF_ETH_HEADER ) ) )
+		{
+			xValid = pdFALSE;
+		}
+		else
+		{
+			uxLength = uxIPLength - ipSIZE_OF_IPv4_HEADER;
+			uxEnd = uxOffset + uxLength;
+
+			/* Except for the last one, all fragments carry a multiple of 8
+			bytes.  The datagram must fit in the network buffer of a slot. */
+			if( ( ( xIsLast == pdFALSE ) && ( ( uxLength & 7U ) != 0U ) ) ||
+				( uxEnd > ipREASSEMBLY_PAYLOAD_SIZE ) )
+			{
+				xValid = pdFALSE;
+			}
+		}
+
+		/* Look up the datagram, and remember a free slot in case it is new. */
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIP_REASSEMBLY_SLOTS; xIndex++ )
+		{
+			if( pxIPStack->xReassemblySlots[ xIndex ].pxBuffer == NULL )
+			{
+				if( pxFree == NULL )
+				{
+					pxFree = &( pxIPStack->xReassemblySlots[ xIndex ] );
+				}
+			}
+			else if( ( pxIPStack->xReassemblySlots[ xIndex ].ulSourceIPAddress == pxIPHeader->ulSourceIPAddress ) &&
+					 ( pxIPStack->xReassemblySlots[ xIndex ].ulDestinationIPAddress == pxIPHeader->ulDestinationIPAddress ) &&
+					 ( pxIPStack->xReassemblySlots[ xIndex ].usIdentification == pxIPHeader->usIdentification ) &&
+					 ( pxIPStack->xReassemblySlots[ xIndex ].ucProtocol == pxIPHeader->ucProtocol ) )
+			{
+				pxSlot = &( pxIPStack->xReassemblySlots[ xIndex ] );
+				break;
+			}
+			else
+			{
+				/* A slot in use by another datagram. */
+			}
+		}
+
+		if( xValid == pdFALSE )
+		{
+			/* A malformed fragment spoils the whole datagram. */
+			iptraceIP_REASSEMBLY_DROPPED( pxIPHeader->ulSourceIPAddress, pxIPHeader->usIdentification );
+			ipSTATS_COUNT_DROP( eIPDropReassembly );
+
+			if( pxSlot != NULL )
+			{
+				prvIPReassemblyRelease( pxSlot );
+			}
+		}
+		else if( pxSlot == NULL )
+		{
+			/* The first fragment of a new datagram to arrive, which is not
+			necessarily the fragment at offset 0.  New datagrams are dropped as
+			long as all slots are in use, so that a flood of fragments can not
+			push out the datagrams that are almost complete. */
+			if( pxFree != NULL )
+			{
+				pxFree->pxBuffer = pxGetNetworkBufferWithDescriptor( ipSIZE_OF_ETH_HEADER + ( size_t ) ipconfigIP_REASSEMBLY_MAX_SIZE, 0U );
+			}
+
+			if( ( pxFree != NULL ) && ( pxFree->pxBuffer != NULL ) )
+			{
+				pxSlot = pxFree;
+				pxSlot->ulSourceIPAddress = pxIPHeader->ulSourceIPAddress;
+				pxSlot->ulDestinationIPAddress = pxIPHeader->ulDestinationIPAddress;
+				pxSlot->usIdentification = pxIPHeader->usIdentification;
+				pxSlot->ucProtocol = pxIPHeader->ucProtocol;
+				pxSlot->uxReceived = 0U;
+				pxSlot->uxTotal = 0U;
+				pxSlot->uxHighest = 0U;
+				pxSlot->xStartTime = xTaskGetTickCount();
+				( void ) memset( pxSlot->ulBlocks, 0, sizeof( pxSlot->ulBlocks ) );
+
+				if( pxIPStack->xReassemblyTimer.bActive == pdFALSE_UNSIGNED )
+				{
+					prvIPTimerReload( &pxIPStack->xReassemblyTimer, pdMS_TO_TICKS( ipREASSEMBLY_TIMER_PERIOD_MS ) );
+				}
+			}
+			else
+			{
+				iptraceIP_REASSEMBLY_DROPPED( pxIPHeader->ulSourceIPAddress, pxIPHeader->usIdentification );
+				ipSTATS_COUNT_DROP( eIPDropReassembly );
+			}
+		}
+		else
+		{
+			/* The datagram is known already. */
+		}
+
+		if( ( xValid != pdFALSE ) && ( pxSlot != NULL ) )
+		{
+			pucTarget = &( pxSlot->pxBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + uxOffset ] );
+
+			/* See which of the 8-byte blocks were received already. */
+			uxFirstBlock = uxOffset / 8U;
+			uxLastBlock = ( uxEnd + 7U ) / 8U;
+
+			for( uxBlock = uxFirstBlock; uxBlock < uxLastBlock; uxBlock++ )
+			{
+				ulMask = 1UL << ( uxBlock & 31U );
+
+				if( ( pxSlot->ulBlocks[ uxBlock / 32U ] & ulMask ) != 0UL )
+				{
+					xAnySet = pdTRUE;
+				}
+				else
+				{
+					xAllSet = pdFALSE;
+				}
+			}
+
+			if( xAnySet != pdFALSE )
+			{
+				if( ( xAllSet != pdFALSE ) && ( memcmp( pucTarget, pucSource, uxLength ) == 0 ) )
+				{
+					/* An exact copy of a fragment that was received before. */
+				}
+				else
+				{
+					/* Fragments that overlap are used to sneak data past
+					filters, or to exhaust the reassembly resources.  Do not
+					try to resolve it, but discard the whole datagram. */
+					iptraceIP_REASSEMBLY_OVERLAP( pxSlot->ulSourceIPAddress, pxSlot->usIdentification );
+					prvIPReassemblyRelease( pxSlot );
+				}
+			}
+			else if( ( ( xIsLast != pdFALSE ) && ( ( pxSlot->uxTotal != 0U ) || ( pxSlot->uxHighest > uxEnd ) ) ) ||
+					 ( ( pxSlot->uxTotal != 0U ) && ( uxEnd > pxSlot->uxTotal ) ) )
+			{
+				/* The fragments do not agree about the length of the datagram. */
+				iptraceIP_REASSEMBLY_DROPPED( pxSlot->ulSourceIPAddress, pxSlot->usIdentification );
+				ipSTATS_COUNT_DROP( eIPDropReassembly );
+				prvIPReassemblyRelease( pxSlot );
+			}
+			else
+			{
+				( void ) memcpy( pucTarget, pucSource, uxLength );
+
+				for( uxBlock = uxFirstBlock; uxBlock < uxLastBlock; uxBlock++ )
+				{
+					pxSlot->ulBlocks[ uxBlock / 32U ] |= 1UL << ( uxBlock & 31U );
+				}
+
+				pxSlot->uxReceived += uxLength;
+
+				if( uxEnd > pxSlot->uxHighest )
+				{
+					pxSlot->uxHighest = uxEnd;
+				}
+
+				if( xIsLast != pdFALSE )
+				{
+					pxSlot->uxTotal = uxEnd;
+				}
+
+				if( uxOffset == 0U )
+				{
+					/* The Ethernet and IP headers of the first fragment will be
+					those of the datagram. */
+					( void ) memcpy( pxSlot->pxBuffer->pucEthernetBuffer, pxFragment->pucEthernetBuffer, ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER );
+				}
+
+				/* As overlaps are refused, the datagram is complete when the
+				number of bytes received equals its length. */
+				if( ( pxSlot->uxTotal != 0U ) && ( pxSlot->uxReceived == pxSlot->uxTotal ) )
+				{
+					pxDatagram = pxSlot->pxBuffer;
+					pxSlot->pxBuffer = NULL;
+
+					pxDatagramHeader = &( ipPOINTER_CAST( IPPacket_t *, pxDatagram->pucEthernetBuffer )->xIPHeader );
+					pxDatagramHeader->usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_IPv4_HEADER + pxSlot->uxTotal ) );
+					pxDatagramHeader->usFragmentOffset = 0U;
+					pxDatagramHeader->usHeaderChecksum = 0U;
+					pxDatagramHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxDatagramHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+					pxDatagramHeader->usHeaderChecksum = ~FreeRTOS_htons( pxDatagramHeader->usHeaderChecksum );
+					pxDatagram->xDataLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + pxSlot->uxTotal;
+
+					iptraceIP_REASSEMBLY_COMPLETE( pxDatagram );
+
+					/* Process the datagram as if it was received in one piece,
+					which also checks its length fields and protocol checksum. */
+					prvProcessEthernetPacket( pxDatagram );
+				}
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigIP_REASSEMBLY_SLOTS */
+
 #if ( ipconfigSUPPORT_OUTGOING_PINGS == 1 )
 
 	static void prvProcessICMPEchoReply( ICMPPacket_t * const pxICMPPacket )
@@ -1910,6 +3059,7 @@ uint8_t ucProtocol;
 	ICMPHeader_t *pxICMPHeader;
 	IPHeader_t *pxIPHeader;
 	uint16_t usRequest;
+	uint32_t ulOwnIPAddress;
 
 		pxICMPHeader = &( pxICMPPacket->xICMPHeader );
 		pxIPHeader = &( pxICMPPacket->xIPHeader );
@@ -1922,8 +3072,12 @@ uint8_t ucProtocol;
 		tell that the ping was received - even if the ping reply contains
 		invalid data. */
 		pxICMPHeader->ucTypeOfMessage = ( uint8_t ) ipICMP_ECHO_REPLY;
+
+		/* Only a request for the address of this host (or of one of its
+		end-points) gets here, answer with that address. */
+		ulOwnIPAddress = pxIPHeader->ulDestinationIPAddress;
 		pxIPHeader->ulDestinationIPAddress = pxIPHeader->ulSourceIPAddress;
-		pxIPHeader->ulSourceIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+		pxIPHeader->ulSourceIPAddress = ulOwnIPAddress;
 
 		/* Update the checksum because the ucTypeOfMessage member in the header
 		has been changed to ipICMP_ECHO_REPLY.  This is faster than calling
@@ -2082,7 +3236,7 @@ uint8_t ucProtocol;
 			uxLength -= ( ( uint16_t ) uxIPHeaderLength ); /* normally, minus 20. */
 
 			if( ( uxLength < ( ( size_t ) sizeof( pxProtPack->xUDPPacket.xUDPHeader ) ) ) ||
-				( uxLength > ( ( size_t ) ipconfigNETWORK_MTU - ( size_t ) uxIPHeaderLength ) ) )
+				( uxLength > ( ( size_t ) ipMAX_IP_PACKET_LENGTH - ( size_t ) uxIPHeaderLength ) ) )
 			{
 				/* For incoming packets, the length is out of bound: either
 				too short or too long. For outgoing packets, there is a 
@@ -2280,7 +3434,7 @@ BaseType_t location = 0;
 		ulLength -= ( ( uint16_t ) uxIPHeaderLength ); /* normally minus 20 */
 
 		if( ( ulLength < ( ( uint32_t ) sizeof( pxProtPack->xUDPPacket.xUDPHeader ) ) ) ||
-			( ulLength > ( ( uint32_t ) ipconfigNETWORK_MTU - ( uint32_t ) uxIPHeaderLength ) ) )
+			( ulLength > ( ( uint32_t ) ipMAX_IP_PACKET_LENGTH - ( uint32_t ) uxIPHeaderLength ) ) )
 		{
 			#if( ipconfigHAS_DEBUG_PRINTF != 0 )
 			{
@@ -2582,10 +3736,15 @@ EthernetHeader_t *pxEthernetHeader;
 
 		/* Swap source and destination MAC addresses. */
 		( void ) memcpy( &( pxEthernetHeader->xDestinationAddress ), &( pxEthernetHeader->xSourceAddress ), sizeof( pxEthernetHeader->xDestinationAddress ) );
-		( void ) memcpy( &( pxEthernetHeader->xSourceAddress) , ipLOCAL_MAC_ADDRESS, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
+		( void ) memcpy( &( pxEthernetHeader->xSourceAddress) , ipBUFFER_MAC_ADDRESS( pxNetworkBuffer ), ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
 
-		/* Send! */
-		( void ) xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
+		#if( ipconfigUSE_LOOPBACK != 0 )
+		if( xLoopbackOutput( pxNetworkBuffer, xReleaseAfterSend ) == pdFALSE )
+		#endif
+		{
+			/* Send! */
+			( void ) ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend );
+		}
 	}
 }
 /*-----------------------------------------------------------*/
@@ -2667,6 +3826,23 @@ EthernetHeader_t *pxEthernetHeader;
 			}
 		}
 		#endif /* ipconfigCHECK_IP_QUEUE_SPACE */
+
+		#if ( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+		{
+			static UBaseType_t uxLastHighWater[ eIPEventClassCount ];
+			UBaseType_t uxHighControl, uxHighData;
+
+			( void ) uxGetIPEventQueueDepth( eIPEventClassControl, &uxHighControl );
+			( void ) uxGetIPEventQueueDepth( eIPEventClassData, &uxHighData );
+
+			if( ( uxLastHighWater[ eIPEventClassControl ] != uxHighControl ) || ( uxLastHighWater[ eIPEventClassData ] != uxHighData ) )
+			{
+				uxLastHighWater[ eIPEventClassControl ] = uxHighControl;
+				uxLastHighWater[ eIPEventClassData ] = uxHighData;
+				FreeRTOS_printf( ( "Event queues: highest control %lu data %lu\n", uxHighControl, uxHighData ) );
+			}
+		}
+		#endif /* ipconfigUSE_PRIORITY_EVENT_QUEUES */
 	}
 #endif /* ( ipconfigHAS_PRINTF != 0 ) */
 /*-----------------------------------------------------------*/
@@ -2682,24 +3858,30 @@ void FreeRTOS_SetIPAddress( uint32_t ulIPAddress )
 {
 	/* Sets the IP address of the NIC. */
 	*ipLOCAL_IP_ADDRESS_POINTER = ulIPAddress;
+
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+		vRouteInvalidateCaches();
+	}
+	#endif /* ipconfigUSE_ROUTING */
 }
 /*-----------------------------------------------------------*/
 
 uint32_t FreeRTOS_GetGatewayAddress( void )
 {
-	return xNetworkAddressing.ulGatewayAddress;
+	return pxIPStack->xNetworkAddressing.ulGatewayAddress;
 }
 /*-----------------------------------------------------------*/
 
 uint32_t FreeRTOS_GetDNSServerAddress( void )
 {
-	return xNetworkAddressing.ulDNSServerAddress;
+	return pxIPStack->xNetworkAddressing.ulDNSServerAddress;
 }
 /*-----------------------------------------------------------*/
 
 uint32_t FreeRTOS_GetNetmask( void )
 {
-	return xNetworkAddressing.ulNetMask;
+	return pxIPStack->xNetworkAddressing.ulNetMask;
 }
 /*-----------------------------------------------------------*/
 
@@ -2718,13 +3900,19 @@ const uint8_t * FreeRTOS_GetMACAddress( void )
 
 void FreeRTOS_SetNetmask ( uint32_t ulNetmask )
 {
-	xNetworkAddressing.ulNetMask = ulNetmask;
+	pxIPStack->xNetworkAddressing.ulNetMask = ulNetmask;
+
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+		vRouteInvalidateCaches();
+	}
+	#endif /* ipconfigUSE_ROUTING */
 }
 /*-----------------------------------------------------------*/
 
 void FreeRTOS_SetGatewayAddress ( uint32_t ulGatewayAddress )
 {
-	xNetworkAddressing.ulGatewayAddress = ulGatewayAddress;
+	pxIPStack->xNetworkAddressing.ulGatewayAddress = ulGatewayAddress;
 }
 /*-----------------------------------------------------------*/
 
@@ -2733,11 +3921,11 @@ void FreeRTOS_SetGatewayAddress ( uint32_t ulGatewayAddress )
 	{
 		if( xEnableState != pdFALSE )
 		{
-			xDHCPTimer.bActive = pdTRUE_UNSIGNED;
+			pxIPStack->xDHCPTimer.bActive = pdTRUE_UNSIGNED;
 		}
 		else
 		{
-			xDHCPTimer.bActive = pdFALSE_UNSIGNED;
+			pxIPStack->xDHCPTimer.bActive = pdFALSE_UNSIGNED;
 		}
 	}
 #endif /* ipconfigUSE_DHCP */
@@ -2746,7 +3934,7 @@ void FreeRTOS_SetGatewayAddress ( uint32_t ulGatewayAddress )
 #if( ipconfigUSE_DHCP == 1 )
 	void vIPReloadDHCPTimer( uint32_t ulLeaseTime )
 	{
-		prvIPTimerReload( &xDHCPTimer, ulLeaseTime );
+		prvIPTimerReload( &pxIPStack->xDHCPTimer, ulLeaseTime );
 	}
 #endif /* ipconfigUSE_DHCP */
 /*-----------------------------------------------------------*/
@@ -2756,11 +3944,11 @@ void FreeRTOS_SetGatewayAddress ( uint32_t ulGatewayAddress )
 	{
 		if( xEnableState != 0 )
 		{
-			xDNSTimer.bActive = pdTRUE;
+			pxIPStack->xDNSTimer.bActive = pdTRUE;
 		}
 		else
 		{
-			xDNSTimer.bActive = pdFALSE;
+			pxIPStack->xDNSTimer.bActive = pdFALSE;
 		}
 	}
 #endif /* ipconfigUSE_DHCP */
@@ -2769,30 +3957,64 @@ void FreeRTOS_SetGatewayAddress ( uint32_t ulGatewayAddress )
 #if( ipconfigDNS_USE_CALLBACKS != 0 )
 	void vIPReloadDNSTimer( uint32_t ulCheckTime )
 	{
-		prvIPTimerReload( &xDNSTimer, ulCheckTime );
+		prvIPTimerReload( &pxIPStack->xDNSTimer, ulCheckTime );
 	}
 #endif /* ipconfigDNS_USE_CALLBACKS != 0 */
 /*-----------------------------------------------------------*/
 
 BaseType_t xIPIsNetworkTaskReady( void )
 {
-	return xIPTaskInitialised;
+	return pxIPStack->xIPTaskInitialised;
 }
 /*-----------------------------------------------------------*/
 
 BaseType_t FreeRTOS_IsNetworkUp( void )
 {
-	return xNetworkUp;
+	return pxIPStack->xNetworkUp;
 }
 /*-----------------------------------------------------------*/
 
 #if( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
 	UBaseType_t uxGetMinimumIPQueueSpace( void )
 	{
-		return uxQueueMinimumSpace;
+		return pxIPStack->uxQueueMinimumSpace;
 	}
 #endif
 /*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+	UBaseType_t uxGetIPEventQueueDepth( eIPEventClass_t eClass, UBaseType_t *puxHighWater )
+	{
+	UBaseType_t uxReturn = 0U;
+
+		if( ( eClass == eIPEventClassControl ) || ( eClass == eIPEventClassData ) )
+		{
+			if( eClass == eIPEventClassControl )
+			{
+				if( pxIPStack->xNetworkControlQueue != NULL )
+				{
+					uxReturn = uxQueueMessagesWaiting( pxIPStack->xNetworkControlQueue );
+				}
+			}
+			else if( pxIPStack->xNetworkEventQueue != NULL )
+			{
+				uxReturn = uxQueueMessagesWaiting( pxIPStack->xNetworkEventQueue );
+			}
+			else
+			{
+				/* Not initialised yet. */
+			}
+
+			if( puxHighWater != NULL )
+			{
+				*puxHighWater = pxIPStack->uxEventQueueHighWater[ eClass ];
+			}
+		}
+
+		return uxReturn;
+	}
+#endif /* ipconfigUSE_PRIORITY_EVENT_QUEUES */
+/*-----------------------------------------------------------*/
 /* Utility function: Convert error number to a human readable
  * string. Decalartion in FreeRTOS_errno_TCP.h. */
 const char *FreeRTOS_strerror_r( BaseType_t xErrnum, char *pcBuffer, size_t uxLength )
@@ -2841,3 +4063,8 @@ const char *pcName;
 	#include "aws_freertos_ip_verification_access_ip_define.h"
 #endif
 
+/* Provide access to private members for benchmarking. */
+#ifdef FREERTOS_TCP_ENABLE_BENCHMARK
+	#include "freertos_tcp_bench_access_ip_define.h"
+#endif
+
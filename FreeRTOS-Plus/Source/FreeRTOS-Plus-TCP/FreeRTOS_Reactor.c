@@ -0,0 +1,512 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * A reactor for sockets: a fixed pool of worker tasks calls the handlers of
+ * registered sockets when the IP-task reports events for them, or when their
+ * timer expires.  A socket that has events is put in a ready list, a counting
+ * semaphore wakes up a worker.  The lists are protected by suspending the
+ * scheduler, as the IP-task already does for the lists of bound sockets.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_IP_Stack.h"
+
+#include "FreeRTOSIPConfigDefaults.h"
+
+/* Exclude the entire file if the reactor is not enabled. */
+#if( ipconfigUSE_SOCKET_REACTOR != 0 )
+
+#if( configUSE_COUNTING_SEMAPHORES == 0 )
+	#error configUSE_COUNTING_SEMAPHORES must be 1 when ipconfigUSE_SOCKET_REACTOR is used
+#endif
+
+/*
+ * The task body of the workers.
+ */
+static void prvReactorTask( void *pvParameters );
+
+/*
+ * Add events to a socket, and put it in the ready list unless it is already
+ * there or being handled.  Must be called with the scheduler suspended.
+ * Returns pdTRUE when a worker must be woken up.
+ */
+static BaseType_t prvReactorAddEvents( FreeRTOS_Socket_t *pxSocket, EventBits_t xEvents );
+
+/*
+ * Take the first socket from the ready list, together with its events.
+ * Returns NULL when the list is empty.
+ */
+static FreeRTOS_Socket_t *prvReactorTake( EventBits_t *pxEvents );
+
+/*
+ * Called after a handler has returned: put the socket back in the ready list
+ * if new events arrived in the mean time.
+ */
+static void prvReactorDone( FreeRTOS_Socket_t *pxSocket );
+
+/*
+ * Move the sockets whose timer has expired to the ready list.  Returns the
+ * number of ticks until the next timer expires, or portMAX_DELAY.
+ */
+static TickType_t prvReactorCheckTimers( void );
+
+/*
+ * The events that a socket already has when it gets registered.
+ */
+static EventBits_t prvReactorInitialEvents( FreeRTOS_Socket_t *pxSocket );
+
+/*-----------------------------------------------------------*/
+
+/* Registered sockets that have events, waiting for a worker. */
+static List_t xReadyList;
+
+/* Registered sockets that have a running timer. */
+static List_t xTimerList;
+
+/* Given once for every socket that is put in the ready list. */
+static SemaphoreHandle_t xReactorSemaphore = NULL;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_ReactorInit( void )
+{
+BaseType_t xReturn = pdPASS;
+UBaseType_t uxIndex;
+
+	configASSERT( xReactorSemaphore == NULL );
+
+	/* vSocketWakeUpUser() passes the eSOCKET_* bits unchanged. */
+	configASSERT( FREERTOS_REACTOR_RECEIVE == ( EventBits_t ) eSOCKET_RECEIVE );
+	configASSERT( FREERTOS_REACTOR_INTR == ( EventBits_t ) eSOCKET_INTR );
+	configASSERT( ( FREERTOS_REACTOR_TIMEOUT & ( EventBits_t ) eSOCKET_ALL ) == 0U );
+
+	vListInitialise( &xReadyList );
+	vListInitialise( &xTimerList );
+
+	/* The workers empty the ready list each time they wake up, so a count
+	higher than the number of workers is not needed. */
+	xReactorSemaphore = xSemaphoreCreateCounting( ( UBaseType_t ) ipconfigREACTOR_WORKER_COUNT, 0U );
+
+	if( xReactorSemaphore == NULL )
+	{
+		xReturn = pdFAIL;
+	}
+	else
+	{
+		for( uxIndex = 0U; uxIndex < ( UBaseType_t ) ipconfigREACTOR_WORKER_COUNT; uxIndex++ )
+		{
+			if( xTaskCreate( prvReactorTask,
+							 "Reactor",
+							 ( uint16_t ) ipconfigREACTOR_TASK_STACK_SIZE_WORDS,
+							 ( void * ) pxIPStack,
+							 ( UBaseType_t ) ipconfigREACTOR_TASK_PRIORITY,
+							 NULL ) != pdPASS )
+			{
+				FreeRTOS_debug_printf( ( "FreeRTOS_ReactorInit: worker %lu could not be created\n", uxIndex ) );
+				xReturn = pdFAIL;
+				break;
+			}
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static EventBits_t prvReactorInitialEvents( FreeRTOS_Socket_t *pxSocket )
+{
+EventBits_t xEvents = 0U;
+
+	if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_UDP )
+	{
+		if( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) != 0U )
+		{
+			xEvents |= FREERTOS_REACTOR_RECEIVE;
+		}
+	}
+	#if( ipconfigUSE_TCP == 1 )
+	else
+	{
+		if( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eTCP_LISTEN )
+		{
+			/* FreeRTOS_accept() will tell if there is a client. */
+			xEvents |= FREERTOS_REACTOR_ACCEPT;
+		}
+		else if( FreeRTOS_rx_size( pxSocket ) > 0 )
+		{
+			xEvents |= FREERTOS_REACTOR_RECEIVE;
+		}
+		else
+		{
+			/* Nothing to read yet. */
+		}
+	}
+	#endif /* ipconfigUSE_TCP */
+
+	return xEvents;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_ReactorRegister( Socket_t xSocket, FOnSocketReady_t pxHandler, void *pvContext )
+{
+FreeRTOS_Socket_t *pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, xSocket );
+BaseType_t xReturn = -pdFREERTOS_ERRNO_EINVAL;
+BaseType_t xWakeUp = pdFALSE;
+EventBits_t xEvents;
+
+	if( ( xReactorSemaphore != NULL ) && ( pxSocket != NULL ) && ( pxSocket != FREERTOS_INVALID_SOCKET ) && ( pxHandler != NULL ) )
+	{
+		xEvents = prvReactorInitialEvents( pxSocket );
+
+		vTaskSuspendAll();
+		{
+			if( pxSocket->pxReactorHandler == NULL )
+			{
+				vListInitialiseItem( &( pxSocket->xReactorReadyItem ) );
+				listSET_LIST_ITEM_OWNER( &( pxSocket->xReactorReadyItem ), ipPOINTER_CAST( void *, pxSocket ) );
+				vListInitialiseItem( &( pxSocket->xReactorTimerItem ) );
+				listSET_LIST_ITEM_OWNER( &( pxSocket->xReactorTimerItem ), ipPOINTER_CAST( void *, pxSocket ) );
+			}
+			pxSocket->pxReactorHandler = pxHandler;
+			pxSocket->pvReactorContext = pvContext;
+
+			if( xEvents != 0U )
+			{
+				xWakeUp = prvReactorAddEvents( pxSocket, xEvents );
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		if( xWakeUp != pdFALSE )
+		{
+			( void ) xSemaphoreGive( xReactorSemaphore );
+		}
+		xReturn = 0;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_ReactorUnregister( Socket_t xSocket )
+{
+FreeRTOS_Socket_t *pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, xSocket );
+BaseType_t xReturn;
+
+	if( ( pxSocket == NULL ) || ( pxSocket == FREERTOS_INVALID_SOCKET ) )
+	{
+		xReturn = -pdFREERTOS_ERRNO_EINVAL;
+	}
+	else
+	{
+		vTaskSuspendAll();
+		{
+			if( ( pxSocket->xReactorWorker != NULL ) && ( pxSocket->xReactorWorker != xTaskGetCurrentTaskHandle() ) )
+			{
+				/* Another worker is running the handler. */
+				xReturn = -pdFREERTOS_ERRNO_EBUSY;
+			}
+			else
+			{
+				vReactorSocketClose( pxSocket );
+				xReturn = 0;
+			}
+		}
+		( void ) xTaskResumeAll();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_ReactorSetTimer( Socket_t xSocket, TickType_t xTicks )
+{
+FreeRTOS_Socket_t *pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, xSocket );
+BaseType_t xReturn = -pdFREERTOS_ERRNO_EINVAL;
+
+	if( ( pxSocket != NULL ) && ( pxSocket != FREERTOS_INVALID_SOCKET ) && ( pxSocket->pxReactorHandler != NULL ) )
+	{
+		vTaskSuspendAll();
+		{
+			if( listLIST_ITEM_CONTAINER( &( pxSocket->xReactorTimerItem ) ) != NULL )
+			{
+				( void ) uxListRemove( &( pxSocket->xReactorTimerItem ) );
+			}
+
+			if( xTicks != 0U )
+			{
+				pxSocket->xReactorTimerStart = xTaskGetTickCount();
+				pxSocket->xReactorTimerDelay = xTicks;
+				vListInsertEnd( &xTimerList, &( pxSocket->xReactorTimerItem ) );
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		if( xTicks != 0U )
+		{
+			/* Let a worker recalculate how long it may sleep. */
+			( void ) xSemaphoreGive( xReactorSemaphore );
+		}
+		xReturn = 0;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReactorAddEvents( FreeRTOS_Socket_t *pxSocket, EventBits_t xEvents )
+{
+BaseType_t xWakeUp = pdFALSE;
+
+	pxSocket->xReactorEvents |= xEvents;
+
+	if( pxSocket->xReactorWorker != NULL )
+	{
+		/* The handler is running, the worker will queue the socket again
+		when it returns. */
+		pxSocket->xReactorPending = pdTRUE;
+	}
+	else if( listLIST_ITEM_CONTAINER( &( pxSocket->xReactorReadyItem ) ) == NULL )
+	{
+		vListInsertEnd( &xReadyList, &( pxSocket->xReactorReadyItem ) );
+		xWakeUp = pdTRUE;
+	}
+	else
+	{
+		/* Already waiting for a worker. */
+	}
+
+	return xWakeUp;
+}
+/*-----------------------------------------------------------*/
+
+void vReactorSocketEvent( FreeRTOS_Socket_t *pxSocket, EventBits_t xEvents )
+{
+BaseType_t xWakeUp = pdFALSE;
+
+	if( ( pxSocket->pxReactorHandler != NULL ) && ( xEvents != 0U ) )
+	{
+		vTaskSuspendAll();
+		{
+			xWakeUp = prvReactorAddEvents( pxSocket, xEvents );
+		}
+		( void ) xTaskResumeAll();
+
+		if( xWakeUp != pdFALSE )
+		{
+			( void ) xSemaphoreGive( xReactorSemaphore );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vReactorSocketClose( FreeRTOS_Socket_t *pxSocket )
+{
+	if( pxSocket->pxReactorHandler != NULL )
+	{
+		vTaskSuspendAll();
+		{
+			if( listLIST_ITEM_CONTAINER( &( pxSocket->xReactorReadyItem ) ) != NULL )
+			{
+				( void ) uxListRemove( &( pxSocket->xReactorReadyItem ) );
+			}
+
+			if( listLIST_ITEM_CONTAINER( &( pxSocket->xReactorTimerItem ) ) != NULL )
+			{
+				( void ) uxListRemove( &( pxSocket->xReactorTimerItem ) );
+			}
+
+			pxSocket->pxReactorHandler = NULL;
+			pxSocket->xReactorEvents = 0U;
+			pxSocket->xReactorPending = pdFALSE;
+		}
+		( void ) xTaskResumeAll();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static FreeRTOS_Socket_t *prvReactorTake( EventBits_t *pxEvents )
+{
+FreeRTOS_Socket_t *pxSocket = NULL;
+
+	vTaskSuspendAll();
+	{
+		if( listCURRENT_LIST_LENGTH( &xReadyList ) != 0U )
+		{
+			pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, listGET_OWNER_OF_HEAD_ENTRY( &xReadyList ) );
+			( void ) uxListRemove( &( pxSocket->xReactorReadyItem ) );
+
+			*pxEvents = pxSocket->xReactorEvents;
+			pxSocket->xReactorEvents = 0U;
+			pxSocket->xReactorPending = pdFALSE;
+			pxSocket->xReactorWorker = xTaskGetCurrentTaskHandle();
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	return pxSocket;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReactorDone( FreeRTOS_Socket_t *pxSocket )
+{
+BaseType_t xWakeUp = pdFALSE;
+
+	vTaskSuspendAll();
+	{
+		pxSocket->xReactorWorker = NULL;
+
+		if( ( pxSocket->xReactorPending != pdFALSE ) && ( pxSocket->pxReactorHandler != NULL ) )
+		{
+			pxSocket->xReactorPending = pdFALSE;
+			vListInsertEnd( &xReadyList, &( pxSocket->xReactorReadyItem ) );
+			xWakeUp = pdTRUE;
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	if( xWakeUp != pdFALSE )
+	{
+		( void ) xSemaphoreGive( xReactorSemaphore );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static TickType_t prvReactorCheckTimers( void )
+{
+const ListItem_t *pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xTimerList ) );
+ListItem_t *pxIterator;
+ListItem_t *pxNext;
+FreeRTOS_Socket_t *pxSocket;
+TickType_t xNow, xElapsed, xNextTimeout = portMAX_DELAY;
+BaseType_t xWakeUp = pdFALSE;
+
+	vTaskSuspendAll();
+	{
+		xNow = xTaskGetTickCount();
+
+		for( pxIterator = ( ListItem_t * ) listGET_NEXT( pxEnd );
+			 pxIterator != pxEnd;
+			 pxIterator = pxNext )
+		{
+			/* The item may be removed, remember the next one. */
+			pxNext = ( ListItem_t * ) listGET_NEXT( pxIterator );
+			pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+
+			/* Unsigned arithmetic gives the right answer when the tick count
+			has wrapped around. */
+			xElapsed = xNow - pxSocket->xReactorTimerStart;
+
+			if( xElapsed >= pxSocket->xReactorTimerDelay )
+			{
+				( void ) uxListRemove( pxIterator );
+				if( prvReactorAddEvents( pxSocket, FREERTOS_REACTOR_TIMEOUT ) != pdFALSE )
+				{
+					xWakeUp = pdTRUE;
+				}
+			}
+			else if( ( pxSocket->xReactorTimerDelay - xElapsed ) < xNextTimeout )
+			{
+				xNextTimeout = pxSocket->xReactorTimerDelay - xElapsed;
+			}
+			else
+			{
+				/* This timer expires later than another one. */
+			}
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	if( xWakeUp != pdFALSE )
+	{
+		/* The calling worker empties the ready list itself, this wakes up
+		another one to share the work. */
+		( void ) xSemaphoreGive( xReactorSemaphore );
+	}
+
+	return xNextTimeout;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReactorTask( void *pvParameters )
+{
+FreeRTOS_Socket_t *pxSocket;
+EventBits_t xEvents = 0U;
+TickType_t xTicksToWait;
+
+	#if( ipconfigIP_STACK_COUNT > 1 )
+	{
+		/* The workers serve the sockets of the stack that was selected by the
+		task that called FreeRTOS_ReactorInit(). */
+		vTaskSetThreadLocalStoragePointer( NULL, ipconfigIP_STACK_TLS_INDEX, pvParameters );
+	}
+	#else
+	{
+		( void ) pvParameters;
+	}
+	#endif
+
+	for( ;; )
+	{
+		xTicksToWait = prvReactorCheckTimers();
+
+		/* Wait until a socket is put in the ready list, or until the next
+		timer expires. */
+		( void ) xSemaphoreTake( xReactorSemaphore, xTicksToWait );
+
+		for( ;; )
+		{
+			pxSocket = prvReactorTake( &xEvents );
+
+			if( pxSocket == NULL )
+			{
+				break;
+			}
+
+			/* The handler and context can not change while this worker
+			owns the socket, unless the handler changes them itself. */
+			if( pxSocket->pxReactorHandler( pxSocket, xEvents, pxSocket->pvReactorContext ) != pdFALSE )
+			{
+				prvReactorDone( pxSocket );
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_SOCKET_REACTOR */
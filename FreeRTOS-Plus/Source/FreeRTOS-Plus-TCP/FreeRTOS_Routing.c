@@ -0,0 +1,736 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Network interfaces, end-points and the routing table.
+ *
+ * The driver of xNetworkInterfaceOutput() and the addresses that were passed to
+ * FreeRTOS_IPInit() form the primary end-point, which is represented by NULL.
+ * It has two implicit routes: one to its own subnet and the default route
+ * through its gateway.  More interfaces are added with
+ * FreeRTOS_AddNetworkInterface(), and they get their addresses from
+ * FreeRTOS_AddEndPoint().
+ *
+ * Each added interface has a reception and a transmission queue.  Its driver
+ * passes received packets to xNetworkInterfaceReceive(), from any task.  The
+ * IP-task takes at most ipconfigINTERFACE_BURST packets from each queue every
+ * time it wakes up.  With more than one IP-stack, the driver task must have
+ * selected its stack with FreeRTOS_SetIPStack().
+ *
+ * A route lookup runs with the scheduler suspended.  Sockets keep the result
+ * in their RouteCache_t, which is only refreshed when the destination changes
+ * or when uxRouteGeneration shows that the routing table was changed.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_IP_Private.h"
+
+#include "FreeRTOSIPConfigDefaults.h"
+
+/* Exclude the entire file if routing is not enabled. */
+#if( ipconfigUSE_ROUTING != 0 )
+
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+#include "FreeRTOS_IP_Stack.h"
+
+/*
+ * Returns the number of leading ones in a netmask, or -1 when the ones are not
+ * contiguous.
+ */
+static BaseType_t prvPrefixLength( uint32_t ulNetMask );
+
+/*
+ * Adds or replaces a route, keeping the table sorted from the longest to the
+ * shortest prefix.  Called with the scheduler suspended.
+ */
+static BaseType_t prvInsertRoute( const Route_t *pxNewRoute );
+
+/*
+ * Returns the first end-point that was added to an interface, or NULL.
+ */
+static NetworkEndPoint_t *prvFirstEndPoint( const NetworkInterface_t *pxInterface );
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvPrefixLength( uint32_t ulNetMask )
+{
+uint32_t ulHostBits = ~FreeRTOS_ntohl( ulNetMask );
+BaseType_t xLength = -1;
+
+	/* The host part must be a series of ones at the right. */
+	if( ( ulHostBits & ( ulHostBits + 1UL ) ) == 0UL )
+	{
+		xLength = 32;
+
+		while( ulHostBits != 0UL )
+		{
+			ulHostBits >>= 1;
+			xLength--;
+		}
+	}
+
+	return xLength;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvInsertRoute( const Route_t *pxNewRoute )
+{
+BaseType_t xReturn = 0;
+UBaseType_t uxIndex;
+UBaseType_t uxPosition = pxIPStack->uxRouteCount;
+
+	for( uxIndex = 0U; uxIndex < pxIPStack->uxRouteCount; uxIndex++ )
+	{
+		if( ( pxIPStack->xRoutes[ uxIndex ].ulDestination == pxNewRoute->ulDestination ) &&
+			( pxIPStack->xRoutes[ uxIndex ].ulNetMask == pxNewRoute->ulNetMask ) )
+		{
+			/* Replace the existing route, the prefix is the same. */
+			uxPosition = uxIndex;
+			break;
+		}
+	}
+
+	if( uxPosition < pxIPStack->uxRouteCount )
+	{
+		pxIPStack->xRoutes[ uxPosition ] = *pxNewRoute;
+	}
+	else if( pxIPStack->uxRouteCount >= ( UBaseType_t ) ipconfigROUTING_MAX_ROUTES )
+	{
+		xReturn = -pdFREERTOS_ERRNO_ENOSPC;
+	}
+	else
+	{
+		/* Insert in front of the first route with a shorter prefix. */
+		for( uxPosition = 0U; uxPosition < pxIPStack->uxRouteCount; uxPosition++ )
+		{
+			if( pxIPStack->xRoutes[ uxPosition ].uxPrefixLength < pxNewRoute->uxPrefixLength )
+			{
+				break;
+			}
+		}
+
+		for( uxIndex = pxIPStack->uxRouteCount; uxIndex > uxPosition; uxIndex-- )
+		{
+			pxIPStack->xRoutes[ uxIndex ] = pxIPStack->xRoutes[ uxIndex - 1U ];
+		}
+
+		pxIPStack->xRoutes[ uxPosition ] = *pxNewRoute;
+		pxIPStack->uxRouteCount++;
+	}
+
+	if( xReturn == 0 )
+	{
+		pxIPStack->uxRouteGeneration++;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_AddRoute( uint32_t ulDestination, uint32_t ulNetMask, uint32_t ulGateway, NetworkEndPoint_t *pxEndPoint )
+{
+BaseType_t xReturn;
+BaseType_t xPrefixLength = prvPrefixLength( ulNetMask );
+Route_t xRoute;
+
+	if( xPrefixLength < 0 )
+	{
+		xReturn = -pdFREERTOS_ERRNO_EINVAL;
+	}
+	else
+	{
+		xRoute.ulDestination = ulDestination & ulNetMask;
+		xRoute.ulNetMask = ulNetMask;
+		xRoute.ulGateway = ulGateway;
+		xRoute.pxEndPoint = pxEndPoint;
+		xRoute.uxPrefixLength = ( UBaseType_t ) xPrefixLength;
+
+		vTaskSuspendAll();
+		{
+			xReturn = prvInsertRoute( &xRoute );
+		}
+		( void ) xTaskResumeAll();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_RemoveRoute( uint32_t ulDestination, uint32_t ulNetMask )
+{
+BaseType_t xReturn = -pdFREERTOS_ERRNO_ENOENT;
+UBaseType_t uxIndex;
+
+	vTaskSuspendAll();
+	{
+		for( uxIndex = 0U; uxIndex < pxIPStack->uxRouteCount; uxIndex++ )
+		{
+			if( xReturn == 0 )
+			{
+				/* Move the rest of the table up. */
+				pxIPStack->xRoutes[ uxIndex - 1U ] = pxIPStack->xRoutes[ uxIndex ];
+			}
+			else if( ( pxIPStack->xRoutes[ uxIndex ].ulDestination == ( ulDestination & ulNetMask ) ) &&
+					 ( pxIPStack->xRoutes[ uxIndex ].ulNetMask == ulNetMask ) )
+			{
+				xReturn = 0;
+			}
+			else
+			{
+				/* Not this route. */
+			}
+		}
+
+		if( xReturn == 0 )
+		{
+			pxIPStack->uxRouteCount--;
+			pxIPStack->uxRouteGeneration++;
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_AddNetworkInterface( NetworkInterface_t *pxInterface )
+{
+BaseType_t xReturn;
+NetworkInterface_t **ppxLast;
+
+	if( ( pxInterface == NULL ) || ( pxInterface->pfInitialise == NULL ) || ( pxInterface->pfOutput == NULL ) )
+	{
+		xReturn = -pdFREERTOS_ERRNO_EINVAL;
+	}
+	else
+	{
+		pxInterface->xInterfaceUp = pdFALSE;
+		vListInitialise( &( pxInterface->xRxQueue ) );
+		vListInitialise( &( pxInterface->xTxQueue ) );
+		( void ) memset( &( pxInterface->xStats ), 0, sizeof( pxInterface->xStats ) );
+		pxInterface->pxNext = NULL;
+
+		/* The IP-task walks through the list without locking, the interface
+		is complete before it is linked. */
+		vTaskSuspendAll();
+		{
+			for( ppxLast = &( pxIPStack->pxInterfaces ); *ppxLast != NULL; ppxLast = &( ( *ppxLast )->pxNext ) )
+			{
+			}
+			*ppxLast = pxInterface;
+		}
+		( void ) xTaskResumeAll();
+
+		/* Let the IP-task call pfInitialise(). */
+		( void ) xSendEventToIPTask( eInterfaceEvent );
+		xReturn = 0;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_AddEndPoint( NetworkEndPoint_t *pxEndPoint,
+	NetworkInterface_t *pxInterface,
+	const uint8_t ucIPAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+	const uint8_t ucNetMask[ ipIP_ADDRESS_LENGTH_BYTES ],
+	const uint8_t ucMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ] )
+{
+BaseType_t xReturn;
+BaseType_t xPrefixLength;
+NetworkEndPoint_t **ppxLast;
+Route_t xRoute;
+
+	if( ( pxEndPoint == NULL ) || ( pxInterface == NULL ) )
+	{
+		xReturn = -pdFREERTOS_ERRNO_EINVAL;
+	}
+	else
+	{
+		pxEndPoint->ulIPAddress = FreeRTOS_inet_addr_quick( ucIPAddress[ 0 ], ucIPAddress[ 1 ], ucIPAddress[ 2 ], ucIPAddress[ 3 ] );
+		pxEndPoint->ulNetMask = FreeRTOS_inet_addr_quick( ucNetMask[ 0 ], ucNetMask[ 1 ], ucNetMask[ 2 ], ucNetMask[ 3 ] );
+		pxEndPoint->ulBroadcastAddress = pxEndPoint->ulIPAddress | ~( pxEndPoint->ulNetMask );
+		( void ) memcpy( pxEndPoint->xMACAddress.ucBytes, ucMACAddress, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
+		pxEndPoint->pxInterface = pxInterface;
+		pxEndPoint->pxNext = NULL;
+
+		xPrefixLength = prvPrefixLength( pxEndPoint->ulNetMask );
+
+		if( xPrefixLength < 0 )
+		{
+			xReturn = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else
+		{
+			/* The route to the subnet of the end-point. */
+			xRoute.ulDestination = pxEndPoint->ulIPAddress & pxEndPoint->ulNetMask;
+			xRoute.ulNetMask = pxEndPoint->ulNetMask;
+			xRoute.ulGateway = 0UL;
+			xRoute.pxEndPoint = pxEndPoint;
+			xRoute.uxPrefixLength = ( UBaseType_t ) xPrefixLength;
+
+			vTaskSuspendAll();
+			{
+				xReturn = prvInsertRoute( &xRoute );
+
+				if( xReturn == 0 )
+				{
+					for( ppxLast = &( pxIPStack->pxEndPoints ); *ppxLast != NULL; ppxLast = &( ( *ppxLast )->pxNext ) )
+					{
+					}
+					*ppxLast = pxEndPoint;
+				}
+			}
+			( void ) xTaskResumeAll();
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vRouteLookup( RouteCache_t *pxCache, uint32_t ulDestination )
+{
+const Route_t *pxRoute = NULL;
+UBaseType_t uxIndex;
+uint32_t ulNetMask;
+
+	vTaskSuspendAll();
+	{
+		/* The table is sorted, the first match has the longest prefix. */
+		for( uxIndex = 0U; ( uxIndex < pxIPStack->uxRouteCount ) && ( pxRoute == NULL ); uxIndex++ )
+		{
+			if( ( ulDestination & pxIPStack->xRoutes[ uxIndex ].ulNetMask ) == pxIPStack->xRoutes[ uxIndex ].ulDestination )
+			{
+				pxRoute = &( pxIPStack->xRoutes[ uxIndex ] );
+			}
+		}
+
+		/* By default, the packet leaves through the primary end-point.
+		eARPGetCacheEntry() will send it to the gateway if the destination is
+		not on the local subnet. */
+		pxCache->ulDestination = ulDestination;
+		pxCache->ulNextHop = ulDestination;
+		pxCache->pxEndPoint = NULL;
+		pxCache->uxGeneration = pxIPStack->uxRouteGeneration;
+
+		if( ( ulDestination == ipBROADCAST_IP_ADDRESS ) || ( xIsIPv4Multicast( ulDestination ) != pdFALSE ) )
+		{
+			/* Broadcasts and multicasts (like DHCP and LLMNR) use the primary
+			end-point. */
+		}
+		else if( pxRoute != NULL )
+		{
+			ulNetMask = pxIPStack->xNetworkAddressing.ulNetMask;
+
+			if( ( *ipLOCAL_IP_ADDRESS_POINTER != 0UL ) &&
+				( ( ( ulDestination ^ *ipLOCAL_IP_ADDRESS_POINTER ) & ulNetMask ) == 0UL ) &&
+				( prvPrefixLength( ulNetMask ) > ( BaseType_t ) pxRoute->uxPrefixLength ) )
+			{
+				/* The subnet of the primary end-point is more specific. */
+			}
+			else
+			{
+				pxCache->pxEndPoint = pxRoute->pxEndPoint;
+
+				if( pxRoute->ulGateway != 0UL )
+				{
+					pxCache->ulNextHop = pxRoute->ulGateway;
+				}
+			}
+		}
+		else
+		{
+			/* One of the implicit routes of the primary end-point. */
+		}
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void vRouteCacheUpdate( RouteCache_t *pxCache, uint32_t ulDestination )
+{
+	if( ( pxCache->ulDestination != ulDestination ) || ( pxCache->uxGeneration != pxIPStack->uxRouteGeneration ) )
+	{
+		vRouteLookup( pxCache, ulDestination );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vRouteNetworkBuffer( NetworkBufferDescriptor_t * const pxNetworkBuffer, uint32_t ulDestination )
+{
+RouteCache_t xRoute;
+
+	vRouteLookup( &xRoute, ulDestination );
+	pxNetworkBuffer->pxEndPoint = xRoute.pxEndPoint;
+	pxNetworkBuffer->ulNextHop = xRoute.ulNextHop;
+}
+/*-----------------------------------------------------------*/
+
+void vRouteInvalidateCaches( void )
+{
+	/* vRouteLookup() compares the primary subnet with the routes. */
+	vTaskSuspendAll();
+	{
+		pxIPStack->uxRouteGeneration++;
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+static NetworkEndPoint_t *prvFirstEndPoint( const NetworkInterface_t *pxInterface )
+{
+NetworkEndPoint_t *pxEndPoint;
+
+	for( pxEndPoint = pxIPStack->pxEndPoints; pxEndPoint != NULL; pxEndPoint = pxEndPoint->pxNext )
+	{
+		if( pxEndPoint->pxInterface == pxInterface )
+		{
+			break;
+		}
+	}
+
+	return pxEndPoint;
+}
+/*-----------------------------------------------------------*/
+
+NetworkEndPoint_t *pxRoutingFindEndPoint( uint32_t ulIPAddress )
+{
+NetworkEndPoint_t *pxEndPoint;
+
+	for( pxEndPoint = pxIPStack->pxEndPoints; pxEndPoint != NULL; pxEndPoint = pxEndPoint->pxNext )
+	{
+		if( ( pxEndPoint->ulIPAddress == ulIPAddress ) && ( ulIPAddress != 0UL ) )
+		{
+			break;
+		}
+	}
+
+	return pxEndPoint;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRoutingIsBroadcast( uint32_t ulIPAddress )
+{
+const NetworkEndPoint_t *pxEndPoint;
+BaseType_t xReturn = pdFALSE;
+
+	for( pxEndPoint = pxIPStack->pxEndPoints; ( pxEndPoint != NULL ) && ( xReturn == pdFALSE ); pxEndPoint = pxEndPoint->pxNext )
+	{
+		if( pxEndPoint->ulBroadcastAddress == ulIPAddress )
+		{
+			xReturn = pdTRUE;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRoutingIsOnLink( uint32_t ulIPAddress )
+{
+const NetworkEndPoint_t *pxEndPoint;
+BaseType_t xReturn = pdFALSE;
+
+	for( pxEndPoint = pxIPStack->pxEndPoints; ( pxEndPoint != NULL ) && ( xReturn == pdFALSE ); pxEndPoint = pxEndPoint->pxNext )
+	{
+		if( ( ( ulIPAddress ^ pxEndPoint->ulIPAddress ) & pxEndPoint->ulNetMask ) == 0UL )
+		{
+			xReturn = pdTRUE;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRoutingIsEndPointMAC( const MACAddress_t *pxMACAddress )
+{
+const NetworkEndPoint_t *pxEndPoint;
+BaseType_t xReturn = pdFALSE;
+
+	for( pxEndPoint = pxIPStack->pxEndPoints; ( pxEndPoint != NULL ) && ( xReturn == pdFALSE ); pxEndPoint = pxEndPoint->pxNext )
+	{
+		if( memcmp( pxEndPoint->xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( MACAddress_t ) ) == 0 )
+		{
+			xReturn = pdTRUE;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vRoutingReceive( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+const IPPacket_t *pxIPPacket = ipPOINTER_CAST( const IPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+const ARPPacket_t *pxARPPacket = ipPOINTER_CAST( const ARPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+NetworkEndPoint_t *pxEndPoint = NULL;
+
+	if( ( pxNetworkBuffer->xDataLength >= sizeof( IPPacket_t ) ) &&
+		( pxIPPacket->xEthernetHeader.usFrameType == ipIPv4_FRAME_TYPE ) )
+	{
+		pxEndPoint = pxRoutingFindEndPoint( pxIPPacket->xIPHeader.ulDestinationIPAddress );
+	}
+	else if( ( pxNetworkBuffer->xDataLength >= sizeof( ARPPacket_t ) ) &&
+			 ( pxARPPacket->xEthernetHeader.usFrameType == ipARP_FRAME_TYPE ) )
+	{
+		pxEndPoint = pxRoutingFindEndPoint( pxARPPacket->xARPHeader.ulTargetProtocolAddress );
+	}
+	else
+	{
+		/* Other frames are dropped later on. */
+	}
+
+	if( ( pxEndPoint == NULL ) && ( pxNetworkBuffer->pxInterface != NULL ) )
+	{
+		/* A broadcast or multicast that arrived on an added interface. */
+		pxEndPoint = prvFirstEndPoint( pxNetworkBuffer->pxInterface );
+	}
+
+	pxNetworkBuffer->pxEndPoint = pxEndPoint;
+
+	/* A reply that is made in this buffer must be routed again. */
+	pxNetworkBuffer->ulNextHop = 0UL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRoutingOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+{
+BaseType_t xReturn = pdFALSE;
+BaseType_t xWakeUp = pdFALSE;
+NetworkBufferDescriptor_t *pxUseBuffer = pxNetworkBuffer;
+NetworkInterface_t *pxInterface = NULL;
+
+	if( pxNetworkBuffer->pxEndPoint != NULL )
+	{
+		pxInterface = pxNetworkBuffer->pxEndPoint->pxInterface;
+	}
+
+	if( pxInterface == NULL )
+	{
+		/* The primary end-point. */
+		xReturn = ipNETWORK_DRIVER_OUTPUT( pxNetworkBuffer, xReleaseAfterSend );
+	}
+	else
+	{
+		if( xReleaseAfterSend == pdFALSE )
+		{
+			/* The buffer still belongs to the caller, queue a copy. */
+			pxUseBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+		}
+
+		if( pxUseBuffer != NULL )
+		{
+			/* The driver may be called from any task, the queue is protected
+			with a critical section. */
+			taskENTER_CRITICAL();
+			{
+				if( ( pxInterface->xInterfaceUp != pdFALSE ) &&
+					( listCURRENT_LIST_LENGTH( &( pxInterface->xTxQueue ) ) < ( UBaseType_t ) ipconfigINTERFACE_TX_QUEUE_LENGTH ) )
+				{
+					xWakeUp = ( listCURRENT_LIST_LENGTH( &( pxInterface->xTxQueue ) ) == 0U ) ? pdTRUE : pdFALSE;
+					vListInsertEnd( &( pxInterface->xTxQueue ), &( pxUseBuffer->xBufferListItem ) );
+					xReturn = pdTRUE;
+				}
+				else
+				{
+					pxInterface->xStats.ulTxDropped++;
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			if( xReturn == pdFALSE )
+			{
+				ipSTATS_COUNT_DROP( eIPDropTxQueueFull );
+				vReleaseNetworkBufferAndDescriptor( pxUseBuffer );
+			}
+			else if( ( xWakeUp != pdFALSE ) && ( xIsCallingFromIPTask() == pdFALSE ) )
+			{
+				/* The IP-task passes the packet to the driver as soon as it
+				wakes up. */
+				( void ) xSendEventToIPTask( eInterfaceEvent );
+			}
+			else
+			{
+				/* vRoutingSendQueued() will be called before the IP-task
+				sleeps. */
+			}
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceReceive( NetworkInterface_t *pxInterface, NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+BaseType_t xReturn = pdFAIL;
+BaseType_t xWakeUp = pdFALSE;
+
+	pxNetworkBuffer->pxInterface = pxInterface;
+
+	taskENTER_CRITICAL();
+	{
+		if( listCURRENT_LIST_LENGTH( &( pxInterface->xRxQueue ) ) < ( UBaseType_t ) ipconfigINTERFACE_RX_QUEUE_LENGTH )
+		{
+			/* Only the first packet needs to wake up the IP-task, which does
+			not sleep while packets are waiting. */
+			xWakeUp = ( listCURRENT_LIST_LENGTH( &( pxInterface->xRxQueue ) ) == 0U ) ? pdTRUE : pdFALSE;
+			vListInsertEnd( &( pxInterface->xRxQueue ), &( pxNetworkBuffer->xBufferListItem ) );
+			xReturn = pdPASS;
+		}
+		else
+		{
+			pxInterface->xStats.ulRxDropped++;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( xReturn == pdFAIL )
+	{
+		iptraceETHERNET_RX_EVENT_LOST();
+		ipSTATS_COUNT_DROP( eIPDropEventQueueFull );
+	}
+	else if( xWakeUp != pdFALSE )
+	{
+		( void ) xSendEventToIPTask( eInterfaceEvent );
+	}
+	else
+	{
+		/* The IP-task is awake already. */
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxRoutingGetReceived( NetworkInterface_t *pxInterface )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer = NULL;
+
+	taskENTER_CRITICAL();
+	{
+		if( listCURRENT_LIST_LENGTH( &( pxInterface->xRxQueue ) ) != 0U )
+		{
+			pxNetworkBuffer = ipPOINTER_CAST( NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( &( pxInterface->xRxQueue ) ) );
+			( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( pxNetworkBuffer != NULL )
+	{
+		pxInterface->xStats.ulRxPackets++;
+	}
+
+	return pxNetworkBuffer;
+}
+/*-----------------------------------------------------------*/
+
+void vRoutingSendQueued( void )
+{
+NetworkInterface_t *pxInterface;
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+UBaseType_t uxCount;
+
+	for( pxInterface = pxIPStack->pxInterfaces; pxInterface != NULL; pxInterface = pxInterface->pxNext )
+	{
+		for( uxCount = 0U; uxCount < ( UBaseType_t ) ipconfigINTERFACE_BURST; uxCount++ )
+		{
+			pxNetworkBuffer = NULL;
+
+			taskENTER_CRITICAL();
+			{
+				if( listCURRENT_LIST_LENGTH( &( pxInterface->xTxQueue ) ) != 0U )
+				{
+					pxNetworkBuffer = ipPOINTER_CAST( NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( &( pxInterface->xTxQueue ) ) );
+					( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			if( pxNetworkBuffer == NULL )
+			{
+				break;
+			}
+
+			pxInterface->xStats.ulTxPackets++;
+			( void ) pxInterface->pfOutput( pxInterface, pxNetworkBuffer, pdTRUE );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRoutingPending( void )
+{
+const NetworkInterface_t *pxInterface;
+BaseType_t xReturn = pdFALSE;
+
+	for( pxInterface = pxIPStack->pxInterfaces; ( pxInterface != NULL ) && ( xReturn == pdFALSE ); pxInterface = pxInterface->pxNext )
+	{
+		if( ( listCURRENT_LIST_LENGTH( &( pxInterface->xRxQueue ) ) != 0U ) ||
+			( listCURRENT_LIST_LENGTH( &( pxInterface->xTxQueue ) ) != 0U ) )
+		{
+			xReturn = pdTRUE;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vRoutingInitialiseInterfaces( void )
+{
+NetworkInterface_t *pxInterface;
+
+	for( pxInterface = pxIPStack->pxInterfaces; pxInterface != NULL; pxInterface = pxInterface->pxNext )
+	{
+		if( pxInterface->xInterfaceUp == pdFALSE )
+		{
+			if( pxInterface->pfInitialise( pxInterface ) == pdPASS )
+			{
+				FreeRTOS_printf( ( "vRoutingInitialiseInterfaces: %s is up\n", pxInterface->pcName ) );
+				pxInterface->xInterfaceUp = pdTRUE;
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_ROUTING */
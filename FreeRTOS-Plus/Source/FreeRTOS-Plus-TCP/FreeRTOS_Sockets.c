@@ -39,7 +39,9 @@
 #include "FreeRTOS_Sockets.h"
 #include "FreeRTOS_IP_Private.h"
 #include "FreeRTOS_DNS.h"
+#include "FreeRTOS_IGMP.h"
 #include "NetworkBufferManagement.h"
+#include "FreeRTOS_IP_Stack.h"
 
 /* A tool to measure RAM usage. By default, it is disabled
 and it won't add any code.
@@ -87,6 +89,25 @@ range 1024-65535" excluding those already in use (inbound or outbound). */
 #define sock80_PERCENT						80U
 #define sock100_PERCENT						100U
 
+#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+	/* uxLittleSpace and uxEnoughSpace are defined for an Rx stream of the
+	maximum size.  An elastic stream may be smaller, scale the limits to its
+	actual length. */
+	#define sockRX_WATER_MARK( pxSocket, uxMark )	\
+		( ( ( ( ( uxMark ) * sock100_PERCENT ) / FreeRTOS_max_uint32( 1UL, ( pxSocket )->u.xTCP.uxRxStreamSize ) ) * ( pxSocket )->u.xTCP.rxStream->LENGTH ) / sock100_PERCENT )
+#else
+	#define sockRX_WATER_MARK( pxSocket, uxMark )	( uxMark )
+#endif
+
+#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+	/* The changes of the streams that a socket owner may ask from the IP-task,
+	see prvTCPStreamRequest(). */
+	#define sockSTREAM_REQUEST_NONE			( 0U )
+	#define sockSTREAM_REQUEST_GROW_RX		( 1U )
+	#define sockSTREAM_REQUEST_GROW_TX		( 2U )
+	#define sockSTREAM_REQUEST_RELEASE		( 3U )
+#endif
+
 
 /*-----------------------------------------------------------*/
 
@@ -126,8 +147,41 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	 * Create a txStream or a rxStream, depending on the parameter 'xIsInputStream'
 	 */
 	static StreamBuffer_t *prvTCPCreateStream (FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream );
+
+	/*
+	 * Allocate a stream that can hold at least uxStreamSize bytes, or free it.
+	 */
+	static StreamBuffer_t *prvTCPAllocateStream( size_t uxStreamSize, BaseType_t xIsInputStream );
+	static void prvTCPFreeStream( StreamBuffer_t *pxStream );
 #endif /* ipconfigUSE_TCP == 1 */
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 )
+	/*
+	 * Called by the socket owner: replace a stream with a bigger one, as long
+	 * as the maximum size and the memory budget allow it.
+	 */
+	static void prvTCPGrowStream( FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream, size_t uxWanted );
+
+	/*
+	 * Called by the socket owner: release the streams that are empty and that
+	 * have not been used for ipconfigTCP_STREAM_IDLE_RELEASE_MS.
+	 */
+	static void prvTCPReleaseIdleStreams( FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Called by the socket owner: ask the IP-task to replace or release the
+	 * streams, and wait until it has done so.  The IP-task may be using the
+	 * streams, so it is the only one that may change them.
+	 */
+	static void prvTCPStreamRequest( FreeRTOS_Socket_t *pxSocket, uint8_t ucRequest, StreamBuffer_t *pxNewStream );
+
+	/*
+	 * Called by the IP-task from xTCPTimerCheck(): carry out the request of
+	 * prvTCPStreamRequest() and wake up the socket owner.
+	 */
+	static void prvTCPHandleStreamRequest( FreeRTOS_Socket_t *pxSocket );
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 ) */
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * Called from FreeRTOS_send(): some checks which will be done before
@@ -143,6 +197,24 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	static void prvTCPSetSocketCount( FreeRTOS_Socket_t const * pxSocketToDelete );
 #endif  /* ipconfigUSE_TCP == 1 */
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_REUSE_PORT == 1 )
+	/*
+	 * Called from vSocketBind(): a TCP port that is already in use may be
+	 * shared if the new socket and all sockets bound to the port have the
+	 * bReusePort flag set.
+	 */
+	static BaseType_t prvTCPPortMayBeShared( FreeRTOS_Socket_t const * pxSocket, TickType_t xPortNumber );
+
+	/*
+	 * Called from pxTCPSocketLookup() when more than one socket is listening
+	 * to the same port: select one of them, based on a hash of the remote
+	 * address and port.
+	 */
+	static FreeRTOS_Socket_t *prvTCPSelectListenSocket( UBaseType_t uxLocalPort, uint32_t ulRemoteIP, UBaseType_t uxRemotePort, UBaseType_t uxListenCount );
+#else
+	#define prvTCPPortMayBeShared( pxSocket, xPortNumber )	( pdFALSE )
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_REUSE_PORT == 1 ) */
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * Called from FreeRTOS_connect(): make some checks and if allowed, send a
@@ -167,15 +239,6 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 #endif /* ipconfigSUPPORT_SELECT_FUNCTION == 1 */
 /*-----------------------------------------------------------*/
 
-/* The list that contains mappings between sockets and port numbers.  Accesses
-to this list must be protected by critical sections of one kind or another. */
-static List_t xBoundUDPSocketsList;
-
-#if ipconfigUSE_TCP == 1
-	List_t xBoundTCPSocketsList;
-#endif /* ipconfigUSE_TCP == 1 */
-
-/*-----------------------------------------------------------*/
 
 static BaseType_t prvValidSocket( const FreeRTOS_Socket_t *pxSocket, BaseType_t xProtocol, BaseType_t xIsBound )
 {
@@ -204,13 +267,13 @@ BaseType_t xReturn;
 }
 /*-----------------------------------------------------------*/
 
-void vNetworkSocketsInit( void )
+void vNetworkSocketsInit( IPStack_t *pxStack )
 {
-	vListInitialise( &xBoundUDPSocketsList );
+	vListInitialise( &( pxStack->xBoundUDPSocketsList ) );
 
 	#if( ipconfigUSE_TCP == 1 )
 	{
-		vListInitialise( &xBoundTCPSocketsList );
+		vListInitialise( &( pxStack->xBoundTCPSocketsList ) );
 	}
 	#endif  /* ipconfigUSE_TCP == 1 */
 }
@@ -233,11 +296,11 @@ FreeRTOS_Socket_t const *pxSocket = NULL;
 		configASSERT( xDomain == FREERTOS_AF_INET );
 
 		/* Check if the UDP socket-list has been initialised. */
-		configASSERT( listLIST_IS_INITIALISED( &xBoundUDPSocketsList ) );
+		configASSERT( listLIST_IS_INITIALISED( &pxIPStack->xBoundUDPSocketsList ) );
 		#if( ipconfigUSE_TCP == 1 )
 		{
 			/* Check if the TCP socket-list has been initialised. */
-			configASSERT( listLIST_IS_INITIALISED( &xBoundTCPSocketsList ) );
+			configASSERT( listLIST_IS_INITIALISED( &pxIPStack->xBoundTCPSocketsList ) );
 		}
 		#endif  /* ipconfigUSE_TCP == 1 */
 
@@ -337,6 +400,7 @@ Socket_t xReturn;
 					#if( ipconfigUDP_MAX_RX_PACKETS > 0U )
 					{
 						pxSocket->u.xUDP.uxMaxPackets = ( UBaseType_t ) ipconfigUDP_MAX_RX_PACKETS;
+						pxSocket->u.xUDP.xDropOldest = ( BaseType_t ) ipconfigUDP_RX_DROP_OLDEST;
 					}
 					#endif /* ipconfigUDP_MAX_RX_PACKETS > 0 */
 				}
@@ -348,6 +412,11 @@ Socket_t xReturn;
 				pxSocket->xSendBlockTime	= ipconfigSOCK_DEFAULT_SEND_BLOCK_TIME;
 				pxSocket->ucSocketOptions   = ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT;
 				pxSocket->ucProtocol		= ( uint8_t ) xProtocol; /* protocol: UDP or TCP */
+				#if( ipconfigIP_STACK_COUNT > 1 )
+				{
+					pxSocket->pxStack = pxIPStack;
+				}
+				#endif /* ipconfigIP_STACK_COUNT */
 
 				#if( ipconfigUSE_TCP == 1 )
 				{
@@ -639,7 +708,7 @@ int32_t FreeRTOS_recvfrom( Socket_t xSocket, void *pvBuffer, size_t uxBufferLeng
 {
 BaseType_t lPacketCount;
 NetworkBufferDescriptor_t *pxNetworkBuffer;
-FreeRTOS_Socket_t const * pxSocket = xSocket;
+FreeRTOS_Socket_t * pxSocket = xSocket;
 TickType_t xRemainingTime = ( TickType_t ) 0; /* Obsolete assignment, but some compilers output a warning if its not done. */
 BaseType_t xTimed = pdFALSE;
 TimeOut_t xTimeOut;
@@ -740,6 +809,7 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 					/* Remove the network buffer from the list of buffers waiting to
 					be processed by the socket. */
 					( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+					pxSocket->u.xUDP.uxWaitingBytes -= pxNetworkBuffer->xDataLength;
 				}
 			}
 			taskEXIT_CRITICAL();
@@ -887,9 +957,22 @@ const size_t uxPayloadOffset = ( size_t ) ipUDP_PAYLOAD_OFFSET_IPv4;
 				pxNetworkBuffer->usBoundPort = ( uint16_t ) socketGET_SOCKET_PORT( pxSocket );
 				pxNetworkBuffer->ulIPAddress = pxDestinationAddress->sin_addr;
 
+				#if( ipconfigUSE_ROUTING != 0 )
+				{
+				RouteCache_t *pxRouteCache = &( ( ( FreeRTOS_Socket_t * ) xSocket )->xRouteCache );
+
+					/* The lookup is only repeated when the destination or the
+					routing table has changed. */
+					vRouteCacheUpdate( pxRouteCache, pxDestinationAddress->sin_addr );
+					pxNetworkBuffer->pxEndPoint = pxRouteCache->pxEndPoint;
+					pxNetworkBuffer->ulNextHop = pxRouteCache->ulNextHop;
+				}
+				#endif
+
 				/* The socket options are passed to the IP layer in the
 				space that will eventually get used by the Ethernet header. */
 				pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] = pxSocket->ucSocketOptions;
+				pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_TOS_OFFSET ] = pxSocket->ucTOS;
 
 				/* Tell the networking task that the packet needs sending. */
 				xStackTxEvent.pvData = pxNetworkBuffer;
@@ -926,6 +1009,7 @@ const size_t uxPayloadOffset = ( size_t ) ipUDP_PAYLOAD_OFFSET_IPv4;
 				number of transmitted bytes, so the calling function knows
 				how	much data was actually sent. */
 				iptraceNO_BUFFER_FOR_SENDTO();
+				ipSTATS_COUNT_DROP( eIPDropNoBuffer );
 			}
 		}
 		else
@@ -1030,12 +1114,12 @@ struct freertos_sockaddr * pxAddress = pxBindAddress;
 #if( ipconfigUSE_TCP == 1 )
 	if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
 	{
-		pxSocketList = &xBoundTCPSocketsList;
+		pxSocketList = &pxIPStack->xBoundTCPSocketsList;
 	}
 	else
 #endif  /* ipconfigUSE_TCP == 1 */
 	{
-		pxSocketList = &xBoundUDPSocketsList;
+		pxSocketList = &pxIPStack->xBoundUDPSocketsList;
 	}
 
 	/* The function prototype is designed to maintain the expected Berkeley
@@ -1091,7 +1175,8 @@ struct freertos_sockaddr * pxAddress = pxBindAddress;
 			/* Check to ensure the port is not already in use.  If the bind is
 			called internally, a port MAY be used by more than one socket. */
 			if( ( ( xInternal == pdFALSE ) || ( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP ) ) &&
-				( pxListFindListItemWithValue( pxSocketList, ( TickType_t ) pxAddress->sin_port ) != NULL ) )
+				( pxListFindListItemWithValue( pxSocketList, ( TickType_t ) pxAddress->sin_port ) != NULL ) &&
+				( prvTCPPortMayBeShared( pxSocket, ( TickType_t ) pxAddress->sin_port ) == pdFALSE ) )
 			{
 				FreeRTOS_debug_printf( ( "vSocketBind: %sP port %d in use\n",
 					( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP ) ? "TC" : "UD",
@@ -1228,19 +1313,34 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 			/* Free the input and output streams */
 			if( pxSocket->u.xTCP.rxStream != NULL )
 			{
-				iptraceMEM_STATS_DELETE( pxSocket->u.xTCP.rxStream );
-				vPortFreeLarge( pxSocket->u.xTCP.rxStream );
+				prvTCPFreeStream( pxSocket->u.xTCP.rxStream );
 			}
 
 			if( pxSocket->u.xTCP.txStream != NULL )
 			{
-				iptraceMEM_STATS_DELETE( pxSocket->u.xTCP.txStream );
-				vPortFreeLarge( pxSocket->u.xTCP.txStream );
+				prvTCPFreeStream( pxSocket->u.xTCP.txStream );
+			}
+
+			#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			{
+				/* A bigger stream that was never installed. */
+				if( pxSocket->u.xTCP.pxNewStream != NULL )
+				{
+					prvTCPFreeStream( pxSocket->u.xTCP.pxNewStream );
+				}
 			}
+			#endif
 
 			/* In case this is a child socket, make sure the child-count of the
 			parent socket is decreased. */
 			prvTCPSetSocketCount( pxSocket );
+
+			#if( ipconfigTCP_SYN_CACHE_ENTRIES > 0 )
+			{
+				/* A listening socket may have pending connection requests. */
+				vTCPSynCacheFlush( pxSocket );
+			}
+			#endif
 		}
 	}
 	#endif  /* ipconfigUSE_TCP == 1 */
@@ -1277,7 +1377,22 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 			( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
 			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
 		}
+		pxSocket->u.xUDP.uxWaitingBytes = 0U;
+
+		#if( ipconfigUSE_IGMP != 0 )
+		{
+			/* Leave the multicast groups that were joined by this socket. */
+			vIGMPSocketLeaveAll( &( pxSocket->u.xUDP.ulIGMPGroupMask ) );
+		}
+		#endif /* ipconfigUSE_IGMP */
+	}
+
+	#if( ipconfigUSE_SOCKET_REACTOR != 0 )
+	{
+		/* Make sure that the workers will not see the socket any more. */
+		vReactorSocketClose( pxSocket );
 	}
+	#endif /* ipconfigUSE_SOCKET_REACTOR */
 
 	if( pxSocket->xEventGroup != NULL )
 	{
@@ -1293,7 +1408,7 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 				pxSocket->u.xTCP.ulRemoteIP,
 				pxSocket->u.xTCP.usRemotePort,
 				uxGetNumberOfFreeNetworkBuffers(),
-				listCURRENT_LIST_LENGTH( &xBoundTCPSocketsList ) ) );
+				listCURRENT_LIST_LENGTH( &pxIPStack->xBoundTCPSocketsList ) ) );
 		}
 	}
 	#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigHAS_DEBUG_PRINTF != 0 ) */
@@ -1317,12 +1432,61 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 	static void prvTCPSetSocketCount( FreeRTOS_Socket_t const * pxSocketToDelete )
 	{
 	const ListItem_t *pxIterator;
-	const ListItem_t *pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xBoundTCPSocketsList ) );
+	const ListItem_t *pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xBoundTCPSocketsList ) );
 	FreeRTOS_Socket_t *pxOtherSocket;
 	uint16_t usLocalPort = pxSocketToDelete->usLocalPort;
+	BaseType_t xParentFound = pdFALSE;
+
+		#if( ipconfigTCP_REUSE_PORT == 1 )
+		{
+			if( pxSocketToDelete->u.xTCP.ucTCPState == ( uint8_t ) eTCP_LISTEN )
+			{
+				/* A listening socket is being closed: its children must not
+				refer to it any longer. */
+				for( pxIterator  = listGET_NEXT( pxEnd );
+					 pxIterator != pxEnd;
+					 pxIterator  = listGET_NEXT( pxIterator ) )
+				{
+					pxOtherSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+					if( pxOtherSocket->u.xTCP.pxListenSocket == pxSocketToDelete )
+					{
+						pxOtherSocket->u.xTCP.pxListenSocket = NULL;
+					}
+				}
+
+				/* A listening socket is not a child: the child-count of the
+				other sockets listening to the same port must not change. */
+				xParentFound = pdTRUE;
+			}
+			else if( pxSocketToDelete->u.xTCP.pxListenSocket != NULL )
+			{
+				/* This child socket knows which of the listening sockets
+				created it, there is no need to search for it. */
+				pxOtherSocket = pxSocketToDelete->u.xTCP.pxListenSocket;
+				if( pxOtherSocket->u.xTCP.usChildCount != 0U )
+				{
+					pxOtherSocket->u.xTCP.usChildCount--;
+					FreeRTOS_debug_printf( ( "Lost: Socket %u now has %u / %u child%s\n",
+						pxOtherSocket->usLocalPort,
+						pxOtherSocket->u.xTCP.usChildCount,
+						pxOtherSocket->u.xTCP.usBacklog,
+						( pxOtherSocket->u.xTCP.usChildCount == 1U ) ? "" : "ren" ) );
+				}
+				xParentFound = pdTRUE;
+			}
+			else
+			{
+				/* Every child gets the address of its parent in
+				prvTCPSocketCopy(), so this socket is either not a child, or
+				its parent has already been closed.  Another socket listening
+				to the same port is not its parent. */
+				xParentFound = pdTRUE;
+			}
+		}
+		#endif /* ipconfigTCP_REUSE_PORT */
 
 		for( pxIterator  = listGET_NEXT( pxEnd );
-			 pxIterator != pxEnd;
+			 ( pxIterator != pxEnd ) && ( xParentFound == pdFALSE );
 			 pxIterator  = listGET_NEXT( pxIterator ) )
 		{
 			pxOtherSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
@@ -1336,7 +1500,7 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 					pxOtherSocket->u.xTCP.usChildCount,
 					pxOtherSocket->u.xTCP.usBacklog,
 					( pxOtherSocket->u.xTCP.usChildCount == 1U ) ? "" : "ren" ) );
-				break;
+				xParentFound = pdTRUE;
 			}
 		}
 	}
@@ -1443,8 +1607,69 @@ FreeRTOS_Socket_t *pxSocket;
 				pxSocket->u.xUDP.uxMaxPackets = *( ( const UBaseType_t * ) pvOptionValue );
 				xReturn = 0;
 				break;
+
+			case FREERTOS_SO_UDP_RX_DROP_OLDEST:
+				/* When the reception list is full, let the IP-task release
+				the oldest packet and queue the new one.  Note that the oldest
+				packet may disappear while it is being peeked at, so do not
+				combine this option with FREERTOS_MSG_PEEK. */
+				if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_UDP )
+				{
+					break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+				}
+				if( *( ipPOINTER_CAST( const BaseType_t *, pvOptionValue ) ) != 0 )
+				{
+					pxSocket->u.xUDP.xDropOldest = pdTRUE;
+				}
+				else
+				{
+					pxSocket->u.xUDP.xDropOldest = pdFALSE;
+				}
+				xReturn = 0;
+				break;
 		#endif /* ipconfigUDP_MAX_RX_PACKETS */
 
+		#if( ipconfigUSE_IGMP != 0 )
+			case FREERTOS_SO_IP_ADD_MEMBERSHIP:
+			case FREERTOS_SO_IP_DROP_MEMBERSHIP:
+				{
+				const struct freertos_ip_mreq *pxRequest = ipPOINTER_CAST( const struct freertos_ip_mreq *, pvOptionValue );
+
+					if( ( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_UDP ) ||
+						( pxRequest == NULL ) ||
+						( uxOptionLength < sizeof( *pxRequest ) ) )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+
+					/* The IGMP module keeps count of the members of each group,
+					and tells the IP-task to report the change. */
+					xReturn = xIGMPSocketMembership( &( pxSocket->u.xUDP.ulIGMPGroupMask ),
+													 pxRequest->imr_multiaddr,
+													 ( lOptionName == FREERTOS_SO_IP_ADD_MEMBERSHIP ) ? pdTRUE : pdFALSE );
+				}
+				break;
+		#endif /* ipconfigUSE_IGMP */
+
+		case FREERTOS_SO_IP_TOS:
+			{
+			BaseType_t xTOS;
+
+				if( pvOptionValue == NULL )
+				{
+					break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+				}
+				xTOS = *( ipPOINTER_CAST( const BaseType_t *, pvOptionValue ) );
+				if( ( xTOS < 0 ) || ( xTOS > 0xff ) )
+				{
+					break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+				}
+				/* The TOS byte is copied into every packet that is sent. */
+				pxSocket->ucTOS = ( uint8_t ) xTOS;
+			}
+			xReturn = 0;
+			break;
+
 		case FREERTOS_SO_UDPCKSUM_OUT :
 			/* Turn calculating of the UDP checksum on/off for this socket. If pvOptionValue
 			 * is anything else than NULL, the checksum generation will be turned on. */
@@ -1652,6 +1877,28 @@ FreeRTOS_Socket_t *pxSocket;
 				xReturn = 0;
 				break;
 
+		#if( ipconfigTCP_REUSE_PORT == 1 )
+			case FREERTOS_SO_REUSE_PORT:	/* If true, more sockets may listen to the same port */
+				{
+					/* The option must be set before the socket gets bound. */
+					if( ( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP ) ||
+						( socketSOCKET_IS_BOUND( pxSocket ) ) )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+					if( *( ipPOINTER_CAST( const BaseType_t *, pvOptionValue ) ) != 0 )
+					{
+						pxSocket->u.xTCP.bits.bReusePort = pdTRUE;
+					}
+					else
+					{
+						pxSocket->u.xTCP.bits.bReusePort = pdFALSE;
+					}
+				}
+				xReturn = 0;
+				break;
+		#endif /* ipconfigTCP_REUSE_PORT */
+
 			case FREERTOS_SO_CLOSE_AFTER_SEND:		/* As soon as the last byte has been transmitted, finalise the connection */
 				{
 					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
@@ -1746,12 +1993,12 @@ const List_t *pxList;
 #if ipconfigUSE_TCP == 1
 	if( xProtocol == ( BaseType_t ) FREERTOS_IPPROTO_TCP )
 	{
-		pxList = &xBoundTCPSocketsList;
+		pxList = &pxIPStack->xBoundTCPSocketsList;
 	}
 	else
 #endif
 	{
-		pxList = &xBoundUDPSocketsList;
+		pxList = &pxIPStack->xBoundUDPSocketsList;
 	}
 
 	/* Avoid compiler warnings if ipconfigUSE_TCP is not defined. */
@@ -1830,7 +2077,7 @@ FreeRTOS_Socket_t *pxSocket = NULL;
 
 	See if there is a list item associated with the port number on the
 	list of bound sockets. */
-	pxListItem = pxListFindListItemWithValue( &xBoundUDPSocketsList, ( TickType_t ) uxLocalPort );
+	pxListItem = pxListFindListItemWithValue( &pxIPStack->xBoundUDPSocketsList, ( TickType_t ) uxLocalPort );
 
 	if( pxListItem != NULL )
 	{
@@ -2079,7 +2326,16 @@ size_t FreeRTOS_GetLocalAddress( ConstSocket_t xSocket, struct freertos_sockaddr
 const FreeRTOS_Socket_t *pxSocket = ( const FreeRTOS_Socket_t * ) xSocket;
 
 	/* IP address of local machine. */
-	pxAddress->sin_addr = *ipLOCAL_IP_ADDRESS_POINTER;
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+		/* The address of the end-point that was used last. */
+		pxAddress->sin_addr = ipEND_POINT_IP_ADDRESS( pxSocket->xRouteCache.pxEndPoint );
+	}
+	#else
+	{
+		pxAddress->sin_addr = *ipLOCAL_IP_ADDRESS_POINTER;
+	}
+	#endif
 
 	/* Local port on this machine. */
 	pxAddress->sin_port = FreeRTOS_htons( pxSocket->usLocalPort );
@@ -2127,6 +2383,13 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	}
 	#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
 
+	#if( ipconfigUSE_SOCKET_REACTOR != 0 )
+	{
+		/* The eSOCKET_* bits have the values of the FREERTOS_REACTOR_* bits. */
+		vReactorSocketEvent( pxSocket, pxSocket->xEventBits & ( EventBits_t ) eSOCKET_ALL );
+	}
+	#endif /* ipconfigUSE_SOCKET_REACTOR */
+
 	if( ( pxSocket->xEventGroup != NULL ) && ( pxSocket->xEventBits != 0U ) )
 	{
 		( void ) xEventGroupSetBits( pxSocket->xEventGroup, pxSocket->xEventBits );
@@ -2151,7 +2414,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 		vTaskSuspendAll();
 		{
-			if( ( pxListFindListItemWithValue( &xBoundUDPSocketsList, ( TickType_t ) usPortNr ) != NULL ) )
+			if( ( pxListFindListItemWithValue( &pxIPStack->xBoundUDPSocketsList, ( TickType_t ) usPortNr ) != NULL ) )
 			{
 				xFound = pdTRUE;
 			}
@@ -2503,6 +2766,12 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		}
 		else
 		{
+			#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			{
+				prvTCPReleaseIdleStreams( pxSocket );
+			}
+			#endif
+
 			if( pxSocket->u.xTCP.rxStream != NULL )
 			{
 				xByteCount = ( BaseType_t )uxStreamBufferGetSize ( pxSocket->u.xTCP.rxStream );
@@ -2601,6 +2870,12 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				}
 				#endif /* ipconfigSUPPORT_SIGNALS */
 
+				#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+				{
+					prvTCPReleaseIdleStreams( pxSocket );
+				}
+				#endif
+
 				if( pxSocket->u.xTCP.rxStream != NULL )
 				{
 					xByteCount = ( BaseType_t ) uxStreamBufferGetSize ( pxSocket->u.xTCP.rxStream );
@@ -2629,6 +2904,10 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				if( ( ( uint32_t ) xFlags & ( uint32_t ) FREERTOS_ZERO_COPY ) == 0U )
 				{
 				BaseType_t xIsPeek = ( ( ( uint32_t ) xFlags & ( uint32_t ) FREERTOS_MSG_PEEK ) != 0U ) ? 1L : 0L;
+				#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+					/* Remember how full the stream was before reading. */
+					size_t uxStored = ( size_t ) xByteCount;
+				#endif
 
 					xByteCount = ( BaseType_t )
 						uxStreamBufferGet( pxSocket->u.xTCP.rxStream,
@@ -2636,13 +2915,28 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 										   ipPOINTER_CAST( uint8_t *, pvBuffer ),
 										   ( size_t ) uxBufferLength,
 										   xIsPeek );
+
+					#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+					{
+						pxSocket->u.xTCP.xLastStreamTime = xTaskGetTickCount();
+
+						/* When the stream was at least half full, the peer is
+						sending faster than the application reads: give it a
+						bigger window. */
+						if( ( xIsPeek == 0 ) && ( uxStored >= ( pxSocket->u.xTCP.rxStream->LENGTH / 2U ) ) )
+						{
+							prvTCPGrowStream( pxSocket, pdTRUE, 0U );
+						}
+					}
+					#endif
+
 					if( pxSocket->u.xTCP.bits.bLowWater != pdFALSE_UNSIGNED )
 					{
 						/* We had reached the low-water mark, now see if the flag
 						can be cleared */
 						size_t uxFrontSpace = uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream );
 
-						if( uxFrontSpace >= pxSocket->u.xTCP.uxEnoughSpace )
+						if( uxFrontSpace >= sockRX_WATER_MARK( pxSocket, pxSocket->u.xTCP.uxEnoughSpace ) )
 						{
 							pxSocket->u.xTCP.bits.bLowWater = pdFALSE;
 							pxSocket->u.xTCP.bits.bWinChange = pdTRUE;
@@ -2669,6 +2963,69 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 )
+
+	/*
+	 * Zero-copy reception of the data in the Rx stream, without stopping at
+	 * the end of the circular buffer.
+	 */
+	BaseType_t FreeRTOS_recv_iovec( Socket_t xSocket, struct freertos_iovec *pxVector, size_t uxVectorCount, BaseType_t xFlags )
+	{
+	const FreeRTOS_Socket_t *pxSocket = ( const FreeRTOS_Socket_t * ) xSocket;
+	StreamBuffer_t *pxStream;
+	uint8_t *pucData = NULL;
+	BaseType_t xByteCount;
+	size_t uxIndex, uxTail, uxFirst, uxSize;
+
+		if( ( pxVector == NULL ) || ( uxVectorCount == 0U ) )
+		{
+			xByteCount = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else
+		{
+			for( uxIndex = 0U; uxIndex < uxVectorCount; uxIndex++ )
+			{
+				pxVector[ uxIndex ].iov_base = NULL;
+				pxVector[ uxIndex ].iov_len = 0U;
+			}
+
+			/* Let FreeRTOS_recv() check the socket and wait for data. */
+			xByteCount = FreeRTOS_recv( xSocket, &( pucData ), 0U, ( BaseType_t ) ( ( uint32_t ) xFlags | ( uint32_t ) FREERTOS_ZERO_COPY ) );
+
+			if( xByteCount > 0 )
+			{
+				/* More data may have arrived in the meantime, take a new
+				snapshot of the stream. */
+				pxStream = pxSocket->u.xTCP.rxStream;
+				uxTail = pxStream->uxTail;
+				uxSize = uxStreamBufferGetSize( pxStream );
+				uxFirst = FreeRTOS_min_uint32( uxSize, pxStream->LENGTH - uxTail );
+
+				pxVector[ 0 ].iov_base = &( pxStream->ucArray[ uxTail ] );
+				pxVector[ 0 ].iov_len = uxFirst;
+
+				if( ( uxVectorCount > 1U ) && ( uxSize > uxFirst ) )
+				{
+					/* The remaining data starts at the beginning of the
+					circular buffer. */
+					pxVector[ 1 ].iov_base = pxStream->ucArray;
+					pxVector[ 1 ].iov_len = uxSize - uxFirst;
+				}
+				else
+				{
+					uxSize = uxFirst;
+				}
+
+				xByteCount = ( BaseType_t ) uxSize;
+			}
+		}
+
+		return xByteCount;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	static int32_t prvTCPSendCheck( FreeRTOS_Socket_t *pxSocket, size_t uxDataLength )
@@ -2778,6 +3135,15 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		
 		if( pvBuffer != NULL )
 		{
+			#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			{
+				if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) != pdFALSE )
+				{
+					prvTCPReleaseIdleStreams( pxSocket );
+				}
+			}
+			#endif
+
 			xByteCount = ( BaseType_t ) prvTCPSendCheck( pxSocket, uxDataLength );
 		}
 
@@ -2786,6 +3152,18 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			/* xBytesLeft is number of bytes to send, will count to zero. */
 			xBytesLeft = ( BaseType_t ) uxDataLength;
 
+			#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			{
+				pxSocket->u.xTCP.xLastStreamTime = xTaskGetTickCount();
+
+				/* Only grow the stream when the data does not fit. */
+				if( uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream ) < ( size_t ) xBytesLeft )
+				{
+					prvTCPGrowStream( pxSocket, pdFALSE, ( size_t ) xBytesLeft );
+				}
+			}
+			#endif
+
 			/* xByteCount is number of bytes that can be sent now. */
 			xByteCount = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
 
@@ -2910,6 +3288,16 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				( void ) xEventGroupWaitBits( pxSocket->xEventGroup, ( EventBits_t ) eSOCKET_SEND | ( EventBits_t ) eSOCKET_CLOSED,
 					pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
 
+				#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+				{
+					/* All data may have been acknowledged in the meantime. */
+					if( uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream ) < ( size_t ) xBytesLeft )
+					{
+						prvTCPGrowStream( pxSocket, pdFALSE, ( size_t ) xBytesLeft );
+					}
+				}
+				#endif
+
 				xByteCount = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
 			}
 
@@ -2988,7 +3376,18 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 				( void ) memset( pxSocket->u.xTCP.xPacket.u.ucLastPacket, 0, sizeof( pxSocket->u.xTCP.xPacket.u.ucLastPacket ) );
 				( void ) memset( &pxSocket->u.xTCP.xTCPWindow, 0, sizeof( pxSocket->u.xTCP.xTCPWindow ) );
-				( void ) memset( &pxSocket->u.xTCP.bits, 0, sizeof( pxSocket->u.xTCP.bits ) );
+				#if( ipconfigTCP_REUSE_PORT == 1 )
+				{
+				BaseType_t xReusePort = ( pxSocket->u.xTCP.bits.bReusePort != pdFALSE_UNSIGNED ) ? pdTRUE : pdFALSE;
+
+					( void ) memset( &pxSocket->u.xTCP.bits, 0, sizeof( pxSocket->u.xTCP.bits ) );
+					pxSocket->u.xTCP.bits.bReusePort = xReusePort;
+				}
+				#else
+				{
+					( void ) memset( &pxSocket->u.xTCP.bits, 0, sizeof( pxSocket->u.xTCP.bits ) );
+				}
+				#endif
 
 				/* Now set the bReuseSocket flag again, because the bits have
 				just been cleared. */
@@ -3056,12 +3455,11 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	FreeRTOS_Socket_t *pxSocket;
 	TickType_t xShortest = pdMS_TO_TICKS( ( TickType_t ) ipTCP_TIMER_PERIOD_MS );
 	TickType_t xNow = xTaskGetTickCount();
-	static TickType_t xLastTime = 0U;
-	TickType_t xDelta = xNow - xLastTime;
-	const ListItem_t* pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xBoundTCPSocketsList ) );
-	const ListItem_t *pxIterator = ( const ListItem_t * ) listGET_HEAD_ENTRY( &xBoundTCPSocketsList );
+	TickType_t xDelta = xNow - pxIPStack->xLastTCPTimerCheck;
+	const ListItem_t* pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xBoundTCPSocketsList ) );
+	const ListItem_t *pxIterator = ( const ListItem_t * ) listGET_HEAD_ENTRY( &pxIPStack->xBoundTCPSocketsList );
 
-		xLastTime = xNow;
+		pxIPStack->xLastTCPTimerCheck = xNow;
 
 		if( xDelta == 0U )
 		{
@@ -3073,6 +3471,17 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
 			pxIterator = ( ListItem_t * ) listGET_NEXT( pxIterator );
 
+			#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			{
+				/* The owner of the socket waits until its streams have been
+				changed. */
+				if( pxSocket->u.xTCP.ucStreamRequest != sockSTREAM_REQUEST_NONE )
+				{
+					prvTCPHandleStreamRequest( pxSocket );
+				}
+			}
+			#endif
+
 			/* Sockets with 'tmout == 0' do not need any regular attention. */
 			if( pxSocket->u.xTCP.usTimeout == 0U )
 			{
@@ -3142,7 +3551,10 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	{
 	const ListItem_t *pxIterator;
 	FreeRTOS_Socket_t *pxResult = NULL, *pxListenSocket = NULL;
-	const ListItem_t *pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xBoundTCPSocketsList ) );
+	const ListItem_t *pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xBoundTCPSocketsList ) );
+	#if( ipconfigTCP_REUSE_PORT == 1 )
+		UBaseType_t uxListenCount = 0U;
+	#endif
 
 		/* Parameter not yet supported. */
 		( void ) ulLocalIP;
@@ -3160,6 +3572,11 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 					/* If this is a socket listening to uxLocalPort, remember it
 					in case there is no perfect match. */
 					pxListenSocket = pxSocket;
+					#if( ipconfigTCP_REUSE_PORT == 1 )
+					{
+						uxListenCount++;
+					}
+					#endif
 				}
 				else if( ( pxSocket->u.xTCP.usRemotePort == ( uint16_t ) uxRemotePort ) && ( pxSocket->u.xTCP.ulRemoteIP == ulRemoteIP ) )
 				{
@@ -3179,6 +3596,17 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			/* An exact match was not found, maybe a listening socket was
 			found. */
 			pxResult = pxListenSocket;
+
+			#if( ipconfigTCP_REUSE_PORT == 1 )
+			{
+				if( uxListenCount > 1U )
+				{
+					/* The port is shared by several listening sockets, spread
+					the new connections among them. */
+					pxResult = prvTCPSelectListenSocket( uxLocalPort, ulRemoteIP, uxRemotePort, uxListenCount );
+				}
+			}
+			#endif
 		}
 
 		return pxResult;
@@ -3187,6 +3615,109 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_REUSE_PORT == 1 )
+
+	static FreeRTOS_Socket_t *prvTCPSelectListenSocket( UBaseType_t uxLocalPort, uint32_t ulRemoteIP, UBaseType_t uxRemotePort, UBaseType_t uxListenCount )
+	{
+	const ListItem_t *pxIterator;
+	const ListItem_t *pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xBoundTCPSocketsList ) );
+	FreeRTOS_Socket_t *pxSocket;
+	FreeRTOS_Socket_t *pxHashed = NULL, *pxFirstFree = NULL, *pxResult = NULL;
+	UBaseType_t uxIndex = 0U, uxStart;
+	uint32_t ulHash;
+
+		/* Mix the remote address and port, so that all SYN's of a peer are
+		handled by the same listening socket, while different peers are
+		distributed evenly. */
+		ulHash = ulRemoteIP ^ ( ( uint32_t ) uxRemotePort << 16 ) ^ ( uint32_t ) uxLocalPort;
+		ulHash ^= ulHash >> 16;
+		ulHash *= 0x45d9f3bUL;
+		ulHash ^= ulHash >> 16;
+		uxStart = ( UBaseType_t ) ( ulHash % ( uint32_t ) uxListenCount );
+
+		for( pxIterator  = listGET_NEXT( pxEnd );
+			 pxIterator != pxEnd;
+			 pxIterator  = listGET_NEXT( pxIterator ) )
+		{
+			pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+
+			if( ( pxSocket->usLocalPort != ( uint16_t ) uxLocalPort ) ||
+				( pxSocket->u.xTCP.ucTCPState != ( uint8_t ) eTCP_LISTEN ) )
+			{
+				continue;
+			}
+
+			if( uxIndex == uxStart )
+			{
+				pxHashed = pxSocket;
+			}
+
+			/* Skip listeners whose backlog is full, if possible. */
+			if( ( pxSocket->u.xTCP.bits.bReuseSocket != pdFALSE_UNSIGNED ) ||
+				( pxSocket->u.xTCP.usChildCount < pxSocket->u.xTCP.usBacklog ) )
+			{
+				if( uxIndex >= uxStart )
+				{
+					pxResult = pxSocket;
+					break;
+				}
+				if( pxFirstFree == NULL )
+				{
+					pxFirstFree = pxSocket;
+				}
+			}
+			uxIndex++;
+		}
+
+		if( pxResult == NULL )
+		{
+			/* Wrap around to a listener before the hashed one, or let the
+			hashed listener refuse the connection. */
+			pxResult = ( pxFirstFree != NULL ) ? pxFirstFree : pxHashed;
+		}
+
+		return pxResult;
+	}
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_REUSE_PORT == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_REUSE_PORT == 1 )
+
+	static BaseType_t prvTCPPortMayBeShared( FreeRTOS_Socket_t const * pxSocket, TickType_t xPortNumber )
+	{
+	const ListItem_t *pxIterator;
+	const ListItem_t *pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xBoundTCPSocketsList ) );
+	const FreeRTOS_Socket_t *pxOtherSocket;
+	BaseType_t xReturn = pdFALSE;
+
+		if( ( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP ) &&
+			( pxSocket->u.xTCP.bits.bReusePort != pdFALSE_UNSIGNED ) )
+		{
+			xReturn = pdTRUE;
+
+			for( pxIterator  = listGET_NEXT( pxEnd );
+				 pxIterator != pxEnd;
+				 pxIterator  = listGET_NEXT( pxIterator ) )
+			{
+				if( listGET_LIST_ITEM_VALUE( pxIterator ) == xPortNumber )
+				{
+					pxOtherSocket = ipPOINTER_CAST( const FreeRTOS_Socket_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+					if( pxOtherSocket->u.xTCP.bits.bReusePort == pdFALSE_UNSIGNED )
+					{
+						xReturn = pdFALSE;
+						break;
+					}
+				}
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_REUSE_PORT == 1 ) */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 	/* For the web server: borrow the circular Rx buffer for inspection
 	 * HTML driver wants to see if a sequence of 13/10/13/10 is available. */
@@ -3214,7 +3745,6 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	{
 	StreamBuffer_t *pxBuffer;
 	size_t uxLength;
-	size_t uxSize;
 
 		/* Now that a stream is created, the maximum size is fixed before
 		creation, it could still be changed with setsockopt(). */
@@ -3237,6 +3767,48 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			uxLength = pxSocket->u.xTCP.uxTxStreamSize;
 		}
 
+		#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+		{
+			/* Start small, the stream will grow while data is passing. */
+			uxLength = FreeRTOS_min_uint32( uxLength, ipconfigTCP_STREAM_INITIAL_LENGTH );
+			pxSocket->u.xTCP.xLastStreamTime = xTaskGetTickCount();
+		}
+		#endif
+
+		pxBuffer = prvTCPAllocateStream( uxLength, xIsInputStream );
+
+		if( pxBuffer == NULL )
+		{
+			FreeRTOS_debug_printf( ( "prvTCPCreateStream: malloc failed\n" ) );
+			pxSocket->u.xTCP.bits.bMallocError = pdTRUE;
+			vTCPStateChange( pxSocket, eCLOSE_WAIT );
+		}
+		else
+		{
+			if( xIsInputStream != 0 )
+			{
+				pxSocket->u.xTCP.rxStream = pxBuffer;
+			}
+			else
+			{
+				pxSocket->u.xTCP.txStream = pxBuffer;
+			}
+		}
+
+		return pxBuffer;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 )
+
+	static StreamBuffer_t *prvTCPAllocateStream( size_t uxStreamSize, BaseType_t xIsInputStream )
+	{
+	StreamBuffer_t *pxBuffer;
+	size_t uxLength = uxStreamSize;
+	size_t uxSize;
+
 		/* Add an extra 4 (or 8) bytes. */
 		uxLength += sizeof( size_t );
 
@@ -3247,13 +3819,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 		pxBuffer = ipPOINTER_CAST( StreamBuffer_t *, pvPortMallocLarge( uxSize ) );
 
-		if( pxBuffer == NULL )
-		{
-			FreeRTOS_debug_printf( ( "prvTCPCreateStream: malloc failed\n" ) );
-			pxSocket->u.xTCP.bits.bMallocError = pdTRUE;
-			vTCPStateChange( pxSocket, eCLOSE_WAIT );
-		}
-		else
+		if( pxBuffer != NULL )
 		{
 			/* Clear the markers of the stream */
 			( void ) memset( pxBuffer, 0, sizeof( *pxBuffer ) - sizeof( pxBuffer->ucArray ) );
@@ -3267,13 +3833,21 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			if( xIsInputStream != 0 )
 			{
 				iptraceMEM_STATS_CREATE( tcpRX_STREAM_BUFFER, pxBuffer, uxSize );
-				pxSocket->u.xTCP.rxStream = pxBuffer;
 			}
 			else
 			{
 				iptraceMEM_STATS_CREATE( tcpTX_STREAM_BUFFER, pxBuffer, uxSize );
-				pxSocket->u.xTCP.txStream = pxBuffer;
 			}
+
+			#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			{
+				taskENTER_CRITICAL();
+				{
+					pxIPStack->uxTCPStreamMemory += uxLength;
+				}
+				taskEXIT_CRITICAL();
+			}
+			#endif
 		}
 
 		return pxBuffer;
@@ -3282,6 +3856,252 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 )
+
+	static void prvTCPFreeStream( StreamBuffer_t *pxStream )
+	{
+		#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+		{
+			taskENTER_CRITICAL();
+			{
+				pxIPStack->uxTCPStreamMemory -= pxStream->LENGTH;
+			}
+			taskEXIT_CRITICAL();
+		}
+		#endif
+
+		iptraceMEM_STATS_DELETE( pxStream );
+		vPortFreeLarge( pxStream );
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 )
+
+	static void prvTCPGrowStream( FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream, size_t uxWanted )
+	{
+	StreamBuffer_t *pxOldStream;
+	StreamBuffer_t *pxNewStream;
+	size_t uxMaximum, uxNewSize, uxFree;
+
+		if( xIsCallingFromIPTask() != pdFALSE )
+		{
+			/* A call-back handler can not wait for the IP-task. */
+			pxOldStream = NULL;
+		}
+		else if( xIsInputStream != pdFALSE )
+		{
+			pxOldStream = pxSocket->u.xTCP.rxStream;
+			uxMaximum = pxSocket->u.xTCP.uxRxStreamSize;
+		}
+		else
+		{
+			pxOldStream = pxSocket->u.xTCP.txStream;
+			uxMaximum = pxSocket->u.xTCP.uxTxStreamSize;
+
+			/* The sliding window refers to positions within the Tx stream,
+			so it can only be replaced when all data has been acknowledged. */
+			if( ( pxOldStream != NULL ) &&
+				( ( uxStreamBufferGetSize( pxOldStream ) != 0U ) || ( xTCPWindowTxDone( &( pxSocket->u.xTCP.xTCPWindow ) ) == pdFALSE ) ) )
+			{
+				pxOldStream = NULL;
+			}
+		}
+
+		if( pxOldStream != NULL )
+		{
+			/* Double the size, or more if that is what the user wants. */
+			uxNewSize = FreeRTOS_max_uint32( 2U * ( pxOldStream->LENGTH - sizeof( size_t ) ), uxWanted );
+
+			#if( ipconfigTCP_STREAM_MEMORY_BUDGET != 0 )
+			{
+				/* As the budget fills up, the streams may not grow as big as
+				configured. */
+				uxFree = ( pxIPStack->uxTCPStreamMemory < ( size_t ) ipconfigTCP_STREAM_MEMORY_BUDGET ) ? ( ( size_t ) ipconfigTCP_STREAM_MEMORY_BUDGET - pxIPStack->uxTCPStreamMemory ) : 0U;
+				uxMaximum = ( uxMaximum / sock100_PERCENT ) * ( uxFree / ( ( ( size_t ) ipconfigTCP_STREAM_MEMORY_BUDGET / sock100_PERCENT ) + 1U ) );
+				uxMaximum = FreeRTOS_min_uint32( uxMaximum, pxOldStream->LENGTH + uxFree );
+			}
+			#else
+			{
+				( void ) uxFree;
+			}
+			#endif
+
+			uxNewSize = FreeRTOS_min_uint32( uxNewSize, uxMaximum );
+
+			/* prvTCPAllocateStream() will add sizeof( size_t ) and round down,
+			so the stream only becomes longer if uxNewSize >= LENGTH. */
+			if( uxNewSize >= pxOldStream->LENGTH )
+			{
+				pxNewStream = prvTCPAllocateStream( uxNewSize, xIsInputStream );
+
+				if( pxNewStream != NULL )
+				{
+					prvTCPStreamRequest( pxSocket,
+						( xIsInputStream != pdFALSE ) ? sockSTREAM_REQUEST_GROW_RX : sockSTREAM_REQUEST_GROW_TX,
+						pxNewStream );
+				}
+			}
+		}
+	}
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 )
+
+	static void prvTCPReleaseIdleStreams( FreeRTOS_Socket_t *pxSocket )
+	{
+	TickType_t xAge = xTaskGetTickCount() - pxSocket->u.xTCP.xLastStreamTime;
+	const StreamBuffer_t *pxRxStream = pxSocket->u.xTCP.rxStream;
+	const StreamBuffer_t *pxTxStream = pxSocket->u.xTCP.txStream;
+
+		/* A call-back handler that is called from the IP-task may be using
+		the Rx stream.  The IP-task checks again whether the streams are still
+		idle before it releases them. */
+		if( ( xAge >= pdMS_TO_TICKS( ipconfigTCP_STREAM_IDLE_RELEASE_MS ) ) &&
+			( xIsCallingFromIPTask() == pdFALSE ) &&
+			( ( ( pxRxStream != NULL ) && ( uxStreamBufferGetSize( pxRxStream ) == 0U ) ) ||
+			  ( ( pxTxStream != NULL ) && ( uxStreamBufferGetSize( pxTxStream ) == 0U ) ) ) )
+		{
+			/* The streams will be created again when data is passed. */
+			prvTCPStreamRequest( pxSocket, sockSTREAM_REQUEST_RELEASE, NULL );
+		}
+	}
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 )
+
+	static void prvTCPStreamRequest( FreeRTOS_Socket_t *pxSocket, uint8_t ucRequest, StreamBuffer_t *pxNewStream )
+	{
+	EventBits_t xWaitBits;
+
+		if( ucRequest == sockSTREAM_REQUEST_GROW_RX )
+		{
+			xWaitBits = ( EventBits_t ) eSOCKET_RECEIVE;
+		}
+		else if( ucRequest == sockSTREAM_REQUEST_GROW_TX )
+		{
+			xWaitBits = ( EventBits_t ) eSOCKET_SEND;
+		}
+		else
+		{
+			xWaitBits = ( EventBits_t ) eSOCKET_RECEIVE | ( EventBits_t ) eSOCKET_SEND;
+		}
+
+		taskENTER_CRITICAL();
+		{
+			pxSocket->u.xTCP.pxNewStream = pxNewStream;
+			pxSocket->u.xTCP.ucStreamRequest = ucRequest;
+		}
+		taskEXIT_CRITICAL();
+
+		( void ) xSendEventToIPTask( eTCPTimerEvent );
+
+		/* The streams may not be touched until the IP-task has handled the
+		request.  The time-out only protects against a lost event. */
+		while( pxSocket->u.xTCP.ucStreamRequest != sockSTREAM_REQUEST_NONE )
+		{
+			( void ) xEventGroupWaitBits( pxSocket->xEventGroup, xWaitBits,
+				pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, pdMS_TO_TICKS( ipTCP_TIMER_PERIOD_MS ) );
+		}
+	}
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 )
+
+	static void prvTCPHandleStreamRequest( FreeRTOS_Socket_t *pxSocket )
+	{
+	StreamBuffer_t *pxNewStream = pxSocket->u.xTCP.pxNewStream;
+	StreamBuffer_t *pxOldRxStream = NULL;
+	StreamBuffer_t *pxOldTxStream = NULL;
+	EventBits_t xWakeUp;
+
+		switch( pxSocket->u.xTCP.ucStreamRequest )
+		{
+			case sockSTREAM_REQUEST_GROW_RX:
+				if( pxSocket->u.xTCP.rxStream != NULL )
+				{
+					pxOldRxStream = pxSocket->u.xTCP.rxStream;
+					vStreamBufferMoveContents( pxNewStream, pxOldRxStream );
+					pxSocket->u.xTCP.rxStream = pxNewStream;
+					pxNewStream = NULL;
+
+					/* Advertise the bigger reception window. */
+					pxSocket->u.xTCP.bits.bWinChange = pdTRUE;
+					pxSocket->u.xTCP.usTimeout = 1U;
+				}
+				xWakeUp = ( EventBits_t ) eSOCKET_RECEIVE;
+				break;
+
+			case sockSTREAM_REQUEST_GROW_TX:
+				/* The sliding window refers to positions within the Tx
+				stream, so it can only be replaced when all data has been
+				acknowledged. */
+				if( ( pxSocket->u.xTCP.txStream != NULL ) &&
+					( uxStreamBufferGetSize( pxSocket->u.xTCP.txStream ) == 0U ) &&
+					( xTCPWindowTxDone( &( pxSocket->u.xTCP.xTCPWindow ) ) != pdFALSE ) )
+				{
+					pxOldTxStream = pxSocket->u.xTCP.txStream;
+					vStreamBufferMoveContents( pxNewStream, pxOldTxStream );
+					pxSocket->u.xTCP.txStream = pxNewStream;
+					pxNewStream = NULL;
+				}
+				xWakeUp = ( EventBits_t ) eSOCKET_SEND;
+				break;
+
+			default:	/* sockSTREAM_REQUEST_RELEASE */
+				if( ( pxSocket->u.xTCP.rxStream != NULL ) &&
+					( uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream ) == 0U ) &&
+					( xTCPWindowRxEmpty( &( pxSocket->u.xTCP.xTCPWindow ) ) != pdFALSE ) &&
+					( pxSocket->u.xTCP.bits.bLowWater == pdFALSE_UNSIGNED ) )
+				{
+					pxOldRxStream = pxSocket->u.xTCP.rxStream;
+					pxSocket->u.xTCP.rxStream = NULL;
+				}
+
+				if( ( pxSocket->u.xTCP.txStream != NULL ) &&
+					( uxStreamBufferGetSize( pxSocket->u.xTCP.txStream ) == 0U ) &&
+					( xTCPWindowTxDone( &( pxSocket->u.xTCP.xTCPWindow ) ) != pdFALSE ) )
+				{
+					pxOldTxStream = pxSocket->u.xTCP.txStream;
+					pxSocket->u.xTCP.txStream = NULL;
+				}
+				xWakeUp = ( EventBits_t ) eSOCKET_RECEIVE | ( EventBits_t ) eSOCKET_SEND;
+				break;
+		}
+
+		pxSocket->u.xTCP.pxNewStream = NULL;
+		pxSocket->u.xTCP.ucStreamRequest = sockSTREAM_REQUEST_NONE;
+
+		if( pxOldRxStream != NULL )
+		{
+			prvTCPFreeStream( pxOldRxStream );
+		}
+
+		if( pxOldTxStream != NULL )
+		{
+			prvTCPFreeStream( pxOldTxStream );
+		}
+
+		if( pxNewStream != NULL )
+		{
+			/* The stream could not be installed. */
+			prvTCPFreeStream( pxNewStream );
+		}
+
+		pxSocket->xEventBits |= xWakeUp;
+		vSocketWakeUpUser( pxSocket );
+	}
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 ) */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	/*
@@ -3381,7 +4201,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 					if( pxSocket->u.xTCP.bits.bLowWater == pdFALSE_UNSIGNED )
 					{
 						size_t uxFrontSpace = uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream );
-						if( uxFrontSpace <= pxSocket->u.xTCP.uxLittleSpace  )
+						if( uxFrontSpace <= sockRX_WATER_MARK( pxSocket, pxSocket->u.xTCP.uxLittleSpace ) )
 						{
 							pxSocket->u.xTCP.bits.bLowWater = pdTRUE;
 							pxSocket->u.xTCP.bits.bWinChange = pdTRUE;
@@ -3650,23 +4470,53 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
-#if 0
-BaseType_t FreeRTOS_udp_rx_size( Socket_t xSocket )
+/*
+ * Returns the number of bytes of network buffer space that is held by the
+ * packets waiting in the reception list of a UDP socket.
+ */
+BaseType_t FreeRTOS_udp_rx_size( ConstSocket_t xSocket )
 {
-	BaseType_t xReturn = 0;
-	const FreeRTOS_Socket_t *pxSocket = ( const FreeRTOS_Socket_t * ) xSocket;
+BaseType_t xReturn;
+const FreeRTOS_Socket_t *pxSocket = ( const FreeRTOS_Socket_t * ) xSocket;
 
-	if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_UDP )
+	if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdFALSE ) == pdFALSE )
 	{
-		xReturn = ( BaseType_t ) listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
+		xReturn = -pdFREERTOS_ERRNO_EINVAL;
 	}
 	else
 	{
-		xReturn = -pdFREERTOS_ERRNO_EINVAL;
+		xReturn = ( BaseType_t ) pxSocket->u.xUDP.uxWaitingBytes;
 	}
+
 	return xReturn;
 }
-#endif /* 0 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUDP_MAX_RX_PACKETS > 0U )
+
+	/*
+	 * Returns the number of packets that were dropped because the reception
+	 * list of a UDP socket was full.
+	 */
+	BaseType_t FreeRTOS_udp_rx_dropped( ConstSocket_t xSocket )
+	{
+	BaseType_t xReturn;
+	const FreeRTOS_Socket_t *pxSocket = ( const FreeRTOS_Socket_t * ) xSocket;
+
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdFALSE ) == pdFALSE )
+		{
+			xReturn = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else
+		{
+			xReturn = ( BaseType_t ) pxSocket->u.xUDP.ulDroppedCount;
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUDP_MAX_RX_PACKETS */
+/*-----------------------------------------------------------*/
 
 #if( ipconfigUSE_TCP == 1 )
 
@@ -3695,16 +4545,16 @@ BaseType_t FreeRTOS_udp_rx_size( Socket_t xSocket )
 	size_t uxMinimum = uxGetMinimumFreeNetworkBuffers();
 	size_t uxCurrent = uxGetNumberOfFreeNetworkBuffers();
 
-		if( !listLIST_IS_INITIALISED( &xBoundTCPSocketsList ) )
+		if( !listLIST_IS_INITIALISED( &pxIPStack->xBoundTCPSocketsList ) )
 		{
 			FreeRTOS_printf( ( "PLUS-TCP not initialized\n" ) );
 		}
 		else
 		{
-		const ListItem_t *pxEndTCP = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xBoundTCPSocketsList ) );
-		const ListItem_t *pxEndUDP = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xBoundUDPSocketsList ) );
+		const ListItem_t *pxEndTCP = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xBoundTCPSocketsList ) );
+		const ListItem_t *pxEndUDP = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xBoundUDPSocketsList ) );
 			FreeRTOS_printf( ( "Prot Port IP-Remote       : Port  R/T Status       Alive  tmout Child\n" ) );
-			for( pxIterator  = listGET_HEAD_ENTRY( &xBoundTCPSocketsList );
+			for( pxIterator  = listGET_HEAD_ENTRY( &pxIPStack->xBoundTCPSocketsList );
 				 pxIterator != pxEndTCP;
 				 pxIterator  = listGET_NEXT( pxIterator ) )
 			{
@@ -3740,7 +4590,7 @@ BaseType_t FreeRTOS_udp_rx_size( Socket_t xSocket )
 				count++;
 			}
 
-			for( pxIterator  = listGET_HEAD_ENTRY( &xBoundUDPSocketsList );
+			for( pxIterator  = listGET_HEAD_ENTRY( &pxIPStack->xBoundUDPSocketsList );
 				 pxIterator != pxEndUDP;
 				 pxIterator  = listGET_NEXT( pxIterator ) )
 			{
@@ -3782,12 +4632,12 @@ BaseType_t FreeRTOS_udp_rx_size( Socket_t xSocket )
 			const ListItem_t *pxEnd;
 			if( xRound == 0 )
 			{
-				pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xBoundUDPSocketsList ) );
+				pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xBoundUDPSocketsList ) );
 			}
 		#if ipconfigUSE_TCP == 1
 			else
 			{
-				pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xBoundTCPSocketsList ) );
+				pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xBoundTCPSocketsList ) );
 			}
 		#endif /* ipconfigUSE_TCP == 1 */
 			for( pxIterator = listGET_NEXT( pxEnd );
@@ -3939,6 +4789,17 @@ BaseType_t FreeRTOS_udp_rx_size( Socket_t xSocket )
 	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
 	BaseType_t xReturn;
 
+		#if( ipconfigUSE_SOCKET_REACTOR != 0 )
+		{
+			/* The handler of a reactor socket gets FREERTOS_REACTOR_INTR, which
+			has the value of eSOCKET_INTR. */
+			if( pxSocket != NULL )
+			{
+				vReactorSocketEvent( pxSocket, ( EventBits_t ) eSOCKET_INTR );
+			}
+		}
+		#endif /* ipconfigUSE_SOCKET_REACTOR */
+
 		if( pxSocket == NULL )
 		{
 			xReturn = -pdFREERTOS_ERRNO_EINVAL;
@@ -3984,8 +4845,17 @@ BaseType_t FreeRTOS_udp_rx_size( Socket_t xSocket )
 		xEvent.eEventType = eSocketSignalEvent;
 		xEvent.pvData = pxSocket;
 
-		/* The IP-task will call FreeRTOS_SignalSocket for this socket. */
-		xReturn = xQueueSendToBackFromISR( xNetworkEventQueue, &xEvent, pxHigherPriorityTaskWoken );
+		/* The IP-task will call FreeRTOS_SignalSocket for this socket.  An ISR
+		can not look up the stack of the calling task. */
+		#if( ipconfigIP_STACK_COUNT > 1 )
+		{
+			xReturn = xSendEventStructToIPStackFromISR( pxSocket->pxStack, &xEvent, pxHigherPriorityTaskWoken );
+		}
+		#else
+		{
+			xReturn = xSendEventStructToIPStackFromISR( pxIPStack, &xEvent, pxHigherPriorityTaskWoken );
+		}
+		#endif /* ipconfigIP_STACK_COUNT */
 
 		return xReturn;
 	}
@@ -4083,3 +4953,8 @@ BaseType_t xReturn = 0;
 
 #endif	/* ipconfigSUPPORT_SELECT_FUNCTION */
 #endif /* 0 */
+
+/* Provide access to private members for testing. */
+#ifdef FREERTOS_ENABLE_UNIT_TESTS
+	#include "freertos_tcp_test_access_sockets_define.h"
+#endif
@@ -0,0 +1,167 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Counters for monitoring the stack.  They are only incremented where a packet
+ * is dropped or a TCP segment is handled; nothing is logged.  An application
+ * reads all of them at once with FreeRTOS_GetIPStats() or
+ * FreeRTOS_GetSocketStats(), as often as it likes.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_IP_Private.h"
+
+#include "FreeRTOSIPConfigDefaults.h"
+
+/* Exclude the entire file if the statistics are not enabled. */
+#if( ipconfigUSE_NETWORK_STATS != 0 )
+
+#include "NetworkBufferManagement.h"
+#include "FreeRTOS_IP_Stack.h"
+
+void vIPStatsCountDrop( eIPDropReason_t eReason )
+{
+	configASSERT( eReason < eIPDropReasonCount );
+
+	if( xIsCallingFromIPTask() != pdFALSE )
+	{
+		pxIPStack->ulIPTaskDrops[ eReason ]++;
+	}
+	else
+	{
+		taskENTER_CRITICAL();
+		{
+			pxIPStack->ulOtherTaskDrops[ eReason ]++;
+		}
+		taskEXIT_CRITICAL();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vIPStatsCountTCPTxBufferFailure( void )
+{
+	configASSERT( xIsCallingFromIPTask() != pdFALSE );
+
+	pxIPStack->ulTCPTxBufferFailures++;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_GetIPStats( IPStats_t *pxStats )
+{
+BaseType_t xReturn = 0;
+UBaseType_t uxIndex;
+
+	if( pxStats == NULL )
+	{
+		xReturn = -pdFREERTOS_ERRNO_EINVAL;
+	}
+	else
+	{
+		( void ) memset( pxStats, 0, sizeof( *pxStats ) );
+
+		/* While the scheduler is suspended, the IP-task can not change its
+		counters.  The other counters are only changed in a critical
+		section. */
+		vTaskSuspendAll();
+		{
+			for( uxIndex = 0U; uxIndex < ( UBaseType_t ) eIPDropReasonCount; uxIndex++ )
+			{
+				pxStats->ulDrops[ uxIndex ] = pxIPStack->ulIPTaskDrops[ uxIndex ] + pxIPStack->ulOtherTaskDrops[ uxIndex ];
+			}
+
+			pxStats->ulTCPTxBufferFailures = pxIPStack->ulTCPTxBufferFailures;
+
+			pxStats->uxFreeNetworkBuffers = uxGetNumberOfFreeNetworkBuffers();
+			pxStats->uxMinimumFreeNetworkBuffers = uxGetMinimumFreeNetworkBuffers();
+
+			#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+			{
+				( void ) uxGetIPEventQueueDepth( eIPEventClassData, &( pxStats->uxEventQueueHighWater ) );
+				( void ) uxGetIPEventQueueDepth( eIPEventClassControl, &( pxStats->uxControlQueueHighWater ) );
+			}
+			#elif( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
+			{
+				pxStats->uxEventQueueHighWater = ( UBaseType_t ) ipconfigEVENT_QUEUE_LENGTH - uxGetMinimumIPQueueSpace();
+			}
+			#endif
+		}
+		( void ) xTaskResumeAll();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_GetSocketStats( Socket_t xSocket, SocketStats_t *pxStats )
+{
+BaseType_t xReturn = -pdFREERTOS_ERRNO_EINVAL;
+
+	#if( ipconfigUSE_TCP == 1 )
+	{
+	const FreeRTOS_Socket_t *pxSocket = ( const FreeRTOS_Socket_t * ) xSocket;
+
+		if( ( pxSocket != NULL ) &&
+			( pxSocket != FREERTOS_INVALID_SOCKET ) &&
+			( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP ) &&
+			( pxStats != NULL ) )
+		{
+			/* The counters are written by the IP-task only. */
+			vTaskSuspendAll();
+			{
+				pxStats->ulRxBytes = pxSocket->u.xTCP.ulRxBytes;
+				pxStats->ulTxBytes = pxSocket->u.xTCP.ulTxBytes;
+				pxStats->ulRetransmits = pxSocket->u.xTCP.xTCPWindow.ulRetransmitCount;
+				pxStats->ulWindowStalls = pxSocket->u.xTCP.ulWindowStalls;
+				pxStats->ulSmoothedRTT = ( uint32_t ) pxSocket->u.xTCP.xTCPWindow.lSRTT;
+			}
+			( void ) xTaskResumeAll();
+
+			xReturn = 0;
+		}
+	}
+	#else
+	{
+		( void ) xSocket;
+		( void ) pxStats;
+	}
+	#endif /* ipconfigUSE_TCP */
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_NETWORK_STATS */
@@ -197,4 +197,38 @@ size_t uxSize, uxCount, uxFirst, uxNextTail;
 
 	return uxCount;
 }
+/*-----------------------------------------------------------*/
+
+/*
+ * vStreamBufferMoveContents( )
+ * Copies the contents of the source buffer to the start of the target buffer,
+ * which must be at least as long.  All bytes are copied, starting at 'uxTail',
+ * so data that was written at an offset from 'uxHead' is preserved as well.
+ * The markers of the target buffer get the same distance to 'uxTail' as they
+ * had in the source buffer.
+ */
+void vStreamBufferMoveContents( StreamBuffer_t *pxTarget, const StreamBuffer_t *pxSource )
+{
+size_t uxTail = pxSource->uxTail;
+size_t uxCount, uxFirst;
+
+	configASSERT( pxTarget->LENGTH >= pxSource->LENGTH );
+
+	/* One item of a circular buffer is never used. */
+	uxCount = pxSource->LENGTH - 1U;
 
+	/* The data may wrap around the end of the source buffer. */
+	uxFirst = FreeRTOS_min_uint32( pxSource->LENGTH - uxTail, uxCount );
+	( void ) memcpy( pxTarget->ucArray, &( pxSource->ucArray[ uxTail ] ), uxFirst );
+
+	if( uxCount > uxFirst )
+	{
+		( void ) memcpy( &( pxTarget->ucArray[ uxFirst ] ), pxSource->ucArray, uxCount - uxFirst );
+	}
+
+	pxTarget->uxTail = 0U;
+	pxTarget->uxHead = uxStreamBufferDistance( pxSource, uxTail, pxSource->uxHead );
+	pxTarget->uxMid = uxStreamBufferDistance( pxSource, uxTail, pxSource->uxMid );
+	pxTarget->uxFront = uxStreamBufferDistance( pxSource, uxTail, pxSource->uxFront );
+}
+/*-----------------------------------------------------------*/
@@ -52,6 +52,7 @@
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
 #include "FreeRTOS_ARP.h"
+#include "FreeRTOS_IP_Stack.h"
 
 
 #include "FreeRTOSIPConfigDefaults.h"
@@ -231,6 +232,12 @@ _static size_t prvSingleStepTCPHeaderOptions( const uint8_t * const pucPtr,
  */
 static UBaseType_t prvSetSynAckOptions( FreeRTOS_Socket_t *pxSocket, TCPHeader_t *pxTCPHeader );
 
+/*
+ * Write the options MSS, window scaling and SACK-permitted.  Called by
+ * prvSetSynAckOptions() and for SYN+ACK's sent from the SYN cache.
+ */
+static UBaseType_t prvWriteSynAckOptions( TCPHeader_t *pxTCPHeader, uint16_t usMSS, uint8_t ucWinScaleFactor );
+
 /*
  * For anti-hang protection and TCP keep-alive messages.  Called in two places:
  * after receiving a packet and after a state change.  The socket's alive timer
@@ -328,6 +335,20 @@ static BaseType_t prvTCPSendReset( NetworkBufferDescriptor_t *pxNetworkBuffer );
  */
 static void prvSocketSetMSS( FreeRTOS_Socket_t *pxSocket );
 
+/*
+ * Return the MSS to be used with a peer.  The IP-address is passed in
+ * network-endian notation.
+ */
+static uint32_t prvGetMSSForPeer( uint32_t ulRemoteIP );
+
+#if( ipconfigUSE_ROUTING != 0 )
+	/*
+	 * A socket that is created for a connection from a peer sends through the
+	 * end-point that received the SYN.
+	 */
+	static void prvSocketSetRoute( FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer );
+#endif
+
 /*
  * Return either a newly created socket, or the current socket in a connected
  * state (depends on the 'bReuseSocket' flag).
@@ -340,6 +361,21 @@ static FreeRTOS_Socket_t *prvHandleListen( FreeRTOS_Socket_t *pxSocket, NetworkB
  */
 static BaseType_t prvTCPSocketCopy( FreeRTOS_Socket_t *pxNewSocket, FreeRTOS_Socket_t *pxSocket );
 
+#if( ipconfigTCP_SYN_CACHE_ENTRIES > 0 )
+	/*
+	 * Store a SYN received by a listening socket in the SYN cache and answer
+	 * it with a SYN+ACK, without creating a new socket.
+	 */
+	static void prvSynCacheAdd( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulInitialSequenceNumber );
+
+	/*
+	 * Called when a listening socket receives an ACK.  If the ACK completes a
+	 * handshake that is stored in the SYN cache, a new socket is created in
+	 * the state eSYN_RECEIVED and returned.
+	 */
+	static FreeRTOS_Socket_t *prvSynCacheComplete( const FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer );
+#endif /* ipconfigTCP_SYN_CACHE_ENTRIES */
+
 /*
  * prvTCPStatusAgeCheck() will see if the socket has been in a non-connected
  * state for too long.  If so, the socket will be closed, and -1 will be
@@ -724,6 +760,19 @@ NetworkBufferDescriptor_t xTempBuffer;
 		xDoRelease = pdFALSE;
 	}
 
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+		/* A packet of a socket leaves through the end-point that was found
+		when it connected.  Without a socket, a reply leaves through the
+		end-point that received the packet. */
+		if( pxSocket != NULL )
+		{
+			pxNetworkBuffer->pxEndPoint = pxSocket->xRouteCache.pxEndPoint;
+			pxNetworkBuffer->ulNextHop = pxSocket->xRouteCache.ulNextHop;
+		}
+	}
+	#endif
+
 	#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
 	{
 		if( xDoRelease == pdFALSE )
@@ -764,7 +813,7 @@ NetworkBufferDescriptor_t xTempBuffer;
 			{
 				/* No RX stream has been created, the full stream size is
 				available. */
-				ulFrontSpace = ( uint32_t ) pxSocket->u.xTCP.uxRxStreamSize;
+				ulFrontSpace = ( uint32_t ) ipTCP_RX_STREAM_INITIAL_SIZE( pxSocket );
 			}
 
 			/* Take the minimum of the RX buffer space and the RX window size. */
@@ -847,6 +896,9 @@ NetworkBufferDescriptor_t xTempBuffer;
 
 			/* Tell which sequence number is expected next time */
 			pxTCPPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( pxTCPWindow->rx.ulCurrentSequenceNumber );
+
+			/* DSCP and ECN bits, see FREERTOS_SO_IP_TOS. */
+			pxIPHeader->ucDifferentiatedServicesCode = pxSocket->ucTOS;
 		}
 		else
 		{
@@ -867,15 +919,15 @@ NetworkBufferDescriptor_t xTempBuffer;
 		}
 		else
 		{
-			ulSourceAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+			ulSourceAddress = ipBUFFER_IP_ADDRESS( pxNetworkBuffer );
 		}
 		pxIPHeader->ulDestinationIPAddress = pxIPHeader->ulSourceIPAddress;
 		pxIPHeader->ulSourceIPAddress = ulSourceAddress;
 		vFlip_16( pxTCPPacket->xTCPHeader.usSourcePort, pxTCPPacket->xTCPHeader.usDestinationPort );
 
 		/* Just an increasing number. */
-		pxIPHeader->usIdentification = FreeRTOS_htons( usPacketIdentifier );
-		usPacketIdentifier++;
+		pxIPHeader->usIdentification = FreeRTOS_htons( pxIPStack->usPacketIdentifier );
+		pxIPStack->usPacketIdentifier++;
 		pxIPHeader->usFragmentOffset = 0U;
 
 		/* Important: tell NIC driver how many bytes must be sent. */
@@ -883,19 +935,22 @@ NetworkBufferDescriptor_t xTempBuffer;
 
 		#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
 		{
-			/* calculate the IP header checksum, in case the driver won't do that. */
-			pxIPHeader->usHeaderChecksum = 0x00U;
-			pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
-			pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+			if( ipCALCULATE_CHECKSUMS( pxIPHeader->ulDestinationIPAddress ) != pdFALSE )
+			{
+				/* calculate the IP header checksum, in case the driver won't do that. */
+				pxIPHeader->usHeaderChecksum = 0x00U;
+				pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+				pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
 
-			/* calculate the TCP checksum for an outgoing packet. */
-			( void ) usGenerateProtocolChecksum( ( uint8_t * ) pxTCPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+				/* calculate the TCP checksum for an outgoing packet. */
+				( void ) usGenerateProtocolChecksum( ( uint8_t * ) pxTCPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
 
-			/* A calculated checksum of 0 must be inverted as 0 means the checksum
-			is disabled. */
-			if( pxTCPPacket->xTCPHeader.usChecksum == 0U )
-			{
-				pxTCPPacket->xTCPHeader.usChecksum = 0xffffU;
+				/* A calculated checksum of 0 must be inverted as 0 means the checksum
+				is disabled. */
+				if( pxTCPPacket->xTCPHeader.usChecksum == 0U )
+				{
+					pxTCPPacket->xTCPHeader.usChecksum = 0xffffU;
+				}
 			}
 		}
 		#endif
@@ -911,8 +966,9 @@ NetworkBufferDescriptor_t xTempBuffer;
 						 &( pxEthernetHeader->xSourceAddress ),
 						 sizeof( pxEthernetHeader->xDestinationAddress ) );
 
-		/* The source MAC addresses is fixed to 'ipLOCAL_MAC_ADDRESS'. */
-		( void ) memcpy( &( pxEthernetHeader->xSourceAddress ), ipLOCAL_MAC_ADDRESS, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
+		/* The source MAC addresses is the one of the end-point, normally
+		'ipLOCAL_MAC_ADDRESS'. */
+		( void ) memcpy( &( pxEthernetHeader->xSourceAddress ), ipBUFFER_MAC_ADDRESS( pxNetworkBuffer ), ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
  
 		#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
 		{
@@ -929,8 +985,13 @@ NetworkBufferDescriptor_t xTempBuffer;
 		}
 		#endif
 
-		/* Send! */
-		( void ) xNetworkInterfaceOutput( pxNetworkBuffer, xDoRelease );
+		#if( ipconfigUSE_LOOPBACK != 0 )
+		if( xLoopbackOutput( pxNetworkBuffer, xDoRelease ) == pdFALSE )
+		#endif
+		{
+			/* Send! */
+			( void ) ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xDoRelease );
+		}
 
 		if( xDoRelease == pdFALSE )
 		{
@@ -985,7 +1046,7 @@ static BaseType_t prvTCPPrepareConnect( FreeRTOS_Socket_t *pxSocket )
 TCPPacket_t *pxTCPPacket;
 IPHeader_t *pxIPHeader;
 eARPLookupResult_t eReturned;
-uint32_t ulRemoteIP;
+uint32_t ulRemoteIP, ulLocalIP;
 MACAddress_t xEthAddress;
 BaseType_t xReturn = pdTRUE;
 uint32_t ulInitialSequenceNumber = 0;
@@ -999,6 +1060,20 @@ uint32_t ulInitialSequenceNumber = 0;
 
 	ulRemoteIP = FreeRTOS_htonl( pxSocket->u.xTCP.ulRemoteIP );
 
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+		/* Find the end-point and the next hop, the connection will keep on
+		using them. */
+		vRouteCacheUpdate( &( pxSocket->xRouteCache ), ulRemoteIP );
+		ulRemoteIP = pxSocket->xRouteCache.ulNextHop;
+		ulLocalIP = ipEND_POINT_IP_ADDRESS( pxSocket->xRouteCache.pxEndPoint );
+	}
+	#else
+	{
+		ulLocalIP = *ipLOCAL_IP_ADDRESS_POINTER;
+	}
+	#endif
+
 	/* Determine the ARP cache status for the requested IP address. */
 	eReturned = eARPGetCacheEntry( &( ulRemoteIP ), &( xEthAddress ) );
 
@@ -1032,7 +1107,7 @@ uint32_t ulInitialSequenceNumber = 0;
 	if( xReturn != pdFALSE )
 	{
 		/* Get a difficult-to-predict initial sequence number for this 4-tuple. */
-		ulInitialSequenceNumber = ulApplicationGetNextSequenceNumber( *ipLOCAL_IP_ADDRESS_POINTER,
+		ulInitialSequenceNumber = ulApplicationGetNextSequenceNumber( ulLocalIP,
 																	  pxSocket->usLocalPort,
 																	  pxSocket->u.xTCP.ulRemoteIP,
 																	  pxSocket->u.xTCP.usRemotePort );
@@ -1080,7 +1155,7 @@ uint32_t ulInitialSequenceNumber = 0;
 
 		/* Addresses and ports will be stored swapped because prvTCPReturnPacket
 		will swap them back while replying. */
-		pxIPHeader->ulDestinationIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+		pxIPHeader->ulDestinationIPAddress = ulLocalIP;
 		pxIPHeader->ulSourceIPAddress = FreeRTOS_htonl( pxSocket->u.xTCP.ulRemoteIP );
 
 		pxTCPPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( pxSocket->u.xTCP.usRemotePort );
@@ -1438,7 +1513,21 @@ BaseType_t xReturn = pdFALSE;
 */
 static UBaseType_t prvSetSynAckOptions( FreeRTOS_Socket_t *pxSocket, TCPHeader_t * pxTCPHeader )
 {
-uint16_t usMSS = pxSocket->u.xTCP.usInitMSS;
+uint8_t ucWinScaleFactor = 0U;
+
+	#if( ipconfigUSE_TCP_WIN != 0 )
+	{
+		pxSocket->u.xTCP.ucMyWinScaleFactor = prvWinScaleFactor( pxSocket );
+		ucWinScaleFactor = pxSocket->u.xTCP.ucMyWinScaleFactor;
+	}
+	#endif
+
+	return prvWriteSynAckOptions( pxTCPHeader, pxSocket->u.xTCP.usInitMSS, ucWinScaleFactor );
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvWriteSynAckOptions( TCPHeader_t *pxTCPHeader, uint16_t usMSS, uint8_t ucWinScaleFactor )
+{
 UBaseType_t uxOptionsLength;
 
 	/* We send out the TCP Maximum Segment Size option with our SYN[+ACK]. */
@@ -1450,16 +1539,15 @@ UBaseType_t uxOptionsLength;
 
 	#if( ipconfigUSE_TCP_WIN != 0 )
 	{
-		pxSocket->u.xTCP.ucMyWinScaleFactor = prvWinScaleFactor( pxSocket );
-
 		pxTCPHeader->ucOptdata[ 4 ] = tcpTCP_OPT_NOOP;
 		pxTCPHeader->ucOptdata[ 5 ] = ( uint8_t ) ( tcpTCP_OPT_WSOPT );
 		pxTCPHeader->ucOptdata[ 6 ] = ( uint8_t ) ( tcpTCP_OPT_WSOPT_LEN );
-		pxTCPHeader->ucOptdata[ 7 ] = ( uint8_t ) pxSocket->u.xTCP.ucMyWinScaleFactor;
+		pxTCPHeader->ucOptdata[ 7 ] = ucWinScaleFactor;
 		uxOptionsLength = 8U;
 	}
 	#else
 	{
+		( void ) ucWinScaleFactor;
 		uxOptionsLength = 4U;
 	}
 	#endif
@@ -1756,6 +1844,12 @@ BaseType_t xResize;
 				( void ) memcpy( pxReturn->pucEthernetBuffer, pxSocket->u.xTCP.xPacket.u.ucLastPacket, sizeof( pxSocket->u.xTCP.xPacket.u.ucLastPacket ) );
 			}
 		}
+		else
+		{
+			/* The packet will be sent later, when a buffer is available.  It is
+			not counted as a drop. */
+			ipSTATS_COUNT_TCP_TX_BUFFER_FAILURE();
+		}
 	}
 	else
 	{
@@ -2271,7 +2365,7 @@ BaseType_t xResult = 0;
 		}
 		else
 		{
-			ulSpace = ( uint32_t )pxSocket->u.xTCP.uxRxStreamSize;
+			ulSpace = ( uint32_t ) ipTCP_RX_STREAM_INITIAL_SIZE( pxSocket );
 		}
 
 		lOffset = lTCPWindowRxCheck( pxTCPWindow, ulSequenceNumber, ulReceiveLength, ulSpace );
@@ -2294,6 +2388,12 @@ BaseType_t xResult = 0;
 				( void ) prvTCPSendReset( pxNetworkBuffer );
 				xResult = -1;
 			}
+			#if( ipconfigUSE_NETWORK_STATS != 0 )
+			else
+			{
+				pxSocket->u.xTCP.ulRxBytes += ( uint32_t ) lStored;
+			}
+			#endif /* ipconfigUSE_NETWORK_STATS */
 		}
 
 		/* After a missing packet has come in, higher packets may be passed to
@@ -2519,6 +2619,15 @@ uint16_t usWindow;
 
 	/* Remember the window size the peer is advertising. */
 	usWindow = FreeRTOS_ntohs( pxTCPHeader->usWindow );
+	#if( ipconfigUSE_NETWORK_STATS != 0 )
+	{
+		/* Count the times that the peer's reception buffer became full. */
+		if( ( usWindow == 0U ) && ( pxSocket->u.xTCP.ulWindowSize != 0U ) )
+		{
+			pxSocket->u.xTCP.ulWindowStalls++;
+		}
+	}
+	#endif /* ipconfigUSE_NETWORK_STATS */
 	pxSocket->u.xTCP.ulWindowSize = ( uint32_t ) usWindow;
 	#if( ipconfigUSE_TCP_WIN != 0 )
 	{
@@ -2531,6 +2640,12 @@ uint16_t usWindow;
 	{
 		ulCount = ulTCPWindowTxAck( pxTCPWindow, FreeRTOS_ntohl( pxTCPHeader->ulAckNr ) );
 
+		#if( ipconfigUSE_NETWORK_STATS != 0 )
+		{
+			pxSocket->u.xTCP.ulTxBytes += ulCount;
+		}
+		#endif /* ipconfigUSE_NETWORK_STATS */
+
 		/* ulTCPWindowTxAck() returns the number of bytes which have been acked,
 		starting at 'tx.ulCurrentSequenceNumber'.  Advance the tail pointer in
 		txStream. */
@@ -3030,17 +3145,29 @@ static BaseType_t prvTCPSendReset( NetworkBufferDescriptor_t *pxNetworkBuffer )
 }
 /*-----------------------------------------------------------*/
 
-static void prvSocketSetMSS( FreeRTOS_Socket_t *pxSocket )
+static uint32_t prvGetMSSForPeer( uint32_t ulRemoteIP )
 {
 uint32_t ulMSS = ipconfigTCP_MSS;
 
-	if( ( ( FreeRTOS_ntohl( pxSocket->u.xTCP.ulRemoteIP ) ^ *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) != 0UL )
+	if( ( ( ( ulRemoteIP ^ *ipLOCAL_IP_ADDRESS_POINTER ) & pxIPStack->xNetworkAddressing.ulNetMask ) != 0UL )
+	#if( ipconfigUSE_ROUTING != 0 )
+		&& ( xRoutingIsOnLink( ulRemoteIP ) == pdFALSE )
+	#endif
+		)
 	{
 		/* Data for this peer will pass through a router, and maybe through
 		the internet.  Limit the MSS to 1400 bytes or less. */
 		ulMSS = FreeRTOS_min_uint32( ( uint32_t ) tcpREDUCED_MSS_THROUGH_INTERNET, ulMSS );
 	}
 
+	return ulMSS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSocketSetMSS( FreeRTOS_Socket_t *pxSocket )
+{
+uint32_t ulMSS = prvGetMSSForPeer( FreeRTOS_ntohl( pxSocket->u.xTCP.ulRemoteIP ) );
+
 	FreeRTOS_debug_printf( ( "prvSocketSetMSS: %lu bytes for %lxip:%u\n", ulMSS, pxSocket->u.xTCP.ulRemoteIP, pxSocket->u.xTCP.usRemotePort ) );
 
 	pxSocket->u.xTCP.usInitMSS = ( uint16_t ) ulMSS;
@@ -3048,6 +3175,21 @@ uint32_t ulMSS = ipconfigTCP_MSS;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_ROUTING != 0 )
+
+	static void prvSocketSetRoute( FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+		/* The replies are built from the received packet, so only the
+		end-point is needed, the next hop is not looked up again. */
+		pxSocket->xRouteCache.ulDestination = FreeRTOS_htonl( pxSocket->u.xTCP.ulRemoteIP );
+		pxSocket->xRouteCache.ulNextHop = pxSocket->xRouteCache.ulDestination;
+		pxSocket->xRouteCache.pxEndPoint = pxNetworkBuffer->pxEndPoint;
+		pxSocket->xRouteCache.uxGeneration = pxIPStack->uxRouteGeneration;
+	}
+
+#endif /* ipconfigUSE_ROUTING */
+/*-----------------------------------------------------------*/
+
 /*
  *	FreeRTOS_TCP_IP has only 2 public functions, this is the second one:
  *	xProcessReceivedTCPPacket()
@@ -3083,6 +3225,7 @@ const IPHeader_t *pxIPHeader;
 	/* Check for a minimum packet size. */
 	if( pxNetworkBuffer->xDataLength < ( ipSIZE_OF_ETH_HEADER + xIPHeaderSize( pxNetworkBuffer ) + ipSIZE_OF_TCP_HEADER ) )
 	{
+		ipSTATS_COUNT_DROP( eIPDropMalformed );
 		xResult = pdFAIL;
 	}
 	else
@@ -3104,6 +3247,7 @@ const IPHeader_t *pxIPHeader;
 			eTIME_WAIT. */
 
 			FreeRTOS_debug_printf( ( "TCP: No active socket on port %d (%lxip:%d)\n", xLocalPort, ulRemoteIP, xRemotePort ) );
+			ipSTATS_COUNT_DROP( eIPDropNoSocket );
 
 			/* Send a RST to all packets that can not be handled.  As a result
 			the other party will get a ECONN error.  There are two exceptions:
@@ -3130,21 +3274,43 @@ const IPHeader_t *pxIPHeader;
 				has set the SYN flag. */
 				if( ( ucTCPFlags & tcpTCP_FLAG_CTRL ) != tcpTCP_FLAG_SYN )
 				{
-					/* What happens: maybe after a reboot, a client doesn't know the
-					connection had gone.  Send a RST in order to get a new connect
-					request. */
-					#if( ipconfigHAS_DEBUG_PRINTF == 1 )
+				FreeRTOS_Socket_t *pxChildSocket = NULL;
+
+					#if( ipconfigTCP_SYN_CACHE_ENTRIES > 0 )
 					{
-					FreeRTOS_debug_printf( ( "TCP: Server can't handle flags: %s from %lxip:%u to port %u\n",
-						prvTCPFlagMeaning( ( UBaseType_t ) ucTCPFlags ), ulRemoteIP, xRemotePort, xLocalPort ) );
+						/* This may be the ACK that completes a handshake which
+						is stored in the SYN cache. */
+						if( ( ucTCPFlags & ( tcpTCP_FLAG_SYN | tcpTCP_FLAG_RST | tcpTCP_FLAG_ACK ) ) == tcpTCP_FLAG_ACK )
+						{
+							pxChildSocket = prvSynCacheComplete( pxSocket, pxNetworkBuffer );
+						}
 					}
-					#endif /* ipconfigHAS_DEBUG_PRINTF */
+					#endif /* ipconfigTCP_SYN_CACHE_ENTRIES */
 
-					if( ( ucTCPFlags & tcpTCP_FLAG_RST ) == 0U )
+					if( pxChildSocket != NULL )
 					{
-						( void ) prvTCPSendReset( pxNetworkBuffer );
+						/* The new socket is in eSYN_RECEIVED state, it will
+						handle the ACK as usual. */
+						pxSocket = pxChildSocket;
+					}
+					else
+					{
+						/* What happens: maybe after a reboot, a client doesn't know the
+						connection had gone.  Send a RST in order to get a new connect
+						request. */
+						#if( ipconfigHAS_DEBUG_PRINTF == 1 )
+						{
+						FreeRTOS_debug_printf( ( "TCP: Server can't handle flags: %s from %lxip:%u to port %u\n",
+							prvTCPFlagMeaning( ( UBaseType_t ) ucTCPFlags ), ulRemoteIP, xRemotePort, xLocalPort ) );
+						}
+						#endif /* ipconfigHAS_DEBUG_PRINTF */
+
+						if( ( ucTCPFlags & tcpTCP_FLAG_RST ) == 0U )
+						{
+							( void ) prvTCPSendReset( pxNetworkBuffer );
+						}
+						xResult = pdFAIL;
 					}
-					xResult = pdFAIL;
 				}
 				else
 				{
@@ -3302,7 +3468,7 @@ uint32_t ulInitialSequenceNumber;
 
 	/* Assume that a new Initial Sequence Number will be required. Request
 	it now in order to fail out if necessary. */
-	ulInitialSequenceNumber = ulApplicationGetNextSequenceNumber( *ipLOCAL_IP_ADDRESS_POINTER,
+	ulInitialSequenceNumber = ulApplicationGetNextSequenceNumber( ipBUFFER_IP_ADDRESS( pxNetworkBuffer ),
 																  pxSocket->usLocalPort,
 																  pxTCPPacket->xIPHeader.ulSourceIPAddress,
 																  pxTCPPacket->xTCPHeader.usSourcePort );
@@ -3332,9 +3498,18 @@ uint32_t ulInitialSequenceNumber;
 					pxSocket->u.xTCP.usChildCount,
 					pxSocket->u.xTCP.usBacklog,
 					( pxSocket->u.xTCP.usChildCount == 1U ) ? "" : "ren" ) );
+				ipSTATS_COUNT_DROP( eIPDropListenBacklog );
 				( void ) prvTCPSendReset( pxNetworkBuffer );
 			}
 			else
+			#if( ipconfigTCP_SYN_CACHE_ENTRIES > 0 )
+			{
+				/* Do not create a new socket yet, wait until the peer has
+				acknowledged the SYN+ACK.  NULL is returned because the network
+				buffer was used to send the SYN+ACK and it was not consumed. */
+				prvSynCacheAdd( pxSocket, pxNetworkBuffer, ulInitialSequenceNumber );
+			}
+			#else
 			{
 				FreeRTOS_Socket_t *pxNewSocket = ( FreeRTOS_Socket_t * )
 					FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
@@ -3357,6 +3532,7 @@ uint32_t ulInitialSequenceNumber;
 					/* Copying failed somehow. */
 				}
 			}
+			#endif /* ipconfigTCP_SYN_CACHE_ENTRIES */
 		}
 	}
 
@@ -3369,6 +3545,11 @@ uint32_t ulInitialSequenceNumber;
 		pxReturn->u.xTCP.usRemotePort = FreeRTOS_htons( pxTCPPacket->xTCPHeader.usSourcePort );
 		pxReturn->u.xTCP.ulRemoteIP = FreeRTOS_htonl( pxTCPPacket->xIPHeader.ulSourceIPAddress );
 		pxReturn->u.xTCP.xTCPWindow.ulOurSequenceNumber = ulInitialSequenceNumber;
+		#if( ipconfigUSE_ROUTING != 0 )
+		{
+			prvSocketSetRoute( pxReturn, pxNetworkBuffer );
+		}
+		#endif
 
 		/* Here is the SYN action. */
 		pxReturn->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = FreeRTOS_ntohl( pxProtocolHeaders->xTCPHeader.ulSequenceNumber );
@@ -3397,6 +3578,7 @@ BaseType_t xResult;
 	pxNewSocket->xReceiveBlockTime = pxSocket->xReceiveBlockTime;
 	pxNewSocket->xSendBlockTime = pxSocket->xSendBlockTime;
 	pxNewSocket->ucSocketOptions = pxSocket->ucSocketOptions;
+	pxNewSocket->ucTOS = pxSocket->ucTOS;
 	pxNewSocket->u.xTCP.uxRxStreamSize = pxSocket->u.xTCP.uxRxStreamSize;
 	pxNewSocket->u.xTCP.uxTxStreamSize = pxSocket->u.xTCP.uxTxStreamSize;
 	pxNewSocket->u.xTCP.uxLittleSpace = pxSocket->u.xTCP.uxLittleSpace;
@@ -3431,6 +3613,15 @@ BaseType_t xResult;
 	}
 	#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
 
+	#if( ipconfigTCP_REUSE_PORT == 1 )
+	{
+		/* More sockets may be listening to this port: remember which one
+		created this child, so it can only be accepted by its own parent. */
+		pxNewSocket->u.xTCP.pxListenSocket = pxSocket;
+		pxNewSocket->u.xTCP.bits.bReusePort = pxSocket->u.xTCP.bits.bReusePort;
+	}
+	#endif /* ipconfigTCP_REUSE_PORT */
+
 	/* And bind it to the same local port as its parent. */
 	xAddress.sin_addr = *ipLOCAL_IP_ADDRESS_POINTER;
 	xAddress.sin_port = FreeRTOS_htons( pxSocket->usLocalPort );
@@ -3485,6 +3676,275 @@ BaseType_t xResult;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigTCP_SYN_CACHE_ENTRIES > 0 )
+
+	static void prvSynCacheAdd( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulInitialSequenceNumber )
+	{
+	/* Map the ethernet buffer onto a TCPPacket_t struct for easy access to the fields. */
+	TCPPacket_t *pxTCPPacket = ipPOINTER_CAST( TCPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+	TCPHeader_t *pxTCPHeader = &( pxTCPPacket->xTCPHeader );
+	uint32_t ulRemoteIP = FreeRTOS_ntohl( pxTCPPacket->xIPHeader.ulSourceIPAddress );
+	uint16_t usRemotePort = FreeRTOS_ntohs( pxTCPHeader->usSourcePort );
+	uint32_t ulPeerSequenceNumber = FreeRTOS_ntohl( pxTCPHeader->ulSequenceNumber );
+	const size_t uxOptionOffset = ipSIZE_OF_ETH_HEADER + xIPHeaderSize( pxNetworkBuffer ) + ipSIZE_OF_TCP_HEADER;
+	const TickType_t xTimeout = pdMS_TO_TICKS( ipconfigTCP_SYN_CACHE_TIMEOUT_MS );
+	TickType_t xNow = xTaskGetTickCount();
+	TCPSynCacheEntry_t *pxEntry = NULL, *pxFree = NULL, *pxOldest = NULL;
+	TCPSynCacheEntry_t *pxCandidate;
+	UBaseType_t uxIndex, uxOptionsLength;
+	size_t uxLength;
+	uint32_t ulSpace;
+
+		for( uxIndex = 0U; uxIndex < ( UBaseType_t ) ipconfigTCP_SYN_CACHE_ENTRIES; uxIndex++ )
+		{
+			pxCandidate = &( pxIPStack->xTCPSynCache[ uxIndex ] );
+
+			if( ( pxCandidate->pxListenSocket == pxSocket ) &&
+				( pxCandidate->ulRemoteIP == ulRemoteIP ) &&
+				( pxCandidate->usRemotePort == usRemotePort ) )
+			{
+				/* The peer has sent a SYN before. */
+				pxEntry = pxCandidate;
+				break;
+			}
+
+			if( ( pxCandidate->pxListenSocket == NULL ) || ( ( xNow - pxCandidate->xCreationTime ) >= xTimeout ) )
+			{
+				if( pxFree == NULL )
+				{
+					pxFree = pxCandidate;
+				}
+			}
+			else if( ( pxOldest == NULL ) || ( ( xNow - pxCandidate->xCreationTime ) > ( xNow - pxOldest->xCreationTime ) ) )
+			{
+				pxOldest = pxCandidate;
+			}
+			else
+			{
+				/* This entry is still in use. */
+			}
+		}
+
+		if( ( pxEntry != NULL ) && ( pxEntry->ulPeerSequenceNumber == ulPeerSequenceNumber ) )
+		{
+			/* The peer did not receive our SYN+ACK and has repeated its SYN.
+			Send the same SYN+ACK again. */
+		}
+		else
+		{
+			if( pxEntry == NULL )
+			{
+				if( pxFree != NULL )
+				{
+					pxEntry = pxFree;
+				}
+				else
+				{
+					/* The cache is full: overwrite the oldest connection
+					request.  That peer will have to try again. */
+					pxEntry = pxOldest;
+					iptraceTCP_SYN_CACHE_OVERFLOW( pxEntry->pxListenSocket );
+					ipSTATS_COUNT_DROP( eIPDropListenBacklog );
+					FreeRTOS_debug_printf( ( "SYN cache: full, drop request from %lxip:%u\n",
+						pxEntry->ulRemoteIP, pxEntry->usRemotePort ) );
+				}
+			}
+
+			pxEntry->pxListenSocket = pxSocket;
+			pxEntry->xCreationTime = xNow;
+			pxEntry->ulRemoteIP = ulRemoteIP;
+			pxEntry->usRemotePort = usRemotePort;
+			pxEntry->ulPeerSequenceNumber = ulPeerSequenceNumber;
+			pxEntry->ulOurSequenceNumber = ulInitialSequenceNumber;
+			#if( ipconfigUSE_TCP_WIN != 0 )
+			{
+				/* The new socket will have the same reception window as
+				the listening socket. */
+				pxEntry->ucWinScaleFactor = prvWinScaleFactor( pxSocket );
+			}
+			#else
+			{
+				pxEntry->ucWinScaleFactor = 0U;
+			}
+			#endif
+
+			/* Store the options, they will be parsed when the new socket has
+			been created. */
+			uxLength = 0U;
+			if( ( pxTCPHeader->ucTCPOffset & tcpTCP_OFFSET_LENGTH_BITS ) > tcpTCP_OFFSET_STANDARD_LENGTH )
+			{
+				uxLength = ( ( size_t ) ( pxTCPHeader->ucTCPOffset >> 4U ) << 2U ) - ipSIZE_OF_TCP_HEADER;
+				if( pxNetworkBuffer->xDataLength < ( uxOptionOffset + uxLength ) )
+				{
+					/* The options are truncated, ignore them. */
+					uxLength = 0U;
+				}
+			}
+			uxLength = FreeRTOS_min_uint32( ( uint32_t ) uxLength, ( uint32_t ) tcpSYN_CACHE_OPTIONS_LENGTH );
+			( void ) memcpy( pxEntry->ucOptions, &( pxNetworkBuffer->pucEthernetBuffer[ uxOptionOffset ] ), uxLength );
+			pxEntry->ucOptionsLength = ( uint8_t ) uxLength;
+		}
+
+		/* Advertise the same reception window as prvTCPReturnPacket() would
+		do for a new socket. */
+		ulSpace = FreeRTOS_min_uint32( ( ( uint32_t ) ipconfigTCP_MSS ) * ( ( uint32_t ) pxSocket->u.xTCP.uxRxWinSize ),
+									   ( uint32_t ) ipTCP_RX_STREAM_INITIAL_SIZE( pxSocket ) );
+		ulSpace = FreeRTOS_min_uint32( ulSpace >> pxEntry->ucWinScaleFactor, 0xfffcUL );
+
+		/* Turn the SYN into a SYN+ACK.  When it is called without a socket,
+		prvTCPReturnPacket() will swap the addresses, the port numbers, and
+		also the sequence and the acknowledge number. */
+		pxTCPHeader->ulSequenceNumber = FreeRTOS_htonl( pxEntry->ulPeerSequenceNumber + 1UL );
+		pxTCPHeader->ulAckNr = FreeRTOS_htonl( pxEntry->ulOurSequenceNumber );
+		pxTCPHeader->ucTCPFlags = ( uint8_t ) tcpTCP_FLAG_SYN | ( uint8_t ) tcpTCP_FLAG_ACK;
+		pxTCPHeader->usWindow = FreeRTOS_htons( ( uint16_t ) ulSpace );
+		pxTCPHeader->usUrgent = 0U;
+
+		uxOptionsLength = prvWriteSynAckOptions( pxTCPHeader,
+												 ( uint16_t ) prvGetMSSForPeer( pxTCPPacket->xIPHeader.ulSourceIPAddress ),
+												 pxEntry->ucWinScaleFactor );
+		pxTCPHeader->ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+
+		prvTCPReturnPacket( NULL, pxNetworkBuffer, ( uint32_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength ), pdFALSE );
+	}
+	/*-----------------------------------------------------------*/
+
+	static FreeRTOS_Socket_t *prvSynCacheComplete( const FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	/* Map the ethernet buffer onto a TCPPacket_t struct for easy access to the fields. */
+	const TCPPacket_t *pxTCPPacket = ipPOINTER_CAST( const TCPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+	uint32_t ulRemoteIP = FreeRTOS_ntohl( pxTCPPacket->xIPHeader.ulSourceIPAddress );
+	uint16_t usRemotePort = FreeRTOS_ntohs( pxTCPPacket->xTCPHeader.usSourcePort );
+	uint32_t ulSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+	uint32_t ulAckNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr );
+	TCPSynCacheEntry_t *pxEntry = NULL;
+	FreeRTOS_Socket_t *pxListenSocket, *pxNewSocket, *pxReturn = NULL;
+	TCPWindow_t *pxTCPWindow;
+	const uint8_t *pucPtr;
+	size_t uxOptionsLength, uxResult;
+	UBaseType_t uxIndex;
+
+		for( uxIndex = 0U; uxIndex < ( UBaseType_t ) ipconfigTCP_SYN_CACHE_ENTRIES; uxIndex++ )
+		{
+			/* With FREERTOS_SO_REUSE_PORT, the entry may belong to another
+			socket listening to the same port. */
+			if( ( pxIPStack->xTCPSynCache[ uxIndex ].pxListenSocket != NULL ) &&
+				( pxIPStack->xTCPSynCache[ uxIndex ].pxListenSocket->usLocalPort == pxSocket->usLocalPort ) &&
+				( pxIPStack->xTCPSynCache[ uxIndex ].ulRemoteIP == ulRemoteIP ) &&
+				( pxIPStack->xTCPSynCache[ uxIndex ].usRemotePort == usRemotePort ) )
+			{
+				pxEntry = &( pxIPStack->xTCPSynCache[ uxIndex ] );
+				break;
+			}
+		}
+
+		/* The ACK must acknowledge our SYN+ACK. */
+		if( ( pxEntry != NULL ) &&
+			( ulAckNumber == ( pxEntry->ulOurSequenceNumber + 1UL ) ) &&
+			( ulSequenceNumber == ( pxEntry->ulPeerSequenceNumber + 1UL ) ) )
+		{
+			pxListenSocket = pxEntry->pxListenSocket;
+
+			/* The entry is not needed any more. */
+			pxEntry->pxListenSocket = NULL;
+
+			if( pxListenSocket->u.xTCP.usChildCount >= pxListenSocket->u.xTCP.usBacklog )
+			{
+				FreeRTOS_printf( ( "Check: Socket %u already has %u / %u child%s\n",
+					pxListenSocket->usLocalPort,
+					pxListenSocket->u.xTCP.usChildCount,
+					pxListenSocket->u.xTCP.usBacklog,
+					( pxListenSocket->u.xTCP.usChildCount == 1U ) ? "" : "ren" ) );
+			}
+			else
+			{
+				pxNewSocket = ( FreeRTOS_Socket_t * ) FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+				if( ( pxNewSocket == NULL ) || ( pxNewSocket == FREERTOS_INVALID_SOCKET ) )
+				{
+					FreeRTOS_debug_printf( ( "TCP: Listen: new socket failed\n" ) );
+				}
+				else if( prvTCPSocketCopy( pxNewSocket, pxListenSocket ) != pdFALSE )
+				{
+					/* Initialise the new socket in the same way as
+					prvHandleListen() does. */
+					pxNewSocket->u.xTCP.usRemotePort = usRemotePort;
+					pxNewSocket->u.xTCP.ulRemoteIP = ulRemoteIP;
+					pxNewSocket->u.xTCP.xTCPWindow.ulOurSequenceNumber = pxEntry->ulOurSequenceNumber;
+					pxNewSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = pxEntry->ulPeerSequenceNumber;
+					#if( ipconfigUSE_ROUTING != 0 )
+					{
+						prvSocketSetRoute( pxNewSocket, pxNetworkBuffer );
+					}
+					#endif
+					prvSocketSetMSS( pxNewSocket );
+
+					prvTCPCreateWindow( pxNewSocket );
+
+					/* Parse the options of the SYN, as if it was received now. */
+					pucPtr = pxEntry->ucOptions;
+					uxOptionsLength = ( size_t ) pxEntry->ucOptionsLength;
+					while( uxOptionsLength > 0U )
+					{
+						uxResult = prvSingleStepTCPHeaderOptions( pucPtr, uxOptionsLength, pxNewSocket, pdTRUE );
+						if( uxResult == 0U )
+						{
+							break;
+						}
+						uxOptionsLength -= uxResult;
+						pucPtr = &( pucPtr[ uxResult ] );
+					}
+
+					#if( ipconfigUSE_TCP_WIN != 0 )
+					{
+						pxNewSocket->u.xTCP.ucMyWinScaleFactor = pxEntry->ucWinScaleFactor;
+					}
+					#endif
+
+					/* The SYN+ACK has been sent already, do what the state
+					eSYN_FIRST would have done. */
+					vTCPStateChange( pxNewSocket, eSYN_RECEIVED );
+
+					pxTCPWindow = &( pxNewSocket->u.xTCP.xTCPWindow );
+					pxTCPWindow->rx.ulHighestSequenceNumber = pxEntry->ulPeerSequenceNumber + 1UL;
+					pxTCPWindow->rx.ulCurrentSequenceNumber = pxEntry->ulPeerSequenceNumber + 1UL;
+					pxTCPWindow->ulNextTxSequenceNumber     = pxTCPWindow->tx.ulFirstSequenceNumber + 1UL;
+					pxTCPWindow->tx.ulCurrentSequenceNumber = pxTCPWindow->tx.ulFirstSequenceNumber + 1UL;
+
+					/* Make a copy of the header up to the TCP header.  It is
+					needed later on, whenever data must be sent to the peer. */
+					( void ) memcpy( pxNewSocket->u.xTCP.xPacket.u.ucLastPacket, pxNetworkBuffer->pucEthernetBuffer, sizeof( pxNewSocket->u.xTCP.xPacket.u.ucLastPacket ) );
+
+					pxReturn = pxNewSocket;
+				}
+				else
+				{
+					/* Copying failed somehow. */
+				}
+			}
+		}
+
+		return pxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vTCPSynCacheFlush( const FreeRTOS_Socket_t *pxSocket )
+	{
+	UBaseType_t uxIndex;
+
+		/* Called from vSocketClose(), in the IP-task. */
+		for( uxIndex = 0U; uxIndex < ( UBaseType_t ) ipconfigTCP_SYN_CACHE_ENTRIES; uxIndex++ )
+		{
+			if( pxIPStack->xTCPSynCache[ uxIndex ].pxListenSocket == pxSocket )
+			{
+				pxIPStack->xTCPSynCache[ uxIndex ].pxListenSocket = NULL;
+			}
+		}
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_ENTRIES */
+/*-----------------------------------------------------------*/
+
 #if( ( ipconfigHAS_DEBUG_PRINTF != 0 ) || ( ipconfigHAS_PRINTF != 0 ) )
 
 	const char *FreeRTOS_GetTCPStateName( UBaseType_t ulState )
@@ -3529,18 +3989,23 @@ TickType_t uxLocalPort = ( TickType_t ) FreeRTOS_htons( pxSocket->usLocalPort );
 const ListItem_t *pxIterator;
 FreeRTOS_Socket_t *pxFound;
 BaseType_t xResult = pdFALSE;
-const ListItem_t *pxEndTCP = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xBoundTCPSocketsList ) );
+const ListItem_t *pxEndTCP = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxIPStack->xBoundTCPSocketsList ) );
 
 	/* Here xBoundTCPSocketsList can be accessed safely IP-task is the only one
 	who has access. */
-	for( pxIterator = ( const ListItem_t * ) listGET_HEAD_ENTRY( &xBoundTCPSocketsList );
+	for( pxIterator = ( const ListItem_t * ) listGET_HEAD_ENTRY( &pxIPStack->xBoundTCPSocketsList );
 		pxIterator != pxEndTCP;
 		pxIterator = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
 	{
 		if( listGET_LIST_ITEM_VALUE( pxIterator ) == ( configLIST_VOLATILE TickType_t ) uxLocalPort )
 		{
 			pxFound = ipPOINTER_CAST( FreeRTOS_Socket_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+			#if( ipconfigTCP_REUSE_PORT == 1 )
+			if( ( pxFound->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP ) && ( pxFound->u.xTCP.bits.bPassAccept != pdFALSE_UNSIGNED ) &&
+				( ( pxFound->u.xTCP.pxListenSocket == pxSocket ) || ( pxFound->u.xTCP.pxListenSocket == NULL ) ) )
+			#else
 			if( ( pxFound->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP ) && ( pxFound->u.xTCP.bits.bPassAccept != pdFALSE_UNSIGNED ) )
+			#endif
 			{
 				pxSocket->u.xTCP.pxPeerSocket = pxFound;
 				FreeRTOS_debug_printf( ( "xTCPCheckNewClient[0]: client on port %u\n", pxSocket->usLocalPort ) );
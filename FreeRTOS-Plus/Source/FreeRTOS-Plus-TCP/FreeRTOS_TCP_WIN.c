@@ -45,6 +45,7 @@
 #include "FreeRTOS_IP.h"
 #include "FreeRTOS_Sockets.h"
 #include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_IP_Stack.h"
 
 #include "FreeRTOSIPConfigDefaults.h"
 
@@ -187,16 +188,6 @@ static void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 
 /*-----------------------------------------------------------*/
 
-/* TCP segment pool. */
-#if( ipconfigUSE_TCP_WIN == 1 )
-	static TCPSegment_t *xTCPSegments = NULL;
-#endif /* ipconfigUSE_TCP_WIN == 1 */
-
-/* List of free TCP segments. */
-#if( ipconfigUSE_TCP_WIN == 1 )
-	_static List_t xSegmentList;
-#endif
-
 /* Logging verbosity level. */
 BaseType_t xTCPWindowLoggingLevel = 0;
 
@@ -329,30 +320,32 @@ static void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 
 		/* Allocate space for 'xTCPSegments' and store them in 'xSegmentList'. */
 
-		vListInitialise( &xSegmentList );
-		xTCPSegments = ipPOINTER_CAST( TCPSegment_t *, pvPortMallocLarge( ( size_t ) ipconfigTCP_WIN_SEG_COUNT * sizeof( xTCPSegments[ 0 ] ) ) );
+		vListInitialise( &pxIPStack->xSegmentList );
+		pxIPStack->xTCPSegments = ipPOINTER_CAST( TCPSegment_t *, pvPortMallocLarge( ( size_t ) ipconfigTCP_WIN_SEG_COUNT * sizeof( pxIPStack->xTCPSegments[ 0 ] ) ) );
 
-		if( xTCPSegments == NULL )
+		if( pxIPStack->xTCPSegments == NULL )
 		{
 			FreeRTOS_debug_printf( ( "prvCreateSectors: malloc %u failed\n",
-				( unsigned ) ipconfigTCP_WIN_SEG_COUNT * sizeof( xTCPSegments[ 0 ] ) ) );
+				( unsigned ) ipconfigTCP_WIN_SEG_COUNT * sizeof( pxIPStack->xTCPSegments[ 0 ] ) ) );
 
 			xReturn = pdFAIL;
 		}
 		else
 		{
+			iptraceMEM_STATS_CREATE( tcpTCP_WIN_SEGMENTS, pxIPStack->xTCPSegments, ( size_t ) ipconfigTCP_WIN_SEG_COUNT * sizeof( pxIPStack->xTCPSegments[ 0 ] ) );
+
 			/* Clear the allocated space. */
-			( void ) memset( xTCPSegments, 0, ( size_t ) ipconfigTCP_WIN_SEG_COUNT * sizeof( xTCPSegments[ 0 ] ) );
+			( void ) memset( pxIPStack->xTCPSegments, 0, ( size_t ) ipconfigTCP_WIN_SEG_COUNT * sizeof( pxIPStack->xTCPSegments[ 0 ] ) );
 
 			for( xIndex = 0; xIndex < ipconfigTCP_WIN_SEG_COUNT; xIndex++ )
 			{
 				/* Could call vListInitialiseItem here but all data has been
 				nulled already.  Set the owner to a segment descriptor. */
-				listSET_LIST_ITEM_OWNER( &( xTCPSegments[ xIndex ].xSegmentItem  ), ipPOINTER_CAST( void *, &( xTCPSegments[ xIndex ] ) ) );
-				listSET_LIST_ITEM_OWNER( &( xTCPSegments[ xIndex ].xQueueItem ), ipPOINTER_CAST( void *, &( xTCPSegments[ xIndex ] ) ) );
+				listSET_LIST_ITEM_OWNER( &( pxIPStack->xTCPSegments[ xIndex ].xSegmentItem  ), ipPOINTER_CAST( void *, &( pxIPStack->xTCPSegments[ xIndex ] ) ) );
+				listSET_LIST_ITEM_OWNER( &( pxIPStack->xTCPSegments[ xIndex ].xQueueItem ), ipPOINTER_CAST( void *, &( pxIPStack->xTCPSegments[ xIndex ] ) ) );
 
 				/* And add it to the pool of available segments */
-				vListInsertFifo( &xSegmentList, &( xTCPSegments[xIndex].xSegmentItem ) );
+				vListInsertFifo( &pxIPStack->xSegmentList, &( pxIPStack->xTCPSegments[xIndex].xSegmentItem ) );
 			}
 
 			xReturn = pdPASS;
@@ -404,7 +397,7 @@ static void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 
 		/* Allocate a new segment.  The socket will borrow all segments from a
 		common pool: 'xSegmentList', which is a list of 'TCPSegment_t' */
-		if( listLIST_IS_EMPTY( &xSegmentList ) != pdFALSE )
+		if( listLIST_IS_EMPTY( &pxIPStack->xSegmentList ) != pdFALSE )
 		{
 			/* If the TCP-stack runs out of segments, you might consider
 			increasing 'ipconfigTCP_WIN_SEG_COUNT'. */
@@ -415,7 +408,7 @@ static void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 		{
 			/* Pop the item at the head of the list.  Semaphore protection is
 			not required as only the IP task will call these functions.  */
-			pxItem = ( ListItem_t * ) listGET_HEAD_ENTRY( &xSegmentList );
+			pxItem = ( ListItem_t * ) listGET_HEAD_ENTRY( &pxIPStack->xSegmentList );
 			pxSegment = ipPOINTER_CAST( TCPSegment_t *, listGET_LIST_ITEM_OWNER( pxItem ) );
 
 			configASSERT( pxItem != NULL );
@@ -445,7 +438,7 @@ static void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 			#if( ipconfigHAS_DEBUG_PRINTF != 0 )
 			{
 			static UBaseType_t xLowestLength = ipconfigTCP_WIN_SEG_COUNT;
-			UBaseType_t xLength = listCURRENT_LIST_LENGTH( &xSegmentList );
+			UBaseType_t xLength = listCURRENT_LIST_LENGTH( &pxIPStack->xSegmentList );
 
 				if( xLowestLength > xLength )
 				{
@@ -571,7 +564,7 @@ static void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 		}
 
 		/* Return it to xSegmentList */
-		vListInsertFifo( &xSegmentList, &( pxSegment->xSegmentItem ) );
+		vListInsertFifo( &pxIPStack->xSegmentList, &( pxSegment->xSegmentItem ) );
 	}
 
 #endif /* ipconfigUSE_TCP_WIN == 1 */
@@ -621,7 +614,7 @@ void vTCPWindowCreate( TCPWindow_t *pxWindow, uint32_t ulRxWindowLength,
 
 	#if( ipconfigUSE_TCP_WIN == 1 )
 	{
-		if( xTCPSegments == NULL )
+		if( pxIPStack->xTCPSegments == NULL )
 		{
 			( void ) prvCreateSectors();
 		}
@@ -709,10 +702,11 @@ const int32_t l500ms = 500;
         /* Free and clear the TCP segments pointer. This function should only be called
          * once FreeRTOS+TCP will no longer be used. No thread-safety is provided for this
          * function. */
-        if( xTCPSegments != NULL )
+        if( pxIPStack->xTCPSegments != NULL )
         {
-            vPortFreeLarge( xTCPSegments );
-            xTCPSegments = NULL;
+            iptraceMEM_STATS_DELETE( pxIPStack->xTCPSegments );
+            vPortFreeLarge( pxIPStack->xTCPSegments );
+            pxIPStack->xTCPSegments = NULL;
         }
     }
 
@@ -1448,6 +1442,16 @@ const int32_t l500ms = 500;
 			the waiting queue. */
 			vListInsertFifo( &pxWindow->xWaitQueue, &pxSegment->xQueueItem );
 
+			#if( ipconfigUSE_NETWORK_STATS != 0 )
+			{
+				/* A segment that is outstanding already is sent again. */
+				if( pxSegment->u.bits.bOutstanding != pdFALSE_UNSIGNED )
+				{
+					pxWindow->ulRetransmitCount++;
+				}
+			}
+			#endif /* ipconfigUSE_NETWORK_STATS */
+
 			/* And mark it as outstanding. */
 			pxSegment->u.bits.bOutstanding = pdTRUE_UNSIGNED;
 
@@ -1873,6 +1877,14 @@ const int32_t l500ms = 500;
 
 			if( ulLength != 0UL )
 			{
+				#if( ipconfigUSE_NETWORK_STATS != 0 )
+				{
+					if( pxSegment->u.bits.bOutstanding != pdFALSE_UNSIGNED )
+					{
+						pxWindow->ulRetransmitCount++;
+					}
+				}
+				#endif /* ipconfigUSE_NETWORK_STATS */
 				pxSegment->u.bits.bOutstanding = pdTRUE_UNSIGNED;
 				pxSegment->u.bits.ucTransmitCount++;
 				vTCPTimerSet (&pxSegment->xTransmitTimer);
@@ -0,0 +1,278 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * A transmit scheduler in front of the network driver.  The packets that the
+ * IP-task sends are queued in one of four classes, chosen by the TOS byte of
+ * the IP-header.  Each time the IP-task wakes up, the queued packets are
+ * passed to the driver with deficit round robin: in every round a class may
+ * send the quantum times its weight in bytes, so a bulk transfer in a low
+ * class can not hold up the packets of an interactive socket in a higher one.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_IP_Private.h"
+
+#include "FreeRTOSIPConfigDefaults.h"
+
+/* Exclude the entire file if the transmit scheduler is not enabled. */
+#if( ipconfigUSE_TX_SCHEDULER != 0 )
+
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+#include "FreeRTOS_IP_Stack.h"
+
+/*
+ * Returns the class of an outgoing packet.
+ */
+static UBaseType_t prvGetClass( const NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+/*
+ * Remove the first packet of a class and pass it to the driver.
+ */
+static void prvSendFirstPacket( TxClass_t *pxClass );
+
+/*-----------------------------------------------------------*/
+
+void vTxSchedulerInit( void )
+{
+UBaseType_t uxClass;
+
+	for( uxClass = 0U; uxClass < ipTX_SCHEDULER_CLASS_COUNT; uxClass++ )
+	{
+		vListInitialise( &( pxIPStack->xTxClasses[ uxClass ].xPackets ) );
+		pxIPStack->xTxClasses[ uxClass ].ulDeficit = 0U;
+
+		/* Only change the weight if it hasn't been set already. */
+		if( pxIPStack->xTxClasses[ uxClass ].ucWeight == 0U )
+		{
+			pxIPStack->xTxClasses[ uxClass ].ucWeight = ( uint8_t ) ( 1U << uxClass );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvGetClass( const NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+const IPPacket_t *pxIPPacket = ipPOINTER_CAST( const IPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+UBaseType_t uxClass;
+
+	if( ( pxNetworkBuffer->xDataLength >= sizeof( IPPacket_t ) ) &&
+		( pxIPPacket->xEthernetHeader.usFrameType == ipIPv4_FRAME_TYPE ) )
+	{
+		uxClass = ipTX_SCHEDULER_CLASS_FROM_TOS( pxIPPacket->xIPHeader.ucDifferentiatedServicesCode );
+	}
+	else
+	{
+		/* ARP and other protocols are needed to keep the network going. */
+		uxClass = ipTX_SCHEDULER_CLASS_COUNT - 1U;
+	}
+
+	return uxClass;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTxSchedulerOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+{
+BaseType_t xReturn;
+NetworkBufferDescriptor_t *pxUseBuffer = pxNetworkBuffer;
+TxClass_t *pxClass;
+UBaseType_t uxClass;
+
+	if( ( xReleaseAfterSend == pdFALSE ) && ( xIsCallingFromIPTask() != pdFALSE ) )
+	{
+		/* The buffer still belongs to the caller, which is the case for TCP
+		packets when ipconfigZERO_COPY_TX_DRIVER is 0.  Queue a copy. */
+		pxUseBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+	}
+
+	if( ( pxUseBuffer == NULL ) || ( xIsCallingFromIPTask() == pdFALSE ) )
+	{
+		/* The lists can only be accessed by the IP-task, or there was no
+		buffer for a copy: send it right away. */
+		xReturn = ipNETWORK_ROUTE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend );
+	}
+	else
+	{
+		uxClass = prvGetClass( pxUseBuffer );
+		pxClass = &( pxIPStack->xTxClasses[ uxClass ] );
+
+		if( listCURRENT_LIST_LENGTH( &( pxClass->xPackets ) ) >= ( UBaseType_t ) ipconfigTX_SCHEDULER_MAX_QUEUED )
+		{
+			iptraceTX_SCHEDULER_DROP( pxUseBuffer, uxClass );
+			ipSTATS_COUNT_DROP( eIPDropTxQueueFull );
+			pxClass->xStats.ulDropped++;
+			vReleaseNetworkBufferAndDescriptor( pxUseBuffer );
+			xReturn = pdFALSE;
+		}
+		else
+		{
+			/* The driver is called from vTxSchedulerProcess(), before the
+			IP-task goes to sleep. */
+			listSET_LIST_ITEM_VALUE( &( pxUseBuffer->xBufferListItem ), xTaskGetTickCount() );
+			vListInsertEnd( &( pxClass->xPackets ), &( pxUseBuffer->xBufferListItem ) );
+			pxIPStack->uxTxQueuedCount++;
+			xReturn = pdTRUE;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendFirstPacket( TxClass_t *pxClass )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+TickType_t xDelay;
+
+	pxNetworkBuffer = ipPOINTER_CAST( NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( &( pxClass->xPackets ) ) );
+	( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+	pxIPStack->uxTxQueuedCount--;
+
+	xDelay = xTaskGetTickCount() - listGET_LIST_ITEM_VALUE( &( pxNetworkBuffer->xBufferListItem ) );
+
+	/* The statistics are read by other tasks while the scheduler is
+	suspended. */
+	vTaskSuspendAll();
+	{
+		pxClass->xStats.ulPackets++;
+		pxClass->xStats.ulBytes += ( uint32_t ) pxNetworkBuffer->xDataLength;
+		pxClass->xStats.xTotalDelay += xDelay;
+		if( pxClass->xStats.xMaxDelay < xDelay )
+		{
+			pxClass->xStats.xMaxDelay = xDelay;
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	( void ) ipNETWORK_ROUTE_OUTPUT( pxNetworkBuffer, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+void vTxSchedulerProcess( void )
+{
+UBaseType_t uxSent = 0U;
+TxClass_t *pxClass;
+const NetworkBufferDescriptor_t *pxFirst;
+
+	while( ( pxIPStack->uxTxQueuedCount != 0U ) && ( uxSent < ( UBaseType_t ) ipconfigTX_SCHEDULER_BURST ) )
+	{
+		pxClass = &( pxIPStack->xTxClasses[ pxIPStack->uxTxCurrentClass ] );
+
+		if( listCURRENT_LIST_LENGTH( &( pxClass->xPackets ) ) == 0U )
+		{
+			/* An idle class does not save its deficit for later. */
+			pxClass->ulDeficit = 0U;
+			pxIPStack->xTxQuantumGiven = pdFALSE;
+			pxIPStack->uxTxCurrentClass = ( pxIPStack->uxTxCurrentClass + 1U ) % ipTX_SCHEDULER_CLASS_COUNT;
+		}
+		else
+		{
+			if( pxIPStack->xTxQuantumGiven == pdFALSE )
+			{
+				pxClass->ulDeficit += ( uint32_t ) ipconfigTX_SCHEDULER_QUANTUM * pxClass->ucWeight;
+				pxIPStack->xTxQuantumGiven = pdTRUE;
+			}
+
+			pxFirst = ipPOINTER_CAST( const NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( &( pxClass->xPackets ) ) );
+
+			if( pxFirst->xDataLength <= pxClass->ulDeficit )
+			{
+				pxClass->ulDeficit -= ( uint32_t ) pxFirst->xDataLength;
+				prvSendFirstPacket( pxClass );
+				uxSent++;
+			}
+			else
+			{
+				/* The rest of the deficit is kept for the next round. */
+				pxIPStack->xTxQuantumGiven = pdFALSE;
+				pxIPStack->uxTxCurrentClass = ( pxIPStack->uxTxCurrentClass + 1U ) % ipTX_SCHEDULER_CLASS_COUNT;
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTxSchedulerPending( void )
+{
+	return ( pxIPStack->uxTxQueuedCount != 0U ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_SetTxClassWeight( UBaseType_t uxClass, uint8_t ucWeight )
+{
+BaseType_t xReturn;
+
+	if( ( uxClass >= ipTX_SCHEDULER_CLASS_COUNT ) || ( ucWeight == 0U ) )
+	{
+		xReturn = -pdFREERTOS_ERRNO_EINVAL;
+	}
+	else
+	{
+		/* A single byte is written, the IP-task will see either value. */
+		pxIPStack->xTxClasses[ uxClass ].ucWeight = ucWeight;
+		xReturn = 0;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_GetTxClassStats( UBaseType_t uxClass, TxClassStats_t *pxStats )
+{
+BaseType_t xReturn;
+
+	if( ( uxClass >= ipTX_SCHEDULER_CLASS_COUNT ) || ( pxStats == NULL ) )
+	{
+		xReturn = -pdFREERTOS_ERRNO_EINVAL;
+	}
+	else
+	{
+		vTaskSuspendAll();
+		{
+			( void ) memcpy( pxStats, &( pxIPStack->xTxClasses[ uxClass ].xStats ), sizeof( *pxStats ) );
+			pxStats->uxQueued = listCURRENT_LIST_LENGTH( &( pxIPStack->xTxClasses[ uxClass ].xPackets ) );
+		}
+		( void ) xTaskResumeAll();
+		xReturn = 0;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_TX_SCHEDULER */
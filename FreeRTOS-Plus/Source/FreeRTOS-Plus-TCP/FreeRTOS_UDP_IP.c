@@ -42,6 +42,7 @@
 #include "FreeRTOS_DHCP.h"
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
+#include "FreeRTOS_IP_Stack.h"
 
 #if( ipconfigUSE_DNS == 1 )
 	#include "FreeRTOS_DNS.h"
@@ -54,7 +55,7 @@
 UDP packet.  This array defines the constant parts, allowing this part of the
 packet to be filled in using a simple memcpy() instead of individual writes. */
 /*lint -e708 (Info -- union initialization). */
-UDPPacketHeader_t xDefaultPartUDPPacketHeader =
+const UDPPacketHeader_t xDefaultPartUDPPacketHeaderTemplate =
 {
 	/* .ucBytes : */
 	{
@@ -95,6 +96,17 @@ size_t uxPayloadSize;
 		uxPayloadSize = pxNetworkBuffer->xDataLength - sizeof( UDPPacket_t );
 	}
 
+	#if( ipconfigUSE_ROUTING != 0 )
+	{
+		/* Packets sent by a socket have been routed already. */
+		if( pxNetworkBuffer->ulNextHop == 0UL )
+		{
+			vRouteNetworkBuffer( pxNetworkBuffer, pxNetworkBuffer->ulIPAddress );
+		}
+		ulIPAddress = pxNetworkBuffer->ulNextHop;
+	}
+	#endif
+
 	/* Determine the ARP cache status for the requested IP address. */
 	eReturned = eARPGetCacheEntry( &( ulIPAddress ), &( pxUDPPacket->xEthernetHeader.xDestinationAddress ) );
 
@@ -105,6 +117,7 @@ size_t uxPayloadSize;
 			#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
 				uint8_t ucSocketOptions;
 			#endif
+			uint8_t ucTOS;
 			iptraceSENDING_UDP_PACKET( pxNetworkBuffer->ulIPAddress );
 
 			/* Create short cuts to the data within the packet. */
@@ -148,13 +161,29 @@ size_t uxPayloadSize;
 				ucSocketOptions = pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ];
 		}
 			#endif
+			ucTOS = pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_TOS_OFFSET ];
 			/*
 			 * Offset the memcpy by the size of a MAC address to start at the packet's
 			 * Ethernet header 'source' MAC address; the preceding 'destination' should not be altered.
 			 */
 			/* The Ethernet source address is at offset 6. */
 			char *pxUdpSrcAddrOffset = ( char *) ( &( pxNetworkBuffer->pucEthernetBuffer[ sizeof( MACAddress_t ) ] ) );
-			( void ) memcpy( pxUdpSrcAddrOffset, xDefaultPartUDPPacketHeader.ucBytes, sizeof( xDefaultPartUDPPacketHeader ) );
+			( void ) memcpy( pxUdpSrcAddrOffset, pxIPStack->xDefaultPartUDPPacketHeader.ucBytes, sizeof( pxIPStack->xDefaultPartUDPPacketHeader ) );
+
+			#if( ipconfigUSE_ROUTING != 0 )
+			{
+				/* The default header holds the addresses of the primary
+				end-point. */
+				if( pxNetworkBuffer->pxEndPoint != NULL )
+				{
+					( void ) memcpy( pxUdpSrcAddrOffset, pxNetworkBuffer->pxEndPoint->xMACAddress.ucBytes, sizeof( MACAddress_t ) );
+					pxIPHeader->ulSourceIPAddress = pxNetworkBuffer->pxEndPoint->ulIPAddress;
+				}
+			}
+			#endif
+
+			/* DSCP and ECN bits, see FREERTOS_SO_IP_TOS. */
+			pxIPHeader->ucDifferentiatedServicesCode = ucTOS;
 
 		#if ipconfigSUPPORT_OUTGOING_PINGS == 1
 			if( pxNetworkBuffer->usPort == ( uint16_t ) ipPACKET_CONTAINS_ICMP_DATA )
@@ -184,17 +213,20 @@ size_t uxPayloadSize;
 
 			#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
 			{
-				pxIPHeader->usHeaderChecksum = 0U;
-				pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
-				pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
-
-				if( ( ucSocketOptions & ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT ) != 0U )
-				{
-					( void ) usGenerateProtocolChecksum( ( uint8_t * ) pxUDPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
-				}
-				else
+				if( ipCALCULATE_CHECKSUMS( pxIPHeader->ulDestinationIPAddress ) != pdFALSE )
 				{
-					pxUDPPacket->xUDPHeader.usChecksum = 0U;
+					pxIPHeader->usHeaderChecksum = 0U;
+					pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+					pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+
+					if( ( ucSocketOptions & ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT ) != 0U )
+					{
+						( void ) usGenerateProtocolChecksum( ( uint8_t * ) pxUDPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+					}
+					else
+					{
+						pxUDPPacket->xUDPHeader.usChecksum = 0U;
+					}
 				}
 			}
 			#endif
@@ -208,6 +240,7 @@ size_t uxPayloadSize;
 
 			/* Generate an ARP for the required IP address. */
 			iptracePACKET_DROPPED_TO_GENERATE_ARP( pxNetworkBuffer->ulIPAddress );
+			ipSTATS_COUNT_DROP( eIPDropARPPending );
 			pxNetworkBuffer->ulIPAddress = ulIPAddress;
 			vARPGenerateRequestPacket( pxNetworkBuffer );
 		}
@@ -215,6 +248,7 @@ size_t uxPayloadSize;
 		{
 			/* The lookup indicated that an ARP request has already been
 			sent out for the queried IP address. */
+			ipSTATS_COUNT_DROP( eIPDropARPPending );
 			eReturned = eCantSendPacket;
 		}
 	}
@@ -239,7 +273,12 @@ size_t uxPayloadSize;
 		}
 		#endif
 
-		( void ) xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+		#if( ipconfigUSE_LOOPBACK != 0 )
+		if( xLoopbackOutput( pxNetworkBuffer, pdTRUE ) == pdFALSE )
+		#endif
+		{
+			( void ) ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, pdTRUE );
+		}
 	}
 	else
 	{
@@ -303,10 +342,39 @@ const UDPPacket_t *pxUDPPacket = ipPOINTER_CAST( const UDPPacket_t *, pxNetworkB
 			{
 				if ( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) >= pxSocket->u.xUDP.uxMaxPackets )
 				{
-					FreeRTOS_debug_printf( ( "xProcessReceivedUDPPacket: buffer full %ld >= %ld port %u\n",
-						listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ),
-						pxSocket->u.xUDP.uxMaxPackets, pxSocket->usLocalPort ) );
-					xReturn = pdFAIL; /* we did not consume or release the buffer */
+					pxSocket->u.xUDP.ulDroppedCount++;
+					iptraceUDP_RX_QUEUE_OVERFLOW( pxSocket, pxSocket->u.xUDP.xDropOldest );
+					ipSTATS_COUNT_DROP( eIPDropSocketQueueFull );
+
+					if( ( pxSocket->u.xUDP.xDropOldest != pdFALSE ) &&
+						( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) > 0U ) )
+					{
+					NetworkBufferDescriptor_t *pxOldestBuffer;
+
+						/* Make room by releasing the packet that has been
+						waiting the longest.  The new packet will be added to
+						the end of the list. */
+						vTaskSuspendAll();
+						{
+							taskENTER_CRITICAL();
+							{
+								pxOldestBuffer = ipPOINTER_CAST( NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) );
+								( void ) uxListRemove( &( pxOldestBuffer->xBufferListItem ) );
+								pxSocket->u.xUDP.uxWaitingBytes -= pxOldestBuffer->xDataLength;
+							}
+							taskEXIT_CRITICAL();
+						}
+						( void ) xTaskResumeAll();
+
+						vReleaseNetworkBufferAndDescriptor( pxOldestBuffer );
+					}
+					else
+					{
+						FreeRTOS_debug_printf( ( "xProcessReceivedUDPPacket: buffer full %ld >= %ld port %u\n",
+							listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ),
+							pxSocket->u.xUDP.uxMaxPackets, pxSocket->usLocalPort ) );
+						xReturn = pdFAIL; /* we did not consume or release the buffer */
+					}
 				}
 			}
 		}
@@ -325,6 +393,7 @@ const UDPPacket_t *pxUDPPacket = ipPOINTER_CAST( const UDPPacket_t *, pxNetworkB
 					/* Add the network packet to the list of packets to be
 					processed by the socket. */
 					vListInsertEnd( &( pxSocket->u.xUDP.xWaitingPacketsList ), &( pxNetworkBuffer->xBufferListItem ) );
+					pxSocket->u.xUDP.uxWaitingBytes += pxNetworkBuffer->xDataLength;
 				}
 				taskEXIT_CRITICAL();
 			}
@@ -354,6 +423,12 @@ const UDPPacket_t *pxUDPPacket = ipPOINTER_CAST( const UDPPacket_t *, pxNetworkB
 			}
 			#endif
 
+			#if( ipconfigUSE_SOCKET_REACTOR != 0 )
+			{
+				vReactorSocketEvent( pxSocket, FREERTOS_REACTOR_RECEIVE );
+			}
+			#endif
+
 			#if( ipconfigUSE_DHCP == 1 )
 			{
 				if( xIsDHCPSocket( pxSocket ) != 0 )
@@ -404,6 +479,7 @@ const UDPPacket_t *pxUDPPacket = ipPOINTER_CAST( const UDPPacket_t *, pxNetworkB
 			else
 		#endif /* ipconfigUSE_NBNS */
 			{
+				ipSTATS_COUNT_DROP( eIPDropNoSocket );
 				xReturn = pdFAIL;
 			}
 	}
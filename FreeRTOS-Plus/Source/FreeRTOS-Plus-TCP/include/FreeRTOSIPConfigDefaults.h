@@ -152,6 +152,32 @@ from the FreeRTOSIPConfig.h configuration header file. */
 		TCP packets which are unknown, or out-of-order. */
 		#define ipconfigIGNORE_UNKNOWN_PACKETS	( 0 )
 	#endif
+
+	#ifndef ipconfigTCP_REUSE_PORT
+		/* When set to 1, several listening sockets may be bound to the same
+		port number, provided that each of them has set the socket option
+		FREERTOS_SO_REUSE_PORT before binding.  New connections are spread
+		over the listening sockets, using a hash of the remote address and
+		port.  This allows several tasks to call FreeRTOS_accept() on the
+		same port in parallel. */
+		#define ipconfigTCP_REUSE_PORT			( 0 )
+	#endif
+
+	#ifndef ipconfigTCP_SYN_CACHE_ENTRIES
+		/* When larger than zero, a listening socket will not create a new
+		socket when it receives a SYN.  Instead, the SYN is stored in a
+		small cache of this size and answered with a SYN+ACK.  The new socket
+		is only created when the peer acknowledges the SYN+ACK.  When the
+		cache is full, the oldest entry is overwritten, so a flood of SYN's
+		can not exhaust the heap. */
+		#define ipconfigTCP_SYN_CACHE_ENTRIES	( 0 )
+	#endif
+
+	#ifndef ipconfigTCP_SYN_CACHE_TIMEOUT_MS
+		/* The time after which an unanswered entry in the SYN cache may be
+		reused. */
+		#define ipconfigTCP_SYN_CACHE_TIMEOUT_MS	( 20000U )
+	#endif
 #endif
 
 /*
@@ -313,8 +339,50 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS		45
 #endif
 
+/* BufferAllocation_1.c gives every network buffer room for the largest
+ * Ethernet frame, which wastes a lot of RAM when a large MTU is used ( jumbo
+ * frames ), because most packets ( ACK's, ARP, DNS ) are small.  When
+ * ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS is positive, a second pool is
+ * created of buffers that hold ipconfigSMALL_NETWORK_BUFFER_SIZE bytes.  A
+ * request for a small packet is served from that pool, as long as it is not
+ * empty.  BufferAllocation_2.c ignores these settings, as it allocates every
+ * buffer with the requested size. */
+#ifndef ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS
+	#define ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS	0
+#endif
+
+/* Must be at least sizeof( TCPPacket_t ), 94 bytes, because a small buffer may
+ * be reused to send an ARP request or an empty TCP packet. */
+#ifndef ipconfigSMALL_NETWORK_BUFFER_SIZE
+	#define ipconfigSMALL_NETWORK_BUFFER_SIZE		256
+#endif
+
 #ifndef ipconfigEVENT_QUEUE_LENGTH
-	#define ipconfigEVENT_QUEUE_LENGTH		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
+	#define ipconfigEVENT_QUEUE_LENGTH		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS + 5 )
+#endif
+
+#ifndef ipconfigUSE_PRIORITY_EVENT_QUEUES
+	/* When 1, the IP-task gets a second queue for control events: timer
+	 * events, requests from the socket API, and received ARP and DHCP packets.
+	 * That queue is emptied before the queue with the other packets, so a flood
+	 * of received or transmitted packets can not delay them.
+	 */
+	#define ipconfigUSE_PRIORITY_EVENT_QUEUES	0
+#endif
+
+#ifndef ipconfigCONTROL_EVENT_QUEUE_LENGTH
+	/* The length of the control queue, only used when
+	 * ipconfigUSE_PRIORITY_EVENT_QUEUES is 1.  When it is full, control events
+	 * are put in the normal queue.
+	 */
+	#define ipconfigCONTROL_EVENT_QUEUE_LENGTH	16
+#endif
+
+#ifndef ipconfigIP_TASK_CONTROL_BURST
+	/* The maximum number of control events that are handled in a row while
+	 * packets are waiting.  After that, one packet is handled first.
+	 */
+	#define ipconfigIP_TASK_CONTROL_BURST		8
 #endif
 
 #ifndef ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND
@@ -360,6 +428,43 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigUDP_MAX_RX_PACKETS		0U
 #endif
 
+#ifndef ipconfigUDP_RX_DROP_OLDEST
+	/* Only used when ipconfigUDP_MAX_RX_PACKETS is positive.  It determines
+	 * which packet is dropped when a UDP packet arrives for a socket that
+	 * already has 'uxMaxPackets' packets waiting:
+	 * 0: the new packet is dropped, the waiting packets are kept.
+	 * 1: the oldest waiting packet is released and the new one is queued.
+	 * Can be overridden with the socket option FREERTOS_SO_UDP_RX_DROP_OLDEST
+	 */
+	#define ipconfigUDP_RX_DROP_OLDEST		0
+#endif
+
+#ifndef ipconfigIP_REASSEMBLY_SLOTS
+	/* Make positive to reassemble incoming fragmented UDP datagrams.  Each slot
+	 * holds one datagram under reassembly, in a single network buffer that is
+	 * claimed when the first fragment arrives.  The number of slots is
+	 * therefore also the maximum number of network buffers that reassembly can
+	 * occupy.  When all slots are in use, fragments of new datagrams are
+	 * dropped.  When 0, all fragmented packets are dropped.
+	 */
+	#define ipconfigIP_REASSEMBLY_SLOTS		0
+#endif
+
+#ifndef ipconfigIP_REASSEMBLY_MAX_SIZE
+	/* The largest IP datagram, header included, that will be reassembled.  The
+	 * network buffer of a slot has this size plus the Ethernet header, so for
+	 * values above ipconfigNETWORK_MTU, BufferAllocation_2.c must be used.
+	 */
+	#define ipconfigIP_REASSEMBLY_MAX_SIZE	( 4U * ipconfigNETWORK_MTU )
+#endif
+
+#ifndef ipconfigIP_REASSEMBLY_TIMEOUT_MS
+	/* A datagram that is not complete within this time is discarded and its
+	 * slot becomes free again.
+	 */
+	#define ipconfigIP_REASSEMBLY_TIMEOUT_MS	( 2000U )
+#endif
+
 #ifndef ipconfigUSE_DHCP
 	#define ipconfigUSE_DHCP				1
 #endif
@@ -406,6 +511,36 @@ from the FreeRTOSIPConfig.h configuration header file. */
 #	define ipconfigTCP_TX_BUFFER_LENGTH			( 4U * ipconfigTCP_MSS )	/* defaults to 5840 bytes */
 #endif
 
+/* When ipconfigTCP_ELASTIC_STREAMS is 1, the Rx and Tx streams of a TCP socket
+ * start small and grow, in steps of a factor two, while data is passing.  The
+ * stream sizes set with ipconfigTCP_RX_BUFFER_LENGTH, ipconfigTCP_TX_BUFFER_LENGTH
+ * or FREERTOS_SO_RCVBUF/FREERTOS_SO_SNDBUF become the maximum sizes.  Empty
+ * streams are released when they have not been used for
+ * ipconfigTCP_STREAM_IDLE_RELEASE_MS.  FreeRTOS_recv() and FreeRTOS_send()
+ * ask the IP-task to resize or release a stream, and wait until it has done
+ * so.  This can not be combined with FreeRTOS_get_rx_buf(). */
+#ifndef ipconfigTCP_ELASTIC_STREAMS
+	#define ipconfigTCP_ELASTIC_STREAMS				( 0 )
+#endif
+
+/* The size with which a stream is created when ipconfigTCP_ELASTIC_STREAMS is
+ * enabled. */
+#ifndef ipconfigTCP_STREAM_INITIAL_LENGTH
+	#define ipconfigTCP_STREAM_INITIAL_LENGTH		( 2U * ipconfigTCP_MSS )
+#endif
+
+#ifndef ipconfigTCP_STREAM_IDLE_RELEASE_MS
+	#define ipconfigTCP_STREAM_IDLE_RELEASE_MS		( 5000U )
+#endif
+
+/* The maximum number of bytes that all TCP streams together may occupy, or
+ * zero for no limit.  The budget limits the growth of elastic streams: as it
+ * fills up, the size to which a stream may grow, and therefore the window
+ * advertised to the peer, is reduced proportionally. */
+#ifndef ipconfigTCP_STREAM_MEMORY_BUDGET
+	#define ipconfigTCP_STREAM_MEMORY_BUDGET		( 0U )
+#endif
+
 #ifndef ipconfigMAXIMUM_DISCOVER_TX_PERIOD
 	#ifdef _WINDOWS_
 		#define ipconfigMAXIMUM_DISCOVER_TX_PERIOD		( pdMS_TO_TICKS( 999U ) )
@@ -543,6 +678,179 @@ answers on successive calls to FreeRTOS_gethostbyname(). */
 	#define ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM 0
 #endif
 
+#ifndef ipconfigUSE_LOOPBACK
+	/* When 1, packets sent to the own IP-address or to 127.0.0.0/8 do not go
+	 * through ARP and the network driver.  The IP-task puts them in a list, and
+	 * handles them as received packets the next time it wakes up.
+	 */
+	#define ipconfigUSE_LOOPBACK 0
+#endif
+
+#ifndef ipconfigLOOPBACK_SKIP_CHECKSUMS
+	/* Only used when ipconfigUSE_LOOPBACK is 1.  Looped-back packets are never
+	 * damaged, so their checksums are not checked.  When 1, the checksums are
+	 * not calculated either.
+	 */
+	#define ipconfigLOOPBACK_SKIP_CHECKSUMS 1
+#endif
+
+#ifndef ipconfigUSE_IGMP
+	/* When 1, UDP sockets can join multicast groups with the socket options
+	 * FREERTOS_SO_IP_ADD_MEMBERSHIP and FREERTOS_SO_IP_DROP_MEMBERSHIP.  The
+	 * memberships are announced with IGMPv3 reports, or IGMPv2/v1 reports when
+	 * an older querier is present.  Multicast packets for groups that have not
+	 * been joined are dropped.
+	 */
+	#define ipconfigUSE_IGMP 0
+#endif
+
+#ifndef ipconfigIGMP_MAX_GROUPS
+	/* The number of multicast groups that can be joined at the same time,
+	 * 224.0.0.1 not included.  At most 32, a socket keeps a bit for every group.
+	 */
+	#define ipconfigIGMP_MAX_GROUPS 8
+#endif
+
+#ifndef ipconfigIGMP_DRIVER_MULTICAST_FILTER
+	/* When 1, the network driver implements
+	 * vNetworkInterfaceUpdateMulticastFilter().  The IP-task calls it every
+	 * time the set of joined groups changes, so that the driver can program
+	 * its hardware filter with the MAC addresses from
+	 * uxIGMPGetGroupMACAddresses().
+	 */
+	#define ipconfigIGMP_DRIVER_MULTICAST_FILTER 0
+#endif
+
+#ifndef ipconfigUSE_TX_SCHEDULER
+	/* When 1, the packets that the IP-task sends are queued in four classes,
+	 * chosen by the upper two bits of the TOS byte (see FREERTOS_SO_IP_TOS).
+	 * Every time the IP-task wakes up, it passes them to the driver with
+	 * deficit round robin, in which the weight of a class sets its share of
+	 * the bytes.  See FreeRTOS_TxScheduler.c.
+	 */
+	#define ipconfigUSE_TX_SCHEDULER 0
+#endif
+
+#ifndef ipconfigTX_SCHEDULER_MAX_QUEUED
+	/* The maximum number of packets that wait in one class.  When a class is
+	 * full, new packets for it are dropped.
+	 */
+	#define ipconfigTX_SCHEDULER_MAX_QUEUED 16
+#endif
+
+#ifndef ipconfigTX_SCHEDULER_BURST
+	/* The maximum number of packets that are passed to the driver each time
+	 * the IP-task wakes up.  Packets that are queued later can still overtake
+	 * the packets that remain.
+	 */
+	#define ipconfigTX_SCHEDULER_BURST 8
+#endif
+
+#ifndef ipconfigTX_SCHEDULER_QUANTUM
+	/* The number of bytes that a class with weight 1 may send per round. */
+	#define ipconfigTX_SCHEDULER_QUANTUM ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER )
+#endif
+
+#ifndef ipconfigUSE_SOCKET_REACTOR
+	/* When 1, sockets can be registered with FreeRTOS_ReactorRegister().  A
+	 * fixed pool of worker tasks calls the handler of a socket when it has
+	 * events, or when its timer expires, so that many connections can be served
+	 * without a task for each of them.  See FreeRTOS_Reactor.c.
+	 */
+	#define ipconfigUSE_SOCKET_REACTOR 0
+#endif
+
+#ifndef ipconfigREACTOR_WORKER_COUNT
+	/* The number of worker tasks that call the socket handlers. */
+	#define ipconfigREACTOR_WORKER_COUNT 2
+#endif
+
+#ifndef ipconfigREACTOR_TASK_PRIORITY
+	/* The priority of the worker tasks, lower than the IP-task. */
+	#define ipconfigREACTOR_TASK_PRIORITY ( ipconfigIP_TASK_PRIORITY - 1 )
+#endif
+
+#ifndef ipconfigREACTOR_TASK_STACK_SIZE_WORDS
+	/* The stack size of each worker task, it must hold the deepest handler. */
+	#define ipconfigREACTOR_TASK_STACK_SIZE_WORDS ( configMINIMAL_STACK_SIZE * 4 )
+#endif
+
+#ifndef ipconfigUSE_NETWORK_STATS
+	/* When 1, the stack counts dropped packets per reason, and the bytes,
+	 * retransmissions and window stalls of each TCP socket.  The counters are
+	 * read with FreeRTOS_GetIPStats() and FreeRTOS_GetSocketStats(), without
+	 * any logging.  See FreeRTOS_Stats.c.
+	 */
+	#define ipconfigUSE_NETWORK_STATS 0
+#endif
+
+#ifndef ipconfigIP_STACK_COUNT
+	/* The number of independent instances of the IP-stack.  Each one has its
+	 * own IP-task, driver, addresses, ARP cache and sockets, see
+	 * FreeRTOS_IPInitStack().  The network buffers are shared.  With more than
+	 * one stack, every access to the state of a stack looks up the stack of the
+	 * calling task, which costs a few instructions.
+	 */
+	#define ipconfigIP_STACK_COUNT 1
+#endif
+
+#ifndef ipconfigIP_STACK_TLS_INDEX
+	/* Only used when ipconfigIP_STACK_COUNT is more than 1: the index of the
+	 * thread local storage pointer in which a task stores its stack.
+	 */
+	#define ipconfigIP_STACK_TLS_INDEX 0
+#endif
+
+#if( ipconfigIP_STACK_COUNT > 1 )
+	#if( configNUM_THREAD_LOCAL_STORAGE_POINTERS <= ipconfigIP_STACK_TLS_INDEX )
+		#error configNUM_THREAD_LOCAL_STORAGE_POINTERS must be more than ipconfigIP_STACK_TLS_INDEX when ipconfigIP_STACK_COUNT > 1
+	#endif
+	#if( INCLUDE_xTaskGetSchedulerState != 1 )
+		#error INCLUDE_xTaskGetSchedulerState must be 1 when ipconfigIP_STACK_COUNT > 1
+	#endif
+#endif
+
+#ifndef ipconfigUSE_ROUTING
+	/* When 1, more network interfaces can be added with
+	 * FreeRTOS_AddNetworkInterface(), each with one or more end-points (an IP
+	 * address, netmask and MAC address).  Outgoing packets are sent through
+	 * the interface of the route with the longest matching prefix.  The
+	 * interface and the addresses passed to FreeRTOS_IPInit() form the
+	 * primary end-point, which also holds the default route.  See
+	 * FreeRTOS_Routing.c.
+	 */
+	#define ipconfigUSE_ROUTING 0
+#endif
+
+#ifndef ipconfigROUTING_MAX_ROUTES
+	/* The number of entries in the routing table.  Every end-point takes one
+	 * entry for its own subnet.
+	 */
+	#define ipconfigROUTING_MAX_ROUTES 8
+#endif
+
+#ifndef ipconfigINTERFACE_RX_QUEUE_LENGTH
+	/* The maximum number of received packets that wait in the queue of an
+	 * added interface.  More packets are refused.
+	 */
+	#define ipconfigINTERFACE_RX_QUEUE_LENGTH 16
+#endif
+
+#ifndef ipconfigINTERFACE_TX_QUEUE_LENGTH
+	/* The maximum number of packets that wait to be sent by an added
+	 * interface.  More packets are dropped.
+	 */
+	#define ipconfigINTERFACE_TX_QUEUE_LENGTH 16
+#endif
+
+#ifndef ipconfigINTERFACE_BURST
+	/* The maximum number of packets that the IP-task takes from each queue of
+	 * an interface every time it wakes up, so that a busy interface can not
+	 * starve the others.
+	 */
+	#define ipconfigINTERFACE_BURST 4
+#endif
+
 #ifndef ipconfigDHCP_REGISTER_HOSTNAME
 	#define ipconfigDHCP_REGISTER_HOSTNAME 0
 #endif
@@ -87,6 +87,18 @@ uint32_t ulDNSHandlePacket( const NetworkBufferDescriptor_t *pxNetworkBuffer );
 
 #if( ipconfigUSE_DNS_CACHE != 0 )
 
+	typedef struct xDNS_CACHE_TABLE_ROW
+	{
+		uint32_t ulIPAddresses[ ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY ]; /* The IP address(es) of an ARP cache entry. */
+		char pcName[ ipconfigDNS_CACHE_NAME_LENGTH ]; /* The name of the host */
+		uint32_t ulTTL;                               /* Time-to-Live (in seconds) from the DNS server. */
+		uint32_t ulTimeWhenAddedInSeconds;
+#if( ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY > 1 )
+		uint8_t  ucNumIPAddresses;
+		uint8_t  ucCurrentIPAddress;
+#endif
+	} DNSCacheRow_t;
+
 	/* Look for the indicated host name in the DNS cache. Returns the IPv4 
 	address if present, or 0x0 otherwise. */
 	uint32_t FreeRTOS_dnslookup( const char *pcHostName );
@@ -0,0 +1,118 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef FREERTOS_IGMP_H
+#define FREERTOS_IGMP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Application level configuration options. */
+#include "FreeRTOSIPConfig.h"
+#include "FreeRTOSIPConfigDefaults.h"
+#include "IPTraceMacroDefaults.h"
+
+#if( ipconfigUSE_IGMP != 0 )
+
+/* A multicast group that is joined by one or more sockets, or by the stack. */
+typedef struct xIGMP_GROUP
+{
+	uint32_t ulGroupAddress;		/* Network byte order, 0 when the entry is free. */
+	UBaseType_t uxReferenceCount;	/* The number of members, 0 while the group is being left. */
+	TickType_t xReportTime;			/* The time at which the delay of the next message started. */
+	TickType_t xReportDelay;		/* The delay of the next message in clock ticks. */
+	uint8_t ucReportCount;			/* The number of messages that still have to be sent. */
+	uint8_t ucRecordType;			/* The kind of message, as an IGMPv3 record type. */
+} IGMPGroup_t;
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Called by FREERTOS_SO_IP_ADD_MEMBERSHIP and FREERTOS_SO_IP_DROP_MEMBERSHIP.
+ * 'pulGroupMask' points to the bits of the socket, one bit for every group
+ * that it has joined.  Returns 0 or a negative errno value.
+ */
+BaseType_t xIGMPSocketMembership( uint32_t *pulGroupMask, uint32_t ulGroupAddress, BaseType_t xJoin );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Leave all groups that a socket has joined, called when the socket is closed.
+ */
+void vIGMPSocketLeaveAll( uint32_t *pulGroupMask );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Join the groups that are used by the stack itself.
+ */
+void vIGMPInitialise( void );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Announce all memberships again, called when the network has come up.
+ */
+void vIGMPNetworkUp( void );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Handle a received IGMP message, the IP-header has been checked already.
+ */
+void vProcessIGMPPacket( const uint8_t *pucIGMPMessage, size_t uxLength );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Called by the IP-task: send the reports and leave messages that are due, and
+ * update the driver's multicast filter if needed.  Returns the number of ticks
+ * until the next message is due, or portMAX_DELAY when nothing is pending.
+ */
+TickType_t xIGMPProcessTimers( void );
+
+/*
+ * Returns pdTRUE when the multicast address 'ulIPAddress' (network byte order)
+ * has been joined.  224.0.0.1, "all systems", is always joined.
+ */
+BaseType_t xIGMPIsGroupMember( uint32_t ulIPAddress );
+
+/*
+ * Returns pdTRUE when 'pxMACAddress' is the MAC address of a joined group.
+ * Can be used by a network driver to drop multicast frames before a network
+ * buffer is obtained for them.
+ */
+BaseType_t xIGMPIsGroupMACAddress( const MACAddress_t *pxMACAddress );
+
+/*
+ * Fill 'pxMACAddresses' with the MAC addresses that a multicast filter must
+ * pass, the address of 224.0.0.1 included.  Returns the number of addresses
+ * that were written, at most 'uxMaxCount'.  Used by network drivers when
+ * vNetworkInterfaceUpdateMulticastFilter() is called.
+ */
+UBaseType_t uxIGMPGetGroupMACAddresses( MACAddress_t *pxMACAddresses, UBaseType_t uxMaxCount );
+
+#endif /* ipconfigUSE_IGMP */
+
+#ifdef __cplusplus
+}	/* extern "C" */
+#endif
+
+#endif /* FREERTOS_IGMP_H */
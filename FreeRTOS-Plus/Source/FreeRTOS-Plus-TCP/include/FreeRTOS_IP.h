@@ -133,6 +133,11 @@ typedef struct xNETWORK_BUFFER
 	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
 		struct xNETWORK_BUFFER *pxNextBuffer; /* Possible optimisation for expert users - requires network driver support. */
 	#endif
+	#if( ipconfigUSE_ROUTING != 0 )
+		struct xNETWORK_INTERFACE *pxInterface;	/* The interface that received the packet, NULL for the primary interface. */
+		struct xNETWORK_END_POINT *pxEndPoint;	/* The end-point that receives or sends the packet, NULL for the primary end-point. */
+		uint32_t ulNextHop;						/* The address to which an outgoing packet is sent, 0 when not routed yet. */
+	#endif
 } NetworkBufferDescriptor_t;
 
 #include "pack_struct_start.h"
@@ -262,6 +267,39 @@ BaseType_t FreeRTOS_IPInit( const uint8_t ucIPAddress[ ipIP_ADDRESS_LENGTH_BYTES
 	const uint8_t ucDNSServerAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
 	const uint8_t ucMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ] );
 
+/* The state of one instance of the IP-stack, see FreeRTOS_IP_Stack.h. */
+struct xIP_STACK;
+typedef struct xIP_STACK IPStack_t;
+
+#if( ipconfigIP_STACK_COUNT > 1 )
+	typedef BaseType_t ( * NetworkInterfaceInitialiseFunction_t )( void );
+	typedef BaseType_t ( * NetworkInterfaceOutputFunction_t )( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+
+	/* Start stack number uxStack, with its own IP-task and network driver.
+	FreeRTOS_IPInit() starts stack 0 with xNetworkInterfaceInitialise() and
+	xNetworkInterfaceOutput().  The driver functions are called from the
+	IP-task of the stack. */
+	BaseType_t FreeRTOS_IPInitStack( UBaseType_t uxStack,
+		const uint8_t ucIPAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+		const uint8_t ucNetMask[ ipIP_ADDRESS_LENGTH_BYTES ],
+		const uint8_t ucGatewayAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+		const uint8_t ucDNSServerAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+		const uint8_t ucMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ],
+		NetworkInterfaceInitialiseFunction_t pxInterfaceInitialise,
+		NetworkInterfaceOutputFunction_t pxInterfaceOutput );
+#endif /* ipconfigIP_STACK_COUNT */
+
+/* Select the stack that is used by all later calls of the calling task,
+including the calls of a network driver task.  Sockets belong to the stack
+that was selected when they were created, and they must only be used by tasks
+that have selected the same stack.  With more than one stack, every task other
+than an IP-task must select a stack before it uses one.  With a single stack,
+only stack 0 can be selected, and doing so is optional. */
+BaseType_t FreeRTOS_SetIPStack( UBaseType_t uxStack );
+
+/* Return the number of the stack that is used by the calling task. */
+UBaseType_t FreeRTOS_GetIPStack( void );
+
 void * FreeRTOS_GetUDPPayloadBuffer( size_t uxRequestedSizeBytes, TickType_t uxBlockTimeTicks );
 void FreeRTOS_GetAddressConfiguration( uint32_t *pulIPAddress,
 									   uint32_t *pulNetMask,
@@ -301,6 +339,20 @@ BaseType_t FreeRTOS_IsNetworkUp( void );
 	UBaseType_t uxGetMinimumIPQueueSpace( void );
 #endif
 
+#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+	/* The two classes of events that are passed to the IP-task. */
+	typedef enum eIP_EVENT_CLASS
+	{
+		eIPEventClassControl = 0,	/* Timers, socket API requests, ARP and DHCP packets. */
+		eIPEventClassData,			/* All other received and transmitted packets. */
+		eIPEventClassCount
+	} eIPEventClass_t;
+
+	/* Returns the number of events of a class that are waiting to be handled.
+	When puxHighWater is not NULL, it receives the highest number seen so far. */
+	UBaseType_t uxGetIPEventQueueDepth( eIPEventClass_t eClass, UBaseType_t *puxHighWater );
+#endif
+
 #if ( ipconfigHAS_PRINTF != 0 )
 	extern void vPrintResourceStats( void );
 #else
@@ -45,6 +45,14 @@ extern "C" {
 
 #include "event_groups.h"
 
+#if( ipconfigUSE_SOCKET_REACTOR != 0 )
+	#include "FreeRTOS_Reactor.h"
+#endif
+
+#if( ipconfigUSE_ROUTING != 0 )
+	#include "FreeRTOS_Routing.h"
+#endif
+
 typedef struct xNetworkAddressingParameters
 {
 	uint32_t ulDefaultIPAddress;
@@ -55,7 +63,6 @@ typedef struct xNetworkAddressingParameters
 } NetworkAddressingParameters_t;
 
 extern BaseType_t xTCPWindowLoggingLevel;
-extern QueueHandle_t xNetworkEventQueue;
 
 /*-----------------------------------------------------------*/
 /* Protocol headers.                                         */
@@ -242,6 +249,8 @@ typedef enum
 	eSocketCloseEvent,		/*10: Send a message to the IP-task to close a socket. */
 	eSocketSelectEvent,		/*11: Send a message to the IP-task for select(). */
 	eSocketSignalEvent,		/*12: A socket must be signalled. */
+	eIGMPEvent,				/*13: A multicast group was joined or left. */
+	eInterfaceEvent,		/*14: An added network interface has queued packets. */
 } eIPEvent_t;
 
 typedef struct IP_TASK_COMMANDS
@@ -257,6 +266,7 @@ on the fragmentation status of the packet being sent.  The value is important,
 as it is past the location into which the destination address will get placed. */
 #define ipFRAGMENTATION_PARAMETERS_OFFSET		( 6 )
 #define ipSOCKET_OPTIONS_OFFSET					( 6 )
+#define ipSOCKET_TOS_OFFSET						( 7 )
 
 /* Only used when outgoing fragmentation is being used (FreeRTOSIPConfig.h
 setting. */
@@ -298,7 +308,6 @@ setting. */
 /* For convenience, a MAC address of all zeros and another of all 0xffs are
 defined const for quick reference. */
 extern const MACAddress_t xBroadcastMACAddress; /* all 0xff's */
-extern uint16_t usPacketIdentifier;
 
 /* Define a default UDP packet header (declared in FreeRTOS_UDP_IP.c) */
 typedef union xUDPPacketHeader
@@ -306,32 +315,58 @@ typedef union xUDPPacketHeader
 	uint8_t ucBytes[24];
 	uint32_t ulWords[6];
 } UDPPacketHeader_t;
-extern UDPPacketHeader_t xDefaultPartUDPPacketHeader;
 
-/* Structure that stores the netmask, gateway address and DNS server addresses. */
-extern NetworkAddressingParameters_t xNetworkAddressing;
+/* The initial value of the xDefaultPartUDPPacketHeader of every stack. */
+extern const UDPPacketHeader_t xDefaultPartUDPPacketHeaderTemplate;
 
-/* Structure that stores the defaults for netmask, gateway address and DNS.
-These values will be copied to 'xNetworkAddressing' in case DHCP is not used,
-and also in case DHCP does not lead to a confirmed request. */
-/*lint -e9003*/
-extern NetworkAddressingParameters_t xDefaultAddressing;	/*lint !e9003 could define variable 'xDefaultAddressing' at block scope [MISRA 2012 Rule 8.9, advisory]. */
+/* The addresses, the event queue, the bound sockets and the other state of the
+stack are members of IPStack_t, see FreeRTOS_IP_Stack.h. */
 
 /* True when BufferAllocation_1.c was included, false for BufferAllocation_2.c */
 extern const BaseType_t xBufferAllocFixedSize;
 
-/* Defined in FreeRTOS_Sockets.c */
-#if ( ipconfigUSE_TCP == 1 )
-	extern List_t xBoundTCPSocketsList;
-#endif
+#if( ipconfigIP_REASSEMBLY_SLOTS > 0 )
+	/* The received parts of a datagram are administrated in blocks of 8 bytes,
+	the unit of the fragment offset. */
+	#define ipREASSEMBLY_PAYLOAD_SIZE		( ( size_t ) ipconfigIP_REASSEMBLY_MAX_SIZE - ipSIZE_OF_IPv4_HEADER )
+	#define ipREASSEMBLY_BLOCK_COUNT		( ( ipREASSEMBLY_PAYLOAD_SIZE + 7U ) / 8U )
+	#define ipREASSEMBLY_BITMAP_WORDS		( ( ipREASSEMBLY_BLOCK_COUNT + 31U ) / 32U )
+
+	/* A datagram under reassembly.  The fragments are copied to pxBuffer, which
+	is NULL when the slot is free. */
+	typedef struct xIP_REASSEMBLY_SLOT
+	{
+		NetworkBufferDescriptor_t *pxBuffer;
+		uint32_t ulSourceIPAddress;		/* The four fields that identify a datagram. */
+		uint32_t ulDestinationIPAddress;
+		uint16_t usIdentification;
+		uint8_t ucProtocol;
+		size_t uxReceived;				/* The number of payload bytes received. */
+		size_t uxTotal;					/* The payload length, 0 until the last fragment was received. */
+		size_t uxHighest;				/* The highest end offset received so far. */
+		TickType_t xStartTime;			/* The time at which the first fragment was received. */
+		uint32_t ulBlocks[ ipREASSEMBLY_BITMAP_WORDS ];	/* One bit for each 8-byte block received. */
+	} IPReassemblySlot_t;
+#endif /* ipconfigIP_REASSEMBLY_SLOTS */
 
 /* The local IP address is accessed from within xDefaultPartUDPPacketHeader,
-rather than duplicated in its own variable. */
-#define ipLOCAL_IP_ADDRESS_POINTER ( ( uint32_t * ) &( xDefaultPartUDPPacketHeader.ulWords[ 20U / sizeof(uint32_t) ] ) )
+rather than duplicated in its own variable.  Both macro's need
+FreeRTOS_IP_Stack.h. */
+#define ipLOCAL_IP_ADDRESS_POINTER ( ( uint32_t * ) &( pxIPStack->xDefaultPartUDPPacketHeader.ulWords[ 20U / sizeof(uint32_t) ] ) )
 
 /* The local MAC address is accessed from within xDefaultPartUDPPacketHeader,
 rather than duplicated in its own variable. */
-#define ipLOCAL_MAC_ADDRESS ( xDefaultPartUDPPacketHeader.ucBytes )
+#define ipLOCAL_MAC_ADDRESS ( pxIPStack->xDefaultPartUDPPacketHeader.ucBytes )
+
+/* The own IP and MAC address used in a packet: those of its end-point when
+routing is used, otherwise the local addresses. */
+#if( ipconfigUSE_ROUTING != 0 )
+	#define ipBUFFER_IP_ADDRESS( pxNetworkBuffer )		ipEND_POINT_IP_ADDRESS( ( pxNetworkBuffer )->pxEndPoint )
+	#define ipBUFFER_MAC_ADDRESS( pxNetworkBuffer )		ipEND_POINT_MAC_ADDRESS( ( pxNetworkBuffer )->pxEndPoint )
+#else
+	#define ipBUFFER_IP_ADDRESS( pxNetworkBuffer )		( *ipLOCAL_IP_ADDRESS_POINTER )
+	#define ipBUFFER_MAC_ADDRESS( pxNetworkBuffer )		( ipLOCAL_MAC_ADDRESS )
+#endif
 
 /* In this library, there is often a cast from a character pointer
  * to a pointer to a struct.
@@ -426,7 +461,16 @@ BaseType_t FreeRTOS_ReleaseFreeNetworkBufferFromISR( void );
  * the interrupt is exited.
  */
 void FreeRTOS_NetworkDown( void );
-BaseType_t FreeRTOS_NetworkDownFromISR( void );
+#if( ipconfigIP_STACK_COUNT == 1 )
+	BaseType_t FreeRTOS_NetworkDownFromISR( void );
+#endif
+
+/*
+ * The same as FreeRTOS_NetworkDownFromISR(), for a given stack.  An ISR can
+ * not find the stack of the calling task, so with more than one stack this is
+ * the only version that may be used from an ISR.
+ */
+BaseType_t FreeRTOS_NetworkDownStackFromISR( IPStack_t *pxStack );
 
 /*
  * Processes incoming ARP packets.
@@ -455,9 +499,9 @@ uint16_t usGenerateChecksum( uint16_t usSum, const uint8_t * pucNextData, size_t
 BaseType_t xProcessReceivedUDPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer, uint16_t usPort );
 
 /*
- * Initialize the socket list data structures for TCP and UDP. 
+ * Initialize the socket list data structures for TCP and UDP of a stack.
  */
-void vNetworkSocketsInit( void );
+void vNetworkSocketsInit( IPStack_t *pxStack );
 
 /*
  * Returns pdTRUE if the IP task has been created and is initialised.  Otherwise
@@ -541,6 +585,9 @@ BaseType_t xIPIsNetworkTaskReady( void );
 				bFinLast : 1,		/* The last ACK (after FIN and FIN+ACK) has been sent or will be sent by the peer */
 				bRxStopped : 1,		/* Application asked to temporarily stop reception */
 				bMallocError : 1,	/* There was an error allocating a stream */
+				#if( ipconfigTCP_REUSE_PORT == 1 )
+					bReusePort : 1,	/* The local port may be shared with other sockets that have this flag set */
+				#endif /* ipconfigTCP_REUSE_PORT */
 				bWinScaling : 1;	/* A TCP-Window Scaling option was offered and accepted in the SYN phase. */
 		} bits;
 		uint32_t ulHighestRxAllowed;
@@ -555,6 +602,9 @@ BaseType_t xIPIsNetworkTaskReady( void );
 								 * TCP win segments */
 		uint8_t ucTCPState;		/* TCP state: see eTCP_STATE */
 		struct xSOCKET *pxPeerSocket;	/* for server socket: child, for child socket: parent */
+		#if( ipconfigTCP_REUSE_PORT == 1 )
+			struct xSOCKET *pxListenSocket;	/* for child socket: the listening socket that created it, cleared when that socket is closed */
+		#endif /* ipconfigTCP_REUSE_PORT */
 		#if( ipconfigTCP_KEEP_ALIVE == 1 )
 			uint8_t ucKeepRepCount;
 			TickType_t xLastAliveTime;
@@ -562,12 +612,19 @@ BaseType_t xIPIsNetworkTaskReady( void );
 		#if( ipconfigTCP_HANG_PROTECTION == 1 )
 			TickType_t xLastActTime;
 		#endif /* ipconfigTCP_HANG_PROTECTION */
+		#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			TickType_t xLastStreamTime;	/* The last time that FreeRTOS_recv() or FreeRTOS_send() passed data */
+		#endif /* ipconfigTCP_ELASTIC_STREAMS */
 		size_t uxLittleSpace;
 		size_t uxEnoughSpace;
 		size_t uxRxStreamSize;
 		size_t uxTxStreamSize;
 		StreamBuffer_t *rxStream;
 		StreamBuffer_t *txStream;
+		#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			StreamBuffer_t *pxNewStream;	/* A bigger stream that the IP-task will install */
+			uint8_t ucStreamRequest;		/* The change of the streams that the owner waits for */
+		#endif /* ipconfigTCP_ELASTIC_STREAMS */
 		#if( ipconfigUSE_TCP_WIN == 1 )
 			NetworkBufferDescriptor_t *pxAckMessage;
 		#endif /* ipconfigUSE_TCP_WIN */
@@ -587,6 +644,11 @@ BaseType_t xIPIsNetworkTaskReady( void );
 			FOnConnected_t pxHandleConnected;	/* Actually type: typedef void (* FOnConnected_t) (Socket_t xSocket, BaseType_t ulConnected ); */
 		#endif /* ipconfigUSE_CALLBACKS */
 		uint32_t ulWindowSize;		/* Current Window size advertised by peer */
+		#if( ipconfigUSE_NETWORK_STATS != 0 )
+			uint32_t ulRxBytes;		/* Bytes stored in rxStream */
+			uint32_t ulTxBytes;		/* Bytes acknowledged by the peer */
+			uint32_t ulWindowStalls;/* Times that the peer advertised a zero window */
+		#endif
 		size_t uxRxWinSize;	/* Fixed value: size of the TCP reception window */
 		size_t uxTxWinSize;	/* Fixed value: size of the TCP transmit window */
 
@@ -598,8 +660,11 @@ BaseType_t xIPIsNetworkTaskReady( void );
 typedef struct UDPSOCKET
 {
 	List_t xWaitingPacketsList;	/* Incoming packets */
+	size_t uxWaitingBytes;		/* The total length of the network buffers in 'xWaitingPacketsList' */
 	#if( ipconfigUDP_MAX_RX_PACKETS > 0 )
 		UBaseType_t uxMaxPackets; /* Protection: limits the number of packets buffered per socket */
+		BaseType_t xDropOldest;	/* When the list is full, release the oldest packet in stead of the newest */
+		uint32_t ulDroppedCount;	/* The number of packets that were dropped because the list was full */
 	#endif /* ipconfigUDP_MAX_RX_PACKETS */
 	#if( ipconfigUSE_CALLBACKS == 1 )
 		FOnUDPReceive_t pxHandleReceive;	/*
@@ -608,6 +673,9 @@ typedef struct UDPSOCKET
 											 */
 		FOnUDPSent_t pxHandleSent;
 	#endif /* ipconfigUSE_CALLBACKS */
+	#if( ipconfigUSE_IGMP != 0 )
+		uint32_t ulIGMPGroupMask;	/* One bit for every multicast group that was joined with FREERTOS_SO_IP_ADD_MEMBERSHIP */
+	#endif /* ipconfigUSE_IGMP */
 } IPUDPSocket_t;
 
 /* Formally typedef'd as eSocketEvent_t. */
@@ -634,6 +702,10 @@ typedef struct xSOCKET
 	uint16_t usLocalPort;		/* Local port on this machine */
 	uint8_t ucSocketOptions;
 	uint8_t ucProtocol; /* choice of FREERTOS_IPPROTO_UDP/TCP */
+	uint8_t ucTOS;		/* The TOS byte of the packets sent, set with FREERTOS_SO_IP_TOS */
+	#if( ipconfigIP_STACK_COUNT > 1 )
+		IPStack_t *pxStack;	/* The stack that created the socket, for use from an ISR */
+	#endif /* ipconfigIP_STACK_COUNT */
 	#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
 		SemaphoreHandle_t pxUserSemaphore;
 	#endif /* ipconfigSOCKET_HAS_USER_SEMAPHORE */
@@ -649,6 +721,20 @@ typedef struct xSOCKET
 		They are maintained by the IP-task */
 		EventBits_t xSocketBits;
 	#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
+	#if( ipconfigUSE_SOCKET_REACTOR != 0 )
+		FOnSocketReady_t pxReactorHandler;	/* Set with FreeRTOS_ReactorRegister() */
+		void *pvReactorContext;
+		ListItem_t xReactorReadyItem;		/* In the list of sockets that wait for a worker */
+		ListItem_t xReactorTimerItem;		/* In the list of sockets with a running timer */
+		TickType_t xReactorTimerStart;
+		TickType_t xReactorTimerDelay;
+		EventBits_t xReactorEvents;			/* Events that have not been passed to the handler yet */
+		TaskHandle_t xReactorWorker;		/* The worker that is running the handler, or NULL */
+		BaseType_t xReactorPending;			/* Events arrived while the handler was running */
+	#endif /* ipconfigUSE_SOCKET_REACTOR */
+	#if( ipconfigUSE_ROUTING != 0 )
+		RouteCache_t xRouteCache;			/* The route to the last destination, see vRouteCacheUpdate() */
+	#endif /* ipconfigUSE_ROUTING */
 	/* TCP/UDP specific fields: */
 	/* Before accessing any member of this structure, it should be confirmed */
 	/* that the protocol corresponds with the type of structure */
@@ -716,6 +802,17 @@ BaseType_t vSocketBind( FreeRTOS_Socket_t *pxSocket, struct freertos_sockaddr *
  */
 int32_t lTCPAddRxdata(FreeRTOS_Socket_t *pxSocket, size_t uxOffset, const uint8_t *pcData, uint32_t ulByteCount);
 
+/*
+ * The number of bytes that the peer may send before an Rx stream has been
+ * created.
+ */
+#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+	#define ipTCP_RX_STREAM_INITIAL_SIZE( pxSocket )	\
+		( ( size_t ) FreeRTOS_min_uint32( ( uint32_t ) ipconfigTCP_STREAM_INITIAL_LENGTH, ( uint32_t ) ( pxSocket )->u.xTCP.uxRxStreamSize ) )
+#else
+	#define ipTCP_RX_STREAM_INITIAL_SIZE( pxSocket )	( ( pxSocket )->u.xTCP.uxRxStreamSize )
+#endif
+
 /*
  * Currently called for any important event.
  */
@@ -749,6 +846,12 @@ BaseType_t xTCPSocketCheck( FreeRTOS_Socket_t *pxSocket );
 
 BaseType_t xTCPCheckNewClient( FreeRTOS_Socket_t *pxSocket );
 
+#if( ipconfigTCP_SYN_CACHE_ENTRIES > 0 )
+	/* Forget the pending connection requests of a listening socket that is
+	being closed. */
+	void vTCPSynCacheFlush( const FreeRTOS_Socket_t *pxSocket );
+#endif
+
 /* Defined in FreeRTOS_Sockets.c
  * Close a socket
  */
@@ -768,6 +871,14 @@ BaseType_t xSendEventToIPTask( eIPEvent_t eEvent );
  */
 BaseType_t xSendEventStructToIPTask( const IPStackEvent_t *pxEvent, TickType_t uxTimeout );
 
+/*
+ * Send an event to the IP-task of a given stack from an ISR.  The event always
+ * goes to the normal event queue.  Returns pdPASS if it was sent.  If
+ * *pxHigherPriorityTaskWoken is set to pdTRUE, a context switch should be
+ * requested before the ISR exits.
+ */
+BaseType_t xSendEventStructToIPStackFromISR( IPStack_t *pxStack, const IPStackEvent_t *pxEvent, BaseType_t *pxHigherPriorityTaskWoken );
+
 /*
  * Returns a pointer to the original NetworkBuffer from a pointer to a UDP
  * payload buffer.
@@ -822,6 +933,56 @@ void vIPReloadDHCPTimer( uint32_t ulLeaseTime );
 /* Send the network-up event and start the ARP timer. */
 void vIPNetworkUpCalls( void );
 
+#if( ipconfigUSE_LOOPBACK != 0 )
+	/* Return pdTRUE if the IPv4 address belongs to this host: its own address,
+	or an address in 127.0.0.0/8. */
+	BaseType_t xIsLoopbackIPAddress( uint32_t ulIPAddress );
+
+	/* Called by the IP-task just before passing a packet to
+	xNetworkInterfaceOutput().  Returns pdTRUE if the packet is addressed to this
+	host, in which case it has been queued as a received packet, and it must not
+	be passed to the driver. */
+	BaseType_t xLoopbackOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+#endif /* ipconfigUSE_LOOPBACK */
+
+#if( ipconfigUSE_SOCKET_REACTOR != 0 )
+	/* Called by the IP-task when a socket has events: queue it for a worker
+	if it has been registered. */
+	void vReactorSocketEvent( FreeRTOS_Socket_t *pxSocket, EventBits_t xEvents );
+
+	/* Called when a socket is closed. */
+	void vReactorSocketClose( FreeRTOS_Socket_t *pxSocket );
+#endif /* ipconfigUSE_SOCKET_REACTOR */
+
+/* Defines ipSTATS_COUNT_DROP(), which is empty unless ipconfigUSE_NETWORK_STATS
+is enabled. */
+#include "FreeRTOS_Stats.h"
+
+/* The function that passes an outgoing packet to the driver of the interface
+of its end-point. */
+#if( ipconfigUSE_ROUTING != 0 )
+	#define ipNETWORK_ROUTE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )		xRoutingOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#else
+	#define ipNETWORK_ROUTE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )		ipNETWORK_DRIVER_OUTPUT( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#endif
+
+/* The function that passes an outgoing packet to the network driver. */
+#if( ipconfigUSE_TX_SCHEDULER != 0 )
+	#include "FreeRTOS_TxScheduler.h"
+
+	#define ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )	xTxSchedulerOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#else
+	#define ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )	ipNETWORK_ROUTE_OUTPUT( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#endif
+
+/* Used by the senders to decide whether the checksums of an outgoing packet
+must be calculated. */
+#if( ipconfigUSE_LOOPBACK != 0 ) && ( ipconfigLOOPBACK_SKIP_CHECKSUMS != 0 )
+	#define ipCALCULATE_CHECKSUMS( ulDestinationIPAddress )		( ( xIsLoopbackIPAddress( ulDestinationIPAddress ) == pdFALSE ) ? pdTRUE : pdFALSE )
+#else
+	#define ipCALCULATE_CHECKSUMS( ulDestinationIPAddress )		( pdTRUE )
+#endif
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,208 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * FreeRTOS_IP_Stack.h
+ * The state of one instance of the IP-stack.  All variables that used to be
+ * private to the modules of the stack are members of IPStack_t, so that
+ * ipconfigIP_STACK_COUNT independent stacks can run in the same program.
+ *
+ * The stack that is used by the calling task is found with 'pxIPStack'.  With
+ * a single stack, it is the address of the only instance and it costs nothing.
+ * With more stacks, each IP-task stores its instance in a thread local storage
+ * pointer, and other tasks select one with FreeRTOS_SetIPStack().  A task that
+ * has not selected a stack fails a configASSERT() when it uses one.  An ISR
+ * can not look up a stack: it must pass the stack explicitly, e.g. to
+ * xSendEventStructToIPStackFromISR().
+ */
+
+#ifndef FREERTOS_IP_STACK_H
+#define FREERTOS_IP_STACK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Application level configuration options. */
+#include "FreeRTOSIPConfig.h"
+#include "FreeRTOSIPConfigDefaults.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_DHCP.h"
+#include "FreeRTOS_DNS.h"
+#include "FreeRTOS_IGMP.h"
+
+struct xIP_STACK
+{
+	UBaseType_t uxIndex;							/* The number of this stack, 0 to ipconfigIP_STACK_COUNT - 1. */
+#if( ipconfigIP_STACK_COUNT > 1 )
+	NetworkInterfaceInitialiseFunction_t pxInterfaceInitialise;	/* The driver of this stack. */
+	NetworkInterfaceOutputFunction_t pxInterfaceOutput;
+#endif
+
+	/* FreeRTOS_IP.c */
+	QueueHandle_t xNetworkEventQueue;				/* The queue used to pass events into the IP-task for processing. */
+#if( ipconfigUSE_PRIORITY_EVENT_QUEUES != 0 )
+	QueueHandle_t xNetworkControlQueue;				/* Events of the class eIPEventClassControl. */
+	UBaseType_t uxControlBurst;						/* The number of control events handled in a row while packets were waiting. */
+	UBaseType_t uxEventQueueHighWater[ eIPEventClassCount ];
+#endif
+#if( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
+	UBaseType_t uxQueueMinimumSpace;				/* The lowest amount of space in xNetworkEventQueue. */
+#endif
+	uint16_t usPacketIdentifier;					/* The identification field of the next IP packet. */
+	NetworkAddressingParameters_t xNetworkAddressing;	/* The netmask, gateway address and DNS server addresses. */
+	NetworkAddressingParameters_t xDefaultAddressing;	/* The values used when DHCP does not lead to a confirmed request. */
+	UDPPacketHeader_t xDefaultPartUDPPacketHeader;	/* Holds the MAC and IP address of this host. */
+	volatile BaseType_t xNetworkDownEventPending;	/* A network down event could not be posted yet. */
+	TaskHandle_t xIPTaskHandle;						/* The handle of the IP-task. */
+	BaseType_t xIPTaskInitialised;					/* pdTRUE when the IP-task is ready to process packets. */
+	BaseType_t xNetworkUp;							/* pdTRUE while the network is up. */
+#if( ipconfigUSE_NETWORK_EVENT_HOOK == 1 )
+	BaseType_t xCallEventHook;						/* Set once the network has been up for the first time. */
+#endif
+#if( ipconfigUSE_TCP != 0 )
+	BaseType_t xProcessedTCPMessage;				/* One or more TCP messages were processed within the last round. */
+#endif
+	/* The timers of the processes that need attention on a regular basis. */
+	IPTimer_t xARPTimer;
+#if( ipconfigUSE_DHCP != 0 )
+	IPTimer_t xDHCPTimer;
+#endif
+#if( ipconfigUSE_TCP != 0 )
+	IPTimer_t xTCPTimer;
+#endif
+#if( ipconfigDNS_USE_CALLBACKS != 0 )
+	IPTimer_t xDNSTimer;
+#endif
+#if( ipconfigIP_REASSEMBLY_SLOTS > 0 )
+	IPTimer_t xReassemblyTimer;
+	IPReassemblySlot_t xReassemblySlots[ ipconfigIP_REASSEMBLY_SLOTS ];
+#endif
+#if( ipconfigUSE_IGMP != 0 )
+	IPTimer_t xIGMPTimer;
+#endif
+#if( ipconfigUSE_LOOPBACK != 0 )
+	List_t xLoopbackList;							/* Packets addressed to this host, waiting to be handled. */
+	BaseType_t xLoopbackReceiving;					/* pdTRUE while a packet from xLoopbackList is being handled. */
+#endif
+
+	/* FreeRTOS_ARP.c */
+	ARPCacheRow_t xARPCache[ ipconfigARP_CACHE_ENTRIES ];
+	TickType_t xLastGratuitousARPTime;
+
+	/* FreeRTOS_Sockets.c */
+	List_t xBoundUDPSocketsList;
+#if( ipconfigUSE_TCP == 1 )
+	List_t xBoundTCPSocketsList;
+	TickType_t xLastTCPTimerCheck;					/* The time at which xTCPTimerCheck() last ran. */
+	#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+		size_t uxTCPStreamMemory;					/* The number of bytes allocated for all TCP streams together. */
+	#endif
+#endif
+
+	/* FreeRTOS_TCP_IP.c and FreeRTOS_TCP_WIN.c */
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_SYN_CACHE_ENTRIES > 0 )
+	TCPSynCacheEntry_t xTCPSynCache[ ipconfigTCP_SYN_CACHE_ENTRIES ];
+#endif
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_WIN == 1 )
+	TCPSegment_t *xTCPSegments;						/* The TCP segment pool. */
+	List_t xSegmentList;							/* The free TCP segments. */
+#endif
+
+	/* FreeRTOS_DNS.c */
+#if( ipconfigUSE_DNS_CACHE == 1 )
+	DNSCacheRow_t xDNSCache[ ipconfigDNS_CACHE_ENTRIES ];
+	BaseType_t xDNSFreeEntry;						/* The entry that will be overwritten next. */
+#endif
+#if( ipconfigDNS_USE_CALLBACKS != 0 )
+	List_t xDNSCallbackList;
+#endif
+
+	/* FreeRTOS_DHCP.c */
+#if( ipconfigUSE_DHCP != 0 )
+	Socket_t xDHCPSocket;
+	DHCPData_t xDHCPData;
+#endif
+
+	/* FreeRTOS_IGMP.c */
+#if( ipconfigUSE_IGMP != 0 )
+	IGMPGroup_t xIGMPGroups[ ipconfigIGMP_MAX_GROUPS ];
+	BaseType_t xIGMPVersion;						/* The version of IGMP that is spoken. */
+	TickType_t xOlderQuerierTime;					/* The time at which the last query of an older version was received. */
+	BaseType_t xIGMPFilterChanged;					/* The filter of the driver must be updated. */
+	uint32_t ulStackGroupMask;						/* The groups joined by the stack itself. */
+#endif
+
+	/* FreeRTOS_Stats.c */
+#if( ipconfigUSE_NETWORK_STATS != 0 )
+	uint32_t ulIPTaskDrops[ eIPDropReasonCount ];	/* Updated by the IP-task, without a lock. */
+	uint32_t ulOtherTaskDrops[ eIPDropReasonCount ];	/* Updated in a critical section. */
+	uint32_t ulTCPTxBufferFailures;					/* Updated by the IP-task, without a lock. */
+#endif
+
+	/* FreeRTOS_TxScheduler.c */
+#if( ipconfigUSE_TX_SCHEDULER != 0 )
+	TxClass_t xTxClasses[ ipTX_SCHEDULER_CLASS_COUNT ];
+	UBaseType_t uxTxCurrentClass;					/* The class that is being served. */
+	BaseType_t xTxQuantumGiven;						/* The current class has received its quantum. */
+	UBaseType_t uxTxQueuedCount;					/* The total number of packets waiting in all classes. */
+#endif
+
+	/* FreeRTOS_Routing.c */
+#if( ipconfigUSE_ROUTING != 0 )
+	NetworkInterface_t *pxInterfaces;				/* The interfaces that were added. */
+	NetworkEndPoint_t *pxEndPoints;					/* The end-points that were added. */
+	Route_t xRoutes[ ipconfigROUTING_MAX_ROUTES ];	/* Sorted from the longest to the shortest prefix. */
+	UBaseType_t uxRouteCount;
+	UBaseType_t uxRouteGeneration;					/* Incremented every time the routes change. */
+#endif
+};
+
+/* The instances, defined in FreeRTOS_IP.c. */
+extern IPStack_t xIPStacks[ ipconfigIP_STACK_COUNT ];
+
+#if( ipconfigIP_STACK_COUNT > 1 )
+	/* Returns the stack that was selected by the calling task.  Before the
+	scheduler is started, this is stack 0. */
+	IPStack_t *pxIPStackGetCurrent( void );
+
+	#define pxIPStack	( pxIPStackGetCurrent() )
+
+	/* Call the driver of the current stack. */
+	#define ipNETWORK_DRIVER_INITIALISE()										( pxIPStack->pxInterfaceInitialise() )
+	#define ipNETWORK_DRIVER_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )		( pxIPStack->pxInterfaceOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) ) )
+#else
+	#define pxIPStack	( &( xIPStacks[ 0 ] ) )
+
+	#define ipNETWORK_DRIVER_INITIALISE()										xNetworkInterfaceInitialise()
+	#define ipNETWORK_DRIVER_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )		xNetworkInterfaceOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#endif /* ipconfigIP_STACK_COUNT */
+
+#ifdef __cplusplus
+}	/* extern "C" */
+#endif
+
+#endif /* FREERTOS_IP_STACK_H */
@@ -0,0 +1,97 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef FREERTOS_REACTOR_H
+#define FREERTOS_REACTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Application level configuration options. */
+#include "FreeRTOSIPConfig.h"
+#include "FreeRTOSIPConfigDefaults.h"
+#include "IPTraceMacroDefaults.h"
+
+#if( ipconfigUSE_SOCKET_REACTOR != 0 )
+
+#include "FreeRTOS_Sockets.h"
+
+/* The events that are passed to a handler, they can be combined. */
+#define FREERTOS_REACTOR_RECEIVE	( ( EventBits_t ) 0x0001U )	/* Data or a packet can be read. */
+#define FREERTOS_REACTOR_SEND		( ( EventBits_t ) 0x0002U )	/* There is space to send, TCP only. */
+#define FREERTOS_REACTOR_ACCEPT		( ( EventBits_t ) 0x0004U )	/* A listening socket has a new client. */
+#define FREERTOS_REACTOR_CONNECT	( ( EventBits_t ) 0x0008U )	/* The connection was established. */
+#define FREERTOS_REACTOR_BOUND		( ( EventBits_t ) 0x0010U )	/* The socket was bound. */
+#define FREERTOS_REACTOR_CLOSED		( ( EventBits_t ) 0x0020U )	/* The connection was closed or reset. */
+#define FREERTOS_REACTOR_INTR		( ( EventBits_t ) 0x0040U )	/* FreeRTOS_SignalSocket() was called. */
+#define FREERTOS_REACTOR_TIMEOUT	( ( EventBits_t ) 0x0080U )	/* The timer set with FreeRTOS_ReactorSetTimer() expired. */
+
+/*
+ * The handler of a socket, called by one of the worker tasks.  A handler is
+ * never called for the same socket by two workers at the same time.  It should
+ * not block: use a receive and send time-out of 0.  The return value must be
+ * pdFALSE when the handler has closed the socket, the worker will not access
+ * it again.  Otherwise return pdTRUE.
+ */
+typedef BaseType_t ( * FOnSocketReady_t )( Socket_t xSocket, EventBits_t xEvents, void *pvContext );
+
+/*
+ * Create the worker tasks.  Returns pdPASS, or pdFAIL when there was not
+ * enough memory.  With ipconfigIP_STACK_COUNT > 1, the workers use the stack
+ * that is selected by the calling task, and only sockets of that stack may be
+ * registered.
+ */
+BaseType_t FreeRTOS_ReactorInit( void );
+
+/*
+ * Let the workers call pxHandler for the events of xSocket.  When the socket
+ * can already be read, or accepts a client, the handler is called once right
+ * away.  Registering a registered socket changes its handler and context.
+ * Returns 0 or -pdFREERTOS_ERRNO_EINVAL.
+ */
+BaseType_t FreeRTOS_ReactorRegister( Socket_t xSocket, FOnSocketReady_t pxHandler, void *pvContext );
+
+/*
+ * Stop calling the handler of xSocket, and stop its timer.  While a worker
+ * is running the handler, only the handler itself may do this, otherwise
+ * -pdFREERTOS_ERRNO_EBUSY is returned.  A registered socket must be closed
+ * from its handler, or after it has been unregistered.
+ */
+BaseType_t FreeRTOS_ReactorUnregister( Socket_t xSocket );
+
+/*
+ * Call the handler with FREERTOS_REACTOR_TIMEOUT after xTicks clock ticks,
+ * once.  A time of 0 stops the timer.  Returns 0 or -pdFREERTOS_ERRNO_EINVAL.
+ */
+BaseType_t FreeRTOS_ReactorSetTimer( Socket_t xSocket, TickType_t xTicks );
+
+#endif /* ipconfigUSE_SOCKET_REACTOR */
+
+#ifdef __cplusplus
+}	/* extern "C" */
+#endif
+
+#endif /* FREERTOS_REACTOR_H */
@@ -0,0 +1,256 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef FREERTOS_ROUTING_H
+#define FREERTOS_ROUTING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Application level configuration options. */
+#include "FreeRTOSIPConfig.h"
+#include "FreeRTOSIPConfigDefaults.h"
+#include "FreeRTOS_IP.h"
+
+#if( ipconfigUSE_ROUTING != 0 )
+
+#include "list.h"
+
+typedef struct xNETWORK_INTERFACE NetworkInterface_t;
+typedef struct xNETWORK_END_POINT NetworkEndPoint_t;
+
+/* Brings the interface up, returns pdPASS when it is ready to be used. */
+typedef BaseType_t ( * InterfaceInitialiseFunction_t )( NetworkInterface_t *pxInterface );
+
+/* Sends a packet, the ownership of the buffer is the same as for
+xNetworkInterfaceOutput(). */
+typedef BaseType_t ( * InterfaceOutputFunction_t )( NetworkInterface_t *pxInterface,
+	NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+
+typedef struct xINTERFACE_STATS
+{
+	uint32_t ulRxPackets;		/* The number of packets taken from the reception queue. */
+	uint32_t ulTxPackets;		/* The number of packets passed to pfOutput. */
+	uint32_t ulRxDropped;		/* The number of packets refused because the reception queue was full. */
+	uint32_t ulTxDropped;		/* The number of packets dropped because the interface was down or its queue was full. */
+} InterfaceStats_t;
+
+/* A network interface in addition to the one of xNetworkInterfaceOutput().
+The driver fills in the first four fields before it is passed to
+FreeRTOS_AddNetworkInterface(), the others belong to the IP-stack. */
+struct xNETWORK_INTERFACE
+{
+	const char *pcName;							/* Only used for logging. */
+	InterfaceInitialiseFunction_t pfInitialise;
+	InterfaceOutputFunction_t pfOutput;
+	void *pvArgument;							/* For use by the driver. */
+
+	BaseType_t xInterfaceUp;					/* pdTRUE once pfInitialise() has succeeded. */
+	List_t xRxQueue;							/* Received packets, waiting for the IP-task. */
+	List_t xTxQueue;							/* Packets waiting to be passed to pfOutput(). */
+	InterfaceStats_t xStats;
+	struct xNETWORK_INTERFACE *pxNext;
+};
+
+/* An IP-address, with its netmask and MAC address, on an added interface. */
+struct xNETWORK_END_POINT
+{
+	uint32_t ulIPAddress;						/* All addresses are in network byte order. */
+	uint32_t ulNetMask;
+	uint32_t ulBroadcastAddress;
+	MACAddress_t xMACAddress;
+	NetworkInterface_t *pxInterface;
+	struct xNETWORK_END_POINT *pxNext;
+};
+
+/* An entry of the routing table. */
+typedef struct xROUTE
+{
+	uint32_t ulDestination;						/* The network address, masked with ulNetMask. */
+	uint32_t ulNetMask;
+	uint32_t ulGateway;							/* Zero when the destination is on the subnet of the end-point. */
+	NetworkEndPoint_t *pxEndPoint;				/* NULL for the primary end-point. */
+	UBaseType_t uxPrefixLength;					/* The number of bits set in ulNetMask. */
+} Route_t;
+
+/* The result of a route lookup, kept in a socket so that the lookup is only
+repeated when the destination or the routing table changes. */
+typedef struct xROUTE_CACHE
+{
+	uint32_t ulDestination;
+	uint32_t ulNextHop;							/* The gateway, or the destination itself. */
+	NetworkEndPoint_t *pxEndPoint;				/* NULL for the primary end-point. */
+	UBaseType_t uxGeneration;					/* The value of uxRouteGeneration at the time of the lookup. */
+} RouteCache_t;
+
+/* The IP and MAC address of an end-point, NULL stands for the primary
+end-point.  The users of these macros include "FreeRTOS_IP_Stack.h". */
+#define ipEND_POINT_IP_ADDRESS( pxEndPoint )	( ( ( pxEndPoint ) != NULL ) ? ( pxEndPoint )->ulIPAddress : *ipLOCAL_IP_ADDRESS_POINTER )
+#define ipEND_POINT_MAC_ADDRESS( pxEndPoint )	( ( ( pxEndPoint ) != NULL ) ? ( pxEndPoint )->xMACAddress.ucBytes : ipLOCAL_MAC_ADDRESS )
+
+/*
+ * Add a network interface.  The IP-task calls its pfInitialise() until it
+ * succeeds, at start-up and every time the ARP timer expires.  Returns 0 or
+ * -pdFREERTOS_ERRNO_EINVAL.
+ */
+BaseType_t FreeRTOS_AddNetworkInterface( NetworkInterface_t *pxInterface );
+
+/*
+ * Add an end-point to an interface that has been added, along with a route to
+ * its subnet.  Returns 0, -pdFREERTOS_ERRNO_EINVAL when the netmask is not
+ * contiguous, or -pdFREERTOS_ERRNO_ENOSPC when the routing table is full.
+ */
+BaseType_t FreeRTOS_AddEndPoint( NetworkEndPoint_t *pxEndPoint,
+	NetworkInterface_t *pxInterface,
+	const uint8_t ucIPAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+	const uint8_t ucNetMask[ ipIP_ADDRESS_LENGTH_BYTES ],
+	const uint8_t ucMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ] );
+
+/*
+ * Add a route to 'ulDestination / ulNetMask', through 'ulGateway' (or 0 for a
+ * subnet that is attached) on 'pxEndPoint' (or NULL for the primary
+ * end-point).  The route with the longest matching prefix is used; routes
+ * that are added win from the implicit routes of the primary end-point when
+ * their prefix is equally long.  An existing route to the same destination is
+ * replaced.  Returns 0, -pdFREERTOS_ERRNO_EINVAL or -pdFREERTOS_ERRNO_ENOSPC.
+ */
+BaseType_t FreeRTOS_AddRoute( uint32_t ulDestination, uint32_t ulNetMask, uint32_t ulGateway, NetworkEndPoint_t *pxEndPoint );
+
+/*
+ * Remove the route to 'ulDestination / ulNetMask'.  Returns 0 or
+ * -pdFREERTOS_ERRNO_ENOENT.
+ */
+BaseType_t FreeRTOS_RemoveRoute( uint32_t ulDestination, uint32_t ulNetMask );
+
+/*
+ * Called by the driver of an added interface when it has received a packet.
+ * Returns pdPASS when the packet has been queued for the IP-task, otherwise
+ * the driver still owns the buffer and must release it.
+ */
+BaseType_t xNetworkInterfaceReceive( NetworkInterface_t *pxInterface, NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Looks up the route to 'ulDestination' and stores the result in 'pxCache'.
+ */
+void vRouteLookup( RouteCache_t *pxCache, uint32_t ulDestination );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Calls vRouteLookup() only when the cache holds a different destination, or
+ * when the routing table has changed since it was filled.
+ */
+void vRouteCacheUpdate( RouteCache_t *pxCache, uint32_t ulDestination );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Sets the end-point and the next hop of an outgoing packet that was not
+ * routed by its socket.
+ */
+void vRouteNetworkBuffer( NetworkBufferDescriptor_t * const pxNetworkBuffer, uint32_t ulDestination );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Called when the IP-address or the netmask of the primary end-point has
+ * changed.  The sockets will repeat their route lookup.
+ */
+void vRouteInvalidateCaches( void );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Sets the end-point of a received packet: the one that owns its destination
+ * address, or else the first end-point of the interface that received it.
+ */
+void vRoutingReceive( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Used in stead of xNetworkInterfaceOutput().  Packets of the primary
+ * end-point go to that driver, the others are queued for their interface.
+ */
+BaseType_t xRoutingOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Returns the end-point that owns 'ulIPAddress', or NULL.
+ */
+NetworkEndPoint_t *pxRoutingFindEndPoint( uint32_t ulIPAddress );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Returns pdTRUE if 'ulIPAddress' is the broadcast address of an added
+ * end-point.
+ */
+BaseType_t xRoutingIsBroadcast( uint32_t ulIPAddress );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Returns pdTRUE if 'ulIPAddress' is on the subnet of an added end-point.
+ */
+BaseType_t xRoutingIsOnLink( uint32_t ulIPAddress );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Returns pdTRUE if 'pxMACAddress' belongs to an added end-point.
+ */
+BaseType_t xRoutingIsEndPointMAC( const MACAddress_t *pxMACAddress );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Removes the first packet from the reception queue of an interface, or
+ * returns NULL.
+ */
+NetworkBufferDescriptor_t *pxRoutingGetReceived( NetworkInterface_t *pxInterface );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Called by the IP-task every time it wakes up: pass at most
+ * ipconfigINTERFACE_BURST of the queued packets of each interface to its
+ * driver.
+ */
+void vRoutingSendQueued( void );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Returns pdTRUE when an interface has packets waiting, the IP-task should not
+ * sleep.
+ */
+BaseType_t xRoutingPending( void );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Called by the IP-task to call pfInitialise() of the interfaces that are not
+ * up yet.
+ */
+void vRoutingInitialiseInterfaces( void );
+
+#endif /* ipconfigUSE_ROUTING */
+
+#ifdef __cplusplus
+}	/* extern "C" */
+#endif
+
+#endif /* FREERTOS_ROUTING_H */
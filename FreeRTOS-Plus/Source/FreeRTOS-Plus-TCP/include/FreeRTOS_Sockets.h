@@ -132,6 +132,21 @@ FreeRTOS_setsockopt(). */
 
 #define FREERTOS_SO_SET_LOW_HIGH_WATER	( 18 )
 
+#if( ipconfigUDP_MAX_RX_PACKETS > 0 )
+	#define FREERTOS_SO_UDP_RX_DROP_OLDEST	( 19 )		/* When the UDP reception queue is full, drop the oldest packet in stead of the newest */
+#endif
+
+#if( ipconfigTCP_REUSE_PORT == 1 )
+	#define FREERTOS_SO_REUSE_PORT			( 20 )		/* Allow several listening sockets to share a port, must be set before bind() */
+#endif
+
+#if( ipconfigUSE_IGMP != 0 )
+	#define FREERTOS_SO_IP_ADD_MEMBERSHIP	( 21 )		/* Let a UDP socket join a multicast group, takes a 'struct freertos_ip_mreq' */
+	#define FREERTOS_SO_IP_DROP_MEMBERSHIP	( 22 )		/* Leave a multicast group again */
+#endif
+
+#define FREERTOS_SO_IP_TOS				( 23 )		/* Set the TOS byte (DSCP and ECN) of the packets sent, takes a pointer to a BaseType_t from 0 to 255 */
+
 #define FREERTOS_NOT_LAST_IN_FRAGMENTED_PACKET 	( 0x80 )  /* For internal use only, but also part of an 8-bit bitwise value. */
 #define FREERTOS_FRAGMENTED_PACKET				( 0x40 )  /* For internal use only, but also part of an 8-bit bitwise value. */
 
@@ -180,6 +195,22 @@ struct freertos_sockaddr
 	uint32_t sin_addr;
 };
 
+/* The option value of FREERTOS_SO_IP_ADD_MEMBERSHIP and
+FREERTOS_SO_IP_DROP_MEMBERSHIP, the addresses are in network byte order.  There
+is only one interface, imr_interface is not used. */
+struct freertos_ip_mreq
+{
+	uint32_t imr_multiaddr;	/* The multicast group, e.g. FreeRTOS_inet_addr_quick( 239, 1, 2, 3 ). */
+	uint32_t imr_interface;
+};
+
+/* A slice of received data, as filled in by FreeRTOS_recv_iovec(). */
+struct freertos_iovec
+{
+	void *iov_base;
+	size_t iov_len;
+};
+
 extern const char *FreeRTOS_inet_ntoa( uint32_t ulIPAddress, char *pcBuffer );
 
 #if ipconfigBYTE_ORDER == pdFREERTOS_LITTLE_ENDIAN
@@ -230,11 +261,30 @@ size_t FreeRTOS_GetLocalAddress( ConstSocket_t xSocket, struct freertos_sockaddr
 	BaseType_t xPortHasUDPSocket( uint16_t usPortNr );
 #endif
 
+/*
+ * For UDP sockets:
+ * udp_rx_size returns the number of bytes of network buffer space held by
+ * the packets that are waiting to be read.
+ * udp_rx_dropped returns the number of packets that were dropped because the
+ * socket already had the maximum number of packets waiting.
+ */
+BaseType_t FreeRTOS_udp_rx_size( ConstSocket_t xSocket );
+#if( ipconfigUDP_MAX_RX_PACKETS > 0 )
+	BaseType_t FreeRTOS_udp_rx_dropped( ConstSocket_t xSocket );
+#endif
+
 #if ipconfigUSE_TCP == 1
 
 BaseType_t FreeRTOS_connect( Socket_t xClientSocket, struct freertos_sockaddr *pxAddress, socklen_t xAddressLength );
 BaseType_t FreeRTOS_listen( Socket_t xSocket, BaseType_t xBacklog );
 BaseType_t FreeRTOS_recv( Socket_t xSocket, void *pvBuffer, size_t uxBufferLength, BaseType_t xFlags );
+
+/* Zero-copy reception of all available data.  The data may wrap around the end
+of the Rx stream, so it is described by at most two slices in pxVector.  The
+return value is the total number of bytes, or a negative errno like
+FreeRTOS_recv().  When the data has been processed, it must be released by
+calling FreeRTOS_recv( xSocket, NULL, xByteCount, 0 ). */
+BaseType_t FreeRTOS_recv_iovec( Socket_t xSocket, struct freertos_iovec *pxVector, size_t uxVectorCount, BaseType_t xFlags );
 BaseType_t FreeRTOS_send( Socket_t xSocket, const void *pvBuffer, size_t uxDataLength, BaseType_t xFlags );
 Socket_t FreeRTOS_accept( Socket_t xServerSocket, struct freertos_sockaddr *pxAddress, socklen_t *pxAddressLength );
 BaseType_t FreeRTOS_shutdown (Socket_t xSocket, BaseType_t xHow);
@@ -0,0 +1,120 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef FREERTOS_STATS_H
+#define FREERTOS_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Application level configuration options. */
+#include "FreeRTOSIPConfig.h"
+#include "FreeRTOSIPConfigDefaults.h"
+#include "IPTraceMacroDefaults.h"
+
+#if( ipconfigUSE_NETWORK_STATS != 0 )
+
+#include "FreeRTOS_Sockets.h"
+
+/* The reasons for which a packet can be dropped. */
+typedef enum eIP_DROP_REASON
+{
+	eIPDropMalformed = 0,		/* A length or header field is not valid. */
+	eIPDropChecksum,			/* The IP or protocol checksum is wrong. */
+	eIPDropFiltered,			/* Not for this host, or not a handled frame type or protocol. */
+	eIPDropNoSocket,			/* No socket is bound to the destination port. */
+	eIPDropSocketQueueFull,		/* The reception queue of a UDP socket is full. */
+	eIPDropListenBacklog,		/* A listening socket can not accept more connections. */
+	eIPDropNoBuffer,			/* A network buffer could not be obtained. */
+	eIPDropEventQueueFull,		/* An event could not be sent to the IP-task. */
+	eIPDropARPPending,			/* An outgoing packet was replaced by an ARP request. */
+	eIPDropReassembly,			/* A fragment was dropped, or its datagram timed out. */
+	eIPDropTxQueueFull,			/* A class of the transmit scheduler, or the queue of an interface, was full. */
+	eIPDropReasonCount
+} eIPDropReason_t;
+
+/* A snapshot of the global counters, filled in by FreeRTOS_GetIPStats(). */
+typedef struct xIP_STATS
+{
+	uint32_t ulDrops[ eIPDropReasonCount ];	/* The number of packets dropped, per reason. */
+	uint32_t ulTCPTxBufferFailures;			/* The number of TCP segments that got no network buffer, they are sent later. */
+	UBaseType_t uxFreeNetworkBuffers;		/* The number of network buffers free now. */
+	UBaseType_t uxMinimumFreeNetworkBuffers;/* The lowest number of free network buffers seen. */
+	UBaseType_t uxEventQueueHighWater;		/* The highest number of events seen in the event queue. */
+	UBaseType_t uxControlQueueHighWater;	/* The same for the control queue, 0 without ipconfigUSE_PRIORITY_EVENT_QUEUES. */
+} IPStats_t;
+
+/* A snapshot of the counters of a TCP socket, filled in by
+FreeRTOS_GetSocketStats(). */
+typedef struct xSOCKET_STATS
+{
+	uint32_t ulRxBytes;			/* The number of bytes received and stored in the reception stream. */
+	uint32_t ulTxBytes;			/* The number of bytes sent and acknowledged by the peer. */
+	uint32_t ulRetransmits;		/* The number of segments sent more than once. */
+	uint32_t ulWindowStalls;	/* The number of times the peer advertised a window of zero. */
+	uint32_t ulSmoothedRTT;		/* The smoothed round trip time in ms. */
+} SocketStats_t;
+
+/*
+ * Copy all global counters to 'pxStats' in a single, consistent snapshot.
+ * The counters are never reset, they wrap around.  Returns 0 or
+ * -pdFREERTOS_ERRNO_EINVAL.
+ */
+BaseType_t FreeRTOS_GetIPStats( IPStats_t *pxStats );
+
+/*
+ * Copy the counters of a TCP socket to 'pxStats'.  Returns 0, or
+ * -pdFREERTOS_ERRNO_EINVAL when 'xSocket' is not a valid TCP socket.
+ */
+BaseType_t FreeRTOS_GetSocketStats( Socket_t xSocket, SocketStats_t *pxStats );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Count a dropped packet.  The IP-task updates its own copy of the counters
+ * without locking, other tasks use a critical section.
+ */
+void vIPStatsCountDrop( eIPDropReason_t eReason );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Count a TCP segment that could not get a network buffer.  It is not
+ * dropped: the data stays in the stream and is sent later.  Only called by
+ * the IP-task.
+ */
+void vIPStatsCountTCPTxBufferFailure( void );
+
+	#define ipSTATS_COUNT_DROP( eReason )		vIPStatsCountDrop( eReason )
+	#define ipSTATS_COUNT_TCP_TX_BUFFER_FAILURE()	vIPStatsCountTCPTxBufferFailure()
+#else
+	#define ipSTATS_COUNT_DROP( eReason )
+	#define ipSTATS_COUNT_TCP_TX_BUFFER_FAILURE()
+#endif /* ipconfigUSE_NETWORK_STATS */
+
+#ifdef __cplusplus
+}	/* extern "C" */
+#endif
+
+#endif /* FREERTOS_STATS_H */
@@ -225,6 +225,15 @@ size_t uxStreamBufferAdd( StreamBuffer_t *pxBuffer, size_t uxOffset, const uint8
  */
 size_t uxStreamBufferGet( StreamBuffer_t *pxBuffer, size_t uxOffset, uint8_t *pucData, size_t uxMaxCount, BaseType_t xPeek );
 
+/*
+ * Move the contents of a stream buffer to a bigger stream buffer.
+ *
+ * pxTarget -	A new buffer, its LENGTH must be at least the LENGTH of pxSource.
+ * pxSource -	The buffer whose contents will be copied, including the data
+ *				that was stored at an offset from uxHead.
+ */
+void vStreamBufferMoveContents( StreamBuffer_t *pxTarget, const StreamBuffer_t *pxSource );
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
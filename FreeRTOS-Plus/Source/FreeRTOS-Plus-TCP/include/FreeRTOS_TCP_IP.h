@@ -59,6 +59,34 @@ typedef enum eTCP_STATE {
 						 stay in TIME-WAIT for a maximum of four minutes known as a MSL (maximum segment lifetime).] */
 } eIPTCPState_t;
 
+#if( ipconfigTCP_SYN_CACHE_ENTRIES > 0 )
+
+	/*
+	 * The TCP header has room for at most 40 bytes of options.  The options of
+	 * a SYN are stored in the cache, and they will be parsed when the new
+	 * socket is created.
+	 */
+	#define tcpSYN_CACHE_OPTIONS_LENGTH		( 40U )
+
+	/*
+	 * A compact record of a connection request received by a listening socket.
+	 * It replaces a half-open child socket until the peer has acknowledged our
+	 * SYN+ACK.
+	 */
+	typedef struct xTCP_SYN_CACHE_ENTRY
+	{
+		struct xSOCKET *pxListenSocket;		/* The listening socket, NULL when the entry is free. */
+		TickType_t xCreationTime;			/* The time at which the SYN was received. */
+		uint32_t ulRemoteIP;				/* IP address of the peer, host-endian. */
+		uint32_t ulPeerSequenceNumber;		/* The initial sequence number of the peer. */
+		uint32_t ulOurSequenceNumber;		/* The initial sequence number of our SYN+ACK. */
+		uint16_t usRemotePort;				/* Port number of the peer, host-endian. */
+		uint8_t ucWinScaleFactor;			/* The window scale factor that was advertised. */
+		uint8_t ucOptionsLength;			/* The number of bytes stored in ucOptions[]. */
+		uint8_t ucOptions[ tcpSYN_CACHE_OPTIONS_LENGTH ];	/* The TCP options of the SYN. */
+	} TCPSynCacheEntry_t;
+
+#endif /* ipconfigTCP_SYN_CACHE_ENTRIES */
 
 #ifdef __cplusplus
 } // extern "C"
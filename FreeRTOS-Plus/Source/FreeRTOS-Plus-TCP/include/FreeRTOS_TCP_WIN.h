@@ -117,6 +117,9 @@ typedef struct xTCP_WINDOW
 	uint32_t ulNextTxSequenceNumber;	/* The sequence number given to the next byte to be added for transmission */
 	int32_t lSRTT;						/* Smoothed Round Trip Time, it may increment quickly and it decrements slower */
 	uint8_t ucOptionLength;				/* Number of valid bytes in ulOptionsData[] */
+#if( ipconfigUSE_NETWORK_STATS != 0 )
+	uint32_t ulRetransmitCount;			/* Number of times that a segment was sent again */
+#endif
 #if( ipconfigUSE_TCP_WIN == 1 )
 	List_t xPriorityQueue;				/* Priority queue: segments which must be sent immediately */
 	List_t xTxQueue;					/* Transmit queue: segments queued for transmission */
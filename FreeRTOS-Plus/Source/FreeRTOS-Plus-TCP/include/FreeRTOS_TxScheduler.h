@@ -0,0 +1,114 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef FREERTOS_TX_SCHEDULER_H
+#define FREERTOS_TX_SCHEDULER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Application level configuration options. */
+#include "FreeRTOSIPConfig.h"
+#include "FreeRTOSIPConfigDefaults.h"
+#include "IPTraceMacroDefaults.h"
+
+#if( ipconfigUSE_TX_SCHEDULER != 0 )
+
+/* The number of transmit classes. */
+#define ipTX_SCHEDULER_CLASS_COUNT		4U
+
+/* The class of a packet, taken from the DSCP field in its TOS byte: CS0 and
+CS1 give class 0, CS6 and CS7 (network control) give class 3.  Frames that are
+not IPv4, like ARP, also go to class 3. */
+#define ipTX_SCHEDULER_CLASS_FROM_TOS( ucTOS )	( ( UBaseType_t ) ( ( uint8_t ) ( ucTOS ) >> 6 ) )
+
+typedef struct xTX_CLASS_STATS
+{
+	uint32_t ulPackets;			/* The number of packets passed to the driver. */
+	uint32_t ulBytes;			/* The number of bytes passed to the driver. */
+	uint32_t ulDropped;			/* The number of packets dropped because the class was full. */
+	UBaseType_t uxQueued;		/* The number of packets waiting now. */
+	TickType_t xTotalDelay;		/* The sum of the times that the packets waited, in clock ticks. */
+	TickType_t xMaxDelay;		/* The longest time that a packet waited, in clock ticks. */
+} TxClassStats_t;
+
+/* The packets and the round robin state of one transmit class. */
+typedef struct xTX_CLASS
+{
+	List_t xPackets;			/* The waiting packets, the item value holds the time at which they were queued. */
+	uint32_t ulDeficit;			/* The number of bytes that may still be sent in this round. */
+	uint8_t ucWeight;			/* The share of this class, 1 to 255. */
+	TxClassStats_t xStats;
+} TxClass_t;
+
+/*
+ * Set the weight of a transmit class, a value from 1 to 255.  Per round, a
+ * class may send ipconfigTX_SCHEDULER_QUANTUM bytes times its weight.  The
+ * default weights of the classes 0 to 3 are 1, 2, 4 and 8.  Returns 0 or
+ * -pdFREERTOS_ERRNO_EINVAL.
+ */
+BaseType_t FreeRTOS_SetTxClassWeight( UBaseType_t uxClass, uint8_t ucWeight );
+
+/*
+ * Copy the statistics of a transmit class to 'pxStats'.  Returns 0 or
+ * -pdFREERTOS_ERRNO_EINVAL.
+ */
+BaseType_t FreeRTOS_GetTxClassStats( UBaseType_t uxClass, TxClassStats_t *pxStats );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Used in stead of xNetworkInterfaceOutput().  When called from the IP-task,
+ * the packet is queued in its class, a copy of it when xReleaseAfterSend is
+ * pdFALSE.  Other tasks pass it to the driver immediately.
+ */
+BaseType_t xTxSchedulerOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Called by the IP-task every time it wakes up: pass at most
+ * ipconfigTX_SCHEDULER_BURST of the queued packets to the driver.
+ */
+void vTxSchedulerProcess( void );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Returns pdTRUE when packets are waiting, the IP-task should not sleep.
+ */
+BaseType_t xTxSchedulerPending( void );
+
+/*
+ * NOT A PUBLIC API FUNCTION.
+ * Prepare the lists of the classes, called when the IP-task starts.
+ */
+void vTxSchedulerInit( void );
+
+#endif /* ipconfigUSE_TX_SCHEDULER */
+
+#ifdef __cplusplus
+}	/* extern "C" */
+#endif
+
+#endif /* FREERTOS_TX_SCHEDULER_H */
@@ -178,6 +178,10 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptraceRECVFROM_INTERRUPTED()
 #endif
 
+#ifndef iptraceUDP_RX_QUEUE_OVERFLOW
+	#define iptraceUDP_RX_QUEUE_OVERFLOW( pxSocket, xDropOldest )
+#endif
+
 #ifndef iptraceNO_BUFFER_FOR_SENDTO
 	#define iptraceNO_BUFFER_FOR_SENDTO()
 #endif
@@ -190,6 +194,50 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptraceSENDTO_DATA_TOO_LONG()
 #endif
 
+#ifndef iptraceTCP_SYN_CACHE_OVERFLOW
+	#define iptraceTCP_SYN_CACHE_OVERFLOW( pxListenSocket )
+#endif
+
+#ifndef iptraceIP_REASSEMBLY_COMPLETE
+	#define iptraceIP_REASSEMBLY_COMPLETE( pxNetworkBuffer )
+#endif
+
+#ifndef iptraceIP_REASSEMBLY_OVERLAP
+	#define iptraceIP_REASSEMBLY_OVERLAP( ulSourceIPAddress, usIdentification )
+#endif
+
+#ifndef iptraceIP_REASSEMBLY_TIMEOUT
+	#define iptraceIP_REASSEMBLY_TIMEOUT( ulSourceIPAddress, usIdentification )
+#endif
+
+#ifndef iptraceIP_REASSEMBLY_DROPPED
+	#define iptraceIP_REASSEMBLY_DROPPED( ulSourceIPAddress, usIdentification )
+#endif
+
+#ifndef iptraceLOOPBACK_PACKET
+	#define iptraceLOOPBACK_PACKET( pxNetworkBuffer )
+#endif
+
+#ifndef iptraceIGMP_JOIN_GROUP
+	#define iptraceIGMP_JOIN_GROUP( ulGroupAddress )
+#endif
+
+#ifndef iptraceIGMP_LEAVE_GROUP
+	#define iptraceIGMP_LEAVE_GROUP( ulGroupAddress )
+#endif
+
+#ifndef iptraceIGMP_QUERY_RECEIVED
+	#define iptraceIGMP_QUERY_RECEIVED( ulGroupAddress, xVersion )
+#endif
+
+#ifndef iptraceIGMP_REPORT_SENT
+	#define iptraceIGMP_REPORT_SENT( xVersion, uxGroupCount )
+#endif
+
+#ifndef iptraceTX_SCHEDULER_DROP
+	#define iptraceTX_SCHEDULER_DROP( pxNetworkBuffer, uxClass )
+#endif
+
 #ifndef ipconfigUSE_TCP_MEM_STATS
 	#define ipconfigUSE_TCP_MEM_STATS	0
 #endif
@@ -230,4 +278,18 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 
 #endif	/* ( ipconfigUSE_DUMP_PACKETS != 0 ) */
 
+#ifndef ipconfigUSE_CAPTURE_PACKETS
+	#define ipconfigUSE_CAPTURE_PACKETS	0
+#endif
+
+#if( ipconfigUSE_CAPTURE_PACKETS == 0 )
+
+	/* See tools/tcp_capture.c */
+
+	#ifndef iptraceCAPTURE_PACKET
+		#define iptraceCAPTURE_PACKET( pucBuffer, uxLength, xIncoming )
+	#endif
+
+#endif	/* ( ipconfigUSE_CAPTURE_PACKETS != 0 ) */
+
 #endif /* UDP_TRACE_MACRO_DEFAULTS_H */
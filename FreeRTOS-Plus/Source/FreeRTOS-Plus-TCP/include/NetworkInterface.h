@@ -42,6 +42,12 @@ void vNetworkInterfaceAllocateRAMToBuffers( NetworkBufferDescriptor_t pxNetworkB
 /* coverity[misra_c_2012_rule_8_6_violation] */
 BaseType_t xGetPhyLinkStatus( void );
 
+#if( ipconfigUSE_IGMP != 0 ) && ( ipconfigIGMP_DRIVER_MULTICAST_FILTER != 0 )
+	/* Called by the IP-task when a multicast group has been joined or left.
+	The driver obtains the addresses to pass with uxIGMPGetGroupMACAddresses(). */
+	void vNetworkInterfaceUpdateMulticastFilter( void );
+#endif
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
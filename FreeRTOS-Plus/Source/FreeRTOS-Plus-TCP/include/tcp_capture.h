@@ -0,0 +1,105 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * tcp_capture.h
+ * Capture network packets in a pcapng file, see tools/tcp_capture.md
+ */
+
+#ifndef TCP_CAPTURE_H
+
+#define TCP_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The number of packets that can wait in the ring for the writer thread,
+must be a power of 2. */
+#ifndef captureRING_SLOTS
+	#define captureRING_SLOTS		64U
+#endif
+
+/* The largest number of bytes that are stored of each packet. */
+#ifndef captureMAX_SNAPLEN
+	#define captureMAX_SNAPLEN		( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER )
+#endif
+
+typedef struct xCAPTURE_STATS
+{
+	uint32_t ulCaptured;	/* Packets stored in the ring. */
+	uint32_t ulFiltered;	/* Packets that did not pass the filter. */
+	uint32_t ulDropped;		/* Packets lost because the ring was full. */
+	uint32_t ulWritten;		/* Packets written to the file. */
+} CaptureStats_t;
+
+#if( ipconfigUSE_CAPTURE_PACKETS != 0 )
+
+	/*
+	 * Start a capture in the pcapng file 'pcFileName'.  'pcFilter' selects
+	 * the packets with space separated words, which must all match:
+	 *     in | out                  the direction
+	 *     arp | ip | icmp | udp | tcp
+	 *     host <a.b.c.d>            source or destination address
+	 *     port <n>                  source or destination port
+	 * The word "and" is ignored, NULL or "" captures all packets.  At most
+	 * 'uxSnapLength' bytes are stored of every packet, 0 means
+	 * captureMAX_SNAPLEN.  Returns pdPASS, or pdFAIL when the filter is not
+	 * valid or the file or the writer thread can not be created.
+	 */
+	BaseType_t xCaptureStart( const char *pcFileName, const char *pcFilter, size_t uxSnapLength );
+
+	/*
+	 * Wait until the running calls to vCapturePacket() have stored their
+	 * packets, write the packets that are still in the ring and close the
+	 * file.  Must be called from a task.
+	 */
+	void vCaptureStop( void );
+
+	/*
+	 * Read the counters of the current capture.
+	 */
+	void vCaptureGetStats( CaptureStats_t *pxStats );
+
+	/*
+	 * Called by the network driver for every packet that it receives or sends.
+	 * It may be called from any FreeRTOS task or thread, it never blocks.
+	 */
+	void vCapturePacket( const uint8_t *pucBuffer, size_t uxLength, BaseType_t xIncoming );
+
+	#define iptraceCAPTURE_PACKET( pucBuffer, uxLength, xIncoming ) \
+		vCapturePacket( pucBuffer, uxLength, xIncoming )
+
+#else
+
+	/* The header file 'IPTraceMacroDefaults.h' will define the default empty macro's. */
+
+#endif /* ipconfigUSE_CAPTURE_PACKETS != 0 */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif	/* TCP_CAPTURE_H */
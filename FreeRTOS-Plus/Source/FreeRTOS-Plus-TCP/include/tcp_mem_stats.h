@@ -45,8 +45,36 @@ typedef enum xTCP_MEMORY
 	tcpRX_STREAM_BUFFER,
 	tcpTX_STREAM_BUFFER,
 	tcpNETWORK_BUFFER,
+	tcpTCP_WIN_SEGMENTS,
+	tcpMEMORY_TYPE_COUNT	/* Must be the last entry. */
 } TCP_MEMORY_t;
 
+/* The number of size classes in the histogram.  The first class holds objects
+of up to tcpMEM_STATS_HISTOGRAM_MIN bytes, each next class doubles the limit,
+and the last class holds all larger objects. */
+#define tcpMEM_STATS_HISTOGRAM_SIZE		16U
+#define tcpMEM_STATS_HISTOGRAM_MIN		16U
+
+typedef struct xTCP_MEMORY_TYPE_STATS
+{
+	size_t uxLiveCount;		/* Objects of this type that currently exist. */
+	size_t uxPeakCount;		/* Highest value of uxLiveCount. */
+	size_t uxLiveBytes;		/* Bytes used by the existing objects. */
+	size_t uxPeakBytes;		/* Highest value of uxLiveBytes. */
+	uint32_t ulCreated;		/* Total number of objects created. */
+	uint32_t ulDeleted;		/* Total number of objects deleted. */
+} TCPMemoryTypeStats_t;
+
+typedef struct xTCP_MEMORY_SNAPSHOT
+{
+	TCPMemoryTypeStats_t xTypes[ tcpMEMORY_TYPE_COUNT ];
+	size_t uxLiveBytes;		/* Bytes used by all existing objects. */
+	size_t uxPeakBytes;		/* Highest value of uxLiveBytes. */
+	uint32_t ulHistogram[ tcpMEM_STATS_HISTOGRAM_SIZE ];	/* Existing objects per size class. */
+	uint32_t ulUntracked;	/* Objects not followed because the table was full. */
+	uint32_t ulUnknown;		/* Deletions of objects that were not followed. */
+} TCPMemorySnapshot_t;
+
 #if( ipconfigUSE_TCP_MEM_STATS != 0 )
 
 	void vTCPMemStatCreate( TCP_MEMORY_t xMemType, void *pxObject, size_t uxSize );
@@ -55,6 +83,13 @@ typedef enum xTCP_MEMORY
 
 	void vTCPMemStatClose( void );
 
+	/* Copy the current counters, may be called from any task at any time. */
+	void vTCPMemStatGetSnapshot( TCPMemorySnapshot_t *pxSnapshot );
+
+	/* Print the counters per object type and the size histogram with
+	configPRINTF(), the lines start with "TCPMemSummary,". */
+	void vTCPMemStatPrintSummary( void );
+
 	#define iptraceMEM_STATS_CREATE( xMemType, pxObject, uxSize ) \
 		vTCPMemStatCreate( xMemType, pxObject, uxSize )
 
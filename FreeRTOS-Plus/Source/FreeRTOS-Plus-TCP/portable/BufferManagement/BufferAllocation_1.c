@@ -33,6 +33,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 /* Standard includes. */
 #include <stdint.h>
+#include <string.h>
 
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
@@ -63,14 +64,37 @@ when the xFreeBuffersList is filled (as all the buffers are free when the system
 is booted). */
 static NetworkBufferDescriptor_t xNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
 
-/* This constant is defined as true to let FreeRTOS_TCP_IP.c know that the
-network buffers have constant size, large enough to hold the biggest Ethernet
-packet. No resizing will be done. */
-const BaseType_t xBufferAllocFixedSize = pdTRUE;
-
 /* The semaphore used to obtain network buffers. */
 static SemaphoreHandle_t xNetworkBufferSemaphore = NULL;
 
+#if( ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS > 0 )
+
+	/* The size of the storage of a small buffer, including the space for the
+	pointer to its descriptor, in units of size_t. */
+	#define baSMALL_BUFFER_WORDS	( ( ipBUFFER_PADDING + ipconfigSMALL_NETWORK_BUFFER_SIZE + sizeof( size_t ) - 1U ) / sizeof( size_t ) )
+
+	/* A second pool of descriptors, with buffers of
+	ipconfigSMALL_NETWORK_BUFFER_SIZE bytes.  Unlike the storage of the large
+	buffers, which is provided by the network interface, the storage of the small
+	buffers is declared here. */
+	static List_t xSmallFreeBuffersList;
+	static NetworkBufferDescriptor_t xSmallNetworkBuffers[ ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS ];
+	static size_t uxSmallBufferStorage[ ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS ][ baSMALL_BUFFER_WORDS ];
+	static SemaphoreHandle_t xSmallNetworkBufferSemaphore = NULL;
+
+	/* Not every buffer can hold the biggest Ethernet packet: let
+	FreeRTOS_TCP_IP.c and FreeRTOS_DNS.c check if a buffer is big enough. */
+	const BaseType_t xBufferAllocFixedSize = pdFALSE;
+
+#else
+
+	/* This constant is defined as true to let FreeRTOS_TCP_IP.c know that the
+	network buffers have constant size, large enough to hold the biggest Ethernet
+	packet. No resizing will be done. */
+	const BaseType_t xBufferAllocFixedSize = pdTRUE;
+
+#endif /* ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS */
+
 #if( ipconfigTCP_IP_SANITY != 0 )
 	static char cIsLow = pdFALSE;
 	UBaseType_t bIsValidNetworkDescriptor( const NetworkBufferDescriptor_t * pxDesc );
@@ -80,6 +104,19 @@ static SemaphoreHandle_t xNetworkBufferSemaphore = NULL;
 
 static void prvShowWarnings( void );
 
+/*
+ * Returns the free list that a descriptor belongs to, and the semaphore that
+ * counts the free descriptors in it.
+ */
+static List_t *prvGetFreeList( const NetworkBufferDescriptor_t *pxDesc, SemaphoreHandle_t *pxSemaphore );
+
+/*
+ * Returns pdTRUE if the descriptor belongs to the pool of small buffers.
+ */
+#if( ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS > 0 )
+	static BaseType_t prvIsSmallNetworkBuffer( const NetworkBufferDescriptor_t *pxDesc );
+#endif
+
 /* The user can define their own ipconfigBUFFER_ALLOC_LOCK() and
 ipconfigBUFFER_ALLOC_UNLOCK() macros, especially for use form an ISR.  If these
 are not defined then default them to call the normal enter/exit critical
@@ -118,8 +155,10 @@ section macros. */
 
 	BaseType_t prvIsFreeBuffer( const NetworkBufferDescriptor_t *pxDescr )
 	{
+	SemaphoreHandle_t xSemaphore;
+
 		return ( bIsValidNetworkDescriptor( pxDescr ) != 0 ) &&
-			( listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxDescr->xBufferListItem ) ) != 0 );
+			( listIS_CONTAINED_WITHIN( prvGetFreeList( pxDescr, &xSemaphore ), &( pxDescr->xBufferListItem ) ) != 0 );
 	}
 	/*-----------------------------------------------------------*/
 
@@ -137,6 +176,12 @@ section macros. */
 	UBaseType_t bIsValidNetworkDescriptor( const NetworkBufferDescriptor_t * pxDesc )
 	{
 		uint32_t offset = ( uint32_t ) ( ((const char *)pxDesc) - ((const char *)xNetworkBuffers) );
+		#if( ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS > 0 )
+		{
+			if( prvIsSmallNetworkBuffer( pxDesc ) != pdFALSE )
+				return (UBaseType_t) (pxDesc - xSmallNetworkBuffers) + ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 1;
+		}
+		#endif
 		if( ( offset >= sizeof( xNetworkBuffers ) ) ||
 			( ( offset % sizeof( xNetworkBuffers[0] ) ) != 0 ) )
 			return pdFALSE;
@@ -159,9 +204,54 @@ section macros. */
 
 #endif /* ipconfigTCP_IP_SANITY */
 
+#if( ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS > 0 )
+
+	static BaseType_t prvIsSmallNetworkBuffer( const NetworkBufferDescriptor_t *pxDesc )
+	{
+	size_t uxOffset = ( size_t ) ( ( ( const char * ) pxDesc ) - ( ( const char * ) xSmallNetworkBuffers ) );
+	BaseType_t xReturn = pdFALSE;
+
+		if( ( uxOffset < sizeof( xSmallNetworkBuffers ) ) && ( ( uxOffset % sizeof( xSmallNetworkBuffers[ 0 ] ) ) == 0U ) )
+		{
+			xReturn = pdTRUE;
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS */
+
+static List_t *prvGetFreeList( const NetworkBufferDescriptor_t *pxDesc, SemaphoreHandle_t *pxSemaphore )
+{
+List_t *pxReturn = &xFreeBuffersList;
+
+	*pxSemaphore = xNetworkBufferSemaphore;
+
+	#if( ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS > 0 )
+	{
+		if( prvIsSmallNetworkBuffer( pxDesc ) != pdFALSE )
+		{
+			pxReturn = &xSmallFreeBuffersList;
+			*pxSemaphore = xSmallNetworkBufferSemaphore;
+		}
+	}
+	#else
+	{
+		( void ) pxDesc;
+	}
+	#endif
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t xNetworkBuffersInitialise( void )
 {
 BaseType_t xReturn, x;
+#if( ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS > 0 )
+	uint8_t *pucStorage;
+#endif
 
 	/* Only initialise the buffers and their associated kernel objects if they
 	have not been initialised before. */
@@ -194,6 +284,37 @@ BaseType_t xReturn, x;
 
 			uxMinimumFreeNetworkBuffers = ( UBaseType_t ) ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS;
 		}
+
+		#if( ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS > 0 )
+		{
+			/* A small buffer may be reused to send an ARP request, or a TCP
+			packet without data. */
+			configASSERT( ipconfigSMALL_NETWORK_BUFFER_SIZE >= sizeof( TCPPacket_t ) );
+
+			xSmallNetworkBufferSemaphore = xSemaphoreCreateCounting( ( UBaseType_t ) ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS, ( UBaseType_t ) ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS );
+			configASSERT( xSmallNetworkBufferSemaphore != NULL );
+
+			if( xSmallNetworkBufferSemaphore != NULL )
+			{
+				vListInitialise( &xSmallFreeBuffersList );
+
+				for( x = 0; x < ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS; x++ )
+				{
+					/* Like the large buffers, the storage starts with a pointer
+					to the descriptor that owns it. */
+					pucStorage = ( uint8_t * ) uxSmallBufferStorage[ x ];
+					*( ( NetworkBufferDescriptor_t ** ) pucStorage ) = &( xSmallNetworkBuffers[ x ] );
+					xSmallNetworkBuffers[ x ].pucEthernetBuffer = pucStorage + ipBUFFER_PADDING;
+
+					vListInitialiseItem( &( xSmallNetworkBuffers[ x ].xBufferListItem ) );
+					listSET_LIST_ITEM_OWNER( &( xSmallNetworkBuffers[ x ].xBufferListItem ), &xSmallNetworkBuffers[ x ] );
+					vListInsert( &xSmallFreeBuffersList, &( xSmallNetworkBuffers[ x ].xBufferListItem ) );
+				}
+
+				uxMinimumFreeNetworkBuffers += ( UBaseType_t ) ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS;
+			}
+		}
+		#endif /* ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS */
 	}
 
 	if( xNetworkBufferSemaphore == NULL )
@@ -214,25 +335,42 @@ NetworkBufferDescriptor_t *pxGetNetworkBufferWithDescriptor( size_t xRequestedSi
 NetworkBufferDescriptor_t *pxReturn = NULL;
 BaseType_t xInvalid = pdFALSE;
 UBaseType_t uxCount;
-
-	/* The current implementation only has a single size memory block, so
-	the requested size parameter is not used (yet). */
-	( void ) xRequestedSizeBytes;
+List_t *pxFreeList = NULL;
 
 	if( xNetworkBufferSemaphore != NULL )
 	{
+		#if( ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS > 0 )
+		{
+			/* A size of zero means that the caller doesn't know the size yet,
+			so it gets a large buffer.  Small packets get a small buffer, as long
+			as there is one.  Otherwise a large buffer is used. */
+			if( ( xRequestedSizeBytes != 0U ) &&
+				( xRequestedSizeBytes <= ( size_t ) ipconfigSMALL_NETWORK_BUFFER_SIZE ) &&
+				( xSmallNetworkBufferSemaphore != NULL ) &&
+				( xSemaphoreTake( xSmallNetworkBufferSemaphore, 0U ) == pdPASS ) )
+			{
+				pxFreeList = &xSmallFreeBuffersList;
+			}
+		}
+		#endif /* ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS */
+
 		/* If there is a semaphore available, there is a network buffer
 		available. */
-		if( xSemaphoreTake( xNetworkBufferSemaphore, xBlockTimeTicks ) == pdPASS )
+		if( ( pxFreeList == NULL ) && ( xSemaphoreTake( xNetworkBufferSemaphore, xBlockTimeTicks ) == pdPASS ) )
+		{
+			pxFreeList = &xFreeBuffersList;
+		}
+
+		if( pxFreeList != NULL )
 		{
 			/* Protect the structure as it is accessed from tasks and
 			interrupts. */
 			ipconfigBUFFER_ALLOC_LOCK();
 			{
-				pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList );
+				pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxFreeList );
 
 				if( ( bIsValidNetworkDescriptor( pxReturn ) != pdFALSE_UNSIGNED ) &&
-					listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxReturn->xBufferListItem ) ) )
+					listIS_CONTAINED_WITHIN( pxFreeList, &( pxReturn->xBufferListItem ) ) )
 				{
 					( void ) uxListRemove( &( pxReturn->xBufferListItem ) );
 				}
@@ -257,7 +395,7 @@ UBaseType_t uxCount;
 			else
 			{
 				/* Reading UBaseType_t, no critical section needed. */
-				uxCount = listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+				uxCount = uxGetNumberOfFreeNetworkBuffers();
 
 				/* For stats, latch the lowest number of network buffers since
 				booting. */
@@ -280,6 +418,16 @@ UBaseType_t uxCount;
 					pxReturn->pxNextBuffer = NULL;
 				}
 				#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+				#if( ipconfigUSE_ROUTING != 0 )
+				{
+					/* The buffer belongs to the primary end-point until it is
+					routed. */
+					pxReturn->pxInterface = NULL;
+					pxReturn->pxEndPoint = NULL;
+					pxReturn->ulNextHop = 0UL;
+				}
+				#endif /* ipconfigUSE_ROUTING */
 			}
 			iptraceNETWORK_BUFFER_OBTAINED( pxReturn );
 		}
@@ -297,24 +445,43 @@ UBaseType_t uxCount;
 NetworkBufferDescriptor_t *pxNetworkBufferGetFromISR( size_t xRequestedSizeBytes )
 {
 NetworkBufferDescriptor_t *pxReturn = NULL;
+List_t *pxFreeList = &xFreeBuffersList;
+SemaphoreHandle_t xSemaphore = xNetworkBufferSemaphore;
 
-	/* The current implementation only has a single size memory block, so
-	the requested size parameter is not used (yet). */
-	( void ) xRequestedSizeBytes;
+	#if( ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS > 0 )
+	{
+		/* Use the pool of small buffers if the packet fits, and if it is not
+		running low. */
+		if( ( xRequestedSizeBytes != 0U ) &&
+			( xRequestedSizeBytes <= ( size_t ) ipconfigSMALL_NETWORK_BUFFER_SIZE ) &&
+			( xSmallNetworkBufferSemaphore != NULL ) &&
+			( uxQueueMessagesWaitingFromISR( ( QueueHandle_t ) xSmallNetworkBufferSemaphore ) > ( UBaseType_t ) baINTERRUPT_BUFFER_GET_THRESHOLD ) )
+		{
+			pxFreeList = &xSmallFreeBuffersList;
+			xSemaphore = xSmallNetworkBufferSemaphore;
+		}
+	}
+	#else
+	{
+		/* There is only a single size memory block, so the requested size
+		parameter is not used. */
+		( void ) xRequestedSizeBytes;
+	}
+	#endif /* ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS */
 
 	/* If there is a semaphore available then there is a buffer available, but,
 	as this is called from an interrupt, only take a buffer if there are at
 	least baINTERRUPT_BUFFER_GET_THRESHOLD buffers remaining.  This prevents,
 	to a certain degree at least, a rapidly executing interrupt exhausting
 	buffer and in so doing preventing tasks from continuing. */
-	if( uxQueueMessagesWaitingFromISR( ( QueueHandle_t ) xNetworkBufferSemaphore ) > ( UBaseType_t ) baINTERRUPT_BUFFER_GET_THRESHOLD )
+	if( uxQueueMessagesWaitingFromISR( ( QueueHandle_t ) xSemaphore ) > ( UBaseType_t ) baINTERRUPT_BUFFER_GET_THRESHOLD )
 	{
-		if( xSemaphoreTakeFromISR( xNetworkBufferSemaphore, NULL ) == pdPASS )
+		if( xSemaphoreTakeFromISR( xSemaphore, NULL ) == pdPASS )
 		{
 			/* Protect the structure as it is accessed from tasks and interrupts. */
 			ipconfigBUFFER_ALLOC_LOCK_FROM_ISR();
 			{
-				pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList );
+				pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxFreeList );
 				uxListRemove( &( pxReturn->xBufferListItem ) );
 			}
 			ipconfigBUFFER_ALLOC_UNLOCK_FROM_ISR();
@@ -335,16 +502,18 @@ NetworkBufferDescriptor_t *pxReturn = NULL;
 BaseType_t vNetworkBufferReleaseFromISR( NetworkBufferDescriptor_t * const pxNetworkBuffer )
 {
 BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+SemaphoreHandle_t xSemaphore;
+List_t *pxFreeList = prvGetFreeList( pxNetworkBuffer, &xSemaphore );
 
 	/* Ensure the buffer is returned to the list of free buffers before the
 	counting semaphore is 'given' to say a buffer is available. */
 	ipconfigBUFFER_ALLOC_LOCK_FROM_ISR();
 	{
-		vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+		vListInsertEnd( pxFreeList, &( pxNetworkBuffer->xBufferListItem ) );
 	}
 	ipconfigBUFFER_ALLOC_UNLOCK_FROM_ISR();
 
-	( void ) xSemaphoreGiveFromISR( xNetworkBufferSemaphore, &xHigherPriorityTaskWoken );
+	( void ) xSemaphoreGiveFromISR( xSemaphore, &xHigherPriorityTaskWoken );
 	iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
 
 	return xHigherPriorityTaskWoken;
@@ -354,6 +523,8 @@ BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
 {
 BaseType_t xListItemAlreadyInFreeList;
+SemaphoreHandle_t xSemaphore;
+List_t *pxFreeList;
 
 	if( bIsValidNetworkDescriptor( pxNetworkBuffer ) == pdFALSE_UNSIGNED )
 	{
@@ -361,16 +532,18 @@ BaseType_t xListItemAlreadyInFreeList;
 	}
 	else
 	{
+		pxFreeList = prvGetFreeList( pxNetworkBuffer, &xSemaphore );
+
 		/* Ensure the buffer is returned to the list of free buffers before the
 		counting semaphore is 'given' to say a buffer is available. */
 		ipconfigBUFFER_ALLOC_LOCK();
 		{
 			{
-				xListItemAlreadyInFreeList = listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+				xListItemAlreadyInFreeList = listIS_CONTAINED_WITHIN( pxFreeList, &( pxNetworkBuffer->xBufferListItem ) );
 
 				if( xListItemAlreadyInFreeList == pdFALSE )
 				{
-					vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+					vListInsertEnd( pxFreeList, &( pxNetworkBuffer->xBufferListItem ) );
 				}
 			}
 		}
@@ -383,7 +556,7 @@ BaseType_t xListItemAlreadyInFreeList;
 		}
 		else
 		{
-			( void ) xSemaphoreGive( xNetworkBufferSemaphore );
+			( void ) xSemaphoreGive( xSemaphore );
 			prvShowWarnings();
 		}
 		iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
@@ -399,16 +572,56 @@ UBaseType_t uxGetMinimumFreeNetworkBuffers( void )
 
 UBaseType_t uxGetNumberOfFreeNetworkBuffers( void )
 {
-	return listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+UBaseType_t uxCount = listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+
+	#if( ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS > 0 )
+	{
+		uxCount += listCURRENT_LIST_LENGTH( &xSmallFreeBuffersList );
+	}
+	#endif
+
+	return uxCount;
 }
 
 NetworkBufferDescriptor_t *pxResizeNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * pxNetworkBuffer, size_t xNewSizeBytes )
 {
-	/* In BufferAllocation_1.c all network buffer are allocated with a
-	maximum size of 'ipTOTAL_ETHERNET_FRAME_SIZE'.No need to resize the
-	network buffer. */
-	pxNetworkBuffer->xDataLength = xNewSizeBytes;
-	return pxNetworkBuffer;
+NetworkBufferDescriptor_t *pxReturn = pxNetworkBuffer;
+
+	#if( ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS > 0 )
+	{
+		/* A small buffer can not grow, its contents must move to a large
+		buffer. */
+		if( ( prvIsSmallNetworkBuffer( pxNetworkBuffer ) != pdFALSE ) && ( xNewSizeBytes > ( size_t ) ipconfigSMALL_NETWORK_BUFFER_SIZE ) )
+		{
+			pxReturn = pxGetNetworkBufferWithDescriptor( xNewSizeBytes, 0U );
+
+			if( pxReturn != NULL )
+			{
+				( void ) memcpy( pxReturn->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+				pxReturn->ulIPAddress = pxNetworkBuffer->ulIPAddress;
+				pxReturn->usPort = pxNetworkBuffer->usPort;
+				pxReturn->usBoundPort = pxNetworkBuffer->usBoundPort;
+				#if( ipconfigUSE_ROUTING != 0 )
+				{
+					pxReturn->pxInterface = pxNetworkBuffer->pxInterface;
+					pxReturn->pxEndPoint = pxNetworkBuffer->pxEndPoint;
+					pxReturn->ulNextHop = pxNetworkBuffer->ulNextHop;
+				}
+				#endif /* ipconfigUSE_ROUTING */
+				vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+			}
+		}
+	}
+	#endif /* ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS */
+
+	/* All large network buffers are allocated with a maximum size of
+	'ipTOTAL_ETHERNET_FRAME_SIZE'.  No need to resize the network buffer. */
+	if( pxReturn != NULL )
+	{
+		pxReturn->xDataLength = xNewSizeBytes;
+	}
+
+	return pxReturn;
 }
 
 /*#endif */ /* ipconfigINCLUDE_TEST_CODE */
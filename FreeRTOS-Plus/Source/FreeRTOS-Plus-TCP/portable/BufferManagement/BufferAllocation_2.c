@@ -52,6 +52,7 @@ heap_4 can be used. */
 #include "FreeRTOS_IP_Private.h"
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
+#include "FreeRTOS_IP_Stack.h"
 
 /* The obtained network buffer must be large enough to hold a packet that might
 replace the packet that was requested to be sent. */
@@ -116,8 +117,7 @@ BaseType_t xReturn, x;
 			in FreeRTOS+Trace.  */
 			#if( ipconfigINCLUDE_EXAMPLE_FREERTOS_PLUS_TRACE_CALLS == 1 )
 			{
-				extern QueueHandle_t xNetworkEventQueue;
-				vTraceSetQueueName( xNetworkEventQueue, "IPStackEvent" );
+				vTraceSetQueueName( pxIPStack->xNetworkEventQueue, "IPStackEvent" );
 				vTraceSetQueueName( xNetworkBufferSemaphore, "NetworkBufferCount" );
 			}
 			#endif /*  ipconfigINCLUDE_EXAMPLE_FREERTOS_PLUS_TRACE_CALLS == 1 */
@@ -182,6 +182,8 @@ size_t xSize = *pxRequestedSizeBytes;
 
 	if( pucEthernetBuffer != NULL )
 	{
+		iptraceMEM_STATS_CREATE( tcpNETWORK_BUFFER, pucEthernetBuffer, xSize + ipBUFFER_PADDING );
+
 		/* Enough space is left at the start of the buffer to place a pointer to
 		the network buffer structure that references this Ethernet buffer.
 		Return a pointer to the start of the Ethernet buffer itself. */
@@ -200,6 +202,7 @@ void vReleaseNetworkBuffer( uint8_t *pucEthernetBuffer )
 	if( pucEthernetBuffer != NULL )
 	{
 		pucEthernetBuffer -= ipBUFFER_PADDING;
+		iptraceMEM_STATS_DELETE( pucEthernetBuffer );
 		vPortFree( ( void * ) pucEthernetBuffer );
 	}
 }
@@ -264,6 +267,8 @@ size_t uxCount;
 				}
 				else
 				{
+					iptraceMEM_STATS_CREATE( tcpNETWORK_BUFFER, pxReturn->pucEthernetBuffer, xRequestedSizeBytes + ipBUFFER_PADDING );
+
 					/* Store a pointer to the network buffer structure in the
 					buffer storage area, then move the buffer pointer on past the
 					stored pointer so the pointer value is not overwritten by the
@@ -281,6 +286,16 @@ size_t uxCount;
 						pxReturn->pxNextBuffer = NULL;
 					}
 					#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+					#if( ipconfigUSE_ROUTING != 0 )
+					{
+						/* The buffer belongs to the primary end-point until it
+						is routed. */
+						pxReturn->pxInterface = NULL;
+						pxReturn->pxEndPoint = NULL;
+						pxReturn->ulNextHop = 0UL;
+					}
+					#endif /* ipconfigUSE_ROUTING */
 				}
 			}
 			else
@@ -73,9 +73,6 @@ static void prvEMACHandlerTask( void *pvParameters );
 
 /*-----------------------------------------------------------*/
 
-/* The queue used to communicate Ethernet events with the IP task. */
-extern QueueHandle_t xNetworkEventQueue;
-
 /* The semaphore used to wake the deferred interrupt handler task when an Rx
 interrupt is received. */
 static SemaphoreHandle_t xEMACRxEventSemaphore = NULL;
@@ -69,9 +69,6 @@ extern void vEMACHandlerTask( void *pvParameters );
 
 /*-----------------------------------------------------------*/
 
-/* The queue used to communicate Ethernet events with the IP task. */
-extern QueueHandle_t xNetworkEventQueue;
-
 /* The semaphore used to wake the deferred interrupt handler task when an Rx
 interrupt is received. */
 SemaphoreHandle_t xEMACRxEventSemaphore = NULL;
@@ -34,6 +34,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "FreeRTOS_IP_Private.h"
 #include "NetworkBufferManagement.h"
 #include "FreeRTOS_Stream_Buffer.h"
+#include "FreeRTOS_IGMP.h"
 
 /* ======================== Standard Library inludes ======================== */
 #include <stdio.h>
@@ -60,17 +61,42 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #endif
 
 /* ============================== Definitions =============================== */
-#define xSEND_BUFFER_SIZE	 32768
-#define xRECV_BUFFER_SIZE	 32768
+/* The thread safe buffers hold at least niBUFFERED_FRAMES frames of the
+maximum size, which matters when jumbo frames are used.  Every frame is stored
+together with its length or its pcap header. */
+#define niBUFFERED_FRAMES	 16
+#define niBUFFER_SIZE_FOR_MTU	 ( niBUFFERED_FRAMES * ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER + sizeof( struct pcap_pkthdr ) ) )
+#define xSEND_BUFFER_SIZE	 ( ( niBUFFER_SIZE_FOR_MTU > 32768 ) ? niBUFFER_SIZE_FOR_MTU : 32768 )
+#define xRECV_BUFFER_SIZE	 ( ( niBUFFER_SIZE_FOR_MTU > 32768 ) ? niBUFFER_SIZE_FOR_MTU : 32768 )
 #define MAX_CAPTURE_LEN		 65535
 #define IP_SIZE				 100
 
+/* The simulated interrupt that the Rx thread raises, see wait_for_event.h */
+#define niRX_INTERRUPT			 0U
+
+/* The storage of a network buffer when BufferAllocation_1.c is used. */
+#define niBUFFER_STORAGE_SIZE	 ( ( ipBUFFER_PADDING + ipTOTAL_ETHERNET_FRAME_SIZE + 31U ) & ~31U )
+
+#if ( ipconfigUSE_IGMP != 0 ) && ( ipconfigIGMP_DRIVER_MULTICAST_FILTER != 0 )
+	/* The pcap filter only passes the multicast groups that were joined, plus
+	224.0.0.1.  Every group adds " or ether dst xx:xx:xx:xx:xx:xx". */
+	#define niMULTICAST_FILTER	 1
+	#define niFILTER_SIZE		 ( 100 + ( ( ipconfigIGMP_MAX_GROUPS + 1 ) * 32 ) )
+#else
+	#define niMULTICAST_FILTER	 0
+	#define niFILTER_SIZE		 100
+#endif
+
 /* ================== Static Function Prototypes ============================ */
 static int prvConfigureCaptureBehaviour( void );
+static void prvBuildCaptureFilter( char *pcFilter,
+								   size_t uxFilterSize );
+static int prvSetCaptureFilter( const char *pcFilter );
 static int prvCreateThreadSafeBuffers( void );
 static void * prvLinuxPcapSendThread( void *pvParam );
 static void * prvLinuxPcapRecvThread( void *pvParam );
 static void prvInterruptSimulatorTask( void *pvParameters );
+static void prvRecvInterruptHandler( void );
 static void prvPrintAvailableNetworkInterfaces( pcap_if_t *  pxAllNetworkInterfaces );
 static pcap_if_t * prvGetAvailableNetworkInterfaces( void );
 static const char * prvRemoveSpaces( char *pcBuffer,
@@ -89,10 +115,19 @@ extern uint8_t ucMACAddress[ 6 ];
 static char errbuf[ PCAP_ERRBUF_SIZE ];
 static pcap_t *pxOpenedInterfaceHandle = NULL;
 static struct event *pvSendEvent = NULL;
+static TaskHandle_t xInterruptSimulatorTask = NULL;
 static uint32_t ulPCAPSendFailures = 0;
 static BaseType_t xConfigNetworkInterfaceToUse = configNETWORK_INTERFACE_TO_USE;
 static BaseType_t xInvalidInterfaceDetected = pdFALSE;
 
+#if ( niMULTICAST_FILTER != 0 )
+	/* A new filter, written by the IP-task and installed by the Rx thread,
+	which is the only thread that uses the pcap handle for reading. */
+	static pthread_mutex_t xFilterMutex = PTHREAD_MUTEX_INITIALIZER;
+	static char pcPendingFilter[ niFILTER_SIZE ];
+	static BaseType_t xFilterPending = pdFALSE;
+#endif
+
 /* ======================= API Function definitions ========================= */
 
 /*!
@@ -160,6 +195,10 @@ size_t xSpace;
 		( xSpace >= ( pxNetworkBuffer->xDataLength +
 					  sizeof( pxNetworkBuffer->xDataLength ) ) ) )
 	{
+		/* The packet is stored in a pcapng capture, only if
+		'ipconfigUSE_CAPTURE_PACKETS' is defined. */
+		iptraceCAPTURE_PACKET( pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdFALSE );
+
 		/* First write in the length of the data, then write in the data
 		itself. */
 		uxStreamBufferAdd( xSendBuffer,
@@ -190,6 +229,42 @@ size_t xSpace;
 	return pdPASS;
 }
 
+/*!
+ * @brief API call, called from BufferAllocation_1.c to give every network
+ *        buffer room for the largest frame, jumbo frames included
+ * @param [in] pxNetworkBuffers the descriptors that need storage
+ */
+void vNetworkInterfaceAllocateRAMToBuffers( NetworkBufferDescriptor_t pxNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ] )
+{
+static uint8_t ucNetworkPackets[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS * niBUFFER_STORAGE_SIZE ] __attribute__( ( aligned( 32 ) ) );
+uint8_t *pucRAMBuffer = ucNetworkPackets;
+uint32_t ul;
+
+	for( ul = 0; ul < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; ul++ )
+	{
+		/* The storage starts with a pointer to its descriptor. */
+		pxNetworkBuffers[ ul ].pucEthernetBuffer = pucRAMBuffer + ipBUFFER_PADDING;
+		*( ( NetworkBufferDescriptor_t ** ) pucRAMBuffer ) = &( pxNetworkBuffers[ ul ] );
+		pucRAMBuffer += niBUFFER_STORAGE_SIZE;
+	}
+}
+
+#if ( niMULTICAST_FILTER != 0 )
+
+/*!
+ * @brief API call, called from the IP-task when a multicast group has been
+ *        joined or left.  The new pcap filter is installed by the Rx thread.
+ */
+	void vNetworkInterfaceUpdateMulticastFilter( void )
+	{
+		pthread_mutex_lock( &xFilterMutex );
+		prvBuildCaptureFilter( pcPendingFilter, sizeof( pcPendingFilter ) );
+		xFilterPending = pdTRUE;
+		pthread_mutex_unlock( &xFilterMutex );
+	}
+
+#endif /* niMULTICAST_FILTER */
+
 /* ====================== Static Function definitions ======================= */
 
 /*!
@@ -539,11 +614,17 @@ int ret = pdPASS;
 						 configMINIMAL_STACK_SIZE,
 						 NULL,
 						 configMAC_ISR_SIMULATOR_PRIORITY,
-						 NULL ) != pdPASS )
+						 &xInterruptSimulatorTask ) != pdPASS )
 		{
 			ret = pdFAIL;
 			FreeRTOS_printf( ( "xTaskCreate could not create a new task\n" ) );
 		}
+		else if( event_interrupt_install( niRX_INTERRUPT, prvRecvInterruptHandler ) == false )
+		{
+			/* The task falls back to polling. */
+			FreeRTOS_printf( ( "Could not install the Rx interrupt, polling every %u ticks\n",
+							   ( unsigned ) configWINDOWS_MAC_INTERRUPT_SIMULATOR_DELAY ) );
+		}
 	}
 
 	return ret;
@@ -557,30 +638,81 @@ int ret = pdPASS;
  */
 static int prvConfigureCaptureBehaviour( void )
 {
-	struct bpf_program xFilterCode;
-	uint32_t ulNetMask;
-	char pcap_filter[ 500 ];
-	int ret = pdFAIL;
+	char pcap_filter[ niFILTER_SIZE ];
 
 	FreeRTOS_debug_printf( ( "Configuring Capture behaviour\n" ) );
 
 	/* Set up a filter so only the packets of interest are passed to the IP
-	stack.  errbuf is used for convenience to create the string.  Don't
-	confuse this with an error message. */
-	sprintf( pcap_filter, "broadcast or multicast or ether host %x:%x:%x:%x:%x:%x",
-			 ucMACAddress[ 0 ],
-			 ucMACAddress[ 1 ],
-			 ucMACAddress[ 2 ],
-			 ucMACAddress[ 3 ],
-			 ucMACAddress[ 4 ],
-			 ucMACAddress[ 5 ] );
-	FreeRTOS_debug_printf( ( "pcap filter to compile: %s\n", pcap_filter ) );
+	stack. */
+	prvBuildCaptureFilter( pcap_filter, sizeof( pcap_filter ) );
+
+	return prvSetCaptureFilter( pcap_filter );
+}
+
+/*!
+ * @brief  write the pcap filter expression that passes the frames for this
+ *         node: its own MAC address, broadcasts, and multicasts.  When the
+ *         driver filters multicast, only the groups that were joined pass.
+ * @param [out] pcFilter buffer to fill up
+ * @param [in] uxFilterSize size of pcFilter
+ */
+static void prvBuildCaptureFilter( char *pcFilter,
+								   size_t uxFilterSize )
+{
+	#if ( niMULTICAST_FILTER != 0 )
+		MACAddress_t xGroups[ ipconfigIGMP_MAX_GROUPS + 1 ];
+		UBaseType_t uxCount, uxIndex;
+		size_t uxLength;
+
+		uxLength = ( size_t ) snprintf( pcFilter, uxFilterSize, "broadcast or ether host %x:%x:%x:%x:%x:%x",
+										ucMACAddress[ 0 ],
+										ucMACAddress[ 1 ],
+										ucMACAddress[ 2 ],
+										ucMACAddress[ 3 ],
+										ucMACAddress[ 4 ],
+										ucMACAddress[ 5 ] );
+
+		uxCount = uxIGMPGetGroupMACAddresses( xGroups, ( UBaseType_t ) ( ipconfigIGMP_MAX_GROUPS + 1 ) );
+
+		for( uxIndex = 0; ( uxIndex < uxCount ) && ( uxLength < uxFilterSize ); uxIndex++ )
+		{
+			uxLength += ( size_t ) snprintf( pcFilter + uxLength, uxFilterSize - uxLength, " or ether dst %x:%x:%x:%x:%x:%x",
+											 xGroups[ uxIndex ].ucBytes[ 0 ],
+											 xGroups[ uxIndex ].ucBytes[ 1 ],
+											 xGroups[ uxIndex ].ucBytes[ 2 ],
+											 xGroups[ uxIndex ].ucBytes[ 3 ],
+											 xGroups[ uxIndex ].ucBytes[ 4 ],
+											 xGroups[ uxIndex ].ucBytes[ 5 ] );
+		}
+	#else /* if ( niMULTICAST_FILTER != 0 ) */
+		snprintf( pcFilter, uxFilterSize, "broadcast or multicast or ether host %x:%x:%x:%x:%x:%x",
+				  ucMACAddress[ 0 ],
+				  ucMACAddress[ 1 ],
+				  ucMACAddress[ 2 ],
+				  ucMACAddress[ 3 ],
+				  ucMACAddress[ 4 ],
+				  ucMACAddress[ 5 ] );
+	#endif /* niMULTICAST_FILTER */
+}
+
+/*!
+ * @brief  compile a pcap filter expression and install it
+ * @param [in] pcFilter the filter expression
+ * @returns pdPASS when successful and pdFAIL when there is a failure
+ */
+static int prvSetCaptureFilter( const char *pcFilter )
+{
+	struct bpf_program xFilterCode;
+	uint32_t ulNetMask;
+	int ret = pdFAIL;
+
+	FreeRTOS_debug_printf( ( "pcap filter to compile: %s\n", pcFilter ) );
 
 	ulNetMask = ( configNET_MASK3 << 24UL ) | ( configNET_MASK2 << 16UL ) | ( configNET_MASK1 << 8L ) | configNET_MASK0;
 
 	ret = pcap_compile( pxOpenedInterfaceHandle,
 						&xFilterCode,
-						pcap_filter,
+						pcFilter,
 						1,
 						ulNetMask );
 
@@ -629,12 +761,18 @@ static void pcap_callback( unsigned char *user,
 							 pkt_header->caplen ) );
 	print_hex( pkt_data, pkt_header->len );
 
-	/* Pass data to the FreeRTOS simulator on a thread safe circular buffer. */
-	if( ( pkt_header->caplen <= ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ) ) &&
+	/* Pass data to the FreeRTOS simulator on a thread safe circular buffer.
+	Frames that were truncated by the snapshot length are dropped, the reader
+	expects 'len' bytes. */
+	if( ( pkt_header->caplen == pkt_header->len ) &&
+		( pkt_header->caplen <= ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ) ) &&
 		( uxStreamBufferGetSpace( xRecvBuffer ) >= ( ( ( size_t ) pkt_header->caplen ) + sizeof( *pkt_header ) ) ) )
 	{
 		uxStreamBufferAdd( xRecvBuffer, 0, ( const uint8_t * ) pkt_header, sizeof( *pkt_header ) );
 		uxStreamBufferAdd( xRecvBuffer, 0, ( const uint8_t * ) pkt_data, ( size_t ) pkt_header->caplen );
+
+		/* Wake up the interrupt simulator task. */
+		event_interrupt_raise( niRX_INTERRUPT );
 	}
 }
 
@@ -662,6 +800,31 @@ int ret;
 
 	for( ; ; )
 	{
+		#if ( niMULTICAST_FILTER != 0 )
+		{
+			char pcFilter[ niFILTER_SIZE ];
+			BaseType_t xUpdate;
+
+			/* Install the filter for the multicast groups that were joined
+			or left, this thread owns the pcap handle. */
+			pthread_mutex_lock( &xFilterMutex );
+			xUpdate = xFilterPending;
+
+			if( xUpdate != pdFALSE )
+			{
+				memcpy( pcFilter, pcPendingFilter, sizeof( pcFilter ) );
+				xFilterPending = pdFALSE;
+			}
+
+			pthread_mutex_unlock( &xFilterMutex );
+
+			if( xUpdate != pdFALSE )
+			{
+				( void ) prvSetCaptureFilter( pcFilter );
+			}
+		}
+		#endif /* niMULTICAST_FILTER */
+
 		ret = pcap_dispatch( pxOpenedInterfaceHandle, 1,
 							 pcap_callback, ( u_char * ) "mydata" );
 
@@ -721,6 +884,22 @@ const time_t xMaxMSToWait = 1000;
 	return NULL;
 }
 
+/*!
+ * @brief simulated interrupt, raised by the Rx thread when it has stored
+ *        frames.  It runs in the context of the FreeRTOS task that was
+ *        interrupted, and may only use the FromISR API
+ */
+static void prvRecvInterruptHandler( void )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if( xInterruptSimulatorTask != NULL )
+	{
+		vTaskNotifyGiveFromISR( xInterruptSimulatorTask, &xHigherPriorityTaskWoken );
+		portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+	}
+}
+
 /*!
  * @brief FreeRTOS infinite loop thread that simulates a network interrupt to notify the
  *         network stack of the presence of new data
@@ -731,7 +910,8 @@ static void prvInterruptSimulatorTask( void *pvParameters )
 	struct pcap_pkthdr xHeader;
 	static struct pcap_pkthdr *pxHeader;
 	const uint8_t *pucPacketData;
-	uint8_t ucRecvBuffer[ ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ];
+	/* Static, as it can be large when jumbo frames are used. */
+	static uint8_t ucRecvBuffer[ ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ];
 	NetworkBufferDescriptor_t *pxNetworkBuffer;
 	IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
 	eFrameProcessingResult_t eResult;
@@ -752,6 +932,7 @@ static void prvInterruptSimulatorTask( void *pvParameters )
 			pxHeader = &xHeader;
 
 			iptraceNETWORK_INTERFACE_RECEIVE();
+			iptraceCAPTURE_PACKET( pucPacketData, ( size_t ) pxHeader->len, pdTRUE );
 
 			/* Check for minimal size. */
 			if( pxHeader->len >= sizeof( EthernetHeader_t ) )
@@ -826,9 +1007,10 @@ static void prvInterruptSimulatorTask( void *pvParameters )
 		}
 		else
 		{
-			/* There is no real way of simulating an interrupt.  Make sure
-			other tasks can run. */
-			vTaskDelay( configWINDOWS_MAC_INTERRUPT_SIMULATOR_DELAY );
+			/* Wait for the simulated interrupt from the Rx thread.  The
+			time-out only matters when the interrupt could not be installed,
+			or when its signal was taken by a thread that is not a task. */
+			( void ) ulTaskNotifyTake( pdTRUE, configWINDOWS_MAC_INTERRUPT_SIMULATOR_DELAY );
 		}
 	}
 }
@@ -0,0 +1,1146 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/*
+ * A network interface for the Posix simulator that uses a Linux TAP device
+ * ( Ethernet frames ) or a TUN device ( IPv4 packets ) in stead of libpcap.
+ *
+ * The device can be created once by the administrator, after which the
+ * simulator needs no special privileges:
+ *
+ *     sudo ip tuntap add dev tap0 mode tap user $USER
+ *     sudo ip link set tap0 up
+ *     sudo ip link set tap0 master br0          ( optional: join a bridge )
+ *
+ * For a multi-queue device, add "multi_queue" to the first command and set
+ * configTAP_QUEUES to the number of queues.  A TUN device is created with
+ * "mode tun" and needs configTAP_USE_TUN set to 1.  In that case the driver
+ * adds and removes the Ethernet headers, and it answers all ARP requests of
+ * the IP-task with the MAC-address of a virtual peer.
+ */
+
+/* ========================= FreeRTOS includes ============================== */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* ========================= FreeRTOS+TCP includes ========================== */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+#include "FreeRTOS_Stream_Buffer.h"
+#include "FreeRTOS_IGMP.h"
+#include "FreeRTOS_IP_Stack.h"
+
+/* ======================== Standard Library inludes ======================== */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+/* ========================== Local includes =================================*/
+#include "utils/wait_for_event.h"
+
+/* ======================== Macro Definitions =============================== */
+#if ( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES == 0 )
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer )    eProcessBuffer
+#else
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) \
+	eConsiderFrameForProcessing( ( pucEthernetBuffer ) )
+#endif
+
+/* The name of the TAP or TUN device, which must exist already. */
+#ifndef configTAP_DEVICE_NAME
+	#define configTAP_DEVICE_NAME	 "tap0"
+#endif
+
+/* Set to 1 to open a TUN device, which carries IPv4 packets without an
+Ethernet header. */
+#ifndef configTAP_USE_TUN
+	#define configTAP_USE_TUN	 0
+#endif
+
+/* The number of queues of a multi-queue device.  Every queue is opened as a
+separate file descriptor.  Linux spreads the received flows over the queues,
+the driver sends all packets of a flow through the same queue. */
+#ifndef configTAP_QUEUES
+	#define configTAP_QUEUES	 1
+#endif
+
+/* The maximum number of frames that the Rx thread reads from a queue before
+it looks at the other queues. */
+#ifndef configTAP_BATCH_SIZE
+	#define configTAP_BATCH_SIZE	 32
+#endif
+
+/* ============================== Definitions =============================== */
+#define niMAX_FRAME_SIZE		 ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER )
+
+/* Every frame in the thread safe buffers is preceded by its length. */
+#define niBUFFERED_FRAMES		 64
+#define niBUFFER_SIZE_FOR_MTU	 ( niBUFFERED_FRAMES * ( niMAX_FRAME_SIZE + sizeof( size_t ) ) )
+#define niSEND_BUFFER_SIZE		 ( ( niBUFFER_SIZE_FOR_MTU > 65536 ) ? niBUFFER_SIZE_FOR_MTU : 65536 )
+#define niRECV_BUFFER_SIZE		 ( ( niBUFFER_SIZE_FOR_MTU > 65536 ) ? niBUFFER_SIZE_FOR_MTU : 65536 )
+
+/* The number of milliseconds that a thread sleeps when there is nothing to
+do, in case a wake-up gets lost. */
+#define niMAX_MS_TO_WAIT		 1000
+
+/* The simulated interrupt that the Rx thread raises, see wait_for_event.h */
+#define niRX_INTERRUPT			 0U
+
+/* The storage of a network buffer when BufferAllocation_1.c is used. */
+#define niBUFFER_STORAGE_SIZE	 ( ( ipBUFFER_PADDING + ipTOTAL_ETHERNET_FRAME_SIZE + 31U ) & ~31U )
+
+#if ( ipconfigUSE_IGMP != 0 ) && ( ipconfigIGMP_DRIVER_MULTICAST_FILTER != 0 )
+	/* Only pass the multicast groups that were joined, plus 224.0.0.1. */
+	#define niMULTICAST_FILTER	 1
+	#define niMAX_MULTICAST		 ( ipconfigIGMP_MAX_GROUPS + 1 )
+#else
+	#define niMULTICAST_FILTER	 0
+#endif
+
+/* ================== Static Function Prototypes ============================ */
+static int prvOpenDevice( void );
+static int prvCreateThreadSafeBuffers( void );
+static int prvCreateWorkerThreads( void );
+static StreamBuffer_t * prvCreateStreamBuffer( size_t uxLength );
+static int prvRingVectors( const StreamBuffer_t *pxBuffer,
+						   size_t uxPosition,
+						   size_t uxLength,
+						   struct iovec *pxVectors );
+static void prvRingWrite( StreamBuffer_t *pxBuffer,
+						  size_t uxOffset,
+						  const void *pvData,
+						  size_t uxLength );
+static BaseType_t prvAcceptFrame( const uint8_t *pucFrame,
+								  size_t uxLength );
+static size_t prvSelectQueue( const StreamBuffer_t *pxBuffer,
+							  size_t uxPosition,
+							  size_t uxLength );
+static BaseType_t prvReadQueue( int iFile );
+static void * prvLinuxTapRecvThread( void *pvParam );
+static void * prvLinuxTapSendThread( void *pvParam );
+static void prvInterruptSimulatorTask( void *pvParameters );
+static void prvRecvInterruptHandler( void );
+
+#if ( configTAP_USE_TUN != 0 )
+	static BaseType_t prvAnswerARPRequest( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+										   BaseType_t bReleaseAfterSend );
+#endif
+
+/* ======================== Static Global Variables ========================= */
+static StreamBuffer_t *xSendBuffer = NULL;
+static StreamBuffer_t *xRecvBuffer = NULL;
+static int iQueueFiles[ configTAP_QUEUES ];
+static int iSendEvent = -1;
+static volatile BaseType_t xSendThreadIdle = pdFALSE;
+static TaskHandle_t xInterruptSimulatorTask = NULL;
+static uint32_t ulSendFailures = 0;
+static uint32_t ulRecvOverflows = 0;
+
+/* A copy of the MAC-address of the interface.  The Rx thread is not a task,
+and can not look at the IP-stack. */
+static uint8_t ucLocalMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ];
+
+#if ( configTAP_USE_TUN != 0 )
+	/* The MAC-address of the other side of the TUN device.  It is locally
+	administered and only exists inside this driver. */
+	static const uint8_t ucPeerMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+#endif
+
+#if ( niMULTICAST_FILTER != 0 )
+	/* The MAC-addresses of the groups that were joined, written by the
+	IP-task and read by the Rx thread. */
+	static pthread_mutex_t xFilterMutex = PTHREAD_MUTEX_INITIALIZER;
+	static MACAddress_t xMulticastAddresses[ niMAX_MULTICAST ];
+	static UBaseType_t uxMulticastCount = 0;
+#endif
+
+/* ======================= API Function definitions ========================= */
+
+/*!
+ * @brief API call, called from FreeRTOS_IP.c to open the TAP or TUN device
+ *        and to start the threads that read and write it
+ * @return pdPASS if successful else pdFAIL
+ */
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+BaseType_t ret = pdPASS;
+
+	/* The device stays open when the network goes down and up again. */
+	if( iSendEvent < 0 )
+	{
+		/* Written before the threads are started. */
+		memcpy( ucLocalMACAddress, ipLOCAL_MAC_ADDRESS, ipMAC_ADDRESS_LENGTH_BYTES );
+
+		ret = prvOpenDevice();
+
+		if( ret == pdPASS )
+		{
+			ret = prvCreateThreadSafeBuffers();
+		}
+
+		if( ret == pdPASS )
+		{
+			ret = prvCreateWorkerThreads();
+		}
+	}
+
+	#if ( niMULTICAST_FILTER != 0 )
+	{
+		vNetworkInterfaceUpdateMulticastFilter();
+	}
+	#endif
+
+	return ret;
+}
+
+/*!
+ * @brief API call, called from FreeRTOS_IP.c to send a network packet.  The
+ *        packet is copied to a thread safe buffer, the Tx thread writes it
+ *        to the device
+ * @return pdTRUE if successful else pdFALSE
+ */
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+									BaseType_t bReleaseAfterSend )
+{
+size_t xSpace;
+BaseType_t xReleased = pdFALSE;
+const uint64_t ullOne = 1U;
+
+	iptraceNETWORK_INTERFACE_TRANSMIT();
+	configASSERT( xIsCallingFromIPTask() == pdTRUE );
+
+	/* The packet is stored in a pcapng capture, only if
+	'ipconfigUSE_CAPTURE_PACKETS' is defined. */
+	iptraceCAPTURE_PACKET( pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdFALSE );
+
+	#if ( configTAP_USE_TUN != 0 )
+	{
+		/* A TUN device has no link layer, ARP is answered locally. */
+		xReleased = prvAnswerARPRequest( pxNetworkBuffer, bReleaseAfterSend );
+	}
+	#endif
+
+	if( xReleased == pdFALSE )
+	{
+		xSpace = uxStreamBufferGetSpace( xSendBuffer );
+
+		if( pxNetworkBuffer->xDataLength > niMAX_FRAME_SIZE )
+		{
+			FreeRTOS_printf( ( "xNetworkInterfaceOutput: frame too long %lu\n",
+							   pxNetworkBuffer->xDataLength ) );
+		}
+		else if( xSpace >= ( pxNetworkBuffer->xDataLength + sizeof( pxNetworkBuffer->xDataLength ) ) )
+		{
+			/* First write in the length of the data, then write in the data
+			itself. */
+			uxStreamBufferAdd( xSendBuffer,
+							   0,
+							   ( const uint8_t * ) &( pxNetworkBuffer->xDataLength ),
+							   sizeof( pxNetworkBuffer->xDataLength ) );
+			uxStreamBufferAdd( xSendBuffer,
+							   0,
+							   ( const uint8_t * ) pxNetworkBuffer->pucEthernetBuffer,
+							   pxNetworkBuffer->xDataLength );
+
+			/* The Tx thread only needs a system call to wake it up when it
+			is about to sleep.  It checks the buffer after setting
+			'xSendThreadIdle', the fence makes sure that either the thread
+			sees the new packet, or this task sees the flag. */
+			__atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+			if( xSendThreadIdle != pdFALSE )
+			{
+				( void ) write( iSendEvent, &ullOne, sizeof( ullOne ) );
+			}
+		}
+		else
+		{
+			ipSTATS_COUNT_DROP( eIPDropTxQueueFull );
+			FreeRTOS_printf( ( "xNetworkInterfaceOutput: send buffers full to store %lu\n",
+							   pxNetworkBuffer->xDataLength ) );
+		}
+
+		/* The buffer has been sent so can be released. */
+		if( bReleaseAfterSend != pdFALSE )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+		}
+	}
+
+	return pdPASS;
+}
+
+/*!
+ * @brief API call, called from BufferAllocation_1.c to give every network
+ *        buffer room for the largest frame, jumbo frames included
+ * @param [in] pxNetworkBuffers the descriptors that need storage
+ */
+void vNetworkInterfaceAllocateRAMToBuffers( NetworkBufferDescriptor_t pxNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ] )
+{
+static uint8_t ucNetworkPackets[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS * niBUFFER_STORAGE_SIZE ] __attribute__( ( aligned( 32 ) ) );
+uint8_t *pucRAMBuffer = ucNetworkPackets;
+uint32_t ul;
+
+	for( ul = 0; ul < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; ul++ )
+	{
+		/* The storage starts with a pointer to its descriptor. */
+		pxNetworkBuffers[ ul ].pucEthernetBuffer = pucRAMBuffer + ipBUFFER_PADDING;
+		*( ( NetworkBufferDescriptor_t ** ) pucRAMBuffer ) = &( pxNetworkBuffers[ ul ] );
+		pucRAMBuffer += niBUFFER_STORAGE_SIZE;
+	}
+}
+
+#if ( niMULTICAST_FILTER != 0 )
+
+/*!
+ * @brief API call, called from the IP-task when a multicast group has been
+ *        joined or left.  The Rx thread drops the frames of other groups.
+ */
+	void vNetworkInterfaceUpdateMulticastFilter( void )
+	{
+	MACAddress_t xGroups[ niMAX_MULTICAST ];
+	UBaseType_t uxCount;
+
+		uxCount = uxIGMPGetGroupMACAddresses( xGroups, ( UBaseType_t ) niMAX_MULTICAST );
+
+		pthread_mutex_lock( &xFilterMutex );
+		memcpy( xMulticastAddresses, xGroups, ( size_t ) uxCount * sizeof( xGroups[ 0 ] ) );
+		uxMulticastCount = uxCount;
+		pthread_mutex_unlock( &xFilterMutex );
+	}
+
+#endif /* niMULTICAST_FILTER */
+
+/* ====================== Static Function definitions ======================= */
+
+/*!
+ * @brief open every queue of the TAP or TUN device configTAP_DEVICE_NAME
+ * @returns pdPASS on success pdFAIL on failure
+ */
+static int prvOpenDevice( void )
+{
+struct ifreq xRequest;
+int iQueue;
+int ret = pdPASS;
+
+	memset( &xRequest, '\0', sizeof( xRequest ) );
+	( void ) strncpy( xRequest.ifr_name, configTAP_DEVICE_NAME, IFNAMSIZ - 1 );
+
+	#if ( configTAP_USE_TUN != 0 )
+		xRequest.ifr_flags = IFF_TUN | IFF_NO_PI;
+	#else
+		xRequest.ifr_flags = IFF_TAP | IFF_NO_PI;
+	#endif
+
+	#if ( configTAP_QUEUES > 1 )
+		xRequest.ifr_flags |= IFF_MULTI_QUEUE;
+	#endif
+
+	for( iQueue = 0; iQueue < configTAP_QUEUES; iQueue++ )
+	{
+		iQueueFiles[ iQueue ] = open( "/dev/net/tun", O_RDWR | O_NONBLOCK | O_CLOEXEC );
+
+		if( iQueueFiles[ iQueue ] < 0 )
+		{
+			FreeRTOS_printf( ( "prvOpenDevice: can not open /dev/net/tun: %s\n", strerror( errno ) ) );
+			ret = pdFAIL;
+			break;
+		}
+
+		/* Attach to the existing device, opening a new device would need
+		CAP_NET_ADMIN. */
+		if( ioctl( iQueueFiles[ iQueue ], TUNSETIFF, &xRequest ) < 0 )
+		{
+			FreeRTOS_printf( ( "prvOpenDevice: can not attach to %s queue %d: %s\n",
+							   configTAP_DEVICE_NAME, iQueue, strerror( errno ) ) );
+			( void ) close( iQueueFiles[ iQueue ] );
+			ret = pdFAIL;
+			break;
+		}
+	}
+
+	if( ret == pdPASS )
+	{
+		iSendEvent = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+		if( iSendEvent < 0 )
+		{
+			ret = pdFAIL;
+		}
+	}
+
+	if( ret == pdFAIL )
+	{
+		while( iQueue > 0 )
+		{
+			iQueue--;
+			( void ) close( iQueueFiles[ iQueue ] );
+		}
+	}
+	else
+	{
+		FreeRTOS_printf( ( "Opened %s with %d queue(s)\n", configTAP_DEVICE_NAME, configTAP_QUEUES ) );
+	}
+
+	return ret;
+}
+
+/*!
+ * @brief allocate a stream buffer that is used between a FreeRTOS task and
+ *        a Linux thread
+ * @param [in] uxLength the number of bytes that it can hold
+ * @returns the buffer or NULL when there is no memory
+ */
+static StreamBuffer_t * prvCreateStreamBuffer( size_t uxLength )
+{
+StreamBuffer_t *pxBuffer;
+size_t uxHeader = sizeof( *pxBuffer ) - sizeof( pxBuffer->ucArray );
+
+	pxBuffer = ( StreamBuffer_t * ) malloc( uxHeader + uxLength + 1 );
+
+	if( pxBuffer != NULL )
+	{
+		memset( pxBuffer, '\0', uxHeader );
+		pxBuffer->LENGTH = uxLength + 1;
+	}
+
+	return pxBuffer;
+}
+
+/*!
+ * @brief create thread safe buffers to send/receive packets between threads
+ * @returns pdPASS on success pdFAIL on failure
+ */
+static int prvCreateThreadSafeBuffers( void )
+{
+int ret = pdFAIL;
+
+	if( xSendBuffer == NULL )
+	{
+		xSendBuffer = prvCreateStreamBuffer( niSEND_BUFFER_SIZE );
+	}
+
+	if( xRecvBuffer == NULL )
+	{
+		xRecvBuffer = prvCreateStreamBuffer( niRECV_BUFFER_SIZE );
+	}
+
+	if( ( xSendBuffer != NULL ) && ( xRecvBuffer != NULL ) )
+	{
+		ret = pdPASS;
+	}
+
+	return ret;
+}
+
+/*!
+ * @brief launch 2 linux threads, one for Tx and one for Rx
+ *        and one FreeRTOS thread that will simulate an interrupt
+ *        and notify the tcp/ip stack of new data
+ * @return pdPASS on success otherwise pdFAIL
+ */
+static int prvCreateWorkerThreads( void )
+{
+pthread_t xRecvThreadHandle;
+pthread_t xSendThreadHandle;
+int ret = pdFAIL;
+
+	do
+	{
+		if( pthread_create( &xRecvThreadHandle, NULL, prvLinuxTapRecvThread, NULL ) != 0 )
+		{
+			FreeRTOS_printf( ( "pthread error" ) );
+			break;
+		}
+
+		if( pthread_create( &xSendThreadHandle, NULL, prvLinuxTapSendThread, NULL ) != 0 )
+		{
+			FreeRTOS_printf( ( "pthread error" ) );
+			break;
+		}
+
+		/* Create a task that simulates an interrupt in a real system.  This
+		will block waiting for packets, then send a message to the IP task
+		when data is available. */
+		if( xTaskCreate( prvInterruptSimulatorTask,
+						 "MAC_ISR",
+						 configMINIMAL_STACK_SIZE,
+						 NULL,
+						 configMAC_ISR_SIMULATOR_PRIORITY,
+						 &xInterruptSimulatorTask ) != pdPASS )
+		{
+			FreeRTOS_printf( ( "xTaskCreate could not create a new task\n" ) );
+			break;
+		}
+
+		/* The Rx thread wakes up the task as soon as it has stored frames.
+		Without the handler, the task falls back to polling. */
+		if( event_interrupt_install( niRX_INTERRUPT, prvRecvInterruptHandler ) == false )
+		{
+			FreeRTOS_printf( ( "Could not install the Rx interrupt, polling every %u ticks\n",
+							   ( unsigned ) configWINDOWS_MAC_INTERRUPT_SIMULATOR_DELAY ) );
+		}
+
+		ret = pdPASS;
+	} while( 0 );
+
+	return ret;
+}
+
+/*!
+ * @brief describe 'uxLength' bytes of a stream buffer, starting 'uxPosition'
+ *        bytes after its head, as at most 2 vectors
+ * @returns the number of vectors used
+ */
+static int prvRingVectors( const StreamBuffer_t *pxBuffer,
+						   size_t uxPosition,
+						   size_t uxLength,
+						   struct iovec *pxVectors )
+{
+size_t uxFirst;
+int iCount = 1;
+
+	if( uxPosition >= pxBuffer->LENGTH )
+	{
+		uxPosition -= pxBuffer->LENGTH;
+	}
+
+	uxFirst = pxBuffer->LENGTH - uxPosition;
+
+	if( uxFirst > uxLength )
+	{
+		uxFirst = uxLength;
+	}
+
+	pxVectors[ 0 ].iov_base = ( void * ) &( pxBuffer->ucArray[ uxPosition ] );
+	pxVectors[ 0 ].iov_len = uxFirst;
+
+	if( uxLength > uxFirst )
+	{
+		pxVectors[ 1 ].iov_base = ( void * ) pxBuffer->ucArray;
+		pxVectors[ 1 ].iov_len = uxLength - uxFirst;
+		iCount = 2;
+	}
+
+	return iCount;
+}
+
+/*!
+ * @brief copy data into the free space of a stream buffer, 'uxOffset' bytes
+ *        after its head, without moving the head
+ */
+static void prvRingWrite( StreamBuffer_t *pxBuffer,
+						  size_t uxOffset,
+						  const void *pvData,
+						  size_t uxLength )
+{
+struct iovec xVectors[ 2 ];
+int iCount, iIndex;
+const uint8_t *pucData = ( const uint8_t * ) pvData;
+
+	iCount = prvRingVectors( pxBuffer, pxBuffer->uxHead + uxOffset, uxLength, xVectors );
+
+	for( iIndex = 0; iIndex < iCount; iIndex++ )
+	{
+		memcpy( xVectors[ iIndex ].iov_base, pucData, xVectors[ iIndex ].iov_len );
+		pucData += xVectors[ iIndex ].iov_len;
+	}
+}
+
+/*!
+ * @brief check the destination of a received frame: this node, a broadcast
+ *        or a multicast that was joined.  A TAP device on a bridge may also
+ *        see frames that were flooded to other nodes
+ * @returns pdTRUE when the frame must be passed to the IP-task
+ */
+static BaseType_t prvAcceptFrame( const uint8_t *pucFrame,
+								  size_t uxLength )
+{
+BaseType_t xReturn = pdFALSE;
+const EthernetHeader_t *pxHeader = ipPOINTER_CAST( const EthernetHeader_t *, pucFrame );
+
+	if( uxLength < sizeof( EthernetHeader_t ) )
+	{
+		/* Too short. */
+	}
+	else if( memcmp( pxHeader->xDestinationAddress.ucBytes, ucLocalMACAddress, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 )
+	{
+		xReturn = pdTRUE;
+	}
+	else if( ( pxHeader->xDestinationAddress.ucBytes[ 0 ] & 0x01U ) != 0U )
+	{
+		/* A broadcast or a multicast. */
+		#if ( niMULTICAST_FILTER != 0 )
+		{
+		UBaseType_t uxIndex;
+
+			if( memcmp( pxHeader->xDestinationAddress.ucBytes, xBroadcastMACAddress.ucBytes, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 )
+			{
+				xReturn = pdTRUE;
+			}
+			else
+			{
+				pthread_mutex_lock( &xFilterMutex );
+
+				for( uxIndex = 0; uxIndex < uxMulticastCount; uxIndex++ )
+				{
+					if( memcmp( pxHeader->xDestinationAddress.ucBytes, xMulticastAddresses[ uxIndex ].ucBytes, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 )
+					{
+						xReturn = pdTRUE;
+						break;
+					}
+				}
+
+				pthread_mutex_unlock( &xFilterMutex );
+			}
+		}
+		#else
+		{
+			xReturn = pdTRUE;
+		}
+		#endif /* niMULTICAST_FILTER */
+	}
+	else
+	{
+		/* A unicast for another node. */
+	}
+
+	return xReturn;
+}
+
+/*!
+ * @brief read up to configTAP_BATCH_SIZE frames from one queue, straight
+ *        into the free space of the receive buffer
+ * @param [in] iFile the file descriptor of the queue
+ * @returns pdTRUE when the batch was full or the buffer ran out of space,
+ *          and more frames may be waiting
+ * @warning this is called from a Linux thread, do not attempt any FreeRTOS calls
+ */
+static BaseType_t prvReadQueue( int iFile )
+{
+struct iovec xVectors[ 2 ];
+uint8_t ucFrame[ niMAX_FRAME_SIZE ];
+BaseType_t xMore = pdTRUE;
+int iCount;
+int iBatch;
+ssize_t xResult;
+size_t xLength;
+size_t uxLinkHeader;
+
+	#if ( configTAP_USE_TUN != 0 )
+		/* An Ethernet header is added in front of every IP-packet. */
+		uxLinkHeader = ipSIZE_OF_ETH_HEADER;
+	#else
+		uxLinkHeader = 0U;
+	#endif
+
+	for( iBatch = 0; iBatch < configTAP_BATCH_SIZE; iBatch++ )
+	{
+		if( uxStreamBufferGetSpace( xRecvBuffer ) < ( sizeof( xLength ) + niMAX_FRAME_SIZE + 1U ) )
+		{
+			/* The IP-task is not fast enough, leave the frames in the queue
+			of the device. */
+			ulRecvOverflows++;
+			break;
+		}
+
+		/* The frame is stored after the space for its length.  One byte
+		more is read to detect frames that are too long: the device would
+		truncate them silently. */
+		iCount = prvRingVectors( xRecvBuffer,
+								 xRecvBuffer->uxHead + sizeof( xLength ) + uxLinkHeader,
+								 niMAX_FRAME_SIZE - uxLinkHeader + 1U,
+								 xVectors );
+		xResult = readv( iFile, xVectors, iCount );
+
+		if( xResult <= 0 )
+		{
+			/* EAGAIN: the queue is empty. */
+			xMore = pdFALSE;
+			break;
+		}
+
+		xLength = ( size_t ) xResult + uxLinkHeader;
+
+		if( xLength > niMAX_FRAME_SIZE )
+		{
+			continue;
+		}
+
+		#if ( configTAP_USE_TUN != 0 )
+		{
+		EthernetHeader_t xHeader;
+		uint32_t ulDestination;
+
+			/* Only IPv4 is supported. */
+			iCount = prvRingVectors( xRecvBuffer, xRecvBuffer->uxHead + sizeof( xLength ) + uxLinkHeader, ipSIZE_OF_IPv4_HEADER, xVectors );
+			memcpy( ucFrame, xVectors[ 0 ].iov_base, xVectors[ 0 ].iov_len );
+
+			if( iCount > 1 )
+			{
+				memcpy( ucFrame + xVectors[ 0 ].iov_len, xVectors[ 1 ].iov_base, xVectors[ 1 ].iov_len );
+			}
+
+			if( ( xResult < ( ssize_t ) ipSIZE_OF_IPv4_HEADER ) || ( ( ucFrame[ 0 ] & 0xF0U ) != 0x40U ) )
+			{
+				continue;
+			}
+
+			/* Give the frame the MAC-address that belongs to its destination
+			IP-address, so that multicasts are handled normally. */
+			memcpy( &ulDestination, &( ucFrame[ 16 ] ), sizeof( ulDestination ) );
+
+			if( ulDestination == FreeRTOS_htonl( 0xffffffffUL ) )
+			{
+				memcpy( xHeader.xDestinationAddress.ucBytes, xBroadcastMACAddress.ucBytes, ipMAC_ADDRESS_LENGTH_BYTES );
+			}
+			else if( ( ucFrame[ 16 ] & 0xF0U ) == 0xE0U )
+			{
+				xHeader.xDestinationAddress.ucBytes[ 0 ] = 0x01U;
+				xHeader.xDestinationAddress.ucBytes[ 1 ] = 0x00U;
+				xHeader.xDestinationAddress.ucBytes[ 2 ] = 0x5EU;
+				xHeader.xDestinationAddress.ucBytes[ 3 ] = ( uint8_t ) ( ucFrame[ 17 ] & 0x7FU );
+				xHeader.xDestinationAddress.ucBytes[ 4 ] = ucFrame[ 18 ];
+				xHeader.xDestinationAddress.ucBytes[ 5 ] = ucFrame[ 19 ];
+			}
+			else
+			{
+				memcpy( xHeader.xDestinationAddress.ucBytes, ucLocalMACAddress, ipMAC_ADDRESS_LENGTH_BYTES );
+			}
+
+			memcpy( xHeader.xSourceAddress.ucBytes, ucPeerMACAddress, ipMAC_ADDRESS_LENGTH_BYTES );
+			xHeader.usFrameType = ipIPv4_FRAME_TYPE;
+			prvRingWrite( xRecvBuffer, sizeof( xLength ), &xHeader, sizeof( xHeader ) );
+		}
+		#endif /* configTAP_USE_TUN */
+
+		/* Look at the Ethernet header, which may wrap around. */
+		iCount = prvRingVectors( xRecvBuffer, xRecvBuffer->uxHead + sizeof( xLength ), sizeof( EthernetHeader_t ), xVectors );
+		memcpy( ucFrame, xVectors[ 0 ].iov_base, xVectors[ 0 ].iov_len );
+
+		if( iCount > 1 )
+		{
+			memcpy( ucFrame + xVectors[ 0 ].iov_len, xVectors[ 1 ].iov_base, xVectors[ 1 ].iov_len );
+		}
+
+		if( prvAcceptFrame( ucFrame, xLength ) != pdFALSE )
+		{
+			prvRingWrite( xRecvBuffer, 0, &xLength, sizeof( xLength ) );
+
+			/* The frame becomes visible to the reader by moving the head
+			once, after all bytes have been written. */
+			__atomic_thread_fence( __ATOMIC_RELEASE );
+			( void ) uxStreamBufferAdd( xRecvBuffer, 0, NULL, sizeof( xLength ) + xLength );
+		}
+	}
+
+	return xMore;
+}
+
+/*!
+ * @brief infinite loop pthread that waits until a queue of the device is
+ *        readable, and then reads all queues in batches
+ * @param [in] pvParam not used
+ * @returns NULL
+ * @warning this is called from a Linux thread, do not attempt any FreeRTOS calls
+ */
+static void * prvLinuxTapRecvThread( void *pvParam )
+{
+struct pollfd xPollFiles[ configTAP_QUEUES ];
+const struct timespec xBackOff = { 0, 1000000L };
+BaseType_t xMore;
+size_t uxHead;
+int iQueue;
+sigset_t set;
+
+	( void ) pvParam;
+
+	/* Disable signals to this thread since this is a Linux pthread to be able to
+	 * printf and other blocking operations without being interruped and put in
+	 * suspension mode by the linux port signals
+	 */
+	sigfillset( &set );
+	pthread_sigmask( SIG_SETMASK, &set, NULL );
+
+	for( iQueue = 0; iQueue < configTAP_QUEUES; iQueue++ )
+	{
+		xPollFiles[ iQueue ].fd = iQueueFiles[ iQueue ];
+		xPollFiles[ iQueue ].events = POLLIN;
+	}
+
+	for( ; ; )
+	{
+		( void ) poll( xPollFiles, configTAP_QUEUES, niMAX_MS_TO_WAIT );
+
+		do
+		{
+			xMore = pdFALSE;
+			uxHead = xRecvBuffer->uxHead;
+
+			/* Visit the queues in turn, so that a busy queue can not starve
+			the others. */
+			for( iQueue = 0; iQueue < configTAP_QUEUES; iQueue++ )
+			{
+				if( prvReadQueue( iQueueFiles[ iQueue ] ) != pdFALSE )
+				{
+					xMore = pdTRUE;
+				}
+			}
+
+			/* Wake up the interrupt simulator task once per batch. */
+			if( xRecvBuffer->uxHead != uxHead )
+			{
+				event_interrupt_raise( niRX_INTERRUPT );
+			}
+
+			if( ( xMore != pdFALSE ) &&
+				( uxStreamBufferGetSpace( xRecvBuffer ) < ( sizeof( size_t ) + niMAX_FRAME_SIZE + 1U ) ) )
+			{
+				/* Give the IP-task some time to empty the buffer. */
+				( void ) nanosleep( &xBackOff, NULL );
+			}
+		} while( xMore != pdFALSE );
+	}
+
+	return NULL;
+}
+
+/*!
+ * @brief return the queue through which a frame will be sent.  The packets
+ *        of one TCP or UDP connection always use the same queue
+ * @returns a queue number smaller than configTAP_QUEUES
+ */
+static size_t prvSelectQueue( const StreamBuffer_t *pxBuffer,
+							  size_t uxPosition,
+							  size_t uxLength )
+{
+size_t uxQueue = 0U;
+
+	#if ( configTAP_QUEUES > 1 )
+	{
+	struct iovec xVectors[ 2 ];
+	uint8_t ucHeaders[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + 4U ];
+	uint32_t ulHash = 0U;
+	size_t uxIndex;
+	int iCount;
+
+		if( uxLength >= sizeof( ucHeaders ) )
+		{
+			iCount = prvRingVectors( pxBuffer, uxPosition, sizeof( ucHeaders ), xVectors );
+			memcpy( ucHeaders, xVectors[ 0 ].iov_base, xVectors[ 0 ].iov_len );
+
+			if( iCount > 1 )
+			{
+				memcpy( ucHeaders + xVectors[ 0 ].iov_len, xVectors[ 1 ].iov_base, xVectors[ 1 ].iov_len );
+			}
+
+			/* Hash the IP-addresses and, for a header without options, the
+			port numbers. */
+			if( ( ucHeaders[ 12 ] == 0x08U ) && ( ucHeaders[ 13 ] == 0x00U ) && ( ucHeaders[ 14 ] == 0x45U ) )
+			{
+				for( uxIndex = ipSIZE_OF_ETH_HEADER + 12U; uxIndex < sizeof( ucHeaders ); uxIndex++ )
+				{
+					ulHash = ( ulHash * 31U ) + ucHeaders[ uxIndex ];
+				}
+			}
+
+			uxQueue = ( size_t ) ( ulHash % ( uint32_t ) configTAP_QUEUES );
+		}
+	}
+	#else
+	{
+		( void ) pxBuffer;
+		( void ) uxPosition;
+		( void ) uxLength;
+	}
+	#endif /* configTAP_QUEUES */
+
+	return uxQueue;
+}
+
+/*!
+ * @brief Infinite loop thread that waits for events when there is data
+ *        available then writes the frames to the device, directly from
+ *        the send buffer
+ * @param [in] pvParam not used
+ * @returns NULL
+ * @warning this is called from a Linux thread, do not attempt any FreeRTOS calls
+ */
+static void * prvLinuxTapSendThread( void *pvParam )
+{
+struct pollfd xPollFile;
+struct iovec xVectors[ 2 ];
+uint64_t ullCount;
+size_t xLength;
+size_t uxLinkHeader;
+size_t uxQueue;
+int iCount;
+sigset_t set;
+
+	( void ) pvParam;
+
+	/* disable signals to avoid treating this thread as a FreeRTOS task and puting
+	 * it to sleep by the scheduler */
+	sigfillset( &set );
+	pthread_sigmask( SIG_SETMASK, &set, NULL );
+
+	#if ( configTAP_USE_TUN != 0 )
+		/* Only the IP-packet is written. */
+		uxLinkHeader = ipSIZE_OF_ETH_HEADER;
+	#else
+		uxLinkHeader = 0U;
+	#endif
+
+	xPollFile.fd = iSendEvent;
+	xPollFile.events = POLLIN;
+
+	for( ; ; )
+	{
+		/* Tell xNetworkInterfaceOutput() that a wake-up is needed, and look
+		at the buffer once more before sleeping. */
+		xSendThreadIdle = pdTRUE;
+		__atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+		if( uxStreamBufferGetSize( xSendBuffer ) <= sizeof( xLength ) )
+		{
+			( void ) poll( &xPollFile, 1, niMAX_MS_TO_WAIT );
+		}
+
+		xSendThreadIdle = pdFALSE;
+		( void ) read( iSendEvent, &ullCount, sizeof( ullCount ) );
+
+		/* Send all frames in the buffer with one system call each, without
+		copying them first. */
+		while( uxStreamBufferGetSize( xSendBuffer ) > sizeof( xLength ) )
+		{
+			uxStreamBufferGet( xSendBuffer, 0, ( uint8_t * ) &xLength, sizeof( xLength ), pdTRUE );
+			__atomic_thread_fence( __ATOMIC_ACQUIRE );
+
+			if( xLength > uxLinkHeader )
+			{
+				uxQueue = prvSelectQueue( xSendBuffer, xSendBuffer->uxTail + sizeof( xLength ), xLength );
+				iCount = prvRingVectors( xSendBuffer,
+										 xSendBuffer->uxTail + sizeof( xLength ) + uxLinkHeader,
+										 xLength - uxLinkHeader,
+										 xVectors );
+
+				if( writev( iQueueFiles[ uxQueue ], xVectors, iCount ) < 0 )
+				{
+					FreeRTOS_debug_printf( ( "writev: send failed %d\n", ulSendFailures ) );
+					ulSendFailures++;
+				}
+			}
+
+			( void ) uxStreamBufferGet( xSendBuffer, 0, NULL, sizeof( xLength ) + xLength, pdFALSE );
+		}
+	}
+
+	return NULL;
+}
+
+#if ( configTAP_USE_TUN != 0 )
+
+/*!
+ * @brief A TUN device has no link layer.  An ARP request of the IP-task is
+ *        turned into a reply from the virtual peer, and passed back to the
+ *        IP-task.  Frames other than IPv4 are dropped
+ * @returns pdTRUE when the network buffer has been taken care of
+ */
+	static BaseType_t prvAnswerARPRequest( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+										   BaseType_t bReleaseAfterSend )
+	{
+	ARPPacket_t *pxARPFrame = ipPOINTER_CAST( ARPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+	NetworkBufferDescriptor_t *pxReply = NULL;
+	IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+	BaseType_t xReturn = pdTRUE;
+	uint32_t ulTarget;
+
+		if( pxARPFrame->xEthernetHeader.usFrameType == ipIPv4_FRAME_TYPE )
+		{
+			/* The Tx thread will write it. */
+			xReturn = pdFALSE;
+		}
+		else if( ( pxARPFrame->xEthernetHeader.usFrameType == ipARP_FRAME_TYPE ) &&
+				 ( pxARPFrame->xARPHeader.usOperation == ( uint16_t ) ipARP_REQUEST ) &&
+				 ( pxARPFrame->xARPHeader.ulTargetProtocolAddress != *ipLOCAL_IP_ADDRESS_POINTER ) )
+		{
+			/* A gratuitous ARP, which asks for the own address, is not
+			answered. */
+			if( bReleaseAfterSend != pdFALSE )
+			{
+				pxReply = pxNetworkBuffer;
+			}
+			else
+			{
+				pxReply = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+			}
+
+			if( pxReply != NULL )
+			{
+				pxARPFrame = ipPOINTER_CAST( ARPPacket_t *, pxReply->pucEthernetBuffer );
+				ulTarget = pxARPFrame->xARPHeader.ulTargetProtocolAddress;
+
+				pxARPFrame->xARPHeader.usOperation = ( uint16_t ) ipARP_REPLY;
+				memcpy( pxARPFrame->xARPHeader.xTargetHardwareAddress.ucBytes, pxARPFrame->xARPHeader.xSenderHardwareAddress.ucBytes, ipMAC_ADDRESS_LENGTH_BYTES );
+				memcpy( &( pxARPFrame->xARPHeader.ulTargetProtocolAddress ), pxARPFrame->xARPHeader.ucSenderProtocolAddress, sizeof( ulTarget ) );
+				memcpy( pxARPFrame->xARPHeader.xSenderHardwareAddress.ucBytes, ucPeerMACAddress, ipMAC_ADDRESS_LENGTH_BYTES );
+				memcpy( pxARPFrame->xARPHeader.ucSenderProtocolAddress, &ulTarget, sizeof( ulTarget ) );
+				memcpy( pxARPFrame->xEthernetHeader.xDestinationAddress.ucBytes, ipLOCAL_MAC_ADDRESS, ipMAC_ADDRESS_LENGTH_BYTES );
+				memcpy( pxARPFrame->xEthernetHeader.xSourceAddress.ucBytes, ucPeerMACAddress, ipMAC_ADDRESS_LENGTH_BYTES );
+
+				xRxEvent.pvData = ( void * ) pxReply;
+
+				if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdFAIL )
+				{
+					vReleaseNetworkBufferAndDescriptor( pxReply );
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+			}
+		}
+		else
+		{
+			/* Nothing to send over a TUN device. */
+		}
+
+		if( ( xReturn != pdFALSE ) && ( bReleaseAfterSend != pdFALSE ) && ( pxReply != pxNetworkBuffer ) )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+		}
+
+		return xReturn;
+	}
+
+#endif /* configTAP_USE_TUN */
+
+/*!
+ * @brief simulated interrupt, raised by the Rx thread when it has stored
+ *        frames.  It runs in the context of the FreeRTOS task that was
+ *        interrupted, and may only use the FromISR API
+ */
+static void prvRecvInterruptHandler( void )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if( xInterruptSimulatorTask != NULL )
+	{
+		vTaskNotifyGiveFromISR( xInterruptSimulatorTask, &xHigherPriorityTaskWoken );
+		portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+	}
+}
+
+/*!
+ * @brief FreeRTOS infinite loop thread that simulates a network interrupt to notify the
+ *         network stack of the presence of new data
+ * @param [in] pvParameters not used
+ */
+static void prvInterruptSimulatorTask( void *pvParameters )
+{
+size_t xLength;
+uint8_t ucHeader[ sizeof( EthernetHeader_t ) ];
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+eFrameProcessingResult_t eResult;
+
+	/* Remove compiler warnings about unused parameters. */
+	( void ) pvParameters;
+
+	for( ; ; )
+	{
+		/* Does the circular buffer used to pass data from the Rx thread into
+		the FreeRTOS simulator contain another frame? */
+		if( uxStreamBufferGetSize( xRecvBuffer ) > sizeof( xLength ) )
+		{
+			/* Get the length of the next frame, and peek at its Ethernet
+			header.  The Rx thread checked the minimal size. */
+			uxStreamBufferGet( xRecvBuffer, 0, ( uint8_t * ) &xLength, sizeof( xLength ), pdFALSE );
+			__atomic_thread_fence( __ATOMIC_ACQUIRE );
+			uxStreamBufferGet( xRecvBuffer, 0, ucHeader, sizeof( ucHeader ), pdTRUE );
+
+			iptraceNETWORK_INTERFACE_RECEIVE();
+
+			eResult = ipCONSIDER_FRAME_FOR_PROCESSING( ucHeader );
+			pxNetworkBuffer = NULL;
+
+			if( eResult == eProcessBuffer )
+			{
+				/* Obtain a buffer into which the data can be placed.  This
+				is only	an interrupt simulator, not a real interrupt, so it
+				is ok to call the task level function here. */
+				pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( xLength, 0 );
+
+				if( pxNetworkBuffer == NULL )
+				{
+					ipSTATS_COUNT_DROP( eIPDropNoBuffer );
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+			}
+
+			if( pxNetworkBuffer != NULL )
+			{
+				/* Read the frame straight into the network buffer. */
+				uxStreamBufferGet( xRecvBuffer, 0, pxNetworkBuffer->pucEthernetBuffer, xLength, pdFALSE );
+				pxNetworkBuffer->xDataLength = xLength;
+				iptraceCAPTURE_PACKET( pxNetworkBuffer->pucEthernetBuffer, xLength, pdTRUE );
+				xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+
+				/* Data was received and stored.  Send a message to the IP
+				task to let it know. */
+				if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdFAIL )
+				{
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+			}
+			else
+			{
+				/* Drop the frame. */
+				uxStreamBufferGet( xRecvBuffer, 0, NULL, xLength, pdFALSE );
+			}
+		}
+		else
+		{
+			/* Wait for the simulated interrupt from the Rx thread.  The
+			time-out only matters when the interrupt could not be installed,
+			or when its signal was taken by a thread that is not a task. */
+			( void ) ulTaskNotifyTake( pdTRUE, configWINDOWS_MAC_INTERRUPT_SIMULATOR_DELAY );
+		}
+	}
+}
@@ -81,6 +81,7 @@
 #include "FreeRTOS_IP_Private.h"
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
+#include "FreeRTOS_IP_Stack.h"
 
 #include "tcpip/tcpip.h"
 #include "tcpip/src/tcpip_private.h"
@@ -306,8 +307,7 @@ BaseType_t xNetworkBuffersInitialise( void )
              * in FreeRTOS+Trace.  */
             #if ( ipconfigINCLUDE_EXAMPLE_FREERTOS_PLUS_TRACE_CALLS == 1 )
                 {
-                    extern QueueHandle_t xNetworkEventQueue;
-                    vTraceSetQueueName( xNetworkEventQueue, "IPStackEvent" );
+                    vTraceSetQueueName( pxIPStack->xNetworkEventQueue, "IPStackEvent" );
                     vTraceSetQueueName( xNetworkBufferSemaphore, "NetworkBufferCount" );
                 }
             #endif /*  ipconfigINCLUDE_EXAMPLE_FREERTOS_PLUS_TRACE_CALLS == 1 */
@@ -499,6 +499,16 @@ NetworkBufferDescriptor_t * pxGetNetworkBufferWithDescriptor( size_t xRequestedS
                         pxReturn->pxNextBuffer = NULL;
                     }
                 #endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+                #if ( ipconfigUSE_ROUTING != 0 )
+                    {
+                        /* The buffer belongs to the primary end-point until it
+                         * is routed. */
+                        pxReturn->pxInterface = NULL;
+                        pxReturn->pxEndPoint = NULL;
+                        pxReturn->ulNextHop = 0UL;
+                    }
+                #endif /* ipconfigUSE_ROUTING */
             }
         }
         else
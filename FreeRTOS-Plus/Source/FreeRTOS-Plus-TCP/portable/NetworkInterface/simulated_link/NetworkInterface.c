@@ -0,0 +1,869 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/*
+ * A network interface that does not need a network: the frames travel over a
+ * simulated link between two ports, see SimulatedLink.h.  It only uses the
+ * FreeRTOS API, no threads of the host, so the behaviour of the link only
+ * depends on the tick count and on the seeds.
+ *
+ * Every frame that is sent goes through these steps:
+ *   - it is lost with a probability of ulLossPPM;
+ *   - it is tail-dropped when the bytes waiting for the link would exceed
+ *     ulQueueLimitBytes;
+ *   - it occupies the link for its length divided by ulBandwidthBps;
+ *   - it is delivered ulLatencyUs plus a random jitter after it has left the
+ *     link.  Jitter alone does not reorder frames: a frame is never delivered
+ *     before the frame that was sent in front of it;
+ *   - with a probability of ulReorderPPM it is held back ulReorderDelayUs
+ *     longer, so that the next frames overtake it;
+ *   - with a probability of ulDuplicatePPM a copy is delivered as well.
+ *
+ * The frames in flight wait in a delay line that is sorted on the time of
+ * delivery.  A task, with the priority of the interrupt simulators of the
+ * other drivers, passes them to the receiving IP-task when their time has
+ * come.  The time has the resolution of a clock tick.
+ */
+
+/* ========================= FreeRTOS includes ============================== */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* ========================= FreeRTOS+TCP includes ========================== */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+#include "FreeRTOS_IP_Stack.h"
+#include "SimulatedLink.h"
+
+/* ======================== Standard Library inludes ======================== */
+#include <string.h>
+#include <stdint.h>
+
+/* ======================== Macro Definitions =============================== */
+#if ( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES == 0 )
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer )    eProcessBuffer
+#else
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) \
+	eConsiderFrameForProcessing( ( pucEthernetBuffer ) )
+#endif
+
+/* The parameters that both directions have until xSimLinkSetParameters() is
+called. */
+#ifndef configSIM_LINK_LATENCY_US
+	#define configSIM_LINK_LATENCY_US		 0U
+#endif
+
+#ifndef configSIM_LINK_JITTER_US
+	#define configSIM_LINK_JITTER_US		 0U
+#endif
+
+#ifndef configSIM_LINK_LOSS_PPM
+	#define configSIM_LINK_LOSS_PPM			 0U
+#endif
+
+#ifndef configSIM_LINK_DUPLICATE_PPM
+	#define configSIM_LINK_DUPLICATE_PPM	 0U
+#endif
+
+#ifndef configSIM_LINK_REORDER_PPM
+	#define configSIM_LINK_REORDER_PPM		 0U
+#endif
+
+#ifndef configSIM_LINK_REORDER_DELAY_US
+	#define configSIM_LINK_REORDER_DELAY_US	 1000U
+#endif
+
+#ifndef configSIM_LINK_BANDWIDTH_BPS
+	#define configSIM_LINK_BANDWIDTH_BPS	 0U
+#endif
+
+#ifndef configSIM_LINK_QUEUE_LIMIT_BYTES
+	#define configSIM_LINK_QUEUE_LIMIT_BYTES 0U
+#endif
+
+#ifndef configSIM_LINK_SEED
+	#define configSIM_LINK_SEED				 1U
+#endif
+
+/* The maximum number of frames in flight in each direction.  They all hold a
+network buffer. */
+#ifndef configSIM_LINK_DELAY_LINE_LENGTH
+	#define configSIM_LINK_DELAY_LINE_LENGTH 64
+#endif
+
+#ifndef configSIM_LINK_TASK_PRIORITY
+	#define configSIM_LINK_TASK_PRIORITY	 configMAC_ISR_SIMULATOR_PRIORITY
+#endif
+
+/* ============================== Definitions =============================== */
+#define niMAX_FRAME_SIZE		 ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER )
+
+/* The number of frames that the link task delivers before it looks at the
+clock again. */
+#define niDELIVERY_BATCH		 8
+
+#define niMICROSECONDS			 1000000ULL
+#define niPARTS_PER_MILLION		 1000000UL
+
+/* The storage of a network buffer when BufferAllocation_1.c is used. */
+#define niBUFFER_STORAGE_SIZE	 ( ( ipBUFFER_PADDING + ipTOTAL_ETHERNET_FRAME_SIZE + 31U ) & ~31U )
+
+/* A frame in flight. */
+typedef struct xSIM_FRAME
+{
+	uint64_t ullDeliveryUs;
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+} SimFrame_t;
+
+/* The frames sent by one port. */
+typedef struct xSIM_DIRECTION
+{
+	SimLinkParameters_t xParameters;
+	SimLinkStats_t xStats;
+	uint32_t ulRandom;				/* The state of the random generator. */
+	uint64_t ullLinkFreeUs;			/* The time at which the link has sent the last frame. */
+	uint64_t ullLastDeliveryUs;		/* The delivery time of the last frame that was not reordered. */
+	SimFrame_t xFrames[ configSIM_LINK_DELAY_LINE_LENGTH ];	/* Sorted on ullDeliveryUs. */
+	UBaseType_t uxFrameCount;
+} SimDirection_t;
+
+/* A port and what is attached to it. */
+typedef struct xSIM_PORT
+{
+	BaseType_t xStackAttached;		/* pdTRUE once an IP-task has initialised the port. */
+	UBaseType_t uxStack;			/* The number of that stack. */
+	SimLinkReceiveHook_t pxHook;
+} SimPort_t;
+
+/* ================== Static Function Prototypes ============================ */
+static void prvInitialiseOnce( void );
+static BaseType_t prvPortInitialise( BaseType_t xPort );
+static BaseType_t prvPortOutput( BaseType_t xPort,
+								 NetworkBufferDescriptor_t * const pxNetworkBuffer,
+								 BaseType_t xReleaseAfterSend );
+static void prvLinkTransmit( BaseType_t xPort,
+							 NetworkBufferDescriptor_t *pxNetworkBuffer );
+static BaseType_t prvInsertFrame( SimDirection_t *pxDirection,
+								  NetworkBufferDescriptor_t *pxNetworkBuffer,
+								  uint64_t ullDeliveryUs );
+static void prvDeliverFrame( BaseType_t xPort,
+							 NetworkBufferDescriptor_t *pxNetworkBuffer );
+static uint32_t prvRandom( SimDirection_t *pxDirection );
+static BaseType_t prvChance( SimDirection_t *pxDirection,
+							 uint32_t ulPartsPerMillion );
+static uint64_t prvNowUs( void );
+static void prvSimLinkTask( void *pvParameters );
+
+/* ======================== Static Global Variables ========================= */
+static SimDirection_t xDirections[ simLINK_PORT_COUNT ];
+static SimPort_t xPorts[ simLINK_PORT_COUNT ];
+static TaskHandle_t xSimLinkTask = NULL;
+static BaseType_t xInitialised = pdFALSE;
+
+/* The 64-bit time in ticks, so that it does not wrap around. */
+static uint64_t ullTickCount = 0U;
+static TickType_t xLastTick = 0U;
+
+/* ======================= API Function definitions ========================= */
+
+/*!
+ * @brief API call, called from FreeRTOS_IP.c to attach stack 0 to port 0
+ * @return pdPASS if successful else pdFAIL
+ */
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+	return prvPortInitialise( simLINK_PORT_0 );
+}
+
+/*!
+ * @brief API call, called from FreeRTOS_IP.c to send a frame from port 0
+ * @return pdPASS, also when the link has dropped the frame
+ */
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+									BaseType_t xReleaseAfterSend )
+{
+	return prvPortOutput( simLINK_PORT_0, pxNetworkBuffer, xReleaseAfterSend );
+}
+
+/*!
+ * @brief driver function of port 1, passed to FreeRTOS_IPInitStack()
+ * @return pdPASS if successful else pdFAIL
+ */
+BaseType_t xSimLinkPort1Initialise( void )
+{
+	return prvPortInitialise( simLINK_PORT_1 );
+}
+
+/*!
+ * @brief driver function of port 1, passed to FreeRTOS_IPInitStack()
+ * @return pdPASS, also when the link has dropped the frame
+ */
+BaseType_t xSimLinkPort1Output( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+								BaseType_t xReleaseAfterSend )
+{
+	return prvPortOutput( simLINK_PORT_1, pxNetworkBuffer, xReleaseAfterSend );
+}
+
+/*!
+ * @brief API call, called from BufferAllocation_1.c to give every network
+ *        buffer room for the largest frame
+ * @param [in] pxNetworkBuffers the descriptors that need storage
+ */
+void vNetworkInterfaceAllocateRAMToBuffers( NetworkBufferDescriptor_t pxNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ] )
+{
+static uint8_t ucNetworkPackets[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS * niBUFFER_STORAGE_SIZE ] __attribute__( ( aligned( 32 ) ) );
+uint8_t *pucRAMBuffer = ucNetworkPackets;
+uint32_t ul;
+
+	for( ul = 0; ul < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; ul++ )
+	{
+		/* The storage starts with a pointer to its descriptor. */
+		pxNetworkBuffers[ ul ].pucEthernetBuffer = pucRAMBuffer + ipBUFFER_PADDING;
+		*( ( NetworkBufferDescriptor_t ** ) pucRAMBuffer ) = &( pxNetworkBuffers[ ul ] );
+		pucRAMBuffer += niBUFFER_STORAGE_SIZE;
+	}
+}
+
+#if ( ipconfigUSE_IGMP != 0 ) && ( ipconfigIGMP_DRIVER_MULTICAST_FILTER != 0 )
+
+/*!
+ * @brief API call.  The link passes all frames, the IP-task filters them
+ */
+	void vNetworkInterfaceUpdateMulticastFilter( void )
+	{
+	}
+
+#endif
+
+/*!
+ * @brief set the parameters of the frames sent by a port, and re-seed its
+ *        random generator
+ * @return pdPASS if successful else pdFAIL
+ */
+BaseType_t xSimLinkSetParameters( BaseType_t xPort,
+								  const SimLinkParameters_t *pxParameters )
+{
+BaseType_t xReturn = pdFAIL;
+SimDirection_t *pxDirection;
+
+	prvInitialiseOnce();
+
+	if( ( xPort >= 0 ) && ( xPort < simLINK_PORT_COUNT ) && ( pxParameters != NULL ) )
+	{
+		pxDirection = &( xDirections[ xPort ] );
+
+		taskENTER_CRITICAL();
+		{
+			pxDirection->xParameters = *pxParameters;
+			pxDirection->ulRandom = ( pxParameters->ulSeed != 0U ) ? pxParameters->ulSeed : 1U;
+		}
+		taskEXIT_CRITICAL();
+
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+
+/*!
+ * @brief copy, and optionally clear, the counters of the frames sent by a port
+ * @return pdPASS if successful else pdFAIL
+ */
+BaseType_t xSimLinkGetStats( BaseType_t xPort,
+							 SimLinkStats_t *pxStats,
+							 BaseType_t xClear )
+{
+BaseType_t xReturn = pdFAIL;
+
+	if( ( xPort >= 0 ) && ( xPort < simLINK_PORT_COUNT ) && ( pxStats != NULL ) )
+	{
+		taskENTER_CRITICAL();
+		{
+			*pxStats = xDirections[ xPort ].xStats;
+
+			if( xClear != pdFALSE )
+			{
+				memset( &( xDirections[ xPort ].xStats ), 0, sizeof( xDirections[ xPort ].xStats ) );
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+
+/*!
+ * @brief install the hook that receives the frames for a port without a stack
+ */
+void vSimLinkSetReceiveHook( BaseType_t xPort,
+							 SimLinkReceiveHook_t pxHook )
+{
+	if( ( xPort >= 0 ) && ( xPort < simLINK_PORT_COUNT ) )
+	{
+		taskENTER_CRITICAL();
+		{
+			xPorts[ xPort ].pxHook = pxHook;
+		}
+		taskEXIT_CRITICAL();
+	}
+}
+
+/*!
+ * @brief send a copy of a frame from a port, on behalf of a packet generator
+ * @return pdPASS when the frame was passed to the link, pdFAIL when it is
+ *         too long or when there is no network buffer
+ */
+BaseType_t xSimLinkInject( BaseType_t xPort,
+						   const uint8_t *pucFrame,
+						   size_t uxLength )
+{
+BaseType_t xReturn = pdFAIL;
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+
+	if( ( xPort >= 0 ) && ( xPort < simLINK_PORT_COUNT ) && ( uxLength <= niMAX_FRAME_SIZE ) )
+	{
+		prvInitialiseOnce();
+
+		pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( uxLength, 0 );
+
+		if( pxNetworkBuffer != NULL )
+		{
+			memcpy( pxNetworkBuffer->pucEthernetBuffer, pucFrame, uxLength );
+			pxNetworkBuffer->xDataLength = uxLength;
+			prvLinkTransmit( xPort, pxNetworkBuffer );
+			xReturn = pdPASS;
+		}
+	}
+
+	return xReturn;
+}
+
+/* ====================== Static Function definitions ======================= */
+
+/*!
+ * @brief give both directions the parameters of the config macros, and create
+ *        the task that delivers the frames.  The first caller does the work
+ */
+static void prvInitialiseOnce( void )
+{
+const SimLinkParameters_t xDefaults =
+{
+	configSIM_LINK_LATENCY_US,
+	configSIM_LINK_JITTER_US,
+	configSIM_LINK_LOSS_PPM,
+	configSIM_LINK_DUPLICATE_PPM,
+	configSIM_LINK_REORDER_PPM,
+	configSIM_LINK_REORDER_DELAY_US,
+	configSIM_LINK_BANDWIDTH_BPS,
+	configSIM_LINK_QUEUE_LIMIT_BYTES,
+	configSIM_LINK_SEED
+};
+BaseType_t xFirst = pdFALSE;
+BaseType_t xPort;
+
+	taskENTER_CRITICAL();
+	{
+		if( xInitialised == pdFALSE )
+		{
+			xInitialised = pdTRUE;
+			xFirst = pdTRUE;
+
+			for( xPort = 0; xPort < simLINK_PORT_COUNT; xPort++ )
+			{
+				xDirections[ xPort ].xParameters = xDefaults;
+
+				/* The directions get different sequences from the same
+				seed. */
+				xDirections[ xPort ].ulRandom = ( uint32_t ) configSIM_LINK_SEED + ( uint32_t ) xPort;
+
+				if( xDirections[ xPort ].ulRandom == 0U )
+				{
+					xDirections[ xPort ].ulRandom = 1U;
+				}
+			}
+
+			xLastTick = xTaskGetTickCount();
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( xFirst != pdFALSE )
+	{
+		if( xTaskCreate( prvSimLinkTask,
+						 "SIM_LINK",
+						 configMINIMAL_STACK_SIZE,
+						 NULL,
+						 configSIM_LINK_TASK_PRIORITY,
+						 &xSimLinkTask ) != pdPASS )
+		{
+			FreeRTOS_printf( ( "prvInitialiseOnce: xTaskCreate could not create a new task\n" ) );
+		}
+	}
+}
+
+/*!
+ * @brief attach the IP-stack of the calling IP-task to a port
+ * @return pdPASS if successful else pdFAIL
+ */
+static BaseType_t prvPortInitialise( BaseType_t xPort )
+{
+	prvInitialiseOnce();
+
+	/* The port keeps the stack when the network goes down and up again. */
+	taskENTER_CRITICAL();
+	{
+		xPorts[ xPort ].uxStack = FreeRTOS_GetIPStack();
+		xPorts[ xPort ].xStackAttached = pdTRUE;
+	}
+	taskEXIT_CRITICAL();
+
+	return ( xSimLinkTask != NULL ) ? pdPASS : pdFAIL;
+}
+
+/*!
+ * @brief pass a frame of an IP-task to the link
+ * @return pdPASS
+ */
+static BaseType_t prvPortOutput( BaseType_t xPort,
+								 NetworkBufferDescriptor_t * const pxNetworkBuffer,
+								 BaseType_t xReleaseAfterSend )
+{
+NetworkBufferDescriptor_t *pxFrame = pxNetworkBuffer;
+
+	iptraceNETWORK_INTERFACE_TRANSMIT();
+
+	/* The packet is stored in a pcapng capture, only if
+	'ipconfigUSE_CAPTURE_PACKETS' is defined. */
+	iptraceCAPTURE_PACKET( pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdFALSE );
+
+	if( xReleaseAfterSend == pdFALSE )
+	{
+		/* The frame stays in flight for a while, it needs its own buffer. */
+		pxFrame = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+	}
+
+	if( pxFrame != NULL )
+	{
+		prvLinkTransmit( xPort, pxFrame );
+	}
+	else
+	{
+		ipSTATS_COUNT_DROP( eIPDropNoBuffer );
+	}
+
+	return pdPASS;
+}
+
+/*!
+ * @brief apply the parameters of the direction to a frame and put it in the
+ *        delay line, or drop it.  The link owns the network buffer
+ */
+static void prvLinkTransmit( BaseType_t xPort,
+							 NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+SimDirection_t *pxDirection = &( xDirections[ xPort ] );
+const SimLinkParameters_t *pxParameters = &( pxDirection->xParameters );
+NetworkBufferDescriptor_t *pxDuplicate = NULL;
+NetworkBufferDescriptor_t *pxDropped[ 2 ] = { NULL, NULL };
+BaseType_t xLost, xDuplicate, xReorder;
+int64_t llJitterUs = 0;
+uint64_t ullNowUs, ullStartUs, ullDeliveryUs, ullBacklogBytes;
+UBaseType_t uxOldCount;
+size_t uxLength = pxNetworkBuffer->xDataLength;
+BaseType_t xIndex;
+
+	/* The random numbers are drawn in a fixed order, so the decisions only
+	depend on the seed and on the sequence of frames, not on the timing of
+	the tasks. */
+	taskENTER_CRITICAL();
+	{
+		pxDirection->xStats.ulFramesSent++;
+		xLost = prvChance( pxDirection, pxParameters->ulLossPPM );
+		xDuplicate = prvChance( pxDirection, pxParameters->ulDuplicatePPM );
+		xReorder = prvChance( pxDirection, pxParameters->ulReorderPPM );
+
+		if( pxParameters->ulJitterUs != 0U )
+		{
+			llJitterUs = ( int64_t ) ( prvRandom( pxDirection ) % ( ( 2U * pxParameters->ulJitterUs ) + 1U ) ) - ( int64_t ) pxParameters->ulJitterUs;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( ( xLost == pdFALSE ) && ( xDuplicate != pdFALSE ) )
+	{
+		/* Duplicate outside the critical section, it takes a semaphore. */
+		pxDuplicate = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, uxLength );
+	}
+
+	taskENTER_CRITICAL();
+	{
+		ullNowUs = prvNowUs();
+		uxOldCount = pxDirection->uxFrameCount;
+		ullStartUs = ( pxDirection->ullLinkFreeUs > ullNowUs ) ? pxDirection->ullLinkFreeUs : ullNowUs;
+		ullBacklogBytes = 0U;
+
+		if( pxParameters->ulBandwidthBps != 0U )
+		{
+			ullBacklogBytes = ( ( ullStartUs - ullNowUs ) * pxParameters->ulBandwidthBps ) / ( 8U * niMICROSECONDS );
+		}
+
+		if( xLost != pdFALSE )
+		{
+			pxDirection->xStats.ulLost++;
+			pxDropped[ 0 ] = pxNetworkBuffer;
+			pxDropped[ 1 ] = pxDuplicate;
+		}
+		else if( ( pxParameters->ulQueueLimitBytes != 0U ) &&
+				 ( ( ullBacklogBytes + uxLength ) > pxParameters->ulQueueLimitBytes ) )
+		{
+			pxDirection->xStats.ulQueueDrops++;
+			pxDropped[ 0 ] = pxNetworkBuffer;
+			pxDropped[ 1 ] = pxDuplicate;
+		}
+		else
+		{
+			/* The time that the frame occupies the link. */
+			if( pxParameters->ulBandwidthBps != 0U )
+			{
+				pxDirection->ullLinkFreeUs = ullStartUs + ( ( ( uint64_t ) uxLength * 8U * niMICROSECONDS ) / pxParameters->ulBandwidthBps );
+			}
+			else
+			{
+				pxDirection->ullLinkFreeUs = ullStartUs;
+			}
+
+			ullDeliveryUs = pxDirection->ullLinkFreeUs + pxParameters->ulLatencyUs;
+
+			if( ( llJitterUs < 0 ) && ( ( uint64_t ) -llJitterUs > ( ullDeliveryUs - pxDirection->ullLinkFreeUs ) ) )
+			{
+				/* A frame can not arrive before it has been sent. */
+				ullDeliveryUs = pxDirection->ullLinkFreeUs;
+			}
+			else
+			{
+				ullDeliveryUs = ( uint64_t ) ( ( int64_t ) ullDeliveryUs + llJitterUs );
+			}
+
+			if( xReorder != pdFALSE )
+			{
+				/* Held back, the frames behind it are not. */
+				ullDeliveryUs += pxParameters->ulReorderDelayUs;
+				pxDirection->xStats.ulReordered++;
+			}
+			else
+			{
+				if( ullDeliveryUs < pxDirection->ullLastDeliveryUs )
+				{
+					ullDeliveryUs = pxDirection->ullLastDeliveryUs;
+				}
+
+				pxDirection->ullLastDeliveryUs = ullDeliveryUs;
+			}
+
+			if( prvInsertFrame( pxDirection, pxNetworkBuffer, ullDeliveryUs ) == pdFALSE )
+			{
+				pxDirection->xStats.ulQueueDrops++;
+				pxDropped[ 0 ] = pxNetworkBuffer;
+			}
+
+			if( pxDuplicate != NULL )
+			{
+				/* The copy follows right behind the original. */
+				if( prvInsertFrame( pxDirection, pxDuplicate, ullDeliveryUs ) == pdFALSE )
+				{
+					pxDirection->xStats.ulQueueDrops++;
+					pxDropped[ 1 ] = pxDuplicate;
+				}
+				else
+				{
+					pxDirection->xStats.ulDuplicated++;
+				}
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	for( xIndex = 0; xIndex < 2; xIndex++ )
+	{
+		if( pxDropped[ xIndex ] != NULL )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxDropped[ xIndex ] );
+		}
+	}
+
+	/* The link task may be sleeping until a later delivery time. */
+	if( ( pxDirection->uxFrameCount != uxOldCount ) && ( xSimLinkTask != NULL ) )
+	{
+		xTaskNotifyGive( xSimLinkTask );
+	}
+}
+
+/*!
+ * @brief insert a frame in the delay line, behind the frames with the same
+ *        delivery time.  Called in a critical section
+ * @return pdFALSE when the delay line is full
+ */
+static BaseType_t prvInsertFrame( SimDirection_t *pxDirection,
+								  NetworkBufferDescriptor_t *pxNetworkBuffer,
+								  uint64_t ullDeliveryUs )
+{
+BaseType_t xReturn = pdFALSE;
+UBaseType_t uxIndex;
+
+	if( pxDirection->uxFrameCount < ( UBaseType_t ) configSIM_LINK_DELAY_LINE_LENGTH )
+	{
+		/* Most frames go to the end, search from there. */
+		uxIndex = pxDirection->uxFrameCount;
+
+		while( ( uxIndex > 0U ) && ( pxDirection->xFrames[ uxIndex - 1U ].ullDeliveryUs > ullDeliveryUs ) )
+		{
+			pxDirection->xFrames[ uxIndex ] = pxDirection->xFrames[ uxIndex - 1U ];
+			uxIndex--;
+		}
+
+		pxDirection->xFrames[ uxIndex ].ullDeliveryUs = ullDeliveryUs;
+		pxDirection->xFrames[ uxIndex ].pxNetworkBuffer = pxNetworkBuffer;
+		pxDirection->uxFrameCount++;
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+
+/*!
+ * @brief pass a frame to what is attached to a port.  Called from the link
+ *        task, which selects the stack of the port
+ */
+static void prvDeliverFrame( BaseType_t xPort,
+							 NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+SimLinkReceiveHook_t pxHook;
+BaseType_t xAttached;
+UBaseType_t uxStack;
+BaseType_t xDelivered = pdFALSE;
+
+	taskENTER_CRITICAL();
+	{
+		xAttached = xPorts[ xPort ].xStackAttached;
+		uxStack = xPorts[ xPort ].uxStack;
+		pxHook = xPorts[ xPort ].pxHook;
+	}
+	taskEXIT_CRITICAL();
+
+	if( xAttached != pdFALSE )
+	{
+		#if ( ipconfigIP_STACK_COUNT > 1 )
+		{
+			( void ) FreeRTOS_SetIPStack( uxStack );
+		}
+		#else
+		{
+			( void ) uxStack;
+		}
+		#endif
+
+		iptraceNETWORK_INTERFACE_RECEIVE();
+		iptraceCAPTURE_PACKET( pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdTRUE );
+
+		if( ipCONSIDER_FRAME_FOR_PROCESSING( pxNetworkBuffer->pucEthernetBuffer ) == eProcessBuffer )
+		{
+			xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+
+			if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdPASS )
+			{
+				xDelivered = pdTRUE;
+			}
+			else
+			{
+				iptraceETHERNET_RX_EVENT_LOST();
+				taskENTER_CRITICAL();
+				{
+					xDirections[ 1 - xPort ].xStats.ulReceiveDrops++;
+				}
+				taskEXIT_CRITICAL();
+			}
+		}
+	}
+	else if( pxHook != NULL )
+	{
+		pxHook( xPort, pxNetworkBuffer );
+		xDelivered = pdTRUE;
+	}
+	else
+	{
+		/* Nothing is listening at this end. */
+	}
+
+	if( xDelivered == pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+}
+
+/*!
+ * @brief a xorshift generator: fast, and the same sequence on every host
+ */
+static uint32_t prvRandom( SimDirection_t *pxDirection )
+{
+uint32_t ulValue = pxDirection->ulRandom;
+
+	ulValue ^= ulValue << 13;
+	ulValue ^= ulValue >> 17;
+	ulValue ^= ulValue << 5;
+	pxDirection->ulRandom = ulValue;
+
+	return ulValue;
+}
+
+/*!
+ * @brief no random number is drawn for a probability of 0 or 100 %
+ * @return pdTRUE with a probability of 'ulPartsPerMillion'
+ */
+static BaseType_t prvChance( SimDirection_t *pxDirection,
+							 uint32_t ulPartsPerMillion )
+{
+BaseType_t xReturn = pdFALSE;
+
+	if( ulPartsPerMillion >= niPARTS_PER_MILLION )
+	{
+		xReturn = pdTRUE;
+	}
+	else if( ulPartsPerMillion != 0U )
+	{
+		if( ( prvRandom( pxDirection ) % niPARTS_PER_MILLION ) < ulPartsPerMillion )
+		{
+			xReturn = pdTRUE;
+		}
+	}
+	else
+	{
+		/* Never. */
+	}
+
+	return xReturn;
+}
+
+/*!
+ * @brief the time in microseconds, with the resolution of a tick.  Called in
+ *        a critical section
+ */
+static uint64_t prvNowUs( void )
+{
+TickType_t xNow = xTaskGetTickCount();
+
+	ullTickCount += ( uint64_t ) ( TickType_t ) ( xNow - xLastTick );
+	xLastTick = xNow;
+
+	return ( ullTickCount * niMICROSECONDS ) / ( uint64_t ) configTICK_RATE_HZ;
+}
+
+/*!
+ * @brief FreeRTOS task that delivers the frames of both directions when their
+ *        time has come, and sleeps until the next one is due
+ * @param [in] pvParameters not used
+ */
+static void prvSimLinkTask( void *pvParameters )
+{
+NetworkBufferDescriptor_t *pxBatch[ niDELIVERY_BATCH ];
+BaseType_t xTargets[ niDELIVERY_BATCH ];
+SimDirection_t *pxDirection;
+uint64_t ullNowUs, ullNextUs;
+TickType_t xTicksToWait;
+UBaseType_t uxCount, uxIndex;
+BaseType_t xPort;
+
+	/* Remove compiler warnings about unused parameters. */
+	( void ) pvParameters;
+
+	for( ; ; )
+	{
+		uxCount = 0U;
+		ullNextUs = UINT64_MAX;
+
+		taskENTER_CRITICAL();
+		{
+			ullNowUs = prvNowUs();
+
+			for( xPort = 0; xPort < simLINK_PORT_COUNT; xPort++ )
+			{
+				pxDirection = &( xDirections[ xPort ] );
+
+				while( ( pxDirection->uxFrameCount > 0U ) &&
+					   ( pxDirection->xFrames[ 0 ].ullDeliveryUs <= ullNowUs ) &&
+					   ( uxCount < ( UBaseType_t ) niDELIVERY_BATCH ) )
+				{
+					/* The frame goes to the other port. */
+					pxBatch[ uxCount ] = pxDirection->xFrames[ 0 ].pxNetworkBuffer;
+					xTargets[ uxCount ] = ( BaseType_t ) ( 1 - xPort );
+					uxCount++;
+
+					pxDirection->xStats.ulFramesDelivered++;
+					pxDirection->xStats.ulBytesDelivered += ( uint32_t ) pxDirection->xFrames[ 0 ].pxNetworkBuffer->xDataLength;
+
+					pxDirection->uxFrameCount--;
+					memmove( &( pxDirection->xFrames[ 0 ] ), &( pxDirection->xFrames[ 1 ] ), pxDirection->uxFrameCount * sizeof( pxDirection->xFrames[ 0 ] ) );
+				}
+
+				if( ( pxDirection->uxFrameCount > 0U ) && ( pxDirection->xFrames[ 0 ].ullDeliveryUs < ullNextUs ) )
+				{
+					ullNextUs = pxDirection->xFrames[ 0 ].ullDeliveryUs;
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+		{
+			prvDeliverFrame( xTargets[ uxIndex ], pxBatch[ uxIndex ] );
+		}
+
+		if( uxCount < ( UBaseType_t ) niDELIVERY_BATCH )
+		{
+			if( ullNextUs == UINT64_MAX )
+			{
+				xTicksToWait = portMAX_DELAY;
+			}
+			else if( ullNextUs <= ullNowUs )
+			{
+				xTicksToWait = 0U;
+			}
+			else
+			{
+				/* Round up to whole ticks. */
+				xTicksToWait = ( TickType_t ) ( ( ( ( ullNextUs - ullNowUs ) * ( uint64_t ) configTICK_RATE_HZ ) + niMICROSECONDS - 1U ) / niMICROSECONDS );
+			}
+
+			if( xTicksToWait != 0U )
+			{
+				( void ) ulTaskNotifyTake( pdTRUE, xTicksToWait );
+			}
+		}
+	}
+}
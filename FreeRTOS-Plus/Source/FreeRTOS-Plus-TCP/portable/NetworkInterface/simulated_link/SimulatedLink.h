@@ -0,0 +1,115 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+#ifndef SIMULATED_LINK_H
+#define SIMULATED_LINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A simulated point-to-point Ethernet link with two ports.  Port 0 is driven
+ * by xNetworkInterfaceInitialise() and xNetworkInterfaceOutput(), as used by
+ * stack 0.  Port 1 is either driven by a second IP-stack, started with
+ * FreeRTOS_IPInitStack( 1, ..., xSimLinkPort1Initialise, xSimLinkPort1Output ),
+ * or by a packet generator that uses xSimLinkInject() and a receive hook.
+ *
+ * Every direction has its own parameters and its own random generator, so
+ * that a run can be repeated exactly with the same seeds.
+ */
+
+/* The ends of the link. */
+#define simLINK_PORT_0			0
+#define simLINK_PORT_1			1
+#define simLINK_PORT_COUNT		2
+
+/* The properties of the direction from one port to the other.  The rates
+are expressed in parts per million of the frames. */
+typedef struct xSIM_LINK_PARAMETERS
+{
+	uint32_t ulLatencyUs;			/* The fixed one-way delay. */
+	uint32_t ulJitterUs;			/* A random delay between -ulJitterUs and +ulJitterUs is added. */
+	uint32_t ulLossPPM;				/* Frames that are dropped. */
+	uint32_t ulDuplicatePPM;		/* Frames that are delivered twice. */
+	uint32_t ulReorderPPM;			/* Frames that are held back by ulReorderDelayUs, so that later frames overtake them. */
+	uint32_t ulReorderDelayUs;
+	uint32_t ulBandwidthBps;		/* The bit rate of the link, 0 for an infinitely fast link. */
+	uint32_t ulQueueLimitBytes;		/* The bytes waiting for the link before frames are tail-dropped, 0 for no limit. */
+	uint32_t ulSeed;				/* The seed of the random generator, 0 is replaced by 1. */
+} SimLinkParameters_t;
+
+/* The counters of one direction. */
+typedef struct xSIM_LINK_STATS
+{
+	uint32_t ulFramesSent;			/* Frames offered by the sending port. */
+	uint32_t ulFramesDelivered;		/* Frames passed to the receiving port, duplicates included. */
+	uint32_t ulBytesDelivered;
+	uint32_t ulLost;				/* Dropped because of ulLossPPM. */
+	uint32_t ulDuplicated;
+	uint32_t ulReordered;
+	uint32_t ulQueueDrops;			/* Dropped because of ulQueueLimitBytes, or because the delay line was full. */
+	uint32_t ulReceiveDrops;		/* The receiving side refused the frame, or had no network buffer. */
+} SimLinkStats_t;
+
+/* Called for a frame that arrives at a port to which no IP-stack is attached.
+The hook owns the network buffer and must release it. */
+typedef void ( * SimLinkReceiveHook_t )( BaseType_t xPort, NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+/*
+ * Set the parameters of the frames that are sent by 'xPort'.  The random
+ * generator is re-seeded.  Returns pdFAIL when the port number is not valid.
+ */
+BaseType_t xSimLinkSetParameters( BaseType_t xPort, const SimLinkParameters_t *pxParameters );
+
+/*
+ * Copy the counters of the frames that were sent by 'xPort', and clear them
+ * if 'xClear' is pdTRUE.
+ */
+BaseType_t xSimLinkGetStats( BaseType_t xPort, SimLinkStats_t *pxStats, BaseType_t xClear );
+
+/*
+ * Install the hook that receives the frames arriving at 'xPort' while no
+ * IP-stack is attached to it.  Without a hook those frames are dropped.
+ */
+void vSimLinkSetReceiveHook( BaseType_t xPort, SimLinkReceiveHook_t pxHook );
+
+/*
+ * Send a frame from 'xPort', as a packet generator.  The frame is copied.
+ * Returns pdPASS when it was accepted by the link, which may still lose it.
+ */
+BaseType_t xSimLinkInject( BaseType_t xPort, const uint8_t *pucFrame, size_t uxLength );
+
+/*
+ * The driver functions of port 1, to be passed to FreeRTOS_IPInitStack().
+ */
+BaseType_t xSimLinkPort1Initialise( void );
+BaseType_t xSimLinkPort1Output( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+
+#ifdef __cplusplus
+}	/* extern "C" */
+#endif
+
+#endif /* SIMULATED_LINK_H */
@@ -0,0 +1,668 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * tcp_capture.c
+ * Captures network packets in a pcapng file, which can be opened with
+ * Wireshark or tcpdump.  The network driver stores the packets in a lock-free
+ * ring, and a POSIX thread writes them to disk.
+ * See tools/tcp_capture.md for further description.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <signal.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_IP_Private.h"
+
+#if( ipconfigUSE_CAPTURE_PACKETS != 0 )
+
+#include "tcp_capture.h"
+
+#if( ( captureRING_SLOTS & ( captureRING_SLOTS - 1U ) ) != 0U )
+	#error captureRING_SLOTS must be a power of 2
+#endif
+
+/* The time that the writer thread sleeps when the ring is empty. */
+#define captureWRITER_SLEEP_NS			10000000L
+
+/* pcapng block types, see the pcapng specification (draft-tuexen-opsawg-pcapng). */
+#define captureBLOCK_SECTION_HEADER		0x0A0D0D0AUL
+#define captureBLOCK_INTERFACE			0x00000001UL
+#define captureBLOCK_ENHANCED_PACKET	0x00000006UL
+#define captureBYTE_ORDER_MAGIC			0x1A2B3C4DUL
+#define captureLINKTYPE_ETHERNET		1U
+
+/* The option 'epb_flags' tells the direction of a packet. */
+#define captureOPTION_EPB_FLAGS			2U
+#define captureEPB_INBOUND				0x00000001UL
+#define captureEPB_OUTBOUND				0x00000002UL
+
+/* The values of 'xDirection' in the filter. */
+#define captureDIRECTION_ANY			0
+#define captureDIRECTION_IN				1
+#define captureDIRECTION_OUT			2
+
+/* The ports of TCP and UDP are stored in the first 4 bytes of their header. */
+#define captureSIZE_OF_PORTS			4U
+
+/* The packets that will be stored, a value of zero matches anything. */
+typedef struct xCAPTURE_FILTER
+{
+	BaseType_t xDirection;		/* captureDIRECTION_IN or captureDIRECTION_OUT. */
+	uint16_t usFrameType;		/* Like ipARP_FRAME_TYPE, network order. */
+	uint8_t ucProtocol;			/* Like ipPROTOCOL_TCP. */
+	uint32_t ulHost;			/* An IPv4 address in network order. */
+	uint16_t usPort;			/* A port number in network order. */
+} CaptureFilter_t;
+
+/* The pcapng blocks, all fields are naturally aligned and written in host
+byte order. */
+typedef struct xSECTION_HEADER_BLOCK
+{
+	uint32_t ulBlockType;
+	uint32_t ulBlockLength;
+	uint32_t ulByteOrderMagic;
+	uint16_t usMajorVersion;
+	uint16_t usMinorVersion;
+	uint32_t ulSectionLength[ 2 ];
+	uint32_t ulBlockLengthCopy;
+} SectionHeaderBlock_t;
+
+typedef struct xINTERFACE_BLOCK
+{
+	uint32_t ulBlockType;
+	uint32_t ulBlockLength;
+	uint16_t usLinkType;
+	uint16_t usReserved;
+	uint32_t ulSnapLength;
+	uint32_t ulBlockLengthCopy;
+} InterfaceBlock_t;
+
+/* An enhanced packet block is written as this header, the packet data padded
+to a multiple of 4 bytes, and the trailer. */
+typedef struct xPACKET_BLOCK_HEADER
+{
+	uint32_t ulBlockType;
+	uint32_t ulBlockLength;
+	uint32_t ulInterfaceID;
+	uint32_t ulTimeHigh;
+	uint32_t ulTimeLow;
+	uint32_t ulCaptureLength;
+	uint32_t ulPacketLength;
+} PacketBlockHeader_t;
+
+typedef struct xPACKET_BLOCK_TRAILER
+{
+	uint16_t usOptionCode;
+	uint16_t usOptionLength;
+	uint32_t ulFlags;
+	uint32_t ulEndOfOptions;
+	uint32_t ulBlockLengthCopy;
+} PacketBlockTrailer_t;
+
+/* An entry of the ring.  The sequence number tells whether the slot is free
+for the producer at position 'uxSequence', or ready for the writer thread at
+position 'uxSequence - 1'. */
+typedef struct xCAPTURE_SLOT
+{
+	size_t uxSequence;
+	uint64_t ullTimeUs;
+	uint32_t ulCaptureLength;
+	uint32_t ulLength;
+	BaseType_t xIncoming;
+	uint8_t ucData[ captureMAX_SNAPLEN ];
+} CaptureSlot_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Translate a filter string into 'pxFilter'.
+ */
+static BaseType_t prvParseFilter( const char *pcFilter, CaptureFilter_t *pxFilter );
+
+/*
+ * Returns pdTRUE when the packet passes the filter.
+ */
+static BaseType_t prvFilterMatches( const uint8_t *pucBuffer, size_t uxLength, BaseType_t xIncoming );
+
+/*
+ * The POSIX thread that writes the packets to the file.
+ */
+static void *prvCaptureWriterThread( void *pvParameter );
+
+/*
+ * Write all packets that are ready.  Returns the number of packets written.
+ */
+static size_t prvWriteReadySlots( void );
+
+/*
+ * Write the section header and interface description blocks.
+ */
+static void prvWriteFileHeader( void );
+
+/*-----------------------------------------------------------*/
+
+/* The ring between the drivers and the writer thread.  Producers claim a
+position with a compare-and-swap on 'uxHead', only the writer thread uses
+'uxTail'. */
+static CaptureSlot_t xSlots[ captureRING_SLOTS ];
+static size_t uxHead;
+static size_t uxTail;
+static BaseType_t xRingInitialised = pdFALSE;
+
+/* Set while a capture is running, read by every call to vCapturePacket(). */
+static BaseType_t xCapturing = pdFALSE;
+
+/* The number of calls to vCapturePacket() that are running.  vCaptureStop()
+waits until they have finished their slots. */
+static size_t uxActiveProducers = 0U;
+
+/* Set by vCaptureStop() to let the writer thread finish. */
+static BaseType_t xWriterStop = pdFALSE;
+
+static CaptureFilter_t xFilter;
+static size_t uxSnapLength;
+static FILE *pxCaptureFile = NULL;
+static pthread_t xWriterThread;
+static CaptureStats_t xStats;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xCaptureStart( const char *pcFileName, const char *pcFilter, size_t uxSnapLen )
+{
+BaseType_t xReturn = pdFAIL;
+CaptureFilter_t xNewFilter;
+size_t uxIndex;
+
+	configASSERT( pcFileName != NULL );
+
+	if( __atomic_load_n( &xCapturing, __ATOMIC_ACQUIRE ) != pdFALSE )
+	{
+		FreeRTOS_printf( ( "xCaptureStart: a capture is running already\n" ) );
+	}
+	else if( prvParseFilter( pcFilter, &xNewFilter ) == pdFALSE )
+	{
+		FreeRTOS_printf( ( "xCaptureStart: invalid filter '%s'\n", pcFilter ) );
+	}
+	else
+	{
+		pxCaptureFile = fopen( pcFileName, "wb" );
+
+		if( pxCaptureFile == NULL )
+		{
+			FreeRTOS_printf( ( "xCaptureStart: can not create '%s'\n", pcFileName ) );
+		}
+		else
+		{
+			if( xRingInitialised == pdFALSE )
+			{
+				for( uxIndex = 0U; uxIndex < captureRING_SLOTS; uxIndex++ )
+				{
+					xSlots[ uxIndex ].uxSequence = uxIndex;
+				}
+
+				xRingInitialised = pdTRUE;
+			}
+
+			xFilter = xNewFilter;
+
+			if( ( uxSnapLen == 0U ) || ( uxSnapLen > captureMAX_SNAPLEN ) )
+			{
+				uxSnapLength = captureMAX_SNAPLEN;
+			}
+			else
+			{
+				uxSnapLength = uxSnapLen;
+			}
+
+			( void ) memset( &xStats, 0, sizeof( xStats ) );
+			prvWriteFileHeader();
+			xWriterStop = pdFALSE;
+
+			if( pthread_create( &xWriterThread, NULL, prvCaptureWriterThread, NULL ) != 0 )
+			{
+				FreeRTOS_printf( ( "xCaptureStart: can not create the writer thread\n" ) );
+				( void ) fclose( pxCaptureFile );
+				pxCaptureFile = NULL;
+			}
+			else
+			{
+				/* The filter and the snap length must be visible before the
+				drivers see this flag. */
+				__atomic_store_n( &xCapturing, pdTRUE, __ATOMIC_RELEASE );
+				xReturn = pdPASS;
+			}
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vCaptureStop( void )
+{
+	if( __atomic_load_n( &xCapturing, __ATOMIC_ACQUIRE ) != pdFALSE )
+	{
+		__atomic_store_n( &xCapturing, pdFALSE, __ATOMIC_SEQ_CST );
+
+		/* A producer that saw the flag set may still be filling a slot.
+		When it is a task, it needs some CPU time to finish. */
+		while( __atomic_load_n( &uxActiveProducers, __ATOMIC_SEQ_CST ) != 0U )
+		{
+			vTaskDelay( 1U );
+		}
+
+		/* The writer thread empties the ring before it exits. */
+		__atomic_store_n( &xWriterStop, pdTRUE, __ATOMIC_RELEASE );
+		( void ) pthread_join( xWriterThread, NULL );
+
+		( void ) fclose( pxCaptureFile );
+		pxCaptureFile = NULL;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vCaptureGetStats( CaptureStats_t *pxStats )
+{
+	pxStats->ulCaptured = __atomic_load_n( &xStats.ulCaptured, __ATOMIC_RELAXED );
+	pxStats->ulFiltered = __atomic_load_n( &xStats.ulFiltered, __ATOMIC_RELAXED );
+	pxStats->ulDropped = __atomic_load_n( &xStats.ulDropped, __ATOMIC_RELAXED );
+	pxStats->ulWritten = __atomic_load_n( &xStats.ulWritten, __ATOMIC_RELAXED );
+}
+/*-----------------------------------------------------------*/
+
+void vCapturePacket( const uint8_t *pucBuffer, size_t uxLength, BaseType_t xIncoming )
+{
+CaptureSlot_t *pxSlot = NULL;
+size_t uxPosition, uxSequence;
+BaseType_t xSearching = pdTRUE;
+struct timespec xNow;
+
+	/* Announce the producer before looking at the flag, see vCaptureStop(). */
+	( void ) __atomic_fetch_add( &uxActiveProducers, 1U, __ATOMIC_SEQ_CST );
+
+	if( __atomic_load_n( &xCapturing, __ATOMIC_SEQ_CST ) != pdFALSE )
+	{
+		if( prvFilterMatches( pucBuffer, uxLength, xIncoming ) == pdFALSE )
+		{
+			( void ) __atomic_fetch_add( &xStats.ulFiltered, 1U, __ATOMIC_RELAXED );
+		}
+		else
+		{
+			/* Claim a slot.  When the slot at the head is still in use by the
+			writer, the ring is full and the packet is dropped. */
+			uxPosition = __atomic_load_n( &uxHead, __ATOMIC_RELAXED );
+
+			while( xSearching != pdFALSE )
+			{
+				pxSlot = &( xSlots[ uxPosition & ( captureRING_SLOTS - 1U ) ] );
+				uxSequence = __atomic_load_n( &( pxSlot->uxSequence ), __ATOMIC_ACQUIRE );
+
+				if( uxSequence == uxPosition )
+				{
+					/* On failure, 'uxPosition' gets the new head. */
+					if( __atomic_compare_exchange_n( &uxHead, &uxPosition, uxPosition + 1U, pdFALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+					{
+						xSearching = pdFALSE;
+					}
+				}
+				else if( ( intptr_t ) ( uxSequence - uxPosition ) < 0 )
+				{
+					pxSlot = NULL;
+					xSearching = pdFALSE;
+				}
+				else
+				{
+					/* Another producer took this position. */
+					uxPosition = __atomic_load_n( &uxHead, __ATOMIC_RELAXED );
+				}
+			}
+
+			if( pxSlot == NULL )
+			{
+				( void ) __atomic_fetch_add( &xStats.ulDropped, 1U, __ATOMIC_RELAXED );
+			}
+			else
+			{
+				( void ) clock_gettime( CLOCK_REALTIME, &xNow );
+				pxSlot->ullTimeUs = ( ( uint64_t ) xNow.tv_sec * 1000000ULL ) + ( ( uint64_t ) xNow.tv_nsec / 1000ULL );
+				pxSlot->ulLength = ( uint32_t ) uxLength;
+				pxSlot->ulCaptureLength = ( uint32_t ) ( ( uxLength < uxSnapLength ) ? uxLength : uxSnapLength );
+				pxSlot->xIncoming = xIncoming;
+				( void ) memcpy( pxSlot->ucData, pucBuffer, pxSlot->ulCaptureLength );
+
+				/* Hand the slot to the writer thread. */
+				__atomic_store_n( &( pxSlot->uxSequence ), uxPosition + 1U, __ATOMIC_RELEASE );
+				( void ) __atomic_fetch_add( &xStats.ulCaptured, 1U, __ATOMIC_RELAXED );
+			}
+		}
+	}
+
+	( void ) __atomic_fetch_sub( &uxActiveProducers, 1U, __ATOMIC_SEQ_CST );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvParseFilter( const char *pcFilter, CaptureFilter_t *pxFilter )
+{
+BaseType_t xReturn = pdTRUE;
+char pcCopy[ 128 ];
+char *pcWord, *pcNext, *pcSave = NULL;
+unsigned long ulPort;
+
+	( void ) memset( pxFilter, 0, sizeof( *pxFilter ) );
+
+	if( pcFilter != NULL )
+	{
+		if( strlen( pcFilter ) >= sizeof( pcCopy ) )
+		{
+			xReturn = pdFALSE;
+		}
+		else
+		{
+			( void ) strcpy( pcCopy, pcFilter );
+			pcWord = strtok_r( pcCopy, " ", &pcSave );
+
+			while( ( pcWord != NULL ) && ( xReturn != pdFALSE ) )
+			{
+				if( strcmp( pcWord, "in" ) == 0 )
+				{
+					pxFilter->xDirection = captureDIRECTION_IN;
+				}
+				else if( strcmp( pcWord, "out" ) == 0 )
+				{
+					pxFilter->xDirection = captureDIRECTION_OUT;
+				}
+				else if( strcmp( pcWord, "arp" ) == 0 )
+				{
+					pxFilter->usFrameType = ipARP_FRAME_TYPE;
+				}
+				else if( strcmp( pcWord, "ip" ) == 0 )
+				{
+					pxFilter->usFrameType = ipIPv4_FRAME_TYPE;
+				}
+				else if( strcmp( pcWord, "icmp" ) == 0 )
+				{
+					pxFilter->usFrameType = ipIPv4_FRAME_TYPE;
+					pxFilter->ucProtocol = ( uint8_t ) ipPROTOCOL_ICMP;
+				}
+				else if( strcmp( pcWord, "udp" ) == 0 )
+				{
+					pxFilter->usFrameType = ipIPv4_FRAME_TYPE;
+					pxFilter->ucProtocol = ( uint8_t ) ipPROTOCOL_UDP;
+				}
+				else if( strcmp( pcWord, "tcp" ) == 0 )
+				{
+					pxFilter->usFrameType = ipIPv4_FRAME_TYPE;
+					pxFilter->ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+				}
+				else if( strcmp( pcWord, "host" ) == 0 )
+				{
+					pcNext = strtok_r( NULL, " ", &pcSave );
+					pxFilter->usFrameType = ipIPv4_FRAME_TYPE;
+					pxFilter->ulHost = ( pcNext != NULL ) ? FreeRTOS_inet_addr( pcNext ) : 0UL;
+
+					if( pxFilter->ulHost == 0UL )
+					{
+						xReturn = pdFALSE;
+					}
+				}
+				else if( strcmp( pcWord, "port" ) == 0 )
+				{
+					pcNext = strtok_r( NULL, " ", &pcSave );
+					ulPort = ( pcNext != NULL ) ? strtoul( pcNext, NULL, 10 ) : 0UL;
+					pxFilter->usFrameType = ipIPv4_FRAME_TYPE;
+					pxFilter->usPort = FreeRTOS_htons( ( uint16_t ) ulPort );
+
+					if( ( ulPort == 0UL ) || ( ulPort > 0xffffUL ) )
+					{
+						xReturn = pdFALSE;
+					}
+				}
+				else if( strcmp( pcWord, "and" ) != 0 )
+				{
+					xReturn = pdFALSE;
+				}
+				else
+				{
+					/* "and" is allowed for readability. */
+				}
+
+				pcWord = strtok_r( NULL, " ", &pcSave );
+			}
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFilterMatches( const uint8_t *pucBuffer, size_t uxLength, BaseType_t xIncoming )
+{
+BaseType_t xReturn = pdTRUE;
+const IPPacket_t *pxIPPacket = ( const IPPacket_t * ) pucBuffer;
+const uint8_t *pucPorts;
+size_t uxHeaderLength;
+uint16_t usSourcePort, usDestinationPort;
+
+	if( ( ( xFilter.xDirection == captureDIRECTION_IN ) && ( xIncoming == pdFALSE ) ) ||
+		( ( xFilter.xDirection == captureDIRECTION_OUT ) && ( xIncoming != pdFALSE ) ) )
+	{
+		xReturn = pdFALSE;
+	}
+	else if( xFilter.usFrameType == 0U )
+	{
+		/* All frame types pass. */
+	}
+	else if( ( uxLength < sizeof( EthernetHeader_t ) ) || ( pxIPPacket->xEthernetHeader.usFrameType != xFilter.usFrameType ) )
+	{
+		xReturn = pdFALSE;
+	}
+	else if( ( xFilter.ucProtocol == 0U ) && ( xFilter.ulHost == 0UL ) && ( xFilter.usPort == 0U ) )
+	{
+		/* Only the frame type was requested. */
+	}
+	else if( uxLength < sizeof( IPPacket_t ) )
+	{
+		xReturn = pdFALSE;
+	}
+	else
+	{
+		if( ( xFilter.ucProtocol != 0U ) && ( pxIPPacket->xIPHeader.ucProtocol != xFilter.ucProtocol ) )
+		{
+			xReturn = pdFALSE;
+		}
+
+		if( ( xFilter.ulHost != 0UL ) &&
+			( pxIPPacket->xIPHeader.ulSourceIPAddress != xFilter.ulHost ) &&
+			( pxIPPacket->xIPHeader.ulDestinationIPAddress != xFilter.ulHost ) )
+		{
+			xReturn = pdFALSE;
+		}
+
+		if( ( xReturn != pdFALSE ) && ( xFilter.usPort != 0U ) )
+		{
+			uxHeaderLength = ( size_t ) ( ( pxIPPacket->xIPHeader.ucVersionHeaderLength & 0x0FU ) << 2 );
+
+			if( ( ( pxIPPacket->xIPHeader.ucProtocol != ( uint8_t ) ipPROTOCOL_TCP ) &&
+				  ( pxIPPacket->xIPHeader.ucProtocol != ( uint8_t ) ipPROTOCOL_UDP ) ) ||
+				( uxLength < ( ipSIZE_OF_ETH_HEADER + uxHeaderLength + captureSIZE_OF_PORTS ) ) )
+			{
+				xReturn = pdFALSE;
+			}
+			else
+			{
+				/* The ports are copied because the header may not be aligned. */
+				pucPorts = &( pucBuffer[ ipSIZE_OF_ETH_HEADER + uxHeaderLength ] );
+				( void ) memcpy( &usSourcePort, &( pucPorts[ 0 ] ), sizeof( usSourcePort ) );
+				( void ) memcpy( &usDestinationPort, &( pucPorts[ 2 ] ), sizeof( usDestinationPort ) );
+
+				if( ( usSourcePort != xFilter.usPort ) && ( usDestinationPort != xFilter.usPort ) )
+				{
+					xReturn = pdFALSE;
+				}
+			}
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteFileHeader( void )
+{
+SectionHeaderBlock_t xSection;
+InterfaceBlock_t xInterface;
+
+	xSection.ulBlockType = captureBLOCK_SECTION_HEADER;
+	xSection.ulBlockLength = ( uint32_t ) sizeof( xSection );
+	xSection.ulByteOrderMagic = captureBYTE_ORDER_MAGIC;
+	xSection.usMajorVersion = 1U;
+	xSection.usMinorVersion = 0U;
+	xSection.ulSectionLength[ 0 ] = 0xffffffffUL;	/* The length is not known. */
+	xSection.ulSectionLength[ 1 ] = 0xffffffffUL;
+	xSection.ulBlockLengthCopy = xSection.ulBlockLength;
+
+	xInterface.ulBlockType = captureBLOCK_INTERFACE;
+	xInterface.ulBlockLength = ( uint32_t ) sizeof( xInterface );
+	xInterface.usLinkType = captureLINKTYPE_ETHERNET;
+	xInterface.usReserved = 0U;
+	xInterface.ulSnapLength = ( uint32_t ) uxSnapLength;
+	xInterface.ulBlockLengthCopy = xInterface.ulBlockLength;
+
+	( void ) fwrite( &xSection, 1U, sizeof( xSection ), pxCaptureFile );
+	( void ) fwrite( &xInterface, 1U, sizeof( xInterface ), pxCaptureFile );
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvWriteReadySlots( void )
+{
+size_t uxCount = 0U;
+CaptureSlot_t *pxSlot;
+PacketBlockHeader_t xHeader;
+PacketBlockTrailer_t xTrailer;
+const uint32_t ulPadding = 0UL;
+size_t uxPadding;
+BaseType_t xReady = pdTRUE;
+
+	while( xReady != pdFALSE )
+	{
+		pxSlot = &( xSlots[ uxTail & ( captureRING_SLOTS - 1U ) ] );
+
+		if( __atomic_load_n( &( pxSlot->uxSequence ), __ATOMIC_ACQUIRE ) != ( uxTail + 1U ) )
+		{
+			/* The producer has not finished this slot yet. */
+			xReady = pdFALSE;
+		}
+		else
+		{
+			uxPadding = ( 4U - ( pxSlot->ulCaptureLength & 3U ) ) & 3U;
+
+			xHeader.ulBlockType = captureBLOCK_ENHANCED_PACKET;
+			xHeader.ulBlockLength = ( uint32_t ) ( sizeof( xHeader ) + pxSlot->ulCaptureLength + uxPadding + sizeof( xTrailer ) );
+			xHeader.ulInterfaceID = 0UL;
+			xHeader.ulTimeHigh = ( uint32_t ) ( pxSlot->ullTimeUs >> 32 );
+			xHeader.ulTimeLow = ( uint32_t ) pxSlot->ullTimeUs;
+			xHeader.ulCaptureLength = pxSlot->ulCaptureLength;
+			xHeader.ulPacketLength = pxSlot->ulLength;
+
+			xTrailer.usOptionCode = captureOPTION_EPB_FLAGS;
+			xTrailer.usOptionLength = ( uint16_t ) sizeof( xTrailer.ulFlags );
+			xTrailer.ulFlags = ( pxSlot->xIncoming != pdFALSE ) ? captureEPB_INBOUND : captureEPB_OUTBOUND;
+			xTrailer.ulEndOfOptions = 0UL;
+			xTrailer.ulBlockLengthCopy = xHeader.ulBlockLength;
+
+			( void ) fwrite( &xHeader, 1U, sizeof( xHeader ), pxCaptureFile );
+			( void ) fwrite( pxSlot->ucData, 1U, pxSlot->ulCaptureLength, pxCaptureFile );
+			( void ) fwrite( &ulPadding, 1U, uxPadding, pxCaptureFile );
+			( void ) fwrite( &xTrailer, 1U, sizeof( xTrailer ), pxCaptureFile );
+
+			/* The slot can be used again, one round later. */
+			__atomic_store_n( &( pxSlot->uxSequence ), uxTail + captureRING_SLOTS, __ATOMIC_RELEASE );
+			uxTail++;
+			uxCount++;
+		}
+	}
+
+	if( uxCount != 0U )
+	{
+		( void ) __atomic_fetch_add( &xStats.ulWritten, ( uint32_t ) uxCount, __ATOMIC_RELAXED );
+	}
+
+	return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvCaptureWriterThread( void *pvParameter )
+{
+sigset_t xSignals;
+const struct timespec xSleep = { 0, captureWRITER_SLEEP_NS };
+BaseType_t xRunning = pdTRUE;
+BaseType_t xStopping;
+
+	( void ) pvParameter;
+
+	/* This is not a FreeRTOS task: block the signals that the POSIX port
+	uses to suspend its threads, like the threads of the Linux driver. */
+	( void ) sigfillset( &xSignals );
+	( void ) pthread_sigmask( SIG_SETMASK, &xSignals, NULL );
+
+	while( xRunning != pdFALSE )
+	{
+		/* Read the flag before the ring.  All slots were filled before the
+		flag was set, so the ring is empty when nothing is written. */
+		xStopping = __atomic_load_n( &xWriterStop, __ATOMIC_ACQUIRE );
+
+		if( prvWriteReadySlots() == 0U )
+		{
+			if( xStopping != pdFALSE )
+			{
+				xRunning = pdFALSE;
+			}
+			else
+			{
+				( void ) fflush( pxCaptureFile );
+				( void ) nanosleep( &xSleep, NULL );
+			}
+		}
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+#endif	/* ( ipconfigUSE_CAPTURE_PACKETS != 0 ) */
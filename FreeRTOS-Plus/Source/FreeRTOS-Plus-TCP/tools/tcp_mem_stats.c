@@ -51,8 +51,24 @@
 	#pragma warning "ipconfigTCP_MEM_STATS_MAX_ALLOCATION undefined?"
 #endif
 
+/* The number of lists in the hash table of allocations, must be a power of 2. */
+#ifndef ipconfigTCP_MEM_STATS_HASH_SIZE
+	#define ipconfigTCP_MEM_STATS_HASH_SIZE     64u
+#endif
+
+/* When non-zero, CSV records are written for every creation and deletion.
+When zero, the counters, the snapshot and the summary are still available,
+which makes the module cheap enough to be used in a production build. */
+#ifndef ipconfigTCP_MEM_STATS_LOG_CSV
+	#define ipconfigTCP_MEM_STATS_LOG_CSV     0
+#endif
+
 #if( ipconfigUSE_TCP_MEM_STATS != 0 )
 
+#if( ( ipconfigTCP_MEM_STATS_HASH_SIZE & ( ipconfigTCP_MEM_STATS_HASH_SIZE - 1u ) ) != 0u )
+	#error ipconfigTCP_MEM_STATS_HASH_SIZE must be a power of 2
+#endif
+
 /* When a streambuffer is allocated, 4 extra bytes will be reserved. */
 
 #define STREAM_BUFFER_ROUNDUP_BYTES		4
@@ -62,6 +78,9 @@
 	configPRINTF( MSG )
 
 #define ETH_MAX_PACKET_SIZE		( ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER + ipBUFFER_PADDING + 31 ) & ~0x1FuL )
+
+/* Marks the end of a hash list or of the free list. */
+#define tcpNO_ALLOCATION		( ( size_t ) ipconfigTCP_MEM_STATS_MAX_ALLOCATION )
 /*-----------------------------------------------------------*/
 
 /* Objects are allocated and deleted. This structure stores the type
@@ -72,88 +91,209 @@ typedef struct xTCP_ALLOCATION
 	void *pxObject;
 	UBaseType_t uxNumber;
 	size_t uxSize;
+	size_t uxNext;		/* Next entry in the same hash list, or in the free list. */
 } TCP_ALLOCATION_t;
 /*-----------------------------------------------------------*/
 
 
-static void vWriteHeader( void );
+#if( ipconfigTCP_MEM_STATS_LOG_CSV != 0 )
+	static void vWriteHeader( void );
+#endif
 
 static size_t uxCurrentMallocSize;
 static TCP_ALLOCATION_t xAllocations[ ipconfigTCP_MEM_STATS_MAX_ALLOCATION ];
-static size_t uxAllocationCount;
-static BaseType_t xFirstItem = pdTRUE;
+static size_t uxHashLists[ ipconfigTCP_MEM_STATS_HASH_SIZE ];
+static size_t uxFreeAllocation;
+static BaseType_t xAllocationsInitialised = pdFALSE;
+static TCPMemorySnapshot_t xCounters;
 UBaseType_t uxNextObjectNumber;
-static BaseType_t xCurrentLine = 0;
-static BaseType_t xFirstDumpLine = 0;
-static BaseType_t xLastHeaderLineNr = 0;
-static BaseType_t xLoggingStopped = 0;
+#if( ipconfigTCP_MEM_STATS_LOG_CSV != 0 )
+	static BaseType_t xFirstItem = pdTRUE;
+	static BaseType_t xCurrentLine = 0;
+	static BaseType_t xFirstDumpLine = 0;
+	static BaseType_t xLastHeaderLineNr = 0;
+	static BaseType_t xLoggingStopped = 0;
+#endif
 /*-----------------------------------------------------------*/
 
-static void vAddAllocation( TCP_MEMORY_t xMemType, void *pxObject, size_t uxSize )
+static size_t uxHashIndex( const void *pxObject )
+{
+uint32_t ulHash = ( uint32_t ) ( ( uintptr_t ) pxObject >> 3 );
+
+	/* Heap pointers are aligned and often close together: mix all bits
+	before taking the lowest ones. */
+	ulHash *= 0x9E3779B1uL;
+	ulHash ^= ulHash >> 16;
+
+	return ( size_t ) ( ulHash & ( ipconfigTCP_MEM_STATS_HASH_SIZE - 1u ) );
+}
+/*-----------------------------------------------------------*/
+
+static size_t uxHistogramIndex( size_t uxSize )
+{
+size_t uxIndex = 0u;
+size_t uxLimit = tcpMEM_STATS_HISTOGRAM_MIN;
+
+	while( ( uxSize > uxLimit ) && ( uxIndex < ( tcpMEM_STATS_HISTOGRAM_SIZE - 1u ) ) )
+	{
+		uxLimit <<= 1;
+		uxIndex++;
+	}
+
+	return uxIndex;
+}
+/*-----------------------------------------------------------*/
+
+static void vInitialiseAllocations( void )
 {
 size_t uxIndex;
 
+	/* Called with the scheduler suspended. */
+	for( uxIndex = 0; uxIndex < ipconfigTCP_MEM_STATS_HASH_SIZE; uxIndex++ )
+	{
+		uxHashLists[ uxIndex ] = tcpNO_ALLOCATION;
+	}
+	for( uxIndex = 0; uxIndex < ipconfigTCP_MEM_STATS_MAX_ALLOCATION; uxIndex++ )
+	{
+		xAllocations[ uxIndex ].uxNext = uxIndex + 1u;
+	}
+	uxFreeAllocation = 0u;
+	xAllocationsInitialised = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t xAddAllocation( TCP_MEMORY_t xMemType, void *pxObject, size_t uxSize )
+{
+size_t uxHash = uxHashIndex( pxObject );
+size_t uxIndex;
+BaseType_t xReturn = pdFAIL;
+TCPMemoryTypeStats_t *pxType;
+
 	vTaskSuspendAll();
 	{
-		for( uxIndex = 0; uxIndex < uxAllocationCount; uxIndex++ )
+		if( xAllocationsInitialised == pdFALSE )
+		{
+			vInitialiseAllocations();
+		}
+
+		for( uxIndex = uxHashLists[ uxHash ]; uxIndex != tcpNO_ALLOCATION; uxIndex = xAllocations[ uxIndex ].uxNext )
 		{
 			if( xAllocations[ uxIndex ].pxObject == pxObject )
 			{
-				/* Already added, strange. */
-				FreeRTOS_printf( ( "vAddAllocation: Pointer %p already added\n", pxObject ) );
-				return;
+				break;
 			}
 		}
-		if( uxAllocationCount >= ipconfigTCP_MEM_STATS_MAX_ALLOCATION )
+
+		if( uxIndex != tcpNO_ALLOCATION )
+		{
+			/* Already added, strange. */
+			FreeRTOS_printf( ( "vAddAllocation: Pointer %p already added\n", pxObject ) );
+		}
+		else if( uxFreeAllocation == tcpNO_ALLOCATION )
 		{
 			/* The table is full. */
-			return;
+			xCounters.ulUntracked++;
+		}
+		else
+		{
+			uxIndex = uxFreeAllocation;
+			uxFreeAllocation = xAllocations[ uxIndex ].uxNext;
+
+			xAllocations[ uxIndex ].pxObject = pxObject;
+			xAllocations[ uxIndex ].xMemType = xMemType;
+			xAllocations[ uxIndex ].uxSize = uxSize;
+			xAllocations[ uxIndex ].uxNumber = uxNextObjectNumber++;
+			xAllocations[ uxIndex ].uxNext = uxHashLists[ uxHash ];
+			uxHashLists[ uxHash ] = uxIndex;
+
+			pxType = &( xCounters.xTypes[ xMemType ] );
+			pxType->ulCreated++;
+			pxType->uxLiveCount++;
+			pxType->uxLiveBytes += uxSize;
+			if( pxType->uxPeakCount < pxType->uxLiveCount )
+			{
+				pxType->uxPeakCount = pxType->uxLiveCount;
+			}
+			if( pxType->uxPeakBytes < pxType->uxLiveBytes )
+			{
+				pxType->uxPeakBytes = pxType->uxLiveBytes;
+			}
+
+			xCounters.uxLiveBytes += uxSize;
+			if( xCounters.uxPeakBytes < xCounters.uxLiveBytes )
+			{
+				xCounters.uxPeakBytes = xCounters.uxLiveBytes;
+			}
+			xCounters.ulHistogram[ uxHistogramIndex( uxSize ) ]++;
+			uxCurrentMallocSize = xCounters.uxLiveBytes;
+
+			xReturn = pdPASS;
 		}
-		xAllocations[ uxIndex ].pxObject = pxObject;
-		xAllocations[ uxIndex ].xMemType = xMemType;
-		xAllocations[ uxIndex ].uxSize = uxSize;
-		xAllocations[ uxIndex ].uxNumber = uxNextObjectNumber++;
-		uxAllocationCount++;
 	}
-	xTaskResumeAll();
+	( void ) xTaskResumeAll();
+
+	return xReturn;
 }
 /*-----------------------------------------------------------*/
 
-static TCP_ALLOCATION_t *pxRemoveAllocation( void *pxObject )
+static BaseType_t xRemoveAllocation( void *pxObject, TCP_ALLOCATION_t *pxAllocation )
 {
-size_t uxSource = 0, uxTarget = 0;
-static TCP_ALLOCATION_t xAllocation = { 0 };
-BaseType_t xFound = pdFALSE;
-TCP_ALLOCATION_t *pxReturn;
+size_t uxHash = uxHashIndex( pxObject );
+size_t uxIndex, uxPrevious = tcpNO_ALLOCATION;
+BaseType_t xReturn = pdFAIL;
+TCPMemoryTypeStats_t *pxType;
 
 	vTaskSuspendAll();
 	{
-		for( ; uxSource < uxAllocationCount; uxSource++ )
+		if( xAllocationsInitialised == pdFALSE )
 		{
-			if( xAllocations[ uxSource ].pxObject == pxObject )
-			{
-				/* This is entry will be removed. */
-				( void ) memcpy( &( xAllocation ), &( xAllocations[ uxSource ] ), sizeof xAllocation );
-				xFound = pdTRUE;
-			}
-			else
+			vInitialiseAllocations();
+		}
+
+		for( uxIndex = uxHashLists[ uxHash ]; uxIndex != tcpNO_ALLOCATION; uxIndex = xAllocations[ uxIndex ].uxNext )
+		{
+			if( xAllocations[ uxIndex ].pxObject == pxObject )
 			{
-				xAllocations[ uxTarget ] = xAllocations[ uxSource ];
-				uxTarget++;
+				break;
 			}
+			uxPrevious = uxIndex;
 		}
-		if( xFound != pdFALSE )
+
+		if( uxIndex == tcpNO_ALLOCATION )
 		{
-			uxAllocationCount--;
-			pxReturn = &( xAllocation );
+			xCounters.ulUnknown++;
 		}
 		else
 		{
-			pxReturn = NULL;
+			/* This is entry will be removed. */
+			*pxAllocation = xAllocations[ uxIndex ];
+
+			if( uxPrevious == tcpNO_ALLOCATION )
+			{
+				uxHashLists[ uxHash ] = xAllocations[ uxIndex ].uxNext;
+			}
+			else
+			{
+				xAllocations[ uxPrevious ].uxNext = xAllocations[ uxIndex ].uxNext;
+			}
+			xAllocations[ uxIndex ].pxObject = NULL;
+			xAllocations[ uxIndex ].uxNext = uxFreeAllocation;
+			uxFreeAllocation = uxIndex;
+
+			pxType = &( xCounters.xTypes[ pxAllocation->xMemType ] );
+			pxType->ulDeleted++;
+			pxType->uxLiveCount--;
+			pxType->uxLiveBytes -= pxAllocation->uxSize;
+			xCounters.uxLiveBytes -= pxAllocation->uxSize;
+			xCounters.ulHistogram[ uxHistogramIndex( pxAllocation->uxSize ) ]--;
+			uxCurrentMallocSize = xCounters.uxLiveBytes;
+
+			xReturn = pdPASS;
 		}
 	}
-	xTaskResumeAll();
-	return pxReturn;
+	( void ) xTaskResumeAll();
+
+	return xReturn;
 }
 /*-----------------------------------------------------------*/
 
@@ -168,11 +308,15 @@ static const char *pcTypeName( TCP_MEMORY_t xMemType )
 	case tcpRX_STREAM_BUFFER:   return "RX-Buffer";
 	case tcpTX_STREAM_BUFFER:   return "TX-Buffer";
 	case tcpNETWORK_BUFFER:     return "networkBuffer";
+	case tcpTCP_WIN_SEGMENTS:   return "WinSegments";
+	case tcpMEMORY_TYPE_COUNT:	break;
 	}
 	return "Unknown object";
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigTCP_MEM_STATS_LOG_CSV != 0 )
+
 static void vWriteHeader()
 {
 size_t uxPacketSize;
@@ -322,8 +466,13 @@ size_t uxTara = sizeof( *pxBuffer ) - sizeof( pxBuffer->ucArray );
 }
 /*-----------------------------------------------------------*/
 
+#endif /* ipconfigTCP_MEM_STATS_LOG_CSV */
+
 void vTCPMemStatCreate( TCP_MEMORY_t xMemType, void *pxObject, size_t uxSize )
 {
+BaseType_t xAdded = xAddAllocation( xMemType, pxObject, uxSize );
+
+	#if( ipconfigTCP_MEM_STATS_LOG_CSV != 0 )
 	if( xLoggingStopped == pdFALSE )
 	{
 	StreamBuffer_t *pxBuffer = NULL;
@@ -341,6 +490,10 @@ void vTCPMemStatCreate( TCP_MEMORY_t xMemType, void *pxObject, size_t uxSize )
 
 			snprintf( pcExtra, sizeof pcExtra, ",%u nett", uxNett );
 		}
+		if( xAdded == pdFAIL )
+		{
+			snprintf( pcExtra, sizeof pcExtra, ",not followed" );
+		}
 
 		if( xFirstDumpLine == 0 )
 		{
@@ -351,28 +504,33 @@ void vTCPMemStatCreate( TCP_MEMORY_t xMemType, void *pxObject, size_t uxSize )
 		configPRINTF( ( "TCPMemStat,CREATE,%s,%lu,%lu,%u,%u,%u%s\n",
 			pcTypeName( xMemType ),
 			uxSize,
-			uxCurrentMallocSize + uxSize,
-			uxNextObjectNumber,
+			uxCurrentMallocSize,
+			uxNextObjectNumber - 1u,
 			xPortGetMinimumEverFreeHeapSize(),
 			xPortGetFreeHeapSize(),
 			pcExtra ) );
-		uxCurrentMallocSize += uxSize;
-		vAddAllocation( xMemType, pxObject, uxSize );
 	}
+	#else
+	{
+		( void ) xAdded;
+	}
+	#endif /* ipconfigTCP_MEM_STATS_LOG_CSV */
 }
 /*-----------------------------------------------------------*/
 
 void vTCPMemStatDelete( void *pxObject )
 {
+TCP_ALLOCATION_t xFound;
+BaseType_t xRemoved = xRemoveAllocation( pxObject, &( xFound ) );
+
+	#if( ipconfigTCP_MEM_STATS_LOG_CSV != 0 )
 	if( xLoggingStopped == pdFALSE )
 	{
-	TCP_ALLOCATION_t *pxFound = pxRemoveAllocation( pxObject );
-
 		if( xFirstDumpLine == 0 )
 		{
 			xFirstDumpLine = xCurrentLine + 1;
 		}
-		if( pxFound == NULL )
+		if( xRemoved == pdFAIL )
 		{
 			FreeRTOS_printf( ( "TCPMemStat: can not find pointer %p\n", pxObject ) );
 		}
@@ -380,27 +538,25 @@ void vTCPMemStatDelete( void *pxObject )
 		{
 			xCurrentLine++;
 			configPRINTF( ( "TCPMemStat,REMOVE,%s,-%lu,%lu,%x,%u,%u\n",
-				pcTypeName( pxFound->xMemType ),
-				pxFound->uxSize,
-				uxCurrentMallocSize - pxFound->uxSize,
-				pxFound->uxNumber,
+				pcTypeName( xFound.xMemType ),
+				xFound.uxSize,
+				uxCurrentMallocSize,
+				xFound.uxNumber,
 				xPortGetMinimumEverFreeHeapSize(),
 				xPortGetFreeHeapSize() ) );
-			if( uxCurrentMallocSize < pxFound->uxSize )
-			{
-				uxCurrentMallocSize = 0uL;
-			}
-			else
-			{
-				uxCurrentMallocSize -= pxFound->uxSize;
-			}
 		}
 	}
+	#else
+	{
+		( void ) xRemoved;
+	}
+	#endif /* ipconfigTCP_MEM_STATS_LOG_CSV */
 }
 /*-----------------------------------------------------------*/
 
 void vTCPMemStatClose()
 {
+	#if( ipconfigTCP_MEM_STATS_LOG_CSV != 0 )
 	if( xLoggingStopped == pdFALSE )
 	{
 	// name;object;size;Heap;Ppointer;HeapMin;HeapDur;Comment
@@ -419,6 +575,64 @@ void vTCPMemStatClose()
 			xLastHeaderLineNr + 1,
 			xLastLineNr + 1 ) );
 	}
+	#endif /* ipconfigTCP_MEM_STATS_LOG_CSV */
+
+	/* The counters are still updated after closing. */
+	vTCPMemStatPrintSummary();
+}
+/*-----------------------------------------------------------*/
+
+void vTCPMemStatGetSnapshot( TCPMemorySnapshot_t *pxSnapshot )
+{
+	vTaskSuspendAll();
+	{
+		*pxSnapshot = xCounters;
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void vTCPMemStatPrintSummary( void )
+{
+static TCPMemorySnapshot_t xSnapshot;
+size_t uxIndex;
+size_t uxLimit = tcpMEM_STATS_HISTOGRAM_MIN;
+
+	/* 'xSnapshot' is static because it is too big for the stack of most
+	tasks.  The summary should not be printed by two tasks at the same time. */
+	vTCPMemStatGetSnapshot( &( xSnapshot ) );
+
+	configPRINTF( ( "TCPMemSummary,Object,Live,Peak,Live bytes,Peak bytes,Created,Deleted\n" ) );
+	for( uxIndex = 0; uxIndex < ( size_t ) tcpMEMORY_TYPE_COUNT; uxIndex++ )
+	{
+		configPRINTF( ( "TCPMemSummary,%s,%lu,%lu,%lu,%lu,%lu,%lu\n",
+			pcTypeName( ( TCP_MEMORY_t ) uxIndex ),
+			( unsigned long ) xSnapshot.xTypes[ uxIndex ].uxLiveCount,
+			( unsigned long ) xSnapshot.xTypes[ uxIndex ].uxPeakCount,
+			( unsigned long ) xSnapshot.xTypes[ uxIndex ].uxLiveBytes,
+			( unsigned long ) xSnapshot.xTypes[ uxIndex ].uxPeakBytes,
+			( unsigned long ) xSnapshot.xTypes[ uxIndex ].ulCreated,
+			( unsigned long ) xSnapshot.xTypes[ uxIndex ].ulDeleted ) );
+	}
+	configPRINTF( ( "TCPMemSummary,Total,,,%lu,%lu,Not followed %lu,Unknown %lu\n",
+		( unsigned long ) xSnapshot.uxLiveBytes,
+		( unsigned long ) xSnapshot.uxPeakBytes,
+		( unsigned long ) xSnapshot.ulUntracked,
+		( unsigned long ) xSnapshot.ulUnknown ) );
+
+	configPRINTF( ( "TCPMemSummary,Size up to,Live objects\n" ) );
+	for( uxIndex = 0; uxIndex < tcpMEM_STATS_HISTOGRAM_SIZE; uxIndex++ )
+	{
+		if( uxIndex < ( tcpMEM_STATS_HISTOGRAM_SIZE - 1u ) )
+		{
+			configPRINTF( ( "TCPMemSummary,%lu,%lu\n", ( unsigned long ) uxLimit, ( unsigned long ) xSnapshot.ulHistogram[ uxIndex ] ) );
+			uxLimit <<= 1;
+		}
+		else
+		{
+			configPRINTF( ( "TCPMemSummary,Larger,%lu\n", ( unsigned long ) xSnapshot.ulHistogram[ uxIndex ] ) );
+		}
+	}
 }
 /*-----------------------------------------------------------*/
 
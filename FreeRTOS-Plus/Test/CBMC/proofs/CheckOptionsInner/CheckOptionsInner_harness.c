@@ -17,6 +17,7 @@
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
 #include "FreeRTOS_ARP.h"
+#include "FreeRTOS_IP_Stack.h"
 
 #include "cbmc.h"
 
@@ -67,8 +68,7 @@ void harness()
 
     vListInitialise( &pxSocket->u.xTCP.xTCPWindow.xPriorityQueue );
 
-    extern List_t xSegmentList;
-    vListInitialise( &xSegmentList );
+    vListInitialise( &pxIPStack->xSegmentList );
 
     /****************************************************************
      * Specification and proof of CheckOptions inner loop
@@ -41,10 +41,9 @@
 #include "FreeRTOS_UDP_IP.h"
 #include "FreeRTOS_DHCP.h"
 #include "FreeRTOS_ARP.h"
+#include "FreeRTOS_IP_Stack.h"
 
-/* Static members defined in FreeRTOS_DHCP.c */
-extern DHCPData_t xDHCPData;
-extern Socket_t xDHCPSocket;
+/* Static member defined in FreeRTOS_DHCP.c */
 void prvCreateDHCPSocket();
 
 /* Static member defined in freertos_api.c */
@@ -91,11 +90,11 @@ void harness()
      * xReset==True resets the state to eWaitingSendFirstDiscover.
      ****************************************************************/
 
-    if( !( ( xDHCPData.eDHCPState == eWaitingSendFirstDiscover ) ||
+    if( !( ( pxIPStack->xDHCPData.eDHCPState == eWaitingSendFirstDiscover ) ||
            ( xReset != pdFALSE ) ) )
     {
         prvCreateDHCPSocket();
-        __CPROVER_assume( xDHCPSocket != NULL );
+        __CPROVER_assume( pxIPStack->xDHCPSocket != NULL );
     }
 
     vDHCPProcess( xReset );
@@ -10,6 +10,7 @@
 #include "FreeRTOS_IP.h"
 #include "FreeRTOS_IP_Private.h"
 #include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_IP_Stack.h"
 
 #include "memory_assignments.c"
 
@@ -59,7 +60,7 @@ void harness()
 	BaseType_t xInternal;
 
 	/* Call to init the socket list. */
-	vNetworkSocketsInit();
+	vNetworkSocketsInit( pxIPStack );
 
 	vSocketBind( pxSocket, pxBindAddress, uxAddressLength, xInternal );
 }
@@ -0,0 +1,155 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/*-----------------------------------------------------------
+ * Application specific definitions.
+ *
+ * The Posix build of the integration tests.  The tests run on two IP-stacks
+ * in one process, that are connected by the simulated link of
+ * portable/NetworkInterface/simulated_link.  Stack 0 runs the test runner,
+ * stack 1 runs the servers of the performance tests.
+ *
+ * THESE PARAMETERS ARE DESCRIBED WITHIN THE 'CONFIGURATION' SECTION OF THE
+ * FreeRTOS API DOCUMENTATION AVAILABLE ON THE FreeRTOS.org WEB SITE.  See
+ * http://www.freertos.org/a00110.html
+ *----------------------------------------------------------*/
+
+#define configUSE_PREEMPTION					1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION	0
+#define configMAX_PRIORITIES					( 7 )
+#define configTICK_RATE_HZ						( 1000 )
+#define configMINIMAL_STACK_SIZE				( ( unsigned short ) 70 ) /* The real stack is that of the pthread. */
+#define configTOTAL_HEAP_SIZE					( ( size_t ) ( 2048U * 1024U ) ) /* Not used by heap_3.c. */
+#define configMAX_TASK_NAME_LEN					( 15 )
+#define configUSE_TRACE_FACILITY				0
+#define configUSE_16_BIT_TICKS					0
+#define configIDLE_SHOULD_YIELD					1
+#define configUSE_MUTEXES						1
+#define configUSE_RECURSIVE_MUTEXES				1
+#define configQUEUE_REGISTRY_SIZE				0
+#define configUSE_APPLICATION_TASK_TAG			0
+#define configUSE_COUNTING_SEMAPHORES			1
+#define configUSE_ALTERNATIVE_API				0
+#define configUSE_QUEUE_SETS					0
+#define configUSE_TASK_NOTIFICATIONS			1
+#define configSUPPORT_DYNAMIC_ALLOCATION		1
+#define configSUPPORT_STATIC_ALLOCATION			0
+#define configSTACK_DEPTH_TYPE					uint32_t
+
+/* Every task remembers the IP-stack that it uses, see FreeRTOS_SetIPStack(). */
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS	1
+
+/* Hook function related definitions. */
+#define configUSE_TICK_HOOK				0
+#define configUSE_IDLE_HOOK				1
+#define configUSE_MALLOC_FAILED_HOOK	1
+#define configCHECK_FOR_STACK_OVERFLOW	0 /* Not applicable to the Posix port. */
+
+/* Software timer related definitions. */
+#define configUSE_TIMERS				1
+#define configTIMER_TASK_PRIORITY		( configMAX_PRIORITIES - 1 )
+#define configTIMER_QUEUE_LENGTH		5
+#define configTIMER_TASK_STACK_DEPTH	( configMINIMAL_STACK_SIZE * 2 )
+
+/* Event group related definitions. */
+#define configUSE_EVENT_GROUPS			1
+
+/* Run time stats gathering definitions. */
+#define configGENERATE_RUN_TIME_STATS	0
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES 			0
+#define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
+
+/* Set the following definitions to 1 to include the API function, or zero
+ * to exclude the API function. */
+#define INCLUDE_vTaskPrioritySet				1
+#define INCLUDE_uxTaskPriorityGet				1
+#define INCLUDE_vTaskDelete						1
+#define INCLUDE_vTaskCleanUpResources			0
+#define INCLUDE_vTaskSuspend					1
+#define INCLUDE_vTaskDelayUntil					1
+#define INCLUDE_vTaskDelay						1
+#define INCLUDE_uxTaskGetStackHighWaterMark		1
+#define INCLUDE_xTaskGetSchedulerState			1
+#define INCLUDE_xTimerGetTimerTaskHandle		0
+#define INCLUDE_xTaskGetIdleTaskHandle			0
+#define INCLUDE_xQueueGetMutexHolder			1
+#define INCLUDE_eTaskGetState					1
+#define INCLUDE_xEventGroupSetBitsFromISR		1
+#define INCLUDE_xTimerPendFunctionCall			1
+#define INCLUDE_xTaskGetCurrentTaskHandle		1
+
+/* An assertion that fails stops the process with the file and line, so that
+ * a script that runs the tests sees the failure. */
+extern void vAssertCalled( const char * const pcFileName,
+						   unsigned long ulLine );
+#define configASSERT( x ) if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ )
+
+/* The priority of the tasks that pass the frames of the simulated link. */
+#define configMAC_ISR_SIMULATOR_PRIORITY	( configMAX_PRIORITIES - 1 )
+
+/* MAC address configuration of stack 0.  Stack 1 uses the same address plus
+ * one in the last byte, see main.c. */
+#define configMAC_ADDR0		0x00
+#define configMAC_ADDR1		0x11
+#define configMAC_ADDR2		0x22
+#define configMAC_ADDR3		0x33
+#define configMAC_ADDR4		0x44
+#define configMAC_ADDR5		0x41
+
+/* IP address configuration of stack 0.  Stack 1 uses the same address plus
+ * one in the last byte. */
+#define configIP_ADDR0		10
+#define configIP_ADDR1		10
+#define configIP_ADDR2		10
+#define configIP_ADDR3		200
+
+/* Default gateway IP address configuration.  There is no gateway on the
+ * simulated link. */
+#define configGATEWAY_ADDR0	10
+#define configGATEWAY_ADDR1	10
+#define configGATEWAY_ADDR2	10
+#define configGATEWAY_ADDR3	1
+
+/* Default DNS server configuration.  The tests only parse DNS replies, they
+ * do not send queries. */
+#define configDNS_SERVER_ADDR0 	208
+#define configDNS_SERVER_ADDR1 	67
+#define configDNS_SERVER_ADDR2 	222
+#define configDNS_SERVER_ADDR3 	222
+
+/* Default netmask configuration. */
+#define configNET_MASK0		255
+#define configNET_MASK1		0
+#define configNET_MASK2		0
+#define configNET_MASK3		0
+
+#endif /* FREERTOS_CONFIG_H */
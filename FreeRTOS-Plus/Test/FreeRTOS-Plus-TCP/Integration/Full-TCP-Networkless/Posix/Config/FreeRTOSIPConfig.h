@@ -0,0 +1,157 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+
+/*****************************************************************************
+ *
+ * See the following URL for configuration information.
+ * http://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Configuration.html
+ *
+ * The settings of the functional tests are those of ../Config/FreeRTOSIPConfig.h.
+ * The differences are commented: this build runs two IP-stacks on the
+ * simulated link, without DHCP, and with larger windows and more network
+ * buffers for the performance tests.
+ *
+ *****************************************************************************/
+
+#ifndef FREERTOS_IP_CONFIG_H
+#define FREERTOS_IP_CONFIG_H
+
+#include <stdlib.h>
+
+/* Prototype for the function used to print out. */
+extern void vLoggingPrintf( const char *pcFormatString, ... );
+
+/* Set to 1 to print out debug messages. */
+#define ipconfigHAS_DEBUG_PRINTF	0
+#if( ipconfigHAS_DEBUG_PRINTF == 1 )
+	#define FreeRTOS_debug_printf(X)	vLoggingPrintf X
+#endif
+
+/* The messages of the stack would be mixed with the results of the tests. */
+#define ipconfigHAS_PRINTF			0
+#if( ipconfigHAS_PRINTF == 1 )
+	#define FreeRTOS_printf(X)			vLoggingPrintf X
+#endif
+
+#define ipconfigBYTE_ORDER pdFREERTOS_LITTLE_ENDIAN
+
+/* The simulated link does not corrupt frames. */
+#define ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM   1
+
+#define ipconfigSOCK_DEFAULT_RECEIVE_BLOCK_TIME	( 5000 )
+#define	ipconfigSOCK_DEFAULT_SEND_BLOCK_TIME	( 5000 )
+
+/* There is no other node on the link that could be asked for a name. */
+#define ipconfigUSE_LLMNR					( 0 )
+#define ipconfigUSE_NBNS					( 0 )
+
+/* The DNS settings are used by the parser tests of test_freertos_tcp.c. */
+#define ipconfigUSE_DNS_CACHE				( 1 )
+#define ipconfigDNS_CACHE_NAME_LENGTH		( 254 )
+#define ipconfigDNS_CACHE_ENTRIES			( 4 )
+#define ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY   ( 6 )
+#define ipconfigDNS_REQUEST_ATTEMPTS		( 2 )
+
+#define ipconfigIP_TASK_PRIORITY			( configMAX_PRIORITIES - 2 )
+#define ipconfigIP_TASK_STACK_SIZE_WORDS	( configMINIMAL_STACK_SIZE * 5 )
+
+#define ipconfigRAND32()	rand()
+
+#define ipconfigUSE_NETWORK_EVENT_HOOK 1
+
+#define ipconfigUDP_MAX_SEND_BLOCK_TIME_TICKS ( 5000U / portTICK_PERIOD_MS )
+
+/* Both stacks use the static addresses of main.c. */
+#define ipconfigUSE_DHCP	0
+
+#define ipconfigARP_CACHE_ENTRIES		6
+#define ipconfigMAX_ARP_RETRANSMISSIONS ( 5 )
+#define ipconfigMAX_ARP_AGE			150
+
+#define ipconfigINCLUDE_FULL_INET_ADDR	1
+
+/* Stack 0 runs the test runner and the clients, stack 1 the servers of the
+performance tests.  Every task selects its stack with FreeRTOS_SetIPStack(),
+which is stored in the thread local storage pointer below. */
+#define ipconfigIP_STACK_COUNT			2
+#define ipconfigIP_STACK_TLS_INDEX		0
+
+/* The pool of network buffers is shared by the two stacks, and must hold the
+windows of a bulk transfer in both directions. */
+#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS		128
+#define ipconfigEVENT_QUEUE_LENGTH		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
+
+#define ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND 1
+
+/* The routing table is tested by test_freertos_tcp.c.  No interfaces are
+added, all packets leave through the simulated link. */
+#define ipconfigUSE_ROUTING				1
+
+#define ipconfigUDP_TIME_TO_LIVE		128
+#define ipconfigTCP_TIME_TO_LIVE		128
+
+#define ipconfigUSE_TCP				( 1 )
+#define ipconfigUSE_TCP_WIN			( 1 )
+
+/* Tested by Full_FREERTOS_TCP, TCPReusePortChildCount. */
+#define ipconfigTCP_REUSE_PORT		( 1 )
+
+/* Full sized Ethernet frames, as on a real network. */
+#define ipconfigNETWORK_MTU		1500U
+
+#define ipconfigUSE_DNS			1
+
+#define ipconfigREPLY_TO_INCOMING_PINGS				1
+#define ipconfigSUPPORT_OUTGOING_PINGS				0
+
+/* The performance tests wait for many sockets at once. */
+#define ipconfigSUPPORT_SELECT_FUNCTION				1
+
+#define ipconfigFILTER_OUT_NON_ETHERNET_II_FRAMES  1
+#define ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES	1
+
+#define ipconfigPACKET_FILLER_SIZE 2U
+
+/* The connect storm holds many connections on both stacks at the same
+time. */
+#define ipconfigTCP_WIN_SEG_COUNT		256
+
+#define ipconfigTCP_RX_BUFFER_LENGTH			( 1000 )
+#define ipconfigTCP_TX_BUFFER_LENGTH			( 1000 )
+
+#define ipconfigIS_VALID_PROG_ADDRESS(x) ( (x) != NULL )
+
+#define ipconfigTCP_HANG_PROTECTION			( 1 )
+#define ipconfigTCP_HANG_PROTECTION_TIME	( 30 )
+
+#define ipconfigTCP_KEEP_ALIVE				( 1 )
+#define ipconfigTCP_KEEP_ALIVE_INTERVAL		( 20 ) /* in seconds */
+
+#define portINLINE __inline
+
+#endif /* FREERTOS_IP_CONFIG_H */
@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+#
+# Comparison of the metrics of the FreeRTOS+TCP performance tests.
+#
+# Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+
+import argparse
+import csv
+import statistics
+import sys
+import textwrap
+
+
+COLUMNS = ["scenario", "metric", "value", "unit", "better"]
+DIRECTIONS = ("higher", "lower", "info")
+
+EXIT_REGRESSION = 1
+EXIT_USAGE = 2
+
+
+class MetricsError(Exception):
+    pass
+
+
+def prolog():
+    return textwrap.dedent("""\
+        Compares the metrics that test_freertos_tcp_performance.c writes to
+        the file named by TCP_PERF_METRICS with a stored baseline.  Every
+        file has the columns scenario,metric,value,unit,better, where better
+        is "higher", "lower" or "info".
+
+        "merge" writes the median of several runs to one file, for instance
+        to store it as the baseline.  "compare" takes the median of one or
+        more runs, and fails when a metric is worse than the baseline by
+        more than the threshold, or is missing.  Metrics marked "info" are
+        shown but never fail.
+    """)
+
+
+def read_metrics(path):
+    """Returns {(scenario, metric): row} of a metrics file."""
+    metrics = {}
+    try:
+        with open(path, newline="") as source:
+            reader = csv.DictReader(source)
+            if reader.fieldnames != COLUMNS:
+                raise MetricsError("%s: the columns must be %s"
+                                   % (path, ",".join(COLUMNS)))
+            for row in reader:
+                if row["better"] not in DIRECTIONS:
+                    raise MetricsError("%s: unknown direction '%s'"
+                                       % (path, row["better"]))
+                try:
+                    row["value"] = float(row["value"])
+                except ValueError:
+                    raise MetricsError("%s: '%s' is not a number"
+                                       % (path, row["value"]))
+                metrics[(row["scenario"], row["metric"])] = row
+    except OSError as error:
+        raise MetricsError(str(error))
+    return metrics
+
+
+def median_of_runs(paths):
+    """Returns the metrics of several runs, with the median of every value.
+
+       A metric that is missing in some runs, because a scenario failed, is
+       the median of the runs that have it.
+    """
+    runs = [read_metrics(path) for path in paths]
+    merged = {}
+    for run in runs:
+        for key, row in run.items():
+            merged.setdefault(key, dict(row, values=[]))["values"].append(
+                row["value"])
+    for row in merged.values():
+        row["value"] = statistics.median(row.pop("values"))
+    return merged
+
+
+def write_metrics(path, metrics):
+    with open(path, "w", newline="") as destination:
+        writer = csv.DictWriter(destination, fieldnames=COLUMNS,
+                                lineterminator="\n")
+        writer.writeheader()
+        for key in sorted(metrics):
+            row = dict(metrics[key])
+            row["value"] = "%.3f" % row["value"]
+            writer.writerow(row)
+
+
+def parse_thresholds(arguments):
+    """Returns {"scenario/metric": percentage} of the --metric options."""
+    thresholds = {}
+    for argument in arguments or []:
+        name, _, percentage = argument.rpartition("=")
+        try:
+            thresholds[name] = float(percentage)
+        except ValueError:
+            name = ""
+        if "/" not in name:
+            raise MetricsError("--metric must look like scenario/metric=PCT,"
+                               " not '%s'" % argument)
+    return thresholds
+
+
+def compare(baseline, current, threshold, thresholds):
+    """Returns a list of (key, unit, base, value, change, limit, status).
+
+       The change is in percent of the baseline, positive when the value is
+       higher.  The status is "ok", "improved", "REGRESSION", "MISSING",
+       "new" or "info".
+    """
+    results = []
+    for key in sorted(set(baseline) | set(current)):
+        base = baseline.get(key)
+        row = current.get(key)
+        unit = (row or base)["unit"]
+        limit = thresholds.get("/".join(key), threshold)
+        if base is None:
+            results.append((key, unit, None, row["value"], None, limit, "new"))
+            continue
+        if row is None:
+            results.append((key, unit, base["value"], None, None, limit,
+                            "MISSING"))
+            continue
+        if base["value"] != 0:
+            change = (row["value"] - base["value"]) * 100.0 / abs(base["value"])
+        else:
+            change = 0.0 if row["value"] == 0 else float("inf")
+        better = base["better"]
+        if better == "info":
+            status = "info"
+        else:
+            worse = -change if better == "higher" else change
+            if worse > limit:
+                status = "REGRESSION"
+            elif -worse > limit:
+                status = "improved"
+            else:
+                status = "ok"
+        results.append((key, unit, base["value"], row["value"], change, limit,
+                        status))
+    return results
+
+
+def print_results(results):
+    print("%-40s %14s %14s %9s %7s  %s"
+          % ("scenario/metric", "baseline", "current", "change", "limit",
+             "status"))
+    for key, unit, base, value, change, limit, status in results:
+        print("%-40s %14s %14s %9s %6.1f%%  %s" % (
+            "/".join(key),
+            "-" if base is None else "%.3f" % base,
+            "-" if value is None else "%.3f" % value,
+            "-" if change is None else "%+.1f%%" % change,
+            limit,
+            status if status != "info" else "info (%s)" % unit))
+
+
+def write_report(path, results):
+    with open(path, "w", newline="") as destination:
+        writer = csv.writer(destination, lineterminator="\n")
+        writer.writerow(["scenario", "metric", "unit", "baseline", "current",
+                         "change_percent", "limit_percent", "status"])
+        for key, unit, base, value, change, limit, status in results:
+            writer.writerow([
+                key[0], key[1], unit,
+                "" if base is None else "%.3f" % base,
+                "" if value is None else "%.3f" % value,
+                "" if change is None else "%.2f" % change,
+                "%.2f" % limit,
+                status.lower()])
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=prolog(),
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command")
+
+    merge = commands.add_parser(
+        "merge", help="write the median of several runs to one file")
+    merge.add_argument("output", help="the file to write")
+    merge.add_argument("runs", nargs="+", help="the metrics of the runs")
+
+    check = commands.add_parser(
+        "compare", help="compare runs with a baseline")
+    check.add_argument("baseline", help="the metrics of the baseline")
+    check.add_argument("runs", nargs="+", help="the metrics of the runs")
+    check.add_argument(
+        "--threshold", type=float, default=10.0, metavar="PCT",
+        help="the largest change for the worse, in percent (default 10)")
+    check.add_argument(
+        "--metric", action="append", metavar="SCENARIO/METRIC=PCT",
+        help="the threshold of one metric, may be repeated")
+    check.add_argument(
+        "--report", metavar="FILE",
+        help="also write the comparison as CSV")
+
+    args = parser.parse_args()
+
+    try:
+        if args.command == "merge":
+            write_metrics(args.output, median_of_runs(args.runs))
+            return 0
+        if args.command == "compare":
+            results = compare(read_metrics(args.baseline),
+                              median_of_runs(args.runs),
+                              args.threshold,
+                              parse_thresholds(args.metric))
+            print_results(results)
+            if args.report:
+                write_report(args.report, results)
+            failed = [r for r in results if r[6] in ("REGRESSION", "MISSING")]
+            if failed:
+                print("%d of %d metrics regressed or are missing"
+                      % (len(failed), len(results)))
+                return EXIT_REGRESSION
+            return 0
+    except MetricsError as error:
+        print("compare_metrics.py: %s" % error, file=sys.stderr)
+        return EXIT_USAGE
+
+    parser.print_help(sys.stderr)
+    return EXIT_USAGE
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,260 @@
+/*
+ * FreeRTOS V202002.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+ /**
+  * @file main.c
+  * @brief Implements the main function of the Posix build of the tests.
+  *
+  * Two IP-stacks are started in the same process.  Stack 0 is the stack under
+  * test, and runs the test runner.  Stack 1 is connected to it by the
+  * simulated link, and runs the servers of the performance tests.  No network
+  * interface of the host is used.
+  */
+
+  /* FreeRTOS include. */
+#include <FreeRTOS.h>
+#include "task.h"
+
+/* Standard includes. */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Test runner includes. */
+#include "test_runner.h"
+
+/* System application includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "SimulatedLink.h"
+
+#define TEST_RUNNER_TASK_STACK_SIZE    10000
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Selects stack 0 for the test runner, and runs the tests.
+ */
+static void prvTestRunnerTask( void * pvParameters );
+
+/*-----------------------------------------------------------*/
+
+/* The MAC and IP addresses of stack 0.  Those of stack 1 are one higher in
+ * the last byte. */
+static const uint8_t ucMACAddress[ 6 ] =
+{
+    configMAC_ADDR0,
+    configMAC_ADDR1,
+    configMAC_ADDR2,
+    configMAC_ADDR3,
+    configMAC_ADDR4,
+    configMAC_ADDR5
+};
+
+static const uint8_t ucServerMACAddress[ 6 ] =
+{
+    configMAC_ADDR0,
+    configMAC_ADDR1,
+    configMAC_ADDR2,
+    configMAC_ADDR3,
+    configMAC_ADDR4,
+    configMAC_ADDR5 + 1
+};
+
+static const uint8_t ucIPAddress[ 4 ] =
+{
+    configIP_ADDR0,
+    configIP_ADDR1,
+    configIP_ADDR2,
+    configIP_ADDR3
+};
+static const uint8_t ucServerIPAddress[ 4 ] =
+{
+    configIP_ADDR0,
+    configIP_ADDR1,
+    configIP_ADDR2,
+    configIP_ADDR3 + 1
+};
+static const uint8_t ucNetMask[ 4 ] =
+{
+    configNET_MASK0,
+    configNET_MASK1,
+    configNET_MASK2,
+    configNET_MASK3
+};
+static const uint8_t ucGatewayAddress[ 4 ] =
+{
+    configGATEWAY_ADDR0,
+    configGATEWAY_ADDR1,
+    configGATEWAY_ADDR2,
+    configGATEWAY_ADDR3
+};
+static const uint8_t ucDNSServerAddress[ 4 ] =
+{
+    configDNS_SERVER_ADDR0,
+    configDNS_SERVER_ADDR1,
+    configDNS_SERVER_ADDR2,
+    configDNS_SERVER_ADDR3
+};
+
+/* Use by the pseudo random number generator.  It has a fixed seed, so that
+ * the sequence numbers and ports, and so the runs, are the same every time. */
+static UBaseType_t ulNextRand = 1U;
+
+/*-----------------------------------------------------------*/
+int main( void )
+{
+    /* The output of the tests is read by scripts, print it immediately. */
+    setvbuf( stdout, NULL, _IONBF, 0 );
+
+    /* Initialize the stack under test.
+     *
+     ***NOTE*** Tasks that use the network are created in the network event hook
+     * when the network is connected and ready for use (see the definition of
+     * vApplicationIPNetworkEventHook() below). */
+    FreeRTOS_IPInit(
+        ucIPAddress,
+        ucNetMask,
+        ucGatewayAddress,
+        ucDNSServerAddress,
+        ucMACAddress );
+
+    /* Start the second stack at the other end of the simulated link. */
+    FreeRTOS_IPInitStack(
+        1U,
+        ucServerIPAddress,
+        ucNetMask,
+        ucGatewayAddress,
+        ucDNSServerAddress,
+        ucServerMACAddress,
+        xSimLinkPort1Initialise,
+        xSimLinkPort1Output );
+
+    vTaskStartScheduler();
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIPNetworkEventHook( eIPCallbackEvent_t eNetworkEvent )
+{
+    static BaseType_t xTasksAlreadyCreated = pdFALSE;
+
+    /* If the network of stack 0 has just come up... */
+    if( ( eNetworkEvent == eNetworkUp ) && ( xTasksAlreadyCreated == pdFALSE ) && ( FreeRTOS_GetIPStack() == 0U ) )
+    {
+        xTaskCreate( prvTestRunnerTask,
+                     "TestRunner",
+                     TEST_RUNNER_TASK_STACK_SIZE,
+                     NULL,
+                     tskIDLE_PRIORITY, NULL );
+
+        xTasksAlreadyCreated = pdTRUE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRunnerTask( void * pvParameters )
+{
+    /* With two stacks, every task must say which one it uses. */
+    ( void ) FreeRTOS_SetIPStack( 0U );
+
+    TEST_RUNNER_RunTests_task( pvParameters );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+    /* The idle task sleeps to lower the CPU usage of the process, which
+     * would otherwise be added to the CPU time of the performance tests. */
+    usleep( 1000 );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationMallocFailedHook( void )
+{
+    printf( "vApplicationMallocFailedHook\n" );
+    exit( EXIT_FAILURE );
+}
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    /* A script that runs the tests must see the failure, so the process is
+     * stopped instead of blocked. */
+    printf( "vAssertCalled %s, %lu\n", pcFileName, ulLine );
+    abort();
+}
+/*-----------------------------------------------------------*/
+
+void vLoggingPrintf( const char * pcFormat,
+                     ... )
+{
+    va_list xArgs;
+
+    va_start( xArgs, pcFormat );
+    vprintf( pcFormat, xArgs );
+    va_end( xArgs );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxRand( void )
+{
+    const uint32_t ulMultiplier = 0x015a4e35UL, ulIncrement = 1UL;
+
+    /* Utility function to generate a pseudo random number. */
+
+    ulNextRand = ( ulMultiplier * ulNextRand ) + ulIncrement;
+    return( ( int ) ( ulNextRand >> 16UL ) & 0x7fffUL );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xApplicationGetRandomNumber( uint32_t * pulNumber )
+{
+    *( pulNumber ) = uxRand();
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Callback that provides the inputs necessary to generate a randomized TCP
+ * Initial Sequence Number per RFC 6528.  THIS IS ONLY A DUMMY IMPLEMENTATION
+ * THAT RETURNS A PSEUDO RANDOM NUMBER SO IS NOT INTENDED FOR USE IN PRODUCTION
+ * SYSTEMS.
+ */
+extern uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+                                                    uint16_t usSourcePort,
+                                                    uint32_t ulDestinationAddress,
+                                                    uint16_t usDestinationPort )
+{
+    ( void ) ulSourceAddress;
+    ( void ) usSourcePort;
+    ( void ) ulDestinationAddress;
+    ( void ) usDestinationPort;
+
+    return uxRand();
+}
@@ -41,4 +41,6 @@ void TEST_FreeRTOS_TCP_prvCheckOptions( FreeRTOS_Socket_t * pxSocket,
 
 void TEST_FreeRTOS_TCP_prvTCPCreateWindow( FreeRTOS_Socket_t * pxSocket );
 
+void TEST_FreeRTOS_TCP_prvTCPSetSocketCount( FreeRTOS_Socket_t const * pxSocketToDelete );
+
 #endif /* ifndef _FREERTOS_TCP_TEST_ACCESS_DECLARE_H_ */
@@ -31,8 +31,10 @@
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 #include "list.h"
+#include "task.h"
 #include "FreeRTOS_IP.h"
 #include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Sockets.h"
 #include "FreeRTOS_DNS.h"
 
 /* Test includes. */
@@ -68,6 +70,16 @@ TEST_GROUP_RUNNER( Full_FREERTOS_TCP )
 
     /* xProcessReceivedUDPPacket test. */
     RUN_TEST_CASE( Full_FREERTOS_TCP, UDPPacketLength );
+
+    #if ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_REUSE_PORT == 1 )
+        /* prvTCPSetSocketCount test. */
+        RUN_TEST_CASE( Full_FREERTOS_TCP, TCPReusePortChildCount );
+    #endif
+
+    #if ( ipconfigUSE_ROUTING != 0 )
+        /* vRouteLookup test. */
+        RUN_TEST_CASE( Full_FREERTOS_TCP, RouteLookup );
+    #endif
 }
 
 TEST( Full_FREERTOS_TCP, prvParseDnsResponse )
@@ -367,3 +379,158 @@ TEST( Full_FREERTOS_TCP, UDPPacketLength )
     xReturn = xProcessReceivedUDPPacket( &xNetworkBuffer, usPort );
     TEST_ASSERT_EQUAL_UINT32( pdFAIL, xReturn );
 }
+
+#if ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_REUSE_PORT == 1 )
+
+    static Socket_t prvCreateReusePortListener( uint16_t usPort )
+    {
+        Socket_t xSocket;
+        struct freertos_sockaddr xAddress;
+        BaseType_t xReusePort = pdTRUE;
+
+        xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+        TEST_ASSERT_NOT_EQUAL( FREERTOS_INVALID_SOCKET, xSocket );
+        TEST_ASSERT_EQUAL_INT32( 0, FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_REUSE_PORT, &xReusePort, sizeof( xReusePort ) ) );
+
+        memset( &xAddress, 0, sizeof( xAddress ) );
+        xAddress.sin_port = FreeRTOS_htons( usPort );
+        TEST_ASSERT_EQUAL_INT32( 0, FreeRTOS_bind( xSocket, &xAddress, sizeof( xAddress ) ) );
+        TEST_ASSERT_EQUAL_INT32( 0, FreeRTOS_listen( xSocket, 4 ) );
+
+        return xSocket;
+    }
+
+    TEST( Full_FREERTOS_TCP, TCPReusePortChildCount )
+    {
+        const uint16_t usPort = 5005U;
+        Socket_t xListenA, xListenB;
+        FreeRTOS_Socket_t * pxListenA, * pxListenB;
+        FreeRTOS_Socket_t xChild;
+
+        /* Two sockets listen to the same port, B has accepted two
+         * connections. */
+        xListenA = prvCreateReusePortListener( usPort );
+        xListenB = prvCreateReusePortListener( usPort );
+        pxListenA = ( FreeRTOS_Socket_t * ) xListenA;
+        pxListenB = ( FreeRTOS_Socket_t * ) xListenB;
+
+        memset( &xChild, 0, sizeof( xChild ) );
+        xChild.ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_TCP;
+        xChild.usLocalPort = usPort;
+        xChild.u.xTCP.ucTCPState = ( uint8_t ) eESTABLISHED;
+        xChild.u.xTCP.pxListenSocket = pxListenB;
+
+        /* The IP-task also changes the child-counts. */
+        vTaskSuspendAll();
+        {
+            pxListenA->u.xTCP.usChildCount = 0U;
+            pxListenB->u.xTCP.usChildCount = 2U;
+
+            /* Closing listener A must leave the children of B alone. */
+            TEST_FreeRTOS_TCP_prvTCPSetSocketCount( pxListenA );
+            TEST_ASSERT_EQUAL_UINT16( 0U, pxListenA->u.xTCP.usChildCount );
+            TEST_ASSERT_EQUAL_UINT16( 2U, pxListenB->u.xTCP.usChildCount );
+
+            /* A child of B decreases the count of B only. */
+            TEST_FreeRTOS_TCP_prvTCPSetSocketCount( &xChild );
+            TEST_ASSERT_EQUAL_UINT16( 1U, pxListenB->u.xTCP.usChildCount );
+
+            /* A child whose listener has been closed has no parent left. */
+            xChild.u.xTCP.pxListenSocket = NULL;
+            TEST_FreeRTOS_TCP_prvTCPSetSocketCount( &xChild );
+            TEST_ASSERT_EQUAL_UINT16( 0U, pxListenA->u.xTCP.usChildCount );
+            TEST_ASSERT_EQUAL_UINT16( 1U, pxListenB->u.xTCP.usChildCount );
+
+            pxListenB->u.xTCP.usChildCount = 0U;
+        }
+        ( void ) xTaskResumeAll();
+
+        FreeRTOS_closesocket( xListenA );
+        FreeRTOS_closesocket( xListenB );
+    }
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_REUSE_PORT == 1 ) */
+
+#if ( ipconfigUSE_ROUTING != 0 )
+
+    TEST( Full_FREERTOS_TCP, RouteLookup )
+    {
+        const uint32_t ulNet16 = FreeRTOS_inet_addr_quick( 192, 168, 0, 0 );
+        const uint32_t ulMask16 = FreeRTOS_inet_addr_quick( 255, 255, 0, 0 );
+        const uint32_t ulNet24 = FreeRTOS_inet_addr_quick( 192, 168, 1, 0 );
+        const uint32_t ulMask24 = FreeRTOS_inet_addr_quick( 255, 255, 255, 0 );
+        const uint32_t ulGateway16 = FreeRTOS_inet_addr_quick( 192, 168, 0, 1 );
+        const uint32_t ulDefaultGateway = FreeRTOS_inet_addr_quick( 192, 168, 0, 2 );
+        const uint32_t ulInNet24 = FreeRTOS_inet_addr_quick( 192, 168, 1, 3 );
+        const uint32_t ulInNet16 = FreeRTOS_inet_addr_quick( 192, 168, 2, 1 );
+        const uint32_t ulElsewhere = FreeRTOS_inet_addr_quick( 172, 16, 0, 1 );
+        const uint32_t ulIPAddress = FreeRTOS_GetIPAddress();
+        const uint32_t ulNetMask = FreeRTOS_GetNetmask();
+        const uint32_t ulNeighbour = ( ulIPAddress & ulNetMask ) | ( ~ulNetMask & FreeRTOS_htonl( 1UL ) );
+        NetworkEndPoint_t xEndPointA, xEndPointB;
+        RouteCache_t xCache;
+        UBaseType_t uxGeneration;
+
+        memset( &xEndPointA, 0, sizeof( xEndPointA ) );
+        memset( &xEndPointB, 0, sizeof( xEndPointB ) );
+
+        /* The IP-task must not send through the end-points of this test,
+         * they have no interface. */
+        vTaskSuspendAll();
+        {
+            /* 192.168/16 through a gateway on A, the more specific
+             * 192.168.1/24 directly on B. */
+            TEST_ASSERT_EQUAL_INT32( 0, FreeRTOS_AddRoute( ulNet16, ulMask16, ulGateway16, &xEndPointA ) );
+            TEST_ASSERT_EQUAL_INT32( 0, FreeRTOS_AddRoute( ulNet24, ulMask24, 0UL, &xEndPointB ) );
+
+            vRouteLookup( &xCache, ulInNet24 );
+            TEST_ASSERT_EQUAL_PTR( &xEndPointB, xCache.pxEndPoint );
+            TEST_ASSERT_EQUAL_UINT32( ulInNet24, xCache.ulNextHop );
+
+            vRouteLookup( &xCache, ulInNet16 );
+            TEST_ASSERT_EQUAL_PTR( &xEndPointA, xCache.pxEndPoint );
+            TEST_ASSERT_EQUAL_UINT32( ulGateway16, xCache.ulNextHop );
+
+            /* Without a route, the primary end-point is used. */
+            vRouteCacheUpdate( &xCache, ulElsewhere );
+            TEST_ASSERT_NULL( xCache.pxEndPoint );
+            TEST_ASSERT_EQUAL_UINT32( ulElsewhere, xCache.ulNextHop );
+
+            /* A new default route makes the cache look up again. */
+            TEST_ASSERT_EQUAL_INT32( 0, FreeRTOS_AddRoute( 0UL, 0UL, ulDefaultGateway, &xEndPointA ) );
+            vRouteCacheUpdate( &xCache, ulElsewhere );
+            TEST_ASSERT_EQUAL_PTR( &xEndPointA, xCache.pxEndPoint );
+            TEST_ASSERT_EQUAL_UINT32( ulDefaultGateway, xCache.ulNextHop );
+
+            /* The subnet of the primary end-point is more specific than the
+             * default route. */
+            vRouteLookup( &xCache, ulNeighbour );
+            TEST_ASSERT_NULL( xCache.pxEndPoint );
+            TEST_ASSERT_EQUAL_UINT32( ulNeighbour, xCache.ulNextHop );
+
+            /* Setting the address or the netmask of the primary end-point
+             * invalidates the caches. */
+            uxGeneration = xCache.uxGeneration;
+            FreeRTOS_SetIPAddress( ulIPAddress );
+            vRouteCacheUpdate( &xCache, ulNeighbour );
+            TEST_ASSERT_NOT_EQUAL( uxGeneration, xCache.uxGeneration );
+
+            uxGeneration = xCache.uxGeneration;
+            FreeRTOS_SetAddressConfiguration( NULL, &ulNetMask, NULL, NULL );
+            vRouteCacheUpdate( &xCache, ulNeighbour );
+            TEST_ASSERT_NOT_EQUAL( uxGeneration, xCache.uxGeneration );
+
+            /* Removing a route also invalidates the caches. */
+            vRouteCacheUpdate( &xCache, ulElsewhere );
+            TEST_ASSERT_EQUAL_PTR( &xEndPointA, xCache.pxEndPoint );
+            TEST_ASSERT_EQUAL_INT32( 0, FreeRTOS_RemoveRoute( 0UL, 0UL ) );
+            vRouteCacheUpdate( &xCache, ulElsewhere );
+            TEST_ASSERT_NULL( xCache.pxEndPoint );
+
+            TEST_ASSERT_EQUAL_INT32( 0, FreeRTOS_RemoveRoute( ulNet24, ulMask24 ) );
+            TEST_ASSERT_EQUAL_INT32( 0, FreeRTOS_RemoveRoute( ulNet16, ulMask16 ) );
+        }
+        ( void ) xTaskResumeAll();
+    }
+
+#endif /* ipconfigUSE_ROUTING */
@@ -0,0 +1,896 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Timed scenarios between two IP-stacks that are connected by the simulated
+ * link, see simulated_link/SimulatedLink.h.  Stack 0 runs the clients in the
+ * task of the test runner, stack 1 runs a TCP sink and an echo server:
+ *
+ *  - ConnectStorm: tcpperfSTORM_ROUNDS rounds in which tcpperfSTORM_CONNECTIONS
+ *    connections are opened at the same time,
+ *  - BulkTransfer: tcpperfBULK_MEGABYTES over one connection,
+ *  - SmallMessageRPC: tcpperfRPC_TRANSACTIONS request/response exchanges of
+ *    tcpperfRPC_MESSAGE_SIZE bytes,
+ *  - LossRecovery: tcpperfLOSS_MEGABYTES over a link that loses tcpperfLOSS_PPM
+ *    of the frames in both directions.
+ *
+ * Every scenario fails when the traffic does not arrive completely.  The
+ * results are printed, and written as CSV to the file named by the environment
+ * variable TCP_PERF_METRICS, with the columns:
+ *
+ *     scenario,metric,value,unit,better
+ *
+ * where 'better' is "higher", "lower" or "info".  The CSV is compared with a
+ * baseline by Posix/compare_metrics.py.
+ *
+ * The CPU time is that of the whole process, so it includes the IP-tasks of
+ * both stacks and the tasks of the link.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/* Test includes. */
+#include "unity_fixture.h"
+#include "unity.h"
+#include "test_runner_config.h"
+
+#if ( testrunnerFULL_TCP_PERFORMANCE_ENABLED == 1 )
+
+#include "SimulatedLink.h"
+
+#if ( ipconfigIP_STACK_COUNT < 2 ) || ( ipconfigSUPPORT_SELECT_FUNCTION != 1 )
+    #error The performance tests need ipconfigIP_STACK_COUNT >= 2 and ipconfigSUPPORT_SELECT_FUNCTION == 1
+#endif
+
+/**
+ * @brief Configuration for this test group.
+ */
+
+/* The stack that runs the servers. */
+#define tcpperfSERVER_STACK           ( 1U )
+
+/* The ports of the servers. */
+#define tcpperfSINK_PORT              ( 5220U )
+#define tcpperfRPC_PORT               ( 5221U )
+
+#ifndef tcpperfSTORM_CONNECTIONS
+    #define tcpperfSTORM_CONNECTIONS    ( 32U )
+#endif
+
+#ifndef tcpperfSTORM_ROUNDS
+    #define tcpperfSTORM_ROUNDS         ( 10U )
+#endif
+
+#ifndef tcpperfBULK_MEGABYTES
+    #define tcpperfBULK_MEGABYTES       ( 32U )
+#endif
+
+#ifndef tcpperfRPC_TRANSACTIONS
+    #define tcpperfRPC_TRANSACTIONS     ( 5000U )
+#endif
+
+#ifndef tcpperfRPC_MESSAGE_SIZE
+    #define tcpperfRPC_MESSAGE_SIZE     ( 64U )
+#endif
+
+/* The loss rate in parts per million, and the one-way delay, of the link in
+ * the LossRecovery scenario.  The seeds are fixed, so that the same frames
+ * are lost in every run. */
+#ifndef tcpperfLOSS_PPM
+    #define tcpperfLOSS_PPM             ( 10000U )
+#endif
+
+#ifndef tcpperfLOSS_LATENCY_US
+    #define tcpperfLOSS_LATENCY_US      ( 500U )
+#endif
+
+#ifndef tcpperfLOSS_MEGABYTES
+    #define tcpperfLOSS_MEGABYTES       ( 4U )
+#endif
+
+/* The priority of the clients and the servers.  It is above that of the idle
+ * task, which sleeps in vApplicationIdleHook(). */
+#define tcpperfTASK_PRIORITY          ( tskIDLE_PRIORITY + 1U )
+#define tcpperfTASK_STACK_SIZE        ( configMINIMAL_STACK_SIZE * 4U )
+
+/* The sink has one socket for every connection of the storm, and one for the
+ * bulk transfers. */
+#define tcpperfSINK_SOCKETS           ( tcpperfSTORM_CONNECTIONS + 1U )
+
+/* The size of the buffers passed to send() and recv(). */
+#define tcpperfBUFFER_SIZE            ( 16384U )
+
+/* The buffer and window sizes of the bulk connections, in segments. */
+#define tcpperfTCP_BUFFER_SEGMENTS    ( 32 )
+#define tcpperfTCP_WINDOW_SEGMENTS    ( 16 )
+
+/* The longest time that a scenario may make no progress. */
+#define tcpperfTIMEOUT                pdMS_TO_TICKS( 10000U )
+
+/* The result of a bulk transfer. */
+typedef struct xTCP_PERF_BULK_RESULT
+{
+    uint64_t ullBytesSent;
+    uint64_t ullBytesReceived; /* By the sink. */
+    uint64_t ullDurationNs;
+    uint64_t ullCPUTimeNs;
+    uint64_t ullMaxStallNs;    /* The longest time in which the sink received nothing. */
+} TCPPerfBulkResult_t;
+
+/*-----------------------------------------------------------*/
+
+static void prvStartServers( void );
+static void prvSelectServerStack( void );
+static void prvSinkServerTask( void * pvParameters );
+static void prvRPCServerTask( void * pvParameters );
+static Socket_t prvConnect( uint16_t usPort,
+                            BaseType_t xBulk );
+static void prvSetWindowProperties( Socket_t xSocket );
+static void prvCloseSocket( Socket_t xSocket );
+static BaseType_t prvRunBulk( uint64_t ullBytes,
+                              TCPPerfBulkResult_t * pxResult );
+static void prvSetLinkLoss( uint32_t ulLossPPM,
+                            uint32_t ulLatencyUs );
+static uint64_t prvNanoseconds( clockid_t xClock );
+static uint64_t prvPercentile( uint64_t * pullValues,
+                               size_t uxCount,
+                               uint32_t ulPerMille );
+static int prvCompareValues( const void * pvLeft,
+                             const void * pvRight );
+static void prvReportMetric( const char * pcScenario,
+                             const char * pcMetric,
+                             double dValue,
+                             const char * pcUnit,
+                             const char * pcBetter );
+static void prvCloseMetrics( void );
+
+/*-----------------------------------------------------------*/
+
+/* The address of the servers, in network byte order, 0 until they run. */
+static volatile uint32_t ulServerAddress = 0U;
+static volatile BaseType_t xSinkReady = pdFALSE;
+static volatile BaseType_t xRPCReady = pdFALSE;
+
+/* Updated by the sink, read by the clients. */
+static volatile uint64_t ullSinkReceived = 0U;
+static volatile uint32_t ulSinkAccepted = 0U;
+static volatile UBaseType_t uxSinkOpen = 0U;
+
+/* The priority of the runner, restored after every test. */
+static UBaseType_t uxRunnerPriority;
+
+/* The CSV file of the metrics. */
+static FILE * pxMetricsFile = NULL;
+
+/* The measurements of the storm and of the RPC scenario. */
+static uint64_t ullSetupTimes[ tcpperfSTORM_CONNECTIONS * tcpperfSTORM_ROUNDS ];
+static uint64_t ullLatencies[ tcpperfRPC_TRANSACTIONS ];
+
+/* Every task has its own buffer. */
+static uint8_t ucClientBuffer[ tcpperfBUFFER_SIZE ];
+static uint8_t ucSinkBuffer[ tcpperfBUFFER_SIZE ];
+static uint8_t ucRPCBuffer[ tcpperfRPC_MESSAGE_SIZE ];
+
+/*-----------------------------------------------------------*/
+
+/*
+ * @brief Test group definition.
+ */
+TEST_GROUP( Full_FREERTOS_TCP_Performance );
+
+TEST_SETUP( Full_FREERTOS_TCP_Performance )
+{
+    /* The clients must not share the CPU with the idle task. */
+    uxRunnerPriority = uxTaskPriorityGet( NULL );
+    vTaskPrioritySet( NULL, tcpperfTASK_PRIORITY );
+
+    prvStartServers();
+    TEST_ASSERT_MESSAGE( ulServerAddress != 0U, "The servers on stack 1 did not start" );
+}
+
+TEST_TEAR_DOWN( Full_FREERTOS_TCP_Performance )
+{
+    /* The other scenarios run on a perfect link. */
+    prvSetLinkLoss( 0U, 0U );
+    vTaskPrioritySet( NULL, uxRunnerPriority );
+}
+
+TEST_GROUP_RUNNER( Full_FREERTOS_TCP_Performance )
+{
+    RUN_TEST_CASE( Full_FREERTOS_TCP_Performance, ConnectStorm );
+    RUN_TEST_CASE( Full_FREERTOS_TCP_Performance, BulkTransfer );
+    RUN_TEST_CASE( Full_FREERTOS_TCP_Performance, SmallMessageRPC );
+    RUN_TEST_CASE( Full_FREERTOS_TCP_Performance, LossRecovery );
+
+    prvCloseMetrics();
+}
+
+TEST( Full_FREERTOS_TCP_Performance, ConnectStorm )
+{
+    Socket_t xSockets[ tcpperfSTORM_CONNECTIONS ];
+    uint64_t ullStarted[ tcpperfSTORM_CONNECTIONS ];
+    SocketSet_t xSocketSet;
+    struct freertos_sockaddr xServerAddress;
+    const TickType_t xNoTimeOut = 0U;
+    uint32_t ulRound, ulIndex, ulPending, ulConnected = 0U, ulFailed = 0U;
+    const uint32_t ulAcceptedBefore = ulSinkAccepted;
+    uint64_t ullRoundStart, ullNow, ullConnectTime = 0U;
+    TimeOut_t xTimeOut;
+    TickType_t xRemaining;
+
+    xSocketSet = FreeRTOS_CreateSocketSet();
+    TEST_ASSERT_NOT_NULL( xSocketSet );
+
+    xServerAddress.sin_port = FreeRTOS_htons( tcpperfSINK_PORT );
+    xServerAddress.sin_addr = ulServerAddress;
+
+    for( ulRound = 0U; ulRound < tcpperfSTORM_ROUNDS; ulRound++ )
+    {
+        ulPending = 0U;
+        ullRoundStart = prvNanoseconds( CLOCK_MONOTONIC );
+
+        /* Start all connections without waiting. */
+        for( ulIndex = 0U; ulIndex < tcpperfSTORM_CONNECTIONS; ulIndex++ )
+        {
+            xSockets[ ulIndex ] = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+            if( xSockets[ ulIndex ] == FREERTOS_INVALID_SOCKET )
+            {
+                xSockets[ ulIndex ] = NULL;
+                ulFailed++;
+                continue;
+            }
+
+            FreeRTOS_setsockopt( xSockets[ ulIndex ], 0, FREERTOS_SO_RCVTIMEO, &xNoTimeOut, sizeof( xNoTimeOut ) );
+            ullStarted[ ulIndex ] = prvNanoseconds( CLOCK_MONOTONIC );
+
+            if( FreeRTOS_connect( xSockets[ ulIndex ], &xServerAddress, sizeof( xServerAddress ) ) != -pdFREERTOS_ERRNO_EWOULDBLOCK )
+            {
+                prvCloseSocket( xSockets[ ulIndex ] );
+                xSockets[ ulIndex ] = NULL;
+                ulFailed++;
+                continue;
+            }
+
+            FreeRTOS_FD_SET( xSockets[ ulIndex ], xSocketSet, eSELECT_WRITE );
+            ulPending++;
+        }
+
+        /* Wait until all of them are connected. */
+        vTaskSetTimeOutState( &xTimeOut );
+        xRemaining = tcpperfTIMEOUT;
+
+        while( ( ulPending > 0U ) && ( xTaskCheckForTimeOut( &xTimeOut, &xRemaining ) == pdFALSE ) )
+        {
+            ( void ) FreeRTOS_select( xSocketSet, xRemaining );
+            ullNow = prvNanoseconds( CLOCK_MONOTONIC );
+
+            for( ulIndex = 0U; ulIndex < tcpperfSTORM_CONNECTIONS; ulIndex++ )
+            {
+                if( ( xSockets[ ulIndex ] != NULL ) &&
+                    ( ullStarted[ ulIndex ] != 0U ) &&
+                    ( FreeRTOS_issocketconnected( xSockets[ ulIndex ] ) > 0 ) )
+                {
+                    ullSetupTimes[ ulConnected++ ] = ullNow - ullStarted[ ulIndex ];
+                    ullStarted[ ulIndex ] = 0U;
+                    FreeRTOS_FD_CLR( xSockets[ ulIndex ], xSocketSet, eSELECT_ALL );
+                    ulPending--;
+                }
+            }
+        }
+
+        ullConnectTime += prvNanoseconds( CLOCK_MONOTONIC ) - ullRoundStart;
+        ulFailed += ulPending;
+
+        /* Close the connections gracefully, and wait until the sink has
+         * accepted and closed all of them, so that the next round starts from
+         * scratch. */
+        for( ulIndex = 0U; ulIndex < tcpperfSTORM_CONNECTIONS; ulIndex++ )
+        {
+            if( xSockets[ ulIndex ] != NULL )
+            {
+                FreeRTOS_FD_CLR( xSockets[ ulIndex ], xSocketSet, eSELECT_ALL );
+                FreeRTOS_shutdown( xSockets[ ulIndex ], FREERTOS_SHUT_RDWR );
+            }
+        }
+
+        vTaskSetTimeOutState( &xTimeOut );
+        xRemaining = tcpperfTIMEOUT;
+
+        while( ( ( ( ulSinkAccepted - ulAcceptedBefore ) < ulConnected ) || ( uxSinkOpen > 0U ) ) &&
+               ( xTaskCheckForTimeOut( &xTimeOut, &xRemaining ) == pdFALSE ) )
+        {
+            vTaskDelay( 1U );
+        }
+
+        for( ulIndex = 0U; ulIndex < tcpperfSTORM_CONNECTIONS; ulIndex++ )
+        {
+            if( xSockets[ ulIndex ] != NULL )
+            {
+                FreeRTOS_closesocket( xSockets[ ulIndex ] );
+            }
+        }
+    }
+
+    FreeRTOS_DeleteSocketSet( xSocketSet );
+
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( 0U, ulFailed, "Connections of the storm failed" );
+    TEST_ASSERT_EQUAL_UINT32( tcpperfSTORM_CONNECTIONS * tcpperfSTORM_ROUNDS, ulConnected );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( ulConnected, ulSinkAccepted - ulAcceptedBefore, "The sink did not accept all connections" );
+
+    prvReportMetric( "connect_storm", "connections_per_s",
+                     ( ( double ) ulConnected * 1.0e9 ) / ( double ) ullConnectTime, "1/s", "higher" );
+    prvReportMetric( "connect_storm", "setup_p50_us",
+                     ( double ) prvPercentile( ullSetupTimes, ulConnected, 500U ) / 1000.0, "us", "lower" );
+    prvReportMetric( "connect_storm", "setup_p99_us",
+                     ( double ) prvPercentile( ullSetupTimes, ulConnected, 990U ) / 1000.0, "us", "lower" );
+}
+
+TEST( Full_FREERTOS_TCP_Performance, BulkTransfer )
+{
+    TCPPerfBulkResult_t xResult;
+    BaseType_t xPassed;
+
+    xPassed = prvRunBulk( ( uint64_t ) tcpperfBULK_MEGABYTES * 1024U * 1024U, &xResult );
+
+    TEST_ASSERT_MESSAGE( xPassed == pdPASS, "The bulk transfer did not complete" );
+    TEST_ASSERT_TRUE( xResult.ullBytesReceived == xResult.ullBytesSent );
+
+    prvReportMetric( "bulk_transfer", "throughput_mbps",
+                     ( ( double ) xResult.ullBytesReceived * 8.0 * 1000.0 ) / ( double ) xResult.ullDurationNs, "Mbit/s", "higher" );
+    prvReportMetric( "bulk_transfer", "cpu_ns_per_byte",
+                     ( double ) xResult.ullCPUTimeNs / ( double ) xResult.ullBytesReceived, "ns/B", "lower" );
+}
+
+TEST( Full_FREERTOS_TCP_Performance, SmallMessageRPC )
+{
+    Socket_t xSocket;
+    uint32_t ulCount;
+    uint64_t ullStart, ullTransactionStart, ullDuration;
+    BaseType_t xResult = 0;
+    size_t uxDone;
+
+    xSocket = prvConnect( tcpperfRPC_PORT, pdFALSE );
+    TEST_ASSERT_NOT_NULL( xSocket );
+
+    memset( ucClientBuffer, 0x5a, tcpperfRPC_MESSAGE_SIZE );
+    ullStart = prvNanoseconds( CLOCK_MONOTONIC );
+
+    for( ulCount = 0U; ulCount < tcpperfRPC_TRANSACTIONS; ulCount++ )
+    {
+        ullTransactionStart = prvNanoseconds( CLOCK_MONOTONIC );
+
+        if( FreeRTOS_send( xSocket, ucClientBuffer, tcpperfRPC_MESSAGE_SIZE, 0 ) != ( BaseType_t ) tcpperfRPC_MESSAGE_SIZE )
+        {
+            break;
+        }
+
+        for( uxDone = 0U; uxDone < tcpperfRPC_MESSAGE_SIZE; uxDone += ( size_t ) xResult )
+        {
+            xResult = FreeRTOS_recv( xSocket, ucClientBuffer + tcpperfRPC_MESSAGE_SIZE + uxDone, tcpperfRPC_MESSAGE_SIZE - uxDone, 0 );
+
+            if( xResult <= 0 )
+            {
+                break;
+            }
+        }
+
+        if( uxDone < tcpperfRPC_MESSAGE_SIZE )
+        {
+            break;
+        }
+
+        ullLatencies[ ulCount ] = prvNanoseconds( CLOCK_MONOTONIC ) - ullTransactionStart;
+    }
+
+    ullDuration = prvNanoseconds( CLOCK_MONOTONIC ) - ullStart;
+    prvCloseSocket( xSocket );
+
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( tcpperfRPC_TRANSACTIONS, ulCount, "A transaction failed" );
+
+    prvReportMetric( "small_message_rpc", "transactions_per_s",
+                     ( ( double ) ulCount * 1.0e9 ) / ( double ) ullDuration, "1/s", "higher" );
+    prvReportMetric( "small_message_rpc", "latency_p50_us",
+                     ( double ) prvPercentile( ullLatencies, ulCount, 500U ) / 1000.0, "us", "lower" );
+    prvReportMetric( "small_message_rpc", "latency_p99_us",
+                     ( double ) prvPercentile( ullLatencies, ulCount, 990U ) / 1000.0, "us", "lower" );
+    prvReportMetric( "small_message_rpc", "latency_p999_us",
+                     ( double ) prvPercentile( ullLatencies, ulCount, 999U ) / 1000.0, "us", "lower" );
+}
+
+TEST( Full_FREERTOS_TCP_Performance, LossRecovery )
+{
+    TCPPerfBulkResult_t xResult;
+    SimLinkStats_t xForward, xBackward;
+    BaseType_t xPassed;
+
+    prvSetLinkLoss( tcpperfLOSS_PPM, tcpperfLOSS_LATENCY_US );
+    xPassed = prvRunBulk( ( uint64_t ) tcpperfLOSS_MEGABYTES * 1024U * 1024U, &xResult );
+    xSimLinkGetStats( simLINK_PORT_0, &xForward, pdFALSE );
+    xSimLinkGetStats( simLINK_PORT_1, &xBackward, pdFALSE );
+
+    TEST_ASSERT_MESSAGE( xPassed == pdPASS, "The transfer over the lossy link did not complete" );
+    TEST_ASSERT_TRUE( xResult.ullBytesReceived == xResult.ullBytesSent );
+
+    prvReportMetric( "loss_recovery", "throughput_mbps",
+                     ( ( double ) xResult.ullBytesReceived * 8.0 * 1000.0 ) / ( double ) xResult.ullDurationNs, "Mbit/s", "higher" );
+    prvReportMetric( "loss_recovery", "max_stall_ms",
+                     ( double ) xResult.ullMaxStallNs / 1.0e6, "ms", "lower" );
+    prvReportMetric( "loss_recovery", "frames_lost",
+                     ( double ) ( xForward.ulLost + xBackward.ulLost ), "frames", "info" );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvStartServers( void )
+{
+    static BaseType_t xStarted = pdFALSE;
+    TickType_t xStartTime;
+
+    if( xStarted == pdFALSE )
+    {
+        xStarted = pdTRUE;
+        xTaskCreate( prvSinkServerTask, "PerfSink", tcpperfTASK_STACK_SIZE, NULL, tcpperfTASK_PRIORITY, NULL );
+        xTaskCreate( prvRPCServerTask, "PerfRPC", tcpperfTASK_STACK_SIZE, NULL, tcpperfTASK_PRIORITY, NULL );
+    }
+
+    xStartTime = xTaskGetTickCount();
+
+    while( ( ( xSinkReady == pdFALSE ) || ( xRPCReady == pdFALSE ) ) &&
+           ( ( xTaskGetTickCount() - xStartTime ) < tcpperfTIMEOUT ) )
+    {
+        vTaskDelay( pdMS_TO_TICKS( 10U ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvSelectServerStack( void )
+{
+    FreeRTOS_SetIPStack( tcpperfSERVER_STACK );
+
+    while( FreeRTOS_IsNetworkUp() == pdFALSE )
+    {
+        vTaskDelay( pdMS_TO_TICKS( 10U ) );
+    }
+
+    ulServerAddress = FreeRTOS_GetIPAddress();
+}
+/*-----------------------------------------------------------*/
+
+static void prvSinkServerTask( void * pvParameters )
+{
+    Socket_t xListeningSocket, xNewSocket;
+    Socket_t xSockets[ tcpperfSINK_SOCKETS ];
+    struct freertos_sockaddr xBindAddress, xClient;
+    socklen_t xSize = sizeof( xClient );
+    const TickType_t xNoTimeOut = 0U;
+    SocketSet_t xSocketSet;
+    UBaseType_t uxIndex;
+    BaseType_t xResult;
+
+    ( void ) pvParameters;
+
+    prvSelectServerStack();
+    memset( xSockets, 0, sizeof( xSockets ) );
+
+    xSocketSet = FreeRTOS_CreateSocketSet();
+    xListeningSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+    configASSERT( ( xSocketSet != NULL ) && ( xListeningSocket != FREERTOS_INVALID_SOCKET ) );
+
+    /* accept() is only called when select() reported a connection. */
+    prvSetWindowProperties( xListeningSocket );
+    FreeRTOS_setsockopt( xListeningSocket, 0, FREERTOS_SO_RCVTIMEO, &xNoTimeOut, sizeof( xNoTimeOut ) );
+
+    xBindAddress.sin_port = FreeRTOS_htons( tcpperfSINK_PORT );
+    xBindAddress.sin_addr = 0U;
+    FreeRTOS_bind( xListeningSocket, &xBindAddress, sizeof( xBindAddress ) );
+    FreeRTOS_listen( xListeningSocket, ( BaseType_t ) tcpperfSINK_SOCKETS );
+    FreeRTOS_FD_SET( xListeningSocket, xSocketSet, eSELECT_READ );
+    xSinkReady = pdTRUE;
+
+    for( ; ; )
+    {
+        ( void ) FreeRTOS_select( xSocketSet, portMAX_DELAY );
+
+        if( FreeRTOS_FD_ISSET( xListeningSocket, xSocketSet ) != 0U )
+        {
+            xNewSocket = FreeRTOS_accept( xListeningSocket, &xClient, &xSize );
+
+            if( ( xNewSocket != NULL ) && ( xNewSocket != FREERTOS_INVALID_SOCKET ) )
+            {
+                for( uxIndex = 0U; uxIndex < tcpperfSINK_SOCKETS; uxIndex++ )
+                {
+                    if( xSockets[ uxIndex ] == NULL )
+                    {
+                        break;
+                    }
+                }
+
+                if( uxIndex < tcpperfSINK_SOCKETS )
+                {
+                    xSockets[ uxIndex ] = xNewSocket;
+                    /* A connection without data is only reported as closed by
+                     * an exception. */
+                    FreeRTOS_FD_SET( xNewSocket, xSocketSet, ( EventBits_t ) eSELECT_READ | ( EventBits_t ) eSELECT_EXCEPT );
+                    ulSinkAccepted++;
+                    uxSinkOpen++;
+                }
+                else
+                {
+                    prvCloseSocket( xNewSocket );
+                }
+            }
+        }
+
+        for( uxIndex = 0U; uxIndex < tcpperfSINK_SOCKETS; uxIndex++ )
+        {
+            if( ( xSockets[ uxIndex ] == NULL ) || ( FreeRTOS_FD_ISSET( xSockets[ uxIndex ], xSocketSet ) == 0U ) )
+            {
+                continue;
+            }
+
+            for( ; ; )
+            {
+                xResult = FreeRTOS_recv( xSockets[ uxIndex ], ucSinkBuffer, sizeof( ucSinkBuffer ), FREERTOS_MSG_DONTWAIT );
+
+                if( xResult > 0 )
+                {
+                    ullSinkReceived += ( uint64_t ) xResult;
+                }
+                else
+                {
+                    if( xResult < 0 )
+                    {
+                        /* The client has shut down the connection. */
+                        FreeRTOS_FD_CLR( xSockets[ uxIndex ], xSocketSet, eSELECT_ALL );
+                        prvCloseSocket( xSockets[ uxIndex ] );
+                        xSockets[ uxIndex ] = NULL;
+                        uxSinkOpen--;
+                    }
+
+                    break;
+                }
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRPCServerTask( void * pvParameters )
+{
+    Socket_t xListeningSocket, xSocket;
+    struct freertos_sockaddr xBindAddress, xClient;
+    socklen_t xSize = sizeof( xClient );
+    BaseType_t xResult = 0;
+    size_t uxDone;
+
+    ( void ) pvParameters;
+
+    prvSelectServerStack();
+
+    xListeningSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+    configASSERT( xListeningSocket != FREERTOS_INVALID_SOCKET );
+
+    xBindAddress.sin_port = FreeRTOS_htons( tcpperfRPC_PORT );
+    xBindAddress.sin_addr = 0U;
+    FreeRTOS_bind( xListeningSocket, &xBindAddress, sizeof( xBindAddress ) );
+    FreeRTOS_listen( xListeningSocket, 1 );
+    xRPCReady = pdTRUE;
+
+    for( ; ; )
+    {
+        xSocket = FreeRTOS_accept( xListeningSocket, &xClient, &xSize );
+
+        if( ( xSocket == NULL ) || ( xSocket == FREERTOS_INVALID_SOCKET ) )
+        {
+            continue;
+        }
+
+        /* Echo every message until the client closes the connection. */
+        for( ; ; )
+        {
+            for( uxDone = 0U; uxDone < tcpperfRPC_MESSAGE_SIZE; uxDone += ( size_t ) xResult )
+            {
+                xResult = FreeRTOS_recv( xSocket, ucRPCBuffer + uxDone, tcpperfRPC_MESSAGE_SIZE - uxDone, 0 );
+
+                if( xResult <= 0 )
+                {
+                    break;
+                }
+            }
+
+            if( ( uxDone < tcpperfRPC_MESSAGE_SIZE ) ||
+                ( FreeRTOS_send( xSocket, ucRPCBuffer, tcpperfRPC_MESSAGE_SIZE, 0 ) != ( BaseType_t ) tcpperfRPC_MESSAGE_SIZE ) )
+            {
+                break;
+            }
+        }
+
+        prvCloseSocket( xSocket );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static Socket_t prvConnect( uint16_t usPort,
+                            BaseType_t xBulk )
+{
+    Socket_t xSocket;
+    struct freertos_sockaddr xServerAddress;
+    const TickType_t xTimeOut = tcpperfTIMEOUT;
+
+    xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+    if( xSocket == FREERTOS_INVALID_SOCKET )
+    {
+        return NULL;
+    }
+
+    if( xBulk != pdFALSE )
+    {
+        prvSetWindowProperties( xSocket );
+    }
+
+    FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+    FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+    xServerAddress.sin_port = FreeRTOS_htons( usPort );
+    xServerAddress.sin_addr = ulServerAddress;
+
+    if( FreeRTOS_connect( xSocket, &xServerAddress, sizeof( xServerAddress ) ) != 0 )
+    {
+        FreeRTOS_closesocket( xSocket );
+        xSocket = NULL;
+    }
+
+    return xSocket;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetWindowProperties( Socket_t xSocket )
+{
+    WinProperties_t xWinProperties;
+
+    memset( &xWinProperties, 0, sizeof( xWinProperties ) );
+    xWinProperties.lTxBufSize = tcpperfTCP_BUFFER_SEGMENTS * ipconfigTCP_MSS;
+    xWinProperties.lTxWinSize = tcpperfTCP_WINDOW_SEGMENTS;
+    xWinProperties.lRxBufSize = tcpperfTCP_BUFFER_SEGMENTS * ipconfigTCP_MSS;
+    xWinProperties.lRxWinSize = tcpperfTCP_WINDOW_SEGMENTS;
+    FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_WIN_PROPERTIES, &xWinProperties, sizeof( xWinProperties ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCloseSocket( Socket_t xSocket )
+{
+    FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+    FreeRTOS_closesocket( xSocket );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRunBulk( uint64_t ullBytes,
+                              TCPPerfBulkResult_t * pxResult )
+{
+    Socket_t xSocket;
+    SocketSet_t xSocketSet;
+    uint64_t ullFirst, ullSeen, ullStart, ullCPUStart, ullLastProgress, ullNow, ullRemaining = ullBytes;
+    BaseType_t xResult;
+    size_t uxLength;
+
+    memset( pxResult, 0, sizeof( *pxResult ) );
+    memset( ucClientBuffer, 0xa5, sizeof( ucClientBuffer ) );
+
+    xSocket = prvConnect( tcpperfSINK_PORT, pdTRUE );
+    xSocketSet = FreeRTOS_CreateSocketSet();
+
+    if( ( xSocket == NULL ) || ( xSocketSet == NULL ) )
+    {
+        if( xSocket != NULL )
+        {
+            prvCloseSocket( xSocket );
+        }
+
+        return pdFAIL;
+    }
+
+    FreeRTOS_FD_SET( xSocket, xSocketSet, eSELECT_WRITE );
+
+    ullFirst = ullSinkReceived;
+    ullSeen = ullFirst;
+    ullCPUStart = prvNanoseconds( CLOCK_PROCESS_CPUTIME_ID );
+    ullStart = prvNanoseconds( CLOCK_MONOTONIC );
+    ullLastProgress = ullStart;
+
+    /* Send while there is space, and note the longest time in which the sink
+     * received nothing.  The select() time-out makes sure that the sink is
+     * also watched while the window is closed. */
+    for( ; ; )
+    {
+        if( ullRemaining > 0U )
+        {
+            ( void ) FreeRTOS_select( xSocketSet, pdMS_TO_TICKS( 10U ) );
+
+            uxLength = ( ullRemaining < sizeof( ucClientBuffer ) ) ? ( size_t ) ullRemaining : sizeof( ucClientBuffer );
+            xResult = FreeRTOS_send( xSocket, ucClientBuffer, uxLength, FREERTOS_MSG_DONTWAIT );
+
+            if( xResult > 0 )
+            {
+                ullRemaining -= ( uint64_t ) xResult;
+                pxResult->ullBytesSent += ( uint64_t ) xResult;
+            }
+            else if( xResult != -pdFREERTOS_ERRNO_ENOSPC )
+            {
+                /* The connection was lost. */
+                break;
+            }
+        }
+        else
+        {
+            vTaskDelay( 1U );
+        }
+
+        ullNow = prvNanoseconds( CLOCK_MONOTONIC );
+
+        if( ullSinkReceived != ullSeen )
+        {
+            ullSeen = ullSinkReceived;
+            ullLastProgress = ullNow;
+        }
+        else if( ( ullNow - ullLastProgress ) > pxResult->ullMaxStallNs )
+        {
+            pxResult->ullMaxStallNs = ullNow - ullLastProgress;
+        }
+
+        if( ( ullRemaining == 0U ) && ( ( ullSeen - ullFirst ) >= pxResult->ullBytesSent ) )
+        {
+            break;
+        }
+
+        if( ( ullNow - ullLastProgress ) > ( ( uint64_t ) tcpperfTIMEOUT * portTICK_PERIOD_MS * 1000000U ) )
+        {
+            break;
+        }
+    }
+
+    pxResult->ullDurationNs = prvNanoseconds( CLOCK_MONOTONIC ) - ullStart;
+    pxResult->ullCPUTimeNs = prvNanoseconds( CLOCK_PROCESS_CPUTIME_ID ) - ullCPUStart;
+    pxResult->ullBytesReceived = ullSinkReceived - ullFirst;
+
+    prvCloseSocket( xSocket );
+    FreeRTOS_DeleteSocketSet( xSocketSet );
+
+    return ( ( ullRemaining == 0U ) && ( pxResult->ullBytesReceived == ullBytes ) ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetLinkLoss( uint32_t ulLossPPM,
+                            uint32_t ulLatencyUs )
+{
+    SimLinkParameters_t xParameters;
+    SimLinkStats_t xStats;
+
+    memset( &xParameters, 0, sizeof( xParameters ) );
+    xParameters.ulLossPPM = ulLossPPM;
+    xParameters.ulLatencyUs = ulLatencyUs;
+
+    xParameters.ulSeed = 1U;
+    xSimLinkSetParameters( simLINK_PORT_0, &xParameters );
+    xParameters.ulSeed = 2U;
+    xSimLinkSetParameters( simLINK_PORT_1, &xParameters );
+
+    xSimLinkGetStats( simLINK_PORT_0, &xStats, pdTRUE );
+    xSimLinkGetStats( simLINK_PORT_1, &xStats, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNanoseconds( clockid_t xClock )
+{
+    struct timespec xNow;
+
+    clock_gettime( xClock, &xNow );
+
+    return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvPercentile( uint64_t * pullValues,
+                               size_t uxCount,
+                               uint32_t ulPerMille )
+{
+    if( uxCount == 0U )
+    {
+        return 0U;
+    }
+
+    qsort( pullValues, uxCount, sizeof( pullValues[ 0 ] ), prvCompareValues );
+
+    return pullValues[ ( uxCount * ulPerMille ) / 1000U ];
+}
+/*-----------------------------------------------------------*/
+
+static int prvCompareValues( const void * pvLeft,
+                             const void * pvRight )
+{
+    uint64_t ullLeft = *( ( const uint64_t * ) pvLeft );
+    uint64_t ullRight = *( ( const uint64_t * ) pvRight );
+
+    return ( ullLeft > ullRight ) - ( ullLeft < ullRight );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReportMetric( const char * pcScenario,
+                             const char * pcMetric,
+                             double dValue,
+                             const char * pcUnit,
+                             const char * pcBetter )
+{
+    const char * pcFileName;
+
+    printf( "tcpperf: %-18s %-20s %14.3f %s\n", pcScenario, pcMetric, dValue, pcUnit );
+
+    if( pxMetricsFile == NULL )
+    {
+        pcFileName = getenv( "TCP_PERF_METRICS" );
+
+        if( pcFileName == NULL )
+        {
+            return;
+        }
+
+        pxMetricsFile = fopen( pcFileName, "w" );
+
+        if( pxMetricsFile == NULL )
+        {
+            printf( "tcpperf: cannot write %s\n", pcFileName );
+            return;
+        }
+
+        fprintf( pxMetricsFile, "scenario,metric,value,unit,better\n" );
+    }
+
+    fprintf( pxMetricsFile, "%s,%s,%.3f,%s,%s\n", pcScenario, pcMetric, dValue, pcUnit, pcBetter );
+    fflush( pxMetricsFile );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCloseMetrics( void )
+{
+    if( pxMetricsFile != NULL )
+    {
+        fclose( pxMetricsFile );
+        pxMetricsFile = NULL;
+    }
+}
+
+#endif /* testrunnerFULL_TCP_PERFORMANCE_ENABLED */
@@ -31,6 +31,9 @@
   /* Test runner interface includes. */
 #include "test_runner.h"
 
+/* Standard includes. */
+#include <stdlib.h>
+
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 #include "task.h"
@@ -53,11 +56,17 @@ unsigned int xHeapAfter;
 static void RunTests(void)
 {
     RUN_TEST_GROUP(Full_FREERTOS_TCP);
+
+#if ( testrunnerFULL_TCP_PERFORMANCE_ENABLED == 1 )
+    RUN_TEST_GROUP(Full_FREERTOS_TCP_Performance);
+#endif
 }
 /*-----------------------------------------------------------*/
 
 void TEST_RUNNER_RunTests_task(void* pvParameters)
 {
+    int iFailures;
+
     /* Disable unused parameter warning. */
     (void)pvParameters;
 
@@ -95,12 +104,19 @@ void TEST_RUNNER_RunTests_task(void* pvParameters)
 #endif /* if ( testrunnerFULL_MEMORYLEAK_ENABLED == 1 ) */
 
     /* Currently disabled. Will be enabled after cleanup. */
-    UNITY_END();
+    iFailures = UNITY_END();
 
 #ifdef CODE_COVERAGE
     exit(0);
 #endif
 
+#if ( testrunnerEXIT_WHEN_DONE == 1 )
+    /* Let a script that runs the tests see whether they passed. */
+    exit((iFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+#else
+    (void)iFailures;
+#endif
+
     /* This task has finished.  FreeRTOS does not allow a task to run off the
      * end of its implementing function, so the task must be deleted. */
     vTaskDelete(NULL);
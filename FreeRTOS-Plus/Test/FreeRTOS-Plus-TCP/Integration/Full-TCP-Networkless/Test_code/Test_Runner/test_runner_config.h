@@ -66,6 +66,18 @@
 #define testrunnerUTIL_PLATFORM_THREADS_ENABLED       0
 #define testrunnerFULL_HTTPS_CLIENT_ENABLED           0
 
+/* The timed scenarios of test_freertos_tcp_performance.c need two IP-stacks
+ * on the simulated link, so they are only enabled by the Posix build. */
+#ifndef testrunnerFULL_TCP_PERFORMANCE_ENABLED
+#define testrunnerFULL_TCP_PERFORMANCE_ENABLED        0
+#endif
+
+/* Set to 1 to end the process when the tests are done, with a failure exit
+ * status when a test failed. */
+#ifndef testrunnerEXIT_WHEN_DONE
+#define testrunnerEXIT_WHEN_DONE                      0
+#endif
+
 /* On systems using FreeRTOS+TCP (such as this one) the TCP segments must be
  * cleaned up before running the memory leak check. */
 #if ( testrunnerFULL_MEMORYLEAK_ENABLED == 1 )
@@ -0,0 +1,79 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/*-----------------------------------------------------------
+ * Application specific definitions.
+ *
+ * The microbenchmark does not run the scheduler: it links the FreeRTOS+TCP
+ * sources with the single-threaded kernel stubs of kernel_stubs.c, and drives
+ * the stack from main() as if it were the IP-task.  Only the definitions that
+ * the kernel headers and the stubs need are present.
+ *
+ * THESE PARAMETERS ARE DESCRIBED WITHIN THE 'CONFIGURATION' SECTION OF THE
+ * FreeRTOS API DOCUMENTATION AVAILABLE ON THE FreeRTOS.org WEB SITE.  See
+ * http://www.freertos.org/a00110.html
+ *----------------------------------------------------------*/
+
+#define configUSE_PREEMPTION					1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION	0
+#define configUSE_IDLE_HOOK						0
+#define configUSE_TICK_HOOK						0
+#define configTICK_RATE_HZ						( 1000 )
+#define configMINIMAL_STACK_SIZE				( ( unsigned short ) 70 )
+#define configTOTAL_HEAP_SIZE					( ( size_t ) ( 1024 * 1024 ) )
+#define configMAX_TASK_NAME_LEN					( 12 )
+#define configUSE_TRACE_FACILITY				0
+#define configUSE_16_BIT_TICKS					0
+#define configUSE_MUTEXES						1
+#define configUSE_RECURSIVE_MUTEXES				0
+#define configQUEUE_REGISTRY_SIZE				0
+#define configUSE_COUNTING_SEMAPHORES			1
+#define configUSE_QUEUE_SETS					0
+#define configUSE_TASK_NOTIFICATIONS			1
+#define configSUPPORT_DYNAMIC_ALLOCATION		1
+#define configSUPPORT_STATIC_ALLOCATION			0
+#define configUSE_TIMERS						0
+#define configUSE_CO_ROUTINES					0
+#define configGENERATE_RUN_TIME_STATS			0
+#define configMAX_PRIORITIES					( 7 )
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS	1
+
+#define INCLUDE_vTaskDelete						1
+#define INCLUDE_vTaskDelay						1
+#define INCLUDE_vTaskDelayUntil					1
+#define INCLUDE_xTaskGetCurrentTaskHandle		1
+#define INCLUDE_xTaskGetSchedulerState			1
+#define INCLUDE_uxTaskPriorityGet				1
+
+/* An assertion that fails stops the benchmark with the file and line. */
+extern void vAssertCalled( const char * const pcFileName, unsigned long ulLine );
+#define configASSERT( x ) if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ )
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,96 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*****************************************************************************
+ *
+ * See the following URL for configuration information.
+ * http://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Configuration.html
+ *
+ * The configuration of the microbenchmark.  Checksums are computed in
+ * software and the Ethernet driver does not filter frames, so that every stage
+ * that is measured is really executed.
+ *
+ *****************************************************************************/
+
+#ifndef FREERTOS_IP_CONFIG_H
+#define FREERTOS_IP_CONFIG_H
+
+/* Printing would dominate the measurements. */
+#define ipconfigHAS_DEBUG_PRINTF				0
+#define ipconfigHAS_PRINTF						0
+
+#define ipconfigBYTE_ORDER						pdFREERTOS_LITTLE_ENDIAN
+
+/* Verify and calculate the checksums in software. */
+#define ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM	0
+#define ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM	0
+
+/* Let eConsiderFrameForProcessing() look at every frame. */
+#define ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES	0
+#define ipconfigETHERNET_DRIVER_FILTERS_PACKETS		0
+
+/* The addresses are static, and no name services are used. */
+#define ipconfigUSE_DHCP						0
+#define ipconfigUSE_DNS							0
+#define ipconfigUSE_LLMNR						0
+#define ipconfigUSE_NBNS						0
+#define ipconfigUSE_NETWORK_EVENT_HOOK			0
+
+#define ipconfigUSE_TCP							1
+#define ipconfigUSE_TCP_WIN						1
+#define ipconfigTCP_MSS							1460
+#define ipconfigNETWORK_MTU						1500
+#define ipconfigTCP_RX_BUFFER_LENGTH			( 64U * 1024U )
+#define ipconfigTCP_TX_BUFFER_LENGTH			( 64U * 1024U )
+#define ipconfigTCP_WIN_SEG_COUNT				256
+
+/* The UDP stages deliver their packets to a receive handler, which frees
+them at once. */
+#define ipconfigUSE_CALLBACKS					1
+
+#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS	64
+#define ipconfigEVENT_QUEUE_LENGTH				( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
+#define ipconfigARP_CACHE_ENTRIES				16
+#define ipconfigMAX_ARP_AGE						150
+#define ipconfigMAX_ARP_RETRANSMISSIONS			5
+
+#define ipconfigIP_TASK_PRIORITY				( configMAX_PRIORITIES - 2 )
+#define ipconfigIP_TASK_STACK_SIZE_WORDS		( configMINIMAL_STACK_SIZE * 5 )
+
+#define ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND	1
+#define ipconfigSUPPORT_SELECT_FUNCTION			0
+#define ipconfigSUPPORT_OUTGOING_PINGS			0
+#define ipconfigREPLY_TO_INCOMING_PINGS			1
+#define ipconfigCAN_FRAGMENT_OUTGOING_PACKETS	0
+#define ipconfigUDP_TIME_TO_LIVE				128
+#define ipconfigTCP_TIME_TO_LIVE				128
+#define ipconfigUSE_LINKED_RX_MESSAGES			0
+#define ipconfigZERO_COPY_RX_DRIVER				0
+#define ipconfigZERO_COPY_TX_DRIVER				0
+#define ipconfigPACKET_FILLER_SIZE				2U
+
+#endif /* FREERTOS_IP_CONFIG_H */
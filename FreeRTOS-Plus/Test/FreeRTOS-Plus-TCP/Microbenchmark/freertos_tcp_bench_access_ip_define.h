@@ -0,0 +1,47 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/*
+ * Included at the end of FreeRTOS_IP.c when FREERTOS_TCP_ENABLE_BENCHMARK is
+ * defined, so that the microbenchmark can call the static functions that
+ * handle a received frame.
+ */
+
+#ifndef FREERTOS_TCP_BENCH_ACCESS_IP_DEFINE_H
+#define FREERTOS_TCP_BENCH_ACCESS_IP_DEFINE_H
+
+eFrameProcessingResult_t publicProcessIPPacket( IPPacket_t * pxIPPacket, NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+	return prvProcessIPPacket( pxIPPacket, pxNetworkBuffer );
+}
+/*-----------------------------------------------------------*/
+
+void publicProcessEthernetPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+	prvProcessEthernetPacket( pxNetworkBuffer );
+}
+/*-----------------------------------------------------------*/
+
+#endif /* FREERTOS_TCP_BENCH_ACCESS_IP_DEFINE_H */
@@ -0,0 +1,752 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/*
+ * A single-threaded implementation of the kernel API that FreeRTOS+TCP uses,
+ * linked instead of tasks.c, queue.c and event_groups.c.  The benchmark calls
+ * the stack directly, so there is never another task that could give a
+ * semaphore or fill a queue: every call returns at once, as if its block time
+ * had been zero.  The kernel's list.c is linked as it is.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+
+#include "stubs.h"
+
+/* The most tasks that can be created. */
+#define stubMAX_TASKS		8
+
+struct tskTaskControlBlock
+{
+	const char *pcName;					/* NULL while the entry is not in use. */
+	UBaseType_t uxPriority;
+	uint32_t ulNotifiedValue;
+	BaseType_t xNotifyPending;
+	void *pvThreadLocalStoragePointers[ configNUM_THREAD_LOCAL_STORAGE_POINTERS ];
+};
+
+/* Queues and semaphores.  A semaphore is a queue with items of zero bytes,
+'uxCount' is then the count of the semaphore. */
+struct QueueDefinition
+{
+	uint8_t *pucStorage;
+	UBaseType_t uxLength;
+	UBaseType_t uxItemSize;
+	UBaseType_t uxHead;					/* The index of the oldest item. */
+	UBaseType_t uxCount;
+	uint8_t ucQueueType;
+};
+
+struct EventGroupDef_t
+{
+	EventBits_t uxEventBits;
+};
+
+static struct tskTaskControlBlock xTasks[ stubMAX_TASKS ];
+static TaskHandle_t pxCurrentTCB = NULL;
+static UBaseType_t uxSchedulerSuspended = 0U;
+
+/*-----------------------------------------------------------*/
+
+void vStubSetCurrentTask( TaskHandle_t xTask )
+{
+	pxCurrentTCB = xTask;
+}
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char * const pcFileName, unsigned long ulLine )
+{
+	fprintf( stderr, "microbench: assertion failed in %s:%lu\n", pcFileName, ulLine );
+	abort();
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Tasks.
+ */
+
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode,
+						const char * const pcName,
+						const configSTACK_DEPTH_TYPE usStackDepth,
+						void * const pvParameters,
+						UBaseType_t uxPriority,
+						TaskHandle_t * const pxCreatedTask )
+{
+BaseType_t xReturn = errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+size_t uxIndex;
+
+	/* The task is never run: the benchmark does its work. */
+	( void ) pxTaskCode;
+	( void ) usStackDepth;
+	( void ) pvParameters;
+
+	for( uxIndex = 0U; uxIndex < stubMAX_TASKS; uxIndex++ )
+	{
+		if( xTasks[ uxIndex ].pcName == NULL )
+		{
+			memset( &( xTasks[ uxIndex ] ), 0, sizeof( xTasks[ uxIndex ] ) );
+			xTasks[ uxIndex ].pcName = pcName;
+			xTasks[ uxIndex ].uxPriority = uxPriority;
+			if( pxCreatedTask != NULL )
+			{
+				*pxCreatedTask = &( xTasks[ uxIndex ] );
+			}
+			xReturn = pdPASS;
+			break;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelete( TaskHandle_t xTaskToDelete )
+{
+TaskHandle_t xTask = ( xTaskToDelete != NULL ) ? xTaskToDelete : pxCurrentTCB;
+
+	if( xTask != NULL )
+	{
+		xTask->pcName = NULL;
+		if( xTask == pxCurrentTCB )
+		{
+			pxCurrentTCB = NULL;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelay( const TickType_t xTicksToDelay )
+{
+	/* There is nothing else to run. */
+	( void ) xTicksToDelay;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelayUntil( TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement )
+{
+	*pxPreviousWakeTime += xTimeIncrement;
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCount( void )
+{
+static uint64_t ullStartNs = 0U;
+struct timespec xNow;
+uint64_t ullNowNs;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	ullNowNs = ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+	if( ullStartNs == 0U )
+	{
+		ullStartNs = ullNowNs;
+	}
+
+	return ( TickType_t ) ( ( ( ullNowNs - ullStartNs ) * configTICK_RATE_HZ ) / 1000000000ULL );
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCountFromISR( void )
+{
+	return xTaskGetTickCount();
+}
+/*-----------------------------------------------------------*/
+
+void vTaskSuspendAll( void )
+{
+	uxSchedulerSuspended++;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskResumeAll( void )
+{
+	configASSERT( uxSchedulerSuspended != 0U );
+	uxSchedulerSuspended--;
+
+	/* No task was woken up. */
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskGetSchedulerState( void )
+{
+	return ( uxSchedulerSuspended != 0U ) ? taskSCHEDULER_SUSPENDED : taskSCHEDULER_RUNNING;
+}
+/*-----------------------------------------------------------*/
+
+TaskHandle_t xTaskGetCurrentTaskHandle( void )
+{
+	return pxCurrentTCB;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxTaskPriorityGet( const TaskHandle_t xTask )
+{
+TaskHandle_t xTarget = ( xTask != NULL ) ? xTask : pxCurrentTCB;
+
+	return ( xTarget != NULL ) ? xTarget->uxPriority : tskIDLE_PRIORITY;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxTaskGetNumberOfTasks( void )
+{
+UBaseType_t uxCount = 0U;
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < stubMAX_TASKS; uxIndex++ )
+	{
+		if( xTasks[ uxIndex ].pcName != NULL )
+		{
+			uxCount++;
+		}
+	}
+
+	return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+char *pcTaskGetName( TaskHandle_t xTaskToQuery )
+{
+TaskHandle_t xTask = ( xTaskToQuery != NULL ) ? xTaskToQuery : pxCurrentTCB;
+
+	return ( xTask != NULL ) ? ( char * ) xTask->pcName : "main";
+}
+/*-----------------------------------------------------------*/
+
+void vTaskSetThreadLocalStoragePointer( TaskHandle_t xTaskToSet, BaseType_t xIndex, void *pvValue )
+{
+TaskHandle_t xTask = ( xTaskToSet != NULL ) ? xTaskToSet : pxCurrentTCB;
+
+	if( ( xTask != NULL ) && ( xIndex >= 0 ) && ( xIndex < configNUM_THREAD_LOCAL_STORAGE_POINTERS ) )
+	{
+		xTask->pvThreadLocalStoragePointers[ xIndex ] = pvValue;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void *pvTaskGetThreadLocalStoragePointer( TaskHandle_t xTaskToQuery, BaseType_t xIndex )
+{
+TaskHandle_t xTask = ( xTaskToQuery != NULL ) ? xTaskToQuery : pxCurrentTCB;
+void *pvReturn = NULL;
+
+	if( ( xTask != NULL ) && ( xIndex >= 0 ) && ( xIndex < configNUM_THREAD_LOCAL_STORAGE_POINTERS ) )
+	{
+		pvReturn = xTask->pvThreadLocalStoragePointers[ xIndex ];
+	}
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskGenericNotify( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue )
+{
+BaseType_t xReturn = pdPASS;
+
+	configASSERT( xTaskToNotify != NULL );
+
+	if( pulPreviousNotificationValue != NULL )
+	{
+		*pulPreviousNotificationValue = xTaskToNotify->ulNotifiedValue;
+	}
+
+	switch( eAction )
+	{
+		case eSetBits:
+			xTaskToNotify->ulNotifiedValue |= ulValue;
+			break;
+
+		case eIncrement:
+			xTaskToNotify->ulNotifiedValue++;
+			break;
+
+		case eSetValueWithOverwrite:
+			xTaskToNotify->ulNotifiedValue = ulValue;
+			break;
+
+		case eSetValueWithoutOverwrite:
+			if( xTaskToNotify->xNotifyPending == pdFALSE )
+			{
+				xTaskToNotify->ulNotifiedValue = ulValue;
+			}
+			else
+			{
+				xReturn = pdFAIL;
+			}
+			break;
+
+		case eNoAction:
+		default:
+			break;
+	}
+
+	xTaskToNotify->xNotifyPending = pdTRUE;
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskGenericNotifyFromISR( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	if( pxHigherPriorityTaskWoken != NULL )
+	{
+		*pxHigherPriorityTaskWoken = pdFALSE;
+	}
+
+	return xTaskGenericNotify( xTaskToNotify, ulValue, eAction, pulPreviousNotificationValue );
+}
+/*-----------------------------------------------------------*/
+
+void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	( void ) xTaskGenericNotifyFromISR( xTaskToNotify, 0U, eIncrement, NULL, pxHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskNotifyWait( uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait )
+{
+TaskHandle_t xTask = pxCurrentTCB;
+BaseType_t xReturn = pdFALSE;
+
+	( void ) xTicksToWait;
+	configASSERT( xTask != NULL );
+
+	if( xTask->xNotifyPending == pdFALSE )
+	{
+		xTask->ulNotifiedValue &= ~ulBitsToClearOnEntry;
+	}
+
+	if( pulNotificationValue != NULL )
+	{
+		*pulNotificationValue = xTask->ulNotifiedValue;
+	}
+
+	if( xTask->xNotifyPending != pdFALSE )
+	{
+		xTask->ulNotifiedValue &= ~ulBitsToClearOnExit;
+		xTask->xNotifyPending = pdFALSE;
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait )
+{
+TaskHandle_t xTask = pxCurrentTCB;
+uint32_t ulReturn;
+
+	( void ) xTicksToWait;
+	configASSERT( xTask != NULL );
+
+	ulReturn = xTask->ulNotifiedValue;
+	if( ulReturn != 0U )
+	{
+		xTask->ulNotifiedValue = ( xClearCountOnExit != pdFALSE ) ? 0U : ( ulReturn - 1U );
+	}
+	xTask->xNotifyPending = pdFALSE;
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskSetTimeOutState( TimeOut_t * const pxTimeOut )
+{
+	pxTimeOut->xOverflowCount = 0;
+	pxTimeOut->xTimeOnEntering = xTaskGetTickCount();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskCheckForTimeOut( TimeOut_t * const pxTimeOut, TickType_t * const pxTicksToWait )
+{
+const TickType_t xElapsedTime = xTaskGetTickCount() - pxTimeOut->xTimeOnEntering;
+BaseType_t xReturn;
+
+	if( *pxTicksToWait == portMAX_DELAY )
+	{
+		xReturn = pdFALSE;
+	}
+	else if( xElapsedTime < *pxTicksToWait )
+	{
+		*pxTicksToWait -= xElapsedTime;
+		vTaskSetTimeOutState( pxTimeOut );
+		xReturn = pdFALSE;
+	}
+	else
+	{
+		*pxTicksToWait = 0U;
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Queues and semaphores.
+ */
+
+QueueHandle_t xQueueGenericCreate( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType )
+{
+QueueHandle_t xQueue;
+
+	xQueue = ( QueueHandle_t ) calloc( 1U, sizeof( *xQueue ) );
+	if( xQueue != NULL )
+	{
+		xQueue->uxLength = uxQueueLength;
+		xQueue->uxItemSize = uxItemSize;
+		xQueue->ucQueueType = ucQueueType;
+		if( uxItemSize != 0U )
+		{
+			xQueue->pucStorage = ( uint8_t * ) malloc( uxQueueLength * uxItemSize );
+			if( xQueue->pucStorage == NULL )
+			{
+				free( xQueue );
+				xQueue = NULL;
+			}
+		}
+	}
+
+	return xQueue;
+}
+/*-----------------------------------------------------------*/
+
+QueueHandle_t xQueueCreateMutex( const uint8_t ucQueueType )
+{
+QueueHandle_t xQueue = xQueueGenericCreate( 1U, 0U, ucQueueType );
+
+	/* A mutex is created in the available state. */
+	if( xQueue != NULL )
+	{
+		xQueue->uxCount = 1U;
+	}
+
+	return xQueue;
+}
+/*-----------------------------------------------------------*/
+
+QueueHandle_t xQueueCreateCountingSemaphore( const UBaseType_t uxMaxCount, const UBaseType_t uxInitialCount )
+{
+QueueHandle_t xQueue = xQueueGenericCreate( uxMaxCount, 0U, queueQUEUE_TYPE_COUNTING_SEMAPHORE );
+
+	if( xQueue != NULL )
+	{
+		xQueue->uxCount = uxInitialCount;
+	}
+
+	return xQueue;
+}
+/*-----------------------------------------------------------*/
+
+void vQueueDelete( QueueHandle_t xQueue )
+{
+	if( xQueue != NULL )
+	{
+		free( xQueue->pucStorage );
+		free( xQueue );
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueGenericReset( QueueHandle_t xQueue, BaseType_t xNewQueue )
+{
+	( void ) xNewQueue;
+
+	xQueue->uxHead = 0U;
+	xQueue->uxCount = 0U;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition )
+{
+UBaseType_t uxIndex;
+BaseType_t xReturn = pdPASS;
+
+	/* Waiting would not help, no other task will make space. */
+	( void ) xTicksToWait;
+	configASSERT( xQueue != NULL );
+
+	if( ( xCopyPosition == queueOVERWRITE ) && ( xQueue->uxCount == xQueue->uxLength ) )
+	{
+		/* Only used with queues of length 1: replace the item. */
+		xQueue->uxCount = 0U;
+	}
+
+	if( xQueue->uxCount >= xQueue->uxLength )
+	{
+		xReturn = errQUEUE_FULL;
+	}
+	else
+	{
+		if( ( xQueue->uxItemSize != 0U ) && ( pvItemToQueue != NULL ) )
+		{
+			if( xCopyPosition == queueSEND_TO_FRONT )
+			{
+				xQueue->uxHead = ( xQueue->uxHead + xQueue->uxLength - 1U ) % xQueue->uxLength;
+				uxIndex = xQueue->uxHead;
+			}
+			else
+			{
+				uxIndex = ( xQueue->uxHead + xQueue->uxCount ) % xQueue->uxLength;
+			}
+			memcpy( xQueue->pucStorage + ( uxIndex * xQueue->uxItemSize ), pvItemToQueue, xQueue->uxItemSize );
+		}
+		xQueue->uxCount++;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueGenericSendFromISR( QueueHandle_t xQueue, const void * const pvItemToQueue, BaseType_t * const pxHigherPriorityTaskWoken, const BaseType_t xCopyPosition )
+{
+	if( pxHigherPriorityTaskWoken != NULL )
+	{
+		*pxHigherPriorityTaskWoken = pdFALSE;
+	}
+
+	return xQueueGenericSend( xQueue, pvItemToQueue, 0U, xCopyPosition );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueGiveFromISR( QueueHandle_t xQueue, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+	return xQueueGenericSendFromISR( xQueue, NULL, pxHigherPriorityTaskWoken, queueSEND_TO_BACK );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvQueueTake( QueueHandle_t xQueue, void * const pvBuffer, BaseType_t xRemove )
+{
+BaseType_t xReturn = pdFALSE;
+
+	configASSERT( xQueue != NULL );
+
+	if( xQueue->uxCount != 0U )
+	{
+		if( ( xQueue->uxItemSize != 0U ) && ( pvBuffer != NULL ) )
+		{
+			memcpy( pvBuffer, xQueue->pucStorage + ( xQueue->uxHead * xQueue->uxItemSize ), xQueue->uxItemSize );
+		}
+		if( xRemove != pdFALSE )
+		{
+			xQueue->uxHead = ( xQueue->uxHead + 1U ) % xQueue->uxLength;
+			xQueue->uxCount--;
+		}
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait )
+{
+	( void ) xTicksToWait;
+
+	return prvQueueTake( xQueue, pvBuffer, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue, void * const pvBuffer, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+	if( pxHigherPriorityTaskWoken != NULL )
+	{
+		*pxHigherPriorityTaskWoken = pdFALSE;
+	}
+
+	return prvQueueTake( xQueue, pvBuffer, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueuePeek( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait )
+{
+	( void ) xTicksToWait;
+
+	return prvQueueTake( xQueue, pvBuffer, pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue, TickType_t xTicksToWait )
+{
+	( void ) xTicksToWait;
+
+	return prvQueueTake( xQueue, NULL, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue )
+{
+	return xQueue->uxCount;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueMessagesWaitingFromISR( const QueueHandle_t xQueue )
+{
+	return xQueue->uxCount;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue )
+{
+	return xQueue->uxLength - xQueue->uxCount;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Event groups.
+ */
+
+EventGroupHandle_t xEventGroupCreate( void )
+{
+	return ( EventGroupHandle_t ) calloc( 1U, sizeof( struct EventGroupDef_t ) );
+}
+/*-----------------------------------------------------------*/
+
+void vEventGroupDelete( EventGroupHandle_t xEventGroup )
+{
+	free( xEventGroup );
+}
+/*-----------------------------------------------------------*/
+
+EventBits_t xEventGroupWaitBits( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor, const BaseType_t xClearOnExit, const BaseType_t xWaitForAllBits, TickType_t xTicksToWait )
+{
+const EventBits_t uxReturn = xEventGroup->uxEventBits;
+BaseType_t xMatch;
+
+	( void ) xTicksToWait;
+
+	if( xWaitForAllBits != pdFALSE )
+	{
+		xMatch = ( ( uxReturn & uxBitsToWaitFor ) == uxBitsToWaitFor ) ? pdTRUE : pdFALSE;
+	}
+	else
+	{
+		xMatch = ( ( uxReturn & uxBitsToWaitFor ) != 0U ) ? pdTRUE : pdFALSE;
+	}
+
+	if( ( xMatch != pdFALSE ) && ( xClearOnExit != pdFALSE ) )
+	{
+		xEventGroup->uxEventBits &= ~uxBitsToWaitFor;
+	}
+
+	return uxReturn;
+}
+/*-----------------------------------------------------------*/
+
+EventBits_t xEventGroupSetBits( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet )
+{
+	xEventGroup->uxEventBits |= uxBitsToSet;
+
+	return xEventGroup->uxEventBits;
+}
+/*-----------------------------------------------------------*/
+
+EventBits_t xEventGroupClearBits( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear )
+{
+const EventBits_t uxReturn = xEventGroup->uxEventBits;
+
+	xEventGroup->uxEventBits &= ~uxBitsToClear;
+
+	return uxReturn;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Memory and port.
+ */
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+	return malloc( xWantedSize );
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+	free( pv );
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	/* The heap is malloc(), its use is not tracked. */
+	return configTOTAL_HEAP_SIZE;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return configTOTAL_HEAP_SIZE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+portBASE_TYPE xPortSetInterruptMask( void )
+{
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( portBASE_TYPE xMask )
+{
+	( void ) xMask;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,345 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/*
+ * A microbenchmark of the receive path of FreeRTOS+TCP.  Every stage times
+ * one function, or one layer of the path, in a tight loop, see stages.c and
+ * pcap_replay.c.  Usage:
+ *
+ *     microbench [-n packets] [-r repetitions] [-w warm-up] [-s payload]
+ *                [-k connections] [-p capture.pcap] [-a] [-c] [-l] [stage ...]
+ *
+ * Without stage names all synthetic stages are run, and the pcap stages as
+ * well when -p is given.  Per stage the time per packet is reported as the
+ * median, mean, standard deviation and minimum of the repetitions, either as
+ * a table or, with -c, as CSV.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+
+#include "microbench.h"
+
+#define benchDEFAULT_PACKETS		100000UL
+#define benchDEFAULT_REPETITIONS	10UL
+#define benchDEFAULT_WARM_UP		2UL
+#define benchDEFAULT_CONNECTIONS	32UL
+
+BenchOptions_t xBenchOptions =
+{
+	ipconfigTCP_MSS,	/* uxPayloadSize */
+	benchDEFAULT_CONNECTIONS,
+	NULL,
+	pdFALSE
+};
+
+static size_t uxPacketCount = benchDEFAULT_PACKETS;
+static size_t uxRepetitions = benchDEFAULT_REPETITIONS;
+static size_t uxWarmUp = benchDEFAULT_WARM_UP;
+static BaseType_t xCSVOutput = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNanoseconds( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+/* Run a repetition of a stage, and return the time that it took in ns.  Only
+pxRun() is timed, not the preparation of the batches. */
+static uint64_t prvRunRepetition( const BenchStage_t *pxStage )
+{
+uint64_t ullTotal = 0U;
+uint64_t ullStart;
+size_t uxDone = 0U;
+size_t uxCount;
+
+	while( uxDone < uxPacketCount )
+	{
+		uxCount = uxPacketCount - uxDone;
+		if( ( pxStage->uxBatchSize != 0U ) && ( uxCount > pxStage->uxBatchSize ) )
+		{
+			uxCount = pxStage->uxBatchSize;
+		}
+
+		if( pxStage->pxPrepareBatch != NULL )
+		{
+			pxStage->pxPrepareBatch( uxCount );
+		}
+
+		ullStart = prvNanoseconds();
+		pxStage->pxRun( uxCount );
+		ullTotal += prvNanoseconds() - ullStart;
+
+		uxDone += uxCount;
+	}
+
+	return ullTotal;
+}
+/*-----------------------------------------------------------*/
+
+static int prvCompareDoubles( const void *pvLeft, const void *pvRight )
+{
+double dLeft = *( const double * ) pvLeft;
+double dRight = *( const double * ) pvRight;
+
+	return ( dLeft > dRight ) - ( dLeft < dRight );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRunStage( const BenchStage_t *pxStage )
+{
+double *pdSamples;
+double dMedian, dMean = 0.0, dVariance = 0.0;
+size_t uxIndex;
+
+	if( pxStage->pxSetup() != pdPASS )
+	{
+		fprintf( stderr, "microbench: stage %s can not be run\n", pxStage->pcName );
+		return pdFAIL;
+	}
+
+	pdSamples = ( double * ) malloc( uxRepetitions * sizeof( *pdSamples ) );
+	configASSERT( pdSamples != NULL );
+
+	for( uxIndex = 0U; uxIndex < uxWarmUp; uxIndex++ )
+	{
+		( void ) prvRunRepetition( pxStage );
+	}
+
+	for( uxIndex = 0U; uxIndex < uxRepetitions; uxIndex++ )
+	{
+		pdSamples[ uxIndex ] = ( double ) prvRunRepetition( pxStage ) / ( double ) uxPacketCount;
+		dMean += pdSamples[ uxIndex ];
+	}
+	dMean /= ( double ) uxRepetitions;
+
+	for( uxIndex = 0U; uxIndex < uxRepetitions; uxIndex++ )
+	{
+		dVariance += ( pdSamples[ uxIndex ] - dMean ) * ( pdSamples[ uxIndex ] - dMean );
+	}
+	if( uxRepetitions > 1U )
+	{
+		dVariance /= ( double ) ( uxRepetitions - 1U );
+	}
+
+	qsort( pdSamples, uxRepetitions, sizeof( *pdSamples ), prvCompareDoubles );
+	if( ( uxRepetitions % 2U ) != 0U )
+	{
+		dMedian = pdSamples[ uxRepetitions / 2U ];
+	}
+	else
+	{
+		dMedian = ( pdSamples[ ( uxRepetitions / 2U ) - 1U ] + pdSamples[ uxRepetitions / 2U ] ) / 2.0;
+	}
+
+	if( xCSVOutput != pdFALSE )
+	{
+		printf( "%s,%u,%u,%.2f,%.2f,%.2f,%.2f\n", pxStage->pcName, ( unsigned ) uxPacketCount, ( unsigned ) uxRepetitions,
+				dMedian, dMean, sqrt( dVariance ), pdSamples[ 0 ] );
+	}
+	else
+	{
+		printf( "%-24s %10.1f %10.1f %10.1f %10.1f\n", pxStage->pcName, dMedian, dMean, sqrt( dVariance ), pdSamples[ 0 ] );
+	}
+	fflush( stdout );
+
+	free( pdSamples );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static const BenchStage_t *prvFindStage( const char *pcName )
+{
+const BenchStage_t *pxStage;
+
+	for( pxStage = xSyntheticStages; pxStage->pcName != NULL; pxStage++ )
+	{
+		if( strcmp( pxStage->pcName, pcName ) == 0 )
+		{
+			return pxStage;
+		}
+	}
+
+	for( pxStage = xPcapStages; pxStage->pcName != NULL; pxStage++ )
+	{
+		if( strcmp( pxStage->pcName, pcName ) == 0 )
+		{
+			return pxStage;
+		}
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvListStages( void )
+{
+const BenchStage_t *pxStage;
+
+	for( pxStage = xSyntheticStages; pxStage->pcName != NULL; pxStage++ )
+	{
+		printf( "%-24s %s\n", pxStage->pcName, pxStage->pcDescription );
+	}
+
+	for( pxStage = xPcapStages; pxStage->pcName != NULL; pxStage++ )
+	{
+		printf( "%-24s %s\n", pxStage->pcName, pxStage->pcDescription );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvUsage( const char *pcProgram )
+{
+	fprintf( stderr,
+		"usage: %s [options] [stage ...]\n"
+		"  -n packets      packets per repetition (%lu)\n"
+		"  -r repetitions  timed repetitions per stage (%lu)\n"
+		"  -w warm-up      repetitions that are not timed (%lu)\n"
+		"  -s payload      payload of the synthetic packets, 1..%u (%u)\n"
+		"  -k connections  TCP connections and UDP sockets of the look-up stages (%lu)\n"
+		"  -p file         replay a pcap capture in the pcap stages\n"
+		"  -a              replay the capture without rewriting its addresses\n"
+		"  -c              print CSV\n"
+		"  -l              list the stages\n",
+		pcProgram, benchDEFAULT_PACKETS, benchDEFAULT_REPETITIONS, benchDEFAULT_WARM_UP,
+		( unsigned ) ipconfigTCP_MSS, ( unsigned ) ipconfigTCP_MSS, benchDEFAULT_CONNECTIONS );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvParseSize( const char *pcValue, size_t uxMinimum, size_t uxMaximum, size_t *puxResult )
+{
+char *pcEnd;
+unsigned long ulValue;
+
+	ulValue = strtoul( pcValue, &pcEnd, 10 );
+	if( ( *pcValue == '\0' ) || ( *pcEnd != '\0' ) || ( ulValue < uxMinimum ) || ( ulValue > uxMaximum ) )
+	{
+		fprintf( stderr, "microbench: %s is not a number from %lu to %lu\n", pcValue, ( unsigned long ) uxMinimum, ( unsigned long ) uxMaximum );
+		return pdFAIL;
+	}
+	*puxResult = ( size_t ) ulValue;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+const BenchStage_t *pxStage;
+BaseType_t xResult = pdPASS;
+int iOption;
+int iIndex;
+
+	while( ( iOption = getopt( argc, argv, "n:r:w:s:k:p:acl" ) ) != -1 )
+	{
+		switch( iOption )
+		{
+			case 'n': xResult &= prvParseSize( optarg, 1U, 1000000000U, &uxPacketCount ); break;
+			case 'r': xResult &= prvParseSize( optarg, 1U, 100000U, &uxRepetitions ); break;
+			case 'w': xResult &= prvParseSize( optarg, 0U, 100000U, &uxWarmUp ); break;
+			case 's': xResult &= prvParseSize( optarg, 1U, ipconfigTCP_MSS, &xBenchOptions.uxPayloadSize ); break;
+			/* Every connection takes a socket from the backlog of the listening socket. */
+			case 'k': xResult &= prvParseSize( optarg, 1U, 1000U, &xBenchOptions.uxConnectionCount ); break;
+			case 'p': xBenchOptions.pcPcapFile = optarg; break;
+			case 'a': xBenchOptions.xKeepAddresses = pdTRUE; break;
+			case 'c': xCSVOutput = pdTRUE; break;
+			case 'l': prvListStages(); return 0;
+			default: xResult = pdFAIL; break;
+		}
+	}
+
+	for( iIndex = optind; iIndex < argc; iIndex++ )
+	{
+		if( prvFindStage( argv[ iIndex ] ) == NULL )
+		{
+			fprintf( stderr, "microbench: unknown stage %s, see -l\n", argv[ iIndex ] );
+			xResult = pdFAIL;
+		}
+	}
+
+	if( xResult != pdPASS )
+	{
+		prvUsage( argv[ 0 ] );
+		return 2;
+	}
+
+	vBenchStartStack();
+
+	if( xCSVOutput != pdFALSE )
+	{
+		printf( "stage,packets,repetitions,median_ns,mean_ns,stddev_ns,min_ns\n" );
+	}
+	else
+	{
+		printf( "%-24s %10s %10s %10s %10s   (ns per packet, %u packets, %u repetitions)\n",
+				"stage", "median", "mean", "stddev", "min", ( unsigned ) uxPacketCount, ( unsigned ) uxRepetitions );
+	}
+
+	if( optind < argc )
+	{
+		for( iIndex = optind; iIndex < argc; iIndex++ )
+		{
+			xResult &= prvRunStage( prvFindStage( argv[ iIndex ] ) );
+		}
+	}
+	else
+	{
+		for( pxStage = xSyntheticStages; pxStage->pcName != NULL; pxStage++ )
+		{
+			xResult &= prvRunStage( pxStage );
+		}
+
+		if( xBenchOptions.pcPcapFile != NULL )
+		{
+			for( pxStage = xPcapStages; pxStage->pcName != NULL; pxStage++ )
+			{
+				xResult &= prvRunStage( pxStage );
+			}
+		}
+	}
+
+	return ( xResult == pdPASS ) ? 0 : 1;
+}
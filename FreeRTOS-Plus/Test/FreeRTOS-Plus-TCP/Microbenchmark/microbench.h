@@ -0,0 +1,83 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+/*
+ * A stage is one function of the receive path that is measured on its own.
+ * main.c times the stages, stages.c and pcap_replay.c define them.
+ *
+ * A repetition processes 'uxPacketCount' packets in batches of 'uxBatchSize'.
+ * Before every batch pxPrepareBatch() is called without being timed: it can
+ * build the frames of the batch, or clean up after the previous one.  Then
+ * pxRun() is timed while it processes the packets of the batch.
+ */
+typedef struct xBENCH_STAGE
+{
+	const char *pcName;
+	const char *pcDescription;
+	BaseType_t ( *pxSetup )( void );						/* Called once, returns pdFAIL when the stage can not be run. */
+	void ( *pxPrepareBatch )( size_t uxCount );			/* May be NULL. */
+	void ( *pxRun )( size_t uxCount );
+	size_t uxBatchSize;										/* 0 for a single batch per repetition. */
+} BenchStage_t;
+
+/* The options that the stages use. */
+typedef struct xBENCH_OPTIONS
+{
+	size_t uxPayloadSize;			/* The payload of the synthetic UDP and TCP packets. */
+	size_t uxConnectionCount;		/* The TCP connections and UDP sockets used by the look-up stages. */
+	const char *pcPcapFile;			/* NULL when no capture is replayed. */
+	BaseType_t xKeepAddresses;		/* Replay the capture without rewriting the destination addresses. */
+} BenchOptions_t;
+
+extern BenchOptions_t xBenchOptions;
+
+/* The addresses of the stack under test and of its peer. */
+extern const uint8_t ucBenchIPAddress[ 4 ];
+extern const uint8_t ucBenchMACAddress[ 6 ];
+extern const uint8_t ucBenchPeerIPAddress[ 4 ];
+extern const uint8_t ucBenchPeerMACAddress[ 6 ];
+
+/* Start the IP-stack without an IP-task, see stages.c. */
+void vBenchStartStack( void );
+
+/* Get a network buffer, copy 'pucFrame' to it.  Stops the benchmark when
+the stack is out of network buffers, as that means that buffers leak. */
+NetworkBufferDescriptor_t *pxBenchFrameToBuffer( const uint8_t *pucFrame, size_t uxLength );
+
+/* Recalculate the IP header checksum, and the TCP, UDP or ICMP checksum. */
+void vBenchSetChecksums( uint8_t *pucFrame, size_t uxLength );
+
+/* Receive a complete frame as the IP-task would, and handle its result. */
+void publicProcessEthernetPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+eFrameProcessingResult_t publicProcessIPPacket( IPPacket_t * pxIPPacket, NetworkBufferDescriptor_t * const pxNetworkBuffer );
+
+/* The stages, each table is ended by an entry with a NULL name. */
+extern const BenchStage_t xSyntheticStages[];
+extern const BenchStage_t xPcapStages[];
+
+#endif /* MICROBENCH_H */
@@ -0,0 +1,130 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/*
+ * The network driver and the application hooks of the microbenchmark.  No
+ * frame is ever sent: the driver counts the frames that the stack passes to
+ * it, keeps a copy of the last one, and releases the network buffers.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+#include "stubs.h"
+
+static uint32_t ulOutputCount = 0U;
+static size_t uxLastOutputLength = 0U;
+static uint8_t ucLastOutput[ ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ];
+
+/* The state of the pseudo random generator, the same in every run. */
+static uint32_t ulRandomState = 0x12345678UL;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+{
+	ulOutputCount++;
+	uxLastOutputLength = pxNetworkBuffer->xDataLength;
+	if( uxLastOutputLength > sizeof( ucLastOutput ) )
+	{
+		uxLastOutputLength = sizeof( ucLastOutput );
+	}
+	memcpy( ucLastOutput, pxNetworkBuffer->pucEthernetBuffer, uxLastOutputLength );
+
+	if( xReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulStubGetOutputCount( void )
+{
+	return ulOutputCount;
+}
+/*-----------------------------------------------------------*/
+
+size_t uxStubGetLastOutput( uint8_t *pucBuffer, size_t uxBufferLength )
+{
+size_t uxLength = uxLastOutputLength;
+
+	if( uxLength > uxBufferLength )
+	{
+		uxLength = uxBufferLength;
+	}
+	memcpy( pucBuffer, ucLastOutput, uxLength );
+
+	return uxLength;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xApplicationGetRandomNumber( uint32_t *pulNumber )
+{
+	/* xorshift32: cheap, and the same sequence in every run. */
+	ulRandomState ^= ulRandomState << 13;
+	ulRandomState ^= ulRandomState >> 17;
+	ulRandomState ^= ulRandomState << 5;
+	*pulNumber = ulRandomState;
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+											 uint16_t usSourcePort,
+											 uint32_t ulDestinationAddress,
+											 uint16_t usDestinationPort )
+{
+uint32_t ulNumber;
+
+	( void ) ulSourceAddress;
+	( void ) usSourcePort;
+	( void ) ulDestinationAddress;
+	( void ) usDestinationPort;
+
+	( void ) xApplicationGetRandomNumber( &( ulNumber ) );
+
+	return ulNumber;
+}
+/*-----------------------------------------------------------*/
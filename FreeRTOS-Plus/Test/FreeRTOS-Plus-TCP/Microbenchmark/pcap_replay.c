@@ -0,0 +1,307 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/*
+ * The stages that replay a capture file, given with the -p option.
+ *
+ * The capture must be in the classic pcap format with Ethernet frames, as
+ * written by "tcpdump -w".  Frames that were truncated by the capture, or that
+ * are larger than a network buffer, are skipped.  Unless -a is given, the
+ * destination MAC and IP addresses of unicast frames are replaced with those
+ * of the stack, and the checksums are recalculated, so that the frames are
+ * not dropped by the first address check.
+ *
+ * The stack only knows the sockets of the synthetic stages, so most replayed
+ * TCP and UDP packets are answered with a RST or dropped.  The replay
+ * measures the classification of real traffic, not the delivery of its data.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkBufferManagement.h"
+
+#include "microbench.h"
+
+#define pcapMAGIC_MICROSECONDS		0xA1B2C3D4UL
+#define pcapMAGIC_NANOSECONDS		0xA1B23C4DUL
+#define pcapMAGIC_PCAPNG			0x0A0D0D0AUL
+#define pcapLINKTYPE_ETHERNET		1UL
+
+#define pcapFILE_HEADER_LENGTH		24U
+#define pcapRECORD_HEADER_LENGTH	16U
+
+/* The largest frame without the Ethernet CRC. */
+#define pcapMAX_FRAME_SIZE			( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER )
+
+typedef struct xPCAP_FRAME
+{
+	uint8_t *pucData;
+	size_t uxLength;
+} PcapFrame_t;
+
+static PcapFrame_t *pxFrames = NULL;
+static size_t uxFrameCount = 0U;
+
+/* The next frame to be replayed, the replay wraps around. */
+static size_t uxNextFrame = 0U;
+
+static volatile uint32_t ulSink;
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRead32( const uint8_t *pucData, BaseType_t xSwapped )
+{
+uint32_t ulValue;
+
+	memcpy( &ulValue, pucData, sizeof( ulValue ) );
+	if( xSwapped != pdFALSE )
+	{
+		ulValue = ( ( ulValue & 0x000000FFUL ) << 24 ) |
+				  ( ( ulValue & 0x0000FF00UL ) << 8 ) |
+				  ( ( ulValue & 0x00FF0000UL ) >> 8 ) |
+				  ( ( ulValue & 0xFF000000UL ) >> 24 );
+	}
+
+	return ulValue;
+}
+/*-----------------------------------------------------------*/
+
+/* Let a frame of the capture be addressed to the stack. */
+static void prvRewriteAddresses( uint8_t *pucFrame, size_t uxLength )
+{
+EthernetHeader_t *pxEthernetHeader = ( EthernetHeader_t * ) pucFrame;
+IPHeader_t *pxIPHeader = ( IPHeader_t * ) &( pucFrame[ ipSIZE_OF_ETH_HEADER ] );
+
+	/* Broadcast and multicast frames stay as they are. */
+	if( ( pxEthernetHeader->xDestinationAddress.ucBytes[ 0 ] & 0x01U ) == 0U )
+	{
+		memcpy( pxEthernetHeader->xDestinationAddress.ucBytes, ucBenchMACAddress, sizeof( ucBenchMACAddress ) );
+
+		if( ( uxLength >= sizeof( IPPacket_t ) ) && ( pxEthernetHeader->usFrameType == ipIPv4_FRAME_TYPE ) )
+		{
+			pxIPHeader->ulDestinationIPAddress = FreeRTOS_inet_addr_quick( ucBenchIPAddress[ 0 ], ucBenchIPAddress[ 1 ], ucBenchIPAddress[ 2 ], ucBenchIPAddress[ 3 ] );
+			vBenchSetChecksums( pucFrame, uxLength );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvLoadCapture( const char *pcFileName )
+{
+FILE *pxFile;
+uint8_t ucHeader[ pcapFILE_HEADER_LENGTH ];
+uint8_t ucRecord[ pcapRECORD_HEADER_LENGTH ];
+uint8_t *pucData;
+BaseType_t xSwapped = pdFALSE;
+BaseType_t xResult = pdPASS;
+uint32_t ulMagic;
+uint32_t ulCapturedLength;
+uint32_t ulOriginalLength;
+size_t uxSkipped = 0U;
+size_t uxAllocated = 0U;
+
+	pxFile = fopen( pcFileName, "rb" );
+	if( pxFile == NULL )
+	{
+		fprintf( stderr, "microbench: can not open %s\n", pcFileName );
+		return pdFAIL;
+	}
+
+	if( fread( ucHeader, 1U, sizeof( ucHeader ), pxFile ) != sizeof( ucHeader ) )
+	{
+		fprintf( stderr, "microbench: %s is not a pcap file\n", pcFileName );
+		fclose( pxFile );
+		return pdFAIL;
+	}
+
+	ulMagic = prvRead32( ucHeader, pdFALSE );
+	if( ( ulMagic != pcapMAGIC_MICROSECONDS ) && ( ulMagic != pcapMAGIC_NANOSECONDS ) )
+	{
+		xSwapped = pdTRUE;
+		ulMagic = prvRead32( ucHeader, pdTRUE );
+	}
+
+	if( ulMagic == pcapMAGIC_PCAPNG )
+	{
+		fprintf( stderr, "microbench: %s is a pcapng file, convert it with \"editcap -F pcap\"\n", pcFileName );
+		xResult = pdFAIL;
+	}
+	else if( ( ulMagic != pcapMAGIC_MICROSECONDS ) && ( ulMagic != pcapMAGIC_NANOSECONDS ) )
+	{
+		fprintf( stderr, "microbench: %s is not a pcap file\n", pcFileName );
+		xResult = pdFAIL;
+	}
+	else if( ( prvRead32( &( ucHeader[ 20 ] ), xSwapped ) & 0xFFFFUL ) != pcapLINKTYPE_ETHERNET )
+	{
+		fprintf( stderr, "microbench: %s does not contain Ethernet frames\n", pcFileName );
+		xResult = pdFAIL;
+	}
+
+	while( ( xResult == pdPASS ) && ( fread( ucRecord, 1U, sizeof( ucRecord ), pxFile ) == sizeof( ucRecord ) ) )
+	{
+		ulCapturedLength = prvRead32( &( ucRecord[ 8 ] ), xSwapped );
+		ulOriginalLength = prvRead32( &( ucRecord[ 12 ] ), xSwapped );
+
+		pucData = ( uint8_t * ) malloc( ulCapturedLength + 1U );
+		if( ( pucData == NULL ) || ( fread( pucData, 1U, ulCapturedLength, pxFile ) != ulCapturedLength ) )
+		{
+			/* The file ends in the middle of a frame. */
+			free( pucData );
+			break;
+		}
+
+		if( ( ulCapturedLength != ulOriginalLength ) ||
+			( ulCapturedLength < ipSIZE_OF_ETH_HEADER ) ||
+			( ulCapturedLength > pcapMAX_FRAME_SIZE ) )
+		{
+			free( pucData );
+			uxSkipped++;
+			continue;
+		}
+
+		if( uxFrameCount == uxAllocated )
+		{
+			uxAllocated = ( uxAllocated == 0U ) ? 1024U : ( uxAllocated * 2U );
+			pxFrames = ( PcapFrame_t * ) realloc( pxFrames, uxAllocated * sizeof( *pxFrames ) );
+			configASSERT( pxFrames != NULL );
+		}
+
+		if( xBenchOptions.xKeepAddresses == pdFALSE )
+		{
+			prvRewriteAddresses( pucData, ulCapturedLength );
+		}
+
+		pxFrames[ uxFrameCount ].pucData = pucData;
+		pxFrames[ uxFrameCount ].uxLength = ulCapturedLength;
+		uxFrameCount++;
+	}
+
+	fclose( pxFile );
+
+	if( xResult == pdPASS )
+	{
+		fprintf( stderr, "microbench: %s: %u frames, %u skipped\n", pcFileName, ( unsigned ) uxFrameCount, ( unsigned ) uxSkipped );
+		if( uxFrameCount == 0U )
+		{
+			xResult = pdFAIL;
+		}
+	}
+
+	return xResult;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSetupCapture( void )
+{
+static BaseType_t xDone = pdFALSE;
+static BaseType_t xResult = pdFAIL;
+
+	if( xDone == pdFALSE )
+	{
+		xDone = pdTRUE;
+
+		if( xBenchOptions.pcPcapFile == NULL )
+		{
+			fprintf( stderr, "microbench: the pcap stages need a capture, see -p\n" );
+		}
+		else
+		{
+			xResult = prvLoadCapture( xBenchOptions.pcPcapFile );
+		}
+	}
+
+	return xResult;
+}
+/*-----------------------------------------------------------*/
+
+static const PcapFrame_t *prvNextFrame( void )
+{
+const PcapFrame_t *pxFrame = &( pxFrames[ uxNextFrame ] );
+
+	uxNextFrame++;
+	if( uxNextFrame == uxFrameCount )
+	{
+		uxNextFrame = 0U;
+	}
+
+	return pxFrame;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunProtocolChecksum( size_t uxCount )
+{
+const PcapFrame_t *pxFrame;
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		pxFrame = prvNextFrame();
+		ulSink += usGenerateProtocolChecksum( pxFrame->pucData, pxFrame->uxLength, pdFALSE );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunConsiderFrame( size_t uxCount )
+{
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		ulSink += ( uint32_t ) eConsiderFrameForProcessing( prvNextFrame()->pucData );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunEthernet( size_t uxCount )
+{
+const PcapFrame_t *pxFrame;
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		pxFrame = prvNextFrame();
+		publicProcessEthernetPacket( pxBenchFrameToBuffer( pxFrame->pucData, pxFrame->uxLength ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+const BenchStage_t xPcapStages[] =
+{
+	{ "pcap-protocol-checksum", "usGenerateProtocolChecksum() of the captured frames", prvSetupCapture, NULL, prvRunProtocolChecksum, 0U },
+	{ "pcap-consider-frame", "eConsiderFrameForProcessing() of the captured frames", prvSetupCapture, NULL, prvRunConsiderFrame, 0U },
+	{ "pcap-ethernet", "buffer + prvProcessEthernetPacket() of the captured frames", prvSetupCapture, NULL, prvRunEthernet, 0U },
+	{ NULL, NULL, NULL, NULL, NULL, 0U }
+};
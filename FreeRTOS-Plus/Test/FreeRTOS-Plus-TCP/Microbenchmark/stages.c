@@ -0,0 +1,742 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/*
+ * The stages that are measured with synthetic traffic, and the start-up of
+ * the IP-stack.
+ *
+ * The stack is started with FreeRTOS_IPInit(), but its task never runs: the
+ * benchmark takes its place, see vBenchStartStack().  A peer at
+ * ucBenchPeerIPAddress sends the frames.  Its TCP connections are opened with
+ * a real three-way handshake through the complete receive path, after which
+ * the TCP stages send in-order data segments on the first connection.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_IP_Stack.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_TCP_IP.h"
+#include "FreeRTOS_Stream_Buffer.h"
+#include "NetworkBufferManagement.h"
+#include "NetworkInterface.h"
+
+#include "microbench.h"
+#include "stubs.h"
+
+/* The UDP port of the socket that receives the UDP stages. */
+#define benchUDP_PORT					5000U
+
+/* The TCP port that the stack listens to. */
+#define benchTCP_PORT					5001U
+
+/* The ports of the peer's connections are benchPEER_PORT, benchPEER_PORT + 1,
+and so on. */
+#define benchPEER_PORT					40000U
+
+/* The ports of the UDP sockets of the "udp-lookup" stage. */
+#define benchUDP_LOOKUP_PORT			6000U
+
+/* The data segments that are sent before the reception stream is emptied.
+Together they must fit in ipconfigTCP_RX_BUFFER_LENGTH. */
+#define benchTCP_BATCH					32U
+
+/* The largest frame without the Ethernet CRC. */
+#define benchFRAME_SIZE					( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER )
+
+/* IPv4 with a header of 20 bytes. */
+#define benchIP_VERSION_HEADER_LENGTH	( ( uint8_t ) 0x45U )
+
+/* The TCP flags, as in FreeRTOS_TCP_IP.c. */
+#define benchTCP_FLAG_SYN				( ( uint8_t ) 0x02U )
+#define benchTCP_FLAG_PSH				( ( uint8_t ) 0x08U )
+#define benchTCP_FLAG_ACK				( ( uint8_t ) 0x10U )
+
+/* The SYN carries an MSS option, which makes the TCP header 24 bytes long. */
+#define benchTCP_SYN_OPTIONS_LENGTH		4U
+
+typedef struct xBENCH_CONNECTION
+{
+	uint16_t usPeerPort;
+	uint32_t ulPeerSequence;		/* The sequence number of the next byte sent by the peer. */
+	uint32_t ulPeerAck;				/* The peer acknowledges the SYN of the stack and nothing more. */
+	FreeRTOS_Socket_t *pxSocket;	/* The child socket of the connection. */
+} BenchConnection_t;
+
+const uint8_t ucBenchIPAddress[ 4 ] = { 10U, 0U, 0U, 1U };
+const uint8_t ucBenchMACAddress[ 6 ] = { 0x00U, 0x11U, 0x22U, 0x33U, 0x44U, 0x01U };
+const uint8_t ucBenchPeerIPAddress[ 4 ] = { 10U, 0U, 0U, 2U };
+const uint8_t ucBenchPeerMACAddress[ 6 ] = { 0x00U, 0x11U, 0x22U, 0x33U, 0x44U, 0x02U };
+static const uint8_t ucNetMask[ 4 ] = { 255U, 255U, 255U, 0U };
+static const uint8_t ucGatewayAddress[ 4 ] = { 10U, 0U, 0U, 254U };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 10U, 0U, 0U, 254U };
+
+/* Written with the results of the functions that are measured, so that the
+compiler can not leave out the calls. */
+static volatile uint32_t ulSink;
+
+static uint8_t ucPayload[ ipconfigTCP_MSS ];
+static uint8_t ucUDPFrame[ benchFRAME_SIZE ];
+static size_t uxUDPFrameLength;
+static uint8_t ucTCPFrame[ benchFRAME_SIZE ];
+static size_t uxTCPFrameLength;
+
+static BenchConnection_t *pxConnections = NULL;
+static uint8_t *pucTCPBatch = NULL;
+static size_t uxTCPBatchLength[ benchTCP_BATCH ];
+static uint64_t ullTCPBytesSent = 0U;
+static uint64_t ullTCPBytesReceived = 0U;
+
+static StreamBuffer_t *pxStreamBuffer = NULL;
+static uint32_t ulARPLookupAddress;
+static uint32_t ulUDPSinkCount = 0U;
+
+/*-----------------------------------------------------------*/
+
+void vBenchStartStack( void )
+{
+BaseType_t xResult;
+
+	xResult = FreeRTOS_IPInit( ucBenchIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucBenchMACAddress );
+	configASSERT( xResult == pdPASS );
+
+	/* From now on the benchmark plays the IP-task.  The task is not started,
+	so the initialisation that prvIPTask() does is repeated here: the
+	interface is up, and the stack knows its peer. */
+	vStubSetCurrentTask( pxIPStack->xIPTaskHandle );
+	pxIPStack->xIPTaskInitialised = pdTRUE;
+	( void ) xNetworkInterfaceInitialise();
+	vIPNetworkUpCalls();
+
+	vARPRefreshCacheEntry( ( const MACAddress_t * ) ucBenchPeerMACAddress,
+						   FreeRTOS_inet_addr_quick( ucBenchPeerIPAddress[ 0 ], ucBenchPeerIPAddress[ 1 ], ucBenchPeerIPAddress[ 2 ], ucBenchPeerIPAddress[ 3 ] ) );
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxBenchFrameToBuffer( const uint8_t *pucFrame, size_t uxLength )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+
+	pxBuffer = pxGetNetworkBufferWithDescriptor( uxLength, 0U );
+	if( pxBuffer == NULL )
+	{
+		fprintf( stderr, "microbench: out of network buffers, a stage does not release them\n" );
+		exit( 1 );
+	}
+	memcpy( pxBuffer->pucEthernetBuffer, pucFrame, uxLength );
+	pxBuffer->xDataLength = uxLength;
+
+	return pxBuffer;
+}
+/*-----------------------------------------------------------*/
+
+void vBenchSetChecksums( uint8_t *pucFrame, size_t uxLength )
+{
+EthernetHeader_t *pxEthernetHeader = ( EthernetHeader_t * ) pucFrame;
+IPHeader_t *pxIPHeader = ( IPHeader_t * ) &( pucFrame[ ipSIZE_OF_ETH_HEADER ] );
+size_t uxHeaderLength;
+
+	if( ( uxLength >= sizeof( IPPacket_t ) ) && ( pxEthernetHeader->usFrameType == ipIPv4_FRAME_TYPE ) )
+	{
+		uxHeaderLength = ( size_t ) ( ( pxIPHeader->ucVersionHeaderLength & 0x0FU ) << 2 );
+		if( ( uxHeaderLength >= ipSIZE_OF_IPv4_HEADER ) && ( ( ipSIZE_OF_ETH_HEADER + uxHeaderLength ) <= uxLength ) )
+		{
+			pxIPHeader->usHeaderChecksum = 0U;
+			pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( const uint8_t * ) pxIPHeader, uxHeaderLength );
+			pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+
+			/* Sets the checksum of TCP, UDP and ICMP packets. */
+			( void ) usGenerateProtocolChecksum( pucFrame, uxLength, pdTRUE );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Fill in the Ethernet and IP headers of a frame from the peer to the stack,
+and return the length of the frame. */
+static size_t prvFillIPHeaders( uint8_t *pucFrame, uint8_t ucProtocol, size_t uxIPPayloadLength )
+{
+EthernetHeader_t *pxEthernetHeader = ( EthernetHeader_t * ) pucFrame;
+IPHeader_t *pxIPHeader = ( IPHeader_t * ) &( pucFrame[ ipSIZE_OF_ETH_HEADER ] );
+static uint16_t usIdentification = 0U;
+
+	memcpy( pxEthernetHeader->xDestinationAddress.ucBytes, ucBenchMACAddress, sizeof( ucBenchMACAddress ) );
+	memcpy( pxEthernetHeader->xSourceAddress.ucBytes, ucBenchPeerMACAddress, sizeof( ucBenchPeerMACAddress ) );
+	pxEthernetHeader->usFrameType = ipIPv4_FRAME_TYPE;
+
+	pxIPHeader->ucVersionHeaderLength = benchIP_VERSION_HEADER_LENGTH;
+	pxIPHeader->ucDifferentiatedServicesCode = 0U;
+	pxIPHeader->usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_IPv4_HEADER + uxIPPayloadLength ) );
+	pxIPHeader->usIdentification = FreeRTOS_htons( usIdentification );
+	usIdentification++;
+	pxIPHeader->usFragmentOffset = 0U;
+	pxIPHeader->ucTimeToLive = 64U;
+	pxIPHeader->ucProtocol = ucProtocol;
+	pxIPHeader->ulSourceIPAddress = FreeRTOS_inet_addr_quick( ucBenchPeerIPAddress[ 0 ], ucBenchPeerIPAddress[ 1 ], ucBenchPeerIPAddress[ 2 ], ucBenchPeerIPAddress[ 3 ] );
+	pxIPHeader->ulDestinationIPAddress = FreeRTOS_inet_addr_quick( ucBenchIPAddress[ 0 ], ucBenchIPAddress[ 1 ], ucBenchIPAddress[ 2 ], ucBenchIPAddress[ 3 ] );
+
+	return ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + uxIPPayloadLength;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvBuildUDPFrame( uint8_t *pucFrame, uint16_t usDestinationPort, size_t uxPayloadLength )
+{
+UDPPacket_t *pxUDPPacket = ( UDPPacket_t * ) pucFrame;
+size_t uxLength;
+
+	uxLength = prvFillIPHeaders( pucFrame, ( uint8_t ) ipPROTOCOL_UDP, ipSIZE_OF_UDP_HEADER + uxPayloadLength );
+	pxUDPPacket->xUDPHeader.usSourcePort = FreeRTOS_htons( ( uint16_t ) benchPEER_PORT );
+	pxUDPPacket->xUDPHeader.usDestinationPort = FreeRTOS_htons( usDestinationPort );
+	pxUDPPacket->xUDPHeader.usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_UDP_HEADER + uxPayloadLength ) );
+	memcpy( &( pucFrame[ sizeof( UDPPacket_t ) ] ), ucPayload, uxPayloadLength );
+	vBenchSetChecksums( pucFrame, uxLength );
+
+	return uxLength;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvBuildTCPFrame( uint8_t *pucFrame, uint16_t usSourcePort, uint32_t ulSequenceNumber, uint32_t ulAckNumber, uint8_t ucFlags, size_t uxPayloadLength )
+{
+TCPPacket_t *pxTCPPacket = ( TCPPacket_t * ) pucFrame;
+size_t uxHeaderLength = ipSIZE_OF_TCP_HEADER;
+size_t uxLength;
+
+	if( ( ucFlags & benchTCP_FLAG_SYN ) != 0U )
+	{
+		uxHeaderLength += benchTCP_SYN_OPTIONS_LENGTH;
+	}
+
+	uxLength = prvFillIPHeaders( pucFrame, ( uint8_t ) ipPROTOCOL_TCP, uxHeaderLength + uxPayloadLength );
+	pxTCPPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( usSourcePort );
+	pxTCPPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( ( uint16_t ) benchTCP_PORT );
+	pxTCPPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( ulSequenceNumber );
+	pxTCPPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( ulAckNumber );
+	pxTCPPacket->xTCPHeader.ucTCPOffset = ( uint8_t ) ( ( uxHeaderLength / 4U ) << 4 );
+	pxTCPPacket->xTCPHeader.ucTCPFlags = ucFlags;
+	pxTCPPacket->xTCPHeader.usWindow = FreeRTOS_htons( 0xFFFFU );
+	pxTCPPacket->xTCPHeader.usUrgent = 0U;
+
+	if( ( ucFlags & benchTCP_FLAG_SYN ) != 0U )
+	{
+		/* The maximum segment size. */
+		pxTCPPacket->xTCPHeader.ucOptdata[ 0 ] = 2U;
+		pxTCPPacket->xTCPHeader.ucOptdata[ 1 ] = 4U;
+		pxTCPPacket->xTCPHeader.ucOptdata[ 2 ] = ( uint8_t ) ( ipconfigTCP_MSS >> 8 );
+		pxTCPPacket->xTCPHeader.ucOptdata[ 3 ] = ( uint8_t ) ( ipconfigTCP_MSS & 0xFFU );
+	}
+
+	memcpy( &( pucFrame[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + uxHeaderLength ] ), ucPayload, uxPayloadLength );
+	vBenchSetChecksums( pucFrame, uxLength );
+
+	return uxLength;
+}
+/*-----------------------------------------------------------*/
+
+/* What the IP-task does with the result of prvProcessIPPacket(). */
+static void prvHandleResult( eFrameProcessingResult_t eResult, NetworkBufferDescriptor_t *pxBuffer )
+{
+	switch( eResult )
+	{
+		case eReturnEthernetFrame:
+			vReturnEthernetFrame( pxBuffer, pdTRUE );
+			break;
+
+		case eFrameConsumed:
+			break;
+
+		default:
+			vReleaseNetworkBufferAndDescriptor( pxBuffer );
+			break;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSetupFrames( void )
+{
+static BaseType_t xDone = pdFALSE;
+size_t uxIndex;
+
+	if( xDone == pdFALSE )
+	{
+		for( uxIndex = 0U; uxIndex < sizeof( ucPayload ); uxIndex++ )
+		{
+			ucPayload[ uxIndex ] = ( uint8_t ) ( uxIndex * 7U );
+		}
+
+		uxUDPFrameLength = prvBuildUDPFrame( ucUDPFrame, ( uint16_t ) benchUDP_PORT, xBenchOptions.uxPayloadSize );
+
+		/* A data segment that does not belong to a connection, for the
+		checksum stage. */
+		uxTCPFrameLength = prvBuildTCPFrame( ucTCPFrame, ( uint16_t ) benchPEER_PORT, 1U, 1U, benchTCP_FLAG_ACK | benchTCP_FLAG_PSH, xBenchOptions.uxPayloadSize );
+
+		xDone = pdTRUE;
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+/* Pass a frame through the complete receive path. */
+static void prvReceiveFrame( const uint8_t *pucFrame, size_t uxLength )
+{
+	publicProcessEthernetPacket( pxBenchFrameToBuffer( pucFrame, uxLength ) );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvUDPSinkHandler( Socket_t xSocket, void *pvData, size_t uxLength, const struct freertos_sockaddr *pxFrom, const struct freertos_sockaddr *pxDest )
+{
+	( void ) xSocket;
+	( void ) pvData;
+	( void ) pxFrom;
+	( void ) pxDest;
+
+	ulUDPSinkCount += ( uint32_t ) uxLength;
+
+	/* Non-zero: the data was handled, the stack releases the buffer. */
+	return 1;
+}
+/*-----------------------------------------------------------*/
+
+static FreeRTOS_Socket_t *prvCreateBoundSocket( BaseType_t xType, BaseType_t xProtocol, uint16_t usPort )
+{
+Socket_t xSocket;
+struct freertos_sockaddr xAddress;
+BaseType_t xResult;
+
+	xSocket = FreeRTOS_socket( FREERTOS_AF_INET, xType, xProtocol );
+	configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+
+	/* FreeRTOS_bind() would wait for the IP-task, call what the IP-task
+	would call. */
+	memset( &xAddress, 0, sizeof( xAddress ) );
+	xAddress.sin_port = FreeRTOS_htons( usPort );
+	xResult = vSocketBind( ( FreeRTOS_Socket_t * ) xSocket, &xAddress, sizeof( xAddress ), pdFALSE );
+	configASSERT( xResult == 0 );
+
+	return ( FreeRTOS_Socket_t * ) xSocket;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSetupUDPSink( void )
+{
+static BaseType_t xDone = pdFALSE;
+static BaseType_t xResult = pdPASS;
+FreeRTOS_Socket_t *pxSocket;
+F_TCP_UDP_Handler_t xHandler;
+
+	( void ) prvSetupFrames();
+
+	if( xDone == pdFALSE )
+	{
+		xDone = pdTRUE;
+
+		pxSocket = prvCreateBoundSocket( FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP, ( uint16_t ) benchUDP_PORT );
+		memset( &xHandler, 0, sizeof( xHandler ) );
+		xHandler.pxOnUDPReceive = prvUDPSinkHandler;
+		( void ) FreeRTOS_setsockopt( ( Socket_t ) pxSocket, 0, FREERTOS_SO_UDP_RECV_HANDLER, ( void * ) &xHandler, sizeof( xHandler ) );
+
+		/* Check that the frames reach the socket, and are not dropped on
+		the way. */
+		prvReceiveFrame( ucUDPFrame, uxUDPFrameLength );
+		if( ulUDPSinkCount != ( uint32_t ) xBenchOptions.uxPayloadSize )
+		{
+			fprintf( stderr, "microbench: the UDP frames do not reach the socket\n" );
+			xResult = pdFAIL;
+		}
+	}
+
+	return xResult;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSetupConnections( void )
+{
+static BaseType_t xDone = pdFALSE;
+static BaseType_t xResult = pdPASS;
+FreeRTOS_Socket_t *pxListener;
+BenchConnection_t *pxConnection;
+uint8_t ucFrame[ benchFRAME_SIZE ];
+const TCPPacket_t *pxReply = ( const TCPPacket_t * ) ucFrame;
+const uint32_t ulLocalIP = FreeRTOS_ntohl( FreeRTOS_inet_addr_quick( ucBenchIPAddress[ 0 ], ucBenchIPAddress[ 1 ], ucBenchIPAddress[ 2 ], ucBenchIPAddress[ 3 ] ) );
+const uint32_t ulPeerIP = FreeRTOS_ntohl( FreeRTOS_inet_addr_quick( ucBenchPeerIPAddress[ 0 ], ucBenchPeerIPAddress[ 1 ], ucBenchPeerIPAddress[ 2 ], ucBenchPeerIPAddress[ 3 ] ) );
+size_t uxIndex;
+size_t uxLength;
+uint32_t ulOutputCount;
+
+	( void ) prvSetupFrames();
+
+	if( xDone == pdFALSE )
+	{
+		xDone = pdTRUE;
+
+		pxListener = prvCreateBoundSocket( FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP, ( uint16_t ) benchTCP_PORT );
+		( void ) FreeRTOS_listen( ( Socket_t ) pxListener, ( BaseType_t ) xBenchOptions.uxConnectionCount + 1 );
+
+		pxConnections = ( BenchConnection_t * ) calloc( xBenchOptions.uxConnectionCount, sizeof( *pxConnections ) );
+		pucTCPBatch = ( uint8_t * ) malloc( benchTCP_BATCH * benchFRAME_SIZE );
+		configASSERT( ( pxConnections != NULL ) && ( pucTCPBatch != NULL ) );
+
+		for( uxIndex = 0U; uxIndex < xBenchOptions.uxConnectionCount; uxIndex++ )
+		{
+			pxConnection = &( pxConnections[ uxIndex ] );
+			pxConnection->usPeerPort = ( uint16_t ) ( benchPEER_PORT + uxIndex );
+			pxConnection->ulPeerSequence = 1000000U * ( uint32_t ) ( uxIndex + 1U );
+
+			/* SYN, to which the stack must answer with a SYN+ACK. */
+			ulOutputCount = ulStubGetOutputCount();
+			uxLength = prvBuildTCPFrame( ucFrame, pxConnection->usPeerPort, pxConnection->ulPeerSequence, 0U, benchTCP_FLAG_SYN, 0U );
+			prvReceiveFrame( ucFrame, uxLength );
+			pxConnection->ulPeerSequence++;
+
+			uxLength = uxStubGetLastOutput( ucFrame, sizeof( ucFrame ) );
+			if( ( ulStubGetOutputCount() == ulOutputCount ) ||
+				( uxLength < ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER ) ) ||
+				( pxReply->xTCPHeader.ucTCPFlags != ( benchTCP_FLAG_SYN | benchTCP_FLAG_ACK ) ) )
+			{
+				fprintf( stderr, "microbench: connection %u was not accepted\n", ( unsigned ) uxIndex );
+				xResult = pdFAIL;
+				break;
+			}
+			pxConnection->ulPeerAck = FreeRTOS_ntohl( pxReply->xTCPHeader.ulSequenceNumber ) + 1U;
+
+			/* The ACK that completes the handshake. */
+			uxLength = prvBuildTCPFrame( ucFrame, pxConnection->usPeerPort, pxConnection->ulPeerSequence, pxConnection->ulPeerAck, benchTCP_FLAG_ACK, 0U );
+			prvReceiveFrame( ucFrame, uxLength );
+
+			pxConnection->pxSocket = pxTCPSocketLookup( ulLocalIP, benchTCP_PORT, ulPeerIP, pxConnection->usPeerPort );
+			if( ( pxConnection->pxSocket == NULL ) || ( pxConnection->pxSocket->u.xTCP.ucTCPState != ( uint8_t ) eESTABLISHED ) )
+			{
+				fprintf( stderr, "microbench: connection %u was not established\n", ( unsigned ) uxIndex );
+				xResult = pdFAIL;
+				break;
+			}
+		}
+	}
+
+	return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/* Empty the reception stream of the first connection, as FreeRTOS_recv()
+would, and build the next 'uxCount' data segments. */
+static void prvPrepareTCPBatch( size_t uxCount )
+{
+BenchConnection_t *pxConnection = &( pxConnections[ 0 ] );
+StreamBuffer_t *pxStream = pxConnection->pxSocket->u.xTCP.rxStream;
+size_t uxIndex;
+
+	if( pxStream != NULL )
+	{
+		ullTCPBytesReceived += uxStreamBufferGet( pxStream, 0U, NULL, uxStreamBufferGetSize( pxStream ), pdFALSE );
+	}
+
+	if( ullTCPBytesReceived != ullTCPBytesSent )
+	{
+		fprintf( stderr, "microbench: the stack accepted %llu of the %llu bytes that were sent\n",
+			( unsigned long long ) ullTCPBytesReceived, ( unsigned long long ) ullTCPBytesSent );
+		exit( 1 );
+	}
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		uxTCPBatchLength[ uxIndex ] = prvBuildTCPFrame( &( pucTCPBatch[ uxIndex * benchFRAME_SIZE ] ),
+			pxConnection->usPeerPort, pxConnection->ulPeerSequence, pxConnection->ulPeerAck,
+			benchTCP_FLAG_ACK | benchTCP_FLAG_PSH, xBenchOptions.uxPayloadSize );
+		pxConnection->ulPeerSequence += ( uint32_t ) xBenchOptions.uxPayloadSize;
+		ullTCPBytesSent += xBenchOptions.uxPayloadSize;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunBuffer( size_t uxCount )
+{
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxBenchFrameToBuffer( ucUDPFrame, uxUDPFrameLength ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunChecksum( size_t uxCount )
+{
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		ulSink += usGenerateChecksum( 0U, ucPayload, xBenchOptions.uxPayloadSize );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunProtocolChecksumUDP( size_t uxCount )
+{
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		ulSink += usGenerateProtocolChecksum( ucUDPFrame, uxUDPFrameLength, pdFALSE );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunProtocolChecksumTCP( size_t uxCount )
+{
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		ulSink += usGenerateProtocolChecksum( ucTCPFrame, uxTCPFrameLength, pdFALSE );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunConsiderFrame( size_t uxCount )
+{
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		ulSink += ( uint32_t ) eConsiderFrameForProcessing( ucUDPFrame );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunIPUDP( size_t uxCount )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		pxBuffer = pxBenchFrameToBuffer( ucUDPFrame, uxUDPFrameLength );
+		prvHandleResult( publicProcessIPPacket( ( IPPacket_t * ) pxBuffer->pucEthernetBuffer, pxBuffer ), pxBuffer );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunEthernetUDP( size_t uxCount )
+{
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		publicProcessEthernetPacket( pxBenchFrameToBuffer( ucUDPFrame, uxUDPFrameLength ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunTCPSegment( size_t uxCount )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		pxBuffer = pxBenchFrameToBuffer( &( pucTCPBatch[ uxIndex * benchFRAME_SIZE ] ), uxTCPBatchLength[ uxIndex ] );
+		if( xProcessReceivedTCPPacket( pxBuffer ) != pdPASS )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxBuffer );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunIPTCP( size_t uxCount )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		pxBuffer = pxBenchFrameToBuffer( &( pucTCPBatch[ uxIndex * benchFRAME_SIZE ] ), uxTCPBatchLength[ uxIndex ] );
+		prvHandleResult( publicProcessIPPacket( ( IPPacket_t * ) pxBuffer->pucEthernetBuffer, pxBuffer ), pxBuffer );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunEthernetTCP( size_t uxCount )
+{
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		publicProcessEthernetPacket( pxBenchFrameToBuffer( &( pucTCPBatch[ uxIndex * benchFRAME_SIZE ] ), uxTCPBatchLength[ uxIndex ] ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSetupStreamBuffer( void )
+{
+size_t uxLength = ipconfigTCP_RX_BUFFER_LENGTH + sizeof( size_t );
+
+	( void ) prvSetupFrames();
+
+	if( pxStreamBuffer == NULL )
+	{
+		/* The same layout as prvTCPAllocateStream() creates. */
+		pxStreamBuffer = ( StreamBuffer_t * ) calloc( 1U, ( sizeof( *pxStreamBuffer ) + uxLength ) - sizeof( pxStreamBuffer->ucArray ) );
+		configASSERT( pxStreamBuffer != NULL );
+		pxStreamBuffer->LENGTH = uxLength;
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunStreamBuffer( size_t uxCount )
+{
+uint8_t ucBuffer[ ipconfigTCP_MSS ];
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		ulSink += ( uint32_t ) uxStreamBufferAdd( pxStreamBuffer, 0U, ucPayload, xBenchOptions.uxPayloadSize );
+		ulSink += ( uint32_t ) uxStreamBufferGet( pxStreamBuffer, 0U, ucBuffer, xBenchOptions.uxPayloadSize, pdFALSE );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSetupARPCache( void )
+{
+static BaseType_t xDone = pdFALSE;
+MACAddress_t xMACAddress;
+size_t uxIndex;
+
+	if( xDone == pdFALSE )
+	{
+		/* The peer takes one entry, fill the others.  The entry that is
+		added last is looked up, it is the last one that the search visits. */
+		for( uxIndex = 1U; uxIndex < ( size_t ) ipconfigARP_CACHE_ENTRIES; uxIndex++ )
+		{
+			memcpy( xMACAddress.ucBytes, ucBenchPeerMACAddress, sizeof( xMACAddress.ucBytes ) );
+			xMACAddress.ucBytes[ 5 ] = ( uint8_t ) ( 0x80U + uxIndex );
+			ulARPLookupAddress = FreeRTOS_inet_addr_quick( ucBenchIPAddress[ 0 ], ucBenchIPAddress[ 1 ], ucBenchIPAddress[ 2 ], ( uint8_t ) ( 100U + uxIndex ) );
+			vARPRefreshCacheEntry( &xMACAddress, ulARPLookupAddress );
+		}
+
+		if( ipconfigARP_CACHE_ENTRIES == 1 )
+		{
+			ulARPLookupAddress = FreeRTOS_inet_addr_quick( ucBenchPeerIPAddress[ 0 ], ucBenchPeerIPAddress[ 1 ], ucBenchPeerIPAddress[ 2 ], ucBenchPeerIPAddress[ 3 ] );
+		}
+
+		xDone = pdTRUE;
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunARPLookup( size_t uxCount )
+{
+MACAddress_t xMACAddress;
+uint32_t ulAddress;
+size_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		ulAddress = ulARPLookupAddress;
+		ulSink += ( uint32_t ) eARPGetCacheEntry( &( ulAddress ), &( xMACAddress ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunTCPLookup( size_t uxCount )
+{
+const uint32_t ulLocalIP = FreeRTOS_ntohl( FreeRTOS_inet_addr_quick( ucBenchIPAddress[ 0 ], ucBenchIPAddress[ 1 ], ucBenchIPAddress[ 2 ], ucBenchIPAddress[ 3 ] ) );
+const uint32_t ulPeerIP = FreeRTOS_ntohl( FreeRTOS_inet_addr_quick( ucBenchPeerIPAddress[ 0 ], ucBenchPeerIPAddress[ 1 ], ucBenchPeerIPAddress[ 2 ], ucBenchPeerIPAddress[ 3 ] ) );
+const UBaseType_t uxPeerPort = pxConnections[ xBenchOptions.uxConnectionCount - 1U ].usPeerPort;
+size_t uxIndex;
+
+	/* The connection that was made last. */
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		ulSink += ( uint32_t ) ( uintptr_t ) pxTCPSocketLookup( ulLocalIP, benchTCP_PORT, ulPeerIP, uxPeerPort );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSetupUDPLookup( void )
+{
+static BaseType_t xDone = pdFALSE;
+size_t uxIndex;
+
+	if( xDone == pdFALSE )
+	{
+		for( uxIndex = 0U; uxIndex < xBenchOptions.uxConnectionCount; uxIndex++ )
+		{
+			( void ) prvCreateBoundSocket( FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP, ( uint16_t ) ( benchUDP_LOOKUP_PORT + uxIndex ) );
+		}
+		xDone = pdTRUE;
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunUDPLookup( size_t uxCount )
+{
+const UBaseType_t uxPort = FreeRTOS_htons( ( uint16_t ) ( benchUDP_LOOKUP_PORT + xBenchOptions.uxConnectionCount - 1U ) );
+size_t uxIndex;
+
+	/* The socket that was bound last. */
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		ulSink += ( uint32_t ) ( uintptr_t ) pxUDPSocketLookup( uxPort );
+	}
+}
+/*-----------------------------------------------------------*/
+
+const BenchStage_t xSyntheticStages[] =
+{
+	{ "buffer", "get a network buffer, copy a UDP frame, release it", prvSetupFrames, NULL, prvRunBuffer, 0U },
+	{ "checksum", "usGenerateChecksum() over the payload", prvSetupFrames, NULL, prvRunChecksum, 0U },
+	{ "protocol-checksum-udp", "usGenerateProtocolChecksum() of a UDP frame", prvSetupFrames, NULL, prvRunProtocolChecksumUDP, 0U },
+	{ "protocol-checksum-tcp", "usGenerateProtocolChecksum() of a TCP frame", prvSetupFrames, NULL, prvRunProtocolChecksumTCP, 0U },
+	{ "consider-frame", "eConsiderFrameForProcessing() of a UDP frame", prvSetupFrames, NULL, prvRunConsiderFrame, 0U },
+	{ "ip-udp", "buffer + prvProcessIPPacket() of a UDP frame to a socket", prvSetupUDPSink, NULL, prvRunIPUDP, 0U },
+	{ "ethernet-udp", "buffer + prvProcessEthernetPacket() of a UDP frame", prvSetupUDPSink, NULL, prvRunEthernetUDP, 0U },
+	{ "tcp-segment", "buffer + xProcessReceivedTCPPacket() of an in-order segment", prvSetupConnections, prvPrepareTCPBatch, prvRunTCPSegment, benchTCP_BATCH },
+	{ "ip-tcp", "buffer + prvProcessIPPacket() of an in-order segment", prvSetupConnections, prvPrepareTCPBatch, prvRunIPTCP, benchTCP_BATCH },
+	{ "ethernet-tcp", "buffer + prvProcessEthernetPacket() of an in-order segment", prvSetupConnections, prvPrepareTCPBatch, prvRunEthernetTCP, benchTCP_BATCH },
+	{ "stream-buffer", "uxStreamBufferAdd() and uxStreamBufferGet() of the payload", prvSetupStreamBuffer, NULL, prvRunStreamBuffer, 0U },
+	{ "arp-lookup", "eARPGetCacheEntry() in a full cache", prvSetupARPCache, NULL, prvRunARPLookup, 0U },
+	{ "tcp-lookup", "pxTCPSocketLookup() among the connections", prvSetupConnections, NULL, prvRunTCPLookup, 0U },
+	{ "udp-lookup", "pxUDPSocketLookup() among as many UDP sockets", prvSetupUDPLookup, NULL, prvRunUDPLookup, 0U },
+	{ NULL, NULL, NULL, NULL, NULL, 0U }
+};
@@ -0,0 +1,49 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+#ifndef MICROBENCH_STUBS_H
+#define MICROBENCH_STUBS_H
+
+/*
+ * The microbenchmark runs without a scheduler.  kernel_stubs.c implements the
+ * kernel API that FreeRTOS+TCP uses for a single thread: nothing ever blocks,
+ * a queue that is full or empty makes the call fail at once, and the tick
+ * count follows CLOCK_MONOTONIC.  network_stubs.c is the network driver, it
+ * counts the frames that the stack sends and keeps a copy of the last one.
+ */
+
+/* Make 'xTask' the task that is running, as returned by
+xTaskGetCurrentTaskHandle().  The benchmark sets the IP-task, so that the stack
+behaves as if it were called from its own task. */
+void vStubSetCurrentTask( TaskHandle_t xTask );
+
+/* The number of frames that the stack has passed to xNetworkInterfaceOutput(). */
+uint32_t ulStubGetOutputCount( void );
+
+/* Copy the last frame that was sent to 'pucBuffer', and return its length.
+Frames that were longer than 'uxBufferLength' are truncated. */
+size_t uxStubGetLastOutput( uint8_t *pucBuffer, size_t uxBufferLength );
+
+#endif /* MICROBENCH_STUBS_H */
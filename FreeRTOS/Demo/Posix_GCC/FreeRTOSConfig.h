@@ -77,6 +77,10 @@ unsigned long ulGetRunTimeCounterValue( void ); /* Prototype of function that re
 void vConfigureTimerForRunTimeStats( void );	/* Prototype of function that initialises the run time counter. */
 #define configGENERATE_RUN_TIME_STATS			1
 
+/* The run time counter counts nanoseconds of CLOCK_MONOTONIC.  Set to 1 to
+count the CPU time of the process instead, see run-time-stats-utils.c. */
+#define configRUN_TIME_STATS_USE_CPU_TIME		0
+
 /* Co-routine related configuration options. */
 #define configUSE_CO_ROUTINES 					0
 #define configMAX_CO_ROUTINE_PRIORITIES			( 2 )
@@ -160,6 +164,20 @@ used with multiple project configurations.  If it is
 //#define ipconfigSOCK_DEFAULT_RECEIVE_BLOCK_TIME  pdMS_TO_TICKS(5000)
 #define configNETWORK_INTERFACE_TO_USE 1L
 
+/* The device used when the demo is built with "scons --tap" or "scons --tun",
+in stead of the pcap interface selected above.  The device must exist and be
+owned by the user, for instance after:
+    sudo ip tuntap add dev tap0 mode tap user $USER
+    sudo ip link set tap0 up
+A TUN device needs an address in the subnet of configIP_ADDR0..3 on the host
+side, the driver answers all ARP requests. */
+#if defined( configTAP_USE_TUN ) && ( configTAP_USE_TUN != 0 )
+	#define configTAP_DEVICE_NAME	"tun0"
+#else
+	#define configTAP_DEVICE_NAME	"tap0"
+#endif
+#define configTAP_QUEUES		1
+
 /* The address of an echo server that will be used by the two demo echo client
 tasks.
 http://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_Echo_Clients.html
@@ -78,6 +78,17 @@ used as defaults. */
 (non-Microsoft) */
 #define ipconfigUSE_LLMNR					( 1 )
 
+/* Let UDP sockets join multicast groups, and announce the memberships with
+IGMP.  The pcap driver then only passes the multicast frames of the groups that
+were joined, in stead of all multicast traffic on the network. */
+#define ipconfigUSE_IGMP					( 1 )
+#define ipconfigIGMP_DRIVER_MULTICAST_FILTER	( 1 )
+
+/* Queue outgoing packets per TOS class and send them with weighted round
+robin, so that sockets that set FREERTOS_SO_IP_TOS are not held up by bulk
+transfers. */
+#define ipconfigUSE_TX_SCHEDULER			( 1 )
+
 /* Include support for NBNS: NetBIOS Name Service (Microsoft) */
 #define ipconfigUSE_NBNS					( 1 )
 
@@ -204,6 +215,14 @@ be queued for processing at any one time.  The event queue must be a minimum of
 5 greater than the total number of network buffers. */
 #define ipconfigEVENT_QUEUE_LENGTH		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
 
+/* Timer events, socket API requests and ARP/DHCP packets are passed through a
+separate queue, which the IP-task empties first. */
+#define ipconfigUSE_PRIORITY_EVENT_QUEUES	1
+
+/* Count dropped packets and the TCP traffic of each socket, so they can be read
+with FreeRTOS_GetIPStats() and FreeRTOS_GetSocketStats(). */
+#define ipconfigUSE_NETWORK_STATS			1
+
 /* The address of a socket is the combination of its IP address and its port
 number.  FreeRTOS_bind() is used to manually allocate a port number to a socket
 (to 'bind' the socket to a port), but manual binding is not normally necessary
@@ -232,7 +251,10 @@ aborted. */
 contain.  For normal Ethernet V2 frames the maximum MTU is 1500.  Setting a
 lower value can save RAM, depending on the buffer management scheme used.  If
 ipconfigCAN_FRAGMENT_OUTGOING_PACKETS is 1 then (ipconfigNETWORK_MTU - 28) must
-be divisible by 8. */
+be divisible by 8.  Jumbo frames can be used on a LAN by setting the MTU to
+9000, when the host interface uses the same MTU ( e.g. "ip link set dev eth0 mtu
+9000" ).  The MSS is derived from the MTU and negotiated with each peer.  With
+BufferAllocation_1.c, see ipconfigNUM_SMALL_NETWORK_BUFFER_DESCRIPTORS. */
 #define ipconfigNETWORK_MTU		1200U
 
 /* Set ipconfigUSE_DNS to 1 to include a basic DNS client/resolver.  DNS is used
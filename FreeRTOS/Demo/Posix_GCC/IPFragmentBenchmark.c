@@ -0,0 +1,405 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A benchmark for the reassembly of fragmented IPv4 datagrams.
+ *
+ * A UDP socket is bound to port fragbenchPORT, and a task receives and counts
+ * the datagrams.  For every number of fragments per datagram from
+ * fragbenchMIN_FRAGMENTS to fragbenchMAX_FRAGMENTS, the benchmark task does
+ * two things:
+ *
+ * 1. It fills all reassembly slots with incomplete datagrams, and reports the
+ *    heap used while they wait for their last fragment.
+ * 2. It passes fragbenchDATAGRAM_COUNT complete datagrams to the IP-task, as
+ *    if they were received by the network driver, and reports the number of
+ *    datagrams and bytes that are delivered to the socket per second.
+ *
+ * The size of the fragments is chosen such that a datagram of
+ * fragbenchMAX_FRAGMENTS fragments still fits in ipconfigIP_REASSEMBLY_MAX_SIZE,
+ * so the datagrams grow with the number of fragments.
+ *
+ * ipconfigIP_REASSEMBLY_SLOTS must be positive in FreeRTOSIPConfig.h.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkBufferManagement.h"
+
+/* Demo application includes. */
+#include "console.h"
+#include "IPFragmentBenchmark.h"
+
+/* Exclude the whole file if FreeRTOSIPConfig.h does not enable reassembly. */
+#if ( ipconfigIP_REASSEMBLY_SLOTS > 0 )
+
+/* The port number that the receiving socket is bound to. */
+	#define fragbenchPORT				  ( 8090U )
+
+/* The range of fragments per datagram that is measured. */
+	#define fragbenchMIN_FRAGMENTS		  ( 2U )
+	#define fragbenchMAX_FRAGMENTS		  ( 8U )
+
+/* The number of datagrams passed to the IP-task per measurement. */
+	#define fragbenchDATAGRAM_COUNT		  ( 500U )
+
+/* The payload carried by each fragment: a multiple of 8 bytes that fits in the
+MTU, and small enough to let fragbenchMAX_FRAGMENTS fragments fit in a slot. */
+	#define fragbenchSLOT_FRAGMENT_SIZE	  ( ( ( ipconfigIP_REASSEMBLY_MAX_SIZE - ipSIZE_OF_IPv4_HEADER ) / fragbenchMAX_FRAGMENTS ) & ~7U )
+	#define fragbenchMTU_FRAGMENT_SIZE	  ( ( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER ) & ~7U )
+	#define fragbenchFRAGMENT_SIZE		  ( ( fragbenchSLOT_FRAGMENT_SIZE < fragbenchMTU_FRAGMENT_SIZE ) ? fragbenchSLOT_FRAGMENT_SIZE : fragbenchMTU_FRAGMENT_SIZE )
+
+/* The peer that sends the datagrams, in the 198.18.0.0/15 benchmark network. */
+	#define fragbenchPEER_IP			  FreeRTOS_inet_addr_quick( 198, 18, 1, 1 )
+	#define fragbenchPEER_PORT			  ( 30000U )
+
+/* The maximum time to wait for the IP-task and the receiving task. */
+	#define fragbenchTIMEOUT			  pdMS_TO_TICKS( 10000U )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Fills the slots, passes the datagrams to the IP-task and reports.
+ */
+	static void prvFragmentBenchmarkTask( void *pvParameters );
+
+/*
+ * Receives and counts the reassembled datagrams.
+ */
+	static void prvReceiveTask( void *pvParameters );
+
+/*
+ * Builds a complete UDP datagram with a valid checksum in ucDatagram[].
+ */
+	static void prvPrepareDatagram( size_t uxPayloadLength );
+
+/*
+ * Passes fragments of the datagram in ucDatagram[] to the IP-task, as if they
+ * were received by the network driver.  Only the fragments from uxFirst up to
+ * but not including uxLast are passed.
+ */
+	static void prvInjectFragments( uint16_t usIdentification,
+									size_t uxFragmentCount,
+									size_t uxFirst,
+									size_t uxLast );
+
+/*
+ * Waits until the receiving task has counted ulExpected datagrams.
+ */
+	static BaseType_t prvWaitForDatagrams( uint32_t ulExpected );
+
+/*
+ * Returns the number of bytes in use on the heap (heap_3 uses malloc()).
+ */
+	static size_t prvHeapInUse( void );
+
+/*-----------------------------------------------------------*/
+
+/* The number of datagrams and payload bytes received by prvReceiveTask(). */
+	static volatile uint32_t ulReceivedCount = 0U;
+	static volatile uint32_t ulReceivedBytes = 0U;
+
+/* The datagram that is being fragmented, including its Ethernet header. */
+	static uint8_t ucDatagram[ ipSIZE_OF_ETH_HEADER + ipconfigIP_REASSEMBLY_MAX_SIZE ];
+
+/* The MAC address of the simulated peer, a locally administered one. */
+	static const uint8_t ucPeerMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ] = { 0x02, 0x00, 0x00, 0x5a, 0x18, 0x02 };
+
+/*-----------------------------------------------------------*/
+
+	void vStartIPFragmentBenchmark( uint16_t usTaskStackSize,
+									UBaseType_t uxTaskPriority )
+	{
+		xTaskCreate( prvFragmentBenchmarkTask, "FragBench", usTaskStackSize, NULL, uxTaskPriority, NULL );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvFragmentBenchmarkTask( void *pvParameters )
+	{
+	size_t uxFragments, uxPayloadLength;
+	uint32_t ulIndex, ulExpected = 0U;
+	uint16_t usIdentification = 1U;
+	size_t uxHeapBefore, uxHeapWaiting;
+	uint32_t ulBytesBefore;
+	TickType_t xStartTime, xDuration;
+
+		( void ) pvParameters;
+
+		xTaskCreate( prvReceiveTask, "FragRecv", configMINIMAL_STACK_SIZE * 2, NULL, uxTaskPriorityGet( NULL ), NULL );
+
+		/* Let the receiving task bind its socket first. */
+		vTaskDelay( pdMS_TO_TICKS( 100U ) );
+
+		console_print( "Fragment benchmark: %u bytes per fragment, %u reassembly slots of %u bytes\n",
+					   ( unsigned ) fragbenchFRAGMENT_SIZE,
+					   ( unsigned ) ipconfigIP_REASSEMBLY_SLOTS,
+					   ( unsigned ) ipconfigIP_REASSEMBLY_MAX_SIZE );
+
+		for( uxFragments = fragbenchMIN_FRAGMENTS; uxFragments <= fragbenchMAX_FRAGMENTS; uxFragments++ )
+		{
+			/* The UDP header travels in the first fragment. */
+			uxPayloadLength = ( uxFragments * fragbenchFRAGMENT_SIZE ) - ipSIZE_OF_UDP_HEADER;
+			prvPrepareDatagram( uxPayloadLength );
+
+			/* Memory: hold back the last fragment of a datagram in every
+			slot. */
+			uxHeapBefore = prvHeapInUse();
+
+			for( ulIndex = 0U; ulIndex < ( uint32_t ) ipconfigIP_REASSEMBLY_SLOTS; ulIndex++ )
+			{
+				prvInjectFragments( ( uint16_t ) ( usIdentification + ulIndex ), uxFragments, 0U, uxFragments - 1U );
+			}
+
+			/* Let the IP-task handle the fragments. */
+			vTaskDelay( pdMS_TO_TICKS( 50U ) );
+			uxHeapWaiting = prvHeapInUse();
+
+			for( ulIndex = 0U; ulIndex < ( uint32_t ) ipconfigIP_REASSEMBLY_SLOTS; ulIndex++ )
+			{
+				prvInjectFragments( ( uint16_t ) ( usIdentification + ulIndex ), uxFragments, uxFragments - 1U, uxFragments );
+			}
+
+			usIdentification += ( uint16_t ) ipconfigIP_REASSEMBLY_SLOTS;
+			ulExpected += ( uint32_t ) ipconfigIP_REASSEMBLY_SLOTS;
+			( void ) prvWaitForDatagrams( ulExpected );
+
+			/* Throughput: complete datagrams, one after the other. */
+			ulBytesBefore = ulReceivedBytes;
+			xStartTime = xTaskGetTickCount();
+
+			for( ulIndex = 0U; ulIndex < fragbenchDATAGRAM_COUNT; ulIndex++ )
+			{
+				prvInjectFragments( usIdentification, uxFragments, 0U, uxFragments );
+				usIdentification++;
+			}
+
+			ulExpected += fragbenchDATAGRAM_COUNT;
+			( void ) prvWaitForDatagrams( ulExpected );
+			xDuration = xTaskGetTickCount() - xStartTime;
+
+			if( xDuration == 0U )
+			{
+				xDuration = 1U;
+			}
+
+			console_print( "%u fragments: %lu bytes per waiting datagram, %lu datagrams/s, %lu KB/s\n",
+						   ( unsigned ) uxFragments,
+						   ( unsigned long ) ( ( uxHeapWaiting - uxHeapBefore ) / ipconfigIP_REASSEMBLY_SLOTS ),
+						   ( unsigned long ) ( ( fragbenchDATAGRAM_COUNT * 1000UL ) / ( xDuration * portTICK_PERIOD_MS ) ),
+						   ( unsigned long ) ( ( ulReceivedBytes - ulBytesBefore ) / ( xDuration * portTICK_PERIOD_MS ) ) );
+		}
+
+		console_print( "Fragment benchmark: %lu datagrams received, at least %lu network buffers were free\n",
+					   ( unsigned long ) ulReceivedCount,
+					   ( unsigned long ) uxGetMinimumFreeNetworkBuffers() );
+
+		vTaskDelete( NULL );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvReceiveTask( void *pvParameters )
+	{
+	Socket_t xSocket;
+	struct freertos_sockaddr xBindAddress, xSource;
+	socklen_t xSourceLength = sizeof( xSource );
+	uint8_t *pucPayload;
+	int32_t lReceived;
+
+		( void ) pvParameters;
+
+		xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+		configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+
+		xBindAddress.sin_port = FreeRTOS_htons( fragbenchPORT );
+		xBindAddress.sin_addr = 0U;
+		FreeRTOS_bind( xSocket, &xBindAddress, sizeof( xBindAddress ) );
+
+		for( ; ; )
+		{
+			/* Zero-copy, the contents are not used. */
+			lReceived = FreeRTOS_recvfrom( xSocket, &pucPayload, 0U, FREERTOS_ZERO_COPY, &xSource, &xSourceLength );
+
+			if( lReceived > 0 )
+			{
+				ulReceivedBytes += ( uint32_t ) lReceived;
+				ulReceivedCount++;
+				FreeRTOS_ReleaseUDPPayloadBuffer( pucPayload );
+			}
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvPrepareDatagram( size_t uxPayloadLength )
+	{
+	UDPPacket_t *pxUDPPacket = ( UDPPacket_t * ) ucDatagram;
+	size_t uxIPLength = ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_UDP_HEADER + uxPayloadLength;
+	size_t uxIndex;
+
+		( void ) memset( ucDatagram, 0, sizeof( UDPPacket_t ) );
+
+		( void ) memcpy( pxUDPPacket->xEthernetHeader.xDestinationAddress.ucBytes, FreeRTOS_GetMACAddress(), ipMAC_ADDRESS_LENGTH_BYTES );
+		( void ) memcpy( pxUDPPacket->xEthernetHeader.xSourceAddress.ucBytes, ucPeerMACAddress, ipMAC_ADDRESS_LENGTH_BYTES );
+		pxUDPPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+
+		pxUDPPacket->xIPHeader.ucVersionHeaderLength = 0x45U;
+		pxUDPPacket->xIPHeader.usLength = FreeRTOS_htons( ( uint16_t ) uxIPLength );
+		pxUDPPacket->xIPHeader.ucTimeToLive = 64U;
+		pxUDPPacket->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_UDP;
+		pxUDPPacket->xIPHeader.ulSourceIPAddress = fragbenchPEER_IP;
+		pxUDPPacket->xIPHeader.ulDestinationIPAddress = FreeRTOS_GetIPAddress();
+
+		pxUDPPacket->xUDPHeader.usSourcePort = FreeRTOS_htons( fragbenchPEER_PORT );
+		pxUDPPacket->xUDPHeader.usDestinationPort = FreeRTOS_htons( fragbenchPORT );
+		pxUDPPacket->xUDPHeader.usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_UDP_HEADER + uxPayloadLength ) );
+
+		for( uxIndex = 0U; uxIndex < uxPayloadLength; uxIndex++ )
+		{
+			ucDatagram[ sizeof( UDPPacket_t ) + uxIndex ] = ( uint8_t ) uxIndex;
+		}
+
+		/* The checksum covers the whole datagram, so it is only valid after a
+		correct reassembly. */
+		( void ) usGenerateProtocolChecksum( ucDatagram, ipSIZE_OF_ETH_HEADER + uxIPLength, pdTRUE );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvInjectFragments( uint16_t usIdentification,
+									size_t uxFragmentCount,
+									size_t uxFirst,
+									size_t uxLast )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	IPPacket_t *pxIPPacket;
+	IPStackEvent_t xRxEvent;
+	size_t uxIndex, uxOffset, uxLength;
+	size_t uxTotal = ( size_t ) FreeRTOS_ntohs( ( ( IPPacket_t * ) ucDatagram )->xIPHeader.usLength ) - ipSIZE_OF_IPv4_HEADER;
+	uint16_t usFragmentField;
+
+		for( uxIndex = uxFirst; uxIndex < uxLast; uxIndex++ )
+		{
+			uxOffset = uxIndex * fragbenchFRAGMENT_SIZE;
+			uxLength = ( uxIndex == ( uxFragmentCount - 1U ) ) ? ( uxTotal - uxOffset ) : fragbenchFRAGMENT_SIZE;
+
+			pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + uxLength, portMAX_DELAY );
+
+			if( pxNetworkBuffer != NULL )
+			{
+				pxIPPacket = ( IPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+
+				/* The Ethernet and IP headers of the datagram, and a slice of
+				its payload. */
+				( void ) memcpy( pxNetworkBuffer->pucEthernetBuffer, ucDatagram, sizeof( IPPacket_t ) );
+				( void ) memcpy( &( pxNetworkBuffer->pucEthernetBuffer[ sizeof( IPPacket_t ) ] ), &( ucDatagram[ sizeof( IPPacket_t ) + uxOffset ] ), uxLength );
+
+				usFragmentField = ( uint16_t ) ( uxOffset / 8U );
+
+				if( uxIndex < ( uxFragmentCount - 1U ) )
+				{
+					/* The "more fragments" flag. */
+					usFragmentField |= 0x2000U;
+				}
+
+				pxIPPacket->xIPHeader.usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_IPv4_HEADER + uxLength ) );
+				pxIPPacket->xIPHeader.usIdentification = FreeRTOS_htons( usIdentification );
+				pxIPPacket->xIPHeader.usFragmentOffset = FreeRTOS_htons( usFragmentField );
+				pxIPPacket->xIPHeader.usHeaderChecksum = 0U;
+				pxIPPacket->xIPHeader.usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPPacket->xIPHeader ), ipSIZE_OF_IPv4_HEADER );
+				pxIPPacket->xIPHeader.usHeaderChecksum = ~FreeRTOS_htons( pxIPPacket->xIPHeader.usHeaderChecksum );
+
+				pxNetworkBuffer->xDataLength = sizeof( IPPacket_t ) + uxLength;
+
+				xRxEvent.eEventType = eNetworkRxEvent;
+				xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+
+				if( xSendEventStructToIPTask( &xRxEvent, portMAX_DELAY ) == pdFAIL )
+				{
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+				}
+			}
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvWaitForDatagrams( uint32_t ulExpected )
+	{
+	TickType_t xStartTime = xTaskGetTickCount();
+	BaseType_t xReturn = pdPASS;
+
+		while( ulReceivedCount < ulExpected )
+		{
+			if( ( xTaskGetTickCount() - xStartTime ) >= fragbenchTIMEOUT )
+			{
+				console_print( "Fragment benchmark: %lu of %lu datagrams received\n",
+							   ( unsigned long ) ulReceivedCount,
+							   ( unsigned long ) ulExpected );
+				xReturn = pdFAIL;
+				break;
+			}
+
+			vTaskDelay( 1U );
+		}
+
+		return xReturn;
+	}
+/*-----------------------------------------------------------*/
+
+	static size_t prvHeapInUse( void )
+	{
+	size_t uxInUse;
+
+		#if defined( __GLIBC__ ) && ( ( __GLIBC__ > 2 ) || ( ( __GLIBC__ == 2 ) && ( __GLIBC_MINOR__ >= 33 ) ) )
+		{
+		struct mallinfo2 xInfo = mallinfo2();
+
+			uxInUse = xInfo.uordblks;
+		}
+		#else
+		{
+		struct mallinfo xInfo = mallinfo();
+
+			uxInUse = ( size_t ) xInfo.uordblks;
+		}
+		#endif
+
+		return uxInUse;
+	}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigIP_REASSEMBLY_SLOTS */
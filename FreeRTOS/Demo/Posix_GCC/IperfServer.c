@@ -0,0 +1,917 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A server for the iperf3 protocol, see https://github.com/esnet/iperf.
+ *
+ * The task listens on port iperfPORT and runs one test at a time, like
+ * "iperf3 -s".  A stock iperf3 client on the host can be used, for instance:
+ *
+ *     iperf3 -c <address> -t 10              TCP, from the client to the server
+ *     iperf3 -c <address> -t 10 -R -P 4      TCP, from the server, 4 streams
+ *     iperf3 -c <address> -u -b 50M -l 1000  UDP, from the client to the server
+ *
+ * The control connection carries one-byte states, and JSON documents that are
+ * preceded by their length in 4 bytes.  Only the few keys that are needed are
+ * looked up in the parameters of the client.  UDP from the server to the
+ * client, and bidirectional tests, are refused.  The UDP datagrams must fit in
+ * ipconfigNETWORK_MTU, hence the "-l" option.
+ *
+ * The results that the server sends back contain its byte counts, the jitter
+ * and the losses of the UDP streams, the retransmissions of its TCP streams
+ * when ipconfigUSE_NETWORK_STATS is set, and the CPU time of the process.
+ *
+ * ipconfigSUPPORT_SELECT_FUNCTION must be set to 1 in FreeRTOSIPConfig.h.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_Stats.h"
+
+/* Demo application includes. */
+#include "console.h"
+#include "IperfServer.h"
+
+/* Exclude the whole file if FreeRTOSIPConfig.h does not enable select(). */
+#if ( ipconfigUSE_TCP == 1 ) && ( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+
+/* The port of the control connection and of the data streams. */
+	#define iperfPORT					( 5201U )
+
+/* The states that are sent over the control connection. */
+	#define iperfTEST_START				( 1 )
+	#define iperfTEST_RUNNING			( 2 )
+	#define iperfTEST_END				( 4 )
+	#define iperfPARAM_EXCHANGE			( 9 )
+	#define iperfCREATE_STREAMS			( 10 )
+	#define iperfEXCHANGE_RESULTS		( 13 )
+	#define iperfDISPLAY_RESULTS		( 14 )
+	#define iperfIPERF_DONE				( 16 )
+	#define iperfACCESS_DENIED			( -1 )
+
+/* All connections of a test start with the same cookie. */
+	#define iperfCOOKIE_SIZE			( 37U )
+
+/* The answer to the datagram that opens a UDP stream, "9876" in the byte order
+of the host, as the client expects it. */
+	#define iperfUDP_CONNECT_REPLY		( 0x39383736UL )
+
+/* The maximum number of parallel streams, the "-P" option of the client. */
+	#define iperfMAX_STREAMS			( 8U )
+
+/* The size of the buffer of the data streams, and the maximum size of a JSON
+document. */
+	#define iperfBUFFER_SIZE			( 16384U )
+	#define iperfJSON_SIZE				( 2048U )
+
+/* The buffer and window sizes of the TCP connections, in segments. */
+	#define iperfTCP_BUFFER_SEGMENTS	( 32 )
+	#define iperfTCP_WINDOW_SEGMENTS	( 16 )
+
+/* The maximum time to wait for the client, and the time select() waits before
+the control connection is checked again. */
+	#define iperfTIMEOUT				pdMS_TO_TICKS( 10000U )
+	#define iperfSELECT_TIME			pdMS_TO_TICKS( 100U )
+
+/*-----------------------------------------------------------*/
+
+/* The counters of one data stream. */
+	typedef struct xIPERF_STREAM
+	{
+		Socket_t xSocket;			/* The TCP connection, or NULL for a UDP stream. */
+		uint32_t ulPeerAddress;		/* The address and port of a UDP stream, in network byte order. */
+		uint16_t usPeerPort;
+		uint64_t ullBytes;			/* The bytes received, or sent in the reverse direction. */
+		uint64_t ullPackets;		/* The highest UDP sequence number seen. */
+		uint64_t ullErrors;			/* The UDP datagrams that did not arrive. */
+		double dJitter;				/* The UDP jitter in seconds, as defined in RFC 1889. */
+		double dPreviousTransit;
+	} IperfStream_t;
+
+/* The parameters and the state of the running test. */
+	typedef struct xIPERF_TEST
+	{
+		Socket_t xControlSocket;
+		Socket_t xUDPSocket;
+		SocketSet_t xSocketSet;
+		char cCookie[ iperfCOOKIE_SIZE ];
+		BaseType_t xUDP;
+		BaseType_t xReverse;
+		BaseType_t xCounters64;		/* The UDP sequence numbers have 64 bits. */
+		size_t uxBlockSize;			/* The "-l" option of the client. */
+		UBaseType_t uxStreamCount;
+		IperfStream_t xStreams[ iperfMAX_STREAMS ];
+		struct timespec xStartTime;
+		double dDuration;
+		struct rusage xStartUsage;
+		struct rusage xEndUsage;
+	} IperfTest_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Accepts control connections and runs the tests, one after the other.
+ */
+	static void prvIperfServerTask( void *pvParameters );
+
+/*
+ * Runs the test of the client that has connected 'xControlSocket'.
+ */
+	static void prvRunTest( Socket_t xListeningSocket,
+							Socket_t xControlSocket );
+
+/*
+ * Reads the parameters of the client.  Returns pdFAIL when the test can not be
+ * run.
+ */
+	static BaseType_t prvReadParameters( IperfTest_t *pxTest );
+
+/*
+ * Accepts the TCP connections, or receives the first datagram of the UDP
+ * streams, of the test.
+ */
+	static BaseType_t prvCreateStreams( IperfTest_t *pxTest,
+										Socket_t xListeningSocket );
+
+/*
+ * Moves the data until the client sends TEST_END.  Returns pdFAIL when the
+ * control connection was lost.
+ */
+	static BaseType_t prvExchangeData( IperfTest_t *pxTest );
+
+/*
+ * Receives the waiting datagrams and updates the counters of their streams.
+ */
+	static void prvReceiveDatagrams( IperfTest_t *pxTest );
+
+/*
+ * Writes the results of the server as a JSON document.
+ */
+	static void prvFormatResults( const IperfTest_t *pxTest,
+								  char *pcBuffer,
+								  size_t uxBufferSize );
+
+/*
+ * Closes all sockets of the test.
+ */
+	static void prvCloseTest( IperfTest_t *pxTest );
+
+/*
+ * Sends or receives exactly 'uxLength' bytes.
+ */
+	static BaseType_t prvSendAll( Socket_t xSocket,
+								  const void *pvBuffer,
+								  size_t uxLength );
+	static BaseType_t prvReceiveAll( Socket_t xSocket,
+									 void *pvBuffer,
+									 size_t uxLength );
+
+/*
+ * Sends a state, or a JSON document preceded by its length.
+ */
+	static BaseType_t prvSendState( Socket_t xSocket,
+									int8_t cState );
+	static BaseType_t prvSendJSON( Socket_t xSocket,
+								   const char *pcJSON );
+
+/*
+ * Receives a JSON document.  A document that does not fit in the buffer is
+ * truncated, the rest is read and dropped.
+ */
+	static BaseType_t prvReceiveJSON( Socket_t xSocket,
+									  char *pcBuffer,
+									  size_t uxBufferSize );
+
+/*
+ * Returns the number or boolean value of 'pcKey', or 'lDefault' when the key
+ * is not found.
+ */
+	static long prvJSONGetInteger( const char *pcJSON,
+								   const char *pcKey,
+								   long lDefault );
+
+/*-----------------------------------------------------------*/
+
+/* Only one test runs at a time. */
+	static IperfTest_t xTest;
+
+/* The data of the streams, and the JSON documents. */
+	static uint8_t ucDataBuffer[ iperfBUFFER_SIZE ];
+	static char cJSONBuffer[ iperfJSON_SIZE ];
+
+/*-----------------------------------------------------------*/
+
+	void vStartIperfServer( uint16_t usTaskStackSize,
+							UBaseType_t uxTaskPriority )
+	{
+		xTaskCreate( prvIperfServerTask, "iperf3", usTaskStackSize, NULL, uxTaskPriority, NULL );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvIperfServerTask( void *pvParameters )
+	{
+	Socket_t xListeningSocket, xControlSocket;
+	struct freertos_sockaddr xBindAddress, xClient;
+	socklen_t xSize = sizeof( xClient );
+	const TickType_t xTimeOut = iperfTIMEOUT;
+	const BaseType_t xBacklog = ( BaseType_t ) iperfMAX_STREAMS + 1;
+	WinProperties_t xWinProperties;
+
+		( void ) pvParameters;
+
+		/* The server runs on stack 0, also when more stacks are started. */
+		( void ) FreeRTOS_SetIPStack( 0U );
+
+		xListeningSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+		configASSERT( xListeningSocket != FREERTOS_INVALID_SOCKET );
+
+		/* The connections inherit the buffer sizes of the listening socket. */
+		memset( &xWinProperties, 0, sizeof( xWinProperties ) );
+		xWinProperties.lTxBufSize = iperfTCP_BUFFER_SEGMENTS * ipconfigTCP_MSS;
+		xWinProperties.lTxWinSize = iperfTCP_WINDOW_SEGMENTS;
+		xWinProperties.lRxBufSize = iperfTCP_BUFFER_SEGMENTS * ipconfigTCP_MSS;
+		xWinProperties.lRxWinSize = iperfTCP_WINDOW_SEGMENTS;
+		FreeRTOS_setsockopt( xListeningSocket, 0, FREERTOS_SO_WIN_PROPERTIES, &xWinProperties, sizeof( xWinProperties ) );
+		FreeRTOS_setsockopt( xListeningSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+		xBindAddress.sin_port = FreeRTOS_htons( iperfPORT );
+		xBindAddress.sin_addr = 0U;
+		FreeRTOS_bind( xListeningSocket, &xBindAddress, sizeof( xBindAddress ) );
+		FreeRTOS_listen( xListeningSocket, xBacklog );
+
+		console_print( "iperf3 server: listening on port %u\n", ( unsigned ) iperfPORT );
+
+		for( ; ; )
+		{
+			xControlSocket = FreeRTOS_accept( xListeningSocket, &xClient, &xSize );
+
+			if( ( xControlSocket == NULL ) || ( xControlSocket == FREERTOS_INVALID_SOCKET ) )
+			{
+				continue;
+			}
+
+			prvRunTest( xListeningSocket, xControlSocket );
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvRunTest( Socket_t xListeningSocket,
+							Socket_t xControlSocket )
+	{
+	IperfTest_t *pxTest = &xTest;
+	const TickType_t xTimeOut = iperfTIMEOUT;
+	struct timespec xEndTime;
+	uint64_t ullTotal = 0U;
+	UBaseType_t uxIndex;
+	char cState;
+
+		memset( pxTest, 0, sizeof( *pxTest ) );
+		pxTest->xControlSocket = xControlSocket;
+		FreeRTOS_setsockopt( xControlSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		FreeRTOS_setsockopt( xControlSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+		do
+		{
+			if( prvReceiveAll( xControlSocket, pxTest->cCookie, sizeof( pxTest->cCookie ) ) == pdFAIL )
+			{
+				break;
+			}
+
+			if( prvReadParameters( pxTest ) == pdFAIL )
+			{
+				( void ) prvSendState( xControlSocket, iperfACCESS_DENIED );
+				break;
+			}
+
+			pxTest->xSocketSet = FreeRTOS_CreateSocketSet();
+
+			if( ( pxTest->xSocketSet == NULL ) || ( prvCreateStreams( pxTest, xListeningSocket ) == pdFAIL ) )
+			{
+				console_print( "iperf3 server: the streams could not be created\n" );
+				break;
+			}
+
+			clock_gettime( CLOCK_MONOTONIC, &( pxTest->xStartTime ) );
+			getrusage( RUSAGE_SELF, &( pxTest->xStartUsage ) );
+
+			if( ( prvSendState( xControlSocket, iperfTEST_START ) == pdFAIL ) ||
+				( prvSendState( xControlSocket, iperfTEST_RUNNING ) == pdFAIL ) ||
+				( prvExchangeData( pxTest ) == pdFAIL ) )
+			{
+				break;
+			}
+
+			clock_gettime( CLOCK_MONOTONIC, &xEndTime );
+			getrusage( RUSAGE_SELF, &( pxTest->xEndUsage ) );
+			pxTest->dDuration = ( double ) ( xEndTime.tv_sec - pxTest->xStartTime.tv_sec ) +
+								( ( double ) ( xEndTime.tv_nsec - pxTest->xStartTime.tv_nsec ) / 1.0e9 );
+
+			/* The client sends its results first. */
+			if( ( prvSendState( xControlSocket, iperfEXCHANGE_RESULTS ) == pdFAIL ) ||
+				( prvReceiveJSON( xControlSocket, cJSONBuffer, sizeof( cJSONBuffer ) ) == pdFAIL ) )
+			{
+				break;
+			}
+
+			prvFormatResults( pxTest, cJSONBuffer, sizeof( cJSONBuffer ) );
+
+			if( ( prvSendJSON( xControlSocket, cJSONBuffer ) == pdFAIL ) ||
+				( prvSendState( xControlSocket, iperfDISPLAY_RESULTS ) == pdFAIL ) )
+			{
+				break;
+			}
+
+			/* Wait for IPERF_DONE, or for the client to close the connection. */
+			( void ) prvReceiveAll( xControlSocket, &cState, sizeof( cState ) );
+
+			for( uxIndex = 0U; uxIndex < pxTest->uxStreamCount; uxIndex++ )
+			{
+				ullTotal += pxTest->xStreams[ uxIndex ].ullBytes;
+			}
+
+			console_print( "iperf3 server: %s %s, %u streams, %llu bytes in %.3f s, %.3f Gbit/s\n",
+						   ( pxTest->xUDP != pdFALSE ) ? "UDP" : "TCP",
+						   ( pxTest->xReverse != pdFALSE ) ? "sent" : "received",
+						   ( unsigned ) pxTest->uxStreamCount,
+						   ( unsigned long long ) ullTotal,
+						   pxTest->dDuration,
+						   ( pxTest->dDuration > 0.0 ) ? ( ( ( double ) ullTotal * 8.0 ) / pxTest->dDuration / 1.0e9 ) : 0.0 );
+		} while( ipFALSE_BOOL );
+
+		prvCloseTest( pxTest );
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvReadParameters( IperfTest_t *pxTest )
+	{
+	BaseType_t xReturn = pdFAIL;
+	long lStreamCount;
+
+		if( ( prvSendState( pxTest->xControlSocket, iperfPARAM_EXCHANGE ) == pdPASS ) &&
+			( prvReceiveJSON( pxTest->xControlSocket, cJSONBuffer, sizeof( cJSONBuffer ) ) == pdPASS ) )
+		{
+			pxTest->xUDP = ( prvJSONGetInteger( cJSONBuffer, "udp", 0 ) != 0 ) ? pdTRUE : pdFALSE;
+			pxTest->xReverse = ( prvJSONGetInteger( cJSONBuffer, "reverse", 0 ) != 0 ) ? pdTRUE : pdFALSE;
+			pxTest->xCounters64 = ( prvJSONGetInteger( cJSONBuffer, "udp_counters_64bit", 0 ) != 0 ) ? pdTRUE : pdFALSE;
+			pxTest->uxBlockSize = ( size_t ) prvJSONGetInteger( cJSONBuffer, "len", ( long ) iperfBUFFER_SIZE );
+			lStreamCount = prvJSONGetInteger( cJSONBuffer, "parallel", 1 );
+
+			if( ( pxTest->uxBlockSize == 0U ) || ( pxTest->uxBlockSize > sizeof( ucDataBuffer ) ) )
+			{
+				pxTest->uxBlockSize = sizeof( ucDataBuffer );
+			}
+
+			if( ( lStreamCount < 1 ) || ( lStreamCount > ( long ) iperfMAX_STREAMS ) )
+			{
+				console_print( "iperf3 server: at most %u parallel streams are supported\n", ( unsigned ) iperfMAX_STREAMS );
+			}
+			else if( prvJSONGetInteger( cJSONBuffer, "bidirectional", 0 ) != 0 )
+			{
+				console_print( "iperf3 server: bidirectional tests are not supported\n" );
+			}
+			else if( ( pxTest->xUDP != pdFALSE ) && ( pxTest->xReverse != pdFALSE ) )
+			{
+				console_print( "iperf3 server: UDP in the reverse direction is not supported\n" );
+			}
+			else
+			{
+				pxTest->uxStreamCount = ( UBaseType_t ) lStreamCount;
+				xReturn = pdPASS;
+			}
+		}
+
+		return xReturn;
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvCreateStreams( IperfTest_t *pxTest,
+										Socket_t xListeningSocket )
+	{
+	IperfStream_t *pxStream;
+	struct freertos_sockaddr xAddress;
+	socklen_t xSize = sizeof( xAddress );
+	const TickType_t xTimeOut = iperfTIMEOUT;
+	char cCookie[ iperfCOOKIE_SIZE ];
+	uint32_t ulMessage;
+	UBaseType_t uxIndex = 0U;
+	TickType_t xStartTime = xTaskGetTickCount();
+	int32_t lReceived;
+
+		if( pxTest->xUDP != pdFALSE )
+		{
+			/* All UDP streams arrive at the same port, they are told apart by
+			the port of the client. */
+			pxTest->xUDPSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+
+			if( pxTest->xUDPSocket == FREERTOS_INVALID_SOCKET )
+			{
+				pxTest->xUDPSocket = NULL;
+				return pdFAIL;
+			}
+
+			FreeRTOS_setsockopt( pxTest->xUDPSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+			xAddress.sin_port = FreeRTOS_htons( iperfPORT );
+			xAddress.sin_addr = 0U;
+			FreeRTOS_bind( pxTest->xUDPSocket, &xAddress, sizeof( xAddress ) );
+		}
+
+		if( prvSendState( pxTest->xControlSocket, iperfCREATE_STREAMS ) == pdFAIL )
+		{
+			return pdFAIL;
+		}
+
+		while( ( uxIndex < pxTest->uxStreamCount ) && ( ( xTaskGetTickCount() - xStartTime ) < iperfTIMEOUT ) )
+		{
+			pxStream = &( pxTest->xStreams[ uxIndex ] );
+
+			if( pxTest->xUDP != pdFALSE )
+			{
+				lReceived = FreeRTOS_recvfrom( pxTest->xUDPSocket, &ulMessage, sizeof( ulMessage ), 0, &xAddress, &xSize );
+
+				if( lReceived == ( int32_t ) sizeof( ulMessage ) )
+				{
+					pxStream->ulPeerAddress = xAddress.sin_addr;
+					pxStream->usPeerPort = xAddress.sin_port;
+					ulMessage = iperfUDP_CONNECT_REPLY;
+					FreeRTOS_sendto( pxTest->xUDPSocket, &ulMessage, sizeof( ulMessage ), 0, &xAddress, sizeof( xAddress ) );
+					uxIndex++;
+				}
+			}
+			else
+			{
+				pxStream->xSocket = FreeRTOS_accept( xListeningSocket, &xAddress, &xSize );
+
+				if( ( pxStream->xSocket == NULL ) || ( pxStream->xSocket == FREERTOS_INVALID_SOCKET ) )
+				{
+					pxStream->xSocket = NULL;
+					continue;
+				}
+
+				/* A connection of another client is closed, only one test
+				runs at a time. */
+				FreeRTOS_setsockopt( pxStream->xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+				if( ( prvReceiveAll( pxStream->xSocket, cCookie, sizeof( cCookie ) ) == pdFAIL ) ||
+					( memcmp( cCookie, pxTest->cCookie, sizeof( cCookie ) ) != 0 ) )
+				{
+					FreeRTOS_closesocket( pxStream->xSocket );
+					pxStream->xSocket = NULL;
+					continue;
+				}
+
+				FreeRTOS_FD_SET( pxStream->xSocket, pxTest->xSocketSet, ( pxTest->xReverse != pdFALSE ) ? eSELECT_WRITE : eSELECT_READ );
+				uxIndex++;
+			}
+		}
+
+		if( pxTest->xUDPSocket != NULL )
+		{
+			FreeRTOS_FD_SET( pxTest->xUDPSocket, pxTest->xSocketSet, eSELECT_READ );
+		}
+
+		FreeRTOS_FD_SET( pxTest->xControlSocket, pxTest->xSocketSet, eSELECT_READ );
+
+		return ( uxIndex == pxTest->uxStreamCount ) ? pdPASS : pdFAIL;
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvExchangeData( IperfTest_t *pxTest )
+	{
+	IperfStream_t *pxStream;
+	UBaseType_t uxIndex;
+	BaseType_t xResult;
+	char cState;
+
+		for( ; ; )
+		{
+			( void ) FreeRTOS_select( pxTest->xSocketSet, iperfSELECT_TIME );
+
+			for( uxIndex = 0U; uxIndex < pxTest->uxStreamCount; uxIndex++ )
+			{
+				pxStream = &( pxTest->xStreams[ uxIndex ] );
+
+				if( ( pxStream->xSocket == NULL ) || ( FreeRTOS_FD_ISSET( pxStream->xSocket, pxTest->xSocketSet ) == 0U ) )
+				{
+					continue;
+				}
+
+				for( ; ; )
+				{
+					if( pxTest->xReverse != pdFALSE )
+					{
+						xResult = FreeRTOS_send( pxStream->xSocket, ucDataBuffer, pxTest->uxBlockSize, FREERTOS_MSG_DONTWAIT );
+					}
+					else
+					{
+						xResult = FreeRTOS_recv( pxStream->xSocket, ucDataBuffer, sizeof( ucDataBuffer ), FREERTOS_MSG_DONTWAIT );
+					}
+
+					if( xResult > 0 )
+					{
+						pxStream->ullBytes += ( uint64_t ) xResult;
+					}
+					else
+					{
+						if( ( xResult < 0 ) && ( xResult != -pdFREERTOS_ERRNO_ENOSPC ) )
+						{
+							/* The client has closed the stream. */
+							FreeRTOS_FD_CLR( pxStream->xSocket, pxTest->xSocketSet, eSELECT_ALL );
+							FreeRTOS_closesocket( pxStream->xSocket );
+							pxStream->xSocket = NULL;
+						}
+
+						break;
+					}
+				}
+			}
+
+			if( pxTest->xUDPSocket != NULL )
+			{
+				prvReceiveDatagrams( pxTest );
+			}
+
+			xResult = FreeRTOS_recv( pxTest->xControlSocket, &cState, sizeof( cState ), FREERTOS_MSG_DONTWAIT );
+
+			if( xResult < 0 )
+			{
+				console_print( "iperf3 server: the control connection was lost\n" );
+				break;
+			}
+
+			if( ( xResult > 0 ) && ( cState == iperfTEST_END ) )
+			{
+				/* Take the datagrams that are still waiting. */
+				if( pxTest->xUDPSocket != NULL )
+				{
+					prvReceiveDatagrams( pxTest );
+				}
+
+				return pdPASS;
+			}
+		}
+
+		return pdFAIL;
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvReceiveDatagrams( IperfTest_t *pxTest )
+	{
+	IperfStream_t *pxStream;
+	struct freertos_sockaddr xAddress;
+	socklen_t xSize = sizeof( xAddress );
+	struct timespec xNow;
+	uint32_t ulHeader[ 4 ];
+	uint64_t ullSequence;
+	double dTransit, dDelta;
+	UBaseType_t uxIndex;
+	int32_t lReceived;
+
+		for( ; ; )
+		{
+			lReceived = FreeRTOS_recvfrom( pxTest->xUDPSocket, ucDataBuffer, sizeof( ucDataBuffer ), FREERTOS_MSG_DONTWAIT, &xAddress, &xSize );
+
+			if( lReceived < ( int32_t ) ( 3U * sizeof( uint32_t ) ) )
+			{
+				break;
+			}
+
+			for( uxIndex = 0U; uxIndex < pxTest->uxStreamCount; uxIndex++ )
+			{
+				pxStream = &( pxTest->xStreams[ uxIndex ] );
+
+				if( ( pxStream->ulPeerAddress == xAddress.sin_addr ) && ( pxStream->usPeerPort == xAddress.sin_port ) )
+				{
+					break;
+				}
+			}
+
+			if( uxIndex == pxTest->uxStreamCount )
+			{
+				continue;
+			}
+
+			/* The header holds the time at which the client sent the datagram,
+			in seconds and microseconds, and a sequence number of 32 or 64 bits,
+			all in network byte order. */
+			clock_gettime( CLOCK_REALTIME, &xNow );
+			memcpy( ulHeader, ucDataBuffer, ( lReceived >= ( int32_t ) sizeof( ulHeader ) ) ? sizeof( ulHeader ) : ( 3U * sizeof( uint32_t ) ) );
+
+			if( ( pxTest->xCounters64 != pdFALSE ) && ( lReceived >= ( int32_t ) sizeof( ulHeader ) ) )
+			{
+				ullSequence = ( ( uint64_t ) FreeRTOS_ntohl( ulHeader[ 2 ] ) << 32 ) | FreeRTOS_ntohl( ulHeader[ 3 ] );
+			}
+			else
+			{
+				ullSequence = FreeRTOS_ntohl( ulHeader[ 2 ] );
+			}
+
+			pxStream->ullBytes += ( uint64_t ) lReceived;
+
+			/* Count the losses and the late arrivals like iperf3 does. */
+			if( ullSequence >= ( pxStream->ullPackets + 1U ) )
+			{
+				pxStream->ullErrors += ullSequence - pxStream->ullPackets - 1U;
+				pxStream->ullPackets = ullSequence;
+			}
+			else if( pxStream->ullErrors > 0U )
+			{
+				pxStream->ullErrors--;
+			}
+
+			dTransit = ( ( double ) xNow.tv_sec + ( ( double ) xNow.tv_nsec / 1.0e9 ) ) -
+					   ( ( double ) FreeRTOS_ntohl( ulHeader[ 0 ] ) + ( ( double ) FreeRTOS_ntohl( ulHeader[ 1 ] ) / 1.0e6 ) );
+			dDelta = dTransit - pxStream->dPreviousTransit;
+
+			if( dDelta < 0.0 )
+			{
+				dDelta = -dDelta;
+			}
+
+			pxStream->dPreviousTransit = dTransit;
+			pxStream->dJitter += ( dDelta - pxStream->dJitter ) / 16.0;
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvFormatResults( const IperfTest_t *pxTest,
+								  char *pcBuffer,
+								  size_t uxBufferSize )
+	{
+	const IperfStream_t *pxStream;
+	double dUser, dSystem;
+	long lRetransmits;
+	BaseType_t xHasRetransmits = pdFALSE;
+	UBaseType_t uxIndex;
+	size_t uxLength;
+
+		dUser = ( double ) ( pxTest->xEndUsage.ru_utime.tv_sec - pxTest->xStartUsage.ru_utime.tv_sec ) +
+				( ( double ) ( pxTest->xEndUsage.ru_utime.tv_usec - pxTest->xStartUsage.ru_utime.tv_usec ) / 1.0e6 );
+		dSystem = ( double ) ( pxTest->xEndUsage.ru_stime.tv_sec - pxTest->xStartUsage.ru_stime.tv_sec ) +
+				  ( ( double ) ( pxTest->xEndUsage.ru_stime.tv_usec - pxTest->xStartUsage.ru_stime.tv_usec ) / 1.0e6 );
+
+		if( pxTest->dDuration > 0.0 )
+		{
+			dUser = ( dUser * 100.0 ) / pxTest->dDuration;
+			dSystem = ( dSystem * 100.0 ) / pxTest->dDuration;
+		}
+
+		#if ( ipconfigUSE_NETWORK_STATS != 0 )
+		{
+			/* The server only sends in the reverse direction. */
+			if( ( pxTest->xReverse != pdFALSE ) && ( pxTest->xUDP == pdFALSE ) )
+			{
+				xHasRetransmits = pdTRUE;
+			}
+		}
+		#endif
+
+		uxLength = ( size_t ) snprintf( pcBuffer, uxBufferSize,
+										"{\"cpu_util_total\":%.4f,\"cpu_util_user\":%.4f,\"cpu_util_system\":%.4f,\"sender_has_retransmits\":%d,\"streams\":[",
+										dUser + dSystem, dUser, dSystem, ( int ) xHasRetransmits );
+
+		for( uxIndex = 0U; ( uxIndex < pxTest->uxStreamCount ) && ( uxLength < uxBufferSize ); uxIndex++ )
+		{
+			pxStream = &( pxTest->xStreams[ uxIndex ] );
+			lRetransmits = -1;
+
+			#if ( ipconfigUSE_NETWORK_STATS != 0 )
+			{
+			SocketStats_t xStats;
+
+				if( ( xHasRetransmits != pdFALSE ) &&
+					( pxStream->xSocket != NULL ) &&
+					( FreeRTOS_GetSocketStats( pxStream->xSocket, &xStats ) == pdPASS ) )
+				{
+					lRetransmits = ( long ) xStats.ulRetransmits;
+				}
+			}
+			#endif
+
+			/* The client numbers its streams 1, 3, 4, 5, ... in the order in
+			which they were created. */
+			uxLength += ( size_t ) snprintf( pcBuffer + uxLength, uxBufferSize - uxLength,
+											 "%s{\"id\":%u,\"bytes\":%llu,\"retransmits\":%ld,\"jitter\":%.9f,\"errors\":%llu,\"packets\":%llu,\"start_time\":0,\"end_time\":%.6f}",
+											 ( uxIndex == 0U ) ? "" : ",",
+											 ( unsigned ) ( ( uxIndex == 0U ) ? 1U : ( uxIndex + 2U ) ),
+											 ( unsigned long long ) pxStream->ullBytes,
+											 lRetransmits,
+											 pxStream->dJitter,
+											 ( unsigned long long ) pxStream->ullErrors,
+											 ( unsigned long long ) pxStream->ullPackets,
+											 pxTest->dDuration );
+		}
+
+		if( uxLength < uxBufferSize )
+		{
+			snprintf( pcBuffer + uxLength, uxBufferSize - uxLength, "]}" );
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvCloseTest( IperfTest_t *pxTest )
+	{
+	UBaseType_t uxIndex;
+
+		for( uxIndex = 0U; uxIndex < iperfMAX_STREAMS; uxIndex++ )
+		{
+			if( pxTest->xStreams[ uxIndex ].xSocket != NULL )
+			{
+				FreeRTOS_shutdown( pxTest->xStreams[ uxIndex ].xSocket, FREERTOS_SHUT_RDWR );
+				FreeRTOS_closesocket( pxTest->xStreams[ uxIndex ].xSocket );
+			}
+		}
+
+		if( pxTest->xUDPSocket != NULL )
+		{
+			FreeRTOS_closesocket( pxTest->xUDPSocket );
+		}
+
+		if( pxTest->xSocketSet != NULL )
+		{
+			FreeRTOS_DeleteSocketSet( pxTest->xSocketSet );
+		}
+
+		FreeRTOS_shutdown( pxTest->xControlSocket, FREERTOS_SHUT_RDWR );
+		FreeRTOS_closesocket( pxTest->xControlSocket );
+		memset( pxTest, 0, sizeof( *pxTest ) );
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvSendAll( Socket_t xSocket,
+								  const void *pvBuffer,
+								  size_t uxLength )
+	{
+	const uint8_t *pucBuffer = ( const uint8_t * ) pvBuffer;
+	size_t uxSent = 0U;
+	BaseType_t xResult;
+
+		while( uxSent < uxLength )
+		{
+			xResult = FreeRTOS_send( xSocket, pucBuffer + uxSent, uxLength - uxSent, 0 );
+
+			if( xResult <= 0 )
+			{
+				break;
+			}
+
+			uxSent += ( size_t ) xResult;
+		}
+
+		return ( uxSent == uxLength ) ? pdPASS : pdFAIL;
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvReceiveAll( Socket_t xSocket,
+									 void *pvBuffer,
+									 size_t uxLength )
+	{
+	uint8_t *pucBuffer = ( uint8_t * ) pvBuffer;
+	size_t uxReceived = 0U;
+	BaseType_t xResult;
+
+		while( uxReceived < uxLength )
+		{
+			xResult = FreeRTOS_recv( xSocket, pucBuffer + uxReceived, uxLength - uxReceived, 0 );
+
+			if( xResult <= 0 )
+			{
+				break;
+			}
+
+			uxReceived += ( size_t ) xResult;
+		}
+
+		return ( uxReceived == uxLength ) ? pdPASS : pdFAIL;
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvSendState( Socket_t xSocket,
+									int8_t cState )
+	{
+		return prvSendAll( xSocket, &cState, sizeof( cState ) );
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvSendJSON( Socket_t xSocket,
+								   const char *pcJSON )
+	{
+	size_t uxLength = strlen( pcJSON );
+	uint32_t ulLength = FreeRTOS_htonl( ( uint32_t ) uxLength );
+	BaseType_t xReturn = pdFAIL;
+
+		if( prvSendAll( xSocket, &ulLength, sizeof( ulLength ) ) == pdPASS )
+		{
+			xReturn = prvSendAll( xSocket, pcJSON, uxLength );
+		}
+
+		return xReturn;
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvReceiveJSON( Socket_t xSocket,
+									  char *pcBuffer,
+									  size_t uxBufferSize )
+	{
+	uint32_t ulLength;
+	size_t uxLength, uxStored;
+	char cDrop;
+	BaseType_t xReturn = pdFAIL;
+
+		if( prvReceiveAll( xSocket, &ulLength, sizeof( ulLength ) ) == pdPASS )
+		{
+			uxLength = ( size_t ) FreeRTOS_ntohl( ulLength );
+			uxStored = ( uxLength < uxBufferSize ) ? uxLength : ( uxBufferSize - 1U );
+
+			if( prvReceiveAll( xSocket, pcBuffer, uxStored ) == pdPASS )
+			{
+				pcBuffer[ uxStored ] = '\0';
+				xReturn = pdPASS;
+
+				while( ( uxStored < uxLength ) && ( xReturn == pdPASS ) )
+				{
+					xReturn = prvReceiveAll( xSocket, &cDrop, sizeof( cDrop ) );
+					uxStored++;
+				}
+			}
+		}
+
+		return xReturn;
+	}
+/*-----------------------------------------------------------*/
+
+	static long prvJSONGetInteger( const char *pcJSON,
+								   const char *pcKey,
+								   long lDefault )
+	{
+	char cPattern[ 32 ];
+	const char *pcValue;
+	long lReturn = lDefault;
+
+		snprintf( cPattern, sizeof( cPattern ), "\"%s\"", pcKey );
+		pcValue = strstr( pcJSON, cPattern );
+
+		if( pcValue != NULL )
+		{
+			pcValue += strlen( cPattern );
+
+			while( ( *pcValue == ' ' ) || ( *pcValue == ':' ) )
+			{
+				pcValue++;
+			}
+
+			if( strncmp( pcValue, "true", 4U ) == 0 )
+			{
+				lReturn = 1;
+			}
+			else if( strncmp( pcValue, "false", 5U ) == 0 )
+			{
+				lReturn = 0;
+			}
+			else
+			{
+				lReturn = strtol( pcValue, NULL, 10 );
+			}
+		}
+
+		return lReturn;
+	}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
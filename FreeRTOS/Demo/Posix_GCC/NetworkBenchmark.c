@@ -0,0 +1,872 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A throughput and latency benchmark between two IP-stacks in one process.
+ *
+ * The server tasks run on a second IP-stack that is connected to the first
+ * one by the simulated link, see simulated_link/SimulatedLink.h.  They are:
+ *
+ *  - a TCP sink on port netbenchSINK_PORT, that accepts many connections and
+ *    receives all data,
+ *  - a UDP sink on port netbenchUDP_PORT, that counts the datagrams,
+ *  - a TCP request/response server on port netbenchRR_PORT.  Every request
+ *    starts with its own size and the size of the wanted response, both in 4
+ *    bytes in network byte order.
+ *
+ * The client task runs the following tests against them, one after the other:
+ * a bulk TCP stream, netbenchPARALLEL_CONNECTIONS parallel TCP streams, a burst
+ * of UDP datagrams, and netbenchRR_TRANSACTIONS transactions of every size in
+ * netbenchRR_SIZES.  For every test it reports the throughput in Gbit/s, the
+ * frames per second that crossed the link in both directions, and the CPU time
+ * of the process per byte.  The request/response tests also report the
+ * transactions per second and the 50th, 99th and 99.9th percentile of the
+ * latency.
+ *
+ * The sizes can be changed by defining the netbench macros below, for instance
+ * in the CPPDEFINES of the posix_bench target.  The link parameters are those
+ * of configSIM_LINK_LATENCY_US and its companions.
+ *
+ * ipconfigIP_STACK_COUNT must be at least 2, and ipconfigSUPPORT_SELECT_FUNCTION
+ * must be set to 1 in FreeRTOSIPConfig.h.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/* Demo application includes. */
+#include "console.h"
+#include "NetworkBenchmark.h"
+
+/* Exclude the whole file if there is only one IP-stack. */
+#if ( ipconfigUSE_TCP == 1 ) && ( ipconfigIP_STACK_COUNT > 1 ) && ( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+
+	#include "SimulatedLink.h"
+
+/* The ports of the servers. */
+	#define netbenchSINK_PORT				( 5210U )
+	#define netbenchRR_PORT					( 5211U )
+	#define netbenchUDP_PORT				( 5212U )
+
+/* The megabytes sent by the TCP tests, shared by the parallel connections. */
+	#ifndef netbenchBULK_MEGABYTES
+		#define netbenchBULK_MEGABYTES		( 32U )
+	#endif
+
+/* The number of connections of the parallel TCP test. */
+	#ifndef netbenchPARALLEL_CONNECTIONS
+		#define netbenchPARALLEL_CONNECTIONS	( 16U )
+	#endif
+
+/* The number and the payload size of the datagrams of the UDP test.  A
+datagram must fit in ipconfigNETWORK_MTU. */
+	#ifndef netbenchUDP_DATAGRAMS
+		#define netbenchUDP_DATAGRAMS		( 20000U )
+	#endif
+
+	#ifndef netbenchUDP_DATAGRAM_SIZE
+		#define netbenchUDP_DATAGRAM_SIZE	( 1024U )
+	#endif
+
+/* The number of transactions of a request/response test, and the pairs of
+request and response sizes that are tested.  A request has at least 8 bytes. */
+	#ifndef netbenchRR_TRANSACTIONS
+		#define netbenchRR_TRANSACTIONS		( 2000U )
+	#endif
+
+	#ifndef netbenchRR_SIZES
+		#define netbenchRR_SIZES			{ 64U, 64U }, { 1024U, 1024U }, { 64U, 8192U }
+	#endif
+
+/* Set to 1 to end the process when all tests are done, so that the benchmark
+can be run from a script, and an instrumented build writes its profile. */
+	#ifndef netbenchEXIT_WHEN_DONE
+		#define netbenchEXIT_WHEN_DONE		( 0 )
+	#endif
+
+/* The size of the buffers passed to send() and recv(), which is also the
+largest request or response. */
+	#define netbenchBUFFER_SIZE				( 16384U )
+
+/* The buffer and window sizes of the TCP connections, in segments. */
+	#define netbenchTCP_BUFFER_SEGMENTS		( 32 )
+	#define netbenchTCP_WINDOW_SEGMENTS		( 16 )
+
+/* The maximum time to wait for a connection, for a send or receive call, or
+for the servers to receive the last data. */
+	#define netbenchTIMEOUT					pdMS_TO_TICKS( 5000U )
+
+/*-----------------------------------------------------------*/
+
+/* A request size and a response size. */
+	typedef struct xNETBENCH_RR_SIZE
+	{
+		uint32_t ulRequestSize;
+		uint32_t ulResponseSize;
+	} RRSize_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The server tasks.  They select the server stack, and wait until it is up.
+ */
+	static void prvSinkServerTask( void *pvParameters );
+	static void prvUDPServerTask( void *pvParameters );
+	static void prvRRServerTask( void *pvParameters );
+
+/*
+ * Runs all tests and reports the results.
+ */
+	static void prvClientTask( void *pvParameters );
+
+/*
+ * Sends netbenchBULK_MEGABYTES over 'uxConnections' connections to the sink.
+ */
+	static void prvRunTCPBulk( const char *pcName,
+							   UBaseType_t uxConnections );
+
+/*
+ * Sends netbenchUDP_DATAGRAMS datagrams to the UDP sink.
+ */
+	static void prvRunUDPBulk( void );
+
+/*
+ * Runs netbenchRR_TRANSACTIONS transactions of the given sizes.
+ */
+	static void prvRunRequestResponse( const RRSize_t *pxSize );
+
+/*
+ * Returns a connected TCP socket, or NULL.
+ */
+	static Socket_t prvConnect( uint16_t usPort );
+
+/*
+ * Apply the buffer and window sizes of the benchmark to a TCP socket.
+ */
+	static void prvSetWindowProperties( Socket_t xSocket );
+
+/*
+ * Waits until the server stack is up.
+ */
+	static void prvSelectServerStack( void );
+
+/*
+ * Start and end a measurement.  The results are printed under 'pcName'.
+ */
+	static void prvMeasureStart( void );
+	static void prvMeasureEnd( const char *pcName,
+							   uint64_t ullBytes );
+
+/*
+ * Returns the time of 'xClock' in nanoseconds.
+ */
+	static uint64_t prvNanoseconds( clockid_t xClock );
+
+/*
+ * Send or receive exactly 'uxLength' bytes.
+ */
+	static BaseType_t prvSendAll( Socket_t xSocket,
+								  const uint8_t *pucBuffer,
+								  size_t uxLength );
+	static BaseType_t prvReceiveAll( Socket_t xSocket,
+									 uint8_t *pucBuffer,
+									 size_t uxLength );
+
+/*
+ * qsort() comparison of two latencies.
+ */
+	static int prvCompareLatency( const void *pvLeft,
+								  const void *pvRight );
+
+/*-----------------------------------------------------------*/
+
+/* The stack of the servers, and its address in network byte order. */
+	static UBaseType_t uxBenchServerStack;
+	static uint32_t ulBenchServerAddress;
+
+/* Updated by the server tasks, read by the client task. */
+	static volatile uint64_t ullSinkReceived = 0U;
+	static volatile uint32_t ulUDPReceived = 0U;
+	static volatile uint64_t ullUDPBytesReceived = 0U;
+
+/* The time at which the running measurement started. */
+	static uint64_t ullStartTime, ullStartCPUTime;
+
+/* The sizes of the request/response tests. */
+	static const RRSize_t xRRSizes[] = { netbenchRR_SIZES };
+
+/* The latencies of the request/response tests, in nanoseconds. */
+	static uint64_t ullLatencies[ netbenchRR_TRANSACTIONS ];
+
+/* Every task has its own buffer. */
+	static uint8_t ucClientBuffer[ netbenchBUFFER_SIZE ];
+	static uint8_t ucClientReceiveBuffer[ netbenchBUFFER_SIZE ];
+	static uint8_t ucSinkBuffer[ netbenchBUFFER_SIZE ];
+	static uint8_t ucUDPBuffer[ netbenchBUFFER_SIZE ];
+	static uint8_t ucRRBuffer[ netbenchBUFFER_SIZE ];
+
+/*-----------------------------------------------------------*/
+
+	void vStartNetworkBenchmark( uint16_t usTaskStackSize,
+								 UBaseType_t uxTaskPriority,
+								 UBaseType_t uxServerStack,
+								 uint32_t ulServerAddress )
+	{
+		uxBenchServerStack = uxServerStack;
+		ulBenchServerAddress = ulServerAddress;
+
+		xTaskCreate( prvSinkServerTask, "BenchSink", usTaskStackSize, NULL, uxTaskPriority, NULL );
+		xTaskCreate( prvUDPServerTask, "BenchUDP", usTaskStackSize, NULL, uxTaskPriority, NULL );
+		xTaskCreate( prvRRServerTask, "BenchRR", usTaskStackSize, NULL, uxTaskPriority, NULL );
+		xTaskCreate( prvClientTask, "BenchClient", usTaskStackSize, NULL, uxTaskPriority, NULL );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvSelectServerStack( void )
+	{
+		FreeRTOS_SetIPStack( uxBenchServerStack );
+
+		while( FreeRTOS_IsNetworkUp() == pdFALSE )
+		{
+			vTaskDelay( pdMS_TO_TICKS( 10U ) );
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvSinkServerTask( void *pvParameters )
+	{
+	Socket_t xListeningSocket, xNewSocket;
+	Socket_t xSockets[ netbenchPARALLEL_CONNECTIONS ];
+	struct freertos_sockaddr xBindAddress, xClient;
+	socklen_t xSize = sizeof( xClient );
+	const TickType_t xNoTimeOut = 0U;
+	SocketSet_t xSocketSet;
+	UBaseType_t uxIndex;
+	BaseType_t xResult;
+
+		( void ) pvParameters;
+
+		prvSelectServerStack();
+		memset( xSockets, 0, sizeof( xSockets ) );
+
+		xSocketSet = FreeRTOS_CreateSocketSet();
+		xListeningSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+		configASSERT( ( xSocketSet != NULL ) && ( xListeningSocket != FREERTOS_INVALID_SOCKET ) );
+
+		/* accept() is only called when select() reported a connection. */
+		prvSetWindowProperties( xListeningSocket );
+		FreeRTOS_setsockopt( xListeningSocket, 0, FREERTOS_SO_RCVTIMEO, &xNoTimeOut, sizeof( xNoTimeOut ) );
+
+		xBindAddress.sin_port = FreeRTOS_htons( netbenchSINK_PORT );
+		xBindAddress.sin_addr = 0U;
+		FreeRTOS_bind( xListeningSocket, &xBindAddress, sizeof( xBindAddress ) );
+		FreeRTOS_listen( xListeningSocket, ( BaseType_t ) netbenchPARALLEL_CONNECTIONS );
+		FreeRTOS_FD_SET( xListeningSocket, xSocketSet, eSELECT_READ );
+
+		for( ; ; )
+		{
+			( void ) FreeRTOS_select( xSocketSet, portMAX_DELAY );
+
+			if( FreeRTOS_FD_ISSET( xListeningSocket, xSocketSet ) != 0U )
+			{
+				xNewSocket = FreeRTOS_accept( xListeningSocket, &xClient, &xSize );
+
+				if( ( xNewSocket != NULL ) && ( xNewSocket != FREERTOS_INVALID_SOCKET ) )
+				{
+					for( uxIndex = 0U; uxIndex < netbenchPARALLEL_CONNECTIONS; uxIndex++ )
+					{
+						if( xSockets[ uxIndex ] == NULL )
+						{
+							break;
+						}
+					}
+
+					if( uxIndex < netbenchPARALLEL_CONNECTIONS )
+					{
+						xSockets[ uxIndex ] = xNewSocket;
+						FreeRTOS_FD_SET( xNewSocket, xSocketSet, eSELECT_READ );
+					}
+					else
+					{
+						FreeRTOS_closesocket( xNewSocket );
+					}
+				}
+			}
+
+			for( uxIndex = 0U; uxIndex < netbenchPARALLEL_CONNECTIONS; uxIndex++ )
+			{
+				if( ( xSockets[ uxIndex ] == NULL ) || ( FreeRTOS_FD_ISSET( xSockets[ uxIndex ], xSocketSet ) == 0U ) )
+				{
+					continue;
+				}
+
+				for( ; ; )
+				{
+					xResult = FreeRTOS_recv( xSockets[ uxIndex ], ucSinkBuffer, sizeof( ucSinkBuffer ), FREERTOS_MSG_DONTWAIT );
+
+					if( xResult > 0 )
+					{
+						ullSinkReceived += ( uint64_t ) xResult;
+					}
+					else
+					{
+						if( xResult < 0 )
+						{
+							/* The client has shut down the connection. */
+							FreeRTOS_FD_CLR( xSockets[ uxIndex ], xSocketSet, eSELECT_ALL );
+							FreeRTOS_shutdown( xSockets[ uxIndex ], FREERTOS_SHUT_RDWR );
+							FreeRTOS_closesocket( xSockets[ uxIndex ] );
+							xSockets[ uxIndex ] = NULL;
+						}
+
+						break;
+					}
+				}
+			}
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvUDPServerTask( void *pvParameters )
+	{
+	Socket_t xSocket;
+	struct freertos_sockaddr xBindAddress, xClient;
+	socklen_t xSize = sizeof( xClient );
+	int32_t lReceived;
+
+		( void ) pvParameters;
+
+		prvSelectServerStack();
+
+		xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+		configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+
+		xBindAddress.sin_port = FreeRTOS_htons( netbenchUDP_PORT );
+		xBindAddress.sin_addr = 0U;
+		FreeRTOS_bind( xSocket, &xBindAddress, sizeof( xBindAddress ) );
+
+		for( ; ; )
+		{
+			lReceived = FreeRTOS_recvfrom( xSocket, ucUDPBuffer, sizeof( ucUDPBuffer ), 0, &xClient, &xSize );
+
+			if( lReceived > 0 )
+			{
+				ullUDPBytesReceived += ( uint64_t ) lReceived;
+				ulUDPReceived++;
+			}
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvRRServerTask( void *pvParameters )
+	{
+	Socket_t xListeningSocket, xSocket;
+	struct freertos_sockaddr xBindAddress, xClient;
+	socklen_t xSize = sizeof( xClient );
+	const TickType_t xTimeOut = netbenchTIMEOUT;
+	uint32_t ulHeader[ 2 ];
+	size_t uxRequestSize, uxResponseSize;
+
+		( void ) pvParameters;
+
+		prvSelectServerStack();
+
+		xListeningSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+		configASSERT( xListeningSocket != FREERTOS_INVALID_SOCKET );
+
+		prvSetWindowProperties( xListeningSocket );
+
+		xBindAddress.sin_port = FreeRTOS_htons( netbenchRR_PORT );
+		xBindAddress.sin_addr = 0U;
+		FreeRTOS_bind( xListeningSocket, &xBindAddress, sizeof( xBindAddress ) );
+		FreeRTOS_listen( xListeningSocket, 1 );
+
+		for( ; ; )
+		{
+			xSocket = FreeRTOS_accept( xListeningSocket, &xClient, &xSize );
+
+			if( ( xSocket == NULL ) || ( xSocket == FREERTOS_INVALID_SOCKET ) )
+			{
+				continue;
+			}
+
+			FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+			FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+			/* Answer the requests until the client closes the connection. */
+			while( prvReceiveAll( xSocket, ucRRBuffer, sizeof( ulHeader ) ) == pdPASS )
+			{
+				memcpy( ulHeader, ucRRBuffer, sizeof( ulHeader ) );
+				uxRequestSize = ( size_t ) FreeRTOS_ntohl( ulHeader[ 0 ] );
+				uxResponseSize = ( size_t ) FreeRTOS_ntohl( ulHeader[ 1 ] );
+
+				if( ( uxRequestSize < sizeof( ulHeader ) ) || ( uxRequestSize > sizeof( ucRRBuffer ) ) || ( uxResponseSize > sizeof( ucRRBuffer ) ) )
+				{
+					break;
+				}
+
+				if( ( prvReceiveAll( xSocket, ucRRBuffer, uxRequestSize - sizeof( ulHeader ) ) == pdFAIL ) ||
+					( prvSendAll( xSocket, ucRRBuffer, uxResponseSize ) == pdFAIL ) )
+				{
+					break;
+				}
+			}
+
+			FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+			FreeRTOS_closesocket( xSocket );
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvClientTask( void *pvParameters )
+	{
+	size_t uxIndex;
+
+		( void ) pvParameters;
+
+		/* The client runs on stack 0, the stack under test. */
+		( void ) FreeRTOS_SetIPStack( 0U );
+
+		for( uxIndex = 0U; uxIndex < sizeof( ucClientBuffer ); uxIndex++ )
+		{
+			ucClientBuffer[ uxIndex ] = ( uint8_t ) uxIndex;
+		}
+
+		/* Let the server tasks create their sockets first. */
+		vTaskDelay( pdMS_TO_TICKS( 500U ) );
+
+		prvRunTCPBulk( "TCP bulk", 1U );
+		prvRunTCPBulk( "TCP parallel", netbenchPARALLEL_CONNECTIONS );
+		prvRunUDPBulk();
+
+		for( uxIndex = 0U; uxIndex < ( sizeof( xRRSizes ) / sizeof( xRRSizes[ 0 ] ) ); uxIndex++ )
+		{
+			prvRunRequestResponse( &( xRRSizes[ uxIndex ] ) );
+		}
+
+		console_print( "netbench: done\n" );
+
+		#if ( netbenchEXIT_WHEN_DONE == 1 )
+		{
+			exit( 0 );
+		}
+		#endif
+
+		vTaskDelete( NULL );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvRunTCPBulk( const char *pcName,
+							   UBaseType_t uxConnections )
+	{
+	Socket_t xSockets[ netbenchPARALLEL_CONNECTIONS ];
+	uint64_t ullRemaining[ netbenchPARALLEL_CONNECTIONS ];
+	const uint64_t ullTotal = ( uint64_t ) netbenchBULK_MEGABYTES * 1024U * 1024U;
+	uint64_t ullSent = 0U, ullExpected, ullBefore;
+	UBaseType_t uxIndex, uxActive = 0U;
+	SocketSet_t xSocketSet;
+	TickType_t xLastProgress;
+	BaseType_t xResult;
+	size_t uxLength;
+
+		configASSERT( ( uxConnections > 0U ) && ( uxConnections <= netbenchPARALLEL_CONNECTIONS ) );
+
+		xSocketSet = FreeRTOS_CreateSocketSet();
+
+		if( xSocketSet == NULL )
+		{
+			return;
+		}
+
+		for( uxIndex = 0U; uxIndex < uxConnections; uxIndex++ )
+		{
+			xSockets[ uxIndex ] = prvConnect( netbenchSINK_PORT );
+			ullRemaining[ uxIndex ] = ullTotal / uxConnections;
+
+			if( xSockets[ uxIndex ] != NULL )
+			{
+				FreeRTOS_FD_SET( xSockets[ uxIndex ], xSocketSet, eSELECT_WRITE );
+				uxActive++;
+			}
+		}
+
+		if( uxActive < uxConnections )
+		{
+			console_print( "netbench: %s: %u of %u connections failed\n", pcName, ( unsigned ) ( uxConnections - uxActive ), ( unsigned ) uxConnections );
+		}
+
+		ullExpected = ullSinkReceived;
+		prvMeasureStart();
+
+		while( uxActive > 0U )
+		{
+			if( FreeRTOS_select( xSocketSet, netbenchTIMEOUT ) == 0 )
+			{
+				console_print( "netbench: %s: time-out while sending\n", pcName );
+				break;
+			}
+
+			for( uxIndex = 0U; uxIndex < uxConnections; uxIndex++ )
+			{
+				if( ( xSockets[ uxIndex ] == NULL ) || ( ullRemaining[ uxIndex ] == 0U ) ||
+					( FreeRTOS_FD_ISSET( xSockets[ uxIndex ], xSocketSet ) == 0U ) )
+				{
+					continue;
+				}
+
+				uxLength = ( ullRemaining[ uxIndex ] < sizeof( ucClientBuffer ) ) ? ( size_t ) ullRemaining[ uxIndex ] : sizeof( ucClientBuffer );
+				xResult = FreeRTOS_send( xSockets[ uxIndex ], ucClientBuffer, uxLength, FREERTOS_MSG_DONTWAIT );
+
+				if( xResult > 0 )
+				{
+					ullRemaining[ uxIndex ] -= ( uint64_t ) xResult;
+					ullSent += ( uint64_t ) xResult;
+				}
+				else if( xResult != -pdFREERTOS_ERRNO_ENOSPC )
+				{
+					/* The connection was lost. */
+					ullRemaining[ uxIndex ] = 0U;
+				}
+
+				if( ullRemaining[ uxIndex ] == 0U )
+				{
+					FreeRTOS_FD_CLR( xSockets[ uxIndex ], xSocketSet, eSELECT_ALL );
+					uxActive--;
+				}
+			}
+		}
+
+		/* Wait until the sink has received everything, or stops making
+		progress. */
+		ullExpected += ullSent;
+		xLastProgress = xTaskGetTickCount();
+
+		while( ullSinkReceived < ullExpected )
+		{
+			ullBefore = ullSinkReceived;
+			vTaskDelay( 1U );
+
+			if( ullSinkReceived != ullBefore )
+			{
+				xLastProgress = xTaskGetTickCount();
+			}
+			else if( ( xTaskGetTickCount() - xLastProgress ) > netbenchTIMEOUT )
+			{
+				break;
+			}
+		}
+
+		prvMeasureEnd( pcName, ullSent - ( ullExpected - ullSinkReceived ) );
+
+		for( uxIndex = 0U; uxIndex < uxConnections; uxIndex++ )
+		{
+			if( xSockets[ uxIndex ] != NULL )
+			{
+				FreeRTOS_shutdown( xSockets[ uxIndex ], FREERTOS_SHUT_RDWR );
+				FreeRTOS_closesocket( xSockets[ uxIndex ] );
+			}
+		}
+
+		FreeRTOS_DeleteSocketSet( xSocketSet );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvRunUDPBulk( void )
+	{
+	Socket_t xSocket;
+	struct freertos_sockaddr xServerAddress;
+	uint32_t ulFirst, ulSent = 0U, ulIndex, ulBefore;
+	uint64_t ullFirstBytes;
+
+		xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+
+		if( xSocket == FREERTOS_INVALID_SOCKET )
+		{
+			return;
+		}
+
+		xServerAddress.sin_port = FreeRTOS_htons( netbenchUDP_PORT );
+		xServerAddress.sin_addr = ulBenchServerAddress;
+
+		ulFirst = ulUDPReceived;
+		ullFirstBytes = ullUDPBytesReceived;
+		prvMeasureStart();
+
+		for( ulIndex = 0U; ulIndex < netbenchUDP_DATAGRAMS; ulIndex++ )
+		{
+			if( FreeRTOS_sendto( xSocket, ucClientBuffer, netbenchUDP_DATAGRAM_SIZE, 0, &xServerAddress, sizeof( xServerAddress ) ) > 0 )
+			{
+				ulSent++;
+			}
+		}
+
+		/* Wait for the datagrams that are still on their way. */
+		do
+		{
+			ulBefore = ulUDPReceived;
+			vTaskDelay( pdMS_TO_TICKS( 20U ) );
+		} while( ( ulUDPReceived != ulBefore ) && ( ( ulUDPReceived - ulFirst ) < ulSent ) );
+
+		prvMeasureEnd( "UDP bulk", ullUDPBytesReceived - ullFirstBytes );
+
+		console_print( "netbench:   %lu of %lu datagrams of %u bytes arrived\n",
+					   ( unsigned long ) ( ulUDPReceived - ulFirst ),
+					   ( unsigned long ) ulSent,
+					   ( unsigned ) netbenchUDP_DATAGRAM_SIZE );
+
+		FreeRTOS_closesocket( xSocket );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvRunRequestResponse( const RRSize_t *pxSize )
+	{
+	Socket_t xSocket;
+	uint32_t ulHeader[ 2 ];
+	uint32_t ulCount;
+	uint64_t ullStart, ullTotal = 0U;
+	char cName[ 32 ];
+
+		configASSERT( ( pxSize->ulRequestSize >= sizeof( ulHeader ) ) && ( pxSize->ulRequestSize <= netbenchBUFFER_SIZE ) );
+		configASSERT( pxSize->ulResponseSize <= netbenchBUFFER_SIZE );
+
+		xSocket = prvConnect( netbenchRR_PORT );
+
+		if( xSocket == NULL )
+		{
+			return;
+		}
+
+		ulHeader[ 0 ] = FreeRTOS_htonl( pxSize->ulRequestSize );
+		ulHeader[ 1 ] = FreeRTOS_htonl( pxSize->ulResponseSize );
+		memcpy( ucClientBuffer, ulHeader, sizeof( ulHeader ) );
+
+		snprintf( cName, sizeof( cName ), "RR %lu/%lu",
+				  ( unsigned long ) pxSize->ulRequestSize,
+				  ( unsigned long ) pxSize->ulResponseSize );
+
+		prvMeasureStart();
+
+		for( ulCount = 0U; ulCount < netbenchRR_TRANSACTIONS; ulCount++ )
+		{
+			ullStart = prvNanoseconds( CLOCK_MONOTONIC );
+
+			if( ( prvSendAll( xSocket, ucClientBuffer, pxSize->ulRequestSize ) == pdFAIL ) ||
+				( prvReceiveAll( xSocket, ucClientReceiveBuffer, pxSize->ulResponseSize ) == pdFAIL ) )
+			{
+				console_print( "netbench: %s: transaction %lu failed\n", cName, ( unsigned long ) ulCount );
+				break;
+			}
+
+			ullLatencies[ ulCount ] = prvNanoseconds( CLOCK_MONOTONIC ) - ullStart;
+			ullTotal += pxSize->ulRequestSize + pxSize->ulResponseSize;
+		}
+
+		prvMeasureEnd( cName, ullTotal );
+
+		if( ulCount > 0U )
+		{
+			qsort( ullLatencies, ulCount, sizeof( ullLatencies[ 0 ] ), prvCompareLatency );
+
+			console_print( "netbench:   %lu transactions/s, latency p50 %.1f us, p99 %.1f us, p99.9 %.1f us\n",
+						   ( unsigned long ) ( ( ( uint64_t ) ulCount * 1000000000ULL ) / ( prvNanoseconds( CLOCK_MONOTONIC ) - ullStartTime ) ),
+						   ( double ) ullLatencies[ ( ulCount * 500U ) / 1000U ] / 1000.0,
+						   ( double ) ullLatencies[ ( ulCount * 990U ) / 1000U ] / 1000.0,
+						   ( double ) ullLatencies[ ( ulCount * 999U ) / 1000U ] / 1000.0 );
+		}
+
+		FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+		FreeRTOS_closesocket( xSocket );
+	}
+/*-----------------------------------------------------------*/
+
+	static Socket_t prvConnect( uint16_t usPort )
+	{
+	Socket_t xSocket;
+	struct freertos_sockaddr xServerAddress;
+	const TickType_t xTimeOut = netbenchTIMEOUT;
+
+		xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+		if( xSocket == FREERTOS_INVALID_SOCKET )
+		{
+			return NULL;
+		}
+
+		prvSetWindowProperties( xSocket );
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+		xServerAddress.sin_port = FreeRTOS_htons( usPort );
+		xServerAddress.sin_addr = ulBenchServerAddress;
+
+		if( FreeRTOS_connect( xSocket, &xServerAddress, sizeof( xServerAddress ) ) != 0 )
+		{
+			console_print( "netbench: connect to port %u failed\n", ( unsigned ) usPort );
+			FreeRTOS_closesocket( xSocket );
+			xSocket = NULL;
+		}
+
+		return xSocket;
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvSetWindowProperties( Socket_t xSocket )
+	{
+	WinProperties_t xWinProperties;
+
+		memset( &xWinProperties, 0, sizeof( xWinProperties ) );
+		xWinProperties.lTxBufSize = netbenchTCP_BUFFER_SEGMENTS * ipconfigTCP_MSS;
+		xWinProperties.lTxWinSize = netbenchTCP_WINDOW_SEGMENTS;
+		xWinProperties.lRxBufSize = netbenchTCP_BUFFER_SEGMENTS * ipconfigTCP_MSS;
+		xWinProperties.lRxWinSize = netbenchTCP_WINDOW_SEGMENTS;
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_WIN_PROPERTIES, &xWinProperties, sizeof( xWinProperties ) );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvMeasureStart( void )
+	{
+	SimLinkStats_t xStats;
+
+		/* Clear the counters of the link. */
+		xSimLinkGetStats( simLINK_PORT_0, &xStats, pdTRUE );
+		xSimLinkGetStats( simLINK_PORT_1, &xStats, pdTRUE );
+
+		ullStartCPUTime = prvNanoseconds( CLOCK_PROCESS_CPUTIME_ID );
+		ullStartTime = prvNanoseconds( CLOCK_MONOTONIC );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvMeasureEnd( const char *pcName,
+							   uint64_t ullBytes )
+	{
+	SimLinkStats_t xForward, xBackward;
+	uint64_t ullDuration, ullCPUTime;
+	double dSeconds;
+
+		ullDuration = prvNanoseconds( CLOCK_MONOTONIC ) - ullStartTime;
+		ullCPUTime = prvNanoseconds( CLOCK_PROCESS_CPUTIME_ID ) - ullStartCPUTime;
+		xSimLinkGetStats( simLINK_PORT_0, &xForward, pdFALSE );
+		xSimLinkGetStats( simLINK_PORT_1, &xBackward, pdFALSE );
+
+		if( ullDuration == 0U )
+		{
+			ullDuration = 1U;
+		}
+
+		dSeconds = ( double ) ullDuration / 1.0e9;
+
+		/* The CPU time is that of all threads of the process, so it includes
+		the IP-tasks of both stacks and the link. */
+		console_print( "netbench: %-16s %12llu B %9.3f s %8.3f Gbit/s %9.0f pkt/s %7.2f ns/B\n",
+					   pcName,
+					   ( unsigned long long ) ullBytes,
+					   dSeconds,
+					   ( ( double ) ullBytes * 8.0 ) / dSeconds / 1.0e9,
+					   ( double ) ( xForward.ulFramesDelivered + xBackward.ulFramesDelivered ) / dSeconds,
+					   ( ullBytes > 0U ) ? ( ( double ) ullCPUTime / ( double ) ullBytes ) : 0.0 );
+	}
+/*-----------------------------------------------------------*/
+
+	static uint64_t prvNanoseconds( clockid_t xClock )
+	{
+	struct timespec xNow;
+
+		clock_gettime( xClock, &xNow );
+
+		return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvSendAll( Socket_t xSocket,
+								  const uint8_t *pucBuffer,
+								  size_t uxLength )
+	{
+	size_t uxSent = 0U;
+	BaseType_t xResult;
+
+		while( uxSent < uxLength )
+		{
+			xResult = FreeRTOS_send( xSocket, pucBuffer + uxSent, uxLength - uxSent, 0 );
+
+			if( xResult <= 0 )
+			{
+				break;
+			}
+
+			uxSent += ( size_t ) xResult;
+		}
+
+		return ( uxSent == uxLength ) ? pdPASS : pdFAIL;
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvReceiveAll( Socket_t xSocket,
+									 uint8_t *pucBuffer,
+									 size_t uxLength )
+	{
+	size_t uxReceived = 0U;
+	BaseType_t xResult;
+
+		while( uxReceived < uxLength )
+		{
+			xResult = FreeRTOS_recv( xSocket, pucBuffer + uxReceived, uxLength - uxReceived, 0 );
+
+			if( xResult <= 0 )
+			{
+				break;
+			}
+
+			uxReceived += ( size_t ) xResult;
+		}
+
+		return ( uxReceived == uxLength ) ? pdPASS : pdFAIL;
+	}
+/*-----------------------------------------------------------*/
+
+	static int prvCompareLatency( const void *pvLeft,
+								  const void *pvRight )
+	{
+	uint64_t ullLeft = *( ( const uint64_t * ) pvLeft );
+	uint64_t ullRight = *( ( const uint64_t * ) pvRight );
+
+		return ( ullLeft > ullRight ) - ( ullLeft < ullRight );
+	}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigIP_STACK_COUNT */
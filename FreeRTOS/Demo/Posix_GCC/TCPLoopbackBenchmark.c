@@ -0,0 +1,251 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A benchmark for the loopback path of the IP-task.
+ *
+ * A server task listens on port loopbenchPORT and receives everything that is
+ * sent to it.  The client task connects to 127.0.0.1, sends loopbenchMEGABYTES
+ * MB, closes the connection, and reports the number of bytes per second.  None
+ * of the packets reach the network driver: they are handed back to the IP-task
+ * by xLoopbackOutput().
+ *
+ * The measurement is repeated loopbenchROUNDS times, so the effect of
+ * ipconfigLOOPBACK_SKIP_CHECKSUMS and of the stream buffer sizes can be
+ * compared between runs.
+ *
+ * ipconfigUSE_LOOPBACK must be set to 1 in FreeRTOSIPConfig.h.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/* Demo application includes. */
+#include "console.h"
+#include "TCPLoopbackBenchmark.h"
+
+/* Exclude the whole file if FreeRTOSIPConfig.h does not enable loopback. */
+#if ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_LOOPBACK != 0 )
+
+/* The port number that the server listens on. */
+	#define loopbenchPORT			  ( 8091U )
+
+/* The number of megabytes sent per round, and the number of rounds. */
+	#define loopbenchMEGABYTES		  ( 16U )
+	#define loopbenchROUNDS			  ( 3U )
+
+/* The size of the blocks passed to FreeRTOS_send() and FreeRTOS_recv(). */
+	#define loopbenchBLOCK_SIZE		  ( 4096U )
+
+/* The maximum time to wait for a connection, or for a send or receive call. */
+	#define loopbenchTIMEOUT		  pdMS_TO_TICKS( 5000U )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Accepts connections and receives all data, until the peer shuts down.
+ */
+	static void prvLoopbackServerTask( void *pvParameters );
+
+/*
+ * Connects to the server through 127.0.0.1, sends the data and reports.
+ */
+	static void prvLoopbackClientTask( void *pvParameters );
+
+/*-----------------------------------------------------------*/
+
+/* The number of bytes received by the server task. */
+	static volatile uint32_t ulServerReceived = 0U;
+
+/* The blocks that are sent and received. */
+	static uint8_t ucSendBuffer[ loopbenchBLOCK_SIZE ];
+	static uint8_t ucReceiveBuffer[ loopbenchBLOCK_SIZE ];
+
+/*-----------------------------------------------------------*/
+
+	void vStartTCPLoopbackBenchmark( uint16_t usTaskStackSize,
+									 UBaseType_t uxTaskPriority )
+	{
+		xTaskCreate( prvLoopbackServerTask, "LoopServer", usTaskStackSize, NULL, uxTaskPriority, NULL );
+		xTaskCreate( prvLoopbackClientTask, "LoopClient", usTaskStackSize, NULL, uxTaskPriority, NULL );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvLoopbackServerTask( void *pvParameters )
+	{
+	Socket_t xListeningSocket, xConnectedSocket;
+	struct freertos_sockaddr xBindAddress, xClient;
+	socklen_t xSize = sizeof( xClient );
+	const TickType_t xTimeOut = loopbenchTIMEOUT;
+	BaseType_t xBacklog = 1;
+	int32_t lReceived;
+
+		( void ) pvParameters;
+
+		xListeningSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+		configASSERT( xListeningSocket != FREERTOS_INVALID_SOCKET );
+
+		xBindAddress.sin_port = FreeRTOS_htons( loopbenchPORT );
+		xBindAddress.sin_addr = 0U;
+		FreeRTOS_bind( xListeningSocket, &xBindAddress, sizeof( xBindAddress ) );
+		FreeRTOS_listen( xListeningSocket, xBacklog );
+
+		for( ; ; )
+		{
+			xConnectedSocket = FreeRTOS_accept( xListeningSocket, &xClient, &xSize );
+
+			if( ( xConnectedSocket == NULL ) || ( xConnectedSocket == FREERTOS_INVALID_SOCKET ) )
+			{
+				continue;
+			}
+
+			FreeRTOS_setsockopt( xConnectedSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+			for( ; ; )
+			{
+				lReceived = FreeRTOS_recv( xConnectedSocket, ucReceiveBuffer, sizeof( ucReceiveBuffer ), 0 );
+
+				if( lReceived > 0 )
+				{
+					ulServerReceived += ( uint32_t ) lReceived;
+				}
+				else if( lReceived < 0 )
+				{
+					/* The client has shut down the connection, or an error
+					occurred. */
+					break;
+				}
+				else
+				{
+					/* Time-out, keep on waiting. */
+				}
+			}
+
+			FreeRTOS_shutdown( xConnectedSocket, FREERTOS_SHUT_RDWR );
+			FreeRTOS_closesocket( xConnectedSocket );
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvLoopbackClientTask( void *pvParameters )
+	{
+	Socket_t xSocket;
+	struct freertos_sockaddr xServerAddress;
+	const TickType_t xTimeOut = loopbenchTIMEOUT;
+	const uint32_t ulTotal = loopbenchMEGABYTES * 1024UL * 1024UL;
+	uint32_t ulSent, ulRound, ulExpected = 0U;
+	TickType_t xStartTime, xDuration;
+	BaseType_t xResult;
+	size_t uxIndex;
+
+		( void ) pvParameters;
+
+		for( uxIndex = 0U; uxIndex < sizeof( ucSendBuffer ); uxIndex++ )
+		{
+			ucSendBuffer[ uxIndex ] = ( uint8_t ) uxIndex;
+		}
+
+		/* Let the server task create its socket first. */
+		vTaskDelay( pdMS_TO_TICKS( 100U ) );
+
+		xServerAddress.sin_port = FreeRTOS_htons( loopbenchPORT );
+		xServerAddress.sin_addr = FreeRTOS_inet_addr_quick( 127, 0, 0, 1 );
+
+		for( ulRound = 0U; ulRound < loopbenchROUNDS; ulRound++ )
+		{
+			xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+			configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+
+			FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+			FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+			if( FreeRTOS_connect( xSocket, &xServerAddress, sizeof( xServerAddress ) ) != 0 )
+			{
+				console_print( "Loopback benchmark: connect to 127.0.0.1 failed\n" );
+				FreeRTOS_closesocket( xSocket );
+				break;
+			}
+
+			xStartTime = xTaskGetTickCount();
+
+			for( ulSent = 0U; ulSent < ulTotal; ulSent += ( uint32_t ) xResult )
+			{
+				xResult = FreeRTOS_send( xSocket, ucSendBuffer, sizeof( ucSendBuffer ), 0 );
+
+				if( xResult <= 0 )
+				{
+					break;
+				}
+			}
+
+			/* Wait until the server has received everything. */
+			ulExpected += ulSent;
+
+			while( ( ulServerReceived < ulExpected ) && ( ( xTaskGetTickCount() - xStartTime ) < ( loopbenchTIMEOUT * loopbenchMEGABYTES ) ) )
+			{
+				vTaskDelay( 1U );
+			}
+
+			xDuration = xTaskGetTickCount() - xStartTime;
+
+			if( xDuration == 0U )
+			{
+				xDuration = 1U;
+			}
+
+			console_print( "Loopback benchmark: %lu of %lu bytes in %lu ms, %lu KB/s\n",
+						   ( unsigned long ) ulSent,
+						   ( unsigned long ) ulTotal,
+						   ( unsigned long ) ( xDuration * portTICK_PERIOD_MS ),
+						   ( unsigned long ) ( ulSent / ( xDuration * portTICK_PERIOD_MS ) ) );
+
+			FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+
+			/* Wait for the connection to be closed by the server. */
+			while( FreeRTOS_recv( xSocket, ucSendBuffer, 0U, 0 ) >= 0 )
+			{
+				vTaskDelay( pdMS_TO_TICKS( 10U ) );
+			}
+
+			FreeRTOS_closesocket( xSocket );
+		}
+
+		vTaskDelete( NULL );
+	}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_LOOPBACK */
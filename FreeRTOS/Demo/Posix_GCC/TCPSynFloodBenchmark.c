@@ -0,0 +1,394 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A benchmark for the handling of connection requests by a listening socket.
+ *
+ * A listening socket is created on port synbenchPORT, and a task accepts and
+ * closes every new connection.  The benchmark task then passes a burst of
+ * synbenchSYN_COUNT SYN packets to the IP-task, as if they were received by
+ * the network driver.  The packets come from different peers in the
+ * 198.18.0.0/15 benchmark network.  When all SYN's have been handled, the
+ * memory used by the half-open connections is reported.  After that, the
+ * handshakes are completed by passing the final ACK's, and the number of
+ * connections accepted per second is reported.
+ *
+ * Build the demo once with ipconfigTCP_SYN_CACHE_ENTRIES set to 0, in which
+ * case each SYN creates a new socket, and once with a SYN cache, to compare
+ * the heap usage under a SYN flood.
+ *
+ * Note that the SYN+ACK's and RST's are really sent to the network interface
+ * that the demo uses.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkBufferManagement.h"
+
+/* Demo application includes. */
+#include "console.h"
+#include "TCPSynFloodBenchmark.h"
+
+/* Exclude the whole file if FreeRTOSIPConfig.h is configured to use UDP only. */
+#if ( ipconfigUSE_TCP == 1 )
+
+/* The port number that the listening socket is bound to. */
+	#define synbenchPORT				  ( 8089 )
+
+/* The number of SYN's in a burst, each from a different peer. */
+	#define synbenchSYN_COUNT			  ( 256U )
+
+/* The first peer address, 198.18.0.1, and the first peer port number. */
+	#define synbenchFIRST_PEER_IP		  FreeRTOS_inet_addr_quick( 198, 18, 0, 1 )
+	#define synbenchFIRST_PEER_PORT		  ( 20000U )
+
+/* The maximum time to wait for the IP-task to handle a burst. */
+	#define synbenchBURST_TIMEOUT		  pdMS_TO_TICKS( 10000U )
+
+/* The TCP flags used by the benchmark. */
+	#define synbenchFLAG_SYN			  ( ( uint8_t ) 0x02U )
+	#define synbenchFLAG_ACK			  ( ( uint8_t ) 0x10U )
+
+/* The SYN's contain the options MSS (4 bytes) and window scaling (4 bytes). */
+	#define synbenchSYN_OPTIONS_LENGTH	  ( 8U )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Creates the listening socket, injects the SYN's and ACK's and reports.
+ */
+	static void prvSynFloodTask( void *pvParameters );
+
+/*
+ * Accepts and closes the new connections, counting them.
+ */
+	static void prvAcceptTask( void *pvParameters );
+
+/*
+ * Passes a TCP packet from a peer to the IP-task, as if it was received by
+ * the network driver.
+ */
+	static void prvInjectPacket( uint32_t ulPeerIP,
+								 uint16_t usPeerPort,
+								 uint8_t ucTCPFlags,
+								 uint32_t ulSequenceNumber,
+								 uint32_t ulAckNumber );
+
+/*
+ * Waits until the IP-task has released all injected network buffers.
+ */
+	static BaseType_t prvWaitForIPTask( UBaseType_t uxFreeBuffers );
+
+/*
+ * Returns the number of bytes in use on the heap (heap_3 uses malloc()).
+ */
+	static size_t prvHeapInUse( void );
+
+/*-----------------------------------------------------------*/
+
+/* The socket on which the connections are accepted. */
+	static Socket_t xListeningSocket = FREERTOS_INVALID_SOCKET;
+
+/* The number of accepted connections. */
+	static volatile uint32_t ulAcceptCount = 0U;
+
+/* The MAC address of the simulated peers, a locally administered one. */
+	static const uint8_t ucPeerMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ] = { 0x02, 0x00, 0x00, 0x5a, 0x18, 0x01 };
+
+/*-----------------------------------------------------------*/
+
+	void vStartTCPSynFloodBenchmark( uint16_t usTaskStackSize,
+									 UBaseType_t uxTaskPriority )
+	{
+		xTaskCreate( prvSynFloodTask, "SynBench", usTaskStackSize, NULL, uxTaskPriority, NULL );
+	}
+/*-----------------------------------------------------------*/
+
+	uint32_t ulSynFloodBenchmarkSequenceNumber( uint32_t ulSourceAddress,
+												uint16_t usSourcePort,
+												uint32_t ulDestinationAddress,
+												uint16_t usDestinationPort )
+	{
+	uint32_t ulHash;
+
+		/* Mix the four values, in the same representation as the IP-task
+		passes them. */
+		ulHash = ulSourceAddress ^ ( ulDestinationAddress * 0x9E3779B1UL );
+		ulHash ^= ( ( ( uint32_t ) usSourcePort ) << 16 ) | ( ( uint32_t ) usDestinationPort );
+		ulHash ^= ulHash >> 16;
+		ulHash *= 0x45d9f3bUL;
+		ulHash ^= ulHash >> 16;
+
+		/* Zero means that no sequence number is available. */
+		return ulHash | 1UL;
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvSynFloodTask( void *pvParameters )
+	{
+	struct freertos_sockaddr xBindAddress;
+	uint32_t ulIndex, ulPeerIP, ulPeerSequenceNumber, ulOurSequenceNumber;
+	uint16_t usPeerPort;
+	UBaseType_t uxFreeBuffers;
+	size_t uxHeapBefore, uxHeapAfter;
+	TickType_t xStartTime, xSynTime, xAcceptTime;
+	uint32_t ulAccepted;
+
+		( void ) pvParameters;
+
+		xListeningSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+		configASSERT( xListeningSocket != FREERTOS_INVALID_SOCKET );
+
+		xBindAddress.sin_port = FreeRTOS_htons( synbenchPORT );
+		xBindAddress.sin_addr = 0U;
+		FreeRTOS_bind( xListeningSocket, &xBindAddress, sizeof( xBindAddress ) );
+		FreeRTOS_listen( xListeningSocket, ( BaseType_t ) synbenchSYN_COUNT );
+
+		xTaskCreate( prvAcceptTask, "SynAccept", configMINIMAL_STACK_SIZE * 2, NULL, uxTaskPriorityGet( NULL ), NULL );
+
+		/* Let the IP-task handle the listen() first. */
+		vTaskDelay( pdMS_TO_TICKS( 100U ) );
+
+		uxFreeBuffers = uxGetNumberOfFreeNetworkBuffers();
+		uxHeapBefore = prvHeapInUse();
+
+		/* Phase 1: a burst of SYN's. */
+		xStartTime = xTaskGetTickCount();
+
+		for( ulIndex = 0U; ulIndex < synbenchSYN_COUNT; ulIndex++ )
+		{
+			ulPeerIP = FreeRTOS_htonl( FreeRTOS_ntohl( synbenchFIRST_PEER_IP ) + ulIndex );
+			usPeerPort = ( uint16_t ) ( synbenchFIRST_PEER_PORT + ulIndex );
+			ulPeerSequenceNumber = ulIndex * 0x10000UL;
+
+			prvInjectPacket( ulPeerIP, usPeerPort, synbenchFLAG_SYN, ulPeerSequenceNumber, 0U );
+		}
+
+		( void ) prvWaitForIPTask( uxFreeBuffers );
+		xSynTime = xTaskGetTickCount() - xStartTime;
+		uxHeapAfter = prvHeapInUse();
+
+		console_print( "SYN burst: %lu SYN's handled in %lu ms\n",
+					   ( unsigned long ) synbenchSYN_COUNT,
+					   ( unsigned long ) ( xSynTime * portTICK_PERIOD_MS ) );
+		console_print( "SYN burst: heap grew by %lu bytes, %lu bytes per half-open connection\n",
+					   ( unsigned long ) ( uxHeapAfter - uxHeapBefore ),
+					   ( unsigned long ) ( ( uxHeapAfter - uxHeapBefore ) / synbenchSYN_COUNT ) );
+
+		/* Phase 2: complete the handshakes. */
+		xStartTime = xTaskGetTickCount();
+
+		for( ulIndex = 0U; ulIndex < synbenchSYN_COUNT; ulIndex++ )
+		{
+			ulPeerIP = FreeRTOS_htonl( FreeRTOS_ntohl( synbenchFIRST_PEER_IP ) + ulIndex );
+			usPeerPort = ( uint16_t ) ( synbenchFIRST_PEER_PORT + ulIndex );
+			ulPeerSequenceNumber = ulIndex * 0x10000UL;
+
+			/* Use the same parameters as prvHandleListen() does. */
+			ulOurSequenceNumber = ulSynFloodBenchmarkSequenceNumber( FreeRTOS_GetIPAddress(),
+																	 synbenchPORT,
+																	 ulPeerIP,
+																	 FreeRTOS_htons( usPeerPort ) );
+
+			prvInjectPacket( ulPeerIP, usPeerPort, synbenchFLAG_ACK, ulPeerSequenceNumber + 1UL, ulOurSequenceNumber + 1UL );
+		}
+
+		( void ) prvWaitForIPTask( uxFreeBuffers );
+
+		/* Wait for the accept task to catch up. */
+		while( ( ulAcceptCount < synbenchSYN_COUNT ) && ( ( xTaskGetTickCount() - xStartTime ) < synbenchBURST_TIMEOUT ) )
+		{
+			vTaskDelay( 1U );
+		}
+
+		xAcceptTime = xTaskGetTickCount() - xStartTime;
+		ulAccepted = ulAcceptCount;
+
+		if( xAcceptTime == 0U )
+		{
+			xAcceptTime = 1U;
+		}
+
+		console_print( "Accept: %lu of %lu connections accepted in %lu ms, %lu per second\n",
+					   ( unsigned long ) ulAccepted,
+					   ( unsigned long ) synbenchSYN_COUNT,
+					   ( unsigned long ) ( xAcceptTime * portTICK_PERIOD_MS ),
+					   ( unsigned long ) ( ( ulAccepted * 1000UL ) / ( xAcceptTime * portTICK_PERIOD_MS ) ) );
+		console_print( "Accept: heap in use %lu bytes after the benchmark, %lu before\n",
+					   ( unsigned long ) prvHeapInUse(),
+					   ( unsigned long ) uxHeapBefore );
+
+		vTaskDelete( NULL );
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvAcceptTask( void *pvParameters )
+	{
+	struct freertos_sockaddr xClient;
+	socklen_t xSize = sizeof( xClient );
+	Socket_t xConnectedSocket;
+
+		( void ) pvParameters;
+
+		for( ; ; )
+		{
+			xConnectedSocket = FreeRTOS_accept( xListeningSocket, &xClient, &xSize );
+
+			if( ( xConnectedSocket != NULL ) && ( xConnectedSocket != FREERTOS_INVALID_SOCKET ) )
+			{
+				ulAcceptCount++;
+				FreeRTOS_closesocket( xConnectedSocket );
+			}
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static void prvInjectPacket( uint32_t ulPeerIP,
+								 uint16_t usPeerPort,
+								 uint8_t ucTCPFlags,
+								 uint32_t ulSequenceNumber,
+								 uint32_t ulAckNumber )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	TCPPacket_t *pxTCPPacket;
+	IPStackEvent_t xRxEvent;
+	size_t uxOptionsLength = ( ( ucTCPFlags & synbenchFLAG_SYN ) != 0U ) ? synbenchSYN_OPTIONS_LENGTH : 0U;
+	size_t uxIPLength = ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength;
+
+		/* The buffer must be big enough to hold a SYN+ACK with options. */
+		pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( sizeof( TCPPacket_t ), portMAX_DELAY );
+
+		if( pxNetworkBuffer != NULL )
+		{
+			( void ) memset( pxNetworkBuffer->pucEthernetBuffer, 0, sizeof( TCPPacket_t ) );
+			pxTCPPacket = ( TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+
+			( void ) memcpy( pxTCPPacket->xEthernetHeader.xDestinationAddress.ucBytes, FreeRTOS_GetMACAddress(), ipMAC_ADDRESS_LENGTH_BYTES );
+			( void ) memcpy( pxTCPPacket->xEthernetHeader.xSourceAddress.ucBytes, ucPeerMACAddress, ipMAC_ADDRESS_LENGTH_BYTES );
+			pxTCPPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+
+			pxTCPPacket->xIPHeader.ucVersionHeaderLength = 0x45U;
+			pxTCPPacket->xIPHeader.usLength = FreeRTOS_htons( ( uint16_t ) uxIPLength );
+			pxTCPPacket->xIPHeader.ucTimeToLive = 64U;
+			pxTCPPacket->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+			pxTCPPacket->xIPHeader.ulSourceIPAddress = ulPeerIP;
+			pxTCPPacket->xIPHeader.ulDestinationIPAddress = FreeRTOS_GetIPAddress();
+			pxTCPPacket->xIPHeader.usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxTCPPacket->xIPHeader ), ipSIZE_OF_IPv4_HEADER );
+			pxTCPPacket->xIPHeader.usHeaderChecksum = ~FreeRTOS_htons( pxTCPPacket->xIPHeader.usHeaderChecksum );
+
+			pxTCPPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( usPeerPort );
+			pxTCPPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( synbenchPORT );
+			pxTCPPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( ulSequenceNumber );
+			pxTCPPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( ulAckNumber );
+			pxTCPPacket->xTCPHeader.ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+			pxTCPPacket->xTCPHeader.ucTCPFlags = ucTCPFlags;
+			pxTCPPacket->xTCPHeader.usWindow = FreeRTOS_htons( 0x2000U );
+
+			if( uxOptionsLength != 0U )
+			{
+				/* MSS 1460, NOP, window scale factor 2. */
+				pxTCPPacket->xTCPHeader.ucOptdata[ 0 ] = 2U;
+				pxTCPPacket->xTCPHeader.ucOptdata[ 1 ] = 4U;
+				pxTCPPacket->xTCPHeader.ucOptdata[ 2 ] = 0x05U;
+				pxTCPPacket->xTCPHeader.ucOptdata[ 3 ] = 0xb4U;
+				pxTCPPacket->xTCPHeader.ucOptdata[ 4 ] = 1U;
+				pxTCPPacket->xTCPHeader.ucOptdata[ 5 ] = 3U;
+				pxTCPPacket->xTCPHeader.ucOptdata[ 6 ] = 3U;
+				pxTCPPacket->xTCPHeader.ucOptdata[ 7 ] = 2U;
+			}
+
+			pxNetworkBuffer->xDataLength = ipSIZE_OF_ETH_HEADER + uxIPLength;
+			( void ) usGenerateProtocolChecksum( pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdTRUE );
+
+			xRxEvent.eEventType = eNetworkRxEvent;
+			xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+
+			if( xSendEventStructToIPTask( &xRxEvent, portMAX_DELAY ) == pdFAIL )
+			{
+				vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+			}
+		}
+	}
+/*-----------------------------------------------------------*/
+
+	static BaseType_t prvWaitForIPTask( UBaseType_t uxFreeBuffers )
+	{
+	TickType_t xStartTime = xTaskGetTickCount();
+	BaseType_t xReturn = pdPASS;
+
+		while( uxGetNumberOfFreeNetworkBuffers() < uxFreeBuffers )
+		{
+			if( ( xTaskGetTickCount() - xStartTime ) >= synbenchBURST_TIMEOUT )
+			{
+				console_print( "SYN benchmark: the IP-task did not release all buffers\n" );
+				xReturn = pdFAIL;
+				break;
+			}
+
+			vTaskDelay( 1U );
+		}
+
+		return xReturn;
+	}
+/*-----------------------------------------------------------*/
+
+	static size_t prvHeapInUse( void )
+	{
+	size_t uxInUse;
+
+		#if defined( __GLIBC__ ) && ( ( __GLIBC__ > 2 ) || ( ( __GLIBC__ == 2 ) && ( __GLIBC_MINOR__ >= 33 ) ) )
+		{
+		struct mallinfo2 xInfo = mallinfo2();
+
+			uxInUse = xInfo.uordblks;
+		}
+		#else
+		{
+		struct mallinfo xInfo = mallinfo();
+
+			uxInUse = ( size_t ) xInfo.uordblks;
+		}
+		#endif
+
+		return uxInUse;
+	}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_TCP */
@@ -0,0 +1,47 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+#ifndef TCP_SYN_FLOOD_BENCHMARK_H
+#define TCP_SYN_FLOOD_BENCHMARK_H
+
+/*
+ * Create the task that injects a burst of SYN's into the IP-task, completes
+ * the handshakes, and reports the heap usage and the accept throughput.
+ */
+void vStartTCPSynFloodBenchmark( uint16_t usTaskStackSize, UBaseType_t uxTaskPriority );
+
+/*
+ * While the benchmark is running, ulApplicationGetNextSequenceNumber() must
+ * return this predictable number, so the benchmark can acknowledge the
+ * SYN+ACK's without seeing them.
+ */
+uint32_t ulSynFloodBenchmarkSequenceNumber( uint32_t ulSourceAddress,
+											uint16_t usSourcePort,
+											uint32_t ulDestinationAddress,
+											uint16_t usDestinationPort );
+
+#endif /* TCP_SYN_FLOOD_BENCHMARK_H */
@@ -0,0 +1,191 @@
+#!/bin/sh
+#
+# Builds posix_bench in several optimized variants, runs the benchmark of
+# NetworkBenchmark.c with every variant, and writes a report that compares
+# the results with those of the default build:
+#
+#     ./bench_report.sh [ISA ...]
+#
+# The variants are the default build, LTO, PGO, and LTO with PGO.  Every ISA
+# on the command line, for instance "native" or "x86-64-v3", adds a variant
+# with that -march, and one with -march, LTO and PGO together.  The profile of
+# the PGO variants is generated by a run of the same benchmark.  The script
+# stops when that run fails, or when it leaves no profile behind.  It also
+# stops when a measured run fails or prints no results.
+#
+# The report is written to bench_report.md, or to $BENCH_REPORT.  A run that
+# takes longer than $BENCH_TIMEOUT seconds (600) is stopped.
+
+set -e
+cd "$(dirname "$0")"
+
+REPORT=${BENCH_REPORT:-bench_report.md}
+TIMEOUT=${BENCH_TIMEOUT:-600}
+RESULTS=$(mktemp -d)
+trap 'rm -rf "$RESULTS"' EXIT
+
+# Print the directory in which SConstruct builds the variant with the given
+# options.  The options must be passed in the order --lto, --march, --pgo.
+variant_dir()
+{
+    dir=build
+    for option in "$@"; do
+        case $option in
+            --lto) dir=$dir-lto ;;
+            --march=*) dir=$dir-${option#--march=} ;;
+            --pgo=*) dir=$dir-pgo ;;
+        esac
+    done
+    echo "$dir"
+}
+
+# run_variant <name> <pgo|nopgo> [scons options]
+run_variant()
+{
+    name=$1
+    pgo=$2
+    shift 2
+    count=$(($(wc -l < "$RESULTS/names") + 1))
+
+    if [ "$pgo" = pgo ]; then
+        dir=$(variant_dir "$@" --pgo=generate)
+        echo "$name: building the instrumented program" >&2
+        scons -Q "$@" --pgo=generate posix_bench > /dev/null
+        find "$dir" -name '*.gcda' -exec rm -f {} +
+        echo "$name: generating the profile" >&2
+        if ! timeout "$TIMEOUT" "./$dir/posix_bench" > /dev/null; then
+            echo "$name: the training run failed" >&2
+            exit 1
+        fi
+        if [ -z "$(find "$dir" -name '*.gcda' -print)" ]; then
+            echo "$name: the training run wrote no profile (.gcda files)" >&2
+            exit 1
+        fi
+        echo "$name: building with the profile" >&2
+        scons -Q "$@" --pgo=use posix_bench > /dev/null
+        options="${*:+$* }--pgo=generate/use"
+    else
+        dir=$(variant_dir "$@")
+        echo "$name: building" >&2
+        scons -Q "$@" posix_bench > /dev/null
+        options="$*"
+    fi
+
+    echo "$name: running" >&2
+    if ! timeout "$TIMEOUT" "./$dir/posix_bench" > "$RESULTS/output"; then
+        echo "$name: the benchmark run failed" >&2
+        exit 1
+    fi
+    echo "variant $name" > "$RESULTS/$count"
+    if ! grep '^netbench:' "$RESULTS/output" >> "$RESULTS/$count"; then
+        echo "$name: the benchmark run printed no results" >&2
+        exit 1
+    fi
+
+    echo "$name" >> "$RESULTS/names"
+    echo "| $name | \`${options:-none}\` |" >> "$RESULTS/options"
+}
+
+: > "$RESULTS/names"
+: > "$RESULTS/options"
+
+run_variant default nopgo
+run_variant lto nopgo --lto
+run_variant pgo pgo
+run_variant lto+pgo pgo --lto
+
+for isa in "$@"; do
+    run_variant "$isa" nopgo "--march=$isa"
+    run_variant "lto+pgo+$isa" pgo --lto "--march=$isa"
+done
+
+count=$(wc -l < "$RESULTS/names")
+files=""
+i=1
+while [ "$i" -le "$count" ]; do
+    files="$files $RESULTS/$i"
+    i=$((i + 1))
+done
+
+{
+    echo "# posix_bench report"
+    echo
+    echo "Date: $(date '+%Y-%m-%d %H:%M')"
+    echo "CPU: $(grep -m 1 'model name' /proc/cpuinfo | sed 's/.*: //')"
+    echo "Compiler: $(${CC:-gcc} --version | head -n 1)"
+    echo
+    echo "| variant | SCons options |"
+    echo "| --- | --- |"
+    cat "$RESULTS/options"
+    echo
+
+    # The lines of a test look like:
+    #   netbench: <test> <bytes> B <seconds> s <rate> Gbit/s <frames> pkt/s <cpu> ns/B
+    #   netbench:   <n> transactions/s, latency p50 <us> us, p99 <us> us, p99.9 <us> us
+    # The relative change is against the first variant.
+    # shellcheck disable=SC2086
+    awk '
+        NR == FNR { names[ ++variants ] = $0; next }
+        FNR == 1 { v++; next }
+        / Gbit\/s / {
+            for( i = 3; i < NF; i++ ) if( $( i + 1 ) == "B" ) break
+            test = $2
+            for( j = 3; j < i; j++ ) test = test " " $j
+            if( !( test in seen ) ) { seen[ test ] = 1; tests[ ++ntests ] = test }
+            gbps[ v, test ] = $( i + 4 )
+            pps[ v, test ] = $( i + 6 )
+            cpu[ v, test ] = $( i + 8 )
+            last = test
+            next
+        }
+        / latency / {
+            for( i = 1; i < NF; i++ )
+            {
+                if( $i == "p50" ) p50[ v, last ] = $( i + 1 )
+                if( $i == "p99" ) p99[ v, last ] = $( i + 1 )
+                if( $i == "p99.9" ) p999[ v, last ] = $( i + 1 )
+            }
+            latency[ last ] = 1
+        }
+        function cell( value, base )
+        {
+            if( value == "" ) return "-"
+            if( base == "" || base + 0 == 0 || value == base ) return value
+            return sprintf( "%s (%+.1f%%)", value, ( value / base - 1 ) * 100 )
+        }
+        function header( title,    k, line, rule )
+        {
+            print "## " title
+            print ""
+            line = "| test |"; rule = "| --- |"
+            for( k = 1; k <= variants; k++ ) { line = line " " names[ k ] " |"; rule = rule " --- |" }
+            print line
+            print rule
+        }
+        function table( title, values, only_latency,    t, k, line )
+        {
+            header( title )
+            for( t = 1; t <= ntests; t++ )
+            {
+                if( only_latency && !( tests[ t ] in latency ) ) continue
+                line = "| " tests[ t ] " |"
+                for( k = 1; k <= variants; k++ )
+                {
+                    line = line " " cell( values[ k, tests[ t ] ], values[ 1, tests[ t ] ] ) " |"
+                }
+                print line
+            }
+            print ""
+        }
+        END {
+            table( "Throughput (Gbit/s)", gbps, 0 )
+            table( "Frames on the link per second", pps, 0 )
+            table( "CPU time per byte (ns)", cpu, 0 )
+            table( "Latency p50 (us)", p50, 1 )
+            table( "Latency p99 (us)", p99, 1 )
+            table( "Latency p99.9 (us)", p999, 1 )
+        }
+    ' "$RESULTS/names" $files
+} > "$REPORT"
+
+echo "The report was written to $REPORT" >&2
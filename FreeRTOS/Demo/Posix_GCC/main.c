@@ -61,6 +61,7 @@
 
 /* Local includes. */
 #include "console.h"
+#include "run-time-stats-utils.h"
 
 /* This project provides two demo applications.  A simple blinky style demo
 application, and a more comprehensive test and demo application.  The
@@ -80,6 +81,26 @@ implemented and described in main_full.c. */
 	#define mainCREATE_TCP_ECHO_TASKS_SINGLE    1
 #endif
 
+/* Set mainRUN_TIME_STATS_EXPORT to runtimestatsFORMAT_CSV or
+runtimestatsFORMAT_JSON to write the CPU usage of every task to
+mainRUN_TIME_STATS_FILE every mainRUN_TIME_STATS_PERIOD_MS milliseconds, see
+run-time-stats-utils.c.  The --stats option of SCons sets it. */
+#ifndef mainRUN_TIME_STATS_EXPORT
+	#define mainRUN_TIME_STATS_EXPORT    0
+#endif
+
+#ifndef mainRUN_TIME_STATS_FILE
+	#if ( mainRUN_TIME_STATS_EXPORT == runtimestatsFORMAT_JSON )
+		#define mainRUN_TIME_STATS_FILE    "run_time_stats.json"
+	#else
+		#define mainRUN_TIME_STATS_FILE    "run_time_stats.csv"
+	#endif
+#endif
+
+#ifndef mainRUN_TIME_STATS_PERIOD_MS
+	#define mainRUN_TIME_STATS_PERIOD_MS    1000U
+#endif
+
 /* This demo uses heap_3.c (the libc provided malloc() and free()). */
 
 /*-----------------------------------------------------------*/
@@ -153,6 +174,13 @@ int main( void )
 	#endif
 
 	console_init();
+
+	#if ( mainRUN_TIME_STATS_EXPORT != 0 )
+	{
+		vStartRunTimeStatsExport( mainRUN_TIME_STATS_FILE, mainRUN_TIME_STATS_PERIOD_MS, mainRUN_TIME_STATS_EXPORT );
+	}
+	#endif
+
 	#if ( mainCREATE_TCP_ECHO_TASKS_SINGLE == 1 )
 	{
 		main_tcp_echo_client_tasks();
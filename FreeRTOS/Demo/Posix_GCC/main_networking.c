@@ -49,6 +49,11 @@
 /*#include "TCPEchoClient_SingleTasks.h" */
 /*#include "demo_logging.h" */
 #include "TCPEchoClient_SingleTasks.h"
+#include "TCPSynFloodBenchmark.h"
+#include "IPFragmentBenchmark.h"
+#include "TCPLoopbackBenchmark.h"
+#include "IperfServer.h"
+#include "NetworkBenchmark.h"
 
 /* Simple UDP client and server task parameters. */
 #define mainSIMPLE_UDP_CLIENT_SERVER_TASK_PRIORITY	  ( tskIDLE_PRIORITY )
@@ -78,6 +83,57 @@ FreeRTOSConfig.h.
 
 */
 #define mainCREATE_TCP_ECHO_TASKS_SINGLE			  1
+
+/*
+mainCREATE_TCP_SYN_FLOOD_BENCHMARK:  When set to 1 a task is created that
+passes a burst of SYN packets to the IP-task, completes the handshakes, and
+reports the heap used by the half-open connections and the number of accepted
+connections per second.  See TCPSynFloodBenchmark.c.  The initial sequence
+numbers become predictable, so do not enable this in a real application.
+*/
+#define mainCREATE_TCP_SYN_FLOOD_BENCHMARK			  0
+
+/*
+mainCREATE_IP_FRAGMENT_BENCHMARK:  When set to 1 a task is created that passes
+fragmented UDP datagrams to the IP-task, and reports the heap used by the
+reassembly slots and the number of datagrams reassembled per second, for 2 to 8
+fragments per datagram.  See IPFragmentBenchmark.c.  ipconfigIP_REASSEMBLY_SLOTS
+must be positive in FreeRTOSIPConfig.h.
+*/
+#define mainCREATE_IP_FRAGMENT_BENCHMARK			  0
+
+/*
+mainCREATE_TCP_LOOPBACK_BENCHMARK:  When set to 1 a server task and a client
+task are created that exchange data through 127.0.0.1, and the client reports
+the throughput of the loopback path.  See TCPLoopbackBenchmark.c.
+ipconfigUSE_LOOPBACK must be set to 1 in FreeRTOSIPConfig.h.
+*/
+#define mainCREATE_TCP_LOOPBACK_BENCHMARK			  0
+
+/*
+mainCREATE_IPERF_SERVER:  When set to 1 a task is created that runs the server
+side of the iperf3 protocol on port 5201, so that the throughput of the stack
+can be measured with a stock iperf3 client on the host.  See IperfServer.c.
+The --iperf option of SCons sets it.
+*/
+#ifndef mainCREATE_IPERF_SERVER
+	#define mainCREATE_IPERF_SERVER					  0
+#endif
+
+/*
+mainCREATE_NETWORK_BENCHMARK:  When set to 1 a second IP-stack is started at
+port 1 of the simulated link, and the tasks of NetworkBenchmark.c measure the
+throughput and the latency between the two stacks.  The posix_bench target of
+SCons sets it, together with ipconfigIP_STACK_COUNT.  The TCP echo tasks are
+not created, their server can not be reached through the simulated link.
+*/
+#ifndef mainCREATE_NETWORK_BENCHMARK
+	#define mainCREATE_NETWORK_BENCHMARK			  0
+#endif
+
+#if ( mainCREATE_NETWORK_BENCHMARK == 1 )
+	#include "SimulatedLink.h"
+#endif
 /*-----------------------------------------------------------*/
 
 /*
@@ -116,6 +172,12 @@ configNETWORK_INTERFACE_TO_USE definition for information on how to configure
 the real network connection to use. */
 const uint8_t ucMACAddress[ 6 ] = { configMAC_ADDR0, configMAC_ADDR1, configMAC_ADDR2, configMAC_ADDR3, configMAC_ADDR4, configMAC_ADDR5 };
 
+#if ( mainCREATE_NETWORK_BENCHMARK == 1 )
+	/* The addresses of the second stack, which runs the benchmark servers. */
+	static const uint8_t ucBenchIPAddress[ 4 ] = { configIP_ADDR0, configIP_ADDR1, configIP_ADDR2, configIP_ADDR3 + 1 };
+	static const uint8_t ucBenchMACAddress[ 6 ] = { configMAC_ADDR0, configMAC_ADDR1, configMAC_ADDR2, configMAC_ADDR3, configMAC_ADDR4, configMAC_ADDR5 + 1 };
+#endif
+
 /* Use by the pseudo random number generator. */
 static UBaseType_t ulNextRand;
 
@@ -148,6 +210,20 @@ const uint32_t ulLongTime_ms = pdMS_TO_TICKS( 1000UL );
 					 ucDNSServerAddress,
 					 ucMACAddress );
 
+	#if ( mainCREATE_NETWORK_BENCHMARK == 1 )
+	{
+		/* Start the second stack at the other end of the simulated link. */
+		FreeRTOS_IPInitStack( 1U,
+							  ucBenchIPAddress,
+							  ucNetMask,
+							  ucGatewayAddress,
+							  ucDNSServerAddress,
+							  ucBenchMACAddress,
+							  xSimLinkPort1Initialise,
+							  xSimLinkPort1Output );
+	}
+	#endif /* mainCREATE_NETWORK_BENCHMARK */
+
 	/* Start the RTOS scheduler. */
 	FreeRTOS_debug_printf( ( "vTaskStartScheduler\n" ) );
 	vTaskStartScheduler();
@@ -178,19 +254,52 @@ static BaseType_t xTasksAlreadyCreated = pdFALSE;
 	if( eNetworkEvent == eNetworkUp )
 	{
 		/* Create the tasks that use the IP stack if they have not already been
-		created. */
-		if( xTasksAlreadyCreated == pdFALSE )
+		created.  With more stacks, this is done when stack 0 comes up. */
+		if( ( xTasksAlreadyCreated == pdFALSE ) && ( FreeRTOS_GetIPStack() == 0U ) )
 		{
 			/* See the comments above the definitions of these pre-processor
 			macros at the top of this file for a description of the individual
 			demo tasks. */
 
-			#if ( mainCREATE_TCP_ECHO_TASKS_SINGLE == 1 )
+			#if ( mainCREATE_TCP_ECHO_TASKS_SINGLE == 1 ) && ( mainCREATE_NETWORK_BENCHMARK == 0 )
 			{
 				vStartTCPEchoClientTasks_SingleTasks( mainECHO_CLIENT_TASK_STACK_SIZE, mainECHO_CLIENT_TASK_PRIORITY );
 			}
 			#endif /* mainCREATE_TCP_ECHO_TASKS_SINGLE */
 
+			#if ( mainCREATE_TCP_SYN_FLOOD_BENCHMARK == 1 )
+			{
+				vStartTCPSynFloodBenchmark( mainECHO_SERVER_TASK_STACK_SIZE, mainECHO_SERVER_TASK_PRIORITY );
+			}
+			#endif /* mainCREATE_TCP_SYN_FLOOD_BENCHMARK */
+
+			#if ( mainCREATE_IP_FRAGMENT_BENCHMARK == 1 )
+			{
+				vStartIPFragmentBenchmark( mainECHO_SERVER_TASK_STACK_SIZE, mainECHO_SERVER_TASK_PRIORITY );
+			}
+			#endif /* mainCREATE_IP_FRAGMENT_BENCHMARK */
+
+			#if ( mainCREATE_TCP_LOOPBACK_BENCHMARK == 1 )
+			{
+				vStartTCPLoopbackBenchmark( mainECHO_SERVER_TASK_STACK_SIZE, mainECHO_SERVER_TASK_PRIORITY );
+			}
+			#endif /* mainCREATE_TCP_LOOPBACK_BENCHMARK */
+
+			#if ( mainCREATE_IPERF_SERVER == 1 )
+			{
+				vStartIperfServer( mainECHO_SERVER_TASK_STACK_SIZE, mainECHO_SERVER_TASK_PRIORITY );
+			}
+			#endif /* mainCREATE_IPERF_SERVER */
+
+			#if ( mainCREATE_NETWORK_BENCHMARK == 1 )
+			{
+				vStartNetworkBenchmark( mainECHO_SERVER_TASK_STACK_SIZE,
+										mainECHO_SERVER_TASK_PRIORITY,
+										1U,
+										FreeRTOS_inet_addr_quick( ucBenchIPAddress[ 0 ], ucBenchIPAddress[ 1 ], ucBenchIPAddress[ 2 ], ucBenchIPAddress[ 3 ] ) );
+			}
+			#endif /* mainCREATE_NETWORK_BENCHMARK */
+
 			xTasksAlreadyCreated = pdTRUE;
 		}
 
@@ -301,12 +410,20 @@ extern uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
 													uint32_t ulDestinationAddress,
 													uint16_t usDestinationPort )
 {
-	( void ) ulSourceAddress;
-	( void ) usSourcePort;
-	( void ) ulDestinationAddress;
-	( void ) usDestinationPort;
+	#if ( mainCREATE_TCP_SYN_FLOOD_BENCHMARK == 1 )
+	{
+		return ulSynFloodBenchmarkSequenceNumber( ulSourceAddress, usSourcePort, ulDestinationAddress, usDestinationPort );
+	}
+	#else
+	{
+		( void ) ulSourceAddress;
+		( void ) usSourcePort;
+		( void ) ulDestinationAddress;
+		( void ) usDestinationPort;
 
-	return uxRand();
+		return uxRand();
+	}
+	#endif
 }
 
 /*
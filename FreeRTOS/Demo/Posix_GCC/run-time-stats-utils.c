@@ -29,21 +29,86 @@
  * Utility functions required to gather run time statistics.  See:
  * http://www.freertos.org/rtos-run-time-stats.html
  *
- * Note that this is a simulated port, where simulated time is a lot slower than
- * real time, therefore the run time counter values have no real meaningful
- * units.
+ * The run time counter counts nanoseconds.  By default it follows
+ * CLOCK_MONOTONIC, so a task is charged for the wall-clock time during which
+ * it was the running task, including the time its thread waited in a system
+ * call.  When configRUN_TIME_STATS_USE_CPU_TIME is set to 1 it follows
+ * CLOCK_PROCESS_CPUTIME_ID instead, so a task is only charged for the CPU time
+ * that was used while it ran.  Only one task thread runs at a time in the
+ * Posix port, so the CPU time of the process is mostly that of the running
+ * task.  CLOCK_THREAD_CPUTIME_ID can not be used: the counter must be one
+ * clock for all threads, because the kernel subtracts the value read by the
+ * task that is switched in from the value read by the next switch.
  *
- * Also note that it is assumed this demo is going to be used for short periods
- * of time only, and therefore timer overflows are not handled.
+ * The kernel keeps 32-bit counters, which wrap around after about 4.29
+ * seconds.  vStartRunTimeStatsExport() takes snapshots more often than that,
+ * and adds the differences to 64-bit totals.
 */
 
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 /* FreeRTOS includes. */
 #include <FreeRTOS.h>
+#include "task.h"
+
+/* Demo application includes. */
+#include "run-time-stats-utils.h"
+
+#ifndef configRUN_TIME_STATS_USE_CPU_TIME
+	#define configRUN_TIME_STATS_USE_CPU_TIME	0
+#endif
+
+#if ( configRUN_TIME_STATS_USE_CPU_TIME == 1 )
+	#define runtimestatsCLOCK	CLOCK_PROCESS_CPUTIME_ID
+#else
+	#define runtimestatsCLOCK	CLOCK_MONOTONIC
+#endif
+
+/* The maximum number of tasks that vStartRunTimeStatsExport() follows. */
+#define runtimestatsMAX_TASKS	( 64U )
+
+/* The totals of one task. */
+typedef struct xRUN_TIME_TOTAL
+{
+	UBaseType_t uxTaskNumber;		/* The unique number that the kernel gave the task. */
+	uint32_t ulLastCounter;			/* The 32-bit counter of the previous snapshot. */
+	uint64_t ullTotalNs;			/* The total run time since the task was first seen. */
+	BaseType_t xSeen;				/* The task was present in the latest snapshot. */
+} RunTimeTotal_t;
+
+/* The parameters of the export task. */
+typedef struct xRUN_TIME_EXPORT
+{
+	FILE *pxFile;
+	TickType_t xPeriod;
+	BaseType_t xFormat;
+} RunTimeExport_t;
+
+/*
+ * Takes a snapshot of all tasks every period and writes it.
+ */
+static void prvRunTimeStatsExportTask( void *pvParameters );
+
+/*
+ * Returns the totals of the task with number 'uxTaskNumber', a new entry if it
+ * was not seen before, or NULL when the table is full.
+ */
+static RunTimeTotal_t *prvGetTotal( UBaseType_t uxTaskNumber,
+									uint32_t ulCounter );
+
+/*-----------------------------------------------------------*/
 
 /* Time at start of day (in ns). */
-static unsigned long ulStartTimeNs;
+static uint64_t ullStartTimeNs;
+
+/* Used by the export task only. */
+static RunTimeExport_t xExport;
+static RunTimeTotal_t xTotals[ runtimestatsMAX_TASKS ];
+static TaskStatus_t xTaskStates[ runtimestatsMAX_TASKS ];
 
 /*-----------------------------------------------------------*/
 
@@ -51,18 +116,195 @@ void vConfigureTimerForRunTimeStats( void )
 {
 struct timespec xNow;
 
-	clock_gettime(CLOCK_MONOTONIC, &xNow);
-	ulStartTimeNs = xNow.tv_sec * 1000000000ul + xNow.tv_nsec;
+	clock_gettime( runtimestatsCLOCK, &xNow );
+	ullStartTimeNs = ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
 }
 /*-----------------------------------------------------------*/
 
-unsigned long ulGetRunTimeCounterValue( void )
+uint64_t ullGetRunTimeCounterValueNs( void )
 {
 struct timespec xNow;
 
-	/* Time at start. */
-	clock_gettime(CLOCK_MONOTONIC, &xNow);
+	clock_gettime( runtimestatsCLOCK, &xNow );
+
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec - ullStartTimeNs;
+}
+/*-----------------------------------------------------------*/
+
+unsigned long ulGetRunTimeCounterValue( void )
+{
+	/* The kernel only keeps the lower 32 bits. */
+	return ( unsigned long ) ( uint32_t ) ullGetRunTimeCounterValueNs();
+}
+/*-----------------------------------------------------------*/
+
+void vStartRunTimeStatsExport( const char *pcFileName,
+							   uint32_t ulPeriodMs,
+							   BaseType_t xFormat )
+{
+	/* A task must not run for more than one wrap-around of the counters
+	between two snapshots. */
+	configASSERT( ( ulPeriodMs > 0U ) && ( ulPeriodMs < 4000U ) );
+
+	xExport.pxFile = stdout;
+
+	if( pcFileName != NULL )
+	{
+		xExport.pxFile = fopen( pcFileName, "w" );
+
+		if( xExport.pxFile == NULL )
+		{
+			printf( "Run time stats: can not open %s\n", pcFileName );
+			return;
+		}
+	}
+
+	xExport.xPeriod = pdMS_TO_TICKS( ulPeriodMs );
+	xExport.xFormat = xFormat;
+
+	if( xFormat == runtimestatsFORMAT_CSV )
+	{
+		fprintf( xExport.pxFile, "time_ns,task,number,state,priority,run_ns,total_run_ns,cpu_percent,stack_high_water\n" );
+	}
+
+	xTaskCreate( prvRunTimeStatsExportTask, "Stats", configMINIMAL_STACK_SIZE * 2, &xExport, configMAX_PRIORITIES - 1, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static RunTimeTotal_t *prvGetTotal( UBaseType_t uxTaskNumber,
+									uint32_t ulCounter )
+{
+RunTimeTotal_t *pxFree = NULL;
+UBaseType_t uxIndex;
+
+	for( uxIndex = 0U; uxIndex < runtimestatsMAX_TASKS; uxIndex++ )
+	{
+		if( xTotals[ uxIndex ].xSeen == pdFALSE )
+		{
+			if( pxFree == NULL )
+			{
+				pxFree = &( xTotals[ uxIndex ] );
+			}
+		}
+		else if( xTotals[ uxIndex ].uxTaskNumber == uxTaskNumber )
+		{
+			return &( xTotals[ uxIndex ] );
+		}
+	}
+
+	if( pxFree != NULL )
+	{
+		/* Only the time run from now on is counted. */
+		pxFree->uxTaskNumber = uxTaskNumber;
+		pxFree->ulLastCounter = ulCounter;
+		pxFree->ullTotalNs = 0U;
+		pxFree->xSeen = pdTRUE;
+	}
+
+	return pxFree;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunTimeStatsExportTask( void *pvParameters )
+{
+RunTimeExport_t *pxExport = ( RunTimeExport_t * ) pvParameters;
+static const char * const pcStateNames[] = { "running", "ready", "blocked", "suspended", "deleted", "invalid" };
+RunTimeTotal_t *pxTotal;
+TaskStatus_t *pxState;
+BaseType_t xPresent[ runtimestatsMAX_TASKS ];
+uint64_t ullNow, ullPrevious, ullPeriodNs;
+uint32_t ulDelta, ulTotalRunTime;
+UBaseType_t uxCount, uxIndex, uxTotal;
+TickType_t xLastWakeTime;
+const char *pcSeparator;
+
+	ullPrevious = ullGetRunTimeCounterValueNs();
+	xLastWakeTime = xTaskGetTickCount();
+
+	for( ; ; )
+	{
+		vTaskDelayUntil( &xLastWakeTime, pxExport->xPeriod );
+
+		uxCount = uxTaskGetSystemState( xTaskStates, runtimestatsMAX_TASKS, &ulTotalRunTime );
+		ullNow = ullGetRunTimeCounterValueNs();
+		ullPeriodNs = ullNow - ullPrevious;
+		ullPrevious = ullNow;
+
+		if( ullPeriodNs == 0U )
+		{
+			ullPeriodNs = 1U;
+		}
+
+		memset( xPresent, 0, sizeof( xPresent ) );
+		pcSeparator = "";
+
+		if( pxExport->xFormat == runtimestatsFORMAT_JSON )
+		{
+			fprintf( pxExport->pxFile, "{\"time_ns\":%llu,\"period_ns\":%llu,\"tasks\":[",
+					 ( unsigned long long ) ullNow,
+					 ( unsigned long long ) ullPeriodNs );
+		}
+
+		for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+		{
+			pxState = &( xTaskStates[ uxIndex ] );
+			pxTotal = prvGetTotal( pxState->xTaskNumber, pxState->ulRunTimeCounter );
+
+			if( pxTotal == NULL )
+			{
+				continue;
+			}
+
+			/* The subtraction is correct across one wrap-around. */
+			ulDelta = pxState->ulRunTimeCounter - pxTotal->ulLastCounter;
+			pxTotal->ulLastCounter = pxState->ulRunTimeCounter;
+			pxTotal->ullTotalNs += ulDelta;
+			xPresent[ pxTotal - xTotals ] = pdTRUE;
+
+			if( pxExport->xFormat == runtimestatsFORMAT_JSON )
+			{
+				fprintf( pxExport->pxFile, "%s{\"task\":\"%s\",\"number\":%lu,\"state\":\"%s\",\"priority\":%lu,\"run_ns\":%lu,\"total_run_ns\":%llu,\"cpu_percent\":%.2f,\"stack_high_water\":%u}",
+						 pcSeparator,
+						 pxState->pcTaskName,
+						 ( unsigned long ) pxState->xTaskNumber,
+						 pcStateNames[ ( pxState->eCurrentState <= eInvalid ) ? pxState->eCurrentState : eInvalid ],
+						 ( unsigned long ) pxState->uxCurrentPriority,
+						 ( unsigned long ) ulDelta,
+						 ( unsigned long long ) pxTotal->ullTotalNs,
+						 ( ( double ) ulDelta * 100.0 ) / ( double ) ullPeriodNs,
+						 ( unsigned ) pxState->usStackHighWaterMark );
+				pcSeparator = ",";
+			}
+			else
+			{
+				fprintf( pxExport->pxFile, "%llu,%s,%lu,%s,%lu,%lu,%llu,%.2f,%u\n",
+						 ( unsigned long long ) ullNow,
+						 pxState->pcTaskName,
+						 ( unsigned long ) pxState->xTaskNumber,
+						 pcStateNames[ ( pxState->eCurrentState <= eInvalid ) ? pxState->eCurrentState : eInvalid ],
+						 ( unsigned long ) pxState->uxCurrentPriority,
+						 ( unsigned long ) ulDelta,
+						 ( unsigned long long ) pxTotal->ullTotalNs,
+						 ( ( double ) ulDelta * 100.0 ) / ( double ) ullPeriodNs,
+						 ( unsigned ) pxState->usStackHighWaterMark );
+			}
+		}
+
+		if( pxExport->xFormat == runtimestatsFORMAT_JSON )
+		{
+			fprintf( pxExport->pxFile, "]}\n" );
+		}
+
+		fflush( pxExport->pxFile );
 
-	return xNow.tv_sec * 1000000000ul + xNow.tv_nsec - ulStartTimeNs;
+		/* Forget the tasks that were deleted. */
+		for( uxTotal = 0U; uxTotal < runtimestatsMAX_TASKS; uxTotal++ )
+		{
+			if( xPresent[ uxTotal ] == pdFALSE )
+			{
+				xTotals[ uxTotal ].xSeen = pdFALSE;
+			}
+		}
+	}
 }
 /*-----------------------------------------------------------*/
@@ -0,0 +1,53 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+#ifndef RUN_TIME_STATS_UTILS_H
+#define RUN_TIME_STATS_UTILS_H
+
+/* The formats of vStartRunTimeStatsExport(). */
+#define runtimestatsFORMAT_CSV		( 1 )
+#define runtimestatsFORMAT_JSON		( 2 )
+
+/*
+ * Returns the time of the run time statistics clock in nanoseconds, counted
+ * from the call of vConfigureTimerForRunTimeStats().  The counter of the
+ * kernel, ulGetRunTimeCounterValue(), holds the lower 32 bits of this value.
+ */
+uint64_t ullGetRunTimeCounterValueNs( void );
+
+/*
+ * Create a task that writes the CPU usage of every task to 'pcFileName', or to
+ * stdout when it is NULL, every 'ulPeriodMs' milliseconds.  Every snapshot is
+ * a set of CSV rows, or one line of JSON, depending on 'xFormat'.  The period
+ * must be shorter than the wrap-around time of the 32-bit counters of the
+ * kernel, which is about 4.29 seconds.
+ */
+void vStartRunTimeStatsExport( const char *pcFileName,
+							   uint32_t ulPeriodMs,
+							   BaseType_t xFormat );
+
+#endif /* RUN_TIME_STATS_UTILS_H */
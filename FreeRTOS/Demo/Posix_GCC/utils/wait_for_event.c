@@ -1,6 +1,8 @@
 #include <pthread.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <signal.h>
+#include <unistd.h>
 
 #include "wait_for_event.h"
 
@@ -11,6 +13,12 @@ struct event
     bool event_triggered;
 };
 
+/* Interrupts that were raised but not yet handled, one bit per interrupt. */
+static unsigned int interrupts_pending = 0;
+static event_interrupt_handler interrupt_handlers[ EVENT_MAX_INTERRUPTS ];
+static pthread_mutex_t interrupt_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool interrupt_signal_installed = false;
+
 struct event * event_create()
 {
     struct event * ev = malloc( sizeof( struct event ) );
@@ -37,6 +45,7 @@ bool event_wait( struct event * ev )
         pthread_cond_wait( &ev->cond, &ev->mutex );
     }
 
+    ev->event_triggered = false;
     pthread_mutex_unlock( &ev->mutex );
     return true;
 }
@@ -45,25 +54,31 @@ bool event_wait_timed( struct event * ev,
 {
     struct timespec ts;
     int ret = 0;
+    bool triggered;
 
+    /* tv_nsec must stay below one second, or pthread_cond_timedwait() fails
+     * immediately with EINVAL and the caller would spin. */
     clock_gettime( CLOCK_REALTIME, &ts );
-    //ts.tv_sec += ms;
-    ts.tv_nsec += (ms * 1000000);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += ( ms % 1000 ) * 1000000;
+
+    if( ts.tv_nsec >= 1000000000 )
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+
     pthread_mutex_lock( &ev->mutex );
 
-    while( (ev->event_triggered == false) && (ret == 0) )
+    while( ( ev->event_triggered == false ) && ( ret != ETIMEDOUT ) )
     {
         ret = pthread_cond_timedwait( &ev->cond, &ev->mutex, &ts );
-
-        if( ( ret == -1 ) && ( errno == ETIMEDOUT ) )
-        {
-            return false;
-        }
     }
 
+    triggered = ev->event_triggered;
     ev->event_triggered = false;
     pthread_mutex_unlock( &ev->mutex );
-    return true;
+    return triggered;
 }
 
 void event_signal( struct event * ev )
@@ -73,3 +88,76 @@ void event_signal( struct event * ev )
     pthread_cond_signal( &ev->cond );
     pthread_mutex_unlock( &ev->mutex );
 }
+
+static void event_interrupt_signal_handler( int sig )
+{
+    unsigned int pending;
+    unsigned int interrupt;
+
+    ( void ) sig;
+
+    /* All signals, including the tick, are blocked while this handler runs.
+     * A handler may switch to another task, the remaining interrupts will be
+     * handled when this thread runs again. */
+    pending = __atomic_exchange_n( &interrupts_pending, 0U, __ATOMIC_ACQ_REL );
+
+    while( pending != 0U )
+    {
+        interrupt = ( unsigned int ) __builtin_ctz( pending );
+        pending &= pending - 1U;
+
+        if( interrupt_handlers[ interrupt ] != NULL )
+        {
+            interrupt_handlers[ interrupt ]();
+        }
+    }
+}
+
+bool event_interrupt_install( unsigned int interrupt,
+                              event_interrupt_handler handler )
+{
+    struct sigaction sa;
+    bool ok = true;
+
+    if( interrupt >= EVENT_MAX_INTERRUPTS )
+    {
+        return false;
+    }
+
+    pthread_mutex_lock( &interrupt_mutex );
+    interrupt_handlers[ interrupt ] = handler;
+
+    if( interrupt_signal_installed == false )
+    {
+        sa.sa_handler = event_interrupt_signal_handler;
+        sa.sa_flags = SA_RESTART;
+        sigfillset( &sa.sa_mask );
+
+        if( sigaction( EVENT_INTERRUPT_SIGNAL, &sa, NULL ) == 0 )
+        {
+            interrupt_signal_installed = true;
+        }
+        else
+        {
+            interrupt_handlers[ interrupt ] = NULL;
+            ok = false;
+        }
+    }
+
+    pthread_mutex_unlock( &interrupt_mutex );
+    return ok;
+}
+
+void event_interrupt_raise( unsigned int interrupt )
+{
+    if( interrupt < EVENT_MAX_INTERRUPTS )
+    {
+        __atomic_fetch_or( &interrupts_pending, 1U << interrupt, __ATOMIC_ACQ_REL );
+
+        /* The signal goes to the process, so the kernel delivers it to a
+         * thread that does not block it: the FreeRTOS task that is running.
+         * When that task is in a critical section, the signal stays pending
+         * until it leaves, like a masked interrupt. */
+        kill( getpid(), EVENT_INTERRUPT_SIGNAL );
+    }
+}
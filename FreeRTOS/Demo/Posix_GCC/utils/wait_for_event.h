@@ -13,6 +13,28 @@ bool event_wait_timed( struct event * ev,
                        time_t ms );
 void event_signal( struct event * ev );
 
+/* Simulated interrupts, the bridge between Linux threads and FreeRTOS tasks.
+ *
+ * A Linux thread may not call the FreeRTOS API, but it may call
+ * event_interrupt_raise().  The handler that was installed for the interrupt
+ * then runs as a signal handler in the thread of the FreeRTOS task that is
+ * running, in the same way as the tick interrupt of the Posix port.  The
+ * handler may use the FromISR API, e.g. vTaskNotifyGiveFromISR() followed by
+ * portYIELD_FROM_ISR(), so the task is woken immediately in stead of at its
+ * next poll.  A Linux thread that raises interrupts must block all signals,
+ * otherwise the handler might run in that thread. */
+#ifndef EVENT_INTERRUPT_SIGNAL
+    #define EVENT_INTERRUPT_SIGNAL    SIGUSR2
+#endif
+
+#define EVENT_MAX_INTERRUPTS          32
+
+typedef void ( * event_interrupt_handler )( void );
+
+bool event_interrupt_install( unsigned int interrupt,
+                              event_interrupt_handler handler );
+void event_interrupt_raise( unsigned int interrupt );
+
 
 
 #endif /* ifndef _WAIT_FOR_EVENT_H_ */